@@ -0,0 +1,15 @@
+// Host side of the runtime benchmarks: every program reads its problem size
+// and seed through these externs so the frontend cannot fold the work away.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t env_u32(const char* name, uint32_t fallback) {
+    const char* text = getenv(name);
+    if (!text || !*text) return fallback;
+    return (uint32_t)strtoul(text, NULL, 10);
+}
+
+uint32_t vx_bench_scale(void) { return env_u32("VEXEL_BENCH_SCALE", 1); }
+uint32_t vx_bench_seed(void) { return env_u32("VEXEL_BENCH_SEED", 7); }
+int32_t vx_putchar(int32_t c) { return putchar(c); }
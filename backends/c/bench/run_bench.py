@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""Runtime benchmarks for C backend output behind `make bench-runtime`.
+
+Every program in the corpus is compiled with the C backend once per backend
+option set, built with the host C compiler and run repeatedly. The report
+records the median and p95 run time, generated C size and executable code
+size per (program, option set) and checks that every option set computes the
+same result. Option sets the host compiler cannot build (e.g. extint=bitint
+without C23 `_BitInt`) are reported as unsupported.
+"""
+import argparse
+import hashlib
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+
+def find_repo_root(start: Path) -> Path:
+    for parent in [start] + list(start.parents):
+        if (parent / "docs" / "vexel-rfc.md").is_file():
+            return parent
+    raise RuntimeError("Could not locate repo root")
+
+
+BENCH_DIR = Path(__file__).resolve().parent
+ROOT = find_repo_root(BENCH_DIR)
+
+# name -> source. Programs read their size and seed through the externs in
+# bench_runtime.c, so the frontend cannot evaluate them at compile time.
+PROGRAMS = {
+    "extint_arith": BENCH_DIR / "extint_arith" / "bench.vx",
+    "sorted_iteration": BENCH_DIR / "sorted_iteration" / "bench.vx",
+    "aggregate_copies": BENCH_DIR / "aggregate_copies" / "bench.vx",
+    "raytracer": ROOT / "examples" / "raytracer.vx",
+    "string_scan": BENCH_DIR / "string_scan" / "bench.vx",
+}
+
+# name -> vexel arguments selecting the backend options under measurement.
+CONFIGS = {
+    "default": [],
+    "extint-int128": ["--backend-opt", "extint=int128"],
+    "extint-bitint": ["--backend-opt", "extint=bitint"],
+    "vectorize-ivdep": ["--backend-opt", "vectorize=ivdep"],
+    "field-order-align": ["--backend-opt", "field_order=align"],
+    "split-tu-4": ["--split-tu=4"],
+}
+
+
+def percentile(values, fraction):
+    """Nearest-rank percentile; the median is percentile(values, 0.5)."""
+    ordered = sorted(values)
+    rank = max(1, -(-len(ordered) * fraction // 1))
+    return ordered[int(rank) - 1]
+
+
+def text_size(exe: Path) -> int:
+    """Bytes of code and read-only data; the file size without binutils."""
+    if shutil.which("size"):
+        result = subprocess.run(["size", str(exe)], capture_output=True, text=True)
+        lines = result.stdout.splitlines()
+        if result.returncode == 0 and len(lines) >= 2:
+            return int(lines[1].split()[0])
+    return exe.stat().st_size
+
+
+def build(vexel: Path, source: Path, config_args, cc: str, cflags, work: Path):
+    """Returns (executable, generated C bytes) or raises RuntimeError with
+    `unsupported` set when only the host compiler rejected the output."""
+    out = work / "out"
+    cmd = [str(vexel), "-b", "c", *config_args, "-o", str(out), str(source)]
+    result = subprocess.run(cmd, cwd=work, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{' '.join(cmd)} failed:\n{result.stderr}")
+    units = sorted(work.glob("out*.c"))
+    c_bytes = sum(path.stat().st_size for path in units) + sum(
+        path.stat().st_size for path in work.glob("out*.h"))
+    exe = work / "bench"
+    cc_cmd = [cc, "-std=c11", *cflags, "-I", str(work), *map(str, units),
+              str(BENCH_DIR / "bench_runtime.c"), "-o", str(exe), "-lm"]
+    result = subprocess.run(cc_cmd, cwd=work, capture_output=True, text=True)
+    if result.returncode != 0:
+        err = RuntimeError(f"{' '.join(cc_cmd)} failed:\n{result.stderr}")
+        err.unsupported = True
+        raise err
+    return exe, c_bytes
+
+
+def run_trials(exe: Path, trials: int, warmup: int, env):
+    times = []
+    exit_code = None
+    digest = None
+    for trial in range(warmup + trials):
+        started = time.perf_counter()
+        result = subprocess.run([str(exe)], capture_output=True, env=env)
+        elapsed_ms = (time.perf_counter() - started) * 1000.0
+        if trial >= warmup:
+            times.append(elapsed_ms)
+        exit_code = result.returncode
+        digest = hashlib.sha256(result.stdout).hexdigest()[:16]
+    return times, exit_code, digest
+
+
+def main() -> int:
+    build_dir = Path(os.environ.get("BUILD_DIR", ROOT / "build"))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--vexel", type=Path, default=build_dir / "vexel", help="compiler binary")
+    parser.add_argument("--cc", default=os.environ.get("CC", "gcc"), help="host C compiler (default: gcc)")
+    parser.add_argument("--cflag", action="append", default=None,
+                        help="host compiler flag, repeatable (default: -O2)")
+    parser.add_argument("--trials", type=int, default=5, help="measured runs per case (default: 5)")
+    parser.add_argument("--warmup", type=int, default=1, help="unmeasured runs per case (default: 1)")
+    parser.add_argument("--scale", type=int, default=1, help="problem size multiplier (default: 1)")
+    parser.add_argument("--program", action="append", choices=sorted(PROGRAMS), help="run only this program")
+    parser.add_argument("--config", action="append", choices=sorted(CONFIGS), help="run only this option set")
+    parser.add_argument("--output", type=Path, default=build_dir / "bench-runtime.json", help="results file")
+    args = parser.parse_args()
+
+    if not args.vexel.is_file():
+        print(f"compiler not found: {args.vexel} (run make first)", file=sys.stderr)
+        return 2
+    if args.trials < 1 or args.warmup < 0 or args.scale < 1:
+        print("--trials and --scale must be at least 1 and --warmup non-negative", file=sys.stderr)
+        return 2
+    cflags = args.cflag if args.cflag is not None else ["-O2"]
+    env = dict(os.environ, VEXEL_BENCH_SCALE=str(args.scale))
+
+    results = {
+        "format": 1,
+        "compiler": str(args.vexel),
+        "host": {"node": platform.node(), "machine": platform.machine(), "cc": args.cc, "cflags": cflags},
+        "trials": args.trials,
+        "scale": args.scale,
+        "cases": [],
+    }
+    mismatches = 0
+    for program in args.program or list(PROGRAMS):
+        reference = None
+        for config in args.config or list(CONFIGS):
+            case = {"program": program, "config": config, "backend_args": CONFIGS[config]}
+            with tempfile.TemporaryDirectory(prefix=f"vexel-rtbench-{program}-") as tmp:
+                try:
+                    exe, c_bytes = build(args.vexel, PROGRAMS[program], CONFIGS[config], args.cc, cflags,
+                                         Path(tmp))
+                except RuntimeError as err:
+                    if not getattr(err, "unsupported", False):
+                        print(f"{program}/{config}: {err}", file=sys.stderr)
+                        return 1
+                    case["status"] = "unsupported"
+                    results["cases"].append(case)
+                    print(f"{program:<18}{config:<20}unsupported by {args.cc}")
+                    continue
+                times, exit_code, digest = run_trials(exe, args.trials, args.warmup, env)
+                case.update({
+                    "status": "ok",
+                    "median_ms": round(percentile(times, 0.5), 3),
+                    "p95_ms": round(percentile(times, 0.95), 3),
+                    "min_ms": round(min(times), 3),
+                    "c_bytes": c_bytes,
+                    "text_bytes": text_size(exe),
+                    "exit_code": exit_code,
+                    "stdout_sha256": digest,
+                })
+            if reference is None:
+                reference = (exit_code, digest)
+            elif reference != (exit_code, digest):
+                case["status"] = "mismatch"
+                mismatches += 1
+            results["cases"].append(case)
+            print(f"{program:<18}{config:<20}{case['median_ms']:>10.3f}ms p95 {case['p95_ms']:>9.3f}ms"
+                  f"  text {case['text_bytes']:>7}  C {c_bytes:>8}"
+                  + ("  RESULT MISMATCH" if case["status"] == "mismatch" else ""))
+
+    args.output.parent.mkdir(parents=True, exist_ok=True)
+    args.output.write_text(json.dumps(results, indent=2) + "\n")
+    print(f"Wrote {args.output}")
+    if mismatches:
+        print(f"{mismatches} option set(s) computed a different result than the first one")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
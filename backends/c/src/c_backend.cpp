@@ -1,17 +1,30 @@
 #include "c_backend.h"
 #include "backend_registry.h"
+#include "c_profile.h"
+#include "c_split_tu.h"
 #include "codegen.h"
 #include "io_utils.h"
+#include "thread_pool.h"
 #include <algorithm>
+#include <cstring>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 
 namespace vexel {
 
 using c_backend_codegen::CCodegenResult;
 using c_backend_codegen::CodeGenerator;
+using c_backend_codegen::CodegenABI;
+using c_backend_codegen::ExecutionProfile;
+using c_backend_codegen::ExtIntLowering;
+using c_backend_codegen::FieldOrder;
+using c_backend_codegen::FrameAllocation;
+using c_backend_codegen::GeneratedFunctionInfo;
+using c_backend_codegen::GeneratedVarInfo;
+using c_backend_codegen::LoopVectorization;
 
 namespace {
 
@@ -20,36 +33,376 @@ static bool has_annotation(const std::vector<Annotation>& anns, const std::strin
                        [&](const Annotation& ann) { return ann.name == name; });
 }
 
-static bool parse_c_backend_option(int, char**, int&, Compiler::Options&, std::string&) {
-    return false;
+constexpr unsigned kMaxSplitUnits = 4096;
+
+constexpr const char* kDefaultProfilePath = "vexel.profile";
+
+// `--split-tu=N` is shorthand for `--backend-opt split_tu=N`,
+// `--profile-generate[=<path>]` for `profile_generate=<path>` and
+// `--profile-use=<path>` for `profile_use=<path>`.
+static bool parse_c_backend_option(int, char** argv, int& index, Compiler::Options& opts, std::string& error) {
+    constexpr const char* kSplitPrefix = "--split-tu=";
+    constexpr const char* kProfileGenerate = "--profile-generate";
+    constexpr const char* kProfileUsePrefix = "--profile-use=";
+    if (std::strcmp(argv[index], kProfileGenerate) == 0) {
+        opts.backend_options["profile_generate"] = kDefaultProfilePath;
+        return true;
+    }
+    if (std::strncmp(argv[index], kProfileGenerate, std::strlen(kProfileGenerate)) == 0 &&
+        argv[index][std::strlen(kProfileGenerate)] == '=') {
+        opts.backend_options["profile_generate"] = argv[index] + std::strlen(kProfileGenerate) + 1;
+        return true;
+    }
+    if (std::strncmp(argv[index], kProfileUsePrefix, std::strlen(kProfileUsePrefix)) == 0) {
+        opts.backend_options["profile_use"] = argv[index] + std::strlen(kProfileUsePrefix);
+        return true;
+    }
+    if (std::strncmp(argv[index], kSplitPrefix, std::strlen(kSplitPrefix)) != 0) {
+        return false;
+    }
+    const char* value = argv[index] + std::strlen(kSplitPrefix);
+    if (*value == '\0') {
+        error = "--split-tu requires a translation unit count";
+        return true;
+    }
+    opts.backend_options["split_tu"] = value;
+    return true;
+}
+
+static bool parse_split_units(const std::string& value, unsigned& out) {
+    if (value.empty() || value.size() > 4) return false;
+    unsigned parsed = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') return false;
+        parsed = parsed * 10 + static_cast<unsigned>(c - '0');
+    }
+    if (parsed == 0 || parsed > kMaxSplitUnits) return false;
+    out = parsed;
+    return true;
+}
+
+static unsigned split_units_option(const Compiler::Options& options) {
+    unsigned units = 1;
+    auto it = options.backend_options.find("split_tu");
+    if (it != options.backend_options.end()) parse_split_units(it->second, units);
+    return units;
+}
+
+static bool parse_extint_lowering(const std::string& value, ExtIntLowering& out) {
+    if (value == "bytes") {
+        out = ExtIntLowering::Bytes;
+    } else if (value == "int128") {
+        out = ExtIntLowering::Int128;
+    } else if (value == "bitint") {
+        out = ExtIntLowering::BitInt;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static ExtIntLowering extint_lowering_option(const Compiler::Options& options) {
+    ExtIntLowering mode = ExtIntLowering::Bytes;
+    auto it = options.backend_options.find("extint");
+    if (it != options.backend_options.end()) parse_extint_lowering(it->second, mode);
+    return mode;
+}
+
+static bool parse_loop_vectorization(const std::string& value, LoopVectorization& out) {
+    if (value == "off") {
+        out = LoopVectorization::Off;
+    } else if (value == "ivdep") {
+        out = LoopVectorization::Ivdep;
+    } else if (value == "omp") {
+        out = LoopVectorization::OmpSimd;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static LoopVectorization loop_vectorization_option(const Compiler::Options& options) {
+    LoopVectorization mode = LoopVectorization::Off;
+    auto it = options.backend_options.find("vectorize");
+    if (it != options.backend_options.end()) parse_loop_vectorization(it->second, mode);
+    return mode;
+}
+
+static bool parse_field_order(const std::string& value, FieldOrder& out) {
+    if (value == "declared") {
+        out = FieldOrder::Declared;
+    } else if (value == "align") {
+        out = FieldOrder::Alignment;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static FieldOrder field_order_option(const Compiler::Options& options) {
+    FieldOrder order = FieldOrder::Declared;
+    auto it = options.backend_options.find("field_order");
+    if (it != options.backend_options.end()) parse_field_order(it->second, order);
+    return order;
+}
+
+static bool parse_frame_allocation(const std::string& value, FrameAllocation& out) {
+    if (value == "separate") {
+        out = FrameAllocation::Separate;
+    } else if (value == "overlay") {
+        out = FrameAllocation::Overlay;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static FrameAllocation frame_allocation_option(const Compiler::Options& options) {
+    FrameAllocation mode = FrameAllocation::Separate;
+    auto it = options.backend_options.find("frames");
+    if (it != options.backend_options.end()) parse_frame_allocation(it->second, mode);
+    return mode;
+}
+
+// Loads the `profile_use` file into `profile`, which must outlive generation.
+static void apply_profile_options(const Compiler::Options& options, CodeGenerator& codegen,
+                                  ExecutionProfile& profile) {
+    auto generate = options.backend_options.find("profile_generate");
+    if (generate != options.backend_options.end()) codegen.set_profile_generate(generate->second);
+    auto use = options.backend_options.find("profile_use");
+    if (use != options.backend_options.end()) {
+        profile = c_backend_codegen::load_execution_profile(use->second);
+        codegen.set_execution_profile(&profile);
+    }
+}
+
+static unsigned codegen_worker_count(const Compiler::Options& options) {
+    return options.parallel_codegen ? resolve_worker_count(options.jobs) : 1;
 }
 
 static void validate_c_backend_options(const Compiler::Options& options, std::string& error) {
-    if (options.backend_options.empty()) return;
-    const auto& entry = *options.backend_options.begin();
-    error = "C backend does not accept backend options (unknown key: " + entry.first + ")";
+    for (const auto& entry : options.backend_options) {
+        if (entry.first == "extint") {
+            ExtIntLowering mode = ExtIntLowering::Bytes;
+            if (!parse_extint_lowering(entry.second, mode)) {
+                error = "C backend option extint expects bytes, int128 or bitint (got: " + entry.second + ")";
+                return;
+            }
+            continue;
+        }
+        if (entry.first == "vectorize") {
+            LoopVectorization mode = LoopVectorization::Off;
+            if (!parse_loop_vectorization(entry.second, mode)) {
+                error = "C backend option vectorize expects off, ivdep or omp (got: " + entry.second + ")";
+                return;
+            }
+            continue;
+        }
+        if (entry.first == "field_order") {
+            FieldOrder order = FieldOrder::Declared;
+            if (!parse_field_order(entry.second, order)) {
+                error = "C backend option field_order expects declared or align (got: " + entry.second + ")";
+                return;
+            }
+            continue;
+        }
+        if (entry.first == "frames") {
+            FrameAllocation mode = FrameAllocation::Separate;
+            if (!parse_frame_allocation(entry.second, mode)) {
+                error = "C backend option frames expects separate or overlay (got: " + entry.second + ")";
+                return;
+            }
+            continue;
+        }
+        if (entry.first == "split_tu") {
+            unsigned units = 1;
+            if (!parse_split_units(entry.second, units)) {
+                error = "C backend option split_tu expects a translation unit count from 1 to " +
+                        std::to_string(kMaxSplitUnits) + " (got: " + entry.second + ")";
+                return;
+            }
+            continue;
+        }
+        if (entry.first == "profile_generate" || entry.first == "profile_use") {
+            if (entry.second.empty()) {
+                error = "C backend option " + entry.first + " expects a profile file path";
+                return;
+            }
+            continue;
+        }
+        error = "C backend does not accept backend options other than extint, vectorize, field_order, frames, "
+                "split_tu, profile_generate and profile_use (unknown key: " + entry.first + ")";
+        return;
+    }
+    if (options.backend_options.count("profile_generate")) {
+        if (options.backend_options.count("profile_use")) {
+            error = "C backend options profile_generate and profile_use cannot be combined";
+        } else if (split_units_option(options) > 1) {
+            error = "C backend option profile_generate cannot be combined with split_tu";
+        }
+    }
 }
 
 static void print_c_backend_usage(std::ostream& os) {
-    os << "  (none)\n";
+    os << "  extint=bytes|int128|bitint   Lowering for non-native integer widths (default bytes):\n"
+       << "                               int128 maps #i128/#u128 to __int128, bitint maps every\n"
+       << "                               width to C23 _BitInt(N); fixed-point types keep bytes\n"
+       << "  vectorize=off|ivdep|omp      Loop shape for @ iteration (default off): ranges become\n"
+       << "                               counted loops, and elementwise bodies get #pragma GCC ivdep\n"
+       << "                               or #pragma omp simd with reduction clauses (-fopenmp-simd)\n"
+       << "  field_order=declared|align   Struct field order (default declared): align sorts fields\n"
+       << "                               by descending alignment to drop padding, except in types\n"
+       << "                               reachable from exports, externals and composite casts\n"
+       << "  frames=separate|overlay      Static frames of non-reentrant internal functions (default\n"
+       << "                               separate): overlay lets functions that are never live at\n"
+       << "                               once share storage; non-reentrant entry points must not\n"
+       << "                               preempt each other\n"
+       << "  split_tu=N (or --split-tu=N)  Spread functions over N .c files (<stem>.c, <stem>_1.c, ...)\n"
+       << "                               clustered by call graph; internal symbols get hidden\n"
+       << "                               linkage and static helpers move to <stem>_internal.h\n"
+       << "  profile_generate=<path>      Count function entries and conditionals; each run appends\n"
+       << "                               them to <path> or $VEXEL_PROFILE_FILE\n"
+       << "                               (--profile-generate[=<path>], default vexel.profile)\n"
+       << "  profile_use=<path>           Hot/cold attributes, branch hints and non-reentrant variant\n"
+       << "                               pruning from a generated profile (--profile-use=<path>)\n";
 }
 
-static void emit_c_backend(const BackendInput& input) {
+// Removes the body spill file however emission ends.
+class SpillFileGuard {
+public:
+    explicit SpillFileGuard(std::filesystem::path path) : path_(std::move(path)) {}
+    ~SpillFileGuard() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+    SpillFileGuard(const SpillFileGuard&) = delete;
+    SpillFileGuard& operator=(const SpillFileGuard&) = delete;
+
+private:
+    std::filesystem::path path_;
+};
+
+// Stream buffer that drops everything written to it.
+class DiscardBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Split output: the header declares every internal symbol with hidden
+// linkage, <stem>_internal.h adds the static helpers and macro-like globals
+// each unit needs, <stem>.c holds the rodata blob and global definitions, and
+// functions are spread over all N units.
+static void emit_split_c_backend(const BackendInput& input, unsigned unit_count) {
     const AnalyzedProgram& program = input.program;
+    const std::string header_name = input.outputs.stem + ".h";
+    const std::string internal_name = input.outputs.stem + "_internal.h";
+    std::filesystem::path header_path = input.outputs.dir / header_name;
+    std::filesystem::path internal_path = input.outputs.dir / internal_name;
+
+    CodegenABI abi;
+    abi.multi_file_globals = true;
+    abi.hidden_internal_linkage = true;
+    DiscardBuffer discard_buffer;
+    std::ostream discard(&discard_buffer);
+    ExecutionProfile profile;
     CodeGenerator codegen;
+    codegen.set_abi(abi);
+    codegen.set_extint_lowering(extint_lowering_option(input.options));
+    codegen.set_loop_vectorization(loop_vectorization_option(input.options));
+    codegen.set_field_order(field_order_option(input.options));
+    codegen.set_frame_allocation(frame_allocation_option(input.options));
+    apply_profile_options(input.options, codegen, profile);
+    codegen.set_parallel_workers(codegen_worker_count(input.options));
+    codegen.set_body_sink(&discard);
     CCodegenResult result = codegen.generate(*program.module, program);
+    const std::vector<GeneratedFunctionInfo>& functions = codegen.functions();
+    std::vector<unsigned> units = c_backend_codegen::partition_translation_units(functions, unit_count);
 
+    if (input.options.verbose) {
+        std::cout << "Writing header: " << header_path << std::endl;
+        std::cout << "Writing internal header: " << internal_path << std::endl;
+    }
+    write_text_file_or_throw(header_path.string(), result.header);
+    write_file_stream_or_throw(internal_path.string(), [&](std::ostream& out) {
+        out << "#pragma once\n#include \"" << header_name << "\"\n\n" << result.shared_helpers;
+        for (const GeneratedVarInfo& var : codegen.variables()) {
+            if (var.declaration && var.declaration->var_linkage != VarLinkageKind::Normal) out << var.code;
+        }
+    });
+    for (unsigned unit = 0; unit < unit_count; ++unit) {
+        std::filesystem::path source_path =
+            input.outputs.dir / (input.outputs.stem + (unit == 0 ? "" : "_" + std::to_string(unit)) + ".c");
+        if (input.options.verbose) {
+            std::cout << "Writing source: " << source_path << std::endl;
+        }
+        write_file_stream_or_throw(source_path.string(), [&](std::ostream& out) {
+            out << "#include \"" << internal_name << "\"\n\n";
+            if (unit == 0) {
+                out << result.source;
+                for (const GeneratedVarInfo& var : codegen.variables()) {
+                    if (!var.declaration || var.declaration->var_linkage == VarLinkageKind::Normal) out << var.code;
+                }
+            }
+            for (size_t i = 0; i < functions.size(); ++i) {
+                if (units[i] == unit) out << functions[i].code;
+            }
+        });
+    }
+}
+
+static void emit_c_backend(const BackendInput& input) {
+    const unsigned split_units = split_units_option(input.options);
+    if (split_units > 1) {
+        emit_split_c_backend(input, split_units);
+        return;
+    }
+    const AnalyzedProgram& program = input.program;
     std::filesystem::path header_path = input.outputs.dir / (input.outputs.stem + ".h");
     std::filesystem::path source_path = input.outputs.dir / (input.outputs.stem + ".c");
+
+    // Function and global definitions stream to a spill file as they are
+    // generated; the prelude they depend on is only complete at the end, so
+    // the final source is the prelude followed by the spilled body.
+    std::filesystem::path body_path = source_path;
+    body_path += ".body.tmp";
+    SpillFileGuard body_guard(body_path);
+    CCodegenResult result;
+    {
+        std::ofstream body_out(body_path, std::ios::binary);
+        if (!body_out) {
+            throw CompileError("Cannot write file: " + body_path.string(), SourceLocation());
+        }
+        ExecutionProfile profile;
+        CodeGenerator codegen;
+        codegen.set_extint_lowering(extint_lowering_option(input.options));
+        codegen.set_loop_vectorization(loop_vectorization_option(input.options));
+        codegen.set_field_order(field_order_option(input.options));
+        codegen.set_frame_allocation(frame_allocation_option(input.options));
+        apply_profile_options(input.options, codegen, profile);
+        codegen.set_body_sink(&body_out);
+        codegen.set_parallel_workers(codegen_worker_count(input.options));
+        result = codegen.generate(*program.module, program);
+        body_out.flush();
+        if (!body_out) {
+            throw CompileError("Cannot write file: " + body_path.string(), SourceLocation());
+        }
+    }
+
     if (input.options.verbose) {
         std::cout << "Writing header: " << header_path << std::endl;
         std::cout << "Writing source: " << source_path << std::endl;
     }
 
     write_text_file_or_throw(header_path.string(), result.header);
-    std::string source_with_include =
-        "#include \"" + header_path.filename().string() + "\"\n\n" + result.source;
-    write_text_file_or_throw(source_path.string(), source_with_include);
+    write_file_stream_or_throw(source_path.string(), [&](std::ostream& out) {
+        out << "#include \"" << header_path.filename().string() << "\"\n\n" << result.source;
+        std::ifstream body_in(body_path, std::ios::binary);
+        if (!body_in) {
+            throw CompileError("Cannot read file: " + body_path.string(), SourceLocation());
+        }
+        if (body_in.peek() != std::ifstream::traits_type::eof()) out << body_in.rdbuf();
+    });
 }
 
 static bool emit_c_translation_unit(const BackendInput& input,
@@ -57,8 +410,22 @@ static bool emit_c_translation_unit(const BackendInput& input,
                                     std::string& error) {
     try {
         const AnalyzedProgram& program = input.program;
+        ExecutionProfile profile;
         CodeGenerator codegen;
+        codegen.set_extint_lowering(extint_lowering_option(input.options));
+        codegen.set_loop_vectorization(loop_vectorization_option(input.options));
+        codegen.set_field_order(field_order_option(input.options));
+        codegen.set_frame_allocation(frame_allocation_option(input.options));
+        apply_profile_options(input.options, codegen, profile);
+        codegen.set_parallel_workers(codegen_worker_count(input.options));
         CCodegenResult result = codegen.generate(*program.module, program);
+        // The unit is a single file, so the header's include guard only makes
+        // host compilers warn about `#pragma once` in the main file.
+        constexpr const char* kIncludeGuard = "#pragma once\n";
+        const size_t guard = result.header.find(kIncludeGuard);
+        if (guard != std::string::npos) {
+            result.header.erase(guard, std::strlen(kIncludeGuard));
+        }
         out_translation_unit = result.header + "\n" + result.source;
         return true;
     } catch (const CompileError& e) {
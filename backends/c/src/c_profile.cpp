@@ -0,0 +1,90 @@
+#include "c_profile.h"
+#include "common.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace vexel::c_backend_codegen {
+
+namespace {
+
+constexpr double kHotEntryShare = 0.9;
+constexpr uint64_t kMinBranchSamples = 16;
+
+} // namespace
+
+bool ExecutionProfile::is_cold(const std::string& c_name) const {
+    auto it = entries.find(c_name);
+    return it != entries.end() && it->second == 0;
+}
+
+int ExecutionProfile::branch_bias(const std::string& c_name, size_t site) const {
+    auto it = branches.find(c_name);
+    if (it == branches.end() || site >= it->second.size()) return 0;
+    const uint64_t not_taken = it->second[site].first;
+    const uint64_t taken = it->second[site].second;
+    const uint64_t total = not_taken + taken;
+    if (total < kMinBranchSamples) return 0;
+    if (taken * 10 >= total * 9) return 1;
+    if (not_taken * 10 >= total * 9) return -1;
+    return 0;
+}
+
+ExecutionProfile load_execution_profile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw CompileError("Cannot read execution profile: " + path, SourceLocation());
+    }
+    ExecutionProfile profile;
+    std::string line;
+    size_t line_no = 0;
+    auto malformed = [&]() {
+        return CompileError("Malformed execution profile " + path + " at line " + std::to_string(line_no),
+                            SourceLocation());
+    };
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (line.empty() || line == kExecutionProfileHeader) continue;
+        std::istringstream fields(line);
+        std::string kind;
+        std::string name;
+        fields >> kind >> name;
+        if (kind == "f") {
+            uint64_t count = 0;
+            if (!(fields >> count)) throw malformed();
+            profile.entries[name] += count;
+        } else if (kind == "b") {
+            size_t site = 0;
+            uint64_t not_taken = 0;
+            uint64_t taken = 0;
+            if (!(fields >> site >> not_taken >> taken)) throw malformed();
+            auto& sites = profile.branches[name];
+            if (sites.size() <= site) sites.resize(site + 1);
+            sites[site].first += not_taken;
+            sites[site].second += taken;
+        } else {
+            throw malformed();
+        }
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> by_count;
+    uint64_t total = 0;
+    for (const auto& entry : profile.entries) {
+        if (entry.second == 0) continue;
+        by_count.emplace_back(entry.second, entry.first);
+        total += entry.second;
+    }
+    std::sort(by_count.begin(), by_count.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    uint64_t covered = 0;
+    for (const auto& entry : by_count) {
+        if (static_cast<double>(covered) >= kHotEntryShare * static_cast<double>(total)) break;
+        profile.hot.insert(entry.second);
+        covered += entry.first;
+    }
+    return profile;
+}
+
+} // namespace vexel::c_backend_codegen
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace vexel::c_backend_codegen {
+
+// Execution counts written by a `profile_generate` build, keyed by the C name
+// of each function variant. Every run appends one record set to the profile
+// file; loading sums them.
+struct ExecutionProfile {
+    std::unordered_map<std::string, uint64_t> entries;
+    // Per function, the not-taken/taken counts of each runtime conditional
+    // in emission order.
+    std::unordered_map<std::string, std::vector<std::pair<uint64_t, uint64_t>>> branches;
+    // Most-entered variants that together account for 90% of all entries.
+    std::unordered_set<std::string> hot;
+
+    // True when the variant was instrumented and never entered.
+    bool is_cold(const std::string& c_name) const;
+    // +1 when the conditional went the same way in at least 90% of enough
+    // samples, -1 when it almost never held, 0 otherwise.
+    int branch_bias(const std::string& c_name, size_t site) const;
+};
+
+// Throws CompileError when the file cannot be read or a line is malformed.
+ExecutionProfile load_execution_profile(const std::string& path);
+
+// First line of every record set in a profile file.
+constexpr const char* kExecutionProfileHeader = "vexel-profile 1";
+
+} // namespace vexel::c_backend_codegen
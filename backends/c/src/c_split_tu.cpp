@@ -0,0 +1,53 @@
+#include "c_split_tu.h"
+
+#include <unordered_map>
+
+namespace vexel::c_backend_codegen {
+
+std::vector<unsigned> partition_translation_units(const std::vector<GeneratedFunctionInfo>& functions,
+                                                  unsigned unit_count) {
+    std::vector<unsigned> units(functions.size(), 0);
+    if (unit_count <= 1 || functions.empty()) return units;
+
+    std::unordered_map<std::string, size_t> index_of;
+    index_of.reserve(functions.size());
+    for (size_t i = 0; i < functions.size(); ++i) {
+        index_of.emplace(functions[i].c_name, i);
+    }
+
+    std::vector<size_t> order;
+    order.reserve(functions.size());
+    std::vector<bool> visited(functions.size(), false);
+    std::vector<size_t> stack;
+    for (size_t root = 0; root < functions.size(); ++root) {
+        stack.push_back(root);
+        while (!stack.empty()) {
+            size_t current = stack.back();
+            stack.pop_back();
+            if (visited[current]) continue;
+            visited[current] = true;
+            order.push_back(current);
+            const auto& callees = functions[current].callees;
+            for (auto it = callees.rbegin(); it != callees.rend(); ++it) {
+                auto found = index_of.find(*it);
+                if (found != index_of.end() && !visited[found->second]) {
+                    stack.push_back(found->second);
+                }
+            }
+        }
+    }
+
+    uint64_t total = 0;
+    for (const auto& info : functions) {
+        total += info.code.size() + 1;
+    }
+    uint64_t before = 0;
+    for (size_t index : order) {
+        uint64_t unit = before * unit_count / total;
+        units[index] = static_cast<unsigned>(unit < unit_count ? unit : unit_count - 1);
+        before += functions[index].code.size() + 1;
+    }
+    return units;
+}
+
+} // namespace vexel::c_backend_codegen
@@ -0,0 +1,14 @@
+#pragma once
+#include "codegen.h"
+#include <vector>
+
+namespace vexel::c_backend_codegen {
+
+// Assigns each generated function to one of `unit_count` translation units.
+// Functions are laid out in depth-first call order from source-order roots,
+// so callees tend to land next to their callers, and that sequence is cut
+// into runs of roughly equal code size. Returns one unit index per function.
+std::vector<unsigned> partition_translation_units(const std::vector<GeneratedFunctionInfo>& functions,
+                                                  unsigned unit_count);
+
+} // namespace vexel::c_backend_codegen
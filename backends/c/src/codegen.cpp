@@ -4,6 +4,7 @@
 #include "expr_access.h"
 #include "function_key.h"
 #include "optimizer.h"
+#include "pipeline_trace.h"
 #include "constants.h"
 #include <algorithm>
 #include <functional>
@@ -15,38 +16,6 @@
 #include <optional>
 
 namespace {
-std::string escape_c_string(const std::string& input) {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (unsigned char c : input) {
-        switch (c) {
-            case '\\':
-                oss << "\\\\";
-                break;
-            case '"':
-                oss << "\\\"";
-                break;
-            case '\n':
-                oss << "\\n";
-                break;
-            case '\r':
-                oss << "\\r";
-                break;
-            case '\t':
-                oss << "\\t";
-                break;
-            default:
-                if (c >= 0x20 && c <= 0x7e) {
-                    oss << static_cast<char>(c);
-                } else {
-                    oss << "\\x" << std::uppercase << std::setw(2) << static_cast<int>(c) << std::nouppercase;
-                }
-                break;
-        }
-    }
-    return oss.str();
-}
-
 const char* expr_kind_name(vexel::Expr::Kind kind) {
     switch (kind) {
         case vexel::Expr::Kind::IntLiteral: return "IntLiteral";
@@ -142,8 +111,9 @@ CCodegenResult CodeGenerator::generate(const Module& mod, const AnalyzedProgram&
     body.clear();
     generated_functions.clear();
     generated_vars.clear();
+    streaming_body = body_sink != nullptr;
     current_ref_params.clear();
-    facts = AnalysisFacts{};
+    facts = nullptr;
     optimization = analyzed.optimization;
     current_reentrancy_key = 'N';
     current_module_id_expr = "0";
@@ -173,10 +143,20 @@ CCodegenResult CodeGenerator::generate(const Module& mod, const AnalyzedProgram&
     }
     comparator_cache.clear();
     comparator_definitions.clear();
+    shared_state_events.clear();
+    pool_rodata_literals = true;
+    rodata_offsets.clear();
+    rodata_blob.clear();
+    rodata_size = 0;
     extint_types_used.clear();
+    wide_native_types_used.clear();
     extint_runtime_needed = false;
     extint_runtime_source.clear();
     extint_header_defs.clear();
+    print_buffer_used = false;
+    promoted_slot_decls.clear();
+    variant_definitions.clear();
+    variant_aliases.clear();
     while (!output_stack.empty()) output_stack.pop();
     output_stack.push(&body);
 
@@ -193,6 +173,7 @@ CCodegenResult CodeGenerator::generate(const Module& mod, const AnalyzedProgram&
     emit_header("#include <string.h>");
     emit_header("#include <stdlib.h>");
     emit_header("#include <math.h>");
+    if (!profile_output.empty()) emit_header("#include <stdio.h>");
     emit_header("");
     emit_header("#ifndef VX_MUTABLE");
     emit_header("#define VX_MUTABLE");
@@ -203,40 +184,315 @@ CCodegenResult CodeGenerator::generate(const Module& mod, const AnalyzedProgram&
     emit_header("#ifndef VX_CONSTEXPR");
     emit_header("#define VX_CONSTEXPR const");
     emit_header("#endif");
+    emit_header("#ifndef VX_RESTRICT");
+    emit_header("#ifdef __cplusplus");
+    emit_header("#define VX_RESTRICT");
+    emit_header("#else");
+    emit_header("#define VX_RESTRICT restrict");
+    emit_header("#endif");
+    emit_header("#endif");
+    emit_header("#if defined(__GNUC__) || defined(__clang__)");
+    emit_header("#define VX_HAS_GNU_ATTRIBUTES 1");
+    emit_header("#else");
+    emit_header("#define VX_HAS_GNU_ATTRIBUTES 0");
+    emit_header("#endif");
+    const char* const attribute_macros[][2] = {
+        {"VX_PURE", "__attribute__((pure))"},
+        {"VX_CONST", "__attribute__((const))"},
+        {"VX_NONNULL(...)", "__attribute__((nonnull(__VA_ARGS__)))"},
+    };
+    for (const auto& macro : attribute_macros) {
+        std::string name = macro[0];
+        emit_header("#ifndef " + name.substr(0, name.find('(')));
+        emit_header("#if VX_HAS_GNU_ATTRIBUTES");
+        emit_header("#define " + name + " " + macro[1]);
+        emit_header("#else");
+        emit_header("#define " + name);
+        emit_header("#endif");
+        emit_header("#endif");
+    }
+    if (execution_profile) {
+        for (const auto& macro : {std::make_pair("VX_HOT", "hot"), std::make_pair("VX_COLD", "cold")}) {
+            emit_header(std::string("#ifndef ") + macro.first);
+            emit_header("#if VX_HAS_GNU_ATTRIBUTES");
+            emit_header(std::string("#define ") + macro.first + " __attribute__((" + macro.second + "))");
+            emit_header("#else");
+            emit_header(std::string("#define ") + macro.first);
+            emit_header("#endif");
+            emit_header("#endif");
+        }
+        emit_header("#ifndef VX_LIKELY");
+        emit_header("#if VX_HAS_GNU_ATTRIBUTES");
+        emit_header("#define VX_LIKELY(c) __builtin_expect(!!(c), 1)");
+        emit_header("#define VX_UNLIKELY(c) __builtin_expect(!!(c), 0)");
+        emit_header("#else");
+        emit_header("#define VX_LIKELY(c) (c)");
+        emit_header("#define VX_UNLIKELY(c) (c)");
+        emit_header("#endif");
+        emit_header("#endif");
+    }
+    if (!profile_output.empty()) {
+        // Counts one conditional: slot i when it fails, slot i + 1 when it holds.
+        emit_header("#define VX_PROF_BRANCH(a, i, c) ((c) ? ((a)[(i) + 1]++, 1) : ((a)[i]++, 0))");
+    }
+    if (abi.hidden_internal_linkage) {
+        emit_header("#ifndef VX_INTERNAL");
+        emit_header("#if defined(__GNUC__) || defined(__clang__)");
+        emit_header("#define VX_INTERNAL __attribute__((visibility(\"hidden\")))");
+        emit_header("#else");
+        emit_header("#define VX_INTERNAL");
+        emit_header("#endif");
+        emit_header("#endif");
+    }
     emit_header("");
 
     if (analyzed.analysis) {
-        facts = *analyzed.analysis;
+        facts = analyzed.analysis;
     } else {
         throw CompileError("Internal error: backend received module without analysis facts",
                            SourceLocation());
     }
 
     validate_codegen_invariants(mod);
+    current_profile_function.clear();
+    current_profile_sites = 0;
+    collect_cold_nonreentrant_functions();
 
     gen_module(mod);
+    emit_profile_runtime();
+    flush_body_to_sink();
+    if (abi.hidden_internal_linkage) {
+        if (!rodata_blob.empty()) {
+            header << "extern " << internal_storage() << "const char vx_rodata[];\n";
+        }
+        header << promoted_slot_decls;
+    }
+
+    // Aliased variants are macros ahead of every prototype, so their
+    // declarations redeclare the emitted variant and calls reach it.
+    std::string alias_defs;
+    if (!variant_aliases.empty()) {
+        std::unordered_map<std::string, std::string> canonical(variant_aliases.begin(), variant_aliases.end());
+        alias_defs = "// Identical function variants\n";
+        for (const auto& alias : variant_aliases) {
+            alias_defs += "#define " + alias.first + " " + alias.second + "\n";
+        }
+        alias_defs += "\n";
+        for (auto& info : generated_functions) {
+            for (auto& callee : info.callees) {
+                auto it = canonical.find(callee);
+                if (it != canonical.end()) callee = it->second;
+            }
+        }
+    }
+
+    std::string frame_declarations;
+    std::string frame_definitions;
+    if (frame_allocation == FrameAllocation::Overlay) {
+        frame_declarations = frame_overlay_declarations(frame_definitions);
+    }
 
     CCodegenResult result;
-    if (extint_header_defs.empty()) {
+    if (extint_header_defs.empty() && alias_defs.empty()) {
         result.header = header.str();
     } else {
         std::ostringstream combined_header;
         combined_header << extint_header_defs;
+        combined_header << alias_defs;
         combined_header << header.str();
         result.header = combined_header.str();
     }
     std::ostringstream combined;
+    std::ostringstream helpers;
+    std::ostream& helper_out = abi.hidden_internal_linkage ? static_cast<std::ostream&>(helpers) : combined;
+    helper_out << frame_declarations;
     if (!extint_runtime_source.empty()) {
-        combined << extint_runtime_source << "\n";
+        helper_out << extint_runtime_source << "\n";
     }
     for (const auto& helper : comparator_definitions) {
-        combined << helper << "\n";
+        helper_out << helper << "\n";
+    }
+    if (print_buffer_used) {
+        if (abi.hidden_internal_linkage) helpers << print_buffer_runtime(true);
+        combined << print_buffer_runtime(false);
     }
+    if (!rodata_blob.empty()) {
+        combined << internal_storage() << "const char vx_rodata[] =\n" << rodata_blob << ";\n\n";
+    }
+    combined << frame_definitions;
     combined << body.str();
     result.source = combined.str();
+    result.shared_helpers = helpers.str();
     return result;
 }
 
+void CodeGenerator::flush_body_to_sink() {
+    if (!streaming_body || (!output_stack.empty() && output_stack.top() != &body)) return;
+    std::string chunk = body.str();
+    if (chunk.empty()) return;
+    *body_sink << chunk;
+    if (!*body_sink) {
+        throw CompileError("Internal error: failed to write generated C source", SourceLocation());
+    }
+    body.str("");
+    body.clear();
+}
+
+namespace {
+
+// `code` with whole-identifier occurrences of `name` replaced by `@`.
+std::string normalize_identifier(const std::string& code, const std::string& name) {
+    auto is_ident = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    std::string out;
+    out.reserve(code.size());
+    size_t pos = 0;
+    while (true) {
+        size_t found = code.find(name, pos);
+        while (found != std::string::npos &&
+               ((found > 0 && is_ident(code[found - 1])) ||
+                (found + name.size() < code.size() && is_ident(code[found + name.size()])))) {
+            found = code.find(name, found + 1);
+        }
+        if (found == std::string::npos) break;
+        out.append(code, pos, found - pos);
+        out += '@';
+        pos = found + name.size();
+    }
+    out.append(code, pos, std::string::npos);
+    return out;
+}
+
+} // namespace
+
+bool CodeGenerator::alias_identical_variant(const GeneratedFunctionInfo& info, const std::string& code) {
+    if (!info.aliasable_variant) return false;
+    // The traits comment names the variant's keys; everything else must match.
+    std::string normalized = normalize_identifier(code, info.c_name);
+    const size_t traits = normalized.find("// VEXEL: kind=");
+    if (traits != std::string::npos) {
+        normalized.erase(traits, normalized.find('\n', traits) - traits);
+    }
+    auto& definitions = variant_definitions[info.declaration.get()];
+    auto inserted = definitions.emplace(std::move(normalized), info.c_name);
+    if (inserted.second) return false;
+    variant_aliases.emplace_back(info.c_name, inserted.first->second);
+    return true;
+}
+
+std::string CodeGenerator::frame_overlay_declarations(std::string& definitions) const {
+    const size_t count = generated_functions.size();
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < count; ++i) index[generated_functions[i].c_name] = i;
+
+    // A variant that can reach an external or indirect call may be re-entered
+    // through a callback while its frame is live: it and its callers keep
+    // their own storage, and its callees are laid out from level 0.
+    std::vector<std::vector<size_t>> callers(count);
+    std::vector<bool> reenterable(count, false);
+    std::vector<size_t> worklist;
+    for (size_t i = 0; i < count; ++i) {
+        bool external = generated_functions[i].calls_external;
+        for (const auto& callee : generated_functions[i].callees) {
+            auto it = index.find(callee);
+            if (it == index.end()) {
+                external = true;
+            } else {
+                callers[it->second].push_back(i);
+            }
+        }
+        if (external) {
+            reenterable[i] = true;
+            worklist.push_back(i);
+        }
+    }
+    while (!worklist.empty()) {
+        const size_t i = worklist.back();
+        worklist.pop_back();
+        for (size_t caller : callers[i]) {
+            if (!reenterable[caller]) {
+                reenterable[caller] = true;
+                worklist.push_back(caller);
+            }
+        }
+    }
+
+    // A frame's level is one past the deepest frame that can be live when it
+    // is entered, so frames on one level are never live at once.
+    std::vector<size_t> indegree(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (reenterable[i]) continue;
+        for (const auto& callee : generated_functions[i].callees) ++indegree[index.at(callee)];
+    }
+    std::vector<size_t> level(count, 0);
+    size_t acyclic = 0;
+    size_t candidates = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (reenterable[i]) continue;
+        ++candidates;
+        if (indegree[i] == 0) worklist.push_back(i);
+    }
+    while (!worklist.empty()) {
+        const size_t i = worklist.back();
+        worklist.pop_back();
+        ++acyclic;
+        const size_t below = level[i] + (generated_functions[i].frame_fields.empty() ? 0 : 1);
+        for (const auto& callee : generated_functions[i].callees) {
+            const size_t c = index.at(callee);
+            level[c] = std::max(level[c], below);
+            if (--indegree[c] == 0) worklist.push_back(c);
+        }
+    }
+    // Recursion leaves every frame in its own storage.
+    const bool overlay = acyclic == candidates;
+
+    std::ostringstream out;
+    std::vector<std::vector<size_t>> levels;
+    std::vector<size_t> separate;
+    for (size_t i = 0; i < count; ++i) {
+        const GeneratedFunctionInfo& info = generated_functions[i];
+        if (info.frame_fields.empty()) continue;
+        if (out.tellp() == 0) out << "// Static frames of non-reentrant variants\n";
+        out << "struct vx_frame_" << info.c_name << " {\n";
+        for (const auto& field : info.frame_fields) out << "    " << field << ";\n";
+        out << "};\n";
+        if (overlay && !reenterable[i]) {
+            if (levels.size() <= level[i]) levels.resize(level[i] + 1);
+            levels[level[i]].push_back(i);
+        } else {
+            separate.push_back(i);
+        }
+    }
+    if (!levels.empty()) {
+        out << "struct vx_frame_overlay {\n";
+        for (size_t l = 0; l < levels.size(); ++l) {
+            if (levels[l].empty()) continue;
+            out << "    union {\n";
+            for (size_t i : levels[l]) {
+                const std::string& c_name = generated_functions[i].c_name;
+                out << "        struct vx_frame_" << c_name << " " << c_name << ";\n";
+            }
+            out << "    } l" << l << ";\n";
+        }
+        out << "};\n";
+        for (size_t l = 0; l < levels.size(); ++l) {
+            for (size_t i : levels[l]) {
+                const std::string& c_name = generated_functions[i].c_name;
+                out << "#define " << frame_object_name(c_name) << " (vx_frames.l" << l << "." << c_name << ")\n";
+            }
+        }
+        if (abi.hidden_internal_linkage) out << "extern " << internal_storage() << "struct vx_frame_overlay vx_frames;\n";
+        definitions += internal_storage() + "struct vx_frame_overlay vx_frames;\n";
+    }
+    for (size_t i : separate) {
+        const std::string decl = "struct vx_frame_" + generated_functions[i].c_name + " " +
+                                 frame_object_name(generated_functions[i].c_name) + ";\n";
+        if (abi.hidden_internal_linkage) out << "extern " << internal_storage() << decl;
+        definitions += internal_storage() + decl;
+    }
+    if (!definitions.empty()) definitions += "\n";
+    return out.str();
+}
+
 GeneratedFunctionInfo CodeGenerator::generate_single_function(const Module& mod,
                                                               StmtPtr func,
                                                               const AnalyzedProgram& analyzed,
@@ -256,9 +512,10 @@ GeneratedFunctionInfo CodeGenerator::generate_single_function(const Module& mod,
     body.clear();
     generated_functions.clear();
     generated_vars.clear();
+    streaming_body = false;
     current_ref_params.clear();
     current_aggregate_params.clear();
-    facts = AnalysisFacts{};
+    facts = nullptr;
     optimization = analyzed.optimization;
     current_reentrancy_key = reent_key;
     current_module_id_expr = "0";
@@ -285,7 +542,10 @@ GeneratedFunctionInfo CodeGenerator::generate_single_function(const Module& mod,
     }
     comparator_cache.clear();
     comparator_definitions.clear();
+    // The caller assembles single functions itself and never sees the blob.
+    pool_rodata_literals = false;
     extint_types_used.clear();
+    wide_native_types_used.clear();
     extint_runtime_needed = false;
     extint_runtime_source.clear();
     extint_header_defs.clear();
@@ -299,7 +559,7 @@ GeneratedFunctionInfo CodeGenerator::generate_single_function(const Module& mod,
     entry_instance_id = analyzed.entry_instance_id;
 
     if (analyzed.analysis) {
-        facts = *analyzed.analysis;
+        facts = analyzed.analysis;
     } else {
         throw CompileError("Internal error: backend single-function emit missing analysis facts",
                            SourceLocation());
@@ -471,7 +731,7 @@ void CodeGenerator::validate_codegen_invariants_impl(const std::vector<StmtPtr>&
                     return;
                 }
                 Symbol* sym = binding_for(stmt);
-                if (use_facts && sym && !facts.reachable_functions.count(sym)) {
+                if (use_facts && sym && !facts->reachable_functions.count(sym)) {
                     return;
                 }
                 if (stmt->body) {
@@ -497,7 +757,7 @@ void CodeGenerator::validate_codegen_invariants_impl(const std::vector<StmtPtr>&
                 bool skip = false;
                 if (is_top_level && use_facts) {
                     Symbol* sym = binding_for(stmt);
-                    if (sym && !stmt->is_exported && !facts.used_global_vars.count(sym)) {
+                    if (sym && !stmt->is_exported && !facts->used_global_vars.count(sym)) {
                         skip = true;
                     }
                 }
@@ -575,6 +835,10 @@ void CodeGenerator::gen_module(const Module& mod) {
                 std::string qualified_name = (ext_sym && !ext_sym->name.empty()) ? ext_sym->name : func_name;
                 bool bundled_std_math = is_bundled_std_math_function(ext_sym, stmt);
                 bool bundled_std_bits = is_bundled_std_bits_function(ext_sym, stmt);
+                if (is_bundled_std_print_function(ext_sym, stmt) && is_std_print_builtin_name(stmt->func_name)) {
+                    print_buffer_used = true;
+                    continue;
+                }
                 if (bundled_std_math) {
                     qualified_name = "std::math::" + stmt->func_name;
                 }
@@ -617,6 +881,20 @@ void CodeGenerator::gen_module(const Module& mod) {
     });
     emit_header("");
 
+    declared_layout_types.clear();
+    if (field_order == FieldOrder::Alignment) {
+        std::vector<TypePtr> roots;
+        std::unordered_map<std::string, StmtPtr> type_decls;
+        for_instances([&](const Module& module) {
+            for (const auto& stmt : module.top_level) {
+                if (is_live_top_level(stmt)) collect_declared_layout_roots(stmt, roots, type_decls);
+            }
+        });
+        for (const auto& type : roots) {
+            pin_declared_layout(type, type_decls);
+        }
+    }
+
     // Type declarations (deduped by name)
     std::unordered_set<std::string> emitted_types;
     if (program) {
@@ -624,7 +902,7 @@ void CodeGenerator::gen_module(const Module& mod) {
             for (const auto& stmt : mod_info.module.top_level) {
                 if (!is_live_top_level(stmt)) continue;
                 if (stmt->kind != Stmt::Kind::TypeDecl) continue;
-                if (!facts.used_type_names.empty() && !facts.used_type_names.count(stmt->type_decl_name)) {
+                if (!facts->used_type_names.empty() && !facts->used_type_names.count(stmt->type_decl_name)) {
                     continue;
                 }
                 if (!emitted_types.insert(stmt->type_decl_name).second) {
@@ -637,7 +915,7 @@ void CodeGenerator::gen_module(const Module& mod) {
         for (const auto& stmt : mod.top_level) {
             if (!is_live_top_level(stmt)) continue;
             if (stmt->kind != Stmt::Kind::TypeDecl) continue;
-            if (!facts.used_type_names.empty() && !facts.used_type_names.count(stmt->type_decl_name)) {
+            if (!facts->used_type_names.empty() && !facts->used_type_names.count(stmt->type_decl_name)) {
                 continue;
             }
             if (!emitted_types.insert(stmt->type_decl_name).second) {
@@ -654,19 +932,27 @@ void CodeGenerator::gen_module(const Module& mod) {
             if (!is_live_top_level(stmt)) {
                 continue;
             }
-            if (stmt->kind != Stmt::Kind::VarDecl || !stmt->is_exported) {
+            if (stmt->kind != Stmt::Kind::VarDecl) {
                 continue;
             }
             Symbol* sym = binding_for(stmt);
             if (!sym) {
                 continue;
             }
+            // Hidden internal globals are declared here too, so every
+            // translation unit sees the one definition.
+            const bool promoted = abi.hidden_internal_linkage && !stmt->is_exported &&
+                                  stmt->var_linkage == VarLinkageKind::Normal &&
+                                  facts->used_global_vars.count(sym);
+            if (!stmt->is_exported && !promoted) {
+                continue;
+            }
             std::string var_name = mangle_name(stmt->var_name) + instance_suffix(sym);
             if (!emitted_exported_globals.insert(var_name).second) {
                 continue;
             }
 
-            std::string mutability = mutability_prefix(stmt);
+            std::string mutability = (promoted ? internal_storage() : std::string()) + mutability_prefix(stmt);
             if (stmt->var_type && stmt->var_type->kind == Type::Kind::Array) {
                 emit_header("extern " + mutability +
                             gen_object_decl(stmt->var_type,
@@ -705,7 +991,7 @@ void CodeGenerator::gen_module(const Module& mod) {
             }
             Symbol* sym = binding_for(stmt);
             if (!sym || sym->kind != Symbol::Kind::Function) continue;
-            if (!facts.reachable_functions.count(sym)) {
+            if (!facts->reachable_functions.count(sym)) {
                 continue;
             }
 
@@ -723,16 +1009,16 @@ void CodeGenerator::gen_module(const Module& mod) {
             std::string func_name = sym->name;
             std::string func_key = func_key_for(sym);
 
-            std::string storage = stmt->is_exported ? "" : "static ";
+            std::string storage = stmt->is_exported ? "" : internal_storage();
             bool is_pure = false;
             bool no_global_write = false;
             {
-                auto pure_it = facts.function_is_pure.find(sym);
-                if (pure_it != facts.function_is_pure.end() && pure_it->second) {
+                auto pure_it = facts->function_is_pure.find(sym);
+                if (pure_it != facts->function_is_pure.end() && pure_it->second) {
                     is_pure = true;
                 }
-                auto gw_it = facts.function_writes_global.find(sym);
-                if (gw_it != facts.function_writes_global.end() && !gw_it->second) {
+                auto gw_it = facts->function_writes_global.find(sym);
+                if (gw_it != facts->function_writes_global.end() && !gw_it->second) {
                     no_global_write = true;
                 }
             }
@@ -806,12 +1092,16 @@ void CodeGenerator::gen_module(const Module& mod) {
                                                               no_global_write,
                                                               frame_abi_variant));
 
+                    SignatureQualifiers quals = signature_qualifiers(stmt, sym, ref_key, reent_key,
+                                                                     frame_abi_variant, ret_type != "void",
+                                                                     returns_aggregate);
+                    const std::string profile_attrs = profile_attributes(codegen_name);
                     if (frame_abi_variant) {
-                        emit_header(storage + "void " + codegen_name + "(void);");
+                        emit_header(storage + profile_attrs + "void " + codegen_name + "(void);");
                         continue;
                     }
 
-                    emit_header(storage + ret_type + " " + codegen_name + "(");
+                    emit_header(storage + quals.attributes + profile_attrs + ret_type + " " + codegen_name + "(");
 
                     bool first_param = true;
                     if (returns_aggregate) {
@@ -849,9 +1139,11 @@ void CodeGenerator::gen_module(const Module& mod) {
                             ref_type = "void*";
                         }
 
-                        emit_header(ref_type + " " + mangle_name(stmt->ref_params[i]));
+                        emit_header(qualified_param_type(ref_type, quals, i) + " " +
+                                    mangle_name(stmt->ref_params[i]));
                     }
 
+                    size_t param_index = stmt->ref_params.size();
                     for (size_t i = 0; i < stmt->params.size(); i++) {
                         if (stmt->params[i].is_expression_param) continue;
                         if (!first_param) emit_header(", ");
@@ -871,7 +1163,8 @@ void CodeGenerator::gen_module(const Module& mod) {
                             stmt->params[i].type->kind != Type::Kind::Array) {
                             ptype = gen_type(stmt->params[i].type) + "*";
                         }
-                        emit_header(ptype + " " + mangle_name(stmt->params[i].name));
+                        emit_header(qualified_param_type(ptype, quals, param_index++) + " " +
+                                    mangle_name(stmt->params[i].name));
                     }
                     emit_header(");");
                 }
@@ -881,14 +1174,27 @@ void CodeGenerator::gen_module(const Module& mod) {
     emit_header("");
 
     // Global variables and functions
-    for_instances([&](const Module& module) {
-        for (const auto& stmt : module.top_level) {
-            if (!is_live_top_level(stmt)) {
-                continue;
+    if (parallel_workers > 1) {
+        std::vector<std::pair<int, StmtPtr>> items;
+        for_instances([&](const Module& module) {
+            for (const auto& stmt : module.top_level) {
+                if (is_live_top_level(stmt)) {
+                    items.emplace_back(current_instance_id, stmt);
+                }
             }
-            gen_stmt(stmt);
-        }
-    });
+        });
+        gen_top_level_parallel(items);
+    } else {
+        for_instances([&](const Module& module) {
+            for (const auto& stmt : module.top_level) {
+                if (!is_live_top_level(stmt)) {
+                    continue;
+                }
+                gen_stmt(stmt);
+                flush_body_to_sink();
+            }
+        });
+    }
 
     // Generate tuple type declarations (collected during code generation)
     // These are emitted at the end of gen_module after everything is processed
@@ -896,7 +1202,7 @@ void CodeGenerator::gen_module(const Module& mod) {
     std::vector<std::pair<std::string, std::vector<TypePtr>>> tuple_decls;
     if (!tuple_types.empty()) {
         for (const auto& pair : tuple_types) {
-            if (!facts.used_type_names.empty() && !facts.used_type_names.count(pair.first)) {
+            if (!facts->used_type_names.empty() && !facts->used_type_names.count(pair.first)) {
                 continue;
             }
             tuple_decls.push_back(pair);
@@ -994,6 +1300,7 @@ void CodeGenerator::gen_stmt(StmtPtr stmt) {
                     stmt->expr->left->kind == Expr::Kind::Identifier &&
                     stmt->expr->creates_new_variable) {
                     // Keep declaration-assignment lowering in one place.
+                    VoidCallGuard guard(*this, true);
                     (void)gen_assignment(stmt->expr);
                     break;
                 }
@@ -1045,7 +1352,7 @@ void CodeGenerator::gen_stmt(StmtPtr stmt) {
                 std::string cond_expr;
                 {
                     VoidCallGuard guard(*this, false);
-                    cond_expr = gen_expr(stmt->condition);
+                    cond_expr = profiled_condition(gen_expr(stmt->condition));
                 }
                 emit("if (" + cond_expr + ") {");
             }
@@ -1082,7 +1389,7 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
     current_function_non_reentrant = (reent_key == 'N');
 
     // Skip unreachable functions (dead code elimination)
-    if (!facts.reachable_functions.count(sym)) {
+    if (!facts->reachable_functions.count(sym)) {
         current_function_non_reentrant = false;
         current_reentrancy_key = 'N';
         current_nonreentrant_frame_abi = false;
@@ -1091,6 +1398,7 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
         return;
     }
 
+    TraceSpan span("emit", "emit", variant_id);
     current_func_key = func_key;
     current_func_symbol = sym;
     if (abi.func_page) {
@@ -1107,12 +1415,12 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
     bool is_pure = false;
     bool no_global_write = false;
     {
-        auto pure_it = facts.function_is_pure.find(sym);
-        if (pure_it != facts.function_is_pure.end() && pure_it->second) {
+        auto pure_it = facts->function_is_pure.find(sym);
+        if (pure_it != facts->function_is_pure.end() && pure_it->second) {
             is_pure = true;
         }
-        auto gw_it = facts.function_writes_global.find(sym);
-        if (gw_it != facts.function_writes_global.end() && !gw_it->second) {
+        auto gw_it = facts->function_writes_global.find(sym);
+        if (gw_it != facts->function_writes_global.end() && !gw_it->second) {
             no_global_write = true;
         }
     }
@@ -1137,6 +1445,8 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
 
     // Track reference parameters for this function (mutable paths use pointers)
     current_ref_params.clear();
+    current_callees.clear();
+    current_calls_external = false;
     current_aggregate_params.clear();
     for (size_t i = 0; i < stmt->ref_params.size(); i++) {
         bool by_ref = true;
@@ -1164,8 +1474,9 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
         }
     }
 
-    // Internal functions are static, exported functions are public
-    std::string storage = stmt->is_exported ? "" : "static ";
+    // Internal functions are static (hidden when split across translation
+    // units), exported functions are public
+    std::string storage = stmt->is_exported ? "" : internal_storage();
 
     // Handle tuple return types
     std::string ret_type;
@@ -1277,25 +1588,52 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
         }
         frame_params.emplace_back(ptype, mangle_name(stmt->params[i].name));
     }
-
+    SignatureQualifiers quals = signature_qualifiers(stmt, sym, ref_key, reent_key,
+                                                     current_nonreentrant_frame_abi, ret_type != "void",
+                                                     current_returns_aggregate);
+    for (size_t i = 0; i < frame_params.size(); i++) {
+        frame_params[i].first = qualified_param_type(frame_params[i].first, quals, i);
+    }
+
+    // Frame slots are file-scope objects. When internal symbols are hidden,
+    // callers in other translation units reach them through header externs,
+    // and the definitions travel with the function's code. Overlaid frames
+    // hold the return slot and temporaries; argument slots stay separate
+    // since a caller may still evaluate later arguments after storing
+    // earlier ones.
+    std::ostringstream frame_slot_stream;
+    current_frame_fields.clear();
+    const bool overlay_frame = current_nonreentrant_frame_abi && frame_allocation == FrameAllocation::Overlay;
     if (current_nonreentrant_frame_abi) {
+        output_stack.push(&frame_slot_stream);
+        auto emit_slot = [&](const std::string& type, const std::string& name) {
+            emit(internal_storage() + type + " " + name + ";");
+            if (abi.hidden_internal_linkage) {
+                promoted_slot_decls += "extern " + internal_storage() + type + " " + name + ";\n";
+            }
+        };
         emit("");
         for (size_t i = 0; i < frame_params.size(); ++i) {
-            emit("static " + frame_params[i].first + " " +
-                 nonreentrant_arg_slot_name(codegen_name, i) + ";");
+            emit_slot(frame_params[i].first, nonreentrant_arg_slot_name(codegen_name, i));
         }
 
-        if (current_returns_aggregate) {
+        const std::string& slot_type = current_returns_aggregate ? aggregate_out_type : ret_type;
+        if (current_returns_aggregate || ret_type != "void") {
             current_nonreentrant_returns_value = true;
             current_nonreentrant_return_slot = nonreentrant_ret_slot_name(codegen_name);
-            emit("static " + aggregate_out_type + " " + current_nonreentrant_return_slot + ";");
+            if (overlay_frame) {
+                current_frame_fields.push_back(slot_type + " ret");
+            } else {
+                emit_slot(slot_type, current_nonreentrant_return_slot);
+            }
             current_returns_aggregate = false;
-        } else if (ret_type != "void") {
-            current_nonreentrant_returns_value = true;
-            current_nonreentrant_return_slot = nonreentrant_ret_slot_name(codegen_name);
-            emit("static " + ret_type + " " + current_nonreentrant_return_slot + ";");
+        }
+        output_stack.pop();
+        if (!abi.hidden_internal_linkage) {
+            body << frame_slot_stream.str();
         }
     }
+    current_frame_object = overlay_frame ? frame_object_name(codegen_name) : "";
 
     bool prev_in_function = in_function;
     in_function = true;
@@ -1339,6 +1677,16 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
         }
     }
 
+    const std::string prev_profile_function = current_profile_function;
+    const size_t prev_profile_sites = current_profile_sites;
+    if (!profile_output.empty() || execution_profile) {
+        current_profile_function = codegen_name;
+        current_profile_sites = 0;
+    }
+    if (!profile_output.empty()) {
+        emit("vx_prof_" + codegen_name + "[0]++;");
+    }
+
     bool handled_body = false;
 
     if (stmt->body) {
@@ -1352,7 +1700,8 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
                     emit_return_stmt(std::to_string(std::get<uint64_t>(result)));
                     handled_body = true;
                 } else if (std::holds_alternative<CTExactInt>(result) &&
-                           stmt->return_type && is_extended_integer_type(stmt->return_type)) {
+                           stmt->return_type && (is_extended_integer_type(stmt->return_type) ||
+                                                 is_wide_native_integer_type(stmt->return_type))) {
                     APInt exact;
                     bool is_unsigned = false;
                     if (ctvalue_to_apint_value(result, exact, is_unsigned)) {
@@ -1363,7 +1712,7 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
                     emit_return_stmt(std::string(std::get<bool>(result) ? "1" : "0"));
                     handled_body = true;
                 } else if (std::holds_alternative<double>(result)) {
-                    emit_return_stmt(std::to_string(std::get<double>(result)));
+                    emit_return_stmt(format_c_double(std::get<double>(result)));
                     handled_body = true;
                 }
             }
@@ -1412,6 +1761,10 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
 
     emit("}");
 
+    const bool aliasable_variant = !stmt->is_exported && !current_nonreentrant_frame_abi &&
+                                   current_variant_name_override.empty() &&
+                                   reentrancy_keys_for(sym).size() * ref_variant_keys_for(stmt).size() > 1;
+
     current_function_non_reentrant = false;
     current_reentrancy_key = 'N';
     current_returns_aggregate = false;
@@ -1427,17 +1780,35 @@ void CodeGenerator::gen_func_decl(StmtPtr stmt, const std::string& ref_key, char
     current_func_symbol = nullptr;
     current_module_id_expr = "0";
     current_bank_page = 'A';
+    current_frame_object.clear();
     
     output_stack.pop();
     in_function = prev_in_function;
     std::string func_code = func_stream.str();
+    // Slot 0 counts entries; each conditional adds a not-taken/taken pair.
+    const size_t profile_counters = profile_output.empty() ? 0 : 1 + 2 * current_profile_sites;
+    if (profile_counters > 0) {
+        func_code = "\nstatic uint64_t vx_prof_" + codegen_name + "[" + std::to_string(profile_counters) + "];" +
+                    func_code;
+    }
+    current_profile_function = prev_profile_function;
+    current_profile_sites = prev_profile_sites;
+    if (abi.hidden_internal_linkage) {
+        func_code = frame_slot_stream.str() + func_code;
+    }
     if (!func_code.empty()) {
         GeneratedFunctionInfo info;
         info.declaration = stmt;
         info.qualified_name = variant_id;
         info.c_name = codegen_name;
         info.storage = storage;
-        info.code = func_code;
+        info.profile_counters = profile_counters;
+        info.aliasable_variant = aliasable_variant;
+        if (alias_identical_variant(info, func_code)) return;
+        if (!streaming_body || abi.multi_file_globals) info.code = func_code;
+        info.callees.assign(current_callees.begin(), current_callees.end());
+        info.frame_fields = std::move(current_frame_fields);
+        info.calls_external = current_calls_external;
         generated_functions.push_back(std::move(info));
         body << func_code;
     }
@@ -1447,7 +1818,21 @@ void CodeGenerator::gen_type_decl(StmtPtr stmt) {
     std::string ann_comment = render_annotation_comment(stmt->annotations);
     if (!ann_comment.empty()) emit_header(ann_comment);
     emit_header("typedef struct {");
-    for (const auto& field : stmt->fields) {
+    std::vector<const Field*> fields;
+    for (const auto& field : stmt->fields) fields.push_back(&field);
+    if (field_order == FieldOrder::Alignment && !declared_layout_types.count(stmt->type_decl_name)) {
+        // Descending alignment leaves no padding between fields; ties keep declaration order.
+        std::vector<size_t> align;
+        for (const Field* field : fields) align.push_back(field_alignment(field->type));
+        std::vector<size_t> order(fields.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return align[a] > align[b]; });
+        std::vector<const Field*> sorted;
+        for (size_t i : order) sorted.push_back(fields[i]);
+        fields.swap(sorted);
+    }
+    for (const Field* field_ptr : fields) {
+        const Field& field = *field_ptr;
         std::string field_decl = gen_object_decl(field.type,
                                                  mangle_name(field.name),
                                                  field.location,
@@ -1464,11 +1849,11 @@ void CodeGenerator::gen_type_decl(StmtPtr stmt) {
 void CodeGenerator::gen_var_decl(StmtPtr stmt) {
     bool is_local = in_function;
     Symbol* sym = binding_for(stmt);
-    if (!is_local && sym && !stmt->is_exported && !facts.used_global_vars.count(sym)) {
+    if (!is_local && sym && !stmt->is_exported && !facts->used_global_vars.count(sym)) {
         return;
     }
     // Non-exported globals stay translation-unit local in the C backend.
-    std::string storage = (!is_local && !stmt->is_exported) ? "static " : "";
+    std::string storage = (!is_local && !stmt->is_exported) ? internal_storage() : "";
     std::ostringstream var_stream;
     output_stack.push(&var_stream);
     std::string ann_comment = render_annotation_comment(stmt->annotations);
@@ -1486,7 +1871,7 @@ void CodeGenerator::gen_var_decl(StmtPtr stmt) {
             GeneratedVarInfo info;
             info.declaration = stmt;
             info.symbol = sym;
-            info.code = code;
+            if (!streaming_body || abi.multi_file_globals) info.code = code;
             generated_vars.push_back(std::move(info));
             if (!abi.multi_file_globals) {
                 body << code;
@@ -1607,6 +1992,28 @@ void CodeGenerator::gen_var_decl(StmtPtr stmt) {
                 }
             }
 
+            // Packed compile-time tables print straight from their lanes.
+            if (!is_local && stmt->var_type && stmt->var_type->kind == Type::Kind::Array &&
+                stmt->var_type->element_type &&
+                !is_extended_integer_type(stmt->var_type->element_type) &&
+                !is_wide_native_integer_type(stmt->var_type->element_type)) {
+                CTValue table_value;
+                const CTArray* table = lookup_constexpr_value(stmt->var_init, table_value)
+                                           ? cte_packed_table(table_value)
+                                           : nullptr;
+                if (table && static_cast<int64_t>(table->size()) ==
+                                 resolve_array_length(stmt->var_type, stmt->location)) {
+                    emit(storage + mutability +
+                         gen_object_decl(stmt->var_type,
+                                         mangle_name(var_name),
+                                         stmt->location,
+                                         "array variable '" + stmt->var_name + "'") +
+                         " = " + packed_table_initializer(*table) + ";");
+                    finalize();
+                    return;
+                }
+            }
+
             // Fallback for arrays initialized from existing arrays/expressions: allocate and copy
             if (stmt->var_type && stmt->var_type->kind == Type::Kind::Array) {
                 emit(storage + mutability +
@@ -1627,7 +2034,11 @@ void CodeGenerator::gen_var_decl(StmtPtr stmt) {
             // Try compile-time evaluation for simple constants
             {
             CTValue result;
-            if (lookup_constexpr_value(stmt->var_init, result)) {
+            // Aggregate values fall through to the static initializer below,
+            // which spells the constructor out field by field.
+            if (lookup_constexpr_value(stmt->var_init, result) &&
+                !std::holds_alternative<std::shared_ptr<CTComposite>>(result) &&
+                !std::holds_alternative<std::shared_ptr<CTArray>>(result)) {
                 // Successfully evaluated at compile time
                 std::string init_val;
                 if (std::holds_alternative<int64_t>(result)) {
@@ -1676,7 +2087,7 @@ void CodeGenerator::gen_var_decl(StmtPtr stmt) {
                         throw CompileError("Internal error: failed to read exact integer constant",
                                            stmt->location);
                     }
-                    if (is_extended_integer_type(stmt->var_type)) {
+                    if (is_extended_integer_type(stmt->var_type) || is_wide_native_integer_type(stmt->var_type)) {
                         init_val = emit_extint_const_initializer(stmt->var_type, exact, is_unsigned, stmt->location);
                     } else if (exact.fits_i64()) {
                         init_val = exact.to_string();
@@ -1688,11 +2099,11 @@ void CodeGenerator::gen_var_decl(StmtPtr stmt) {
                                            stmt->location);
                     }
                 } else if (std::holds_alternative<double>(result)) {
-                    init_val = std::to_string(std::get<double>(result));
+                    init_val = format_c_double(std::get<double>(result));
                 } else if (std::holds_alternative<bool>(result)) {
                     init_val = std::get<bool>(result) ? "1" : "0";
-                } else if (std::holds_alternative<std::string>(result)) {
-                    init_val = "\"" + escape_c_string(std::get<std::string>(result)) + "\"";
+                } else if (std::holds_alternative<CTString>(result)) {
+                    init_val = "\"" + escape_c_string(std::get<CTString>(result).str()) + "\"";
                 }
                 emit(storage + mutability + vtype + " " + mangle_name(var_name) + " = " + init_val + ";");
                 finalize();
@@ -1748,9 +2159,9 @@ void CodeGenerator::gen_var_decl(StmtPtr stmt) {
 
 std::string CodeGenerator::mutability_prefix(StmtPtr stmt) const {
     Symbol* sym = binding_for(stmt);
-    auto it = sym ? facts.var_mutability.find(sym) : facts.var_mutability.end();
+    auto it = sym ? facts->var_mutability.find(sym) : facts->var_mutability.end();
     VarMutability kind = stmt->is_mutable ? VarMutability::Mutable : VarMutability::Constexpr;
-    if (it != facts.var_mutability.end()) {
+    if (it != facts->var_mutability.end()) {
         kind = it->second;
     }
     switch (kind) {
@@ -1784,8 +2195,8 @@ std::vector<std::string> CodeGenerator::ref_variant_keys_for(StmtPtr stmt) const
     }
     Symbol* sym = binding_for(stmt);
     if (sym) {
-        auto it = facts.ref_variants.find(sym);
-        if (it != facts.ref_variants.end()) {
+        auto it = facts->ref_variants.find(sym);
+        if (it != facts->ref_variants.end()) {
             keys.assign(it->second.begin(), it->second.end());
         }
     }
@@ -1806,8 +2217,8 @@ std::string CodeGenerator::ref_variant_name(const std::string& func_name, const
 std::vector<char> CodeGenerator::reentrancy_keys_for(const Symbol* func_sym) const {
     std::vector<char> keys;
     if (func_sym) {
-        auto it = facts.reentrancy_variants.find(func_sym);
-        if (it != facts.reentrancy_variants.end()) {
+        auto it = facts->reentrancy_variants.find(func_sym);
+        if (it != facts->reentrancy_variants.end()) {
             keys.assign(it->second.begin(), it->second.end());
         }
     }
@@ -1815,12 +2226,15 @@ std::vector<char> CodeGenerator::reentrancy_keys_for(const Symbol* func_sym) con
         keys.push_back('N');
     }
     std::sort(keys.begin(), keys.end());
+    if (keys.size() > 1 && cold_nonreentrant_functions.count(func_sym)) {
+        keys = {'R'};
+    }
     return keys;
 }
 
 std::string CodeGenerator::reentrancy_variant_name(const std::string& func_name, const Symbol* func_sym, char reent_key) const {
-    auto it = func_sym ? facts.reentrancy_variants.find(func_sym) : facts.reentrancy_variants.end();
-    if (it == facts.reentrancy_variants.end() || it->second.size() <= 1) {
+    auto it = func_sym ? facts->reentrancy_variants.find(func_sym) : facts->reentrancy_variants.end();
+    if (it == facts->reentrancy_variants.end() || it->second.size() <= 1) {
         return func_name;
     }
     if (reent_key == 'R') {
@@ -1854,12 +2268,12 @@ bool CodeGenerator::is_void_call(ExprPtr expr, std::string* name_out) const {
 
 bool CodeGenerator::lookup_constexpr_value(ExprPtr expr, CTValue& out) const {
     if (!expr || !optimization) return false;
-    auto it = optimization->constexpr_values.find(
+    const CTValue* value = optimization->constexpr_value(
         expr_fact_key(fact_instance_id_for_expr(expr), expr.get()));
-    if (it == optimization->constexpr_values.end()) {
+    if (!value) {
         return false;
     }
-    out = it->second;
+    out = *value;
     return true;
 }
 
@@ -1907,18 +2321,13 @@ bool CodeGenerator::can_emit_static_initializer_expr(ExprPtr expr) const {
 
 bool CodeGenerator::constexpr_condition(ExprPtr expr, bool& out) const {
     if (!expr || !optimization) return false;
-    auto cond_it = optimization->constexpr_conditions.find(
+    auto cond = optimization->constexpr_condition(
         expr_fact_key(fact_instance_id_for_expr(expr), expr.get()));
-    if (cond_it != optimization->constexpr_conditions.end()) {
-        out = cond_it->second;
-        return true;
-    }
-
-    CTValue value;
-    if (!lookup_constexpr_value(expr, value)) {
+    if (!cond.has_value()) {
         return false;
     }
-    return cte_scalar_to_bool(value, out);
+    out = cond.value();
+    return true;
 }
 
 int CodeGenerator::fact_instance_id_for_expr(ExprPtr expr) const {
@@ -1991,10 +2400,7 @@ bool CodeGenerator::is_pointer_like(TypePtr type) const {
 
 TypePtr CodeGenerator::resolve_type(TypePtr type) const {
     if (!type) return nullptr;
-    if (analyzed_program && analyzed_program->resolve_type) {
-        return analyzed_program->resolve_type(type);
-    }
-    return type;
+    return analyzed_program ? analyzed_program->resolved_type(type) : type;
 }
 
 TypePtr CodeGenerator::resolve_ref_param_type_or_fail(StmtPtr stmt, size_t index) const {
@@ -2014,8 +2420,7 @@ TypePtr CodeGenerator::resolve_ref_param_type_or_fail(StmtPtr stmt, size_t index
 }
 
 Symbol* CodeGenerator::binding_for(const void* node) const {
-    if (!analyzed_program || !analyzed_program->binding_for) return nullptr;
-    return analyzed_program->binding_for(current_instance_id, node);
+    return analyzed_program ? analyzed_program->bound_symbol(current_instance_id, node) : nullptr;
 }
 
 std::string CodeGenerator::instance_suffix(const Symbol* sym) const {
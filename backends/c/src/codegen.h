@@ -3,6 +3,7 @@
 #include "ast.h"
 #include "analysis.h"
 #include <sstream>
+#include <string_view>
 #include <unordered_set>
 #include <unordered_map>
 #include <set>
@@ -13,17 +14,49 @@
 
 namespace vexel::c_backend_codegen {
 
+struct ExecutionProfile;
+
 struct CCodegenResult {
     std::string header;
+    // Without a body sink, the whole source. With one, only the prelude
+    // (frame overlay, wide-integer runtime, comparators, rodata) that must
+    // precede the body already written to the sink.
     std::string source;
+    // With CodegenABI::hidden_internal_linkage, the frame overlay layout and
+    // static helpers (wide-integer runtime, comparators) every translation
+    // unit needs; `source` then starts at the rodata definition.
+    std::string shared_helpers;
 };
 
+// Body of a C string literal for `input` (without the quotes). Non-printable
+// bytes use three-digit octal escapes, so a following digit can never be read
+// as part of the escape.
+std::string escape_c_string(std::string_view input);
+
+// C spelling of a floating-point constant that reads back as exactly `value`
+// (shortest of 15-17 significant digits); INFINITY/NAN come from <math.h>.
+std::string format_c_double(double value);
+
+// Brace-enclosed initializer for a packed compile-time table (see
+// cte_packed_table), written directly from its lanes.
+std::string packed_table_initializer(const CTArray& table);
+
 struct GeneratedFunctionInfo {
     StmtPtr declaration;
     std::string qualified_name;  // e.g., Vec::push
     std::string c_name;          // mangled C symbol
     std::string storage;         // "" or "static "
-    std::string code;            // complete function definition text
+    std::string code;            // complete function definition text (empty when streamed to a body sink)
+    std::vector<std::string> callees;  // C names of internal functions called (hidden_internal_linkage or FrameAllocation::Overlay)
+    size_t profile_counters = 0;  // length of vx_prof_<c_name> (profile_generate only)
+    // One of several internal variants of its declaration with the native
+    // call ABI, so a byte-identical sibling can stand in for it.
+    bool aliasable_variant = false;
+    // FrameAllocation::Overlay: members of the frame-ABI variant's static
+    // frame (return slot and function-scope temporaries), empty otherwise.
+    std::vector<std::string> frame_fields;
+    // Calls an external or indirect function, which may re-enter the program.
+    bool calls_external = false;
 };
 
 struct GeneratedVarInfo {
@@ -46,7 +79,13 @@ struct CallTargetInfo {
 
 struct CodegenABI {
     bool lower_aggregates = false;
+    // Keep global and function code in the generated infos even when the
+    // body streams to a sink, and leave globals out of the body.
     bool multi_file_globals = false;
+    // Give non-exported functions, globals, frame slots and the rodata blob
+    // hidden external linkage (VX_INTERNAL) instead of static, and declare
+    // them in the header, so several translation units can share them.
+    bool hidden_internal_linkage = false;
     std::string return_prefix;
     std::function<PtrKind(const ExprPtr&)> expr_ptr_kind;
     std::function<PtrKind(const std::string& name, int scope_id)> symbol_ptr_kind;
@@ -63,6 +102,32 @@ struct CodegenABI {
                                  const std::string& ref_key)> resolve_call;
 };
 
+// How integer widths other than 8/16/32/64 bits are represented in C.
+enum class ExtIntLowering {
+    Bytes,   // byte-array structs operated on by the vx_ai_* runtime (portable C11)
+    Int128,  // 128-bit widths as (unsigned) __int128; other widths as Bytes
+    BitInt,  // every width as C23 (unsigned) _BitInt(N); signed 1-bit stays Bytes
+};
+
+// Loop shape and hints for `@` iteration.
+enum class LoopVectorization {
+    Off,      // ranges materialize their index array; no hints
+    Ivdep,    // ranges become counted loops; elementwise bodies get `#pragma GCC ivdep`
+    OmpSimd,  // as Ivdep, with `#pragma omp simd` and reduction clauses instead
+};
+
+// Field order of emitted structs.
+enum class FieldOrder {
+    Declared,   // declaration order for every type
+    Alignment,  // types off the ABI boundary sorted by descending alignment
+};
+
+// Storage of non-reentrant frame-ABI variants' return slots and temporaries.
+enum class FrameAllocation {
+    Separate,  // function-scope statics per variant
+    Overlay,   // per-variant frame structs; variants never live at once share storage
+};
+
 // CodeGenerator translates the type-checked AST into C code.
 // Generates both header (.h) and source (.c) files with:
 // - Type declarations and forward declarations
@@ -72,23 +137,74 @@ struct CodegenABI {
 class CodeGenerator {
     std::ostringstream header;
     std::ostringstream body;
+    // When set, generate() moves each finished top-level declaration from
+    // `body` to this stream, and generated function/variable infos keep no
+    // code text. generate_single_function() ignores it.
+    std::ostream* body_sink = nullptr;
+    bool streaming_body = false;
     std::vector<GeneratedFunctionInfo> generated_functions;
     std::vector<GeneratedVarInfo> generated_vars;
     int temp_counter;
     std::stack<std::string> available_temps;
     std::unordered_set<std::string> live_temps;
     std::unordered_set<std::string> declared_temps;
+    // FrameAllocation::Overlay, in a frame-ABI variant: its frame object and
+    // the members (return slot and temporaries) declared so far.
+    std::string current_frame_object;
+    std::vector<std::string> current_frame_fields;
     std::unordered_map<std::string, std::string> type_map;
     const AnalyzedProgram* analyzed_program = nullptr;
     std::stack<std::ostringstream*> output_stack;
     std::unordered_map<std::string, std::string> comparator_cache;
     std::vector<std::string> comparator_definitions;
+    // Large string literals are pooled into one `vx_rodata` array in the
+    // source file and referenced by offset, so repeated payloads (embedded
+    // resources) are escaped and stored once.
+    bool pool_rodata_literals = false;
+    std::unordered_map<std::string, size_t> rodata_offsets;
+    std::string rodata_blob;
+    size_t rodata_size = 0;
     std::set<std::pair<bool, uint64_t>> extint_types_used;
     bool extint_runtime_needed = false;
     std::string extint_runtime_source;
     std::string extint_header_defs;
+    // A bundled std::print buffered-output extern is live, so the source
+    // carries the vx_std_print_* runtime.
+    bool print_buffer_used = false;
+    ExtIntLowering extint_lowering = ExtIntLowering::Bytes;
+    LoopVectorization loop_vectorization = LoopVectorization::Off;
+    FieldOrder field_order = FieldOrder::Declared;
+    FrameAllocation frame_allocation = FrameAllocation::Separate;
+    // profile_generate: runtime path of the profile file each run appends to
+    // (empty = no instrumentation). profile_use: counts of an earlier run.
+    std::string profile_output;
+    const ExecutionProfile* execution_profile = nullptr;
+    // C name and conditional count of the function being instrumented or
+    // annotated (empty outside function bodies).
+    std::string current_profile_function;
+    size_t current_profile_sites = 0;
+    // Functions whose non-reentrant variants never ran under the profile;
+    // their callers use the reentrant variant instead.
+    std::unordered_set<const Symbol*> cold_nonreentrant_functions;
+    // Types whose memory layout is observable (exported/external signatures
+    // and globals, composite casts, and types nested in those); they keep
+    // declaration order under FieldOrder::Alignment.
+    std::unordered_set<std::string> declared_layout_types;
+    // Header externs for frame slots under hidden_internal_linkage.
+    std::string promoted_slot_decls;
+    // Definitions of aliasable variants by declaration, keyed by their code
+    // with the variant's own name and traits comment normalized away, and the
+    // C name of the variant that was emitted with that code.
+    std::unordered_map<const Stmt*, std::unordered_map<std::string, std::string>> variant_definitions;
+    // `#define alias canonical` pairs for variants that were not emitted.
+    std::vector<std::pair<std::string, std::string>> variant_aliases;
+    // Internal functions called by the function being generated.
+    std::set<std::string> current_callees;
+    bool current_calls_external = false;
+    // Widths lowered to __int128 / _BitInt whose typedefs were emitted.
+    std::set<std::pair<bool, uint64_t>> wide_native_types_used;
     bool in_function = false;
-    AnalysisFacts facts;
+    const AnalysisFacts* facts = nullptr;
     const OptimizationFacts* optimization = nullptr;
     char current_reentrancy_key = 'N';
     CodegenABI abi;
@@ -100,6 +216,25 @@ class CodeGenerator {
     int current_instance_id = -1;
     int entry_instance_id = 0;
     const Symbol* current_func_symbol = nullptr;
+    // Parallel function emission (codegen_parallel.cpp). Worker generators
+    // run with deferred_shared_state set: first uses of prelude entries whose
+    // names depend on creation order are logged instead of created, and the
+    // main generator replays each function's log in source order.
+    struct SharedStateEvent {
+        enum class Kind { ExtInt, WideNative, Comparator, Rodata };
+        Kind kind = Kind::ExtInt;
+        int instance_id = -1;
+        bool is_signed = false;
+        uint64_t bits = 0;
+        TypePtr type;      // Comparator
+        bool equality = false;  // Comparator: ensure_equality rather than ensure_comparator
+        std::string text;  // Rodata payload
+    };
+    struct ParallelFunctionTask;
+    struct ParallelFunctionChunk;
+    unsigned parallel_workers = 1;
+    bool deferred_shared_state = false;
+    std::vector<SharedStateEvent> shared_state_events;  // placeholder i names event i
 
 public:
     CodeGenerator();
@@ -114,7 +249,20 @@ public:
                                                    const std::string& variant_name_override,
                                                    const std::string& variant_id_override);
     void set_abi(const CodegenABI& options) { abi = options; }
-    const std::unordered_set<const Symbol*>& reachable() const { return facts.reachable_functions; }
+    void set_extint_lowering(ExtIntLowering mode) { extint_lowering = mode; }
+    void set_loop_vectorization(LoopVectorization mode) { loop_vectorization = mode; }
+    void set_field_order(FieldOrder order) { field_order = order; }
+    void set_frame_allocation(FrameAllocation mode) { frame_allocation = mode; }
+    // Instrument function variants and runtime conditionals with counters that
+    // are appended to `output_path` (or $VEXEL_PROFILE_FILE) at exit.
+    void set_profile_generate(const std::string& output_path) { profile_output = output_path; }
+    // Hot/cold attributes, branch hints and non-reentrant variant pruning from
+    // `profile` (not owned).
+    void set_execution_profile(const ExecutionProfile* profile) { execution_profile = profile; }
+    void set_body_sink(std::ostream* sink) { body_sink = sink; }
+    // More than one worker makes generate() emit function variants concurrently.
+    void set_parallel_workers(unsigned workers) { parallel_workers = workers == 0 ? 1 : workers; }
+    const SymbolSet& reachable() const { return facts->reachable_functions; }
     const std::vector<GeneratedFunctionInfo>& functions() const { return generated_functions; }
     const std::vector<GeneratedVarInfo>& variables() const { return generated_vars; }
     std::string type_to_c(TypePtr type) { return gen_type(type); }
@@ -135,7 +283,33 @@ private:
     std::string aggregate_out_type;
     std::unordered_set<std::string> current_aggregate_params;
 
+    // Qualifiers and attributes one function variant's C signature carries,
+    // derived from analysis facts. Prototype and definition both use them.
+    struct SignatureQualifiers {
+        std::string attributes;                // attribute macros, each followed by a space
+        std::vector<bool> const_pointee;       // per receiver/parameter, in C order
+        std::vector<bool> restrict_pointer;
+    };
+    SignatureQualifiers signature_qualifiers(StmtPtr stmt,
+                                             const Symbol* sym,
+                                             const std::string& ref_key,
+                                             char reent_key,
+                                             bool frame_abi,
+                                             bool returns_value,
+                                             bool returns_aggregate);
+    static std::string qualified_param_type(const std::string& type, const SignatureQualifiers& quals, size_t index);
+    bool receiver_is_read_only(const Symbol* func_sym, size_t index) const;
+    void collect_declared_layout_roots(const StmtPtr& stmt,
+                                       std::vector<TypePtr>& roots,
+                                       std::unordered_map<std::string, StmtPtr>& type_decls);
+    void pin_declared_layout(TypePtr type, const std::unordered_map<std::string, StmtPtr>& type_decls);
+    size_t field_alignment(TypePtr type);
+
     void gen_module(const Module& mod);
+    void gen_top_level_parallel(const std::vector<std::pair<int, StmtPtr>>& items);
+    void run_parallel_chunk(std::vector<ParallelFunctionTask>& tasks, ParallelFunctionChunk& chunk) const;
+    std::string defer_shared_state(SharedStateEvent event);
+    static std::string shared_state_placeholder(size_t index);
     void gen_stmt(StmtPtr stmt);
     void gen_func_decl(StmtPtr stmt, const std::string& ref_key, char reent_key);
     void gen_type_decl(StmtPtr stmt);
@@ -159,6 +333,9 @@ private:
     std::string gen_range(ExprPtr expr);
     std::string gen_length(ExprPtr expr);
     std::string gen_iteration(ExprPtr expr);
+    bool vectorizable_loop_body(ExprPtr body,
+                                bool indexed_by_range,
+                                std::vector<std::pair<std::string, std::string>>& reductions);
     std::string gen_repeat(ExprPtr expr);
 
     std::string mutability_prefix(StmtPtr stmt) const;
@@ -166,6 +343,10 @@ private:
     std::vector<std::string> ref_variant_keys_for(StmtPtr stmt) const;
     std::string ref_variant_name(const std::string& func_name, const std::string& ref_key) const;
     std::vector<char> reentrancy_keys_for(const Symbol* func_sym) const;
+    void collect_cold_nonreentrant_functions();
+    std::string profile_attributes(const std::string& c_name) const;
+    std::string profiled_condition(const std::string& cond);
+    void emit_profile_runtime();
     std::string reentrancy_variant_name(const std::string& func_name, const Symbol* func_sym, char reent_key) const;
     std::string variant_name(const std::string& func_name, const Symbol* func_sym, char reent_key, const std::string& ref_key) const;
     bool receiver_is_mutable_arg(ExprPtr expr) const;
@@ -190,6 +371,11 @@ private:
     bool is_extended_integer_type(TypePtr type) const;
     bool is_native_integer_type(TypePtr type) const;
     bool is_extended_integer_expr(ExprPtr expr) const;
+    bool lowers_to_wide_native(bool is_signed, uint64_t bits) const;
+    bool is_wide_native_integer_type(TypePtr type, bool& is_signed, uint64_t& bits) const;
+    bool is_wide_native_integer_type(TypePtr type) const;
+    std::string wide_native_type_name(bool is_signed, uint64_t bits);
+    std::string wide_native_literal(bool is_signed, uint64_t bits, const APInt& value);
     std::string extint_type_name(bool is_signed, uint64_t bits) const;
     void ensure_extint_type(TypePtr type, const SourceLocation& loc, const std::string& context);
     void ensure_extint_type(bool is_signed, uint64_t bits);
@@ -211,14 +397,20 @@ private:
                                           TypePtr fixed_type,
                                           const std::string& left,
                                           const std::string& right,
-                                          const std::string& op);
+                                          BinaryOp op);
+    // Native lowering of the same operation through the wide native type;
+    // empty when the lowering mode has none or an operand would not fit.
+    std::string gen_fixed_native64_muldiv_wide(TypePtr fixed_type,
+                                               const std::string& left,
+                                               const std::string& right,
+                                               BinaryOp op);
     std::string gen_extint_unary(ExprPtr expr, const std::string& operand);
     std::string gen_extint_cast(ExprPtr expr, const std::string& operand);
     std::string gen_extint_assignment(ExprPtr expr,
                                       TypePtr lhs_type,
                                       const std::string& lhs,
                                       const std::string& rhs,
-                                      const std::string& assign_op);
+                                      AssignOp assign_op);
     std::string gen_extint_conditional(ExprPtr expr,
                                        const std::string& cond,
                                        const std::string& true_expr,
@@ -238,26 +430,51 @@ private:
     std::string mangle_name(const std::string& name);
     std::string fresh_temp();
     void release_temp(const std::string& temp);
+    // Declares temporary `name` (`type name dims`) once per function. In an
+    // overlaid frame it becomes a frame member and `name` is rebound to it.
+    void declare_temp(const std::string& type, std::string& name, const std::string& dims = "");
+    std::string unit_value(bool value_discarded);
 
     std::optional<std::pair<int64_t, int64_t>> evaluate_range(ExprPtr range_expr);
     std::string storage_prefix() const;
+    std::string internal_storage() const;
     bool use_nonreentrant_frame_abi(bool is_exported) const;
     std::string nonreentrant_arg_slot_name(const std::string& c_name, size_t index) const;
     std::string nonreentrant_ret_slot_name(const std::string& c_name) const;
+    // FrameAllocation::Overlay: the frame object of a frame-ABI variant.
+    std::string frame_object_name(const std::string& c_name) const;
     std::string external_link_name(const std::string& qualified_name, const std::string& fallback_c_name) const;
     bool is_std_math_macro_builtin_name(const std::string& runtime_name) const;
+    // `sym` is declared in the bundled std module `file` (e.g. "std/math.vx").
+    bool is_bundled_std_function(const Symbol* sym, StmtPtr decl, const std::string& file) const;
     bool is_bundled_std_math_function(const Symbol* sym, StmtPtr decl) const;
     bool is_std_bits_builtin_name(const std::string& runtime_name) const;
     bool is_bundled_std_bits_function(const Symbol* sym, StmtPtr decl) const;
+    bool is_std_print_builtin_name(const std::string& runtime_name) const;
+    bool is_bundled_std_print_function(const Symbol* sym, StmtPtr decl) const;
+    // Definitions of the buffered print runtime, or (split units) the
+    // declarations every unit needs.
+    std::string print_buffer_runtime(bool declarations_only) const;
     std::string gen_std_bits_builtin_call(const std::string& runtime_name,
                                           const std::string& arg_expr,
                                           TypePtr source_type,
                                           TypePtr result_type,
                                           const SourceLocation& loc);
     std::string ensure_comparator(TypePtr type);
+    // Zero-iff-equal helper for ==/!=: a memcmp over the object bytes when
+    // the type has no padding and no value with two representations
+    // (bitwise_size), otherwise the ordering comparator.
+    std::string ensure_equality(TypePtr type);
+    bool bitwise_size(TypePtr type, uint64_t& size);
+    std::string gen_string_literal(const std::string& value);
     int64_t resolve_array_length(TypePtr type, const SourceLocation& loc);
     void emit_return_stmt(const std::string& expr);
     void append_return_prefix(std::ostringstream& out) const;
+    void flush_body_to_sink();
+    bool alias_identical_variant(const GeneratedFunctionInfo& info, const std::string& code);
+    // Frame structs and the overlay layout, private to the program; the
+    // storage definitions are appended to `definitions`.
+    std::string frame_overlay_declarations(std::string& definitions) const;
     void validate_codegen_invariants(const Module& mod);
     void validate_codegen_invariants(StmtPtr func);
     void validate_codegen_invariants_impl(const std::vector<StmtPtr>& stmts, bool use_facts, bool top_level);
@@ -1,10 +1,12 @@
 #include "codegen.h"
 #include "analysis.h"
+#include "ast_walk.h"
 #include "expr_access.h"
 #include "function_key.h"
 #include "optimizer.h"
 #include "typechecker.h"
 #include "constants.h"
+#include "cte_value_utils.h"
 
 #include <algorithm>
 #include <functional>
@@ -16,37 +18,8 @@
 
 namespace {
 
-std::string escape_c_string(const std::string& input) {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (unsigned char c : input) {
-        switch (c) {
-            case '\\':
-                oss << "\\\\";
-                break;
-            case '"':
-                oss << "\\\"";
-                break;
-            case '\n':
-                oss << "\\n";
-                break;
-            case '\r':
-                oss << "\\r";
-                break;
-            case '\t':
-                oss << "\\t";
-                break;
-            default:
-                if (c >= 0x20 && c <= 0x7e) {
-                    oss << static_cast<char>(c);
-                } else {
-                    oss << "\\x" << std::uppercase << std::setw(2) << static_cast<int>(c) << std::nouppercase;
-                }
-                break;
-        }
-    }
-    return oss.str();
-}
+// Sorted iteration over at most this many elements keeps the insertion sort.
+constexpr int64_t kInsertionSortMaxElements = 16;
 
 bool is_fixed_primitive_type_codegen(const vexel::TypePtr& type) {
     return type &&
@@ -124,14 +97,15 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
                                           const std::string& raw_c_type,
                                           const std::string& lhs,
                                           const std::string& rhs,
-                                          const std::string& op,
+                                          vexel::BinaryOp op,
+                                          const std::string& spelling,
                                           const vexel::SourceLocation& loc) {
     uint64_t bits = 0;
     bool signed_raw = false;
     int64_t frac = 0;
     if (!fixed_muldiv_meta_supported_codegen(fixed_type, bits, signed_raw, frac)) {
         throw vexel::CompileError(
-            "Fixed-point operator '" + op +
+            "Fixed-point operator '" + spelling +
                 "' currently supports only native storage widths up to 32 bits (8/16/32)",
             loc);
     }
@@ -139,7 +113,7 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
     if (signed_raw) {
         std::string l = "((int64_t)((" + raw_c_type + ")" + lhs + "))";
         std::string r = "((int64_t)((" + raw_c_type + ")" + rhs + "))";
-        if (op == "*") {
+        if (op == vexel::BinaryOp::Mul) {
             std::string prod = "((" + l + ") * (" + r + "))";
             if (frac >= 0) {
                 return "((" + raw_c_type + ")(" +
@@ -150,7 +124,7 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
             return "((" + raw_c_type + ")(" +
                    mul_pow2_u64_expr_codegen("(uint64_t)(" + prod + ")", k) + "))";
         }
-        if (op == "/") {
+        if (op == vexel::BinaryOp::Div) {
             if (frac >= 0) {
                 std::string num = "((" + l + ") * " + pow2_i64_literal_codegen(static_cast<uint64_t>(frac)) + ")";
                 return "((" + raw_c_type + ")((" + num + ") / (" + r + ")))";
@@ -163,7 +137,7 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
             std::string den = "((" + r + ") * " + pow2_i64_literal_codegen(k) + ")";
             return "((" + raw_c_type + ")((" + l + ") / (" + den + ")))";
         }
-        if (op == "%") {
+        if (op == vexel::BinaryOp::Mod) {
             std::string q = "((" + raw_c_type + ")((" + l + ") / (" + r + ")))";
             std::string prod_back = "((" + raw_c_type + ")((" + q + ") * ((" + raw_c_type + ")" + rhs + ")))";
             return "((" + raw_c_type + ")((" + raw_c_type + ")" + lhs + " - " + prod_back + "))";
@@ -171,7 +145,7 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
     } else {
         std::string l = "((uint64_t)((" + raw_c_type + ")" + lhs + "))";
         std::string r = "((uint64_t)((" + raw_c_type + ")" + rhs + "))";
-        if (op == "*") {
+        if (op == vexel::BinaryOp::Mul) {
             std::string prod = "((uint64_t)((" + l + ") * (" + r + ")))";
             if (frac >= 0) {
                 return "((" + raw_c_type + ")(" +
@@ -181,7 +155,7 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
             if (k >= bits) return "((" + raw_c_type + ")0)";
             return "((" + raw_c_type + ")(" + mul_pow2_u64_expr_codegen(prod, k) + "))";
         }
-        if (op == "/") {
+        if (op == vexel::BinaryOp::Div) {
             if (frac >= 0) {
                 std::string num = "((uint64_t)((" + l + ") * " + pow2_u64_literal_codegen(static_cast<uint64_t>(frac)) + "))";
                 return "((" + raw_c_type + ")((" + num + ") / (" + r + ")))";
@@ -194,14 +168,77 @@ std::string fixed_muldiv_raw_expr_codegen(const vexel::TypePtr& fixed_type,
             std::string den = "((uint64_t)((" + r + ") * " + pow2_u64_literal_codegen(k) + "))";
             return "((" + raw_c_type + ")((" + l + ") / (" + den + ")))";
         }
-        if (op == "%") {
+        if (op == vexel::BinaryOp::Mod) {
             std::string q = "((" + raw_c_type + ")((" + l + ") / (" + r + ")))";
             std::string prod_back = "((" + raw_c_type + ")((" + q + ") * ((" + raw_c_type + ")" + rhs + ")))";
             return "((" + raw_c_type + ")((" + raw_c_type + ")" + lhs + " - " + prod_back + "))";
         }
     }
 
-    throw vexel::CompileError("Unsupported fixed-point operator in C codegen: " + op, loc);
+    throw vexel::CompileError("Unsupported fixed-point operator in C codegen: " + spelling, loc);
+}
+
+bool is_temp_name(const std::string& code) {
+    return code.size() > 3 && code.compare(0, 3, "tmp") == 0 &&
+           std::all_of(code.begin() + 3, code.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// A generated value with no effect as a statement: a name or a numeric
+// literal, optionally parenthesized or cast to a named type.
+bool is_inert_c_value(std::string code) {
+    auto is_word = [](const std::string& text) {
+        return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+        });
+    };
+    for (;;) {
+        if (code.size() >= 2 && code.front() == '(' && code.back() == ')' &&
+            code.find('(', 1) == std::string::npos) {
+            code = code.substr(1, code.size() - 2);
+            continue;
+        }
+        const size_t close = code.find(')');
+        if (!code.empty() && code.front() == '(' && close != std::string::npos &&
+            is_word(code.substr(1, close - 1))) {
+            code = code.substr(close + 1);
+            continue;
+        }
+        break;
+    }
+    if (!code.empty() && code.front() == '-') code = code.substr(1);
+    return is_word(code);
+}
+
+// What evaluating an expression may change. Locals change only through
+// assignments and receivers; any call may write globals.
+enum class OperandEffect { None, Globals, Locals };
+
+OperandEffect operand_effect(const vexel::ExprPtr& expr) {
+    OperandEffect effect = OperandEffect::None;
+    std::function<void(const vexel::ExprPtr&)> visit_expr;
+    std::function<void(const vexel::StmtPtr&)> visit_stmt;
+    visit_expr = [&](const vexel::ExprPtr& e) {
+        if (!e || effect == OperandEffect::Locals) return;
+        // Expression-parameter references stand for argument expressions not visible here.
+        if (e->kind == vexel::Expr::Kind::Assignment || e->kind == vexel::Expr::Kind::Process ||
+            e->is_expr_param_ref ||
+            (e->kind == vexel::Expr::Kind::Call && !e->receivers.empty())) {
+            effect = OperandEffect::Locals;
+            return;
+        }
+        if (e->kind == vexel::Expr::Kind::Call) effect = OperandEffect::Globals;
+        vexel::for_each_expr_child(e, visit_expr, visit_stmt);
+    };
+    visit_stmt = [&](const vexel::StmtPtr& st) {
+        if (!st || effect == OperandEffect::Locals) return;
+        if (st->kind == vexel::Stmt::Kind::VarDecl) {
+            effect = OperandEffect::Locals;
+            return;
+        }
+        vexel::for_each_stmt_child(st, visit_expr, visit_stmt);
+    };
+    visit_expr(expr);
+    return effect;
 }
 
 } // namespace
@@ -225,7 +262,10 @@ std::string CodeGenerator::gen_expr(ExprPtr expr) {
         expr->kind != Expr::Kind::Block;
     if (allow_constexpr_fold && fold_side_effect_free) {
         CTValue folded;
-        if (lookup_constexpr_value(expr, folded)) {
+        // Global tables are read in place, not copied into a temporary.
+        const bool global_table =
+            expr->kind == Expr::Kind::Identifier && expr->resolved_symbol && !expr->resolved_symbol->is_local;
+        if (lookup_constexpr_value(expr, folded) && !(global_table && cte_packed_table(folded))) {
             auto scalar_literal = [&](const CTValue& value) -> std::optional<std::string> {
                 return folded_scalar_expr_literal(value, expr ? expr->type : nullptr, expr ? expr->location : SourceLocation());
             };
@@ -243,9 +283,9 @@ std::string CodeGenerator::gen_expr(ExprPtr expr) {
                     std::string elem_type = gen_type(expr->type->element_type);
                     std::ostringstream init;
                     init << storage_prefix() << elem_type << " " << temp << "["
-                         << array_value->elements.size() << "] = {";
-                    for (size_t i = 0; i < array_value->elements.size(); ++i) {
-                        auto lit = folded_scalar_expr_literal(array_value->elements[i],
+                         << array_value->size() << "] = {";
+                    for (size_t i = 0; i < array_value->size(); ++i) {
+                        auto lit = folded_scalar_expr_literal(array_value->at(i),
                                                               expr->type->element_type,
                                                               expr->location);
                         if (!lit.has_value()) {
@@ -268,19 +308,20 @@ std::string CodeGenerator::gen_expr(ExprPtr expr) {
 
     switch (expr->kind) {
         case Expr::Kind::IntLiteral:
-            if (expr->has_exact_int_val && is_extended_integer_type(expr->type)) {
+            if (expr->has_exact_int_val &&
+                (is_extended_integer_type(expr->type) || is_wide_native_integer_type(expr->type))) {
                 return emit_extint_temp_literal(expr->type, expr->exact_int_val, expr->literal_is_unsigned, expr->location);
             }
             if (expr->has_exact_int_val) {
-                if (expr->exact_int_val.fits_i64()) return std::to_string(expr->exact_int_val.to_i64());
-                if (expr->exact_int_val.fits_u64()) return std::to_string(expr->exact_int_val.to_u64());
+                if (expr->exact_int_val->fits_i64()) return std::to_string(expr->exact_int_val->to_i64());
+                if (expr->exact_int_val->fits_u64()) return std::to_string(expr->exact_int_val->to_u64());
             }
             return std::to_string((int64_t)expr->uint_val);
         case Expr::Kind::FloatLiteral:
-            return std::to_string(expr->float_val);
+            return format_c_double(expr->float_val);
         case Expr::Kind::StringLiteral:
             {
-                std::string lit = "\"" + escape_c_string(expr->string_val) + "\"";
+                std::string lit = gen_string_literal(expr->string_val);
                 if (ptr_kind_for_expr(expr) == PtrKind::Far) {
                     std::string mod = current_module_id_expr.empty() ? "0" : current_module_id_expr;
                     return "VX_FARPTR(" + mod + ", " + lit + ")";
@@ -393,16 +434,13 @@ std::string CodeGenerator::gen_binary(ExprPtr expr) {
     bool right_extint = is_extended_integer_expr(expr->right);
 
     // Preserve runtime short-circuit semantics for logical operators.
-    if (expr->op == "&&" || expr->op == "||") {
+    if (expr->binary_op == BinaryOp::LogicalAnd || expr->binary_op == BinaryOp::LogicalOr) {
         std::string tmp = fresh_temp();
         std::string result_type = c_type_for_expr(expr);
-        if (!declared_temps.count(tmp)) {
-            emit(storage_prefix() + result_type + " " + tmp + ";");
-            declared_temps.insert(tmp);
-        }
+        declare_temp(result_type, tmp);
         emit(tmp + " = " + left + ";");
 
-        if (expr->op == "&&") {
+        if (expr->binary_op == BinaryOp::LogicalAnd) {
             emit("if (" + tmp + ") {");
         } else {
             emit("if (!" + tmp + ") {");
@@ -428,23 +466,21 @@ std::string CodeGenerator::gen_binary(ExprPtr expr) {
         return gen_extint_binary(expr, left, right);
     }
     if (expr && expr->type && is_fixed_primitive_type_codegen(expr->type) &&
-        (expr->op == "*" || expr->op == "/" || expr->op == "%")) {
+        (expr->binary_op == BinaryOp::Mul || expr->binary_op == BinaryOp::Div || expr->binary_op == BinaryOp::Mod)) {
         int64_t fixed_bits = type_bits(expr->type->primitive, expr->type->integer_bits, expr->type->fractional_bits);
         if (fixed_bits == 64) {
-            return gen_fixed_native64_muldiv(expr, expr->type, left, right, expr->op);
+            return gen_fixed_native64_muldiv(expr, expr->type, left, right, expr->binary_op);
         }
         std::string tmp = fresh_temp();
         std::string result_type = c_type_for_expr(expr);
-        if (!declared_temps.count(tmp)) {
-            emit(storage_prefix() + result_type + " " + tmp + ";");
-            declared_temps.insert(tmp);
-        }
+        declare_temp(result_type, tmp);
         emit(tmp + " = " +
-             fixed_muldiv_raw_expr_codegen(expr->type, gen_type(expr->type), left, right, expr->op, expr->location) +
+             fixed_muldiv_raw_expr_codegen(expr->type, gen_type(expr->type), left, right, expr->binary_op,
+                                           expr->op, expr->location) +
              ";");
         return tmp;
     }
-    if (expr->op == "==" || expr->op == "!=") {
+    if (expr->binary_op == BinaryOp::Eq || expr->binary_op == BinaryOp::Ne) {
         TypePtr cmp_type = expr->left ? expr->left->type : nullptr;
         if (!cmp_type && expr->left && expr->left->kind == Expr::Kind::Identifier) {
             Symbol* sym = binding_for(expr->left);
@@ -459,16 +495,13 @@ std::string CodeGenerator::gen_binary(ExprPtr expr) {
             (cmp_type->kind == Type::Kind::Array ||
              cmp_type->kind == Type::Kind::Named ||
              (cmp_type->kind == Type::Kind::Primitive && cmp_type->primitive == PrimitiveType::String))) {
-            std::string cmp_name = ensure_comparator(cmp_type);
+            std::string cmp_name = ensure_equality(cmp_type);
             if (!expr->type || expr->type->kind == Type::Kind::TypeVar) {
                 return "(" + cmp_name + "(" + left + ", " + right + ") " + expr->op + " 0)";
             }
             std::string tmp = fresh_temp();
             std::string result_type = c_type_for_expr(expr);
-            if (!declared_temps.count(tmp)) {
-                emit(storage_prefix() + result_type + " " + tmp + ";");
-                declared_temps.insert(tmp);
-            }
+            declare_temp(result_type, tmp);
             emit(tmp + " = (" + cmp_name + "(" + left + ", " + right + ") " + expr->op + " 0);");
             return tmp;
         }
@@ -478,14 +511,18 @@ std::string CodeGenerator::gen_binary(ExprPtr expr) {
     }
     std::string tmp = fresh_temp();
     std::string result_type = c_type_for_expr(expr);
-    if (!declared_temps.count(tmp)) {
-        emit(storage_prefix() + result_type + " " + tmp + ";");
-        declared_temps.insert(tmp);
-    }
+    declare_temp(result_type, tmp);
     uint64_t signed_bits = 0;
-    if ((expr->op == "+" || expr->op == "-" || expr->op == "*") &&
-        signed_native_int_type_codegen(expr->type, signed_bits)) {
-        std::string utype = unsigned_c_type_for_signed_bits_codegen(signed_bits);
+    bool wide_signed = false;
+    std::string utype;
+    if (expr->binary_op == BinaryOp::Add || expr->binary_op == BinaryOp::Sub || expr->binary_op == BinaryOp::Mul) {
+        if (signed_native_int_type_codegen(expr->type, signed_bits)) {
+            utype = unsigned_c_type_for_signed_bits_codegen(signed_bits);
+        } else if (is_wide_native_integer_type(expr->type, wide_signed, signed_bits) && wide_signed) {
+            utype = wide_native_type_name(false, signed_bits);
+        }
+    }
+    if (!utype.empty()) {
         emit(tmp + " = (" + result_type + ")((" + utype + ")(" + left + ") " + expr->op +
              " (" + utype + ")(" + right + "));");
         return tmp;
@@ -509,10 +546,7 @@ std::string CodeGenerator::gen_unary(ExprPtr expr) {
     }
     std::string tmp = fresh_temp();
     std::string result_type = c_type_for_expr(expr);
-    if (!declared_temps.count(tmp)) {
-        emit(storage_prefix() + result_type + " " + tmp + ";");
-        declared_temps.insert(tmp);
-    }
+    declare_temp(result_type, tmp);
     emit(tmp + " = (" + expr->op + operand + ");");
     return tmp;
 }
@@ -584,17 +618,11 @@ std::string CodeGenerator::gen_std_bits_builtin_call(const std::string& runtime_
         require_exact_primitive(dst, expected_dst, expected_dst_bits, "result");
 
         std::string src_tmp = fresh_temp();
-        if (!declared_temps.count(src_tmp)) {
-            emit(storage_prefix() + arg_type + " " + src_tmp + ";");
-            declared_temps.insert(src_tmp);
-        }
+        declare_temp(arg_type, src_tmp);
         emit(src_tmp + " = (" + arg_type + ")(" + arg_expr + ");");
 
         std::string dst_tmp = fresh_temp();
-        if (!declared_temps.count(dst_tmp)) {
-            emit(storage_prefix() + gen_type(dst) + " " + dst_tmp + ";");
-            declared_temps.insert(dst_tmp);
-        }
+        declare_temp(gen_type(dst), dst_tmp);
         emit("memcpy(&" + dst_tmp + ", &" + src_tmp + ", sizeof(" + dst_tmp + "));");
         return dst_tmp;
     }
@@ -727,12 +755,15 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
 
         if (callee_decl) {
             if (!is_external) {
-                auto reent_it = facts.reentrancy_variants.find(sym);
-                if (reent_it == facts.reentrancy_variants.end() || reent_it->second.empty()) {
+                auto reent_it = facts->reentrancy_variants.find(sym);
+                if (reent_it == facts->reentrancy_variants.end() || reent_it->second.empty()) {
                     throw CompileError("Internal error: missing reentrancy variants for callee '" +
                                            base_name + "'",
                                        expr->location);
                 }
+                if (call_reentrancy_key == 'N' && cold_nonreentrant_functions.count(sym)) {
+                    call_reentrancy_key = 'R';
+                }
                 if (!reent_it->second.count(call_reentrancy_key)) {
                     if (reent_it->second.size() == 1) {
                         call_reentrancy_key = *reent_it->second.begin();
@@ -762,6 +793,8 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
                 std::string alias_lookup_name = base_name;
                 if (sym && callee_decl && is_bundled_std_math_function(sym, callee_decl)) {
                     alias_lookup_name = "std::math::" + callee_decl->func_name;
+                } else if (sym && callee_decl && is_bundled_std_print_function(sym, callee_decl)) {
+                    alias_lookup_name = "std::print::" + callee_decl->func_name;
                 }
                 func_name = external_link_name(alias_lookup_name, mangle_name(base_name));
             }
@@ -785,6 +818,14 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
         }
     }
 
+    if (abi.hidden_internal_linkage || frame_allocation == FrameAllocation::Overlay) {
+        if (callee_decl && !is_external) {
+            current_callees.insert(func_name);
+        } else {
+            current_calls_external = true;
+        }
+    }
+
     bool returns_aggregate = false;
     bool returns_value = false;
     std::string agg_out_type;
@@ -839,6 +880,38 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
         }
     }
 
+    // Operands are staged in temps so they are evaluated left to right. A
+    // literal, a fresh temp, or a variable no later operand can change reads
+    // the same at the call and is passed as is.
+    std::vector<OperandEffect> later_effect(expr->receivers.size() + expr->args.size() + 1, OperandEffect::None);
+    for (size_t k = later_effect.size() - 1; k-- > 0;) {
+        const ExprPtr& operand = k < expr->receivers.size() ? expr->receivers[k]
+                                                            : expr->args[k - expr->receivers.size()];
+        later_effect[k] = std::max(later_effect[k + 1], operand_effect(operand));
+    }
+    auto needs_staging = [&](const ExprPtr& operand, const std::string& code, size_t position) {
+        switch (operand->kind) {
+            case Expr::Kind::IntLiteral:
+            case Expr::Kind::CharLiteral:
+            case Expr::Kind::StringLiteral:
+                // A float-typed literal keeps its temp: the temp rounds it to the type's precision.
+                return operand->type->kind == Type::Kind::Primitive && is_float(operand->type->primitive);
+            case Expr::Kind::Identifier: {
+                if (operand->is_expr_param_ref || abi.symbol_load_expr) return true;
+                const Symbol* var = binding_for(operand);
+                if (!var || var->is_backend_bound || var->is_external) return true;
+                // Receiver parameters are references to caller storage.
+                bool ref_param = current_ref_params.count(operand->name) > 0;
+                if (!var->is_mutable && !ref_param) return false;
+                bool caller_storage = ref_param || !var->is_local;
+                OperandEffect after = later_effect[position + 1];
+                return caller_storage ? after != OperandEffect::None : after == OperandEffect::Locals;
+            }
+            default:
+                return !is_temp_name(code);
+        }
+    };
+
     // Handle method calls with receivers - add them as first arguments
     if (!expr->receivers.empty()) {
         for (size_t i = 0; i < expr->receivers.size(); i++) {
@@ -867,6 +940,7 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
                     } else {
                         std::string ptr_temp = fresh_temp();
                         std::string rtype = gen_type(rec->type);
+                        if (!is_external && receiver_is_read_only(sym, i)) rtype = "const " + rtype;
                         emit(rtype + "* " + ptr_temp + " = &" + rec_expr + ";");
                         all_args.push_back(ptr_temp);
                     }
@@ -890,7 +964,7 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
                     VoidCallGuard guard(*this, false);
                     rec_expr = gen_expr(rec);
                 }
-                if (!rec || !rec->type || rec->type->kind == Type::Kind::TypeVar) {
+                if (!rec || !rec->type || rec->type->kind == Type::Kind::TypeVar || !needs_staging(rec, rec_expr, i)) {
                     all_args.push_back(rec_expr);
                 } else {
                     std::string staged = fresh_temp();
@@ -950,7 +1024,8 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
                 all_args.push_back("&" + temp);
             }
         } else {
-            if (!expr->args[i] || !expr->args[i]->type || expr->args[i]->type->kind == Type::Kind::TypeVar) {
+            if (!expr->args[i] || !expr->args[i]->type || expr->args[i]->type->kind == Type::Kind::TypeVar ||
+                !needs_staging(expr->args[i], arg_expr, expr->receivers.size() + i)) {
                 all_args.push_back(arg_expr);
             } else {
                 std::string temp = fresh_temp();
@@ -985,10 +1060,7 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
     std::string out_temp;
     if (returns_aggregate && !call_nonreentrant_frame) {
         out_temp = fresh_temp();
-        if (!declared_temps.count(out_temp)) {
-            emit(storage_prefix() + agg_out_type + " " + out_temp + ";");
-            declared_temps.insert(out_temp);
-        }
+        declare_temp(agg_out_type, out_temp);
         all_args.insert(all_args.begin(), "&" + out_temp);
     }
 
@@ -1005,10 +1077,7 @@ std::string CodeGenerator::gen_call(ExprPtr expr) {
         if (returns_aggregate || returns_value) {
             std::string ret_temp = fresh_temp();
             std::string ret_type = returns_aggregate ? agg_out_type : c_type_for_expr(expr);
-            if (!declared_temps.count(ret_temp)) {
-                emit(storage_prefix() + ret_type + " " + ret_temp + ";");
-                declared_temps.insert(ret_temp);
-            }
+            declare_temp(ret_type, ret_temp);
             emit(ret_temp + " = " + nonreentrant_ret_slot_name(func_name) + ";");
             return ret_temp;
         }
@@ -1045,10 +1114,7 @@ std::string CodeGenerator::gen_index(ExprPtr expr) {
         std::string ptr_expr = arr;
         if (expr_has_side_effects(expr->operand)) {
             std::string temp = fresh_temp();
-            if (!declared_temps.count(temp)) {
-                emit(storage_prefix() + std::string("uint32_t ") + temp + ";");
-                declared_temps.insert(temp);
-            }
+            declare_temp("uint32_t", temp);
             emit(temp + " = " + arr + ";");
             ptr_expr = temp;
         }
@@ -1154,7 +1220,8 @@ std::string CodeGenerator::gen_array_literal(ExprPtr expr) {
     if (storage_prefix().empty()) {
         emit(array_decl + " = " + gen_array_initializer(expr) + ";");
     } else {
-        emit(storage_prefix() + array_decl + ";");
+        const size_t name_at = array_decl.rfind(" " + temp);
+        declare_temp(array_decl.substr(0, name_at), temp, array_decl.substr(name_at + 1 + temp.size()));
         emit_array_literal_assignments(temp, expr, expr->type);
     }
 
@@ -1206,7 +1273,7 @@ std::string CodeGenerator::gen_block(ExprPtr expr) {
         }
         if (expr->result_expr) {
             std::string result = gen_expr(expr->result_expr);
-            if (!result.empty()) {
+            if (!result.empty() && !is_inert_c_value(result)) {
                 emit(result + ";");
             }
         }
@@ -1239,10 +1306,7 @@ std::string CodeGenerator::gen_block(ExprPtr expr) {
     }
 
     // Declare temp variable outside block scope only if not already declared
-    if (!declared_temps.count(temp)) {
-        emit(storage_prefix() + result_type + " " + temp + ";");
-        declared_temps.insert(temp);
-    }
+    declare_temp(result_type, temp);
 
     emit("{");
     for (const auto& stmt : expr->statements) {
@@ -1296,7 +1360,40 @@ std::string CodeGenerator::gen_conditional(ExprPtr expr) {
     std::string cond;
     {
         VoidCallGuard guard(*this, false);
-        cond = gen_expr(expr->condition);
+        cond = profiled_condition(gen_expr(expr->condition));
+    }
+    // A block arm in statement position emits its statements in place, so
+    // both arms go inside an if/else instead of running ahead of the test.
+    if (allow_void_call && ((expr->true_expr && expr->true_expr->kind == Expr::Kind::Block) ||
+                            (expr->false_expr && expr->false_expr->kind == Expr::Kind::Block))) {
+        // An arm's value is discarded; a bare literal or name (the `: 0` of
+        // `cond ? { ... } : 0`) is dropped rather than emitted as a statement
+        // with no effect, and an arm left empty loses its `else`.
+        auto gen_arm = [&](const ExprPtr& arm) {
+            std::ostringstream capture;
+            output_stack.push(&capture);
+            try {
+                const std::string code = gen_expr(arm);
+                if (!code.empty() && !is_inert_c_value(code)) emit(code + ";");
+            } catch (...) {
+                output_stack.pop();
+                throw;
+            }
+            output_stack.pop();
+            // A block arm that kept nothing leaves only its braces.
+            const std::string code = capture.str();
+            return code.find_first_not_of("{}\n") == std::string::npos ? std::string() : code;
+        };
+        const std::string true_code = gen_arm(expr->true_expr);
+        const std::string false_code = gen_arm(expr->false_expr);
+        emit("if (" + cond + ") {");
+        (*output_stack.top()) << true_code;
+        if (!false_code.empty()) {
+            emit("} else {");
+            (*output_stack.top()) << false_code;
+        }
+        emit("}");
+        return "";
     }
     std::string true_expr;
     std::string false_expr;
@@ -1340,19 +1437,13 @@ std::string CodeGenerator::gen_cast(ExprPtr expr) {
         }
         std::string source_tmp = fresh_temp();
         std::string source_type = gen_type(expr->operand->type);
-        if (!declared_temps.count(source_tmp)) {
-            emit(storage_prefix() + source_type + " " + source_tmp + ";");
-            declared_temps.insert(source_tmp);
-        }
+        declare_temp(source_type, source_tmp);
         emit(source_tmp + " = " + source_val + ";");
 
         std::string result = fresh_temp();
         std::string elem_type = gen_type(expr->target_type->element_type);
         std::string size_str = std::to_string(length);
-        if (!declared_temps.count(result)) {
-            emit(storage_prefix() + elem_type + " " + result + "[" + size_str + "];");
-            declared_temps.insert(result);
-        }
+        declare_temp(elem_type, result, "[" + size_str + "]");
         if (is_extended_integer_type(expr->operand->type)) {
             for (int64_t i = 0; i < length; ++i) {
                 emit(result + "[" + std::to_string(i) + "] = (" + elem_type + ")(" + source_tmp +
@@ -1386,10 +1477,7 @@ std::string CodeGenerator::gen_cast(ExprPtr expr) {
             source = gen_expr(expr->operand);
         }
         std::string temp = fresh_temp();
-        if (!declared_temps.count(temp)) {
-            emit(storage_prefix() + target + " " + temp + ";");
-            declared_temps.insert(temp);
-        }
+        declare_temp(target, temp);
         bool ext_signed = false;
         uint64_t ext_bits = 0;
         if (is_extended_integer_type(expr->target_type) &&
@@ -1418,6 +1506,20 @@ std::string CodeGenerator::gen_cast(ExprPtr expr) {
         return temp;
     }
 
+    if (expr && expr->target_type && expr->operand && expr->operand->type &&
+        (is_wide_native_integer_type(expr->target_type) || is_wide_native_integer_type(expr->operand->type))) {
+        auto is_fixed = [&](TypePtr type) {
+            TypePtr resolved = resolve_type(type);
+            return resolved && resolved->kind == Type::Kind::Primitive &&
+                   (is_signed_fixed(resolved->primitive) || is_unsigned_fixed(resolved->primitive));
+        };
+        if (is_fixed(expr->target_type) || is_fixed(expr->operand->type)) {
+            throw CompileError("Cast between fixed-point and natively lowered wide integer types is not supported "
+                               "by the C backend (use --backend-opt extint=bytes)",
+                               expr->location);
+        }
+    }
+
     if ((expr && expr->target_type && is_extended_integer_type(expr->target_type)) ||
         (expr && expr->operand && expr->operand->type && is_extended_integer_type(expr->operand->type))) {
         std::string operand;
@@ -1472,10 +1574,7 @@ std::string CodeGenerator::gen_cast(ExprPtr expr) {
     };
     auto declare_temp = [&](TypePtr type) {
         std::string name = fresh_temp();
-        if (!declared_temps.count(name)) {
-            emit(storage_prefix() + gen_type(type) + " " + name + ";");
-            declared_temps.insert(name);
-        }
+        this->declare_temp(gen_type(type), name);
         return name;
     };
     auto pow2_u64_literal = [&](uint64_t shift) {
@@ -1627,11 +1726,25 @@ std::string CodeGenerator::gen_cast(ExprPtr expr) {
     return "((" + target + ")" + operand + ")";
 }
 
+std::string CodeGenerator::unit_value(bool value_discarded) {
+    // Declarations and array copies evaluate to a dummy 0, which needs no temp when discarded.
+    if (value_discarded) return "";
+    std::string temp = fresh_temp();
+    if (!declared_temps.count(temp)) {
+        emit(storage_prefix() + std::string("int ") + temp + " = 0;");
+        declared_temps.insert(temp);
+    } else {
+        emit(temp + " = 0;");
+    }
+    return temp;
+}
+
 std::string CodeGenerator::gen_assignment(ExprPtr expr) {
-    const std::string assign_op = expr->op.empty() ? "=" : expr->op;
+    const AssignOp assign_op = expr->op.empty() ? AssignOp::Assign : expr->assign_op;
+    const bool value_discarded = allow_void_call;
     // Use the flag set by the typechecker to determine if this creates a new variable
     if (expr->creates_new_variable) {
-        if (assign_op != "=") {
+        if (assign_op != AssignOp::Assign) {
             throw CompileError("Internal error: compound assignment cannot declare a new variable", expr->location);
         }
         TypePtr var_type = expr->left->type ? expr->left->type : expr->type;
@@ -1653,20 +1766,18 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
 
         // For array declarations, we need to handle the literal specially
         if (var_type && var_type->kind == Type::Kind::Array && expr->right->kind == Expr::Kind::ArrayLiteral) {
+            std::string array_init;
+            {
+                VoidCallGuard guard(*this, false);
+                array_init = gen_array_initializer(expr->right);
+            }
             emit(gen_object_decl(var_type,
                                  var_name,
                                  expr->location,
                                  "array declaration '" + expr->left->name + "'") +
-                 " = " + gen_array_initializer(expr->right) + ";");
+                 " = " + array_init + ";");
 
-            std::string temp = fresh_temp();
-            if (!declared_temps.count(temp)) {
-                emit(storage_prefix() + std::string("int ") + temp + " = 0;");
-                declared_temps.insert(temp);
-            } else {
-                emit(temp + " = 0;");
-            }
-            return temp;
+            return unit_value(value_discarded);
         }
 
         if (var_type && var_type->kind == Type::Kind::Array) {
@@ -1682,14 +1793,7 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
             }
             emit("memcpy(" + var_name + ", " + rhs + ", sizeof(" + var_name + "));");
 
-            std::string temp = fresh_temp();
-            if (!declared_temps.count(temp)) {
-                emit(storage_prefix() + std::string("int ") + temp + " = 0;");
-                declared_temps.insert(temp);
-            } else {
-                emit(temp + " = 0;");
-            }
-            return temp;
+            return unit_value(value_discarded);
         }
 
         std::string rhs;
@@ -1702,15 +1806,8 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
             (!expr->right || !expr->right->type || expr->right->type->kind != Type::Kind::Array)) {
             release_temp(rhs);
         }
-        std::string temp = fresh_temp();
         emit(var_type_str + " " + var_name + " = " + rhs + ";");
-        if (!declared_temps.count(temp)) {
-            emit(storage_prefix() + std::string("int ") + temp + " = 0;"); // Assignment as expression returns dummy value
-            declared_temps.insert(temp);
-        } else {
-            emit(temp + " = 0;");
-        }
-        return temp;
+        return unit_value(value_discarded);
     }
 
     // Regular assignment
@@ -1732,7 +1829,7 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         }
     }
 
-    if (assign_op == "&&=" || assign_op == "||=") {
+    if (assign_op == AssignOp::LogicalAnd || assign_op == AssignOp::LogicalOr) {
         if (!lhs_type || lhs_type->kind != Type::Kind::Primitive ||
             lhs_type->primitive != PrimitiveType::Bool) {
             throw CompileError("Internal error: logical compound assignment requires boolean lhs", expr->location);
@@ -1767,14 +1864,14 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         }
 
         emit(std::string("if (*") + ptr_tmp + ") {");
-        if (assign_op == "&&=") {
+        if (assign_op == AssignOp::LogicalAnd) {
             append_captured(rhs_capture.str());
             emit(std::string("*") + ptr_tmp + " = " + rhs + ";");
         } else {
             emit(std::string("*") + ptr_tmp + " = 1;");
         }
         emit("} else {");
-        if (assign_op == "||=") {
+        if (assign_op == AssignOp::LogicalOr) {
             append_captured(rhs_capture.str());
             emit(std::string("*") + ptr_tmp + " = " + rhs + ";");
         } else {
@@ -1783,10 +1880,7 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         emit("}");
 
         std::string result_tmp = fresh_temp();
-        if (!declared_temps.count(result_tmp)) {
-            emit(storage_prefix() + lhs_type_str + " " + result_tmp + ";");
-            declared_temps.insert(result_tmp);
-        }
+        declare_temp(lhs_type_str, result_tmp);
         emit(result_tmp + " = *" + ptr_tmp + ";");
         return result_tmp;
     }
@@ -1804,7 +1898,7 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         return result;
     }
     if (lhs_type && is_fixed_primitive_type_codegen(lhs_type) &&
-        (assign_op == "*=" || assign_op == "/=" || assign_op == "%=")) {
+        (assign_op == AssignOp::Mul || assign_op == AssignOp::Div || assign_op == AssignOp::Mod)) {
         std::string lhs_type_str = gen_type(lhs_type);
         std::string ptr_tmp = fresh_temp();
         if (!declared_temps.count(ptr_tmp)) {
@@ -1816,21 +1910,19 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         std::string lhs_deref = std::string("*") + ptr_tmp;
         int64_t fixed_bits = type_bits(lhs_type->primitive, lhs_type->integer_bits, lhs_type->fractional_bits);
         if (fixed_bits == 64) {
-            std::string op = assign_op.substr(0, assign_op.size() - 1);
-            std::string value = gen_fixed_native64_muldiv(expr, lhs_type, lhs_deref, rhs, op);
+            std::string value =
+                gen_fixed_native64_muldiv(expr, lhs_type, lhs_deref, rhs, compound_binary_op(assign_op));
             emit(lhs_deref + " = " + value + ";");
         } else {
         emit(lhs_deref + " = " +
              fixed_muldiv_raw_expr_codegen(lhs_type, lhs_type_str, lhs_deref, rhs,
-                                           assign_op.substr(0, assign_op.size() - 1),
+                                           compound_binary_op(assign_op),
+                                           expr->op.substr(0, expr->op.size() - 1),
                                            expr->location) +
              ";");
         }
         std::string result_tmp = fresh_temp();
-        if (!declared_temps.count(result_tmp)) {
-            emit(storage_prefix() + lhs_type_str + " " + result_tmp + ";");
-            declared_temps.insert(result_tmp);
-        }
+        declare_temp(lhs_type_str, result_tmp);
         emit(result_tmp + " = " + lhs_deref + ";");
         if (rhs.rfind("tmp", 0) == 0 &&
             (!expr->right || !expr->right->type || expr->right->type->kind != Type::Kind::Array)) {
@@ -1839,10 +1931,17 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         return result_tmp;
     }
     uint64_t signed_bits = 0;
-    if ((assign_op == "+=" || assign_op == "-=" || assign_op == "*=") &&
-        signed_native_int_type_codegen(lhs_type, signed_bits)) {
+    bool wide_signed = false;
+    std::string utype;
+    if (assign_op == AssignOp::Add || assign_op == AssignOp::Sub || assign_op == AssignOp::Mul) {
+        if (signed_native_int_type_codegen(lhs_type, signed_bits)) {
+            utype = unsigned_c_type_for_signed_bits_codegen(signed_bits);
+        } else if (is_wide_native_integer_type(lhs_type, wide_signed, signed_bits) && wide_signed) {
+            utype = wide_native_type_name(false, signed_bits);
+        }
+    }
+    if (!utype.empty()) {
         std::string lhs_type_str = gen_type(lhs_type);
-        std::string utype = unsigned_c_type_for_signed_bits_codegen(signed_bits);
         std::string ptr_tmp = fresh_temp();
         if (!declared_temps.count(ptr_tmp)) {
             emit(storage_prefix() + lhs_type_str + "* " + ptr_tmp + " = &(" + lhs + ");");
@@ -1852,24 +1951,15 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
         }
         std::string lhs_u = fresh_temp();
         std::string rhs_u = fresh_temp();
-        if (!declared_temps.count(lhs_u)) {
-            emit(storage_prefix() + utype + " " + lhs_u + ";");
-            declared_temps.insert(lhs_u);
-        }
-        if (!declared_temps.count(rhs_u)) {
-            emit(storage_prefix() + utype + " " + rhs_u + ";");
-            declared_temps.insert(rhs_u);
-        }
+        declare_temp(utype, lhs_u);
+        declare_temp(utype, rhs_u);
         emit(lhs_u + " = (" + utype + ")(*" + ptr_tmp + ");");
         emit(rhs_u + " = (" + utype + ")(" + rhs + ");");
-        std::string op = assign_op.substr(0, assign_op.size() - 1);
+        std::string op = expr->op.substr(0, expr->op.size() - 1);
         emit(lhs_u + " = (" + lhs_u + " " + op + " " + rhs_u + ");");
         emit("*" + ptr_tmp + " = (" + lhs_type_str + ")" + lhs_u + ";");
         std::string result_tmp = fresh_temp();
-        if (!declared_temps.count(result_tmp)) {
-            emit(storage_prefix() + lhs_type_str + " " + result_tmp + ";");
-            declared_temps.insert(result_tmp);
-        }
+        declare_temp(lhs_type_str, result_tmp);
         emit(result_tmp + " = *" + ptr_tmp + ";");
         if (rhs.rfind("tmp", 0) == 0 &&
             (!expr->right || !expr->right->type || expr->right->type->kind != Type::Kind::Array)) {
@@ -1885,17 +1975,10 @@ std::string CodeGenerator::gen_assignment(ExprPtr expr) {
 
     if (lhs_type && lhs_type->kind == Type::Kind::Array) {
         emit("memmove(" + lhs + ", " + rhs + ", sizeof(" + lhs + "));");
-        std::string temp = fresh_temp();
-        if (!declared_temps.count(temp)) {
-            emit(storage_prefix() + std::string("int ") + temp + " = 0;");
-            declared_temps.insert(temp);
-        } else {
-            emit(temp + " = 0;");
-        }
-        return temp;
+        return unit_value(value_discarded);
     }
 
-    return "(" + lhs + " " + assign_op + " " + rhs + ")";
+    return "(" + lhs + " " + (expr->op.empty() ? "=" : expr->op) + " " + rhs + ")";
 }
 
 std::optional<std::pair<int64_t, int64_t>> CodeGenerator::evaluate_range(ExprPtr range_expr) {
@@ -1998,6 +2081,12 @@ std::string CodeGenerator::gen_length(ExprPtr expr) {
             if (expr->operand->kind == Expr::Kind::StringLiteral) {
                 return std::to_string(expr->operand->string_val.size());
             }
+            // Operands the evaluator already knows (named constants, folded
+            // concatenations) carry their length; only runtime strings pay strlen.
+            CTValue known;
+            if (lookup_constexpr_value(expr->operand, known) && std::holds_alternative<CTString>(known)) {
+                return std::to_string(std::get<CTString>(known).str().size());
+            }
             std::string operand;
             {
                 VoidCallGuard guard(*this, false);
@@ -2027,10 +2116,7 @@ std::string CodeGenerator::gen_length(ExprPtr expr) {
             if (!is_signed) return operand;
             std::string temp = fresh_temp();
             std::string t = gen_type(expr->operand->type);
-            if (!declared_temps.count(temp)) {
-                emit(storage_prefix() + t + " " + temp + ";");
-                declared_temps.insert(temp);
-            }
+            declare_temp(t, temp);
             emit(temp + " = " + operand + ";");
             emit("if (vx_ai_signbit(" + temp + ".b, sizeof(" + temp + ".b), " + std::to_string(extint_sign_mask(bits)) + ")) {");
             emit("  vx_ai_neg(" + temp + ".b, " + temp + ".b, sizeof(" + temp + ".b), " + std::to_string(extint_top_mask(bits)) + ");");
@@ -2045,19 +2131,15 @@ std::string CodeGenerator::gen_length(ExprPtr expr) {
                 case 32: unsigned_type = "uint32_t"; break;
                 case 64: unsigned_type = "uint64_t"; break;
                 default:
-                    return "abs(" + operand + ")";
+                    if (!is_wide_native_integer_type(expr->operand->type)) return "abs(" + operand + ")";
+                    unsigned_type = wide_native_type_name(false, bits);
+                    break;
             }
             std::string signed_type = gen_type(expr->operand->type);
             std::string s_tmp = fresh_temp();
-            if (!declared_temps.count(s_tmp)) {
-                emit(storage_prefix() + signed_type + " " + s_tmp + ";");
-                declared_temps.insert(s_tmp);
-            }
+            declare_temp(signed_type, s_tmp);
             std::string u_tmp = fresh_temp();
-            if (!declared_temps.count(u_tmp)) {
-                emit(storage_prefix() + unsigned_type + " " + u_tmp + ";");
-                declared_temps.insert(u_tmp);
-            }
+            declare_temp(unsigned_type, u_tmp);
             emit(s_tmp + " = (" + signed_type + ")(" + operand + ");");
             emit(u_tmp + " = (" + unsigned_type + ")" + s_tmp + ";");
             emit("if (" + s_tmp + " < 0) " + u_tmp + " = (" + unsigned_type + ")(~" + u_tmp + ") + (" + unsigned_type + ")1;");
@@ -2071,6 +2153,143 @@ std::string CodeGenerator::gen_length(ExprPtr expr) {
     return "abs(" + operand + ")";
 }
 
+// An iteration body may carry a vectorization hint when lanes cannot
+// interfere: native scalar arithmetic only (no calls, nested loops or control
+// transfer), memory written only at `_` of a range loop and then read only
+// there, and outer locals written only as `x = x op e` reductions that are not
+// otherwise read. Reductions are returned as (operator, C name).
+bool CodeGenerator::vectorizable_loop_body(ExprPtr body,
+                                           bool indexed_by_range,
+                                           std::vector<std::pair<std::string, std::string>>& reductions) {
+    auto native_scalar = [&](TypePtr type) {
+        TypePtr resolved = resolve_type(type);
+        if (!resolved || resolved->kind != Type::Kind::Primitive) return false;
+        switch (resolved->primitive) {
+            case PrimitiveType::F32:
+            case PrimitiveType::F64:
+            case PrimitiveType::Bool:
+                return true;
+            default:
+                return is_native_integer_type(resolved);
+        }
+    };
+    auto is_underscore = [](const ExprPtr& e) {
+        return e && e->kind == Expr::Kind::Identifier && e->name == "_";
+    };
+
+    bool writes_memory = false;
+    bool irregular_read = false;
+    std::unordered_set<const Symbol*> declared;
+    std::unordered_map<const Symbol*, size_t> occurrences;
+    std::vector<std::pair<const Symbol*, std::string>> updates;  // symbol, operator
+    std::unordered_map<const Symbol*, size_t> expected_occurrences;
+
+    std::function<bool(const ExprPtr&)> visit;
+    std::function<bool(const StmtPtr&)> visit_stmt = [&](const StmtPtr& stmt) {
+        if (!stmt) return true;
+        switch (stmt->kind) {
+            case Stmt::Kind::Expr:
+                return visit(stmt->expr);
+            case Stmt::Kind::VarDecl:
+                if (Symbol* sym = binding_for(stmt)) declared.insert(sym);
+                return native_scalar(stmt->var_type) && visit(stmt->var_init);
+            case Stmt::Kind::ConditionalStmt:
+                return visit(stmt->condition) && visit_stmt(stmt->true_stmt);
+            default:
+                return false;
+        }
+    };
+    // Writes through `a[_]` (optionally followed by member accesses).
+    auto regular_store = [&](ExprPtr lhs) {
+        while (lhs && lhs->kind == Expr::Kind::Member) lhs = lhs->operand;
+        return indexed_by_range && lhs && lhs->kind == Expr::Kind::Index && lhs->args.size() == 1 &&
+               is_underscore(lhs->args[0]) && lhs->operand && lhs->operand->kind == Expr::Kind::Identifier;
+    };
+    visit = [&](const ExprPtr& e) -> bool {
+        if (!e) return true;
+        switch (e->kind) {
+            case Expr::Kind::IntLiteral:
+            case Expr::Kind::FloatLiteral:
+            case Expr::Kind::CharLiteral:
+                return true;
+            case Expr::Kind::Identifier: {
+                if (e->name == "_") return true;
+                if (e->is_expr_param_ref) return false;
+                if (Symbol* sym = binding_for(e)) occurrences[sym]++;
+                return true;
+            }
+            case Expr::Kind::Binary:
+                return native_scalar(e->type) && visit(e->left) && visit(e->right);
+            case Expr::Kind::Unary:
+            case Expr::Kind::Cast:
+                return native_scalar(e->type) && visit(e->operand);
+            case Expr::Kind::Member:
+                return visit(e->operand);
+            case Expr::Kind::Index:
+                if (e->args.size() != 1) return false;
+                if (!is_underscore(e->args[0])) irregular_read = true;
+                return visit(e->operand) && visit(e->args[0]);
+            case Expr::Kind::Conditional:
+                return visit(e->condition) && visit(e->true_expr) && visit(e->false_expr);
+            case Expr::Kind::Block:
+                for (const auto& stmt : e->statements) {
+                    if (!visit_stmt(stmt)) return false;
+                }
+                return visit(e->result_expr);
+            case Expr::Kind::Assignment: {
+                if (!e->left || !native_scalar(e->left->type)) return false;
+                if (e->left->kind != Expr::Kind::Identifier) {
+                    if (!regular_store(e->left)) return false;
+                    writes_memory = true;
+                    return visit(e->left) && visit(e->right);
+                }
+                Symbol* sym = binding_for(e->left);
+                if (!sym || e->left->name == "_") return false;
+                if (e->creates_new_variable || declared.count(sym)) {
+                    declared.insert(sym);
+                    return visit(e->right);
+                }
+                if (!sym->is_local || sym->is_backend_bound || current_ref_params.count(e->left->name) ||
+                    current_aggregate_params.count(e->left->name)) {
+                    return false;
+                }
+                const AssignOp assign_op = e->op.empty() ? AssignOp::Assign : e->assign_op;
+                std::string op;
+                size_t self_reads = 0;
+                if (assign_op == AssignOp::Add || assign_op == AssignOp::Mul || assign_op == AssignOp::BitAnd ||
+                    assign_op == AssignOp::BitOr || assign_op == AssignOp::BitXor) {
+                    op = e->op.substr(0, 1);
+                } else if (assign_op == AssignOp::Assign && e->right && e->right->kind == Expr::Kind::Binary &&
+                           (e->right->binary_op == BinaryOp::Add || e->right->binary_op == BinaryOp::Mul ||
+                            e->right->binary_op == BinaryOp::BitAnd || e->right->binary_op == BinaryOp::BitOr ||
+                            e->right->binary_op == BinaryOp::BitXor)) {
+                    auto is_self = [&](const ExprPtr& side) {
+                        return side && side->kind == Expr::Kind::Identifier && binding_for(side) == sym;
+                    };
+                    if (is_self(e->right->left) || is_self(e->right->right)) {
+                        op = e->right->op;
+                        self_reads = 1;
+                    }
+                }
+                if (op.empty() || expected_occurrences.count(sym)) return false;
+                expected_occurrences[sym] = self_reads;
+                updates.emplace_back(sym, op);
+                return visit(e->right);
+            }
+            default:
+                return false;
+        }
+    };
+
+    if (!visit(body)) return false;
+    if (writes_memory && irregular_read) return false;
+    for (const auto& update : updates) {
+        if (occurrences[update.first] != expected_occurrences[update.first]) return false;
+        reductions.emplace_back(update.second, mangle_name(update.first->name) + instance_suffix(update.first));
+    }
+    return true;
+}
+
 std::string CodeGenerator::gen_iteration(ExprPtr expr) {
     if (!expr->operand || !expr->operand->type || expr->operand->type->kind != Type::Kind::Array) {
         throw CompileError("Iteration requires array or range", expr->location);
@@ -2084,6 +2303,8 @@ std::string CodeGenerator::gen_iteration(ExprPtr expr) {
 
     std::string size_str;
     int64_t element_count = 0;
+    int64_t range_start = 0;
+    bool range_ascending = true;
     auto value_to_int64 = [&](const CTValue& v, const SourceLocation& loc) -> int64_t {
         int64_t out = 0;
         if (ctvalue_to_i64_exact(v, out)) return out;
@@ -2099,6 +2320,8 @@ std::string CodeGenerator::gen_iteration(ExprPtr expr) {
         int64_t start = value_to_int64(start_val, expr->operand->left->location);
         int64_t end = value_to_int64(end_val, expr->operand->right->location);
         element_count = (start < end) ? (end - start) : (start - end);
+        range_start = start;
+        range_ascending = start < end;
         if (element_count <= 0) {
             throw CompileError("Range iteration produced empty sequence", expr->location);
         }
@@ -2111,17 +2334,47 @@ std::string CodeGenerator::gen_iteration(ExprPtr expr) {
         size_str = std::to_string(element_count);
     }
 
+    // With loop hints on, an unsorted range walks its bounds directly instead
+    // of materializing the index array. Constant folding turns most ranges
+    // into literal arrays of consecutive integers, which count the same way.
+    auto consecutive_literals = [&](const ExprPtr& subject) {
+        if (subject->kind != Expr::Kind::ArrayLiteral || subject->elements.empty() ||
+            static_cast<int64_t>(subject->elements.size()) != element_count) {
+            return false;
+        }
+        std::vector<int64_t> values;
+        for (const auto& element : subject->elements) {
+            if (!element || element->kind != Expr::Kind::IntLiteral) return false;
+            if (element->literal_is_unsigned && element->uint_val > static_cast<uint64_t>(INT64_MAX)) return false;
+            values.push_back(static_cast<int64_t>(element->uint_val));
+        }
+        const bool ascending = values.size() == 1 || values[1] > values[0];
+        for (size_t i = 1; i < values.size(); ++i) {
+            if (values[i] != (ascending ? values[i - 1] + 1 : values[i - 1] - 1)) return false;
+        }
+        range_start = values.front();
+        range_ascending = ascending;
+        return true;
+    };
+    const bool vectorize = loop_vectorization != LoopVectorization::Off;
+    const bool counted_range = vectorize && !expr->is_sorted_iteration && is_native_integer_type(element_type) &&
+                               (expr->operand->kind == Expr::Kind::Range || consecutive_literals(expr->operand));
     std::string array_expr;
-    {
-        VoidCallGuard guard(*this, false);
-        array_expr = gen_expr(expr->operand);
+    std::string array_ptr;
+    if (!counted_range) {
+        {
+            VoidCallGuard guard(*this, false);
+            array_expr = gen_expr(expr->operand);
+        }
+        array_ptr = fresh_temp();
     }
-    std::string array_ptr = fresh_temp();
     std::string loop_var = fresh_temp();
     std::string underscore = fresh_temp();
 
     emit("{");
-    emit("  " + element_c_type + "* " + array_ptr + " = " + array_expr + ";");
+    if (!counted_range) {
+        emit("  " + element_c_type + "* " + array_ptr + " = " + array_expr + ";");
+    }
 
     if (expr->is_sorted_iteration && element_count > 1) {
         if (!element_type) {
@@ -2130,32 +2383,98 @@ std::string CodeGenerator::gen_iteration(ExprPtr expr) {
         std::string copy_var = fresh_temp();
         std::string sort_buffer = fresh_temp();
         std::string cmp_name = ensure_comparator(element_type);
-        std::string i_var = fresh_temp();
-        std::string j_var = fresh_temp();
-        std::string key_var = fresh_temp();
 
         emit("  " + storage_prefix() + element_c_type + " " + sort_buffer + "[" + size_str + "];");
         emit("  for (int " + copy_var + " = 0; " + copy_var + " < " + size_str + "; " + copy_var + "++) {");
         emit("    " + sort_buffer + "[" + copy_var + "] = " + array_ptr + "[" + copy_var + "];");
         emit("  }");
-        emit("  for (int " + i_var + " = 1; " + i_var + " < " + size_str + "; " + i_var + "++) {");
-        emit("    " + element_c_type + " " + key_var + " = " + sort_buffer + "[" + i_var + "];");
-        emit("    int " + j_var + " = " + i_var + " - 1;");
-        emit("    while (" + j_var + " >= 0 && " + cmp_name + "(" + sort_buffer + "[" + j_var + "], " + key_var + ") > 0) {");
-        emit("      " + sort_buffer + "[" + j_var + " + 1] = " + sort_buffer + "[" + j_var + "];");
-        emit("      " + j_var + " = " + j_var + " - 1;");
-        emit("    }");
-        emit("    " + sort_buffer + "[" + j_var + " + 1] = " + key_var + ";");
-        emit("  }");
-        emit("  " + array_ptr + " = " + sort_buffer + ";");
+        if (element_count <= kInsertionSortMaxElements) {
+            std::string i_var = fresh_temp();
+            std::string j_var = fresh_temp();
+            std::string key_var = fresh_temp();
+            emit("  for (int " + i_var + " = 1; " + i_var + " < " + size_str + "; " + i_var + "++) {");
+            emit("    " + element_c_type + " " + key_var + " = " + sort_buffer + "[" + i_var + "];");
+            emit("    int " + j_var + " = " + i_var + " - 1;");
+            emit("    while (" + j_var + " >= 0 && " + cmp_name + "(" + sort_buffer + "[" + j_var + "], " + key_var + ") > 0) {");
+            emit("      " + sort_buffer + "[" + j_var + " + 1] = " + sort_buffer + "[" + j_var + "];");
+            emit("      " + j_var + " = " + j_var + " - 1;");
+            emit("    }");
+            emit("    " + sort_buffer + "[" + j_var + " + 1] = " + key_var + ";");
+            emit("  }");
+            emit("  " + array_ptr + " = " + sort_buffer + ";");
+        } else {
+            // Bottom-up merge sort ping-ponging between two fixed buffers:
+            // stable, O(n log n), no recursion and no heap.
+            std::string merge_buffer = fresh_temp();
+            std::string src = fresh_temp();
+            std::string dst = fresh_temp();
+            std::string swap = fresh_temp();
+            std::string width = fresh_temp();
+            std::string lo = fresh_temp();
+            std::string mid = fresh_temp();
+            std::string hi = fresh_temp();
+            std::string a = fresh_temp();
+            std::string b = fresh_temp();
+            std::string k = fresh_temp();
+            emit("  " + storage_prefix() + element_c_type + " " + merge_buffer + "[" + size_str + "];");
+            emit("  " + element_c_type + "* " + src + " = " + sort_buffer + ";");
+            emit("  " + element_c_type + "* " + dst + " = " + merge_buffer + ";");
+            emit("  for (int " + width + " = 1; " + width + " < " + size_str + "; " + width + " *= 2) {");
+            emit("    for (int " + lo + " = 0; " + lo + " < " + size_str + "; " + lo + " += 2 * " + width + ") {");
+            emit("      int " + mid + " = (" + lo + " + " + width + " < " + size_str + ") ? " + lo + " + " + width +
+                 " : " + size_str + ";");
+            emit("      int " + hi + " = (" + lo + " + 2 * " + width + " < " + size_str + ") ? " + lo + " + 2 * " +
+                 width + " : " + size_str + ";");
+            emit("      int " + a + " = " + lo + ", " + b + " = " + mid + ", " + k + " = " + lo + ";");
+            emit("      while (" + a + " < " + mid + " && " + b + " < " + hi + ") {");
+            emit("        if (" + cmp_name + "(" + src + "[" + b + "], " + src + "[" + a + "]) < 0) " + dst + "[" + k +
+                 "++] = " + src + "[" + b + "++];");
+            emit("        else " + dst + "[" + k + "++] = " + src + "[" + a + "++];");
+            emit("      }");
+            emit("      while (" + a + " < " + mid + ") " + dst + "[" + k + "++] = " + src + "[" + a + "++];");
+            emit("      while (" + b + " < " + hi + ") " + dst + "[" + k + "++] = " + src + "[" + b + "++];");
+            emit("    }");
+            emit("    " + element_c_type + "* " + swap + " = " + src + ";");
+            emit("    " + src + " = " + dst + ";");
+            emit("    " + dst + " = " + swap + ";");
+            emit("  }");
+            emit("  " + array_ptr + " = " + src + ";");
+        }
+    }
+
+    // Static locals, inlined parameters and banked loads can make lanes share
+    // state the body scan does not see.
+    std::vector<std::pair<std::string, std::string>> reductions;
+    const bool hinted = vectorize && !current_function_non_reentrant && !abi.symbol_load_expr &&
+                        expr_param_substitutions.empty() && value_param_replacements.empty() &&
+                        vectorizable_loop_body(expr->right, counted_range, reductions);
+    if (hinted && loop_vectorization == LoopVectorization::OmpSimd) {
+        std::string pragma = "#pragma omp simd";
+        for (const auto& reduction : reductions) {
+            pragma += " reduction(" + reduction.first + ":" + reduction.second + ")";
+        }
+        emit("  " + pragma);
+    } else if (hinted) {
+        emit("  #pragma GCC ivdep");
     }
-
     emit("  for (int " + loop_var + " = 0; " + loop_var + " < " + size_str + "; " + loop_var + "++) {");
-    emit("    " + element_c_type + " " + underscore + " = " + array_ptr + "[" + loop_var + "];");
+    if (counted_range) {
+        std::string start = std::to_string(range_start);
+        if (range_start < INT32_MIN || range_start > INT32_MAX) start = "INT64_C(" + start + ")";
+        emit("    " + element_c_type + " " + underscore + " = (" + element_c_type + ")(" + start +
+             (range_ascending ? " + " : " - ") + loop_var + ");");
+    } else {
+        emit("    " + element_c_type + " " + underscore + " = " + array_ptr + "[" + loop_var + "];");
+    }
 
     std::string saved_underscore = underscore_var;
     underscore_var = underscore;
 
+    // Hinted bodies declare every temp inside the loop, so no lane writes a
+    // scalar that outlives its iteration.
+    std::stack<std::string> saved_available_temps;
+    if (hinted) std::swap(saved_available_temps, available_temps);
+
     std::string body_code;
     {
         VoidCallGuard guard(*this, true);
@@ -2165,6 +2484,7 @@ std::string CodeGenerator::gen_iteration(ExprPtr expr) {
         emit("    " + body_code + ";");
     }
 
+    if (hinted) available_temps = std::move(saved_available_temps);
     underscore_var = saved_underscore;
 
     emit("  }");
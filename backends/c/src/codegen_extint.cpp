@@ -81,13 +81,6 @@ static int vx_ai_scmp(const uint8_t* a, const uint8_t* b, size_t n, uint8_t sign
     return sa ? -u : u;
 }
 
-static int vx_ai_get_bit(const uint8_t* v, size_t n, unsigned long bit_index) {
-    unsigned long byte_index = bit_index / 8u;
-    unsigned long bit = bit_index % 8u;
-    if ((size_t)byte_index >= n) return 0;
-    return (v[byte_index] >> bit) & 1u;
-}
-
 static void vx_ai_set_bit(uint8_t* v, size_t n, unsigned long bit_index, int bit_value) {
     unsigned long byte_index = bit_index / 8u;
     unsigned long bit = bit_index % 8u;
@@ -97,16 +90,6 @@ static void vx_ai_set_bit(uint8_t* v, size_t n, unsigned long bit_index, int bit
     else v[byte_index] &= (uint8_t)~mask;
 }
 
-static void vx_ai_shl1_inplace(uint8_t* v, size_t n, uint8_t top_mask) {
-    unsigned carry = 0u;
-    for (size_t i = 0; i < n; ++i) {
-        unsigned next = (unsigned)((v[i] >> 7) & 1u);
-        v[i] = (uint8_t)(((unsigned)v[i] << 1u) | carry);
-        carry = next;
-    }
-    vx_ai_mask_top(v, n, top_mask);
-}
-
 static void vx_ai_add(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n, uint8_t top_mask) {
     unsigned carry = 0u;
     for (size_t i = 0; i < n; ++i) {
@@ -230,40 +213,164 @@ static void vx_ai_shr_s(uint8_t* out, const uint8_t* a, size_t n, unsigned long
     vx_ai_mask_top(out, n, top_mask);
 }
 
-static void vx_ai_mul(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n, uint8_t top_mask) {
-    for (size_t i = 0; i < n; ++i) out[i] = 0;
+/* Multiplication and division work on machine-word limbs loaded from the
+   little-endian byte layout: 64-bit limbs when the compiler has a 128-bit
+   integer for the double-width products, 32-bit limbs otherwise. */
+#if defined(__SIZEOF_INT128__)
+typedef uint64_t vx_ai_limb;
+__extension__ typedef unsigned __int128 vx_ai_dlimb;
+#define VX_AI_LIMB_BYTES 8u
+#else
+typedef uint32_t vx_ai_limb;
+typedef uint64_t vx_ai_dlimb;
+#define VX_AI_LIMB_BYTES 4u
+#endif
+#define VX_AI_LIMB_BITS (VX_AI_LIMB_BYTES * 8u)
+#define VX_AI_STACK_LIMBS 64u
+
+static size_t vx_ai_limb_count(size_t n) {
+    return (n + VX_AI_LIMB_BYTES - 1u) / VX_AI_LIMB_BYTES;
+}
+
+static vx_ai_limb* vx_ai_scratch(vx_ai_limb* stack, size_t count) {
+    if (count <= VX_AI_STACK_LIMBS) return stack;
+    vx_ai_limb* heap = (vx_ai_limb*)malloc(count * sizeof(vx_ai_limb));
+    if (!heap) abort();
+    return heap;
+}
+
+static void vx_ai_load_limbs(vx_ai_limb* out, size_t limbs, const uint8_t* in, size_t n) {
+    for (size_t i = 0; i < limbs; ++i) out[i] = 0;
     for (size_t i = 0; i < n; ++i) {
-        unsigned carry = 0u;
-        for (size_t j = 0; j + i < n; ++j) {
-            size_t k = i + j;
-            unsigned prod = (unsigned)out[k] + (unsigned)a[i] * (unsigned)b[j] + carry;
-            out[k] = (uint8_t)(prod & 0xFFu);
-            carry = (prod >> 8) & 0xFFFFu;
-        }
+        out[i / VX_AI_LIMB_BYTES] |= (vx_ai_limb)in[i] << (8u * (unsigned)(i % VX_AI_LIMB_BYTES));
     }
+}
+
+static void vx_ai_store_limbs(uint8_t* out, size_t n, const vx_ai_limb* in) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (uint8_t)(in[i / VX_AI_LIMB_BYTES] >> (8u * (unsigned)(i % VX_AI_LIMB_BYTES)));
+    }
+}
+
+static size_t vx_ai_limb_used(const vx_ai_limb* v, size_t limbs) {
+    while (limbs > 0 && v[limbs - 1] == 0) --limbs;
+    return limbs;
+}
+
+static void vx_ai_mul(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n, uint8_t top_mask) {
+    size_t limbs = vx_ai_limb_count(n);
+    vx_ai_limb stack[VX_AI_STACK_LIMBS];
+    vx_ai_limb* buf = vx_ai_scratch(stack, 3u * limbs);
+    vx_ai_limb* la = buf;
+    vx_ai_limb* lb = buf + limbs;
+    vx_ai_limb* lr = buf + 2u * limbs;
+    vx_ai_load_limbs(la, limbs, a, n);
+    vx_ai_load_limbs(lb, limbs, b, n);
+    for (size_t i = 0; i < limbs; ++i) lr[i] = 0;
+    for (size_t i = 0; i < limbs; ++i) {
+        if (la[i] == 0) continue;
+        vx_ai_limb carry = 0;
+        for (size_t j = 0; j + i < limbs; ++j) {
+            vx_ai_dlimb t = (vx_ai_dlimb)la[i] * lb[j] + lr[i + j] + carry;
+            lr[i + j] = (vx_ai_limb)t;
+            carry = (vx_ai_limb)(t >> VX_AI_LIMB_BITS);
+        }
+    }
+    vx_ai_store_limbs(out, n, lr);
+    if (buf != stack) free(buf);
     vx_ai_mask_top(out, n, top_mask);
 }
 
+/* Long division over limbs (Knuth, TAOCP vol. 2, 4.3.1, algorithm D). */
 static void vx_ai_udivmod(uint8_t* out_q, uint8_t* out_r,
                           const uint8_t* a, const uint8_t* b,
                           size_t n, uint8_t top_mask) {
-    for (size_t i = 0; i < n; ++i) { out_q[i] = 0; out_r[i] = 0; }
     if (n == 0) return;
     if (vx_ai_is_zero(b, n)) abort();
-    unsigned long used_bits = 0;
-    for (unsigned bit = 0; bit < 8u; ++bit) {
-        if (top_mask & (uint8_t)(1u << bit)) used_bits = (unsigned long)((n - 1) * 8u + bit + 1u);
-    }
-    if (used_bits == 0) used_bits = (unsigned long)n * 8u;
-    for (unsigned long iter = used_bits; iter > 0; --iter) {
-        unsigned long bit = iter - 1u;
-        vx_ai_shl1_inplace(out_r, n, top_mask);
-        vx_ai_set_bit(out_r, n, 0u, vx_ai_get_bit(a, n, bit));
-        if (vx_ai_ucmp(out_r, b, n) >= 0) {
-            vx_ai_sub(out_r, out_r, b, n, top_mask);
-            vx_ai_set_bit(out_q, n, bit, 1);
+    size_t limbs = vx_ai_limb_count(n);
+    vx_ai_limb stack[VX_AI_STACK_LIMBS];
+    vx_ai_limb* buf = vx_ai_scratch(stack, 6u * limbs + 1u);
+    vx_ai_limb* la = buf;
+    vx_ai_limb* lb = la + limbs;
+    vx_ai_limb* lq = lb + limbs;
+    vx_ai_limb* lr = lq + limbs;
+    vx_ai_limb* vn = lr + limbs;
+    vx_ai_limb* un = vn + limbs;
+    vx_ai_load_limbs(la, limbs, a, n);
+    vx_ai_load_limbs(lb, limbs, b, n);
+    /* Bits of the dividend above the type width do not take part. */
+    la[(n - 1u) / VX_AI_LIMB_BYTES] &=
+        ~((vx_ai_limb)(uint8_t)~top_mask << (8u * (unsigned)((n - 1u) % VX_AI_LIMB_BYTES)));
+    for (size_t i = 0; i < limbs; ++i) { lq[i] = 0; lr[i] = 0; }
+    size_t an = vx_ai_limb_used(la, limbs);
+    size_t bn = vx_ai_limb_used(lb, limbs);
+    if (an < bn) {
+        for (size_t i = 0; i < an; ++i) lr[i] = la[i];
+    } else if (bn == 1u) {
+        vx_ai_limb d = lb[0];
+        vx_ai_dlimb rem = 0;
+        for (size_t i = an; i > 0; --i) {
+            vx_ai_dlimb num = (rem << VX_AI_LIMB_BITS) | la[i - 1];
+            lq[i - 1] = (vx_ai_limb)(num / d);
+            rem = num % d;
+        }
+        lr[0] = (vx_ai_limb)rem;
+    } else {
+        unsigned shift = 0;
+        while (((lb[bn - 1] << shift) >> (VX_AI_LIMB_BITS - 1u)) == 0) ++shift;
+        for (size_t i = bn - 1u; i > 0; --i) {
+            vn[i] = shift ? (lb[i] << shift) | (lb[i - 1] >> (VX_AI_LIMB_BITS - shift)) : lb[i];
+        }
+        vn[0] = lb[0] << shift;
+        un[an] = shift ? la[an - 1] >> (VX_AI_LIMB_BITS - shift) : 0;
+        for (size_t i = an - 1u; i > 0; --i) {
+            un[i] = shift ? (la[i] << shift) | (la[i - 1] >> (VX_AI_LIMB_BITS - shift)) : la[i];
+        }
+        un[0] = la[0] << shift;
+        const vx_ai_dlimb base = (vx_ai_dlimb)1 << VX_AI_LIMB_BITS;
+        for (size_t jj = an - bn + 1u; jj > 0; --jj) {
+            size_t j = jj - 1u;
+            vx_ai_dlimb num = ((vx_ai_dlimb)un[j + bn] << VX_AI_LIMB_BITS) | un[j + bn - 1u];
+            vx_ai_dlimb qhat = num / vn[bn - 1u];
+            vx_ai_dlimb rhat = num % vn[bn - 1u];
+            while (qhat >= base ||
+                   qhat * vn[bn - 2u] > ((rhat << VX_AI_LIMB_BITS) | un[j + bn - 2u])) {
+                --qhat;
+                rhat += vn[bn - 1u];
+                if (rhat >= base) break;
+            }
+            vx_ai_limb borrow = 0;
+            vx_ai_limb carry = 0;
+            for (size_t i = 0; i < bn; ++i) {
+                vx_ai_dlimb p = qhat * vn[i] + carry;
+                carry = (vx_ai_limb)(p >> VX_AI_LIMB_BITS);
+                vx_ai_limb sub = (vx_ai_limb)p;
+                vx_ai_limb cur = un[i + j];
+                un[i + j] = cur - sub - borrow;
+                borrow = (cur < sub || (vx_ai_limb)(cur - sub) < borrow) ? 1u : 0u;
+            }
+            vx_ai_limb top = un[j + bn];
+            un[j + bn] = top - carry - borrow;
+            borrow = (top < carry || (vx_ai_limb)(top - carry) < borrow) ? 1u : 0u;
+            if (borrow) {
+                --qhat;
+                vx_ai_limb add_carry = 0;
+                for (size_t i = 0; i < bn; ++i) {
+                    vx_ai_dlimb sum = (vx_ai_dlimb)un[i + j] + vn[i] + add_carry;
+                    un[i + j] = (vx_ai_limb)sum;
+                    add_carry = (vx_ai_limb)(sum >> VX_AI_LIMB_BITS);
+                }
+                un[j + bn] += add_carry;
+            }
+            lq[j] = (vx_ai_limb)qhat;
+        }
+        for (size_t i = 0; i < bn; ++i) {
+            lr[i] = shift ? (un[i] >> shift) | (un[i + 1u] << (VX_AI_LIMB_BITS - shift)) : un[i];
         }
     }
+    vx_ai_store_limbs(out_q, n, lq);
+    vx_ai_store_limbs(out_r, n, lr);
+    if (buf != stack) free(buf);
     vx_ai_mask_top(out_q, n, top_mask);
     vx_ai_mask_top(out_r, n, top_mask);
 }
@@ -381,7 +488,89 @@ namespace vexel::c_backend_codegen {
 bool CodeGenerator::analyze_extint_type(TypePtr type, bool& is_signed, uint64_t& bits) const {
     TypePtr resolved = resolve_type(type);
     if (!is_integer_primitive_kind(resolved, is_signed, bits)) return false;
-    return bits != 8 && bits != 16 && bits != 32 && bits != 64;
+    if (bits == 8 || bits == 16 || bits == 32 || bits == 64) return false;
+    bool plain_int = resolved->primitive == PrimitiveType::Int || resolved->primitive == PrimitiveType::UInt;
+    return !(plain_int && lowers_to_wide_native(is_signed, bits));
+}
+
+bool CodeGenerator::lowers_to_wide_native(bool is_signed, uint64_t bits) const {
+    switch (extint_lowering) {
+        case ExtIntLowering::Bytes:
+            return false;
+        case ExtIntLowering::Int128:
+            return bits == 128;
+        case ExtIntLowering::BitInt:
+            return bits >= (is_signed ? 2u : 1u);
+    }
+    return false;
+}
+
+bool CodeGenerator::is_wide_native_integer_type(TypePtr type, bool& is_signed, uint64_t& bits) const {
+    if (extint_lowering == ExtIntLowering::Bytes) return false;
+    TypePtr resolved = resolve_type(type);
+    if (!resolved || resolved->kind != Type::Kind::Primitive) return false;
+    if (resolved->primitive != PrimitiveType::Int && resolved->primitive != PrimitiveType::UInt) return false;
+    if (!is_integer_primitive_kind(resolved, is_signed, bits)) return false;
+    if (bits == 8 || bits == 16 || bits == 32 || bits == 64) return false;
+    return lowers_to_wide_native(is_signed, bits);
+}
+
+bool CodeGenerator::is_wide_native_integer_type(TypePtr type) const {
+    bool is_signed = false;
+    uint64_t bits = 0;
+    return is_wide_native_integer_type(type, is_signed, bits);
+}
+
+std::string CodeGenerator::wide_native_type_name(bool is_signed, uint64_t bits) {
+    std::string name = std::string(is_signed ? "vx_native_i" : "vx_native_u") + std::to_string(bits) + "_t";
+    if (!wide_native_types_used.insert({is_signed, bits}).second) {
+        return name;
+    }
+    if (deferred_shared_state) {
+        SharedStateEvent event;
+        event.kind = SharedStateEvent::Kind::WideNative;
+        event.is_signed = is_signed;
+        event.bits = bits;
+        defer_shared_state(std::move(event));
+        return name;
+    }
+    std::ostringstream os;
+    if (extint_lowering == ExtIntLowering::Int128) {
+        os << "#if !defined(__SIZEOF_INT128__)\n"
+           << "#error \"generated with C backend option extint=int128: needs a compiler with __int128\"\n"
+           << "#endif\n"
+           << "__extension__ typedef " << (is_signed ? "" : "unsigned ") << "__int128 " << name << ";\n";
+    } else {
+        os << "#if !defined(__BITINT_MAXWIDTH__) || __BITINT_MAXWIDTH__ < " << bits << "\n"
+           << "#error \"generated with C backend option extint=bitint: needs a compiler with _BitInt(" << bits
+           << ")\"\n"
+           << "#endif\n"
+           << "typedef " << (is_signed ? "" : "unsigned ") << "_BitInt(" << bits << ") " << name << ";\n";
+    }
+    extint_header_defs += os.str();
+    return name;
+}
+
+std::string CodeGenerator::wide_native_literal(bool is_signed, uint64_t bits, const APInt& value) {
+    std::string type = wide_native_type_name(is_signed, bits);
+    APInt wrapped = is_signed ? value.wrapped_signed(bits) : value.wrapped_unsigned(bits);
+    if (wrapped.fits_i64()) return "((" + type + ")" + std::to_string(wrapped.to_i64()) + "LL)";
+    if (wrapped.fits_u64()) return "((" + type + ")" + std::to_string(wrapped.to_u64()) + "ULL)";
+    // Wider constants are assembled from 64-bit chunks, most significant first.
+    std::string utype = wide_native_type_name(false, bits);
+    size_t n = static_cast<size_t>((bits + 7u) / 8u);
+    std::vector<uint8_t> bytes = (is_signed ? wrapped.wrapped_unsigned(bits) : wrapped).to_unsigned_le_bytes(n);
+    std::string acc;
+    for (size_t chunk = (n + 7u) / 8u; chunk > 0; --chunk) {
+        uint64_t word = 0;
+        for (size_t i = 0; i < 8u; ++i) {
+            size_t index = (chunk - 1u) * 8u + i;
+            if (index < n) word |= static_cast<uint64_t>(bytes[index]) << (8u * i);
+        }
+        std::string part = "(" + utype + ")" + std::to_string(word) + "ULL";
+        acc = acc.empty() ? part : "((" + acc + " << 64) | " + part + ")";
+    }
+    return "((" + type + ")" + acc + ")";
 }
 
 bool CodeGenerator::is_extended_integer_type(TypePtr type) const {
@@ -395,7 +584,7 @@ bool CodeGenerator::is_native_integer_type(TypePtr type) const {
     uint64_t bits = 0;
     TypePtr resolved = resolve_type(type);
     if (!is_integer_primitive_kind(resolved, is_signed, bits)) return false;
-    return bits == 8 || bits == 16 || bits == 32 || bits == 64;
+    return bits == 8 || bits == 16 || bits == 32 || bits == 64 || is_wide_native_integer_type(resolved);
 }
 
 bool CodeGenerator::is_extended_integer_expr(ExprPtr expr) const {
@@ -447,6 +636,14 @@ void CodeGenerator::ensure_extint_type(bool is_signed, uint64_t bits) {
     if (!extint_types_used.insert({is_signed, bits}).second) {
         return;
     }
+    if (deferred_shared_state) {
+        SharedStateEvent event;
+        event.kind = SharedStateEvent::Kind::ExtInt;
+        event.is_signed = is_signed;
+        event.bits = bits;
+        defer_shared_state(std::move(event));
+        return;
+    }
     ensure_extint_runtime();
     size_t bytes = extint_num_bytes(bits, SourceLocation(), "arbitrary-width integer helper");
     std::ostringstream os;
@@ -465,6 +662,9 @@ std::string CodeGenerator::emit_extint_const_initializer(TypePtr target_type,
     (void)value_is_unsigned;
     bool is_signed = false;
     uint64_t bits = 0;
+    if (is_wide_native_integer_type(target_type, is_signed, bits)) {
+        return wide_native_literal(is_signed, bits, value);
+    }
     if (!analyze_extint_type(target_type, is_signed, bits)) {
         throw CompileError("Internal error: expected arbitrary-width integer target for constant initializer", loc);
     }
@@ -486,7 +686,7 @@ std::optional<std::string> CodeGenerator::folded_scalar_expr_literal(const CTVal
     APInt exact;
     bool is_unsigned = false;
     if (ctvalue_to_apint_value(value, exact, is_unsigned)) {
-        if (is_extended_integer_type(expected_type)) {
+        if (is_extended_integer_type(expected_type) || is_wide_native_integer_type(expected_type)) {
             return emit_extint_temp_literal(expected_type, exact, is_unsigned, loc);
         }
         if (exact.fits_i64()) return std::to_string(exact.to_i64());
@@ -497,7 +697,7 @@ std::optional<std::string> CodeGenerator::folded_scalar_expr_literal(const CTVal
         return std::get<bool>(value) ? "1" : "0";
     }
     if (std::holds_alternative<double>(value)) {
-        return std::to_string(std::get<double>(value));
+        return format_c_double(std::get<double>(value));
     }
     return std::nullopt;
 }
@@ -524,15 +724,12 @@ std::string CodeGenerator::gen_extint_unary(ExprPtr expr, const std::string& ope
     ensure_extint_type(is_signed, bits);
     std::string tmp = fresh_temp();
     std::string rtype = gen_type(expr->type);
-    if (!declared_temps.count(tmp)) {
-        emit(storage_prefix() + rtype + " " + tmp + ";");
-        declared_temps.insert(tmp);
-    }
-    if (expr->op == "-") {
+    declare_temp(rtype, tmp);
+    if (expr->unary_op == UnaryOp::Neg) {
         emit("vx_ai_neg(" + tmp + ".b, (" + operand + ").b, sizeof(" + tmp + ".b), " + std::to_string(extint_top_mask(bits)) + ");");
         return tmp;
     }
-    if (expr->op == "~") {
+    if (expr->unary_op == UnaryOp::BitNot) {
         emit("vx_ai_not(" + tmp + ".b, (" + operand + ").b, sizeof(" + tmp + ".b), " + std::to_string(extint_top_mask(bits)) + ");");
         return tmp;
     }
@@ -550,25 +747,19 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
     if (expr->left && is_extended_integer_type(expr->left->type)) {
         std::string tmp = fresh_temp();
         std::string t = gen_type(expr->left->type);
-        if (!declared_temps.count(tmp)) {
-            emit(storage_prefix() + t + " " + tmp + ";");
-            declared_temps.insert(tmp);
-        }
+        declare_temp(t, tmp);
         emit(tmp + " = " + left + ";");
         left_use = tmp;
     }
     if (expr->right && is_extended_integer_type(expr->right->type)) {
         std::string tmp = fresh_temp();
         std::string t = gen_type(expr->right->type);
-        if (!declared_temps.count(tmp)) {
-            emit(storage_prefix() + t + " " + tmp + ";");
-            declared_temps.insert(tmp);
-        }
+        declare_temp(t, tmp);
         emit(tmp + " = " + right + ";");
         right_use = tmp;
     }
-    const std::string& op = expr->op;
-    if (op == "==" || op == "!=" || op == "<" || op == "<=" || op == ">" || op == ">=") {
+    const BinaryOp op = expr->binary_op;
+    if (is_comparison_op(op)) {
         TypePtr cmp_type = expr->left ? expr->left->type : expr->right ? expr->right->type : nullptr;
         bool is_signed = false;
         uint64_t bits = 0;
@@ -577,10 +768,7 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         }
         ensure_extint_type(is_signed, bits);
         std::string cmp_tmp = fresh_temp();
-        if (!declared_temps.count(cmp_tmp)) {
-            emit(storage_prefix() + std::string("int ") + cmp_tmp + ";");
-            declared_temps.insert(cmp_tmp);
-        }
+        declare_temp("int", cmp_tmp);
         std::string cmp_fn = is_signed ? "vx_ai_scmp" : "vx_ai_ucmp";
         std::string args = "(" + left_use + ").b, (" + right_use + ").b, sizeof((" + left_use + ").b)";
         if (is_signed) {
@@ -588,11 +776,8 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         }
         emit(cmp_tmp + " = " + cmp_fn + "(" + args + ");");
         std::string out = fresh_temp();
-        if (!declared_temps.count(out)) {
-            emit(storage_prefix() + std::string("_Bool ") + out + ";");
-            declared_temps.insert(out);
-        }
-        emit(out + " = (" + cmp_tmp + " " + op + " 0);");
+        declare_temp("_Bool", out);
+        emit(out + " = (" + cmp_tmp + " " + expr->op + " 0);");
         return out;
     }
 
@@ -604,10 +789,7 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
     ensure_extint_type(result_signed, result_bits);
     std::string out = fresh_temp();
     std::string out_type = gen_type(expr->type);
-    if (!declared_temps.count(out)) {
-        emit(storage_prefix() + out_type + " " + out + ";");
-        declared_temps.insert(out);
-    }
+    declare_temp(out_type, out);
 
     std::string top_mask = std::to_string(extint_top_mask(result_bits));
     std::string sign_mask = std::to_string(extint_sign_mask(result_bits));
@@ -637,11 +819,11 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
     uint64_t fixed_bits = 0;
     bool fixed_signed = false;
     int64_t fixed_frac = 0;
-    if ((op == "*" || op == "/") &&
+    if ((op == BinaryOp::Mul || op == BinaryOp::Div) &&
         fixed_extint_meta(expr ? expr->type : nullptr, fixed_bits, fixed_signed, fixed_frac) &&
         fixed_frac != 0) {
         uint64_t work_bits = 0;
-        if (op == "*") {
+        if (op == BinaryOp::Mul) {
             work_bits = add_checked_u64(fixed_bits, fixed_bits, "fixed-point multiplication");
             if (fixed_frac < 0) {
                 work_bits = add_checked_u64(work_bits, abs_frac_u64(fixed_frac, "fixed-point multiplication"),
@@ -662,10 +844,7 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         std::string work_sign_mask = std::to_string(extint_sign_mask(work_bits));
         auto declare_work_temp = [&]() {
             std::string tmp = fresh_temp();
-            if (!declared_temps.count(tmp)) {
-                emit(storage_prefix() + work_type + " " + tmp + ";");
-                declared_temps.insert(tmp);
-            }
+            declare_temp(work_type, tmp);
             return tmp;
         };
         std::string lhs_wide = declare_work_temp();
@@ -678,7 +857,7 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
              std::string(fixed_signed ? "1" : "0") + ", " + std::to_string(extint_sign_mask(fixed_bits)) + ");");
 
         std::string scaled = declare_work_temp();
-        if (op == "*") {
+        if (op == BinaryOp::Mul) {
             std::string prod = declare_work_temp();
             emit("vx_ai_mul(" + prod + ".b, (" + lhs_wide + ").b, (" + rhs_wide + ").b, sizeof(" + prod + ".b), " +
                  work_top_mask + ");");
@@ -686,10 +865,7 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
                 uint64_t shift = static_cast<uint64_t>(fixed_frac);
                 if (fixed_signed) {
                     std::string neg = fresh_temp();
-                    if (!declared_temps.count(neg)) {
-                        emit(storage_prefix() + std::string("_Bool ") + neg + ";");
-                        declared_temps.insert(neg);
-                    }
+                    declare_temp("_Bool", neg);
                     std::string abs = declare_work_temp();
                     std::string shr = declare_work_temp();
                     emit(neg + " = vx_ai_signbit(" + prod + ".b, sizeof(" + prod + ".b), " + work_sign_mask + ");");
@@ -737,14 +913,8 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
                 std::string den_abs = declare_work_temp();
                 std::string num_neg = fresh_temp();
                 std::string den_neg = fresh_temp();
-                if (!declared_temps.count(num_neg)) {
-                    emit(storage_prefix() + std::string("_Bool ") + num_neg + ";");
-                    declared_temps.insert(num_neg);
-                }
-                if (!declared_temps.count(den_neg)) {
-                    emit(storage_prefix() + std::string("_Bool ") + den_neg + ";");
-                    declared_temps.insert(den_neg);
-                }
+                declare_temp("_Bool", num_neg);
+                declare_temp("_Bool", den_neg);
                 emit(num_neg + " = vx_ai_signbit(" + num + ".b, sizeof(" + num + ".b), " + work_sign_mask + ");");
                 emit(den_neg + " = vx_ai_signbit(" + den + ".b, sizeof(" + den + ".b), " + work_sign_mask + ");");
                 emit("if (" + num_neg + ") vx_ai_neg(" + num_abs + ".b, " + num + ".b, sizeof(" + num_abs + ".b), " +
@@ -765,33 +935,33 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         return out;
     }
 
-    if (op == "+") {
+    if (op == BinaryOp::Add) {
         emit("vx_ai_add(" + out + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
         return out;
     }
-    if (op == "-") {
+    if (op == BinaryOp::Sub) {
         emit("vx_ai_sub(" + out + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
         return out;
     }
-    if (op == "*") {
+    if (op == BinaryOp::Mul) {
         emit("vx_ai_mul(" + out + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
         return out;
     }
-    if (op == "&") {
+    if (op == BinaryOp::BitAnd) {
         emit("vx_ai_and(" + out + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
         return out;
     }
-    if (op == "|") {
+    if (op == BinaryOp::BitOr) {
         emit("vx_ai_or(" + out + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
         return out;
     }
-    if (op == "^") {
+    if (op == BinaryOp::BitXor) {
         emit("vx_ai_xor(" + out + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
         return out;
     }
-    if (op == "<<" || op == ">>") {
+    if (op == BinaryOp::Shl || op == BinaryOp::Shr) {
         std::string shift_expr = extint_shift_amount_expr(right_use, expr->right ? expr->right->type : nullptr, expr->location);
-        if (op == "<<") {
+        if (op == BinaryOp::Shl) {
             emit("vx_ai_shl(" + out + ".b, (" + left_use + ").b, sizeof(" + out + ".b), " + shift_expr + ", " + top_mask + ");");
         } else if (result_signed) {
             emit("vx_ai_shr_s(" + out + ".b, (" + left_use + ").b, sizeof(" + out + ".b), " + shift_expr + ", " + top_mask + ", " + sign_mask + ");");
@@ -800,18 +970,12 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         }
         return out;
     }
-    if (op == "/" || op == "%") {
+    if (op == BinaryOp::Div || op == BinaryOp::Mod) {
         if (!result_signed) {
-            std::string q = (op == "/") ? out : fresh_temp();
-            std::string r = (op == "%") ? out : fresh_temp();
-            if (q != out && !declared_temps.count(q)) {
-                emit(storage_prefix() + out_type + " " + q + ";");
-                declared_temps.insert(q);
-            }
-            if (r != out && !declared_temps.count(r)) {
-                emit(storage_prefix() + out_type + " " + r + ";");
-                declared_temps.insert(r);
-            }
+            std::string q = (op == BinaryOp::Div) ? out : fresh_temp();
+            std::string r = (op == BinaryOp::Mod) ? out : fresh_temp();
+            if (q != out) declare_temp(out_type, q);
+            if (r != out) declare_temp(out_type, r);
             emit("vx_ai_udivmod(" + q + ".b, " + r + ".b, (" + left_use + ").b, (" + right_use + ").b, sizeof(" + out + ".b), " + top_mask + ");");
             return out;
         }
@@ -821,28 +985,19 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         std::string r_abs = fresh_temp();
         std::string q = fresh_temp();
         std::string rem = fresh_temp();
-        for (const std::string* name : {&l_abs, &r_abs, &q, &rem}) {
-            if (!declared_temps.count(*name)) {
-                emit(storage_prefix() + out_type + " " + *name + ";");
-                declared_temps.insert(*name);
-            }
+        for (std::string* name : {&l_abs, &r_abs, &q, &rem}) {
+            declare_temp(out_type, *name);
         }
         std::string l_neg = fresh_temp();
         std::string r_neg = fresh_temp();
-        if (!declared_temps.count(l_neg)) {
-            emit(storage_prefix() + std::string("_Bool ") + l_neg + ";");
-            declared_temps.insert(l_neg);
-        }
-        if (!declared_temps.count(r_neg)) {
-            emit(storage_prefix() + std::string("_Bool ") + r_neg + ";");
-            declared_temps.insert(r_neg);
-        }
+        declare_temp("_Bool", l_neg);
+        declare_temp("_Bool", r_neg);
         emit(l_neg + " = vx_ai_signbit((" + left_use + ").b, sizeof(" + out + ".b), " + sign_mask + ");");
         emit(r_neg + " = vx_ai_signbit((" + right_use + ").b, sizeof(" + out + ".b), " + sign_mask + ");");
         emit("if (" + l_neg + ") vx_ai_neg(" + l_abs + ".b, (" + left_use + ").b, sizeof(" + l_abs + ".b), " + top_mask + "); else " + l_abs + " = " + left_use + ";");
         emit("if (" + r_neg + ") vx_ai_neg(" + r_abs + ".b, (" + right_use + ").b, sizeof(" + r_abs + ".b), " + top_mask + "); else " + r_abs + " = " + right_use + ";");
         emit("vx_ai_udivmod(" + q + ".b, " + rem + ".b, " + l_abs + ".b, " + r_abs + ".b, sizeof(" + q + ".b), " + top_mask + ");");
-        if (op == "/") {
+        if (op == BinaryOp::Div) {
             emit(out + " = " + q + ";");
             emit("if (" + l_neg + " != " + r_neg + ") vx_ai_neg(" + out + ".b, " + out + ".b, sizeof(" + out + ".b), " + top_mask + ");");
         } else {
@@ -852,14 +1007,100 @@ std::string CodeGenerator::gen_extint_binary(ExprPtr expr, const std::string& le
         return out;
     }
 
-    throw CompileError("Unsupported binary operator '" + op + "' for arbitrary-width integer", expr->location);
+    throw CompileError("Unsupported binary operator '" + expr->op + "' for arbitrary-width integer", expr->location);
+}
+
+std::string CodeGenerator::gen_fixed_native64_muldiv_wide(TypePtr fixed_type,
+                                                          const std::string& left,
+                                                          const std::string& right,
+                                                          BinaryOp op) {
+    if (extint_lowering == ExtIntLowering::Bytes) return "";
+    if (op != BinaryOp::Mul && op != BinaryOp::Div && op != BinaryOp::Mod) return "";
+    const bool fixed_signed = (fixed_type->primitive == PrimitiveType::FixedInt);
+    const int64_t frac = fixed_type->fractional_bits;
+    // Division shifts one operand left by |frac| before dividing; past this
+    // the shifted operand no longer fits 128 bits and the byte runtime
+    // handles it.
+    const int64_t max_div_shift = fixed_signed ? 63 : 64;
+    if (op == BinaryOp::Div && (frac > max_div_shift || frac < -max_div_shift)) return "";
+
+    auto declare_native_temp = [&](const std::string& type) {
+        std::string name = fresh_temp();
+        declare_temp(type, name);
+        return name;
+    };
+
+    const std::string raw_type = fixed_signed ? "int64_t" : "uint64_t";
+    const std::string out_type = gen_type(fixed_type);
+    std::string l = declare_native_temp(raw_type);
+    std::string r = declare_native_temp(raw_type);
+    emit(l + " = (" + raw_type + ")(" + left + ");");
+    emit(r + " = (" + raw_type + ")(" + right + ");");
+    std::string out = declare_native_temp(out_type);
+
+    if (op == BinaryOp::Mod) {
+        // The remainder never exceeds the operands, so 64-bit % suffices
+        // once INT64_MIN % -1 is ruled out.
+        emit("if (" + r + " == 0) abort();");
+        if (fixed_signed) {
+            emit(out + " = (" + out_type + ")((" + r + " == -1) ? 0 : " + l + " % " + r + ");");
+        } else {
+            emit(out + " = (" + out_type + ")(" + l + " % " + r + ");");
+        }
+        return out;
+    }
+
+    if (op == BinaryOp::Mul && frac <= 0) {
+        // Only the low 64 bits of product << -frac survive truncation.
+        uint64_t k = static_cast<uint64_t>(-frac);
+        if (k >= 64) {
+            emit(out + " = (" + out_type + ")0;");
+        } else {
+            emit(out + " = (" + out_type + ")(((uint64_t)" + l + " * (uint64_t)" + r + ") << " +
+                 std::to_string(k) + ");");
+        }
+        return out;
+    }
+
+    const std::string wide_type = wide_native_type_name(fixed_signed, 128);
+    const std::string wide_utype = wide_native_type_name(false, 128);
+    if (op == BinaryOp::Mul) {
+        std::string prod = declare_native_temp(wide_type);
+        emit(prod + " = (" + wide_type + ")" + l + " * (" + wide_type + ")" + r + ";");
+        if (frac >= 128) {
+            emit(out + " = (" + out_type + ")0;");
+        } else if (fixed_signed) {
+            // Shift the magnitude so the product rounds toward zero.
+            std::string mag = declare_native_temp(wide_utype);
+            emit(mag + " = (" + prod + " < 0) ? -(" + wide_utype + ")" + prod + " : (" + wide_utype + ")" + prod +
+                 ";");
+            emit(mag + " >>= " + std::to_string(frac) + ";");
+            emit(out + " = (" + out_type + ")(uint64_t)((" + prod + " < 0) ? -" + mag + " : " + mag + ");");
+        } else {
+            emit(out + " = (" + out_type + ")(uint64_t)(" + prod + " >> " + std::to_string(frac) + ");");
+        }
+        return out;
+    }
+
+    std::string num = declare_native_temp(wide_type);
+    std::string den = declare_native_temp(wide_type);
+    emit("if (" + r + " == 0) abort();");
+    emit(num + " = (" + wide_type + ")" + l + ";");
+    emit(den + " = (" + wide_type + ")" + r + ";");
+    if (frac > 0) {
+        emit(num + " = (" + wide_type + ")((" + wide_utype + ")" + num + " << " + std::to_string(frac) + ");");
+    } else if (frac < 0) {
+        emit(den + " = (" + wide_type + ")((" + wide_utype + ")" + den + " << " + std::to_string(-frac) + ");");
+    }
+    emit(out + " = (" + out_type + ")(uint64_t)(" + num + " / " + den + ");");
+    return out;
 }
 
 std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
                                                      TypePtr fixed_type,
                                                      const std::string& left,
                                                      const std::string& right,
-                                                     const std::string& op) {
+                                                     BinaryOp op) {
     if (!fixed_type || fixed_type->kind != Type::Kind::Primitive ||
         (fixed_type->primitive != PrimitiveType::FixedInt &&
          fixed_type->primitive != PrimitiveType::FixedUInt)) {
@@ -872,6 +1113,9 @@ std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
                            expr ? expr->location : SourceLocation());
     }
 
+    std::string native = gen_fixed_native64_muldiv_wide(fixed_type, left, right, op);
+    if (!native.empty()) return native;
+
     const bool fixed_signed = (fixed_type->primitive == PrimitiveType::FixedInt);
     const int64_t fixed_frac = fixed_type->fractional_bits;
     const uint64_t fixed_bits = 64;
@@ -882,18 +1126,12 @@ std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
     auto declare_ext_temp = [&](bool is_signed_tmp, uint64_t bits_tmp) {
         ensure_extint_type(is_signed_tmp, bits_tmp);
         std::string name = fresh_temp();
-        if (!declared_temps.count(name)) {
-            emit(storage_prefix() + extint_type_name(is_signed_tmp, bits_tmp) + " " + name + ";");
-            declared_temps.insert(name);
-        }
+        declare_temp(extint_type_name(is_signed_tmp, bits_tmp), name);
         return name;
     };
     auto declare_bool_temp = [&]() {
         std::string name = fresh_temp();
-        if (!declared_temps.count(name)) {
-            emit(storage_prefix() + std::string("_Bool ") + name + ";");
-            declared_temps.insert(name);
-        }
+        declare_temp("_Bool", name);
         return name;
     };
     auto checked_add_u64 = [&](uint64_t a, uint64_t b, const std::string& context) -> uint64_t {
@@ -925,7 +1163,7 @@ std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
 
     std::string out_raw = declare_ext_temp(fixed_signed, fixed_bits);
 
-    if (op == "%") {
+    if (op == BinaryOp::Mod) {
         if (!fixed_signed) {
             std::string q = declare_ext_temp(false, fixed_bits);
             std::string rem = declare_ext_temp(false, fixed_bits);
@@ -951,9 +1189,9 @@ std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
             emit("if (" + l_neg + ") vx_ai_neg(" + out_raw + ".b, " + out_raw + ".b, sizeof(" + out_raw + ".b), " +
                  fixed_top_mask + ");");
         }
-    } else if (op == "*" || op == "/") {
+    } else if (op == BinaryOp::Mul || op == BinaryOp::Div) {
         uint64_t work_bits = 0;
-        if (op == "*") {
+        if (op == BinaryOp::Mul) {
             work_bits = checked_add_u64(fixed_bits, fixed_bits, "fixed-point multiplication");
             if (fixed_frac < 0) {
                 work_bits = checked_add_u64(work_bits, abs_frac_u64(fixed_frac, "fixed-point multiplication"),
@@ -981,7 +1219,7 @@ std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
              std::string(fixed_signed ? "1" : "0") + ", " + fixed_sign_mask + ");");
 
         std::string scaled = declare_ext_temp(fixed_signed, work_bits);
-        if (op == "*") {
+        if (op == BinaryOp::Mul) {
             std::string prod = declare_ext_temp(fixed_signed, work_bits);
             emit("vx_ai_mul(" + prod + ".b, " + lhs_wide + ".b, " + rhs_wide + ".b, sizeof(" + prod + ".b), " +
                  work_top_mask + ");");
@@ -1053,16 +1291,14 @@ std::string CodeGenerator::gen_fixed_native64_muldiv(ExprPtr expr,
              ", " + scaled + ".b, sizeof(" + scaled + ".b), " +
              std::string(fixed_signed ? "1" : "0") + ", " + work_sign_mask + ");");
     } else {
-        throw CompileError("Internal error: unsupported fixed native64 mul/div/mod operator '" + op + "'",
+        throw CompileError("Internal error: unsupported fixed native64 mul/div/mod operator '" +
+                               (expr ? expr->op.str() : std::string()) + "'",
                            loc);
     }
 
     std::string out_native = fresh_temp();
     std::string out_native_type = gen_type(fixed_type);
-    if (!declared_temps.count(out_native)) {
-        emit(storage_prefix() + out_native_type + " " + out_native + ";");
-        declared_temps.insert(out_native);
-    }
+    declare_temp(out_native_type, out_native);
     if (fixed_signed) {
         emit(out_native + " = (" + out_native_type + ")vx_ai_to_i64_trunc(" + out_raw + ".b, sizeof(" + out_raw +
              ".b), " + fixed_sign_mask + ");");
@@ -1126,19 +1362,13 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
     };
     auto declare_bool_temp = [&]() {
         std::string name = fresh_temp();
-        if (!declared_temps.count(name)) {
-            emit(storage_prefix() + std::string("_Bool ") + name + ";");
-            declared_temps.insert(name);
-        }
+        declare_temp("_Bool", name);
         return name;
     };
     auto declare_ext_temp = [&](bool is_signed_tmp, uint64_t bits_tmp) {
         ensure_extint_type(is_signed_tmp, bits_tmp);
         std::string tmp = fresh_temp();
-        if (!declared_temps.count(tmp)) {
-            emit(storage_prefix() + extint_type_name(is_signed_tmp, bits_tmp) + " " + tmp + ";");
-            declared_temps.insert(tmp);
-        }
+        declare_temp(extint_type_name(is_signed_tmp, bits_tmp), tmp);
         return tmp;
     };
     auto emit_ext_cast = [&](const std::string& out,
@@ -1212,14 +1442,49 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
                tmp + ".b, sizeof(" + tmp + ".b)))";
     };
 
+    // A natively lowered wide integer meets the byte runtime only here: its
+    // value crosses as little-endian bytes of its own width.
+    bool wide_signed = false;
+    uint64_t wide_bits = 0;
+    if (dst_ext && is_wide_native_integer_type(source_type, wide_signed, wide_bits)) {
+        std::string wide_type = wide_native_type_name(wide_signed, wide_bits);
+        std::string wide_utype = wide_native_type_name(false, wide_bits);
+        std::string value = fresh_temp();
+        declare_temp(wide_type, value);
+        emit(value + " = " + operand + ";");
+        std::string bytes = declare_ext_temp(wide_signed, wide_bits);
+        for (uint64_t i = 0; i < (wide_bits + 7u) / 8u; ++i) {
+            emit(bytes + ".b[" + std::to_string(i) + "] = (unsigned char)((" + wide_utype + ")" + value +
+                 " >> " + std::to_string(8u * i) + ");");
+        }
+        std::string out = declare_ext_temp(dst_signed, dst_bits);
+        emit_ext_cast(out, dst_signed, dst_bits, bytes, wide_signed, wide_bits);
+        return out;
+    }
+    if (src_ext && is_wide_native_integer_type(target_type, wide_signed, wide_bits)) {
+        std::string wide_type = wide_native_type_name(wide_signed, wide_bits);
+        std::string wide_utype = wide_native_type_name(false, wide_bits);
+        std::string in = fresh_temp();
+        declare_temp(gen_type(source_type), in);
+        emit(in + " = " + operand + ";");
+        std::string bytes = declare_ext_temp(wide_signed, wide_bits);
+        emit_ext_cast(bytes, wide_signed, wide_bits, in, src_signed, src_bits);
+        std::string acc = fresh_temp();
+        declare_temp(wide_utype, acc);
+        uint64_t top = (wide_bits + 7u) / 8u - 1u;
+        emit(acc + " = (" + wide_utype + ")" + bytes + ".b[" + std::to_string(top) + "];");
+        for (uint64_t i = top; i > 0; --i) {
+            emit(acc + " = (" + wide_utype + ")((" + acc + " << 8) | " + bytes + ".b[" + std::to_string(i - 1u) +
+                 "]);");
+        }
+        return "((" + wide_type + ")" + acc + ")";
+    }
+
     std::string operand_use = operand;
     if (src_ext) {
         std::string tmp = fresh_temp();
         std::string t = gen_type(source_type);
-        if (!declared_temps.count(tmp)) {
-            emit(storage_prefix() + t + " " + tmp + ";");
-            declared_temps.insert(tmp);
-        }
+        declare_temp(t, tmp);
         emit(tmp + " = " + operand + ";");
         operand_use = tmp;
     }
@@ -1246,10 +1511,7 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
         if (!src_ext) {
             std::string src_tmp = fresh_temp();
             std::string src_type = gen_type(source_type);
-            if (!declared_temps.count(src_tmp)) {
-                emit(storage_prefix() + src_type + " " + src_tmp + ";");
-                declared_temps.insert(src_tmp);
-            }
+            declare_temp(src_type, src_tmp);
             emit(src_tmp + " = " + operand + ";");
             scalar_source = src_tmp;
         }
@@ -1377,10 +1639,7 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
 
         if (is_float(target_type->primitive)) {
             std::string out_tmp = fresh_temp();
-            if (!declared_temps.count(out_tmp)) {
-                emit(storage_prefix() + gen_type(target_type) + " " + out_tmp + ";");
-                declared_temps.insert(out_tmp);
-            }
+            declare_temp(gen_type(target_type), out_tmp);
             emit(out_tmp + " = (" + gen_type(target_type) + ")ldexp(" +
                  ext_to_double_expr(src_raw, src_fixed_signed, src_fixed_bits) + ", " +
                  std::to_string(-src_fixed_frac) + ");");
@@ -1422,10 +1681,7 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
         ensure_extint_type(dst_signed, dst_bits);
         std::string out = fresh_temp();
         std::string out_type = gen_type(target_type);
-        if (!declared_temps.count(out)) {
-            emit(storage_prefix() + out_type + " " + out + ";");
-            declared_temps.insert(out);
-        }
+        declare_temp(out_type, out);
         if (src_ext) {
             ensure_extint_type(src_signed, src_bits);
             emit("vx_ai_cast(" + out + ".b, sizeof(" + out + ".b), " + std::to_string(extint_top_mask(dst_bits)) +
@@ -1443,10 +1699,7 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
         if (src_ty->kind == Type::Kind::Primitive && is_float(src_ty->primitive)) {
             std::string src_tmp = fresh_temp();
             std::string src_type = gen_type(src_ty);
-            if (!declared_temps.count(src_tmp)) {
-                emit(storage_prefix() + src_type + " " + src_tmp + ";");
-                declared_temps.insert(src_tmp);
-            }
+            declare_temp(src_type, src_tmp);
             emit(src_tmp + " = " + operand + ";");
             emit("vx_ai_from_double_u(" + out + ".b, sizeof(" + out + ".b), " + std::to_string(extint_top_mask(dst_bits)) +
                  ", fabs((double)" + src_tmp + "));");
@@ -1492,10 +1745,7 @@ std::string CodeGenerator::gen_extint_cast(ExprPtr expr, const std::string& oper
             if (src_signed) {
                 std::string tmp = fresh_temp();
                 std::string ttype = extint_type_name(true, src_bits);
-                if (!declared_temps.count(tmp)) {
-                    emit(storage_prefix() + ttype + " " + tmp + ";");
-                    declared_temps.insert(tmp);
-                }
+                declare_temp(ttype, tmp);
                 emit(tmp + " = " + operand_use + ";");
                 emit("if (vx_ai_signbit(" + tmp + ".b, sizeof(" + tmp + ".b), " + std::to_string(extint_sign_mask(src_bits)) +
                      ")) vx_ai_neg(" + tmp + ".b, " + tmp + ".b, sizeof(" + tmp + ".b), " + std::to_string(extint_top_mask(src_bits)) + ");");
@@ -1514,7 +1764,7 @@ std::string CodeGenerator::gen_extint_assignment(ExprPtr expr,
                                                  TypePtr lhs_type,
                                                  const std::string& lhs,
                                                  const std::string& rhs,
-                                                 const std::string& assign_op) {
+                                                 AssignOp assign_op) {
     bool is_signed = false;
     uint64_t bits = 0;
     if (!analyze_extint_type(lhs_type, is_signed, bits)) {
@@ -1534,31 +1784,25 @@ std::string CodeGenerator::gen_extint_assignment(ExprPtr expr,
 
     auto copy_result = [&]() -> std::string {
         std::string result_tmp = fresh_temp();
-        if (!declared_temps.count(result_tmp)) {
-            emit(storage_prefix() + lhs_type_str + " " + result_tmp + ";");
-            declared_temps.insert(result_tmp);
-        }
+        declare_temp(lhs_type_str, result_tmp);
         emit(result_tmp + " = *" + lhs_ptr + ";");
         return result_tmp;
     };
 
-    if (assign_op == "=") {
+    if (assign_op == AssignOp::Assign) {
         emit("*" + lhs_ptr + " = " + rhs + ";");
         return copy_result();
     }
     std::string lhs_val = fresh_temp();
-    if (!declared_temps.count(lhs_val)) {
-        emit(storage_prefix() + lhs_type_str + " " + lhs_val + ";");
-        declared_temps.insert(lhs_val);
-    }
+    declare_temp(lhs_type_str, lhs_val);
     emit(lhs_val + " = *" + lhs_ptr + ";");
     const bool lhs_is_fixed = lhs_type &&
                               lhs_type->kind == Type::Kind::Primitive &&
                               (lhs_type->primitive == PrimitiveType::FixedInt ||
                                lhs_type->primitive == PrimitiveType::FixedUInt);
     const int64_t lhs_frac = lhs_is_fixed ? lhs_type->fractional_bits : 0;
-    if ((assign_op == "*=" || assign_op == "/=") && lhs_is_fixed && lhs_frac != 0) {
-        std::string op = (assign_op == "*=") ? "*" : "/";
+    if ((assign_op == AssignOp::Mul || assign_op == AssignOp::Div) && lhs_is_fixed && lhs_frac != 0) {
+        std::string op = (assign_op == AssignOp::Mul) ? "*" : "/";
         auto fake = Expr::make_binary(op, expr ? expr->left : nullptr, expr ? expr->right : nullptr,
                                       expr ? expr->location : SourceLocation());
         fake->type = lhs_type;
@@ -1566,37 +1810,37 @@ std::string CodeGenerator::gen_extint_assignment(ExprPtr expr,
         emit("*" + lhs_ptr + " = " + value + ";");
         return copy_result();
     }
-    if (assign_op == "+=") {
+    if (assign_op == AssignOp::Add) {
         emit("vx_ai_add(" + lhs_ptr + "->b, " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == "-=") {
+    if (assign_op == AssignOp::Sub) {
         emit("vx_ai_sub(" + lhs_ptr + "->b, " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == "*=") {
+    if (assign_op == AssignOp::Mul) {
         emit("vx_ai_mul(" + lhs_ptr + "->b, " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == "&=") {
+    if (assign_op == AssignOp::BitAnd) {
         emit("vx_ai_and(" + lhs_ptr + "->b, " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == "|=") {
+    if (assign_op == AssignOp::BitOr) {
         emit("vx_ai_or(" + lhs_ptr + "->b, " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == "^=") {
+    if (assign_op == AssignOp::BitXor) {
         emit("vx_ai_xor(" + lhs_ptr + "->b, " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == "<<=") {
+    if (assign_op == AssignOp::Shl) {
         std::string sh = extint_shift_amount_expr(rhs, expr && expr->right ? expr->right->type : nullptr,
                                                   expr ? expr->location : SourceLocation());
         emit("vx_ai_shl(" + lhs_ptr + "->b, " + lhs_val + ".b, sizeof(" + lhs_ptr + "->b), " + sh + ", " + top_mask + ");");
         return copy_result();
     }
-    if (assign_op == ">>=") {
+    if (assign_op == AssignOp::Shr) {
         std::string sh = extint_shift_amount_expr(rhs, expr && expr->right ? expr->right->type : nullptr,
                                                   expr ? expr->location : SourceLocation());
         if (is_signed) {
@@ -1606,32 +1850,26 @@ std::string CodeGenerator::gen_extint_assignment(ExprPtr expr,
         }
         return copy_result();
     }
-    if (assign_op == "/=" || assign_op == "%=") {
-        std::string q = (assign_op == "/=") ? "*"+lhs_ptr : fresh_temp();
-        std::string r = (assign_op == "%=") ? "*"+lhs_ptr : fresh_temp();
-        if (q != "*"+lhs_ptr && !declared_temps.count(q)) {
-            emit(storage_prefix() + lhs_type_str + " " + q + ";");
-            declared_temps.insert(q);
-        }
-        if (r != "*"+lhs_ptr && !declared_temps.count(r)) {
-            emit(storage_prefix() + lhs_type_str + " " + r + ";");
-            declared_temps.insert(r);
-        }
+    if (assign_op == AssignOp::Div || assign_op == AssignOp::Mod) {
+        std::string q = (assign_op == AssignOp::Div) ? "*"+lhs_ptr : fresh_temp();
+        std::string r = (assign_op == AssignOp::Mod) ? "*"+lhs_ptr : fresh_temp();
+        if (q != "*"+lhs_ptr) declare_temp(lhs_type_str, q);
+        if (r != "*"+lhs_ptr) declare_temp(lhs_type_str, r);
         if (!is_signed) {
-            std::string q_expr = (assign_op == "/=") ? lhs_ptr + "->b" : q + ".b";
-            std::string r_expr = (assign_op == "%=") ? lhs_ptr + "->b" : r + ".b";
+            std::string q_expr = (assign_op == AssignOp::Div) ? lhs_ptr + "->b" : q + ".b";
+            std::string r_expr = (assign_op == AssignOp::Mod) ? lhs_ptr + "->b" : r + ".b";
             emit("vx_ai_udivmod(" + q_expr + ", " + r_expr + ", " + lhs_val + ".b, (" + rhs + ").b, sizeof(" + lhs_ptr + "->b), " + top_mask + ");");
             return copy_result();
         }
         // Signed /= and %= reuse binary path by computing and assigning.
-        std::string op = (assign_op == "/=") ? "/" : "%";
+        std::string op = (assign_op == AssignOp::Div) ? "/" : "%";
         auto fake = Expr::make_binary(op, expr ? expr->left : nullptr, expr ? expr->right : nullptr, expr ? expr->location : SourceLocation());
         fake->type = lhs_type;
         std::string value = gen_extint_binary(fake, lhs_val, rhs);
         emit("*" + lhs_ptr + " = " + value + ";");
         return copy_result();
     }
-    throw CompileError("Unsupported compound assignment '" + assign_op + "' for arbitrary-width integer", expr ? expr->location : SourceLocation());
+    throw CompileError("Unsupported compound assignment '" + (expr ? expr->op.str() : std::string()) + "' for arbitrary-width integer", expr ? expr->location : SourceLocation());
 }
 
 std::string CodeGenerator::gen_extint_conditional(ExprPtr expr,
@@ -1644,10 +1882,7 @@ std::string CodeGenerator::gen_extint_conditional(ExprPtr expr,
     }
     std::string temp = fresh_temp();
     std::string t = gen_type(expr->type);
-    if (!declared_temps.count(temp)) {
-        emit(storage_prefix() + t + " " + temp + ";");
-        declared_temps.insert(temp);
-    }
+    declare_temp(t, temp);
     emit("if (" + cond + ") {");
     emit(temp + " = " + true_expr + ";");
     emit("} else {");
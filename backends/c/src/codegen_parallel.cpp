@@ -0,0 +1,248 @@
+#include "codegen.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+namespace vexel::c_backend_codegen {
+
+// Parallel emission hands every reachable function variant to worker
+// generators and emits the remaining top-level statements (globals) on the
+// main generator, merging both back in source order.
+//
+// Function text only depends on read-only inputs (the analyzed program, facts
+// and type tables) plus prelude entries shared by all functions: comparators,
+// pooled rodata literals and wide-integer typedefs. Their names, offsets and
+// header order come from creation order, so workers do not create them. A
+// worker logs each first use and writes a placeholder where the name or offset
+// goes; the merge replays a function's log on the main generator before its
+// text, which creates entries exactly when serial emission would, then
+// substitutes the placeholders. The output is byte-identical to serial.
+//
+// Variants are split into contiguous chunks, one worker generator per chunk.
+// A chunk stops at its first failing variant; the merge rethrows that error
+// when it reaches the variant, so the first error in source order wins.
+
+namespace {
+
+constexpr char kPlaceholderMark = '\x1d';  // never emitted raw: literals escape control bytes
+constexpr size_t kChunksPerWorker = 4;
+
+std::string resolve_placeholders(const std::string& code, const std::vector<std::string>& resolved) {
+    size_t start = code.find(kPlaceholderMark);
+    if (start == std::string::npos) return code;
+    std::string out;
+    out.reserve(code.size());
+    size_t pos = 0;
+    while (start != std::string::npos) {
+        size_t end = code.find(kPlaceholderMark, start + 1);
+        if (end == std::string::npos) {
+            throw CompileError("Internal error: unterminated placeholder in parallel C codegen", SourceLocation());
+        }
+        out.append(code, pos, start - pos);
+        out += resolved[std::stoul(code.substr(start + 1, end - start - 1))];
+        pos = end + 1;
+        start = code.find(kPlaceholderMark, pos);
+    }
+    out.append(code, pos, std::string::npos);
+    return out;
+}
+
+} // namespace
+
+struct CodeGenerator::ParallelFunctionTask {
+    int instance_id = -1;
+    StmtPtr stmt;
+    std::string ref_key;
+    char reent_key = 'N';
+    // Filled by the worker.
+    std::string code;
+    std::vector<GeneratedFunctionInfo> functions;
+    std::string slot_decls;
+    size_t events_end = 0;  // this variant's events are [previous end, events_end)
+    // Per-function state a variant leaves behind, which the next global
+    // initializer emitted after it still sees.
+    int temp_counter = 0;
+    std::stack<std::string> available_temps;
+    std::unordered_set<std::string> live_temps;
+    std::unordered_set<std::string> declared_temps;
+    std::unordered_set<std::string> ref_params;
+};
+
+struct CodeGenerator::ParallelFunctionChunk {
+    size_t first_task = 0;
+    size_t task_count = 0;
+    size_t completed = 0;
+    std::exception_ptr error;  // thrown by task first_task + completed
+    std::vector<SharedStateEvent> events;
+    std::unordered_map<std::string, std::vector<TypePtr>> tuple_types;
+    std::vector<std::string> resolved;  // placeholder -> final text, filled by the merge
+};
+
+std::string CodeGenerator::shared_state_placeholder(size_t index) {
+    return kPlaceholderMark + std::to_string(index) + kPlaceholderMark;
+}
+
+std::string CodeGenerator::defer_shared_state(SharedStateEvent event) {
+    event.instance_id = current_instance_id;
+    shared_state_events.push_back(std::move(event));
+    return shared_state_placeholder(shared_state_events.size() - 1);
+}
+
+void CodeGenerator::run_parallel_chunk(std::vector<ParallelFunctionTask>& tasks,
+                                       ParallelFunctionChunk& chunk) const {
+    CodeGenerator worker;
+    worker.analyzed_program = analyzed_program;
+    worker.facts = facts;
+    worker.optimization = optimization;
+    worker.abi = abi;
+    worker.entry_instance_id = entry_instance_id;
+    worker.extint_lowering = extint_lowering;
+    worker.loop_vectorization = loop_vectorization;
+    worker.frame_allocation = frame_allocation;
+    worker.profile_output = profile_output;
+    worker.execution_profile = execution_profile;
+    worker.cold_nonreentrant_functions = cold_nonreentrant_functions;
+    worker.pool_rodata_literals = pool_rodata_literals;
+    worker.type_map = type_map;
+    worker.type_decl_map = type_decl_map;
+    worker.tuple_types = tuple_types;
+    worker.deferred_shared_state = true;
+    try {
+        for (size_t i = chunk.first_task; i < chunk.first_task + chunk.task_count; ++i) {
+            ParallelFunctionTask& task = tasks[i];
+            worker.current_instance_id = task.instance_id;
+            worker.gen_func_decl(task.stmt, task.ref_key, task.reent_key);
+            task.code = worker.body.str();
+            worker.body.str("");
+            worker.body.clear();
+            task.functions = std::move(worker.generated_functions);
+            worker.generated_functions.clear();
+            task.slot_decls = std::move(worker.promoted_slot_decls);
+            worker.promoted_slot_decls.clear();
+            task.events_end = worker.shared_state_events.size();
+            task.temp_counter = worker.temp_counter;
+            task.available_temps = worker.available_temps;
+            task.live_temps = worker.live_temps;
+            task.declared_temps = worker.declared_temps;
+            task.ref_params = worker.current_ref_params;
+            ++chunk.completed;
+        }
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+    chunk.events = std::move(worker.shared_state_events);
+    chunk.tuple_types = std::move(worker.tuple_types);
+}
+
+void CodeGenerator::gen_top_level_parallel(const std::vector<std::pair<int, StmtPtr>>& items) {
+    // Function declarations own a (possibly empty) task range; anything else
+    // is emitted by this generator during the merge.
+    struct Slot {
+        bool is_function = false;
+        size_t task_begin = 0;
+        size_t task_end = 0;
+    };
+    std::vector<ParallelFunctionTask> tasks;
+    std::vector<Slot> slots(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const StmtPtr& stmt = items[i].second;
+        Slot& slot = slots[i];
+        slot.task_begin = tasks.size();
+        if (stmt->kind == Stmt::Kind::FuncDecl) {
+            slot.is_function = true;
+            current_instance_id = items[i].first;
+            Symbol* sym = binding_for(stmt);
+            if (sym && sym->kind == Symbol::Kind::Function) {
+                for (char reent_key : reentrancy_keys_for(sym)) {
+                    for (const auto& ref_key : ref_variant_keys_for(stmt)) {
+                        ParallelFunctionTask task;
+                        task.instance_id = items[i].first;
+                        task.stmt = stmt;
+                        task.ref_key = ref_key;
+                        task.reent_key = reent_key;
+                        tasks.push_back(std::move(task));
+                    }
+                }
+            }
+        }
+        slot.task_end = tasks.size();
+    }
+
+    const size_t max_chunks = static_cast<size_t>(parallel_workers) * kChunksPerWorker;
+    const size_t chunk_size = tasks.empty() ? 1 : (tasks.size() + max_chunks - 1) / max_chunks;
+    std::vector<ParallelFunctionChunk> chunks((tasks.size() + chunk_size - 1) / chunk_size);
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        chunks[c].first_task = c * chunk_size;
+        chunks[c].task_count = std::min(chunk_size, tasks.size() - chunks[c].first_task);
+    }
+    {
+        ThreadPool pool(parallel_workers);
+        for (auto& chunk : chunks) {
+            pool.submit([this, &tasks, &chunk]() { run_parallel_chunk(tasks, chunk); });
+        }
+        pool.wait();
+    }
+    for (auto& chunk : chunks) {
+        chunk.resolved.resize(chunk.events.size());
+        for (auto& pair : chunk.tuple_types) {
+            tuple_types.emplace(pair.first, std::move(pair.second));
+        }
+    }
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Slot& slot = slots[i];
+        if (!slot.is_function) {
+            current_instance_id = items[i].first;
+            gen_stmt(items[i].second);
+            flush_body_to_sink();
+            continue;
+        }
+        for (size_t t = slot.task_begin; t < slot.task_end; ++t) {
+            ParallelFunctionChunk& chunk = chunks[t / chunk_size];
+            const size_t local = t - chunk.first_task;
+            if (local >= chunk.completed) {
+                std::rethrow_exception(chunk.error);
+            }
+            ParallelFunctionTask& task = tasks[t];
+            const size_t events_begin = local == 0 ? 0 : tasks[t - 1].events_end;
+            for (size_t e = events_begin; e < task.events_end; ++e) {
+                const SharedStateEvent& event = chunk.events[e];
+                current_instance_id = event.instance_id;
+                switch (event.kind) {
+                    case SharedStateEvent::Kind::ExtInt:
+                        ensure_extint_type(event.is_signed, event.bits);
+                        break;
+                    case SharedStateEvent::Kind::WideNative:
+                        wide_native_type_name(event.is_signed, event.bits);
+                        break;
+                    case SharedStateEvent::Kind::Comparator:
+                        chunk.resolved[e] = event.equality ? ensure_equality(event.type)
+                                                            : ensure_comparator(event.type);
+                        break;
+                    case SharedStateEvent::Kind::Rodata:
+                        chunk.resolved[e] = gen_string_literal(event.text);
+                        break;
+                }
+            }
+            std::string code = resolve_placeholders(task.code, chunk.resolved);
+            if (task.functions.size() != 1 || !alias_identical_variant(task.functions.front(), code)) {
+                for (auto& info : task.functions) {
+                    info.code = (streaming_body && !abi.multi_file_globals) ? std::string() : code;
+                    generated_functions.push_back(std::move(info));
+                }
+                body << code;
+            }
+            promoted_slot_decls += task.slot_decls;
+            temp_counter = task.temp_counter;
+            available_temps = std::move(task.available_temps);
+            live_temps = std::move(task.live_temps);
+            declared_temps = std::move(task.declared_temps);
+            current_ref_params = std::move(task.ref_params);
+        }
+        flush_body_to_sink();
+    }
+}
+
+} // namespace vexel::c_backend_codegen
@@ -1,5 +1,7 @@
 #include "codegen.h"
+#include "c_profile.h"
 #include "analysis.h"
+#include "ast_walk.h"
 #include "expr_access.h"
 #include "function_key.h"
 #include "optimizer.h"
@@ -10,7 +12,11 @@
 #include <functional>
 #include <iomanip>
 #include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <tuple>
 #include <sstream>
@@ -61,6 +67,19 @@ bool is_std_math_macro_builtin_name_impl(const std::string& runtime_name) {
     return runtime_name == "isnan" || runtime_name == "isinf" || runtime_name == "isfinite";
 }
 
+// Bundled std::print externs the backend implements itself, by C name.
+const std::pair<const char*, const char*> kStdPrintBuiltins[] = {
+    {"print_buffer_byte", "vx_std_print_byte"},
+    {"print_buffer_flush", "vx_std_print_flush"},
+};
+
+std::string std_print_runtime_name(const std::string& name) {
+    for (const auto& builtin : kStdPrintBuiltins) {
+        if (name == builtin.first) return builtin.second;
+    }
+    return "";
+}
+
 bool is_std_bits_builtin_name_impl(const std::string& runtime_name) {
     static const std::unordered_set<std::string> kNames = {
         "f32_as_u32",
@@ -74,6 +93,136 @@ bool is_std_bits_builtin_name_impl(const std::string& runtime_name) {
 } // namespace
 
 namespace vexel::c_backend_codegen {
+
+namespace {
+
+// Literals at least this long are pooled into the rodata blob; shorter ones
+// stay inline where they read better in the generated code.
+constexpr size_t kRodataLiteralMinBytes = 256;
+// Raw bytes per source line of the blob initializer.
+constexpr size_t kRodataLineBytes = 96;
+
+} // namespace
+
+std::string format_c_double(double value) {
+    if (std::isnan(value)) return "NAN";
+    if (std::isinf(value)) return value < 0 ? "(-INFINITY)" : "INFINITY";
+    char buf[40];
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+        if (std::strtod(buf, nullptr) == value) break;
+    }
+    std::string out(buf);
+    if (out.find_first_of(".e") == std::string::npos) out += ".0";
+    return out;
+}
+
+std::string packed_table_initializer(const CTArray& table) {
+    std::string out;
+    out.reserve(table.size() * 12 + 2);
+    out += '{';
+    char buf[32];
+    auto append_word = [&](auto value) {
+        const auto done = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, done.ptr);
+    };
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (i > 0) out += ", ";
+        switch (table.storage()) {
+            case CTArray::Storage::Bytes:
+                append_word(static_cast<unsigned>(table.byte_lane()[i]));
+                break;
+            case CTArray::Storage::Bool:
+                out += table.byte_lane()[i] != 0 ? '1' : '0';
+                break;
+            case CTArray::Storage::UInt64:
+                append_word(table.word_lane()[i]);
+                break;
+            case CTArray::Storage::Int64:
+                append_word(static_cast<int64_t>(table.word_lane()[i]));
+                break;
+            case CTArray::Storage::Float64: {
+                double value = 0.0;
+                std::memcpy(&value, &table.word_lane()[i], sizeof(value));
+                out += format_c_double(value);
+                break;
+            }
+            case CTArray::Storage::Range:
+                append_word(std::get<int64_t>(table.at(i)));
+                break;
+            default:
+                throw CompileError("Internal error: packed table initializer on generic array storage",
+                                   SourceLocation());
+        }
+    }
+    out += '}';
+    return out;
+}
+
+std::string escape_c_string(std::string_view input) {
+    std::string out;
+    out.reserve(input.size() + input.size() / 8);
+    for (unsigned char c : input) {
+        switch (c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '"':
+                out += "\\\"";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (c >= 0x20 && c <= 0x7e) {
+                    out.push_back(static_cast<char>(c));
+                } else {
+                    out.push_back('\\');
+                    out.push_back(static_cast<char>('0' + ((c >> 6) & 7)));
+                    out.push_back(static_cast<char>('0' + ((c >> 3) & 7)));
+                    out.push_back(static_cast<char>('0' + (c & 7)));
+                }
+                break;
+        }
+    }
+    return out;
+}
+
+std::string CodeGenerator::gen_string_literal(const std::string& value) {
+    if (!pool_rodata_literals || value.size() < kRodataLiteralMinBytes) {
+        return "\"" + escape_c_string(value) + "\"";
+    }
+    if (deferred_shared_state) {
+        // Offsets are only known once the main generator pools the payload;
+        // a worker maps each payload to its placeholder instead.
+        auto it = rodata_offsets.find(value);
+        if (it != rodata_offsets.end()) return shared_state_placeholder(it->second);
+        SharedStateEvent event;
+        event.kind = SharedStateEvent::Kind::Rodata;
+        event.text = value;
+        rodata_offsets.emplace(value, shared_state_events.size());
+        return defer_shared_state(std::move(event));
+    }
+    auto inserted = rodata_offsets.emplace(value, rodata_size);
+    if (inserted.second) {
+        const std::string_view payload(value);
+        for (size_t pos = 0; pos < payload.size(); pos += kRodataLineBytes) {
+            rodata_blob += "    \"";
+            rodata_blob += escape_c_string(payload.substr(pos, kRodataLineBytes));
+            rodata_blob += "\"\n";
+        }
+        rodata_blob += "    \"\\0\"\n";
+        rodata_size += payload.size() + 1;
+    }
+    return "(vx_rodata + " + std::to_string(inserted.first->second) + ")";
+}
+
 std::string CodeGenerator::require_type(TypePtr type, const SourceLocation& loc, const std::string& context) {
     if (!type) {
         throw CompileError("Missing type during code generation: " + context, loc);
@@ -94,6 +243,9 @@ std::string CodeGenerator::gen_type(TypePtr type) {
                         case 32: return "int32_t";
                         case 64: return "int64_t";
                         default:
+                            if (lowers_to_wide_native(true, type->integer_bits)) {
+                                return wide_native_type_name(true, type->integer_bits);
+                            }
                             ensure_extint_type(true, type->integer_bits);
                             return extint_type_name(true, type->integer_bits);
                     }
@@ -104,6 +256,9 @@ std::string CodeGenerator::gen_type(TypePtr type) {
                         case 32: return "uint32_t";
                         case 64: return "uint64_t";
                         default:
+                            if (lowers_to_wide_native(false, type->integer_bits)) {
+                                return wide_native_type_name(false, type->integer_bits);
+                            }
                             ensure_extint_type(false, type->integer_bits);
                             return extint_type_name(false, type->integer_bits);
                     }
@@ -238,6 +393,17 @@ void CodeGenerator::release_temp(const std::string& temp) {
     // Prefer correctness over reuse; Step 8 can reintroduce typed reuse if needed.
 }
 
+void CodeGenerator::declare_temp(const std::string& type, std::string& name, const std::string& dims) {
+    if (current_frame_object.empty()) {
+        if (declared_temps.insert(name).second) emit(storage_prefix() + type + " " + name + dims + ";");
+        return;
+    }
+    const std::string prefix = current_frame_object + ".";
+    if (name.compare(0, prefix.size(), prefix) == 0) return;
+    if (declared_temps.insert(name).second) current_frame_fields.push_back(type + " " + name + dims);
+    name = prefix + name;
+}
+
 void CodeGenerator::emit(const std::string& code) {
     if (output_stack.empty()) {
         output_stack.push(&body);
@@ -249,6 +415,10 @@ void CodeGenerator::emit_header(const std::string& code) {
     header << code << "\n";
 }
 
+std::string CodeGenerator::internal_storage() const {
+    return abi.hidden_internal_linkage ? "VX_INTERNAL " : "static ";
+}
+
 std::string CodeGenerator::storage_prefix() const {
     return current_function_non_reentrant ? "static " : "";
 }
@@ -258,16 +428,290 @@ bool CodeGenerator::use_nonreentrant_frame_abi(bool is_exported) const {
     return current_function_non_reentrant && !is_exported;
 }
 
+bool CodeGenerator::receiver_is_read_only(const Symbol* func_sym, size_t index) const {
+    // Lowered aggregates pass through pointer temps that are not qualified.
+    if (abi.lower_aggregates || !func_sym) return false;
+    auto it = facts->receiver_mutates.find(func_sym);
+    return it != facts->receiver_mutates.end() && index < it->second.size() && !it->second[index];
+}
+
+void CodeGenerator::collect_declared_layout_roots(const StmtPtr& stmt,
+                                                  std::vector<TypePtr>& roots,
+                                                  std::unordered_map<std::string, StmtPtr>& type_decls) {
+    if (stmt->kind == Stmt::Kind::TypeDecl) {
+        type_decls.emplace(stmt->type_decl_name, stmt);
+        return;
+    }
+    if (stmt->kind == Stmt::Kind::FuncDecl && (stmt->is_exported || stmt->is_external)) {
+        for (const auto& param : stmt->params) roots.push_back(param.type);
+        roots.insert(roots.end(), stmt->ref_param_types.begin(), stmt->ref_param_types.end());
+        roots.push_back(stmt->return_type);
+        roots.insert(roots.end(), stmt->return_types.begin(), stmt->return_types.end());
+    } else if (stmt->kind == Stmt::Kind::VarDecl &&
+               (stmt->is_exported || stmt->var_linkage != VarLinkageKind::Normal)) {
+        roots.push_back(stmt->var_type);
+    }
+    // Composite casts reinterpret the object representation.
+    std::function<void(const ExprPtr&)> visit_expr;
+    std::function<void(const StmtPtr&)> visit_stmt;
+    visit_expr = [&](const ExprPtr& expr) {
+        if (!expr) return;
+        if (expr->kind == Expr::Kind::Cast) {
+            roots.push_back(expr->target_type);
+            if (expr->operand) roots.push_back(expr->operand->type);
+        }
+        for_each_expr_child(expr, visit_expr, visit_stmt);
+    };
+    visit_stmt = [&](const StmtPtr& child) { for_each_stmt_child(child, visit_expr, visit_stmt); };
+    visit_stmt(stmt);
+}
+
+void CodeGenerator::pin_declared_layout(TypePtr type, const std::unordered_map<std::string, StmtPtr>& type_decls) {
+    type = resolve_type(type);
+    while (type && type->kind == Type::Kind::Array) {
+        type = resolve_type(type->element_type);
+    }
+    if (!type || type->kind != Type::Kind::Named) return;
+    if (!declared_layout_types.insert(type->type_name).second) return;
+    auto it = type_decls.find(type->type_name);
+    if (it == type_decls.end()) return;
+    for (const auto& field : it->second->fields) {
+        pin_declared_layout(field.type, type_decls);
+    }
+}
+
+size_t CodeGenerator::field_alignment(TypePtr type) {
+    type = resolve_type(type);
+    while (type && type->kind == Type::Kind::Array) {
+        type = resolve_type(type->element_type);
+    }
+    if (!type) return 1;
+    if (type->kind == Type::Kind::Named) {
+        // Nested types are emitted first, so their declarations are known here.
+        size_t align = 1;
+        auto it = type_decl_map.find(type->type_name);
+        if (it != type_decl_map.end()) {
+            for (const auto& field : it->second->fields) {
+                align = std::max(align, field_alignment(field.type));
+            }
+        }
+        return align;
+    }
+    if (type->kind != Type::Kind::Primitive) return 1;
+    switch (type->primitive) {
+        case PrimitiveType::Int:
+        case PrimitiveType::UInt: {
+            uint64_t bits = type->integer_bits;
+            if (bits == 8 || bits == 16 || bits == 32 || bits == 64) return static_cast<size_t>(bits / 8);
+            if (lowers_to_wide_native(type->primitive == PrimitiveType::Int, bits)) {
+                if (extint_lowering == ExtIntLowering::Int128) return 16;
+                return bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4 : 8;  // x86-64 _BitInt
+            }
+            return 1;  // byte-array struct
+        }
+        case PrimitiveType::FixedInt:
+        case PrimitiveType::FixedUInt: {
+            int64_t bits = type_bits(type->primitive, type->integer_bits, type->fractional_bits);
+            if (bits == 8 || bits == 16 || bits == 32 || bits == 64) return static_cast<size_t>(bits / 8);
+            return 1;
+        }
+        case PrimitiveType::F16: return 2;
+        case PrimitiveType::F32: return 4;
+        case PrimitiveType::F64: return 8;
+        case PrimitiveType::Bool: return 1;
+        case PrimitiveType::String: return alignof(const char*);
+    }
+    return 1;
+}
+
+// Receivers the function never mutates (transitively) point to const. A
+// variant whose only pointer parameter is its sole route to memory the caller
+// can see (no mutable global is read or written) marks it restrict. Pointer
+// parameters other than strings are never null. Reentrant variants that
+// return a value get pure when they write nothing the caller can observe,
+// and const when they also read nothing but their scalar arguments and
+// constants. Frame-ABI variants communicate through static slots and get none.
+CodeGenerator::SignatureQualifiers CodeGenerator::signature_qualifiers(StmtPtr stmt,
+                                                                       const Symbol* sym,
+                                                                       const std::string& ref_key,
+                                                                       char reent_key,
+                                                                       bool frame_abi,
+                                                                       bool returns_value,
+                                                                       bool returns_aggregate) {
+    SignatureQualifiers quals;
+    std::vector<size_t> pointer_params;
+    bool has_string_param = false;
+    for (size_t i = 0; i < stmt->ref_params.size(); i++) {
+        TypePtr ref_type_ptr = resolve_ref_param_type_or_fail(stmt, i);
+        bool by_ref = true;
+        if (!ref_key.empty() && i < ref_key.size()) {
+            by_ref = ref_key[i] == 'M';
+        }
+        if (abi.lower_aggregates && ref_type_ptr && is_aggregate_type(ref_type_ptr)) {
+            by_ref = true;
+        }
+        const bool is_array = ref_type_ptr && ref_type_ptr->kind == Type::Kind::Array;
+        const size_t index = quals.const_pointee.size();
+        quals.const_pointee.push_back(by_ref && !is_array && ref_type_ptr && receiver_is_read_only(sym, i));
+        quals.restrict_pointer.push_back(false);
+        if (ref_type_ptr && (is_array || by_ref)) {
+            pointer_params.push_back(index);
+        }
+    }
+    for (const auto& param : stmt->params) {
+        if (param.is_expression_param) continue;
+        const size_t index = quals.const_pointee.size();
+        quals.const_pointee.push_back(false);
+        quals.restrict_pointer.push_back(false);
+        if (!param.type) continue;
+        if (is_pointer_like(param.type) && ptr_kind_for_symbol(binding_for(&param)) == PtrKind::Far) continue;
+        if (param.type->kind == Type::Kind::Array ||
+            (abi.lower_aggregates && is_aggregate_type(param.type))) {
+            pointer_params.push_back(index);
+        } else if (is_pointer_like(param.type)) {
+            has_string_param = true;
+        }
+    }
+    if (frame_abi) return quals;
+
+    auto fact = [&](const SymbolMap<bool>& map, bool fallback) {
+        auto it = map.find(sym);
+        return it == map.end() ? fallback : it->second;
+    };
+    const bool reads_global = fact(facts->function_reads_global, true);
+    const bool writes_global = fact(facts->function_writes_global, true);
+    const bool writes_params = fact(facts->function_writes_params, true);
+    const bool is_pure = fact(facts->function_is_pure, false);
+
+    if (pointer_params.size() == 1 && !returns_aggregate && !reads_global && !writes_global) {
+        quals.restrict_pointer[pointer_params.front()] = true;
+    }
+    if (reent_key != 'N' && returns_value && !returns_aggregate && is_pure && !writes_params) {
+        const bool reads_memory = reads_global || has_string_param || !pointer_params.empty();
+        quals.attributes += reads_memory ? "VX_PURE " : "VX_CONST ";
+    }
+    if (returns_aggregate || !pointer_params.empty()) {
+        // nonnull positions are 1-based and count the aggregate out-parameter.
+        const size_t offset = returns_aggregate ? 2 : 1;
+        std::string positions = returns_aggregate ? "1" : "";
+        for (size_t index : pointer_params) {
+            if (!positions.empty()) positions += ", ";
+            positions += std::to_string(index + offset);
+        }
+        quals.attributes += "VX_NONNULL(" + positions + ") ";
+    }
+    return quals;
+}
+
+std::string CodeGenerator::qualified_param_type(const std::string& type,
+                                                const SignatureQualifiers& quals,
+                                                size_t index) {
+    std::string out = type;
+    if (index < quals.const_pointee.size() && quals.const_pointee[index]) out = "const " + out;
+    if (index < quals.restrict_pointer.size() && quals.restrict_pointer[index]) out += " VX_RESTRICT";
+    return out;
+}
+
 std::string CodeGenerator::nonreentrant_arg_slot_name(const std::string& c_name, size_t index) const {
     return "__vx_nr_arg_" + c_name + "_" + std::to_string(index);
 }
 
 std::string CodeGenerator::nonreentrant_ret_slot_name(const std::string& c_name) const {
+    if (frame_allocation == FrameAllocation::Overlay) return frame_object_name(c_name) + ".ret";
     return "__vx_nr_ret_" + c_name;
 }
 
+std::string CodeGenerator::frame_object_name(const std::string& c_name) const {
+    return "vx_fr_" + c_name;
+}
+
+void CodeGenerator::collect_cold_nonreentrant_functions() {
+    cold_nonreentrant_functions.clear();
+    if (!execution_profile) return;
+    for (const auto& entry : facts->reentrancy_variants) {
+        const Symbol* sym = entry.first;
+        if (entry.second.size() <= 1 || !sym || !sym->declaration) continue;
+        bool cold = true;
+        for (const auto& ref_key : ref_variant_keys_for(sym->declaration)) {
+            std::string c_name = mangle_name(variant_name(sym->name, sym, 'N', ref_key)) + instance_suffix(sym);
+            if (!execution_profile->is_cold(c_name)) {
+                cold = false;
+                break;
+            }
+        }
+        if (cold) cold_nonreentrant_functions.insert(sym);
+    }
+}
+
+std::string CodeGenerator::profile_attributes(const std::string& c_name) const {
+    if (!execution_profile) return "";
+    if (execution_profile->hot.count(c_name)) return "VX_HOT ";
+    if (execution_profile->is_cold(c_name)) return "VX_COLD ";
+    return "";
+}
+
+std::string CodeGenerator::profiled_condition(const std::string& cond) {
+    if (current_profile_function.empty()) return cond;
+    const size_t site = current_profile_sites++;
+    if (!profile_output.empty()) {
+        return "VX_PROF_BRANCH(vx_prof_" + current_profile_function + ", " + std::to_string(1 + 2 * site) +
+               ", " + cond + ")";
+    }
+    switch (execution_profile->branch_bias(current_profile_function, site)) {
+        case 1:
+            return "VX_LIKELY(" + cond + ")";
+        case -1:
+            return "VX_UNLIKELY(" + cond + ")";
+        default:
+            return cond;
+    }
+}
+
+void CodeGenerator::emit_profile_runtime() {
+    if (profile_output.empty()) return;
+    std::vector<const GeneratedFunctionInfo*> instrumented;
+    for (const auto& info : generated_functions) {
+        if (info.profile_counters > 0) instrumented.push_back(&info);
+    }
+    if (instrumented.empty()) return;
+    emit("");
+    emit("static const struct { const char* name; uint64_t* counters; size_t count; } vx_prof_sites[] = {");
+    for (const GeneratedFunctionInfo* info : instrumented) {
+        emit("    {\"" + info->c_name + "\", vx_prof_" + info->c_name + ", " +
+             std::to_string(info->profile_counters) + "},");
+    }
+    emit("};");
+    emit("");
+    emit("static void vx_prof_dump(void) {");
+    emit("    const char* path = getenv(\"VEXEL_PROFILE_FILE\");");
+    emit("    FILE* out = fopen(path && path[0] ? path : \"" + escape_c_string(profile_output) + "\", \"a\");");
+    emit("    if (!out) return;");
+    emit(std::string("    fputs(\"") + kExecutionProfileHeader + "\\n\", out);");
+    emit("    for (size_t i = 0; i < sizeof(vx_prof_sites) / sizeof(vx_prof_sites[0]); i++) {");
+    emit("        const uint64_t* c = vx_prof_sites[i].counters;");
+    emit("        fprintf(out, \"f %s %llu\\n\", vx_prof_sites[i].name, (unsigned long long)c[0]);");
+    emit("        for (size_t s = 1; s + 1 < vx_prof_sites[i].count; s += 2) {");
+    emit("            fprintf(out, \"b %s %lu %llu %llu\\n\", vx_prof_sites[i].name, (unsigned long)(s / 2),");
+    emit("                    (unsigned long long)c[s], (unsigned long long)c[s + 1]);");
+    emit("        }");
+    emit("    }");
+    emit("    fclose(out);");
+    emit("}");
+    emit("");
+    emit("#if VX_HAS_GNU_ATTRIBUTES");
+    emit("__attribute__((constructor)) static void vx_prof_register(void) {");
+    emit("    atexit(vx_prof_dump);");
+    emit("}");
+    emit("#endif");
+}
+
 std::string CodeGenerator::external_link_name(const std::string& qualified_name,
                                               const std::string& fallback_c_name) const {
+    const std::string print_prefix = "std::print::";
+    if (qualified_name.rfind(print_prefix, 0) == 0) {
+        std::string runtime = std_print_runtime_name(qualified_name.substr(print_prefix.size()));
+        return runtime.empty() ? fallback_c_name : runtime;
+    }
     const std::string prefix = "std::math::";
     if (qualified_name.rfind(prefix, 0) != 0) {
         return fallback_c_name;
@@ -284,7 +728,7 @@ bool CodeGenerator::is_std_math_macro_builtin_name(const std::string& runtime_na
     return is_std_math_macro_builtin_name_impl(runtime_name);
 }
 
-bool CodeGenerator::is_bundled_std_math_function(const Symbol* sym, StmtPtr decl) const {
+bool CodeGenerator::is_bundled_std_function(const Symbol* sym, StmtPtr decl, const std::string& file) const {
     if (!sym || !decl || !analyzed_program || !analyzed_program->program) {
         return false;
     }
@@ -296,8 +740,12 @@ bool CodeGenerator::is_bundled_std_math_function(const Symbol* sym, StmtPtr decl
         return false;
     }
     const std::string& path = mod->path;
-    return path == "std/math.vx" ||
-           (path.size() >= 11 && path.compare(path.size() - 11, 11, "std/math.vx") == 0);
+    return path == file ||
+           (path.size() >= file.size() && path.compare(path.size() - file.size(), file.size(), file) == 0);
+}
+
+bool CodeGenerator::is_bundled_std_math_function(const Symbol* sym, StmtPtr decl) const {
+    return is_bundled_std_function(sym, decl, "std/math.vx");
 }
 
 bool CodeGenerator::is_std_bits_builtin_name(const std::string& runtime_name) const {
@@ -305,19 +753,54 @@ bool CodeGenerator::is_std_bits_builtin_name(const std::string& runtime_name) co
 }
 
 bool CodeGenerator::is_bundled_std_bits_function(const Symbol* sym, StmtPtr decl) const {
-    if (!sym || !decl || !analyzed_program || !analyzed_program->program) {
-        return false;
-    }
-    if (sym->module_id < 0) {
-        return false;
-    }
-    const ModuleInfo* mod = analyzed_program->program->module(sym->module_id);
-    if (!mod || mod->origin != ModuleOrigin::BundledStd) {
-        return false;
+    return is_bundled_std_function(sym, decl, "std/bits.vx");
+}
+
+bool CodeGenerator::is_std_print_builtin_name(const std::string& runtime_name) const {
+    return !std_print_runtime_name(runtime_name).empty();
+}
+
+bool CodeGenerator::is_bundled_std_print_function(const Symbol* sym, StmtPtr decl) const {
+    return is_bundled_std_function(sym, decl, "std/print.vx");
+}
+
+std::string CodeGenerator::print_buffer_runtime(bool declarations_only) const {
+    const std::string storage = internal_storage();
+    std::ostringstream out;
+    if (declarations_only) {
+        out << storage << "void vx_std_print_byte(uint8_t c);\n";
+        out << storage << "void vx_std_print_flush(void);\n\n";
+        return out.str();
     }
-    const std::string& path = mod->path;
-    return path == "std/bits.vx" ||
-           (path.size() >= 11 && path.compare(path.size() - 11, 11, "std/bits.vx") == 0);
+    // Output collects in static storage and leaves in one fwrite per line,
+    // when the buffer fills, or on flush(); text still buffered at exit is
+    // written by an atexit hook where GNU attributes are available.
+    out << "#include <stdio.h>\n";
+    out << "#ifndef VX_PRINT_BUFFER_SIZE\n";
+    out << "#define VX_PRINT_BUFFER_SIZE 4096\n";
+    out << "#endif\n";
+    out << storage << "unsigned char vx_std_print_buffer[VX_PRINT_BUFFER_SIZE];\n";
+    out << storage << "size_t vx_std_print_length;\n\n";
+    out << storage << "void vx_std_print_flush(void) {\n";
+    out << "    if (vx_std_print_length > 0) {\n";
+    out << "        fwrite(vx_std_print_buffer, 1, vx_std_print_length, stdout);\n";
+    out << "        vx_std_print_length = 0;\n";
+    out << "    }\n";
+    out << "    fflush(stdout);\n";
+    out << "}\n\n";
+    out << storage << "void vx_std_print_byte(uint8_t c) {\n";
+    out << "    vx_std_print_buffer[vx_std_print_length++] = c;\n";
+    out << "    if (c == 10 || vx_std_print_length == sizeof(vx_std_print_buffer)) {\n";
+    out << "        fwrite(vx_std_print_buffer, 1, vx_std_print_length, stdout);\n";
+    out << "        vx_std_print_length = 0;\n";
+    out << "    }\n";
+    out << "}\n\n";
+    out << "#if VX_HAS_GNU_ATTRIBUTES\n";
+    out << "__attribute__((constructor)) static void vx_std_print_register(void) {\n";
+    out << "    atexit(vx_std_print_flush);\n";
+    out << "}\n";
+    out << "#endif\n\n";
+    return out.str();
 }
 
 void CodeGenerator::emit_return_stmt(const std::string& expr) {
@@ -372,11 +855,11 @@ int64_t CodeGenerator::resolve_array_length(TypePtr type, const SourceLocation&
     if (!lookup_constexpr_value(type->array_size, size_val)) {
         ExprPtr size_expr = type->array_size;
         if (size_expr && size_expr->kind == Expr::Kind::IntLiteral) {
-            if (size_expr->has_exact_int_val && size_expr->exact_int_val.fits_i64()) {
-                return size_expr->exact_int_val.to_i64();
+            if (size_expr->has_exact_int_val && size_expr->exact_int_val->fits_i64()) {
+                return size_expr->exact_int_val->to_i64();
             }
-            if (size_expr->has_exact_int_val && size_expr->exact_int_val.fits_u64()) {
-                uint64_t u = size_expr->exact_int_val.to_u64();
+            if (size_expr->has_exact_int_val && size_expr->exact_int_val->fits_u64()) {
+                uint64_t u = size_expr->exact_int_val->to_u64();
                 if (u > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
                     throw CompileError("Array length exceeds backend host limit", loc);
                 }
@@ -413,6 +896,14 @@ std::string CodeGenerator::ensure_comparator(TypePtr type) {
     if (it != comparator_cache.end()) {
         return it->second;
     }
+    if (deferred_shared_state) {
+        SharedStateEvent event;
+        event.kind = SharedStateEvent::Kind::Comparator;
+        event.type = type;
+        std::string placeholder = defer_shared_state(std::move(event));
+        comparator_cache[key] = placeholder;
+        return placeholder;
+    }
 
     std::string func_name = "vx_cmp_" + sanitize_identifier(key) + "_" + std::to_string(comparator_cache.size());
     comparator_cache[key] = func_name;
@@ -459,11 +950,11 @@ std::string CodeGenerator::ensure_comparator(TypePtr type) {
             break;
         }
         case Type::Kind::Named: {
-            if (!analyzed_program || !analyzed_program->lookup_type_symbol) {
+            if (!analyzed_program) {
                 throw CompileError("Internal error: comparator generation without type lookup",
                                    type->location);
             }
-            Symbol* sym = analyzed_program->lookup_type_symbol(current_instance_id, type->type_name);
+            Symbol* sym = analyzed_program->type_symbol(current_instance_id, type->type_name);
             if (!sym || sym->kind != Symbol::Kind::Type || !sym->declaration || sym->declaration->kind != Stmt::Kind::TypeDecl) {
                 throw CompileError("Cannot compare values of type " + type->type_name, type->location);
             }
@@ -492,4 +983,102 @@ std::string CodeGenerator::ensure_comparator(TypePtr type) {
 }
 
 
+// Bytes of a value whose equality is exactly byte equality: native-width
+// integers, bools, fixed-point raws, and arrays and records of them with no
+// padding. Floats (0.0 == -0.0, NaN), strings and byte-array integers are
+// excluded. A record without gaps in declaration order is also gap-free when
+// field_order=align sorts it, since every field size is a multiple of its
+// alignment.
+bool CodeGenerator::bitwise_size(TypePtr type, uint64_t& size) {
+    type = resolve_type(type);
+    if (!type) return false;
+    switch (type->kind) {
+        case Type::Kind::Primitive:
+            switch (type->primitive) {
+                case PrimitiveType::Int:
+                case PrimitiveType::UInt:
+                    if (type->integer_bits != 8 && type->integer_bits != 16 &&
+                        type->integer_bits != 32 && type->integer_bits != 64) {
+                        return false;
+                    }
+                    size = type->integer_bits / 8;
+                    return true;
+                case PrimitiveType::FixedInt:
+                case PrimitiveType::FixedUInt: {
+                    int64_t bits = type_bits(type->primitive, type->integer_bits, type->fractional_bits);
+                    if (bits != 8 && bits != 16 && bits != 32 && bits != 64) return false;
+                    size = static_cast<uint64_t>(bits / 8);
+                    return true;
+                }
+                case PrimitiveType::Bool:
+                    size = 1;
+                    return true;
+                default:
+                    return false;
+            }
+        case Type::Kind::Array: {
+            uint64_t elem = 0;
+            if (!bitwise_size(type->element_type, elem)) return false;
+            int64_t length = resolve_array_length(type, type->location);
+            if (length <= 0) return false;
+            size = elem * static_cast<uint64_t>(length);
+            return true;
+        }
+        case Type::Kind::Named: {
+            auto it = type_decl_map.find(type->type_name);
+            if (it == type_decl_map.end() || it->second->fields.empty()) return false;
+            uint64_t offset = 0;
+            size_t max_align = 1;
+            for (const auto& field : it->second->fields) {
+                uint64_t field_size = 0;
+                if (!bitwise_size(field.type, field_size)) return false;
+                size_t align = field_alignment(field.type);
+                if (offset % align != 0) return false;
+                offset += field_size;
+                max_align = std::max(max_align, align);
+            }
+            if (offset % max_align != 0) return false;
+            size = offset;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+std::string CodeGenerator::ensure_equality(TypePtr type) {
+    uint64_t size = 0;
+    if (!type || !bitwise_size(type, size)) {
+        return ensure_comparator(type);
+    }
+
+    std::string key = "==" + type->to_string();
+    auto it = comparator_cache.find(key);
+    if (it != comparator_cache.end()) {
+        return it->second;
+    }
+    if (deferred_shared_state) {
+        SharedStateEvent event;
+        event.kind = SharedStateEvent::Kind::Comparator;
+        event.type = type;
+        event.equality = true;
+        std::string placeholder = defer_shared_state(std::move(event));
+        comparator_cache[key] = placeholder;
+        return placeholder;
+    }
+
+    std::string func_name = "vx_eq_" + sanitize_identifier(type->to_string()) + "_" +
+                            std::to_string(comparator_cache.size());
+    comparator_cache[key] = func_name;
+
+    // Arrays arrive as pointers, records by value.
+    const bool is_array = resolve_type(type)->kind == Type::Kind::Array;
+    std::ostringstream fn;
+    fn << "static int " << func_name << "(" << gen_type(type) << " lhs, " << gen_type(type) << " rhs) {\n";
+    fn << "    return memcmp(" << (is_array ? "lhs, rhs" : "&lhs, &rhs") << ", " << size << ") != 0;\n";
+    fn << "}\n";
+    comparator_definitions.push_back(fn.str());
+    return func_name;
+}
+
 } // namespace vexel::c_backend_codegen
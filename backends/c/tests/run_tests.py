@@ -1,12 +1,27 @@
 #!/usr/bin/env python3
+import argparse
+import hashlib
 import os
 import re
 import shutil
 import subprocess
 import sys
 import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 
+# Cases run on a thread pool (each case is a handful of child processes, so
+# threads only wait). With --compile-server every {VEXEL} invocation goes
+# through one `vexel --serve` process instead of starting a fresh compiler.
+# Executables built for @run-generated cases are cached under the build
+# directory, keyed by the C sources they were built from, so an unchanged
+# generated output is not recompiled on the next run.
+
+CC_COMMAND = ["gcc", "-std=c11", "-O2", "out.c", "-o", "out", "-lm"]
+# The compile server rejects these; commands using them run the driver directly.
+SERVER_UNSUPPORTED_FLAGS = ("--run", "--emit-exe")
+
 
 def find_repo_root(start: Path) -> Path:
     for parent in [start] + list(start.parents):
@@ -58,9 +73,12 @@ def resolve_build_dir(root: Path) -> Path:
     return path
 
 
-def replace_macros(command: str, root: Path, build_dir: Path) -> str:
+def replace_macros(command: str, root: Path, build_dir: Path, server_socket=None) -> str:
+    vexel = str(build_dir / "vexel")
+    if server_socket and not any(re.search(rf"(^|\s){flag}(\s|$)", command) for flag in SERVER_UNSUPPORTED_FLAGS):
+        vexel = f"{vexel} --connect {server_socket}"
     replacements = {
-        "{VEXEL}": str(build_dir / "vexel"),
+        "{VEXEL}": vexel,
         "{VEXEL_FRONTEND}": str(build_dir / "vexel-frontend"),
     }
     for key, value in replacements.items():
@@ -78,16 +96,34 @@ def run_command(command: str, cwd: Path):
     )
 
 
-def compile_and_run(cwd: Path):
-    compile_cmd = ["gcc", "-std=c11", "-O2", "out.c", "-o", "out", "-lm"]
-    compile_res = subprocess.run(
-        compile_cmd,
-        cwd=cwd,
-        capture_output=True,
-        text=True,
-    )
-    if compile_res.returncode != 0:
-        return compile_res, None
+def source_digest(cwd: Path) -> str:
+    digest = hashlib.sha256("\0".join(CC_COMMAND).encode())
+    for path in sorted(cwd.iterdir()):
+        if path.is_file() and path.suffix in {".c", ".h"}:
+            digest.update(b"\0" + path.name.encode() + b"\0")
+            digest.update(path.read_bytes())
+    return digest.hexdigest()
+
+
+def compile_and_run(cwd: Path, cc_cache):
+    cached = cc_cache / source_digest(cwd) if cc_cache else None
+    if cached and cached.is_file():
+        shutil.copy2(cached, cwd / "out")
+        compile_res = subprocess.CompletedProcess(CC_COMMAND, 0, "", "")
+    else:
+        compile_res = subprocess.run(
+            CC_COMMAND,
+            cwd=cwd,
+            capture_output=True,
+            text=True,
+        )
+        if compile_res.returncode != 0:
+            return compile_res, None
+        if cached:
+            # Concurrent cases may build the same sources; publish atomically.
+            staging = cached.with_name(f"{cached.name}.{os.getpid()}.{id(cwd)}")
+            shutil.copy2(cwd / "out", staging)
+            os.replace(staging, cached)
 
     run_res = subprocess.run(
         ["./out"],
@@ -98,10 +134,10 @@ def compile_and_run(cwd: Path):
     return compile_res, run_res
 
 
-def run_test(test_file: Path, root: Path) -> str:
+def run_test(test_file: Path, root: Path, server_socket=None, cc_cache=None) -> str:
     command, expect_exit, expect_stderr, run_generated = parse_metadata(test_file)
     build_dir = resolve_build_dir(root)
-    command = replace_macros(command, root, build_dir)
+    command = replace_macros(command, root, build_dir, server_socket)
 
     with tempfile.TemporaryDirectory(prefix="vexel_c_test_") as tmp:
         tmp_path = Path(tmp)
@@ -118,7 +154,7 @@ def run_test(test_file: Path, root: Path) -> str:
                     f"stdout:\n{compile_res.stdout}\n"
                     f"stderr:\n{compile_res.stderr}\n"
                 )
-            gcc_res, run_res = compile_and_run(tmp_path)
+            gcc_res, run_res = compile_and_run(tmp_path, cc_cache)
             if gcc_res.returncode != 0:
                 return (
                     f"gcc failed for {test_file}.\n"
@@ -149,20 +185,81 @@ def run_test(test_file: Path, root: Path) -> str:
         return ""
 
 
+def start_compile_server(build_dir: Path, socket_dir: Path):
+    socket_path = socket_dir / "server.sock"
+    server = subprocess.Popen(
+        [str(build_dir / "vexel"), "--serve", str(socket_path)],
+        stdout=subprocess.DEVNULL,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    deadline = time.monotonic() + 10
+    while not socket_path.exists():
+        if server.poll() is not None or time.monotonic() > deadline:
+            server.kill()
+            _, stderr = server.communicate()
+            raise RuntimeError(f"compile server did not start: {stderr.strip()}")
+        time.sleep(0.01)
+    return server, socket_path
+
+
+def stop_compile_server(build_dir: Path, server, socket_path: Path):
+    subprocess.run(
+        [str(build_dir / "vexel"), "--connect", str(socket_path), "--shutdown"],
+        capture_output=True,
+    )
+    try:
+        server.wait(timeout=10)
+    except subprocess.TimeoutExpired:
+        server.kill()
+        server.wait()
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Run the C backend test suite.")
+    parser.add_argument("-j", "--jobs", type=int,
+                        default=int(os.environ.get("VEXEL_TEST_JOBS", "0") or 0) or os.cpu_count() or 1,
+                        help="cases to run at once (default: $VEXEL_TEST_JOBS or the CPU count)")
+    parser.add_argument("--compile-server", action="store_true",
+                        default=os.environ.get("VEXEL_TEST_COMPILE_SERVER", "") not in {"", "0"},
+                        help="route {VEXEL} through one `vexel --serve` process "
+                             "(default: $VEXEL_TEST_COMPILE_SERVER)")
+    parser.add_argument("--no-cc-cache", action="store_true",
+                        help="always recompile generated C for @run-generated cases")
+    parser.add_argument("filters", nargs="*",
+                        help="run only cases whose path contains one of these substrings")
+    return parser.parse_args()
+
+
 def main() -> int:
+    args = parse_args()
     root = find_repo_root(Path(__file__).resolve())
     tests_root = Path(__file__).resolve().parent
     test_files = sorted(tests_root.rglob("test.vx"))
+    if args.filters:
+        test_files = [f for f in test_files if any(s in str(f.relative_to(tests_root)) for s in args.filters)]
     if not test_files:
         print("No backend C tests found.")
         return 0
 
-    failures = []
-    for test_file in test_files:
-        error = run_test(test_file, root)
-        if error:
-            failures.append(error)
+    build_dir = resolve_build_dir(root)
+    cc_cache = None
+    if not args.no_cc_cache:
+        cc_cache = build_dir / "backend-c-tests" / "cc-cache"
+        cc_cache.mkdir(parents=True, exist_ok=True)
+
+    with tempfile.TemporaryDirectory(prefix="vexel_c_server_") as socket_dir:
+        server = socket_path = None
+        if args.compile_server:
+            server, socket_path = start_compile_server(build_dir, Path(socket_dir))
+        try:
+            with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+                errors = list(pool.map(lambda f: run_test(f, root, socket_path, cc_cache), test_files))
+        finally:
+            if server:
+                stop_compile_server(build_dir, server, socket_path)
 
+    failures = [error for error in errors if error]
     if failures:
         for error in failures:
             print("FAIL:", error)
@@ -3,69 +3,104 @@
 #include "backend_registry.h"
 #include "expr_access.h"
 #include "io_utils.h"
+#include "pipeline_trace.h"
 
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
-#include <unordered_set>
+#include <string>
 
 namespace vexel {
 
 namespace {
 
+// Every writer appends to one reusable buffer. render_to() hands the buffer to
+// the output stream between top-level statements, so a large module is never
+// held as one string.
 class LoweredVexelPrinter {
 public:
-    std::string render(const Module& mod, const std::string& source_path) {
-        std::ostringstream out;
-        out << "// Lowered Vexel module: " << source_path << "\n";
+    void render_to(std::ostream& sink, const Module& mod, const std::string& source_path) {
+        out_.clear();
+        out_ += "// Lowered Vexel module: ";
+        out_ += source_path;
+        out_ += '\n';
         for (const auto& stmt : mod.top_level) {
-            append_stmt(out, stmt, 0);
+            write_stmt(stmt, 0);
+            if (out_.size() >= kFlushBytes) flush(sink);
         }
-        return out.str();
+        flush(sink);
     }
 
 private:
-    static std::string indent(int level) {
-        return std::string(static_cast<size_t>(level) * 4u, ' ');
+    static constexpr size_t kIndentWidth = 4;
+    static constexpr size_t kFlushBytes = size_t{1} << 16;
+
+    std::string out_;
+
+    void flush(std::ostream& sink) {
+        sink.write(out_.data(), static_cast<std::streamsize>(out_.size()));
+        out_.clear();
+    }
+
+    void write_indent(int level) {
+        static const std::string spaces(64 * kIndentWidth, ' ');
+        size_t width = static_cast<size_t>(level) * kIndentWidth;
+        for (; width > spaces.size(); width -= spaces.size()) {
+            out_ += spaces;
+        }
+        out_.append(spaces, 0, width);
     }
 
-    static std::string join_path(const std::vector<std::string>& parts) {
-        std::ostringstream out;
+    void write_path(const std::vector<std::string>& parts) {
         for (size_t i = 0; i < parts.size(); ++i) {
-            if (i > 0) out << "::";
-            out << parts[i];
+            if (i > 0) out_ += "::";
+            out_ += parts[i];
+        }
+    }
+
+    // Scalar operator code of an operator spelling; per-element `.`-prefixed
+    // operators bind like their scalar form.
+    static BinaryOp scalar_op_code(const std::string& spelling) {
+        if (!spelling.empty() && spelling.front() == '.') {
+            return binary_op_code(spelling.substr(1));
+        }
+        return binary_op_code(spelling);
+    }
+
+    static int binary_precedence(BinaryOp op) {
+        switch (op) {
+            case BinaryOp::LogicalOr: return 3;
+            case BinaryOp::LogicalAnd: return 4;
+            case BinaryOp::BitOr: return 5;
+            case BinaryOp::BitXor: return 6;
+            case BinaryOp::BitAnd: return 7;
+            case BinaryOp::Eq:
+            case BinaryOp::Ne: return 8;
+            case BinaryOp::Lt:
+            case BinaryOp::Gt:
+            case BinaryOp::Le:
+            case BinaryOp::Ge: return 9;
+            case BinaryOp::Shl:
+            case BinaryOp::Shr: return 10;
+            case BinaryOp::Add:
+            case BinaryOp::Sub: return 11;
+            default: return 12;
         }
-        return out.str();
     }
 
     static int precedence(const ExprPtr& expr) {
         if (!expr) return 0;
-        auto binary_precedence = [](std::string op) {
-            if (!op.empty() && op.front() == '.') {
-                op.erase(op.begin());
-            }
-            if (op == "||") return 3;
-            if (op == "&&") return 4;
-            if (op == "|") return 5;
-            if (op == "^") return 6;
-            if (op == "&") return 7;
-            if (op == "==" || op == "!=") return 8;
-            if (op == "<" || op == ">" || op == "<=" || op == ">=") return 9;
-            if (op == "<<" || op == ">>") return 10;
-            if (op == "+" || op == "-") return 11;
-            if (op == "*" || op == "/" || op == "%") return 12;
-            return 12;
-        };
         switch (expr->kind) {
             case Expr::Kind::Assignment:
                 return 1;
             case Expr::Kind::Conditional:
                 return 2;
             case Expr::Kind::Binary:
-                return binary_precedence(expr->op);
+                if (expr->binary_op == BinaryOp::Other) {
+                    return binary_precedence(scalar_op_code(expr->op));
+                }
+                return binary_precedence(expr->binary_op);
             case Expr::Kind::Unary:
             case Expr::Kind::Cast:
             case Expr::Kind::Length:
@@ -83,407 +118,429 @@ private:
         return expr && (expr->kind == Expr::Kind::Assignment || expr->kind == Expr::Kind::Conditional);
     }
 
-    static std::string format_float(double value) {
-        std::ostringstream out;
-        out << std::setprecision(17) << value;
-        return out.str();
+    void write_float(double value) {
+        char buffer[32];
+        const int length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        out_.append(buffer, static_cast<size_t>(length));
     }
 
-    std::string format_type(const TypePtr& type) {
-        if (!type) return "#T";
+    void write_type(const TypePtr& type) {
+        if (!type) {
+            out_ += "#T";
+            return;
+        }
         switch (type->kind) {
             case Type::Kind::Primitive:
-                return "#" + primitive_name(type->primitive, type->integer_bits, type->fractional_bits);
+                out_ += '#';
+                out_ += primitive_name(type->primitive, type->integer_bits, type->fractional_bits);
+                return;
             case Type::Kind::Named:
-                return "#" + type->type_name;
+                out_ += '#';
+                out_ += type->type_name;
+                return;
             case Type::Kind::TypeVar:
-                return "#" + type->var_name;
+                out_ += '#';
+                out_ += type->var_name;
+                return;
             case Type::Kind::TypeOf:
                 throw CompileError("Internal error: unresolved #[...] reached vexel backend", type->location);
-            case Type::Kind::Array: {
-                std::string size = "...";
+            case Type::Kind::Array:
+                write_type(type->element_type);
+                out_ += '[';
                 if (type->array_size) {
-                    size = format_expr(type->array_size, 0, 0);
+                    write_expr(type->array_size, 0, 0);
+                } else {
+                    out_ += "...";
                 }
-                return format_type(type->element_type) + "[" + size + "]";
-            }
+                out_ += ']';
+                return;
         }
-        return "#T";
+        out_ += "#T";
     }
 
-    std::string format_param(const Parameter& param) {
-        std::ostringstream out;
+    void write_param(const Parameter& param) {
         if (param.is_expression_param) {
-            out << "$";
+            out_ += '$';
         }
-        out << param.name;
+        out_ += param.name;
         if (param.type) {
-            out << ": " << format_type(param.type);
+            out_ += ": ";
+            write_type(param.type);
         }
-        return out.str();
     }
 
-    std::string format_function_signature(const StmtPtr& stmt) {
-        std::ostringstream out;
-        out << "&";
+    void write_function_signature(const StmtPtr& stmt) {
+        out_ += '&';
         if (stmt->is_external) {
-            out << "!";
+            out_ += '!';
         } else if (stmt->is_exported) {
-            out << "^";
+            out_ += '^';
         }
 
         if (!stmt->ref_params.empty()) {
-            out << "(";
+            out_ += '(';
             for (size_t i = 0; i < stmt->ref_params.size(); ++i) {
-                if (i > 0) out << ", ";
-                out << stmt->ref_params[i];
+                if (i > 0) out_ += ", ";
+                out_ += stmt->ref_params[i];
             }
-            out << ")";
+            out_ += ')';
         }
 
         if (!stmt->type_namespace.empty()) {
-            out << "#" << stmt->type_namespace << "::";
+            out_ += '#';
+            out_ += stmt->type_namespace;
+            out_ += "::";
         }
-        out << stmt->func_name;
-
-        out << "(";
-        bool first = true;
-        for (const auto& param : stmt->params) {
-            if (!first) out << ", ";
-            first = false;
-            out << format_param(param);
+        out_ += stmt->func_name;
+
+        out_ += '(';
+        for (size_t i = 0; i < stmt->params.size(); ++i) {
+            if (i > 0) out_ += ", ";
+            write_param(stmt->params[i]);
         }
-        out << ")";
+        out_ += ')';
 
         if (!stmt->return_types.empty()) {
-            out << " -> (";
+            out_ += " -> (";
             for (size_t i = 0; i < stmt->return_types.size(); ++i) {
-                if (i > 0) out << ", ";
-                out << format_type(stmt->return_types[i]);
+                if (i > 0) out_ += ", ";
+                write_type(stmt->return_types[i]);
             }
-            out << ")";
+            out_ += ')';
         } else if (stmt->return_type) {
-            out << " -> " << format_type(stmt->return_type);
+            out_ += " -> ";
+            write_type(stmt->return_type);
         }
-
-        return out.str();
     }
 
-    void append_stmt(std::ostringstream& out, const StmtPtr& stmt, int level) {
+    void write_stmt(const StmtPtr& stmt, int level) {
         if (!stmt) return;
 
         switch (stmt->kind) {
             case Stmt::Kind::Expr:
-                out << indent(level) << format_expr(stmt->expr, 0, level) << ";\n";
+                write_indent(level);
+                write_expr(stmt->expr, 0, level);
+                out_ += ";\n";
                 return;
             case Stmt::Kind::Return:
+                write_indent(level);
                 if (stmt->return_expr) {
-                    out << indent(level) << "-> " << format_expr(stmt->return_expr, 0, level) << ";\n";
+                    out_ += "-> ";
+                    write_expr(stmt->return_expr, 0, level);
+                    out_ += ";\n";
                 } else {
-                    out << indent(level) << "->;\n";
+                    out_ += "->;\n";
                 }
                 return;
             case Stmt::Kind::Break:
-                out << indent(level) << "->|;\n";
+                write_indent(level);
+                out_ += "->|;\n";
                 return;
             case Stmt::Kind::Continue:
-                out << indent(level) << "->>;\n";
+                write_indent(level);
+                out_ += "->>;\n";
                 return;
             case Stmt::Kind::VarDecl:
-                out << indent(level);
+                write_indent(level);
                 if (stmt->is_exported) {
-                    out << "^";
+                    out_ += '^';
                 }
                 if (stmt->var_linkage == VarLinkageKind::ExternalSymbol) {
-                    out << "!";
+                    out_ += '!';
                 } else if (stmt->var_linkage == VarLinkageKind::BackendBound) {
-                    out << "!!";
+                    out_ += "!!";
                 }
-                out << stmt->var_name;
+                out_ += stmt->var_name;
                 if (stmt->var_type) {
-                    out << ": " << format_type(stmt->var_type);
+                    out_ += ": ";
+                    write_type(stmt->var_type);
                 }
                 if (stmt->var_init) {
-                    out << " = " << format_expr(stmt->var_init, 0, level);
+                    out_ += " = ";
+                    write_expr(stmt->var_init, 0, level);
                 }
-                out << ";\n";
+                out_ += ";\n";
                 return;
             case Stmt::Kind::TypeDecl:
-                out << indent(level) << "#" << stmt->type_decl_name << "(";
+                write_indent(level);
+                out_ += '#';
+                out_ += stmt->type_decl_name;
+                out_ += '(';
                 for (size_t i = 0; i < stmt->fields.size(); ++i) {
-                    if (i > 0) out << ", ";
-                    out << stmt->fields[i].name;
+                    if (i > 0) out_ += ", ";
+                    out_ += stmt->fields[i].name;
                     if (stmt->fields[i].type) {
-                        out << ": " << format_type(stmt->fields[i].type);
+                        out_ += ": ";
+                        write_type(stmt->fields[i].type);
                     }
                 }
-                out << ");\n";
+                out_ += ");\n";
                 return;
             case Stmt::Kind::Import:
-                out << indent(level) << "::" << join_path(stmt->import_path) << ";\n";
+                write_indent(level);
+                out_ += "::";
+                write_path(stmt->import_path);
+                out_ += ";\n";
                 return;
             case Stmt::Kind::ConditionalStmt:
-                out << indent(level) << format_expr(stmt->condition, 0, level) << " ? \n";
-                append_stmt(out, stmt->true_stmt, level + 1);
+                write_indent(level);
+                write_expr(stmt->condition, 0, level);
+                out_ += " ? \n";
+                write_stmt(stmt->true_stmt, level + 1);
                 return;
-            case Stmt::Kind::FuncDecl:
-                out << indent(level) << format_function_signature(stmt);
+            case Stmt::Kind::FuncDecl: {
+                write_indent(level);
+                write_function_signature(stmt);
                 if (stmt->is_external || !stmt->body) {
-                    out << ";\n";
+                    out_ += ";\n";
                     return;
                 }
-                out << " {\n";
-                append_function_body(out, stmt->body, level + 1);
-                out << indent(level) << "}\n";
+                TraceSpan span("emit", "emit", stmt->func_name);
+                out_ += " {\n";
+                write_function_body(stmt->body, level + 1);
+                write_indent(level);
+                out_ += "}\n";
                 return;
+            }
         }
     }
 
-    void append_function_body(std::ostringstream& out, const ExprPtr& body, int level) {
+    void write_function_body(const ExprPtr& body, int level) {
         if (!body) return;
 
         if (body->kind == Expr::Kind::Block) {
             for (const auto& st : body->statements) {
-                append_stmt(out, st, level);
+                write_stmt(st, level);
             }
             if (body->result_expr) {
-                out << indent(level) << format_expr(body->result_expr, 0, level) << "\n";
+                write_indent(level);
+                write_expr(body->result_expr, 0, level);
+                out_ += '\n';
+            }
+            return;
+        }
+
+        write_indent(level);
+        write_expr(body, 0, level);
+        out_ += '\n';
+    }
+
+    void write_expr_list(const std::vector<ExprPtr>& exprs, int level) {
+        for (size_t i = 0; i < exprs.size(); ++i) {
+            if (i > 0) out_ += ", ";
+            write_expr(exprs[i], 0, level);
+        }
+    }
+
+    void write_call(const ExprPtr& expr, int my_prec, int parent_prec, int level) {
+        if (expr->is_constructor_call) {
+            out_ += '#';
+            write_expr(expr->operand, my_prec, level);
+            out_ += '(';
+            write_expr_list(expr->args, level);
+            out_ += ')';
+            return;
+        }
+
+        if (!expr->receivers.empty() && expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
+            const std::string& name = expr->operand->name;
+            const size_t scope = name.rfind("::");
+            const std::string display_name = scope == std::string::npos ? name : name.substr(scope + 2);
+            const bool is_sugar_op = display_name == "@" || display_name == "@@";
+            const BinaryOp op = scalar_op_code(display_name);
+            if ((is_sugar_op || op != BinaryOp::Other) &&
+                expr->receivers.size() == 1 && expr->args.size() == 1) {
+                if (is_sugar_op) {
+                    write_expr(expr->receivers[0], my_prec, level);
+                    out_ += display_name;
+                    write_expr(expr->args[0], 0, level);
+                    return;
+                }
+                const int op_prec = binary_precedence(op);
+                const bool op_need_parens = op_prec < parent_prec;
+                if (op_need_parens) out_ += '(';
+                write_expr(expr->receivers[0], op_prec, level);
+                out_ += ' ';
+                out_ += display_name;
+                out_ += ' ';
+                write_expr(expr->args[0], op_prec + 1, level);
+                if (op_need_parens) out_ += ')';
+                return;
+            }
+
+            if (expr->receivers.size() == 1) {
+                write_expr(expr->receivers[0], my_prec, level);
+            } else {
+                out_ += '(';
+                write_expr_list(expr->receivers, level);
+                out_ += ')';
             }
+            out_ += '.';
+            out_ += display_name;
+            out_ += '(';
+            write_expr_list(expr->args, level);
+            out_ += ')';
             return;
         }
 
-        out << indent(level) << format_expr(body, 0, level) << "\n";
+        write_expr(expr->operand, my_prec, level);
+        out_ += '(';
+        write_expr_list(expr->args, level);
+        out_ += ')';
     }
 
-    std::string format_expr(const ExprPtr& expr, int parent_prec, int level) {
-        if (!expr) return "";
+    void write_expr(const ExprPtr& expr, int parent_prec, int level) {
+        if (!expr) return;
 
         const int my_prec = precedence(expr);
         const bool need_parens = my_prec < parent_prec;
-        std::ostringstream out;
 
-        if (need_parens) out << "(";
+        if (need_parens) out_ += '(';
 
         switch (expr->kind) {
             case Expr::Kind::IntLiteral:
                 if (!expr->raw_literal.empty()) {
-                    out << expr->raw_literal;
+                    out_ += expr->raw_literal;
                 } else {
-                    out << expr->uint_val;
+                    out_ += std::to_string(expr->uint_val);
                 }
                 break;
             case Expr::Kind::FloatLiteral:
                 if (!expr->raw_literal.empty()) {
-                    out << expr->raw_literal;
+                    out_ += expr->raw_literal;
                 } else {
-                    out << format_float(expr->float_val);
+                    write_float(expr->float_val);
                 }
                 break;
             case Expr::Kind::StringLiteral:
-                out << '"' << expr->string_val << '"';
+                out_ += '"';
+                out_ += expr->string_val;
+                out_ += '"';
                 break;
             case Expr::Kind::CharLiteral:
-                out << '\'' << static_cast<char>(expr->uint_val & 0xFFu) << '\'';
+                out_ += '\'';
+                out_ += static_cast<char>(expr->uint_val & 0xFFu);
+                out_ += '\'';
                 break;
             case Expr::Kind::Identifier:
-                out << expr->name;
+                out_ += expr->name;
                 break;
-            case Expr::Kind::Binary: {
-                out << format_expr(expr->left, my_prec, level);
-                out << " " << expr->op << " ";
-                int rhs_prec = my_prec + (is_right_associative(expr) ? 0 : 1);
-                out << format_expr(expr->right, rhs_prec, level);
+            case Expr::Kind::Binary:
+                write_expr(expr->left, my_prec, level);
+                out_ += ' ';
+                out_ += expr->op;
+                out_ += ' ';
+                write_expr(expr->right, my_prec + (is_right_associative(expr) ? 0 : 1), level);
                 break;
-            }
             case Expr::Kind::Unary:
-                out << expr->op << format_expr(expr->operand, my_prec, level);
+                out_ += expr->op;
+                write_expr(expr->operand, my_prec, level);
                 break;
-            case Expr::Kind::Call: {
-                auto append_args = [&](const std::vector<ExprPtr>& args) {
-                    bool first = true;
-                    for (const auto& arg : args) {
-                        if (!first) out << ", ";
-                        first = false;
-                        out << format_expr(arg, 0, level);
-                    }
-                };
-                auto method_suffix_name = [&](const std::string& name) {
-                    size_t pos = name.rfind("::");
-                    return (pos == std::string::npos) ? name : name.substr(pos + 2);
-                };
-                auto is_operator_name = [&](const std::string& name) {
-                    static const std::unordered_set<std::string> kOps = {
-                        "+","-","*","/","%","&","|","^","<<",">>","==","!=","<","<=",">",">=",
-                        "&&","||","@","@@",
-                        ".+",".-",".*","./",".%",".&",".|",".^",".<<",".>>",".==",".!=",".<",".<=",".>",".>=",".&&",".||"
-                    };
-                    return kOps.count(name) > 0;
-                };
-                auto binary_op_precedence = [&](std::string op) {
-                    if (!op.empty() && op.front() == '.') {
-                        op.erase(op.begin());
-                    }
-                    if (op == "||") return 3;
-                    if (op == "&&") return 4;
-                    if (op == "|") return 5;
-                    if (op == "^") return 6;
-                    if (op == "&") return 7;
-                    if (op == "==" || op == "!=") return 8;
-                    if (op == "<" || op == ">" || op == "<=" || op == ">=") return 9;
-                    if (op == "<<" || op == ">>") return 10;
-                    if (op == "+" || op == "-") return 11;
-                    if (op == "*" || op == "/" || op == "%") return 12;
-                    return 12;
-                };
-
-                if (expr->is_constructor_call) {
-                    out << "#";
-                    out << format_expr(expr->operand, my_prec, level) << "(";
-                    append_args(expr->args);
-                    out << ")";
-                    break;
-                }
-
-                if (!expr->receivers.empty() && expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
-                    const std::string display_name = method_suffix_name(expr->operand->name);
-                    if (is_operator_name(display_name)) {
-                        if ((display_name == "@" || display_name == "@@") &&
-                            expr->receivers.size() == 1 && expr->args.size() == 1) {
-                            out << format_expr(expr->receivers[0], my_prec, level)
-                                << display_name
-                                << format_expr(expr->args[0], 0, level);
-                            break;
-                        }
-                        if (expr->receivers.size() == 1 && expr->args.size() == 1) {
-                            int op_prec = binary_op_precedence(display_name);
-                            bool op_need_parens = op_prec < parent_prec;
-                            if (op_need_parens) out << "(";
-                            out << format_expr(expr->receivers[0], op_prec, level)
-                                << " " << display_name << " ";
-                            int rhs_prec = op_prec + 1;
-                            out << format_expr(expr->args[0], rhs_prec, level);
-                            if (op_need_parens) out << ")";
-                            break;
-                        }
-                    }
-
-                    if (expr->receivers.size() == 1) {
-                        out << format_expr(expr->receivers[0], my_prec, level)
-                            << "." << display_name << "(";
-                        append_args(expr->args);
-                        out << ")";
-                        break;
-                    }
-                    out << "(";
-                    for (size_t i = 0; i < expr->receivers.size(); ++i) {
-                        if (i > 0) out << ", ";
-                        out << format_expr(expr->receivers[i], 0, level);
-                    }
-                    out << ")." << display_name << "(";
-                    append_args(expr->args);
-                    out << ")";
-                    break;
-                }
-
-                out << format_expr(expr->operand, my_prec, level) << "(";
-                append_args(expr->args);
-                out << ")";
+            case Expr::Kind::Call:
+                write_call(expr, my_prec, parent_prec, level);
                 break;
-            }
             case Expr::Kind::Index:
-                out << format_expr(expr->operand, my_prec, level) << "[";
+                write_expr(expr->operand, my_prec, level);
+                out_ += '[';
                 if (!expr->args.empty()) {
-                    out << format_expr(expr->args[0], 0, level);
+                    write_expr(expr->args[0], 0, level);
                 }
-                out << "]";
+                out_ += ']';
                 break;
             case Expr::Kind::Member:
-                out << format_expr(expr->operand, my_prec, level) << "." << expr->name;
+                write_expr(expr->operand, my_prec, level);
+                out_ += '.';
+                out_ += expr->name;
                 break;
             case Expr::Kind::ArrayLiteral:
-                out << "[";
-                for (size_t i = 0; i < expr->elements.size(); ++i) {
-                    if (i > 0) out << ", ";
-                    out << format_expr(expr->elements[i], 0, level);
-                }
-                out << "]";
+                out_ += '[';
+                write_expr_list(expr->elements, level);
+                out_ += ']';
                 break;
             case Expr::Kind::TupleLiteral:
-                out << "(";
-                for (size_t i = 0; i < expr->elements.size(); ++i) {
-                    if (i > 0) out << ", ";
-                    out << format_expr(expr->elements[i], 0, level);
-                }
-                out << ")";
+                out_ += '(';
+                write_expr_list(expr->elements, level);
+                out_ += ')';
                 break;
-            case Expr::Kind::Block: {
-                out << "{\n";
+            case Expr::Kind::Block:
+                out_ += "{\n";
                 for (const auto& st : expr->statements) {
-                    append_stmt(out, st, level + 1);
+                    write_stmt(st, level + 1);
                 }
                 if (expr->result_expr) {
-                    out << indent(level + 1) << format_expr(expr->result_expr, 0, level + 1) << "\n";
+                    write_indent(level + 1);
+                    write_expr(expr->result_expr, 0, level + 1);
+                    out_ += '\n';
                 }
-                out << indent(level) << "}";
+                write_indent(level);
+                out_ += '}';
                 break;
-            }
             case Expr::Kind::Conditional:
-                out << format_expr(expr->condition, my_prec, level)
-                    << " ? "
-                    << format_expr(expr->true_expr, my_prec, level)
-                    << " : "
-                    << format_expr(expr->false_expr, my_prec, level);
+                write_expr(expr->condition, my_prec, level);
+                out_ += " ? ";
+                write_expr(expr->true_expr, my_prec, level);
+                out_ += " : ";
+                write_expr(expr->false_expr, my_prec, level);
                 break;
             case Expr::Kind::Cast:
-                out << "( " << format_type(expr->target_type) << " ) "
-                    << format_expr(expr->operand, my_prec, level);
+                out_ += "( ";
+                write_type(expr->target_type);
+                out_ += " ) ";
+                write_expr(expr->operand, my_prec, level);
                 break;
             case Expr::Kind::Assignment:
-                {
-                    const std::string assign_op = expr->op.empty() ? "=" : expr->op;
                 if (expr->creates_new_variable &&
                     expr->left &&
                     expr->left->kind == Expr::Kind::Identifier) {
-                    out << expr->left->name;
+                    out_ += expr->left->name;
                     if (expr->declared_var_type) {
-                        out << ": " << format_type(expr->declared_var_type);
+                        out_ += ": ";
+                        write_type(expr->declared_var_type);
                     }
-                    out << " " << assign_op << " " << format_expr(expr->right, my_prec, level);
                 } else {
-                    out << format_expr(expr->left, my_prec, level)
-                        << " " << assign_op << " "
-                        << format_expr(expr->right, my_prec, level);
+                    write_expr(expr->left, my_prec, level);
                 }
-                break;
+                out_ += ' ';
+                if (expr->op.empty()) {
+                    out_ += '=';
+                } else {
+                    out_ += expr->op;
                 }
+                out_ += ' ';
+                write_expr(expr->right, my_prec, level);
+                break;
             case Expr::Kind::Range:
-                out << format_expr(expr->left, my_prec, level)
-                    << ".."
-                    << format_expr(expr->right, my_prec, level);
+                write_expr(expr->left, my_prec, level);
+                out_ += "..";
+                write_expr(expr->right, my_prec, level);
                 break;
             case Expr::Kind::Length:
-                out << "|" << format_expr(expr->operand, 0, level) << "|";
+                out_ += '|';
+                write_expr(expr->operand, 0, level);
+                out_ += '|';
                 break;
             case Expr::Kind::Iteration:
-                out << format_expr(loop_subject(expr), 0, level)
-                    << (expr->is_sorted_iteration ? "@@" : "@")
-                    << format_expr(loop_body(expr), my_prec, level + 1);
+                write_expr(loop_subject(expr), 0, level);
+                out_ += expr->is_sorted_iteration ? "@@" : "@";
+                write_expr(loop_body(expr), my_prec, level + 1);
                 break;
             case Expr::Kind::Repeat:
-                out << format_expr(loop_subject(expr), 0, level)
-                    << "@"
-                    << format_expr(loop_body(expr), my_prec, level + 1);
+                write_expr(loop_subject(expr), 0, level);
+                out_ += '@';
+                write_expr(loop_body(expr), my_prec, level + 1);
                 break;
             case Expr::Kind::Resource:
-                out << "::" << join_path(expr->resource_path);
+                out_ += "::";
+                write_path(expr->resource_path);
                 break;
             case Expr::Kind::Process:
-                out << "::\"" << expr->process_command << "\"";
+                out_ += "::\"";
+                out_ += expr->process_command;
+                out_ += '"';
                 break;
         }
 
-        if (need_parens) out << ")";
-        return out.str();
+        if (need_parens) out_ += ')';
     }
 };
 
@@ -502,11 +559,11 @@ static void print_vexel_backend_usage(std::ostream& os) {
 }
 
 static void emit_vexel_backend(const BackendInput& input) {
-    LoweredVexelPrinter printer;
-    const std::string text = printer.render(*input.program.module, input.options.input_file);
-
     std::filesystem::path output_path = input.outputs.dir / (input.outputs.stem + ".vx");
-    write_text_file_or_throw(output_path.string(), text);
+    LoweredVexelPrinter printer;
+    write_file_stream_or_throw(output_path.string(), [&](std::ostream& out) {
+        printer.render_to(out, *input.program.module, input.options.input_file);
+    });
 
     if (input.options.verbose) {
         std::cout << "Writing lowered Vexel: " << output_path << std::endl;
@@ -0,0 +1,136 @@
+#include "batch_compile.h"
+
+#include "common.h"
+#include "thread_pool.h"
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace vexel {
+
+namespace {
+
+struct BatchEntry {
+    std::string input;
+    std::string output;
+    size_t line = 0;
+    std::string error;  // filled by the worker
+};
+
+std::string format_error(const CompileError& e) {
+    std::ostringstream out;
+    out << "Error";
+    if (!e.location.filename().empty()) {
+        out << " at " << e.location.filename() << ":" << e.location.line << ":" << e.location.column;
+    }
+    out << ": " << e.what() << "\n";
+    return out.str();
+}
+
+bool read_batch_list(const std::string& list_path,
+                     const std::string& output_dir,
+                     std::vector<BatchEntry>& entries,
+                     std::ostream& err) {
+    std::ifstream list(list_path);
+    if (!list) {
+        err << "Error: Cannot open batch list: " << list_path << "\n";
+        return false;
+    }
+    const std::filesystem::path base = std::filesystem::path(list_path).parent_path();
+    auto relative_to_list = [&](const std::string& path) {
+        std::filesystem::path p(path);
+        return (p.is_absolute() || base.empty() ? p : base / p).lexically_normal().string();
+    };
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(list, line)) {
+        ++line_no;
+        std::istringstream fields(line);
+        BatchEntry entry;
+        if (!(fields >> entry.input) || entry.input[0] == '#') continue;
+        std::string output;
+        std::string extra;
+        fields >> output;
+        if (fields >> extra) {
+            err << "Error: " << list_path << ":" << line_no
+                << ": expected '<input.vx> [<output base>]'\n";
+            return false;
+        }
+        entry.line = line_no;
+        entry.input = relative_to_list(entry.input);
+        if (!output.empty()) {
+            entry.output = relative_to_list(output);
+        } else {
+            entry.output = (std::filesystem::path(output_dir) / std::filesystem::path(entry.input).stem()).string();
+        }
+        entries.push_back(std::move(entry));
+    }
+    if (entries.empty()) {
+        err << "Error: Batch list " << list_path << " has no entries\n";
+        return false;
+    }
+
+    // Two entries resolving to one output base would overwrite each other.
+    std::map<std::string, size_t> owners;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Compiler::OutputPaths paths = Compiler::resolve_output_paths(entries[i].output);
+        const std::string key = (std::filesystem::absolute(paths.dir) / paths.stem).lexically_normal().string();
+        auto inserted = owners.emplace(key, i);
+        if (!inserted.second) {
+            err << "Error: " << list_path << ":" << entries[i].line << ": '" << entries[i].input
+                << "' and '" << entries[inserted.first->second].input << "' both write " << paths.stem
+                << " in " << paths.dir.string() << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int run_batch_compile(const CompilerSession& session,
+                      const std::string& list_path,
+                      const std::string& output_dir,
+                      std::ostream& err) {
+    std::vector<BatchEntry> entries;
+    if (!read_batch_list(list_path, output_dir, entries, err)) return 1;
+
+    const Compiler::Options& options = session.options();
+    {
+        ThreadPool pool(options.verbose ? 1 : resolve_worker_count(options.jobs));
+        for (BatchEntry& entry : entries) {
+            pool.submit([&session, &entry]() {
+                try {
+                    (void)session.compile(entry.input, entry.output);
+                } catch (const CompileError& e) {
+                    entry.error = format_error(e);
+                } catch (const std::exception& e) {
+                    entry.error = std::string("Error: ") + e.what() + "\n";
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    size_t failed = 0;
+    for (const BatchEntry& entry : entries) {
+        if (entry.error.empty()) continue;
+        ++failed;
+        err << entry.error;
+    }
+    if (failed > 0) {
+        err << "Batch: " << failed << " of " << entries.size() << " entries failed\n";
+        return 1;
+    }
+    if (options.verbose) {
+        std::cout << "Batch: compiled " << entries.size() << " entries" << std::endl;
+    }
+    return 0;
+}
+
+} // namespace vexel
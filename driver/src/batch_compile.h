@@ -0,0 +1,27 @@
+#pragma once
+
+#include "compiler_session.h"
+
+#include <ostream>
+#include <string>
+
+namespace vexel {
+
+// `vexel --batch <list>`: compiles every entry program named in `list_path`
+// through one CompilerSession, so modules the entries share are parsed once.
+// Entries run on `--jobs` workers (one at a time with `-v`, whose progress
+// lines would otherwise interleave).
+//
+// List format: one entry per line, `<input.vx> [<output base>]`; blank lines
+// and lines starting with `#` are skipped, and relative paths are relative to
+// the list file. Without an output base an entry writes `<output_dir>/<stem>`
+// (`dir/prog.vx` -> `<output_dir>/prog.c`).
+//
+// Diagnostics are printed in list order after all entries finished. Returns
+// 0 when every entry compiled.
+int run_batch_compile(const CompilerSession& session,
+                      const std::string& list_path,
+                      const std::string& output_dir,
+                      std::ostream& err);
+
+} // namespace vexel
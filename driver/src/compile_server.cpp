@@ -0,0 +1,259 @@
+#include "compile_server.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define VEXEL_HAVE_UNIX_SOCKETS 1
+#endif
+
+namespace vexel {
+
+#if defined(VEXEL_HAVE_UNIX_SOCKETS)
+
+namespace {
+
+// Wire format, both directions: u32 string count, then per string a u32 byte
+// length and the bytes (host byte order; both ends run on one machine).
+// Request: working directory, then argv. Reply: exit code, stdout, stderr.
+constexpr uint32_t kMaxWireString = 1u << 30;
+constexpr const char* kShutdownRequest = "--shutdown";
+constexpr int kConnectAttempts = 50;  // 100 ms apart, for a server that is still starting
+constexpr int kListenBacklog = 16;
+
+bool write_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::read(fd, bytes, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_strings(int fd, const std::vector<std::string>& strings) {
+    uint32_t count = static_cast<uint32_t>(strings.size());
+    if (!write_all(fd, &count, sizeof(count))) return false;
+    for (const auto& s : strings) {
+        uint32_t size = static_cast<uint32_t>(s.size());
+        if (!write_all(fd, &size, sizeof(size)) || !write_all(fd, s.data(), s.size())) return false;
+    }
+    return true;
+}
+
+bool read_strings(int fd, std::vector<std::string>& strings) {
+    uint32_t count = 0;
+    if (!read_all(fd, &count, sizeof(count))) return false;
+    strings.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t size = 0;
+        if (!read_all(fd, &size, sizeof(size)) || size > kMaxWireString) return false;
+        std::string s(size, '\0');
+        if (!read_all(fd, s.data(), size)) return false;
+        strings.push_back(std::move(s));
+    }
+    return true;
+}
+
+bool make_address(const std::string& path, sockaddr_un& addr, std::string& error) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        error = "compile server socket path must be 1 to " + std::to_string(sizeof(addr.sun_path) - 1) +
+                " bytes long: " + path;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int connect_to(const sockaddr_un& addr) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+// Runs one request with std::cout/std::cerr captured.
+std::vector<std::string> run_request(const std::vector<std::string>& request,
+                                     const std::filesystem::path& home,
+                                     const CompileRequestHandler& compile) {
+    std::ostringstream out;
+    std::ostringstream err;
+    int status = 1;
+    std::error_code ec;
+    std::filesystem::current_path(request[0], ec);
+    if (ec) {
+        err << "Error: compile server cannot enter working directory " << request[0] << ": " << ec.message()
+            << "\n";
+    } else {
+        std::streambuf* saved_out = std::cout.rdbuf(out.rdbuf());
+        std::streambuf* saved_err = std::cerr.rdbuf(err.rdbuf());
+        try {
+            status = compile(std::vector<std::string>(request.begin() + 1, request.end()));
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            status = 1;
+        } catch (...) {
+            std::cerr << "Error: compile server request failed\n";
+            status = 1;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        std::cout.rdbuf(saved_out);
+        std::cerr.rdbuf(saved_err);
+    }
+    std::filesystem::current_path(home, ec);
+    return {std::to_string(status), out.str(), err.str()};
+}
+
+} // namespace
+
+bool compile_server_supported() {
+    return true;
+}
+
+int serve_compile_requests(const std::string& socket_path,
+                           const CompileRequestHandler& compile,
+                           std::ostream& err) {
+    std::error_code ec;
+    const std::filesystem::path home = std::filesystem::current_path(ec);
+    const std::string path = std::filesystem::absolute(socket_path, ec).string();
+    sockaddr_un addr;
+    std::string error;
+    if (!make_address(path, addr, error)) {
+        err << "Error: " << error << "\n";
+        return 1;
+    }
+    int probe = connect_to(addr);
+    if (probe >= 0) {
+        ::close(probe);
+        err << "Error: a compile server is already listening on " << socket_path << "\n";
+        return 1;
+    }
+    ::unlink(path.c_str());  // stale socket left by a server that did not shut down
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener, kListenBacklog) != 0) {
+        err << "Error: cannot listen on " << socket_path << ": " << std::strerror(errno) << "\n";
+        if (listener >= 0) ::close(listener);
+        return 1;
+    }
+    // A client that disconnects mid-reply must not terminate the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    bool running = true;
+    while (running) {
+        int conn = ::accept(listener, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) continue;
+            err << "Error: compile server accept failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        std::vector<std::string> request;
+        if (read_strings(conn, request) && !request.empty()) {
+            std::vector<std::string> reply;
+            if (request.size() == 3 && request[2] == kShutdownRequest) {
+                reply = {"0", "", ""};
+                running = false;
+            } else if (request.size() < 2) {
+                reply = {"1", "", "Error: empty compile server request\n"};
+            } else {
+                reply = run_request(request, home, compile);
+            }
+            write_strings(conn, reply);
+        }
+        ::close(conn);
+    }
+    ::close(listener);
+    ::unlink(path.c_str());
+    return running ? 1 : 0;
+}
+
+int forward_compile_request(const std::string& socket_path,
+                            const std::vector<std::string>& args,
+                            std::ostream& out,
+                            std::ostream& err) {
+    sockaddr_un addr;
+    std::string error;
+    if (!make_address(socket_path, addr, error)) {
+        err << "Error: " << error << "\n";
+        return 1;
+    }
+    int fd = -1;
+    for (int attempt = 0; attempt < kConnectAttempts; ++attempt) {
+        fd = connect_to(addr);
+        if (fd >= 0 || (errno != ENOENT && errno != ECONNREFUSED)) break;
+        ::usleep(100 * 1000);
+    }
+    if (fd < 0) {
+        err << "Error: cannot connect to compile server at " << socket_path << ": " << std::strerror(errno)
+            << "\n";
+        return 1;
+    }
+    std::error_code ec;
+    std::vector<std::string> request;
+    request.push_back(std::filesystem::current_path(ec).string());
+    request.insert(request.end(), args.begin(), args.end());
+    std::vector<std::string> reply;
+    bool ok = write_strings(fd, request) && read_strings(fd, reply) && reply.size() == 3;
+    ::close(fd);
+    if (!ok) {
+        err << "Error: compile server at " << socket_path << " closed the connection\n";
+        return 1;
+    }
+    out << reply[1];
+    err << reply[2];
+    return std::atoi(reply[0].c_str());
+}
+
+#else
+
+bool compile_server_supported() {
+    return false;
+}
+
+int serve_compile_requests(const std::string&, const CompileRequestHandler&, std::ostream& err) {
+    err << "Error: --serve requires Unix domain sockets, which this build does not have\n";
+    return 1;
+}
+
+int forward_compile_request(const std::string&, const std::vector<std::string>&, std::ostream&, std::ostream& err) {
+    err << "Error: --connect requires Unix domain sockets, which this build does not have\n";
+    return 1;
+}
+
+#endif
+
+} // namespace vexel
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vexel {
+
+// Compile server: `vexel --serve <socket>` accepts requests on a Unix socket
+// and runs them one at a time in one long-lived process, so backend
+// registration, interned names and parsed modules stay warm between builds.
+// `vexel --connect <socket> <args...>` forwards its command line and working
+// directory and relays the server's stdout, stderr and exit code.
+//
+// `compile` runs one command line (argv[0] first) with the server's working
+// directory set to the client's and std::cout/std::cerr captured for the
+// reply. The server stops on a `--shutdown` request.
+using CompileRequestHandler = std::function<int(const std::vector<std::string>& args)>;
+
+bool compile_server_supported();
+int serve_compile_requests(const std::string& socket_path,
+                           const CompileRequestHandler& compile,
+                           std::ostream& err);
+int forward_compile_request(const std::string& socket_path,
+                            const std::vector<std::string>& args,
+                            std::ostream& out,
+                            std::ostream& err);
+
+} // namespace vexel
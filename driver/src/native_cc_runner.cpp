@@ -0,0 +1,110 @@
+#include "native_cc_runner.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <sys/wait.h>
+#include <unistd.h>
+#define VEXEL_HAVE_FORK_EXEC 1
+#endif
+
+namespace vexel {
+
+bool native_cc_supported() {
+#if defined(VEXEL_HAVE_FORK_EXEC)
+    return true;
+#else
+    return false;
+#endif
+}
+
+int emit_exe_with_native_cc(const Compiler::Options& opts, const NativeCcOptions& cc, std::ostream& err) {
+#if !defined(VEXEL_HAVE_FORK_EXEC)
+    (void)opts;
+    (void)cc;
+    err << "Error: --native-cc is unavailable on this platform\n";
+    return 1;
+#else
+    std::string translation_unit;
+    {
+        Compiler compiler(opts);
+        std::string compile_error;
+        if (!compiler.emit_translation_unit(translation_unit, compile_error)) {
+            err << "Error: " << compile_error << "\n";
+            return 1;
+        }
+    }
+
+    // Flags after the source apply to linking; libm matches the libtcc path.
+    std::vector<std::string> args = {cc.compiler, "-std=c11", "-O" + cc.opt_level};
+    args.insert(args.end(), cc.flags.begin(), cc.flags.end());
+    args.insert(args.end(), {"-x", "c", "-", "-x", "none", "-o", opts.output_file, "-lm"});
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (std::string& arg : args) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    if (opts.verbose) {
+        std::cout << "Running:";
+        for (const std::string& arg : args) std::cout << " " << arg;
+        std::cout << std::endl;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+
+    int pipe_fds[2];
+    if (::pipe(pipe_fds) != 0) {
+        err << "Error: cannot create pipe for " << cc.compiler << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        err << "Error: cannot start " << cc.compiler << ": " << std::strerror(errno) << "\n";
+        ::close(pipe_fds[0]);
+        ::close(pipe_fds[1]);
+        return 1;
+    }
+    if (pid == 0) {
+        ::dup2(pipe_fds[0], STDIN_FILENO);
+        ::close(pipe_fds[0]);
+        ::close(pipe_fds[1]);
+        ::execvp(argv[0], argv.data());
+        std::fprintf(stderr, "Error: cannot run %s: %s\n", argv[0], std::strerror(errno));
+        _exit(127);
+    }
+    ::close(pipe_fds[0]);
+
+    // A compiler that exits early closes the pipe; report its status, not SIGPIPE.
+    void (*saved_sigpipe)(int) = std::signal(SIGPIPE, SIG_IGN);
+    const char* data = translation_unit.data();
+    size_t remaining = translation_unit.size();
+    while (remaining > 0) {
+        ssize_t n = ::write(pipe_fds[1], data, remaining);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        data += n;
+        remaining -= static_cast<size_t>(n);
+    }
+    ::close(pipe_fds[1]);
+    std::signal(SIGPIPE, saved_sigpipe);
+
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            err << "Error: cannot wait for " << cc.compiler << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        err << "Error: " << cc.compiler << " failed to build " << opts.output_file << "\n";
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+} // namespace vexel
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "compiler.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vexel {
+
+// `--emit-exe --native-cc=<cc>`: build the executable with a host C compiler
+// instead of libtcc. The translation unit is piped to `<cc> -x c -` on stdin,
+// so no intermediate files are written.
+struct NativeCcOptions {
+    std::string compiler;               // Command name or path (gcc, clang, ...)
+    std::string opt_level = "2";        // Passed as -O<opt_level>
+    std::vector<std::string> flags;     // Extra flags, e.g. -flto or -fprofile-use=<path>
+};
+
+bool native_cc_supported();
+int emit_exe_with_native_cc(const Compiler::Options& opts, const NativeCcOptions& cc, std::ostream& err);
+
+} // namespace vexel
@@ -0,0 +1,186 @@
+#include "native_run_cache.h"
+
+#include "content_hash.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <sys/wait.h>
+#include <unistd.h>
+#define VEXEL_HAVE_FORK_EXEC 1
+#endif
+
+namespace vexel {
+
+namespace {
+
+// The build stamp and the running binary's size and mtime keep entries made
+// by another compiler build out; either may change the generated program.
+constexpr const char* kCacheHeader = "vexel-run-cache 1 " __DATE__ " " __TIME__;
+
+void add_compiler_identity(ContentHasher& hasher) {
+    hasher.add_bytes(kCacheHeader, std::strlen(kCacheHeader));
+    std::error_code ec;
+    const std::filesystem::path self("/proc/self/exe");
+    const uintmax_t size = std::filesystem::file_size(self, ec);
+    if (!ec) {
+        hasher.add_u64(size);
+        const auto mtime = std::filesystem::last_write_time(self, ec);
+        if (!ec) hasher.add_u64(static_cast<uint64_t>(mtime.time_since_epoch().count()));
+    }
+}
+
+std::string absolute_path(const std::string& path) {
+    std::error_code ec;
+    const std::filesystem::path abs = std::filesystem::weakly_canonical(path, ec);
+    return ec ? path : abs.string();
+}
+
+bool write_atomically(const std::string& target, const std::string& content) {
+    const std::string tmp_path =
+        target + ".tmp" +
+        std::to_string(static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file << content;
+        if (!file) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string NativeRunCache::source_key(const Compiler::Options& opts) {
+    ContentHasher hasher;
+    add_compiler_identity(hasher);
+    hasher.add_string(absolute_path(opts.input_file));
+    hasher.add_string(absolute_path(opts.project_root));
+    hasher.add_string(opts.backend);
+    hasher.add_u64(static_cast<uint64_t>(opts.type_strictness));
+    hasher.add_tag(opts.check_all ? 'a' : '-');
+    hasher.add_u64(opts.cte_step_budget);
+    hasher.add_u64(opts.cte_memory_limit);
+    const std::map<std::string, std::string> backend_options(opts.backend_options.begin(),
+                                                             opts.backend_options.end());
+    hasher.add_u64(backend_options.size());
+    for (const auto& entry : backend_options) {
+        hasher.add_string(entry.first);
+        hasher.add_string(entry.second);
+    }
+    return hasher.hex();
+}
+
+std::string NativeRunCache::unit_key(const std::string& translation_unit) {
+    ContentHasher hasher;
+    add_compiler_identity(hasher);
+    hasher.add_string(translation_unit);
+    return hasher.hex();
+}
+
+std::string NativeRunCache::entry_path(const std::string& name) const {
+    return (std::filesystem::path(dir_) / "run" / name).string();
+}
+
+std::string NativeRunCache::executable_path(const std::string& unit_key) const {
+    const std::string path = entry_path(unit_key + ".exe");
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    return path;
+}
+
+std::string NativeRunCache::lookup_source(const std::string& source_key) const {
+    std::ifstream file(entry_path(source_key + ".manifest"), std::ios::binary);
+    if (!file) return std::string();
+    std::string line;
+    if (!std::getline(file, line) || line != kCacheHeader) return std::string();
+    std::string unit;
+    if (!std::getline(file, line) || line.compare(0, 5, "unit ") != 0) return std::string();
+    unit = line.substr(5);
+    // Remaining lines: `<kind> <digest> <path>`, kind `f` (file) or `d` (directory).
+    while (std::getline(file, line)) {
+        const size_t digest_end = line.find(' ', 2);
+        if (line.size() < 3 || line[1] != ' ' || digest_end == std::string::npos) return std::string();
+        const std::string digest = line.substr(2, digest_end - 2);
+        const std::string path = line.substr(digest_end + 1);
+        const std::string current = line[0] == 'f' ? file_digest(path)
+                                    : line[0] == 'd' ? directory_digest(path)
+                                                     : std::string();
+        if (current.empty() || current != digest) return std::string();
+    }
+    const std::string exe = entry_path(unit + ".exe");
+    std::error_code ec;
+    return std::filesystem::is_regular_file(exe, ec) ? exe : std::string();
+}
+
+void NativeRunCache::store_source(const std::string& source_key,
+                                  const std::string& unit_key,
+                                  const Compiler::Inputs& inputs) const {
+    std::ostringstream manifest;
+    manifest << kCacheHeader << "\n" << "unit " << unit_key << "\n";
+    for (const std::string& path : inputs.files) {
+        const std::string digest = file_digest(path);
+        if (digest.empty() || path.find('\n') != std::string::npos) return;
+        manifest << "f " << digest << " " << path << "\n";
+    }
+    for (const std::string& path : inputs.directories) {
+        if (path.find('\n') != std::string::npos) return;
+        manifest << "d " << directory_digest(path) << " " << path << "\n";
+    }
+    const std::string target = entry_path(source_key + ".manifest");
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(target).parent_path(), ec);
+    (void)write_atomically(target, manifest.str());
+}
+
+std::string default_run_cache_dir(const Compiler::Options& opts) {
+    std::filesystem::path dir = std::filesystem::path(opts.output_file).parent_path();
+    if (dir.empty()) dir = ".";
+    return (dir / ".vexel-cache").string();
+}
+
+int run_native_executable(const std::string& path, std::ostream& err) {
+#if defined(VEXEL_HAVE_FORK_EXEC)
+    std::cout.flush();
+    std::cerr.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        err << "Error: cannot start " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    if (pid == 0) {
+        char arg0[] = "vexel";
+        char* argv[] = {arg0, nullptr};
+        ::execv(path.c_str(), argv);
+        _exit(127);
+    }
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            err << "Error: cannot wait for " << path << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return 1;
+#else
+    err << "Error: cannot run cached executable " << path << " on this platform\n";
+    return 1;
+#endif
+}
+
+} // namespace vexel
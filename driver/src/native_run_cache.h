@@ -0,0 +1,50 @@
+#pragma once
+
+#include "compiler.h"
+
+#include <ostream>
+#include <string>
+
+namespace vexel {
+
+// Executable cache behind `--run --run-cache`. Entries live in `<dir>/run`:
+// - `<unit key>.exe`: the native executable built from one translation unit.
+//   The key hashes the unit text together with the compiler build.
+// - `<source key>.manifest`: for one input file and option set, the unit key
+//   of its last build plus a content hash of every file it read and a listing
+//   hash of every directory it depended on. While they all still match, the
+//   cached executable runs without invoking the frontend or tcc.
+class NativeRunCache {
+public:
+    explicit NativeRunCache(std::string dir) : dir_(std::move(dir)) {}
+
+    static std::string source_key(const Compiler::Options& opts);
+    static std::string unit_key(const std::string& translation_unit);
+
+    // Executable recorded for `source_key` when its manifest is current and the
+    // executable still exists; empty otherwise.
+    std::string lookup_source(const std::string& source_key) const;
+    // Best effort: a manifest that cannot be written just misses next time.
+    void store_source(const std::string& source_key,
+                      const std::string& unit_key,
+                      const Compiler::Inputs& inputs) const;
+    // Where the executable for `unit_key` is (or would be) stored; creates the
+    // entry directory.
+    std::string executable_path(const std::string& unit_key) const;
+
+    const std::string& dir() const { return dir_; }
+
+private:
+    std::string entry_path(const std::string& name) const;
+
+    std::string dir_;
+};
+
+// Default cache directory for `--run-cache` without a value.
+std::string default_run_cache_dir(const Compiler::Options& opts);
+
+// Runs a cached executable the way `--run` runs a program (argv[0] "vexel")
+// and returns its exit status; 128 + signal number if it was killed.
+int run_native_executable(const std::string& path, std::ostream& err);
+
+} // namespace vexel
@@ -1,9 +1,12 @@
 #include "native_tcc_runner.h"
 
+#include <filesystem>
+#include <iostream>
 #include <string>
 
 #if VEXEL_HAS_LIBTCC
 #include <libtcc.h>
+#include <unistd.h>
 #endif
 
 #if VEXEL_HAS_LIBTCC && defined(VEXEL_HAS_TCC_RUNTIME) && VEXEL_HAS_TCC_RUNTIME
@@ -19,6 +22,7 @@ namespace {
 #if VEXEL_HAS_NATIVE_TCC
 int compile_to_translation_unit(const Compiler::Options& opts,
                                 std::string& out,
+                                Compiler::Inputs& inputs,
                                 std::ostream& err) {
     Compiler compiler(opts);
     std::string compile_error;
@@ -26,6 +30,7 @@ int compile_to_translation_unit(const Compiler::Options& opts,
         err << "Error: " << compile_error << "\n";
         return 1;
     }
+    inputs = compiler.inputs();
     return 0;
 }
 #endif
@@ -45,6 +50,61 @@ void configure_tcc_include_paths(TCCState* state) {
     (void)tcc_add_sysinclude_path(state, VEXEL_GCC_SYS_INCLUDE_DIR);
 #endif
 }
+
+// Null on failure; tcc reports its own diagnostics through `err`.
+TCCState* compile_with_tcc(const std::string& translation_unit, int output_type, std::ostream& err) {
+    TCCState* state = tcc_new();
+    if (!state) {
+        err << "Error: failed to initialize libtcc state\n";
+        return nullptr;
+    }
+    tcc_set_error_func(state, &err, tcc_error_callback);
+    configure_tcc_include_paths(state);
+#if defined(VEXEL_TCC_RUNTIME_DIR)
+    tcc_set_lib_path(state, VEXEL_TCC_RUNTIME_DIR);
+#endif
+
+    if (tcc_set_output_type(state, output_type) < 0 ||
+        tcc_compile_string(state, translation_unit.c_str()) < 0) {
+        tcc_delete(state);
+        return nullptr;
+    }
+
+    // Many generated programs do not need libm, but adding it here keeps math calls portable.
+    (void)tcc_add_library(state, "m");
+    return state;
+}
+
+// Builds the executable for `translation_unit` into the cache unless it is
+// already there. Returns its path, or empty when tcc failed (`compile_failed`)
+// or the entry cannot be written.
+std::string cached_executable(const NativeRunCache& cache,
+                              const std::string& unit_key,
+                              const std::string& translation_unit,
+                              bool& compile_failed,
+                              std::ostream& err) {
+    compile_failed = false;
+    const std::string exe = cache.executable_path(unit_key);
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(exe, ec)) return exe;
+    TCCState* state = compile_with_tcc(translation_unit, TCC_OUTPUT_EXE, err);
+    if (!state) {
+        compile_failed = true;
+        return std::string();
+    }
+    const std::string tmp_path = exe + ".tmp" + std::to_string(static_cast<long>(::getpid()));
+    bool ok = tcc_output_file(state, tmp_path.c_str()) >= 0;
+    tcc_delete(state);
+    if (ok) {
+        std::filesystem::rename(tmp_path, exe, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(tmp_path, ec);
+        return std::string();
+    }
+    return exe;
+}
 #endif
 
 } // namespace
@@ -57,49 +117,70 @@ bool native_tcc_supported() {
 #endif
 }
 
-int run_native_with_tcc(const Compiler::Options& opts, NativeTccMode mode, std::ostream& err) {
+int run_native_with_tcc(const Compiler::Options& opts,
+                        NativeTccMode mode,
+                        std::ostream& err,
+                        const NativeRunCache* run_cache) {
 #if !VEXEL_HAS_LIBTCC
     (void)opts;
     (void)mode;
+    (void)run_cache;
     err << "Error: this vexel build does not include libtcc support\n";
     return 1;
 #elif !VEXEL_HAS_NATIVE_TCC
     (void)opts;
     (void)mode;
+    (void)run_cache;
     err << "Error: this vexel build is missing tcc runtime support files (libtcc1.a)\n";
     return 1;
 #else
+    const bool cached_run = run_cache && mode == NativeTccMode::Run;
+    std::string source_key;
+    // Process expressions may read anything, so their programs only reuse the
+    // executable of an identical translation unit and never skip the frontend.
+    if (cached_run && !opts.allow_process) {
+        source_key = NativeRunCache::source_key(opts);
+        const std::string exe = run_cache->lookup_source(source_key);
+        if (!exe.empty()) {
+            if (opts.verbose) {
+                std::cout << "Run cache: reusing " << exe << std::endl;
+            }
+            return run_native_executable(exe, err);
+        }
+    }
+
     std::string translation_unit;
-    int compile_status = compile_to_translation_unit(opts, translation_unit, err);
+    Compiler::Inputs inputs;
+    int compile_status = compile_to_translation_unit(opts, translation_unit, inputs, err);
     if (compile_status != 0) {
         return compile_status;
     }
 
-    TCCState* state = tcc_new();
-    if (!state) {
-        err << "Error: failed to initialize libtcc state\n";
-        return 1;
+    if (cached_run) {
+        const std::string unit_key = NativeRunCache::unit_key(translation_unit);
+        bool compile_failed = false;
+        const std::string exe = cached_executable(*run_cache, unit_key, translation_unit, compile_failed, err);
+        if (compile_failed) {
+            return 1;
+        }
+        if (!exe.empty()) {
+            if (!source_key.empty()) {
+                run_cache->store_source(source_key, unit_key, inputs);
+            }
+            if (opts.verbose) {
+                std::cout << "Run cache: running " << exe << std::endl;
+            }
+            return run_native_executable(exe, err);
+        }
+        // The cache directory is not writable: run in-process as without a cache.
     }
-    tcc_set_error_func(state, &err, tcc_error_callback);
-    configure_tcc_include_paths(state);
-#if defined(VEXEL_TCC_RUNTIME_DIR)
-    tcc_set_lib_path(state, VEXEL_TCC_RUNTIME_DIR);
-#endif
 
     int output_type = (mode == NativeTccMode::Run) ? TCC_OUTPUT_MEMORY : TCC_OUTPUT_EXE;
-    if (tcc_set_output_type(state, output_type) < 0) {
-        tcc_delete(state);
-        return 1;
-    }
-
-    if (tcc_compile_string(state, translation_unit.c_str()) < 0) {
-        tcc_delete(state);
+    TCCState* state = compile_with_tcc(translation_unit, output_type, err);
+    if (!state) {
         return 1;
     }
 
-    // Many generated programs do not need libm, but adding it here keeps math calls portable.
-    (void)tcc_add_library(state, "m");
-
     int status = 0;
     if (mode == NativeTccMode::Run) {
         char arg0[] = "vexel";
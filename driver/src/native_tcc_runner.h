@@ -1,6 +1,7 @@
 #pragma once
 
 #include "compiler.h"
+#include "native_run_cache.h"
 
 #include <ostream>
 
@@ -12,7 +13,12 @@ enum class NativeTccMode {
 };
 
 bool native_tcc_supported();
-int run_native_with_tcc(const Compiler::Options& opts, NativeTccMode mode, std::ostream& err);
+// With `run_cache`, NativeTccMode::Run builds a cached executable once and
+// runs it; see NativeRunCache.
+int run_native_with_tcc(const Compiler::Options& opts,
+                        NativeTccMode mode,
+                        std::ostream& err,
+                        const NativeRunCache* run_cache = nullptr);
 
 } // namespace vexel
 
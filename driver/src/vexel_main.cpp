@@ -1,5 +1,11 @@
 #include "backend_registry.h"
+#include "batch_compile.h"
 #include "cli_utils.h"
+#include "compile_server.h"
+#include "compiler_session.h"
+#include "module_cache.h"
+#include "native_cc_runner.h"
+#include "native_run_cache.h"
 #include "native_tcc_runner.h"
 #include <iostream>
 #include <cstring>
@@ -28,13 +34,47 @@ void print_usage(const char* prog,
     }
     std::cout << "\n";
     std::cout << "  --emit-analysis Emit analysis report alongside backend output\n";
+    std::cout << "  --emit-analysis=jsonl Emit the analysis report as JSON lines (<stem>.analysis.jsonl)\n";
     std::cout << "  --allow-process Enable process expressions (executes host commands; disabled by default)\n";
+    std::cout << "  --check-all   Type-check every function body, including ones nothing reaches\n";
     std::cout << "  --type-strictness <0|1|2> Literal/type strictness (0 relaxed, 1 annotated-locals, 2 full)\n";
     std::cout << "  --strict-types[=full] Alias for --type-strictness=1 (or 2 with '=full')\n";
     std::cout << "  --backend-opt <k=v> Backend-specific option (repeatable)\n";
+    std::cout << "  --time-passes Print per-stage wall time, peak RSS growth and AST size to stderr\n";
+    std::cout << "  --stats-json <path> Write the same per-stage stats as JSON\n";
+    std::cout << "  --trace <file.json> Write a Chrome/Perfetto trace-event timeline of parsing, type checking, optimization, analysis and emission\n";
+    std::cout << "  -MD          Write a make/ninja dependency file listing every module, resource and resource directory read (<stem>.d)\n";
+    std::cout << "  --depfile <path> Write the dependency file to <path> instead\n";
+    std::cout << "  --cte-profile Print per-function and per-initializer compile-time evaluation counters to stderr\n";
+    std::cout << "  --cte-step-budget=<n> Evaluation steps each compile-time query may take (default 10000000)\n";
+    std::cout << "  --cte-memory-limit=<bytes>[K|M|G] Live value memory each compile-time query may hold (default 1G)\n";
+    std::cout << "  --pass-invariants=<level> Structural checks between frontend stages: off, boundary, sampled[:<period>[:<seed>]] or full (default off)\n";
+    std::cout << "  --cte-cache[=<dir>] Reuse pure compile-time call results across builds (default <output dir>/.vexel-cache)\n";
+    std::cout << "  --parse-cache[=<dir>] Reuse parsed modules of unchanged source files across builds (default <output dir>/.vexel-cache)\n";
+    std::cout << "  --incremental[=<dir>] Skip builds whose inputs and outputs are unchanged; implies the parse and CTE caches (default <output dir>/.vexel-cache)\n";
+    std::cout << "  --emit-analyzed <path> Also write the analyzed program (the frontend's result) to <path>\n";
+    std::cout << "  --from-analyzed <path> Emit from an analyzed program written by --emit-analyzed instead of an input file\n";
+    std::cout << "  --analyzed-cache[=<dir>] Skip the frontend when only backend options changed since a build with unchanged inputs (default <output dir>/.vexel-cache)\n";
+    std::cout << "  --process-cache[=<dir>] Run identical process commands once and reuse outputs across builds (default <output dir>/.vexel-cache)\n";
+    std::cout << "  --process-input <path> File whose contents key process-cache entries (repeatable)\n";
+    std::cout << "  -j, --jobs <n> Worker threads for parallel frontend stages (default: hardware concurrency)\n";
+    std::cout << "  --parallel-typecheck Type-check independent module instances concurrently on the --jobs workers\n";
+    std::cout << "  --parallel-optimize Evaluate independent compile-time fact queries concurrently on the --jobs workers\n";
+    std::cout << "  --parallel-codegen Generate C function bodies concurrently on the --jobs workers (same output as serial)\n";
+    std::cout << "  --batch <list> Compile every entry listed in <list> in one process, sharing parsed modules (-o names the output directory, default out)\n";
     if (has_native_tcc) {
         std::cout << "  --run         Compile with backend c and run in-process via libtcc (no .c/.h output)\n";
         std::cout << "  --emit-exe    Compile with backend c and emit native executable via libtcc\n";
+        std::cout << "  --run-cache[=<dir>] With --run, reuse a cached executable while its sources are unchanged (default <output dir>/.vexel-cache)\n";
+    }
+    if (vexel::native_cc_supported()) {
+        std::cout << "  --native-cc=<cc> With --emit-exe, build with host C compiler <cc> (e.g. gcc, clang) instead of libtcc\n";
+        std::cout << "  -O<level>    Optimization level for --native-cc (default 2)\n";
+        std::cout << "  --native-cflag=<flag> Extra --native-cc compiler flag, e.g. -flto or -march=native (repeatable)\n";
+    }
+    if (vexel::compile_server_supported()) {
+        std::cout << "  --serve <socket> Run a compile server on a Unix socket, keeping parsed modules warm across requests\n";
+        std::cout << "  --connect <socket> [options] <input.vx> Compile through a running server (--shutdown stops it)\n";
     }
     std::cout << "  -v           Verbose output\n";
     std::cout << "  -h           Show this help\n";
@@ -56,9 +96,8 @@ void print_usage(const char* prog,
     }
 }
 
-} // namespace
-
-int main(int argc, char** argv) {
+// One compiler invocation; `resident` is set when serving requests.
+int run_cli(int argc, char** argv, const vexel::ResidentModuleCache* resident) {
     std::vector<vexel::BackendInfo> available_backends = vexel::list_backends();
     if (available_backends.empty()) {
         std::cerr << "No backends available\n";
@@ -68,8 +107,23 @@ int main(int argc, char** argv) {
     bool help_requested = false;
     bool run_requested = false;
     bool emit_exe_requested = false;
+    bool run_cache_requested = false;
+    std::string run_cache_dir;
+    bool native_cc_requested = false;
+    bool native_cc_flags_given = false;
+    vexel::NativeCcOptions native_cc;
+    std::string batch_list;
     std::string selected_backend_name;
     for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 >= argc || argv[i + 1][0] == '\0') {
+                std::cerr << "Error: --batch requires a list file\n";
+                print_usage(argv[0], available_backends);
+                return 1;
+            }
+            batch_list = argv[++i];
+            continue;
+        }
         if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
             help_requested = true;
             continue;
@@ -82,6 +136,50 @@ int main(int argc, char** argv) {
             emit_exe_requested = true;
             continue;
         }
+        if (std::strcmp(argv[i], "--run-cache") == 0) {
+            run_cache_requested = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--run-cache=", std::strlen("--run-cache=")) == 0) {
+            run_cache_dir = argv[i] + std::strlen("--run-cache=");
+            if (run_cache_dir.empty()) {
+                std::cerr << "Error: --run-cache requires a non-empty directory\n";
+                print_usage(argv[0], available_backends);
+                return 1;
+            }
+            run_cache_requested = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--native-cc=", std::strlen("--native-cc=")) == 0) {
+            native_cc.compiler = argv[i] + std::strlen("--native-cc=");
+            if (native_cc.compiler.empty()) {
+                std::cerr << "Error: --native-cc requires a compiler name\n";
+                print_usage(argv[0], available_backends);
+                return 1;
+            }
+            native_cc_requested = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "-O", 2) == 0) {
+            native_cc.opt_level = argv[i] + 2;
+            if (native_cc.opt_level.empty()) {
+                std::cerr << "Error: -O requires a level (for example -O2)\n";
+                print_usage(argv[0], available_backends);
+                return 1;
+            }
+            native_cc_flags_given = true;
+            continue;
+        }
+        if (std::strncmp(argv[i], "--native-cflag=", std::strlen("--native-cflag=")) == 0) {
+            native_cc.flags.push_back(argv[i] + std::strlen("--native-cflag="));
+            if (native_cc.flags.back().empty()) {
+                std::cerr << "Error: --native-cflag requires a non-empty flag\n";
+                print_usage(argv[0], available_backends);
+                return 1;
+            }
+            native_cc_flags_given = true;
+            continue;
+        }
         std::string parsed_backend;
         std::string parse_error;
         if (vexel::try_read_backend_arg(argc, argv, i, parsed_backend, parse_error)) {
@@ -105,7 +203,31 @@ int main(int argc, char** argv) {
         print_usage(argv[0], available_backends);
         return 1;
     }
+    if (run_cache_requested && !run_requested) {
+        std::cerr << "Error: --run-cache requires --run\n";
+        print_usage(argv[0], available_backends);
+        return 1;
+    }
+    if (native_cc_requested && !emit_exe_requested) {
+        std::cerr << "Error: --native-cc requires --emit-exe\n";
+        print_usage(argv[0], available_backends);
+        return 1;
+    }
+    if (native_cc_flags_given && !native_cc_requested) {
+        std::cerr << "Error: -O and --native-cflag require --native-cc\n";
+        print_usage(argv[0], available_backends);
+        return 1;
+    }
     bool native_mode = run_requested || emit_exe_requested;
+    if (!batch_list.empty() && native_mode) {
+        std::cerr << "Error: --batch cannot be combined with --run or --emit-exe\n";
+        print_usage(argv[0], available_backends);
+        return 1;
+    }
+    if (native_mode && resident) {
+        std::cerr << "Error: --run/--emit-exe are not available through the compile server\n";
+        return 1;
+    }
 
     const vexel::Backend* selected_backend = nullptr;
     if (!selected_backend_name.empty()) {
@@ -131,96 +253,149 @@ int main(int argc, char** argv) {
             print_usage(argv[0], available_backends, selected_backend);
             return 1;
         }
-        if (!vexel::native_tcc_supported()) {
+        if (native_cc_requested && !vexel::native_cc_supported()) {
+            std::cerr << "Error: --native-cc is unavailable on this platform\n";
+            return 1;
+        }
+        if (!native_cc_requested && !vexel::native_tcc_supported()) {
             std::cerr << "Error: --run/--emit-exe are unavailable in this build (libtcc+tcc runtime not detected)\n";
             return 1;
         }
     }
 
     vexel::Compiler::Options opts;
-    opts.output_file = "out";
+    // In batch mode -o names the output directory.
+    opts.output_file = batch_list.empty() ? "out" : "";
     opts.backend = selected_backend_name;
+    opts.resident_modules = resident;
 
+    // Driver-only flags were handled above; the session parser takes the rest.
+    std::vector<std::string> compiler_args;
     for (int i = 1; i < argc; i++) {
         if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
             continue;
         }
-        if (std::strcmp(argv[i], "--run") == 0 || std::strcmp(argv[i], "--emit-exe") == 0) {
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            ++i;
             continue;
         }
-        std::string parse_error;
-        if (vexel::try_parse_common_compiler_option(argc, argv, i, opts, parse_error)) {
-            if (!parse_error.empty()) {
-                std::cerr << "Error: " << parse_error << "\n";
-                print_usage(argv[0], available_backends, selected_backend);
-                return 1;
-            }
-        } else if (vexel::try_parse_backend_opt_arg(argc, argv, i, opts, parse_error)) {
-            if (!parse_error.empty()) {
-                std::cerr << "Error: " << parse_error << "\n";
-                print_usage(argv[0], available_backends, selected_backend);
-                return 1;
-            }
-        } else if (std::strcmp(argv[i], "-b") == 0 || std::strcmp(argv[i], "--backend") == 0 ||
-                   std::strncmp(argv[i], "--backend=", std::strlen("--backend=")) == 0) {
-            std::string backend_name;
-            std::string backend_parse_error;
-            if (!vexel::try_read_backend_arg(argc, argv, i, backend_name, backend_parse_error)) {
-                std::cerr << "Error: Failed to parse backend argument\n";
-                print_usage(argv[0], available_backends, selected_backend);
-                return 1;
-            }
-            if (!backend_parse_error.empty()) {
-                std::cerr << "Error: " << backend_parse_error << "\n";
-                print_usage(argv[0], available_backends, selected_backend);
-                return 1;
-            }
-            if (backend_name != selected_backend_name) {
-                std::cerr << "Error: Conflicting backend selection '" << backend_name
-                          << "' (expected '" << selected_backend_name << "')\n";
-                print_usage(argv[0], available_backends, selected_backend);
-                return 1;
-            }
-        } else if (argv[i][0] == '-') {
-            if (selected_backend && selected_backend->parse_option) {
-                int backend_idx = i;
-                std::string backend_error;
-                bool handled = selected_backend->parse_option(argc, argv, backend_idx, opts, backend_error);
-                if (handled) {
-                    if (!backend_error.empty()) {
-                        std::cerr << "Error: " << backend_error << "\n";
-                        print_usage(argv[0], available_backends, selected_backend);
-                        return 1;
-                    }
-                    i = backend_idx;
-                    continue;
-                }
-            }
-            std::cerr << "Error: Unknown option: " << argv[i] << "\n";
+        if (std::strcmp(argv[i], "--run") == 0 || std::strcmp(argv[i], "--emit-exe") == 0 ||
+            std::strncmp(argv[i], "--run-cache", std::strlen("--run-cache")) == 0 ||
+            std::strncmp(argv[i], "--native-cc=", std::strlen("--native-cc=")) == 0 ||
+            std::strncmp(argv[i], "--native-cflag=", std::strlen("--native-cflag=")) == 0 ||
+            std::strncmp(argv[i], "-O", 2) == 0) {
+            continue;
+        }
+        compiler_args.push_back(argv[i]);
+    }
+    std::string parse_error;
+    if (!vexel::CompilerSession::parse_arguments(compiler_args, opts, parse_error)) {
+        std::cerr << "Error: " << parse_error << "\n";
+        print_usage(argv[0], available_backends, selected_backend);
+        return 1;
+    }
+
+    if (opts.emit_depfile && native_mode) {
+        // The native paths write no backend outputs for a rule to name.
+        std::cerr << "Error: -MD/--depfile cannot be combined with --run or --emit-exe\n";
+        print_usage(argv[0], available_backends, selected_backend);
+        return 1;
+    }
+
+    if (!opts.from_analyzed.empty()) {
+        // The analyzed program is the whole input, and neither the
+        // fingerprint database nor the run cache records it.
+        const char* conflict = !batch_list.empty()       ? "--batch"
+                               : !opts.input_file.empty() ? "an input file"
+                               : opts.incremental         ? "--incremental"
+                               : run_cache_requested      ? "--run-cache"
+                                                          : nullptr;
+        if (conflict) {
+            std::cerr << "Error: --from-analyzed cannot be combined with " << conflict << "\n";
+            print_usage(argv[0], available_backends, selected_backend);
+            return 1;
+        }
+    }
+
+    if (!batch_list.empty()) {
+        if (!opts.input_file.empty()) {
+            std::cerr << "Error: --batch takes its inputs from the list; got input file '" << opts.input_file
+                      << "'\n";
+            print_usage(argv[0], available_backends, selected_backend);
+            return 1;
+        }
+        if (!opts.stats_json.empty()) {
+            std::cerr << "Error: --stats-json cannot be combined with --batch\n";
+            print_usage(argv[0], available_backends, selected_backend);
+            return 1;
+        }
+        if (!opts.trace.empty()) {
+            std::cerr << "Error: --trace cannot be combined with --batch\n";
+            print_usage(argv[0], available_backends, selected_backend);
+            return 1;
+        }
+        if (!opts.depfile.empty()) {
+            std::cerr << "Error: --depfile cannot be combined with --batch (use -MD)\n";
             print_usage(argv[0], available_backends, selected_backend);
             return 1;
-        } else {
-            if (!opts.input_file.empty()) {
-                std::cerr << "Error: Multiple input files specified ('" << opts.input_file
-                          << "' and '" << argv[i] << "')\n";
-                print_usage(argv[0], available_backends, selected_backend);
-                return 1;
-            }
-            opts.input_file = argv[i];
+        }
+        const std::string output_dir = opts.output_file.empty() ? "out" : opts.output_file;
+        opts.output_file = "out";
+        try {
+            const vexel::CompilerSession session(opts);
+            return vexel::run_batch_compile(session, batch_list, output_dir, std::cerr);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
         }
     }
 
-    if (opts.input_file.empty()) {
+    if (opts.input_file.empty() && opts.from_analyzed.empty()) {
         std::cerr << "Error: No input file specified\n";
         print_usage(argv[0], available_backends, selected_backend);
         return 1;
     }
 
+    if (native_cc_requested) {
+        return vexel::emit_exe_with_native_cc(opts, native_cc, std::cerr);
+    }
     if (native_mode) {
         vexel::NativeTccMode mode = run_requested ? vexel::NativeTccMode::Run
                                                   : vexel::NativeTccMode::EmitExe;
+        if (run_cache_requested) {
+            const vexel::NativeRunCache run_cache(run_cache_dir.empty() ? vexel::default_run_cache_dir(opts)
+                                                                        : run_cache_dir);
+            return vexel::run_native_with_tcc(opts, mode, std::cerr, &run_cache);
+        }
         return vexel::run_native_with_tcc(opts, mode, std::cerr);
     }
 
     return vexel::run_compiler_with_diagnostics(opts, std::cerr);
 }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const bool serve = argc >= 2 && std::strcmp(argv[1], "--serve") == 0;
+    const bool connect = argc >= 2 && std::strcmp(argv[1], "--connect") == 0;
+    if (!serve && !connect) {
+        return run_cli(argc, argv, nullptr);
+    }
+    if (argc < 3 || (serve && argc != 3)) {
+        std::cerr << "Error: " << argv[1] << (serve ? " expects exactly one socket path\n"
+                                                    : " expects a socket path followed by compiler options\n");
+        return 1;
+    }
+    if (connect) {
+        std::vector<std::string> args = {argv[0]};
+        args.insert(args.end(), argv + 3, argv + argc);
+        return vexel::forward_compile_request(argv[2], args, std::cout, std::cerr);
+    }
+    vexel::ResidentModuleCache resident;
+    return vexel::serve_compile_requests(argv[2], [&](const std::vector<std::string>& args) {
+        std::vector<char*> request_argv;
+        for (const auto& arg : args) request_argv.push_back(const_cast<char*>(arg.c_str()));
+        request_argv.push_back(nullptr);
+        return run_cli(static_cast<int>(args.size()), request_argv.data(), &resident);
+    }, std::cerr);
+}
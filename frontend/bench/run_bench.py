@@ -0,0 +1,320 @@
+#!/usr/bin/env python3
+"""Compiler benchmark suite behind `make bench`.
+
+Generates synthetic programs that stress one dimension of the frontend each,
+compiles every program repeatedly with `--stats-json`, and reports the median
+and p95 wall time of each pipeline stage. Results go to a JSON file that a
+later run can take as `--baseline` to flag stage regressions between compiler
+versions.
+"""
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+
+def find_repo_root(start: Path) -> Path:
+    for parent in [start] + list(start.parents):
+        if (parent / "docs" / "vexel-rfc.md").is_file():
+            return parent
+    raise RuntimeError("Could not locate repo root")
+
+
+# Workload generators. Each takes a size and a scratch directory, writes the
+# program there and returns the entry file.
+
+def gen_modules(size: int, work: Path) -> Path:
+    """`size` modules in an import chain; main imports every one of them."""
+    for i in range(size):
+        lines = []
+        if i > 0:
+            lines.append(f"::m{i - 1};")
+            lines.append("")
+        lines.append(f"&step{i}(x:#i32) -> #i32 {{ x * 3 + {i} }}")
+        prev = f"m{i - 1}::value{i - 1}(x)" if i > 0 else "x"
+        lines.append(f"&value{i}(x:#i32) -> #i32 {{ step{i}({prev}) - x }}")
+        (work / f"m{i}.vx").write_text("\n".join(lines) + "\n")
+    entry = work / "main.vx"
+    lines = [f"::m{i};" for i in range(size)]
+    lines.append("")
+    lines.append("&^main(x:#i32) -> #i32 {")
+    lines.append("    0" + "".join(f" + m{i}::value{i}(x)" for i in range(size)))
+    lines.append("}")
+    entry.write_text("\n".join(lines) + "\n")
+    return entry
+
+
+def gen_generics(size: int, work: Path) -> Path:
+    """Two nested generic functions instantiated for `size` distinct structs."""
+    lines = [f"#S{i}(v:#i32, k:#i32);" for i in range(size)]
+    lines.append("")
+    lines.append("&pick(a, b) { b }")
+    lines.append("&first(a, b) { pick(b, a) }")
+    lines.append("")
+    lines.append("&^main(x:#i32) -> #i32 {")
+    for i in range(size):
+        lines.append(f"    s{i}:#S{i} = first(#S{i}(x, {i}), x);")
+    lines.append("    0" + "".join(f" + s{i}.v" for i in range(size)))
+    lines.append("}")
+    entry = work / "main.vx"
+    entry.write_text("\n".join(lines) + "\n")
+    return entry
+
+
+def gen_cte_loop(size: int, work: Path) -> Path:
+    """A global constant computed by a `size`-iteration loop at compile time."""
+    entry = work / "main.vx"
+    entry.write_text(
+        "&mix(n:#i64) -> #i64 {\n"
+        "    i:#i64 = 0;\n"
+        "    acc:#i64 = 0;\n"
+        "    (i < n)@{\n"
+        "        acc = acc + (i * 3 - acc / 7);\n"
+        "        i = i + 1;\n"
+        "    };\n"
+        "    acc\n"
+        "}\n"
+        f"TOTAL:#i64 = mix({size});\n"
+        "&^main() -> #i64 { TOTAL }\n")
+    return entry
+
+
+def gen_ast_depth(size: int, work: Path) -> Path:
+    """One expression nested `size` levels deep."""
+    expr = "x"
+    for i in range(size):
+        expr = f"({expr} + {i % 7} * x)" if i % 2 else f"(x - {expr})"
+    entry = work / "main.vx"
+    entry.write_text(f"&^main(x:#i32) -> #i32 {{\n    {expr}\n}}\n")
+    return entry
+
+
+def gen_call_depth(size: int, work: Path) -> Path:
+    """A call chain `size` functions deep over a runtime argument."""
+    lines = ["&f0(x:#i32) -> #i32 { x + 1 }"]
+    for i in range(1, size):
+        lines.append(f"&f{i}(x:#i32) -> #i32 {{ f{i - 1}(x * 3 - {i % 5}) + {i % 11} }}")
+    lines.append(f"&^main(x:#i32) -> #i32 {{ f{size - 1}(x) }}")
+    entry = work / "main.vx"
+    entry.write_text("\n".join(lines) + "\n")
+    return entry
+
+
+def gen_global_chain(size: int, work: Path) -> Path:
+    """`size` global constants, each reading its predecessor and one further back."""
+    lines = ["&g(v:#i32) -> #i32 { v * 3 - v - v + 1 }", "C0:#i32 = 1;", "C1:#i32 = 2;"]
+    for i in range(2, size):
+        lines.append(f"C{i}:#i32 = g(C{i - 1}) + (C{i // 2} > 100 ? 1 : 0);")
+    lines.append(f"&^main() -> #i32 {{ C{size - 1} }}")
+    entry = work / "main.vx"
+    entry.write_text("\n".join(lines) + "\n")
+    return entry
+
+
+def gen_cte_string_scan(size: int, work: Path) -> Path:
+    """A compile-time checksum over a `size`-byte embedded resource."""
+    (work / "blob.bin").write_bytes(bytes((i * 131 + 7) % 256 for i in range(size)))
+    entry = work / "main.vx"
+    entry.write_text(
+        "blob:#s = ::blob.bin;\n"
+        "&checksum(s:#s) -> #u32 {\n"
+        "    acc:#u32 = 0;\n"
+        "    i = 0;\n"
+        "    (i < |s|)@{\n"
+        "        acc = acc * 31 + s[i];\n"
+        "        i = i + 1;\n"
+        "    };\n"
+        "    acc\n"
+        "}\n"
+        "SUM = checksum(blob);\n"
+        "&^main() -> #u32 { SUM }\n")
+    return entry
+
+
+WORKLOADS = {
+    "modules": (gen_modules, [8, 32, 128]),
+    "generics": (gen_generics, [16, 64, 256]),
+    "cte-loop": (gen_cte_loop, [2000, 20000, 100000]),
+    "ast-depth": (gen_ast_depth, [64, 256, 1024]),
+    "call-depth": (gen_call_depth, [64, 256, 1024]),
+    "global-chain": (gen_global_chain, [100, 400, 1600]),
+    "cte-string-scan": (gen_cte_string_scan, [10000, 40000, 160000]),
+}
+
+
+def percentile(values, fraction):
+    """Nearest-rank percentile; the median is percentile(values, 0.5)."""
+    ordered = sorted(values)
+    rank = max(1, -(-len(ordered) * fraction // 1))
+    return ordered[int(rank) - 1]
+
+
+def summarize(values):
+    return {
+        "median_ms": round(percentile(values, 0.5), 3),
+        "p95_ms": round(percentile(values, 0.95), 3),
+        "min_ms": round(min(values), 3),
+        "max_ms": round(max(values), 3),
+    }
+
+
+def run_case(vexel: Path, backend: str, entry: Path, trials: int, warmup: int):
+    """Compiles `entry` warmup + trials times and aggregates the stats."""
+    stats_path = entry.parent / "stats.json"
+    out_path = entry.parent / "out" / "main"
+    stage_samples = {}
+    stage_order = []
+    totals = []
+    process = []
+    peaks = []
+    cmd = [str(vexel), "-b", backend, f"--stats-json={stats_path}", "-o", str(out_path), str(entry)]
+    for trial in range(warmup + trials):
+        stats_path.unlink(missing_ok=True)
+        started = time.perf_counter()
+        result = subprocess.run(cmd, cwd=entry.parent, capture_output=True, text=True)
+        elapsed_ms = (time.perf_counter() - started) * 1000.0
+        if result.returncode != 0 or not stats_path.is_file():
+            raise RuntimeError(f"{' '.join(cmd)} failed ({result.returncode}):\n{result.stderr}")
+        if trial < warmup:
+            continue
+        stats = json.loads(stats_path.read_text())
+        per_stage = {}
+        for stage in stats["stages"]:
+            # Stages that run more than once (per module or per phase) add up.
+            per_stage[stage["name"]] = per_stage.get(stage["name"], 0.0) + stage["wall_ms"]
+        for name, wall_ms in per_stage.items():
+            if name not in stage_samples:
+                stage_samples[name] = []
+                stage_order.append(name)
+            stage_samples[name].append(wall_ms)
+        totals.append(stats["total_wall_ms"])
+        process.append(elapsed_ms)
+        peaks.append(stats["peak_rss_kb"])
+    return {
+        "stages": {name: summarize(stage_samples[name]) for name in stage_order},
+        "total": summarize(totals),
+        "process": summarize(process),
+        "peak_rss_kb": int(percentile(peaks, 0.5)),
+    }
+
+
+def compiler_identity(root: Path, vexel: Path):
+    identity = {"binary": str(vexel), "host": platform.node(), "machine": platform.machine()}
+    try:
+        stat = vexel.stat()
+        identity["binary_size"] = stat.st_size
+        identity["binary_mtime"] = int(stat.st_mtime)
+    except OSError:
+        pass
+    try:
+        rev = subprocess.run(["git", "-C", str(root), "rev-parse", "--short", "HEAD"],
+                             capture_output=True, text=True, check=True).stdout.strip()
+        identity["git_rev"] = rev
+    except (OSError, subprocess.CalledProcessError):
+        pass
+    return identity
+
+
+def compare(results, baseline, threshold):
+    """Prints stage medians that grew by more than `threshold` (a fraction)
+    against the baseline and returns how many did."""
+    previous = {(case["workload"], case["size"]): case for case in baseline.get("cases", [])}
+    regressions = 0
+    for case in results["cases"]:
+        old = previous.get((case["workload"], case["size"]))
+        if old is None:
+            continue
+        rows = list(case["stages"].items()) + [("total", case["total"])]
+        old_rows = dict(old["stages"])
+        old_rows["total"] = old["total"]
+        for name, summary in rows:
+            before = old_rows.get(name)
+            # Sub-millisecond stages are dominated by noise.
+            if before is None or before["median_ms"] < 1.0:
+                continue
+            ratio = summary["median_ms"] / before["median_ms"]
+            if ratio > 1.0 + threshold:
+                regressions += 1
+                print(f"REGRESSION {case['workload']}/{case['size']} {name}: "
+                      f"{before['median_ms']:.3f}ms -> {summary['median_ms']:.3f}ms ({ratio:.2f}x)")
+    return regressions
+
+
+def print_case(case):
+    print(f"{case['workload']} size={case['size']}: total median {case['total']['median_ms']:.3f}ms "
+          f"p95 {case['total']['p95_ms']:.3f}ms, peak {case['peak_rss_kb']}kB")
+    for name, summary in case["stages"].items():
+        if summary["median_ms"] >= 0.05:
+            print(f"  {name:<18}{summary['median_ms']:>10.3f}{summary['p95_ms']:>10.3f}")
+
+
+def main() -> int:
+    root = find_repo_root(Path(__file__).resolve().parent)
+    build_dir = Path(os.environ.get("BUILD_DIR", root / "build"))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--vexel", type=Path, default=build_dir / "vexel", help="compiler binary")
+    parser.add_argument("--backend", default="vexel", help="backend to emit with (default: vexel)")
+    parser.add_argument("--trials", type=int, default=5, help="measured runs per case (default: 5)")
+    parser.add_argument("--warmup", type=int, default=1, help="unmeasured runs per case (default: 1)")
+    parser.add_argument("--workload", action="append", choices=sorted(WORKLOADS),
+                        help="run only this workload (repeatable)")
+    parser.add_argument("--sizes", help="comma-separated sizes overriding each workload's defaults")
+    parser.add_argument("--scale", type=float, default=1.0, help="multiply every size (default: 1)")
+    parser.add_argument("--output", type=Path, default=build_dir / "bench.json", help="results file")
+    parser.add_argument("--baseline", type=Path, help="earlier results file to compare against")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="median growth counted as a regression (default: 0.10)")
+    args = parser.parse_args()
+
+    if not args.vexel.is_file():
+        print(f"compiler not found: {args.vexel} (run make first)", file=sys.stderr)
+        return 2
+    if args.trials < 1 or args.warmup < 0:
+        print("--trials must be at least 1 and --warmup non-negative", file=sys.stderr)
+        return 2
+
+    results = {
+        "format": 1,
+        "compiler": compiler_identity(root, args.vexel),
+        "backend": args.backend,
+        "trials": args.trials,
+        "warmup": args.warmup,
+        "cases": [],
+    }
+    sizes_override = [int(s) for s in args.sizes.split(",")] if args.sizes else None
+    for name in args.workload or list(WORKLOADS):
+        generator, default_sizes = WORKLOADS[name]
+        for base in sizes_override or default_sizes:
+            size = max(1, int(base * args.scale))
+            with tempfile.TemporaryDirectory(prefix=f"vexel-bench-{name}-") as tmp:
+                entry = generator(size, Path(tmp))
+                try:
+                    summary = run_case(args.vexel, args.backend, entry, args.trials, args.warmup)
+                except RuntimeError as err:
+                    print(f"{name} size={size}: {err}", file=sys.stderr)
+                    return 1
+            case = {"workload": name, "size": size}
+            case.update(summary)
+            results["cases"].append(case)
+            print_case(case)
+
+    args.output.parent.mkdir(parents=True, exist_ok=True)
+    args.output.write_text(json.dumps(results, indent=2) + "\n")
+    print(f"Wrote {args.output}")
+
+    if args.baseline:
+        regressions = compare(results, json.loads(args.baseline.read_text()), args.threshold)
+        if regressions:
+            print(f"{regressions} stage median(s) regressed by more than {args.threshold:.0%}")
+            return 1
+        print("No regressions against baseline")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
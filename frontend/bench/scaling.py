@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Asymptotic scaling gate for compiler pipeline stages.
+
+Compiles one `run_bench.py` workload at several sizes, fits the growth
+exponent of each bounded stage's wall time (least squares over log time
+against log size) and fails when that exponent exceeds what the declared
+complexity class grows by over the same sizes, plus a tolerance:
+
+    scaling.py --workload modules --sizes 16,32,64,128 \\
+        --bound resolve=n --bound analysis=nlogn
+
+Classes are `1`, `logn`, `n`, `nlogn` and `n2`. Each size is compiled
+`--trials` times and its fastest run is fitted, which keeps scheduler noise
+out of the slope.
+"""
+import argparse
+import math
+import sys
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+import run_bench  # noqa: E402
+
+
+CLASSES = {
+    "1": lambda n: 1.0,
+    "logn": lambda n: math.log(n),
+    "n": lambda n: float(n),
+    "nlogn": lambda n: n * math.log(n),
+    "n2": lambda n: float(n) * n,
+}
+
+
+def fit_exponent(sizes, values):
+    """Slope of log(value) over log(size)."""
+    xs = [math.log(s) for s in sizes]
+    ys = [math.log(max(v, 1e-6)) for v in values]
+    mean_x = sum(xs) / len(xs)
+    mean_y = sum(ys) / len(ys)
+    num = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys))
+    den = sum((x - mean_x) ** 2 for x in xs)
+    return num / den
+
+
+def parse_bound(text):
+    stage, sep, cls = text.partition("=")
+    if not sep or not stage or cls not in CLASSES:
+        raise argparse.ArgumentTypeError(
+            f"expected <stage>=<class> with class one of {', '.join(CLASSES)}: {text}")
+    return stage, cls
+
+
+def fastest_stage_times(vexel, generator, size, trials):
+    with tempfile.TemporaryDirectory(prefix="vexel-scaling-") as tmp:
+        entry = generator(size, Path(tmp))
+        summary = run_bench.run_case(vexel, "vexel", entry, trials, 0)
+    times = {name: stage["min_ms"] for name, stage in summary["stages"].items()}
+    times["total"] = summary["total"]["min_ms"]
+    return times
+
+
+def main() -> int:
+    root = run_bench.find_repo_root(Path(__file__).resolve().parent)
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--vexel", type=Path, default=root / "build" / "vexel", help="compiler binary")
+    parser.add_argument("--workload", required=True, choices=sorted(run_bench.WORKLOADS))
+    parser.add_argument("--sizes", required=True, help="comma-separated sizes, at least three")
+    parser.add_argument("--bound", action="append", type=parse_bound, required=True,
+                        help="<stage>=<class>; `total` bounds the whole pipeline (repeatable)")
+    parser.add_argument("--trials", type=int, default=3, help="runs per size (default: 3)")
+    parser.add_argument("--tolerance", type=float, default=0.3,
+                        help="exponent slack over the declared class (default: 0.3)")
+    parser.add_argument("--min-ms", type=float, default=2.0,
+                        help="stages below this at the largest size are too small to fit (default: 2)")
+    args = parser.parse_args()
+
+    sizes = sorted({int(s) for s in args.sizes.split(",")})
+    if len(sizes) < 3 or sizes[0] < 2:
+        print("--sizes needs at least three distinct sizes of 2 or more", file=sys.stderr)
+        return 2
+    generator = run_bench.WORKLOADS[args.workload][0]
+    try:
+        samples = [fastest_stage_times(args.vexel, generator, size, args.trials) for size in sizes]
+    except RuntimeError as err:
+        print(err, file=sys.stderr)
+        return 1
+
+    failures = 0
+    for stage, cls in args.bound:
+        values = [sample.get(stage) for sample in samples]
+        if any(value is None for value in values):
+            print(f"{args.workload}: stage '{stage}' missing from the stats report", file=sys.stderr)
+            failures += 1
+            continue
+        if values[-1] < args.min_ms:
+            continue
+        measured = fit_exponent(sizes, values)
+        allowed = fit_exponent(sizes, [CLASSES[cls](n) for n in sizes]) + args.tolerance
+        if measured > allowed:
+            timings = ", ".join(f"{n}: {v:.2f}ms" for n, v in zip(sizes, values))
+            print(f"{args.workload}: {stage} grows as n^{measured:.2f}, bound O({cls}) allows "
+                  f"n^{allowed:.2f} ({timings})", file=sys.stderr)
+            failures += 1
+    if failures:
+        return 1
+    print("ok")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,6 +1,7 @@
 #include "analysis.h"
 #include "ast_walk.h"
 #include "optimizer.h"
+#include "pipeline_trace.h"
 #include "program.h"
 #include "typechecker.h"
 
@@ -30,7 +31,7 @@ bool Analyzer::global_initializer_runs_at_runtime(const Symbol* sym) const {
         return true;
     }
     const ExprFactKey key = expr_fact_key(sym->instance_id, sym->declaration->var_init.get());
-    return optimization->constexpr_values.count(key) == 0;
+    return optimization->constexpr_value(key) == nullptr;
 }
 
 void Analyzer::build_run_summary(const AnalysisFacts& facts) {
@@ -41,51 +42,51 @@ void Analyzer::build_run_summary(const AnalysisFacts& facts) {
     }
 
     for (const auto& instance : run_summary_.program->instances) {
-        [[maybe_unused]] auto instance_scope = scoped_instance(instance.id);
-
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
+        instance.for_each_symbol([&](const Symbol* sym) {
             if (!sym || !sym->declaration) {
-                continue;
+                return;
             }
 
             if (sym->kind == Symbol::Kind::Function) {
                 if (!sym->is_external && facts.reachable_functions.count(sym)) {
                     run_summary_.reachable_function_decls[sym] = sym->declaration;
-                    if (sym->declaration->body) {
-                        std::unordered_set<const Symbol*> calls;
-                        collect_calls(sym->declaration->body, calls);
-                        run_summary_.reachable_calls[sym] = std::move(calls);
-                    }
                 }
-                continue;
+                return;
             }
 
             if (sym->kind != Symbol::Kind::Variable && sym->kind != Symbol::Kind::Constant) {
-                continue;
+                return;
             }
             if (!global_initializer_runs_at_runtime(sym)) {
-                continue;
+                return;
             }
 
             run_summary_.runtime_initialized_globals.insert(sym);
-            std::unordered_set<const Symbol*> calls;
-            collect_calls(sym->declaration->var_init, calls);
-            run_summary_.global_initializer_calls[sym] = std::move(calls);
+            run_summary_.global_initializer_calls[sym] = body_summary(sym).calls;
+        });
+    }
+
+    CallGraph& graph = run_summary_.call_graph;
+    for (const Symbol* sym : facts.reachable_functions) {
+        graph.add_node(sym);
+    }
+    for (const auto& entry : run_summary_.reachable_function_decls) {
+        if (!entry.second->body) continue;
+        const uint32_t caller = graph.add_node(entry.first);
+        for (const Symbol* callee : body_summary(entry.first).calls) {
+            graph.add_edge(caller, graph.add_node(callee));
         }
     }
+    graph.finalize();
 }
 
 std::optional<bool> Analyzer::constexpr_condition(ExprPtr expr) const {
     if (!expr || !optimization) return std::nullopt;
-    auto it = optimization->constexpr_conditions.find(expr_fact_key(current_instance_id, expr.get()));
-    if (it != optimization->constexpr_conditions.end()) {
-        return it->second;
-    }
-    return std::nullopt;
+    return optimization->constexpr_condition(expr_fact_key(current_instance_id, expr.get()));
 }
 
-void Analyzer::walk_pruned_expr(ExprPtr expr, const ExprVisitor& on_expr, const StmtVisitor& on_stmt) {
+template <typename ExprFn, typename StmtFn>
+void Analyzer::walk_pruned_expr(const ExprPtr& expr, ExprFn& on_expr, StmtFn& on_stmt) {
     if (!expr) return;
     on_expr(expr);
 
@@ -112,7 +113,8 @@ void Analyzer::walk_pruned_expr(ExprPtr expr, const ExprVisitor& on_expr, const
         [&](const StmtPtr& child) { walk_pruned_stmt(child, on_expr, on_stmt); });
 }
 
-void Analyzer::walk_pruned_stmt(StmtPtr stmt, const ExprVisitor& on_expr, const StmtVisitor& on_stmt) {
+template <typename ExprFn, typename StmtFn>
+void Analyzer::walk_pruned_stmt(const StmtPtr& stmt, ExprFn& on_expr, StmtFn& on_stmt) {
     if (!stmt) return;
     on_stmt(stmt);
 
@@ -134,12 +136,113 @@ void Analyzer::walk_pruned_stmt(StmtPtr stmt, const ExprVisitor& on_expr, const
         [&](const StmtPtr& child) { walk_pruned_stmt(child, on_expr, on_stmt); });
 }
 
-void Analyzer::walk_runtime_expr(ExprPtr expr, const ExprVisitor& on_expr, const StmtVisitor& on_stmt) {
-    walk_pruned_expr(expr, on_expr, on_stmt);
+namespace {
+
+void collect_type_names(const TypePtr& type, std::unordered_set<std::string>& names) {
+    if (!type) return;
+    if (type->kind == Type::Kind::Named) {
+        if (!type->type_name.empty()) names.insert(type->type_name);
+    } else if (type->kind == Type::Kind::Array) {
+        collect_type_names(type->element_type, names);
+    }
+}
+
+bool is_global_storage(const Symbol* sym) {
+    return sym && !sym->is_local &&
+           (sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant);
 }
 
-void Analyzer::walk_runtime_stmt(StmtPtr stmt, const ExprVisitor& on_expr, const StmtVisitor& on_stmt) {
-    walk_pruned_stmt(stmt, on_expr, on_stmt);
+} // namespace
+
+const BodySummary& Analyzer::body_summary(const Symbol* owner) {
+    auto found = body_summaries_.find(owner);
+    if (found != body_summaries_.end()) {
+        return found->second;
+    }
+    BodySummary& summary = body_summaries_[owner];
+    if (!owner || !owner->declaration) {
+        return summary;
+    }
+    const ExprPtr& root = owner->kind == Symbol::Kind::Function ? owner->declaration->body
+                                                                : owner->declaration->var_init;
+    if (!root) {
+        return summary;
+    }
+
+    [[maybe_unused]] auto owner_scope = scoped_instance(owner->instance_id);
+    const bool usage = pass_enabled(AnalysisPass::Usage);
+
+    auto receiver_of = [&](const ExprPtr& expr) {
+        BodySummary::Receiver receiver;
+        if (auto base = base_identifier_symbol(expr)) {
+            receiver.base = *base;
+        }
+        receiver.addressable = is_addressable_lvalue(expr);
+        return receiver;
+    };
+
+    auto on_expr = [&](const ExprPtr& expr) {
+        if (usage) {
+            collect_type_names(expr->type, summary.type_names);
+            collect_type_names(expr->declared_var_type, summary.type_names);
+            collect_type_names(expr->target_type, summary.type_names);
+        }
+        switch (expr->kind) {
+            case Expr::Kind::Identifier: {
+                Symbol* sym = binding_for(expr);
+                if (!sym) break;
+                if (sym->is_external &&
+                    (sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant)) {
+                    summary.reads_external = true;
+                }
+                if (usage) {
+                    collect_type_names(sym->type, summary.type_names);
+                    if (is_global_storage(sym)) {
+                        summary.global_reads.insert(sym);
+                    }
+                }
+                break;
+            }
+            case Expr::Kind::Assignment: {
+                BodySummary::Assignment assignment;
+                if (auto base = base_identifier_symbol(expr->left)) {
+                    assignment.base = *base;
+                }
+                assignment.declares_local = expr->creates_new_variable && expr->left &&
+                                            expr->left->kind == Expr::Kind::Identifier;
+                summary.assignments.push_back(assignment);
+                break;
+            }
+            case Expr::Kind::Call: {
+                BodySummary::CallSite site;
+                if (expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
+                    site.identifier_callee = true;
+                    site.callee = binding_for(expr->operand);
+                    if (site.callee && site.callee->kind == Symbol::Kind::Function) {
+                        summary.calls.insert(site.callee);
+                    }
+                }
+                site.receivers.reserve(expr->receivers.size());
+                for (const auto& rec : expr->receivers) {
+                    site.receivers.push_back(receiver_of(rec));
+                }
+                summary.call_sites.push_back(std::move(site));
+                break;
+            }
+            case Expr::Kind::Process:
+                summary.spawns_process = true;
+                break;
+            default:
+                break;
+        }
+    };
+    auto on_stmt = [&](const StmtPtr& stmt) {
+        if (usage && stmt->kind == Stmt::Kind::VarDecl) {
+            collect_type_names(stmt->var_type, summary.type_names);
+        }
+    };
+    walk_pruned_expr(root, on_expr, on_stmt);
+    return summary;
 }
 
 Symbol* Analyzer::binding_for(ExprPtr expr) const {
@@ -199,6 +302,7 @@ std::optional<const Symbol*> Analyzer::base_identifier_symbol(ExprPtr expr) cons
 AnalysisFacts Analyzer::run(const Module& mod) {
     AnalysisFacts facts;
     run_summary_ = AnalysisRunSummary{};
+    body_summaries_.clear();
 
     const bool needs_reachability =
         pass_enabled(AnalysisPass::Reachability) ||
@@ -208,11 +312,13 @@ AnalysisFacts Analyzer::run(const Module& mod) {
         pass_enabled(AnalysisPass::Effects) ||
         pass_enabled(AnalysisPass::Usage);
     if (needs_reachability) {
+        TraceSpan span("analysis", "reachability");
         analyze_reachability(mod, facts);
         build_run_summary(facts);
     }
 
     if (pass_enabled(AnalysisPass::Reentrancy)) {
+        TraceSpan span("analysis", "reentrancy");
         analyze_reentrancy(mod, facts);
     }
 
@@ -221,18 +327,23 @@ AnalysisFacts Analyzer::run(const Module& mod) {
         pass_enabled(AnalysisPass::RefVariants) ||
         pass_enabled(AnalysisPass::Effects);
     if (needs_mutability) {
+        TraceSpan span("analysis", "mutability");
         analyze_mutability(mod, facts);
     }
 
     if (pass_enabled(AnalysisPass::RefVariants)) {
+        TraceSpan span("analysis", "ref-variants");
         analyze_ref_variants(mod, facts);
     }
     if (pass_enabled(AnalysisPass::Effects)) {
+        TraceSpan span("analysis", "effects");
         analyze_effects(mod, facts);
     }
     if (pass_enabled(AnalysisPass::Usage)) {
+        TraceSpan span("analysis", "usage");
         analyze_usage(mod, facts);
     }
+    body_summaries_.clear();
     return facts;
 }
 
@@ -241,29 +352,23 @@ void Analyzer::analyze_reachability(const Module& /*mod*/, AnalysisFacts& facts)
     if (!program) return;
 
     for (const auto& instance : program->instances) {
-        [[maybe_unused]] auto instance_scope = scoped_instance(instance.id);
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
-            if (!sym || sym->kind != Symbol::Kind::Function) continue;
-            if (!sym->is_exported) continue;
+        instance.for_each_symbol([&](const Symbol* sym) {
+            if (!sym || sym->kind != Symbol::Kind::Function) return;
+            if (!sym->is_exported) return;
             mark_reachable(sym, facts);
-        }
+        });
     }
 
     for (const auto& instance : program->instances) {
-        [[maybe_unused]] auto instance_scope = scoped_instance(instance.id);
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
-            if (!sym || (sym->kind != Symbol::Kind::Variable && sym->kind != Symbol::Kind::Constant)) continue;
-            if (!sym->declaration || !sym->declaration->var_init) continue;
-            if (!global_initializer_runs_at_runtime(sym)) continue;
-
-            std::unordered_set<const Symbol*> calls;
-            collect_calls(sym->declaration->var_init, calls);
-            for (const Symbol* callee : calls) {
+        instance.for_each_symbol([&](const Symbol* sym) {
+            if (!sym || (sym->kind != Symbol::Kind::Variable && sym->kind != Symbol::Kind::Constant)) return;
+            if (!sym->declaration || !sym->declaration->var_init) return;
+            if (!global_initializer_runs_at_runtime(sym)) return;
+
+            for (const Symbol* callee : body_summary(sym).calls) {
                 mark_reachable(callee, facts);
             }
-        }
+        });
     }
 }
 
@@ -279,31 +384,9 @@ void Analyzer::mark_reachable(const Symbol* func_sym, AnalysisFacts& facts) {
         return;
     }
 
-    [[maybe_unused]] auto callee_scope = scoped_instance(func_sym->instance_id);
-
-    std::unordered_set<const Symbol*> calls;
-    collect_calls(func_sym->declaration->body, calls);
-    for (const auto& called_sym : calls) {
+    for (const Symbol* called_sym : body_summary(func_sym).calls) {
         mark_reachable(called_sym, facts);
     }
-
-}
-
-void Analyzer::collect_calls(ExprPtr expr, std::unordered_set<const Symbol*>& calls) {
-    walk_pruned_expr(
-        expr,
-        [&](ExprPtr node) {
-            if (!node) return;
-            if (node->kind != Expr::Kind::Call || !node->operand ||
-                node->operand->kind != Expr::Kind::Identifier) {
-                return;
-            }
-            Symbol* sym = binding_for(node->operand);
-            if (sym && sym->kind == Symbol::Kind::Function) {
-                calls.insert(sym);
-            }
-        },
-        [&](StmtPtr) {});
 }
 
 } // namespace vexel
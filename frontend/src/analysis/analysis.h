@@ -1,5 +1,7 @@
 #pragma once
+#include "analysis_call_graph.h"
 #include "ast.h"
+#include "symbol_map.h"
 #include "symbols.h"
 #include <cstdint>
 #include <functional>
@@ -52,23 +54,57 @@ struct AnalysisConfig {
 
 enum class VarMutability { Mutable, Constexpr };
 
+// Symbol-keyed facts are bitsets and flat maps over Symbol::id, so backend
+// queries are index lookups rather than hash probes.
 struct AnalysisFacts {
-    std::unordered_set<const Symbol*> reachable_functions;
-    std::unordered_map<const Symbol*, VarMutability> var_mutability;
-    std::unordered_map<const Symbol*, std::vector<bool>> receiver_mutates;
-    std::unordered_map<const Symbol*, std::unordered_set<std::string>> ref_variants;
-    std::unordered_map<const Symbol*, bool> function_writes_global;
-    std::unordered_map<const Symbol*, bool> function_is_pure;
-    std::unordered_set<const Symbol*> used_global_vars;
+    SymbolSet reachable_functions;
+    SymbolMap<VarMutability> var_mutability;
+    SymbolMap<std::vector<bool>> receiver_mutates;
+    SymbolMap<std::unordered_set<std::string>> ref_variants;
+    SymbolMap<bool> function_writes_global;
+    SymbolMap<bool> function_is_pure;
+    // Transitive over calls, like function_writes_global: reads a mutable
+    // global, and writes through an array parameter into the caller's array.
+    SymbolMap<bool> function_reads_global;
+    SymbolMap<bool> function_writes_params;
+    SymbolSet used_global_vars;
     std::unordered_set<std::string> used_type_names;
-    std::unordered_map<const Symbol*, std::unordered_set<char>> reentrancy_variants;
+    SymbolMap<std::unordered_set<char>> reentrancy_variants;
+};
+
+// Facts of one function body or global initializer, gathered by a single
+// pruned walk and shared by every pass instead of each pass re-walking it.
+struct BodySummary {
+    struct Receiver {
+        const Symbol* base = nullptr;  // Symbol of the root identifier, if bound.
+        bool addressable = false;
+    };
+    struct CallSite {
+        const Symbol* callee = nullptr;  // Null for unresolved or non-identifier callees.
+        bool identifier_callee = false;
+        std::vector<Receiver> receivers;
+    };
+    struct Assignment {
+        const Symbol* base = nullptr;
+        bool declares_local = false;
+    };
+
+    std::unordered_set<const Symbol*> calls;
+    std::vector<CallSite> call_sites;
+    std::vector<Assignment> assignments;
+    bool reads_external = false;
+    bool spawns_process = false;
+    // Only gathered when the usage pass is enabled.
+    std::unordered_set<const Symbol*> global_reads;
+    std::unordered_set<std::string> type_names;
 };
 
 // Shared data computed once per analysis run and reused across passes.
 struct AnalysisRunSummary {
     Program* program = nullptr;
     std::unordered_map<const Symbol*, StmtPtr> reachable_function_decls;
-    std::unordered_map<const Symbol*, std::unordered_set<const Symbol*>> reachable_calls;
+    // Every reachable function, with call edges out of reachable bodies.
+    CallGraph call_graph;
     std::unordered_set<const Symbol*> runtime_initialized_globals;
     std::unordered_map<const Symbol*, std::unordered_set<const Symbol*>> global_initializer_calls;
 };
@@ -86,9 +122,6 @@ private:
         Program* program = nullptr;
     };
 
-    using ExprVisitor = std::function<void(ExprPtr)>;
-    using StmtVisitor = std::function<void(StmtPtr)>;
-
     class InstanceScope {
     public:
         InstanceScope(Analyzer& analyzer, int instance_id)
@@ -120,6 +153,7 @@ private:
     AnalysisConfig analysis_config;
     int current_instance_id = -1;
     AnalysisRunSummary run_summary_;
+    std::unordered_map<const Symbol*, BodySummary> body_summaries_;
 
     AnalysisContext context() const;
     const AnalysisRunSummary& run_summary() const { return run_summary_; }
@@ -128,10 +162,13 @@ private:
     bool global_initializer_runs_at_runtime(const Symbol* sym) const;
     void build_run_summary(const AnalysisFacts& facts);
     std::optional<bool> constexpr_condition(ExprPtr expr) const;
-    void walk_pruned_expr(ExprPtr expr, const ExprVisitor& on_expr, const StmtVisitor& on_stmt);
-    void walk_pruned_stmt(StmtPtr stmt, const ExprVisitor& on_expr, const StmtVisitor& on_stmt);
-    void walk_runtime_expr(ExprPtr expr, const ExprVisitor& on_expr, const StmtVisitor& on_stmt);
-    void walk_runtime_stmt(StmtPtr stmt, const ExprVisitor& on_expr, const StmtVisitor& on_stmt);
+    template <typename ExprFn, typename StmtFn>
+    void walk_pruned_expr(const ExprPtr& expr, ExprFn& on_expr, StmtFn& on_stmt);
+    template <typename ExprFn, typename StmtFn>
+    void walk_pruned_stmt(const StmtPtr& stmt, ExprFn& on_expr, StmtFn& on_stmt);
+    // Summary of the function body or global initializer `owner` declares,
+    // walked once per run in the owner's instance.
+    const BodySummary& body_summary(const Symbol* owner);
     void analyze_reachability(const Module& mod, AnalysisFacts& facts);
     void analyze_reentrancy(const Module& mod, AnalysisFacts& facts);
     void analyze_mutability(const Module& mod, AnalysisFacts& facts);
@@ -140,7 +177,6 @@ private:
     void analyze_usage(const Module& mod, AnalysisFacts& facts);
 
     void mark_reachable(const Symbol* func_sym, AnalysisFacts& facts);
-    void collect_calls(ExprPtr expr, std::unordered_set<const Symbol*>& calls);
 
     Symbol* binding_for(ExprPtr expr) const;
     std::optional<const Symbol*> base_identifier_symbol(ExprPtr expr) const;
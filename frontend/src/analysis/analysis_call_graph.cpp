@@ -0,0 +1,119 @@
+#include "analysis_call_graph.h"
+
+#include <algorithm>
+
+namespace vexel {
+
+uint32_t CallGraph::add_node(const Symbol* sym) {
+    auto inserted = index_.emplace(sym, static_cast<uint32_t>(nodes_.size()));
+    if (inserted.second) {
+        nodes_.push_back(sym);
+    }
+    return inserted.first->second;
+}
+
+uint32_t CallGraph::find(const Symbol* sym) const {
+    auto it = index_.find(sym);
+    return it == index_.end() ? kNoNode : it->second;
+}
+
+void CallGraph::add_edge(uint32_t caller, uint32_t callee) {
+    pending_edges_.emplace_back(caller, callee);
+}
+
+CallGraph::Range CallGraph::callees(uint32_t node) const {
+    return Range{edges_.data() + edge_begin_[node], edges_.data() + edge_begin_[node + 1]};
+}
+
+CallGraph::Range CallGraph::component_nodes(uint32_t component) const {
+    return Range{component_nodes_.data() + component_begin_[component],
+                 component_nodes_.data() + component_begin_[component + 1]};
+}
+
+bool CallGraph::component_is_cyclic(uint32_t component) const {
+    Range members = component_nodes(component);
+    if (members.size() > 1) return true;
+    uint32_t node = *members.begin();
+    for (uint32_t callee : callees(node)) {
+        if (callee == node) return true;
+    }
+    return false;
+}
+
+void CallGraph::finalize() {
+    const uint32_t count = static_cast<uint32_t>(nodes_.size());
+
+    // Counting sort of the pending edges by caller.
+    edge_begin_.assign(count + 1, 0);
+    for (const auto& edge : pending_edges_) {
+        edge_begin_[edge.first + 1]++;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        edge_begin_[i + 1] += edge_begin_[i];
+    }
+    edges_.assign(pending_edges_.size(), 0);
+    std::vector<uint32_t> fill(edge_begin_.begin(), edge_begin_.end() - 1);
+    for (const auto& edge : pending_edges_) {
+        edges_[fill[edge.first]++] = edge.second;
+    }
+    pending_edges_.clear();
+    pending_edges_.shrink_to_fit();
+
+    // Iterative Tarjan; components are emitted callees-first.
+    constexpr uint32_t kUnvisited = UINT32_MAX;
+    std::vector<uint32_t> order(count, kUnvisited);
+    std::vector<uint32_t> low(count, 0);
+    std::vector<uint8_t> on_stack(count, 0);
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, uint32_t>> frames;  // (node, next edge offset)
+    component_.assign(count, 0);
+    component_begin_.assign(1, 0);
+    component_nodes_.clear();
+    component_nodes_.reserve(count);
+    uint32_t next_order = 0;
+
+    for (uint32_t root = 0; root < count; root++) {
+        if (order[root] != kUnvisited) continue;
+        frames.emplace_back(root, edge_begin_[root]);
+        order[root] = low[root] = next_order++;
+        stack.push_back(root);
+        on_stack[root] = 1;
+
+        while (!frames.empty()) {
+            uint32_t node = frames.back().first;
+            uint32_t& next = frames.back().second;
+            if (next < edge_begin_[node + 1]) {
+                uint32_t callee = edges_[next++];
+                if (order[callee] == kUnvisited) {
+                    order[callee] = low[callee] = next_order++;
+                    stack.push_back(callee);
+                    on_stack[callee] = 1;
+                    frames.emplace_back(callee, edge_begin_[callee]);
+                } else if (on_stack[callee]) {
+                    low[node] = std::min(low[node], order[callee]);
+                }
+                continue;
+            }
+
+            frames.pop_back();
+            if (!frames.empty()) {
+                uint32_t parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[node]);
+            }
+            if (low[node] != order[node]) continue;
+
+            const uint32_t component = static_cast<uint32_t>(component_begin_.size() - 1);
+            uint32_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = 0;
+                component_[member] = component;
+                component_nodes_.push_back(member);
+            } while (member != node);
+            component_begin_.push_back(static_cast<uint32_t>(component_nodes_.size()));
+        }
+    }
+}
+
+} // namespace vexel
@@ -0,0 +1,54 @@
+#pragma once
+#include "symbols.h"
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vexel {
+
+// Call graph over dense node indices with CSR adjacency. After finalize(),
+// strongly connected components are numbered callees-first (reverse
+// topological order), so a single forward sweep over components sees every
+// callee component before its callers and a backward sweep sees callers first.
+class CallGraph {
+public:
+    static constexpr uint32_t kNoNode = UINT32_MAX;
+
+    struct Range {
+        const uint32_t* first = nullptr;
+        const uint32_t* last = nullptr;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    // Returns the index of `sym`, adding a node on first use.
+    uint32_t add_node(const Symbol* sym);
+    uint32_t find(const Symbol* sym) const;
+    void add_edge(uint32_t caller, uint32_t callee);
+    // Packs the edges into CSR form and computes the components.
+    void finalize();
+
+    size_t node_count() const { return nodes_.size(); }
+    const Symbol* symbol(uint32_t node) const { return nodes_[node]; }
+    Range callees(uint32_t node) const;
+
+    size_t component_count() const { return component_begin_.empty() ? 0 : component_begin_.size() - 1; }
+    uint32_t component_of(uint32_t node) const { return component_[node]; }
+    Range component_nodes(uint32_t component) const;
+    // True when the component contains a cycle (several nodes or a self call).
+    bool component_is_cyclic(uint32_t component) const;
+
+private:
+    std::vector<const Symbol*> nodes_;
+    std::unordered_map<const Symbol*, uint32_t> index_;
+    std::vector<std::pair<uint32_t, uint32_t>> pending_edges_;
+    std::vector<uint32_t> edge_begin_;
+    std::vector<uint32_t> edges_;
+    std::vector<uint32_t> component_;
+    std::vector<uint32_t> component_begin_;
+    std::vector<uint32_t> component_nodes_;
+};
+
+} // namespace vexel
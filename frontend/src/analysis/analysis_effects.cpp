@@ -6,41 +6,60 @@
 
 namespace vexel {
 
+namespace {
+
+bool is_global_storage(const Symbol* sym) {
+    return sym && !sym->is_local &&
+           (sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant);
+}
+
+// Arrays are passed by pointer, so a write through an array parameter lands in
+// the caller's array.
+bool is_array_param(const Stmt& func, const Symbol* sym) {
+    if (!sym || !sym->is_local) return false;
+    return std::any_of(func.params.begin(), func.params.end(), [&](const Parameter& param) {
+        return !param.is_expression_param && param.name == sym->name && param.type &&
+               param.type->kind == Type::Kind::Array;
+    });
+}
+
+} // namespace
+
 void Analyzer::analyze_effects(const Module& /*mod*/, AnalysisFacts& facts) {
     facts.function_writes_global.clear();
     facts.function_is_pure.clear();
+    facts.function_reads_global.clear();
+    facts.function_writes_params.clear();
 
     const AnalysisRunSummary& summary = run_summary();
     Program* program = summary.program;
     if (!program) return;
 
     std::unordered_map<const Symbol*, StmtPtr> function_map;
-    std::unordered_map<const Symbol*, std::unordered_set<const Symbol*>> function_calls;
     std::unordered_map<const Symbol*, bool> function_direct_writes_global;
     std::unordered_map<const Symbol*, bool> function_direct_impure;
     std::unordered_map<const Symbol*, bool> function_unknown_call;
+    std::unordered_map<const Symbol*, bool> function_direct_reads_global;
+    std::unordered_map<const Symbol*, bool> function_direct_writes_params;
     std::unordered_map<const Symbol*, bool> function_mutates_receiver;
     std::unordered_set<const Symbol*> external_functions;
 
     for (const auto& instance : program->instances) {
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
+        instance.for_each_symbol([&](const Symbol* sym) {
             if (sym && sym->kind == Symbol::Kind::Function && sym->is_external) {
                 external_functions.insert(sym);
             }
-        }
+        });
     }
 
     for (const auto& entry : summary.reachable_function_decls) {
         const Symbol* sym = entry.first;
         function_map[sym] = entry.second;
-        auto calls_it = summary.reachable_calls.find(sym);
-        function_calls[sym] = (calls_it != summary.reachable_calls.end())
-                                  ? calls_it->second
-                                  : std::unordered_set<const Symbol*>{};
         function_direct_writes_global[sym] = false;
         function_direct_impure[sym] = false;
         function_unknown_call[sym] = false;
+        function_direct_reads_global[sym] = false;
+        function_direct_writes_params[sym] = false;
 
         bool mutates = false;
         auto mut_it = facts.receiver_mutates.find(sym);
@@ -57,152 +76,120 @@ void Analyzer::analyze_effects(const Module& /*mod*/, AnalysisFacts& facts) {
         if (!func || !func->body) {
             function_direct_impure[func_sym] = true;
             function_unknown_call[func_sym] = true;
+            function_direct_reads_global[func_sym] = true;
+            function_direct_writes_params[func_sym] = true;
             continue;
         }
 
+        const BodySummary& body = body_summary(func_sym);
         bool direct_write = false;
-        bool direct_impure = false;
+        bool direct_impure = body.reads_external || body.spawns_process;
         bool unknown_call = false;
-
-        auto func_scope = scoped_instance(func_sym->instance_id);
-        (void)func_scope;
-
-        walk_pruned_expr(
-            func->body,
-            [&](ExprPtr expr) {
-                if (!expr) return;
-                if (expr->kind == Expr::Kind::Identifier ||
-                    expr->kind == Expr::Kind::Member ||
-                    expr->kind == Expr::Kind::Index) {
-                    auto base = base_identifier_symbol(expr);
-                    if (base &&
-                        (*base)->is_external &&
-                        ((*base)->kind == Symbol::Kind::Variable || (*base)->kind == Symbol::Kind::Constant)) {
-                        direct_impure = true;
-                    }
-                }
-                if (expr->kind == Expr::Kind::Assignment) {
-                    if (expr->creates_new_variable &&
-                        expr->left && expr->left->kind == Expr::Kind::Identifier) {
-                        return;
-                    }
-                    auto base = base_identifier_symbol(expr->left);
-                    if (base && !(*base)->is_local &&
-                        ((*base)->kind == Symbol::Kind::Variable || (*base)->kind == Symbol::Kind::Constant)) {
-                        direct_write = true;
-                    }
-                    return;
-                }
-
-                if (expr->kind == Expr::Kind::Call) {
-                    if (!expr->operand || expr->operand->kind != Expr::Kind::Identifier) {
-                        unknown_call = true;
-                        direct_impure = true;
-                        return;
-                    }
-                    Symbol* callee_sym = binding_for(expr->operand);
-                    if (!callee_sym) {
-                        unknown_call = true;
-                        direct_impure = true;
-                        return;
-                    }
-
-                    auto callee_it = facts.receiver_mutates.find(callee_sym);
-                    for (size_t i = 0; i < expr->receivers.size(); i++) {
-                        bool mut = true;
-                        if (callee_it != facts.receiver_mutates.end() && i < callee_it->second.size()) {
-                            mut = callee_it->second[i];
-                        }
-                        if (!mut) continue;
-                        ExprPtr rec = expr->receivers[i];
-                        if (!is_addressable_lvalue(rec)) {
-                            continue;
-                        }
-                        auto base = base_identifier_symbol(rec);
-                        if (base && !(*base)->is_local &&
-                            ((*base)->kind == Symbol::Kind::Variable || (*base)->kind == Symbol::Kind::Constant)) {
-                            direct_write = true;
-                        }
-                    }
-                    return;
+        // Global reads are only gathered by the usage pass; without it every
+        // body is assumed to read globals.
+        bool direct_reads = !pass_enabled(AnalysisPass::Usage);
+        bool direct_param_write = false;
+
+        for (const auto& assignment : body.assignments) {
+            if (!assignment.declares_local && is_global_storage(assignment.base)) {
+                direct_write = true;
+            }
+            if (!assignment.declares_local && is_array_param(*func, assignment.base)) {
+                direct_param_write = true;
+            }
+        }
+        for (const Symbol* global : body.global_reads) {
+            auto mut_it = facts.var_mutability.find(global);
+            if (mut_it == facts.var_mutability.end() || mut_it->second != VarMutability::Constexpr) {
+                direct_reads = true;
+            }
+        }
+        for (const auto& site : body.call_sites) {
+            if (!site.identifier_callee || !site.callee) {
+                unknown_call = true;
+                direct_impure = true;
+                continue;
+            }
+            auto callee_it = facts.receiver_mutates.find(site.callee);
+            for (size_t i = 0; i < site.receivers.size(); i++) {
+                bool mut = true;
+                if (callee_it != facts.receiver_mutates.end() && i < callee_it->second.size()) {
+                    mut = callee_it->second[i];
                 }
-
-                if (expr->kind == Expr::Kind::Process) {
-                    direct_impure = true;
+                if (!mut) continue;
+                const BodySummary::Receiver& receiver = site.receivers[i];
+                if (receiver.addressable && is_global_storage(receiver.base)) {
+                    direct_write = true;
                 }
-            },
-            [&](StmtPtr) {});
+            }
+        }
 
         function_direct_writes_global[func_sym] = direct_write;
         function_direct_impure[func_sym] = direct_impure;
         function_unknown_call[func_sym] = unknown_call;
+        function_direct_reads_global[func_sym] = direct_reads || unknown_call;
+        function_direct_writes_params[func_sym] = direct_param_write || unknown_call;
     }
 
-    for (const auto& entry : function_map) {
-        const Symbol* func_sym = entry.first;
-        facts.function_writes_global[func_sym] = function_direct_writes_global[func_sym] ||
-                                                 function_unknown_call[func_sym];
+    // All facts are uniform across a strongly connected component: a write
+    // anywhere in a cycle is reachable from every member, and so is any
+    // impurity. Callees outside the analyzed set (externals) read, write and
+    // are impure. A caller passing a local array to a parameter-writing callee
+    // is conservatively marked too. One sweep, callees first, settles every
+    // component.
+    const CallGraph& graph = summary.call_graph;
+    const size_t node_count = graph.node_count();
+    std::vector<uint8_t> writes(node_count, 1);
+    std::vector<uint8_t> pure(node_count, 0);
+    std::vector<uint8_t> local_writes(node_count, 1);
+    std::vector<uint8_t> local_pure(node_count, 0);
+    std::vector<uint8_t> reads(node_count, 1);
+    std::vector<uint8_t> param_writes(node_count, 1);
+    std::vector<uint8_t> local_reads(node_count, 1);
+    std::vector<uint8_t> local_param_writes(node_count, 1);
+    for (uint32_t node = 0; node < node_count; node++) {
+        const Symbol* func_sym = graph.symbol(node);
+        if (!function_map.count(func_sym) || external_functions.count(func_sym)) continue;
+        local_writes[node] = function_direct_writes_global[func_sym] || function_unknown_call[func_sym];
+        local_pure[node] = !function_direct_impure[func_sym] && !function_mutates_receiver[func_sym];
+        local_reads[node] = function_direct_reads_global[func_sym];
+        local_param_writes[node] = function_direct_writes_params[func_sym];
     }
 
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (const auto& entry : function_map) {
-            const Symbol* func_sym = entry.first;
-            bool writes = function_direct_writes_global[func_sym] || function_unknown_call[func_sym];
-            if (!writes) {
-                for (const auto& callee_sym : function_calls[func_sym]) {
-                    if (external_functions.count(callee_sym) || !function_map.count(callee_sym)) {
-                        writes = true;
-                        break;
-                    }
-                    if (facts.function_writes_global[callee_sym]) {
-                        writes = true;
-                        break;
-                    }
-                }
-            }
-            if (writes != facts.function_writes_global[func_sym]) {
-                facts.function_writes_global[func_sym] = writes;
-                changed = true;
+    for (uint32_t component = 0; component < graph.component_count(); component++) {
+        bool component_writes = false;
+        bool component_pure = true;
+        bool component_reads = false;
+        bool component_param_writes = false;
+        for (uint32_t node : graph.component_nodes(component)) {
+            component_writes = component_writes || local_writes[node];
+            component_pure = component_pure && local_pure[node];
+            component_reads = component_reads || local_reads[node];
+            component_param_writes = component_param_writes || local_param_writes[node];
+            for (uint32_t callee : graph.callees(node)) {
+                if (graph.component_of(callee) == component) continue;
+                component_writes = component_writes || writes[callee];
+                component_pure = component_pure && pure[callee];
+                component_reads = component_reads || reads[callee];
+                component_param_writes = component_param_writes || param_writes[callee];
             }
         }
+        component_pure = component_pure && !component_writes;
+        for (uint32_t node : graph.component_nodes(component)) {
+            writes[node] = component_writes;
+            pure[node] = component_pure;
+            reads[node] = component_reads;
+            param_writes[node] = component_param_writes;
+        }
     }
 
     for (const auto& entry : function_map) {
         const Symbol* func_sym = entry.first;
-        bool base = !facts.function_writes_global[func_sym] &&
-                    !function_direct_impure[func_sym] &&
-                    !function_mutates_receiver[func_sym];
-        facts.function_is_pure[func_sym] = base;
-    }
-
-    changed = true;
-    while (changed) {
-        changed = false;
-        for (const auto& entry : function_map) {
-            const Symbol* func_sym = entry.first;
-            bool base = !facts.function_writes_global[func_sym] &&
-                        !function_direct_impure[func_sym] &&
-                        !function_mutates_receiver[func_sym];
-            bool pure = base;
-            if (pure) {
-                for (const auto& callee_sym : function_calls[func_sym]) {
-                    if (external_functions.count(callee_sym) || !function_map.count(callee_sym)) {
-                        pure = false;
-                        break;
-                    }
-                    if (!facts.function_is_pure[callee_sym]) {
-                        pure = false;
-                        break;
-                    }
-                }
-            }
-            if (pure != facts.function_is_pure[func_sym]) {
-                facts.function_is_pure[func_sym] = pure;
-                changed = true;
-            }
-        }
+        const uint32_t node = graph.find(func_sym);
+        facts.function_writes_global[func_sym] = node == CallGraph::kNoNode || writes[node];
+        facts.function_is_pure[func_sym] = node != CallGraph::kNoNode && pure[node];
+        facts.function_reads_global[func_sym] = node == CallGraph::kNoNode || reads[node];
+        facts.function_writes_params[func_sym] = node == CallGraph::kNoNode || param_writes[node];
     }
 }
 
@@ -6,6 +6,15 @@
 
 namespace vexel {
 
+namespace {
+
+bool is_global_storage(const Symbol* sym) {
+    return sym && !sym->is_local &&
+           (sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant);
+}
+
+} // namespace
+
 void Analyzer::analyze_mutability(const Module& /*mod*/, AnalysisFacts& facts) {
     facts.var_mutability.clear();
     facts.receiver_mutates.clear();
@@ -17,9 +26,8 @@ void Analyzer::analyze_mutability(const Module& /*mod*/, AnalysisFacts& facts) {
     std::unordered_map<const Symbol*, bool> global_written;
 
     for (const auto& instance : program->instances) {
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
-            if (!sym) continue;
+        instance.for_each_symbol([&](const Symbol* sym) {
+            if (!sym) return;
             if (sym->kind == Symbol::Kind::Function && sym->declaration) {
                 function_map[sym] = sym->declaration;
                 if (!sym->declaration->ref_params.empty()) {
@@ -32,70 +40,79 @@ void Analyzer::analyze_mutability(const Module& /*mod*/, AnalysisFacts& facts) {
             } else if ((sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant) && !sym->is_local) {
                 global_written[sym] = false;
             }
-        }
+        });
     }
 
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (const auto& entry : function_map) {
-            const Symbol* func_sym = entry.first;
-            const StmtPtr& func = entry.second;
-            if (!func || func->is_external || !func->body || func->ref_params.empty()) continue;
-
-            auto func_scope = scoped_instance(func_sym->instance_id);
-            (void)func_scope;
-
-            std::vector<bool> updated = facts.receiver_mutates[func_sym];
-            std::unordered_map<std::string, size_t> receiver_index;
-            receiver_index.reserve(func->ref_params.size());
-            for (size_t i = 0; i < func->ref_params.size(); i++) {
-                receiver_index[func->ref_params[i]] = i;
+    // Receiver mutation only flows between functions that take receivers, so
+    // the graph is restricted to those with a body. Components are settled
+    // callees-first; only cyclic ones need to iterate, and only internally.
+    CallGraph graph;
+    for (const auto& entry : function_map) {
+        const StmtPtr& func = entry.second;
+        if (!func || func->is_external || !func->body || func->ref_params.empty()) continue;
+        graph.add_node(entry.first);
+    }
+    for (uint32_t node = 0; node < graph.node_count(); node++) {
+        for (const auto& site : body_summary(graph.symbol(node)).call_sites) {
+            const uint32_t callee = site.callee ? graph.find(site.callee) : CallGraph::kNoNode;
+            if (callee != CallGraph::kNoNode) {
+                graph.add_edge(node, callee);
             }
+        }
+    }
+    graph.finalize();
+
+    auto refresh = [&](uint32_t node) {
+        const Symbol* func_sym = graph.symbol(node);
+        const StmtPtr& func = func_sym->declaration;
+        const BodySummary& body = body_summary(func_sym);
+        std::vector<bool>& current = facts.receiver_mutates[func_sym];
+        std::vector<bool> updated = current;
+        std::unordered_map<std::string, size_t> receiver_index;
+        receiver_index.reserve(func->ref_params.size());
+        for (size_t i = 0; i < func->ref_params.size(); i++) {
+            receiver_index[func->ref_params[i]] = i;
+        }
 
-            walk_pruned_expr(
-                func->body,
-                [&](ExprPtr expr) {
-                    if (!expr) return;
-                    if (expr->kind == Expr::Kind::Assignment) {
-                        auto base = base_identifier_symbol(expr->left);
-                        if (base) {
-                            auto it = receiver_index.find((*base)->name);
-                            if (it != receiver_index.end()) {
-                                updated[it->second] = true;
-                            }
-                        }
-                        return;
-                    }
-                    if (expr->kind == Expr::Kind::Call) {
-                        Symbol* callee_sym = nullptr;
-                        if (expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
-                            callee_sym = binding_for(expr->operand);
-                        }
-                        auto callee_it = callee_sym ? facts.receiver_mutates.find(callee_sym)
-                                                    : facts.receiver_mutates.end();
-                        for (size_t i = 0; i < expr->receivers.size(); i++) {
-                            ExprPtr rec_expr = expr->receivers[i];
-                            auto base = base_identifier_symbol(rec_expr);
-                            if (!base) continue;
-                            auto rec_it = receiver_index.find((*base)->name);
-                            if (rec_it == receiver_index.end()) continue;
-                            bool mut = true;
-                            if (callee_it != facts.receiver_mutates.end() && i < callee_it->second.size()) {
-                                mut = callee_it->second[i];
-                            }
-                            if (mut) {
-                                updated[rec_it->second] = true;
-                            }
-                        }
-                    }
-                },
-                [&](StmtPtr) {});
+        for (const auto& assignment : body.assignments) {
+            if (!assignment.base) continue;
+            auto it = receiver_index.find(assignment.base->name);
+            if (it != receiver_index.end()) {
+                updated[it->second] = true;
+            }
+        }
+        for (const auto& site : body.call_sites) {
+            auto callee_it = site.callee ? facts.receiver_mutates.find(site.callee)
+                                         : facts.receiver_mutates.end();
+            for (size_t i = 0; i < site.receivers.size(); i++) {
+                const Symbol* base = site.receivers[i].base;
+                if (!base) continue;
+                auto rec_it = receiver_index.find(base->name);
+                if (rec_it == receiver_index.end()) continue;
+                bool mut = true;
+                if (callee_it != facts.receiver_mutates.end() && i < callee_it->second.size()) {
+                    mut = callee_it->second[i];
+                }
+                if (mut) {
+                    updated[rec_it->second] = true;
+                }
+            }
+        }
 
-            if (updated != facts.receiver_mutates[func_sym]) {
-                facts.receiver_mutates[func_sym] = updated;
-                changed = true;
+        if (updated == current) return false;
+        current = std::move(updated);
+        return true;
+    };
+
+    for (uint32_t component = 0; component < graph.component_count(); component++) {
+        const bool cyclic = graph.component_is_cyclic(component);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t node : graph.component_nodes(component)) {
+                changed = refresh(node) || changed;
             }
+            changed = changed && cyclic;
         }
     }
 
@@ -105,48 +122,27 @@ void Analyzer::analyze_mutability(const Module& /*mod*/, AnalysisFacts& facts) {
         if (!func || !func->body) continue;
         if (!facts.reachable_functions.count(func_sym)) continue;
 
-        auto func_scope = scoped_instance(func_sym->instance_id);
-        (void)func_scope;
-
-        walk_pruned_expr(
-            func->body,
-            [&](ExprPtr expr) {
-                if (!expr) return;
-                if (expr->kind == Expr::Kind::Assignment) {
-                    auto base = base_identifier_symbol(expr->left);
-                    if (base && !(*base)->is_local &&
-                        ((*base)->kind == Symbol::Kind::Variable || (*base)->kind == Symbol::Kind::Constant)) {
-                        global_written[*base] = true;
-                    }
-                    return;
+        const BodySummary& body = body_summary(func_sym);
+        for (const auto& assignment : body.assignments) {
+            if (is_global_storage(assignment.base)) {
+                global_written[assignment.base] = true;
+            }
+        }
+        for (const auto& site : body.call_sites) {
+            auto callee_it = site.callee ? facts.receiver_mutates.find(site.callee)
+                                         : facts.receiver_mutates.end();
+            for (size_t i = 0; i < site.receivers.size(); i++) {
+                bool mut = true;
+                if (callee_it != facts.receiver_mutates.end() && i < callee_it->second.size()) {
+                    mut = callee_it->second[i];
                 }
-                if (expr->kind == Expr::Kind::Call) {
-                    Symbol* callee_sym = nullptr;
-                    if (expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
-                        callee_sym = binding_for(expr->operand);
-                    }
-                    auto callee_it = callee_sym ? facts.receiver_mutates.find(callee_sym)
-                                                : facts.receiver_mutates.end();
-                    for (size_t i = 0; i < expr->receivers.size(); i++) {
-                        bool mut = true;
-                        if (callee_it != facts.receiver_mutates.end() && i < callee_it->second.size()) {
-                            mut = callee_it->second[i];
-                        }
-                        if (!mut) continue;
-                        ExprPtr rec_expr = expr->receivers[i];
-                        if (!rec_expr) continue;
-                        if (!is_addressable_lvalue(rec_expr)) {
-                            continue;
-                        }
-                        auto base = base_identifier_symbol(rec_expr);
-                        if (base && !(*base)->is_local &&
-                            ((*base)->kind == Symbol::Kind::Variable || (*base)->kind == Symbol::Kind::Constant)) {
-                            global_written[*base] = true;
-                        }
-                    }
+                if (!mut) continue;
+                const BodySummary::Receiver& receiver = site.receivers[i];
+                if (receiver.addressable && is_global_storage(receiver.base)) {
+                    global_written[receiver.base] = true;
                 }
-            },
-            [&](StmtPtr) {});
+            }
+        }
     }
 
     for (const auto& entry : global_written) {
@@ -1,8 +1,7 @@
 #include "analysis.h"
 #include "program.h"
 
-#include <algorithm>
-#include <deque>
+#include <vector>
 
 namespace vexel {
 
@@ -40,29 +39,37 @@ void Analyzer::analyze_reentrancy(const Module& /*mod*/, AnalysisFacts& facts) {
     std::unordered_set<const Symbol*> external_nonreentrant;
 
     for (const auto& instance : program->instances) {
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
-            if (!sym || sym->kind != Symbol::Kind::Function || !sym->is_external) continue;
+        instance.for_each_symbol([&](const Symbol* sym) {
+            if (!sym || sym->kind != Symbol::Kind::Function || !sym->is_external) return;
             if (boundary_ctx(sym, ReentrancyBoundaryKind::ExitPoint) == 'N') {
                 external_nonreentrant.insert(sym);
             }
-        }
+        });
     }
 
-    std::deque<std::pair<const Symbol*, char>> work;
-
-    for (const auto& instance : program->instances) {
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
-            if (!sym || sym->kind != Symbol::Kind::Function) continue;
-            if (!sym->is_exported) continue;
-            if (!facts.reachable_functions.count(sym)) continue;
+    // Contexts flow from callers to callees, so every member of a strongly
+    // connected component ends with the same set. Sweeping components
+    // callers-first visits each edge once.
+    constexpr uint8_t kReentrant = 1u << 0;
+    constexpr uint8_t kNonReentrant = 1u << 1;
+    auto ctx_bit = [](char ctx) { return ctx == 'R' ? kReentrant : kNonReentrant; };
 
-            char ctx = boundary_ctx(sym, ReentrancyBoundaryKind::EntryPoint);
-            if (facts.reentrancy_variants[sym].insert(ctx).second) {
-                work.emplace_back(sym, ctx);
-            }
+    const CallGraph& graph = summary.call_graph;
+    std::vector<uint8_t> contexts(graph.node_count(), 0);
+    auto seed = [&](const Symbol* sym, char ctx) {
+        const uint32_t node = graph.find(sym);
+        if (node != CallGraph::kNoNode) {
+            contexts[node] |= ctx_bit(ctx);
         }
+    };
+
+    for (const auto& instance : program->instances) {
+        instance.for_each_symbol([&](const Symbol* sym) {
+            if (!sym || sym->kind != Symbol::Kind::Function) return;
+            if (!sym->is_exported) return;
+            if (!facts.reachable_functions.count(sym)) return;
+            seed(sym, boundary_ctx(sym, ReentrancyBoundaryKind::EntryPoint));
+        });
     }
 
     for (const Symbol* sym : summary.runtime_initialized_globals) {
@@ -70,40 +77,48 @@ void Analyzer::analyze_reentrancy(const Module& /*mod*/, AnalysisFacts& facts) {
         if (calls_it == summary.global_initializer_calls.end()) continue;
         for (const auto& callee_sym : calls_it->second) {
             if (!callee_sym) continue;
-            if (facts.reentrancy_variants[callee_sym].insert('N').second) {
-                work.emplace_back(callee_sym, 'N');
-            }
+            seed(callee_sym, 'N');
         }
     }
 
-    while (!work.empty()) {
-        auto [func_sym, ctx] = work.front();
-        work.pop_front();
-        auto it = function_map.find(func_sym);
-        if (it == function_map.end()) {
-            if (ctx == 'R' && external_nonreentrant.count(func_sym)) {
-                throw CompileError("Reentrant path calls non-reentrant external function '" + func_sym->name + "'",
-                                   func_sym->declaration ? func_sym->declaration->location : SourceLocation());
-            }
-            continue;
+    for (uint32_t component = static_cast<uint32_t>(graph.component_count()); component-- > 0;) {
+        uint8_t component_contexts = 0;
+        for (uint32_t node : graph.component_nodes(component)) {
+            component_contexts |= contexts[node];
         }
-        StmtPtr func = it->second;
-        if (!func || !func->body) continue;
-
-        auto calls_it = summary.reachable_calls.find(func_sym);
-        if (calls_it == summary.reachable_calls.end()) continue;
-        for (const auto& callee_sym : calls_it->second) {
-            if (!callee_sym) continue;
-            if (ctx == 'R' && external_nonreentrant.count(callee_sym)) {
-                throw CompileError("Reentrant path calls non-reentrant external function '" + callee_sym->name + "'",
-                                   func->location);
+        if (component_contexts == 0) continue;
+        const bool reentrant = (component_contexts & kReentrant) != 0;
+        for (uint32_t node : graph.component_nodes(component)) {
+            contexts[node] = component_contexts;
+            const Symbol* func_sym = graph.symbol(node);
+            auto it = function_map.find(func_sym);
+            if (it == function_map.end()) {
+                if (reentrant && external_nonreentrant.count(func_sym)) {
+                    throw CompileError("Reentrant path calls non-reentrant external function '" + func_sym->name + "'",
+                                       func_sym->declaration ? func_sym->declaration->location : SourceLocation());
+                }
+                continue;
             }
-            if (facts.reentrancy_variants[callee_sym].insert(ctx).second) {
-                work.emplace_back(callee_sym, ctx);
+            for (uint32_t callee : graph.callees(node)) {
+                const Symbol* callee_sym = graph.symbol(callee);
+                if (!callee_sym) continue;
+                if (reentrant && external_nonreentrant.count(callee_sym)) {
+                    throw CompileError("Reentrant path calls non-reentrant external function '" + callee_sym->name + "'",
+                                       it->second->location);
+                }
+                contexts[callee] |= component_contexts;
             }
         }
     }
 
+    for (uint32_t node = 0; node < graph.node_count(); node++) {
+        const Symbol* sym = graph.symbol(node);
+        if (!sym || contexts[node] == 0) continue;
+        auto& variants = facts.reentrancy_variants[sym];
+        if (contexts[node] & kReentrant) variants.insert('R');
+        if (contexts[node] & kNonReentrant) variants.insert('N');
+    }
+
     char default_entry_ctx = normalize_ctx(analysis_config.default_entry_context);
     for (const auto& entry : function_map) {
         const Symbol* func_sym = entry.first;
@@ -1,6 +1,7 @@
 #include "analysis_report.h"
 #include <algorithm>
-#include <sstream>
+#include <cstdio>
+#include <utility>
 #include <vector>
 
 namespace vexel {
@@ -24,11 +25,123 @@ std::string symbol_label(const Symbol* sym) {
     }
     return label;
 }
+
+bool symbol_order(const Symbol* a, const Symbol* b) {
+    if (!a || !b) return a < b;
+    if (a->name == b->name) return a->instance_id < b->instance_id;
+    return a->name < b->name;
+}
+
+template <typename Range, typename Key>
+std::vector<const Symbol*> sorted_symbols(const Range& range, Key key) {
+    std::vector<const Symbol*> out;
+    out.reserve(range.size());
+    for (const auto& item : range) {
+        out.push_back(key(item));
+    }
+    std::sort(out.begin(), out.end(), symbol_order);
+    return out;
+}
+
+std::vector<const Symbol*> sorted_fold_skips(const OptimizationFacts& optimization) {
+    return sorted_symbols(optimization.fold_skip_reasons, [](const auto& pair) { return pair.first; });
+}
+
+std::vector<const Symbol*> sorted_reachable(const AnalysisFacts& analysis) {
+    return sorted_symbols(analysis.reachable_functions, [](const Symbol* sym) { return sym; });
+}
+
+std::vector<const Symbol*> sorted_reentrancy(const AnalysisFacts& analysis) {
+    return sorted_symbols(analysis.reentrancy_variants, [](const auto& pair) { return pair.first; });
+}
+
+std::vector<const Symbol*> sorted_ref_variants(const AnalysisFacts& analysis) {
+    return sorted_symbols(analysis.ref_variants, [](const auto& pair) { return pair.first; });
+}
+
+std::vector<char> sorted_tags(const std::unordered_set<char>& variants) {
+    std::vector<char> sorted(variants.begin(), variants.end());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+std::vector<std::string> sorted_masks(const std::unordered_set<std::string>& masks) {
+    std::vector<std::string> sorted(masks.begin(), masks.end());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+// Ordered by label, then mutability: the same order as sorting the
+// "label -> mutability" text lines, since labels never contain characters
+// below the separator's space.
+struct LabeledSymbol {
+    std::string label;
+    const Symbol* sym;
+};
+
+std::vector<std::pair<LabeledSymbol, VarMutability>> sorted_mutability(const AnalysisFacts& analysis) {
+    std::vector<std::pair<LabeledSymbol, VarMutability>> out;
+    out.reserve(analysis.var_mutability.size());
+    for (const auto& pair : analysis.var_mutability) {
+        out.push_back({LabeledSymbol{symbol_label(pair.first), pair.first}, pair.second});
+    }
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+        if (a.first.label != b.first.label) return a.first.label < b.first.label;
+        return mutability_label(a.second) < mutability_label(b.second);
+    });
+    return out;
+}
+
+std::vector<LabeledSymbol> sorted_used_globals(const AnalysisFacts& analysis) {
+    std::vector<LabeledSymbol> out;
+    out.reserve(analysis.used_global_vars.size());
+    for (const auto& sym : analysis.used_global_vars) {
+        out.push_back(LabeledSymbol{symbol_label(sym), sym});
+    }
+    std::sort(out.begin(), out.end(), [](const LabeledSymbol& a, const LabeledSymbol& b) {
+        return a.label < b.label;
+    });
+    return out;
+}
+
+std::vector<std::string> sorted_used_types(const AnalysisFacts& analysis) {
+    std::vector<std::string> out(analysis.used_type_names.begin(), analysis.used_type_names.end());
+    std::sort(out.begin(), out.end());
+    return out;
 }
 
-std::string format_analysis_report(const Module& mod, const AnalysisFacts& analysis,
-                                   const OptimizationFacts* optimization) {
-    std::ostringstream out;
+void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+                    out << buf;
+                } else {
+                    out << c;
+                }
+                break;
+        }
+    }
+    out << '"';
+}
+
+void write_json_symbol(std::ostream& out, const Symbol* sym) {
+    out << "\"symbol\": ";
+    write_json_string(out, sym ? sym->name : std::string("<unknown>"));
+    out << ", \"instance\": " << (sym ? sym->instance_id : -1);
+}
+}
+
+void write_analysis_report(std::ostream& out, const Module& mod, const AnalysisFacts& analysis,
+                           const OptimizationFacts* optimization) {
     out << "# Vexel Analysis Report\n";
     if (!mod.name.empty()) {
         out << "Module: " << mod.name << "\n";
@@ -37,123 +150,172 @@ std::string format_analysis_report(const Module& mod, const AnalysisFacts& analy
 
     if (optimization) {
         out << "## Optimization Summary\n";
-        out << "- Constexpr expressions: " << optimization->constexpr_values.size() << "\n";
+        const ConstexprFactStore* constexpr_facts = optimization->constexpr_facts;
+        out << "- Constexpr expressions: " << (constexpr_facts ? constexpr_facts->value_count() : 0) << "\n";
         out << "- Constexpr inits: " << optimization->constexpr_inits.size() << "\n";
         out << "- Foldable functions: " << optimization->foldable_functions.size() << "\n";
-        out << "- Constexpr conditions: " << optimization->constexpr_conditions.size() << "\n\n";
-
-        std::vector<const Symbol*> skipped;
-        skipped.reserve(optimization->fold_skip_reasons.size());
-        for (const auto& pair : optimization->fold_skip_reasons) {
-            skipped.push_back(pair.first);
-        }
-        std::sort(skipped.begin(), skipped.end(), [](const Symbol* a, const Symbol* b) {
-            if (!a || !b) return a < b;
-            if (a->name == b->name) return a->instance_id < b->instance_id;
-            return a->name < b->name;
-        });
+        out << "- Constexpr conditions: " << (constexpr_facts ? constexpr_facts->condition_count() : 0) << "\n\n";
 
         out << "## Fold Skip Reasons\n";
-        for (const auto& sym : skipped) {
+        for (const auto& sym : sorted_fold_skips(*optimization)) {
             out << "- " << symbol_label(sym) << ": " << optimization->fold_skip_reasons.at(sym) << "\n";
         }
         out << "\n";
+
+        if (!optimization->specializations.empty()) {
+            out << "## Specializations\n";
+            for (const auto& spec : optimization->specializations) {
+                out << "- " << symbol_label(spec.clone) << " <- " << symbol_label(spec.original) << "("
+                    << spec.bindings << ")\n";
+            }
+            out << "\n";
+        }
+
+        if (!optimization->loop_rewrites.empty()) {
+            out << "## Loop Rewrites\n";
+            for (const auto& rewrite : optimization->loop_rewrites) {
+                out << "- " << symbol_label(rewrite.function) << ": hoisted " << rewrite.hoisted
+                    << ", strength-reduced " << rewrite.strength_reduced << "\n";
+            }
+            out << "\n";
+        }
     }
 
-    std::vector<const Symbol*> reachable(analysis.reachable_functions.begin(),
-                                         analysis.reachable_functions.end());
-    std::sort(reachable.begin(), reachable.end(), [](const Symbol* a, const Symbol* b) {
-        if (!a || !b) return a < b;
-        if (a->name == b->name) return a->instance_id < b->instance_id;
-        return a->name < b->name;
-    });
     out << "## Reachable Functions\n";
-    for (const auto& sym : reachable) {
+    for (const auto& sym : sorted_reachable(analysis)) {
         out << "- " << symbol_label(sym) << "\n";
     }
     out << "\n";
 
-    std::vector<const Symbol*> reent_keys;
-    reent_keys.reserve(analysis.reentrancy_variants.size());
-    for (const auto& pair : analysis.reentrancy_variants) {
-        reent_keys.push_back(pair.first);
-    }
-    std::sort(reent_keys.begin(), reent_keys.end(), [](const Symbol* a, const Symbol* b) {
-        if (!a || !b) return a < b;
-        if (a->name == b->name) return a->instance_id < b->instance_id;
-        return a->name < b->name;
-    });
     out << "## Reentrancy Variants\n";
-    for (const auto& sym : reent_keys) {
-        const auto& variants = analysis.reentrancy_variants.at(sym);
-        std::vector<char> sorted(variants.begin(), variants.end());
-        std::sort(sorted.begin(), sorted.end());
-        std::string tags;
-        for (char v : sorted) {
-            if (!tags.empty()) tags += ",";
-            tags.push_back(v);
+    for (const auto& sym : sorted_reentrancy(analysis)) {
+        out << "- " << symbol_label(sym) << ": ";
+        bool first = true;
+        for (char v : sorted_tags(analysis.reentrancy_variants.at(sym))) {
+            if (!first) out << ",";
+            out << v;
+            first = false;
         }
-        out << "- " << symbol_label(sym) << ": " << tags << "\n";
+        out << "\n";
     }
     out << "\n";
 
-    std::vector<const Symbol*> ref_syms;
-    ref_syms.reserve(analysis.ref_variants.size());
-    for (const auto& pair : analysis.ref_variants) {
-        ref_syms.push_back(pair.first);
-    }
-    std::sort(ref_syms.begin(), ref_syms.end(), [](const Symbol* a, const Symbol* b) {
-        if (!a || !b) return a < b;
-        if (a->name == b->name) return a->instance_id < b->instance_id;
-        return a->name < b->name;
-    });
     out << "## Ref Variants\n";
-    for (const auto& sym : ref_syms) {
-        const auto& masks = analysis.ref_variants.at(sym);
-        std::vector<std::string> sorted_masks(masks.begin(), masks.end());
-        std::sort(sorted_masks.begin(), sorted_masks.end());
+    for (const auto& sym : sorted_ref_variants(analysis)) {
+        std::vector<std::string> masks = sorted_masks(analysis.ref_variants.at(sym));
         out << "- " << symbol_label(sym) << ": ";
-        for (size_t i = 0; i < sorted_masks.size(); ++i) {
+        for (size_t i = 0; i < masks.size(); ++i) {
             if (i > 0) out << ", ";
-            out << (sorted_masks[i].empty() ? "<default>" : sorted_masks[i]);
+            out << (masks[i].empty() ? "<default>" : masks[i]);
         }
         out << "\n";
     }
     out << "\n";
 
-    std::vector<std::string> mut_lines;
-    mut_lines.reserve(analysis.var_mutability.size());
-    for (const auto& pair : analysis.var_mutability) {
-        mut_lines.push_back(symbol_label(pair.first) + " -> " + mutability_label(pair.second));
-    }
-    std::sort(mut_lines.begin(), mut_lines.end());
     out << "## Variable Mutability\n";
-    for (const auto& line : mut_lines) {
-        out << "- " << line << "\n";
+    for (const auto& entry : sorted_mutability(analysis)) {
+        out << "- " << entry.first.label << " -> " << mutability_label(entry.second) << "\n";
     }
     out << "\n";
 
-    std::vector<std::string> used_globals;
-    used_globals.reserve(analysis.used_global_vars.size());
-    for (const auto& sym : analysis.used_global_vars) {
-        used_globals.push_back(symbol_label(sym));
-    }
-    std::sort(used_globals.begin(), used_globals.end());
     out << "## Used Globals\n";
-    for (const auto& name : used_globals) {
-        out << "- " << name << "\n";
+    for (const auto& global : sorted_used_globals(analysis)) {
+        out << "- " << global.label << "\n";
     }
     out << "\n";
 
-    std::vector<std::string> used_types(analysis.used_type_names.begin(),
-                                        analysis.used_type_names.end());
-    std::sort(used_types.begin(), used_types.end());
     out << "## Used Types\n";
-    for (const auto& name : used_types) {
+    for (const auto& name : sorted_used_types(analysis)) {
         out << "- " << name << "\n";
     }
+}
+
+void write_analysis_report_jsonl(std::ostream& out, const Module& mod, const AnalysisFacts& analysis,
+                                 const OptimizationFacts* optimization) {
+    out << "{\"kind\": \"module\", \"name\": ";
+    write_json_string(out, mod.name);
+    out << "}\n";
+
+    if (optimization) {
+        const ConstexprFactStore* constexpr_facts = optimization->constexpr_facts;
+        out << "{\"kind\": \"summary\""
+            << ", \"constexpr_expressions\": " << (constexpr_facts ? constexpr_facts->value_count() : 0)
+            << ", \"constexpr_inits\": " << optimization->constexpr_inits.size()
+            << ", \"foldable_functions\": " << optimization->foldable_functions.size()
+            << ", \"constexpr_conditions\": " << (constexpr_facts ? constexpr_facts->condition_count() : 0)
+            << "}\n";
+        for (const auto& sym : sorted_fold_skips(*optimization)) {
+            out << "{\"kind\": \"fold_skip\", ";
+            write_json_symbol(out, sym);
+            out << ", \"reason\": ";
+            write_json_string(out, optimization->fold_skip_reasons.at(sym));
+            out << "}\n";
+        }
+        for (const auto& spec : optimization->specializations) {
+            out << "{\"kind\": \"specialization\", ";
+            write_json_symbol(out, spec.clone);
+            out << ", \"original\": ";
+            write_json_string(out, symbol_label(spec.original));
+            out << ", \"bindings\": ";
+            write_json_string(out, spec.bindings);
+            out << "}\n";
+        }
+        for (const auto& rewrite : optimization->loop_rewrites) {
+            out << "{\"kind\": \"loop_rewrite\", ";
+            write_json_symbol(out, rewrite.function);
+            out << ", \"hoisted\": " << rewrite.hoisted << ", \"strength_reduced\": " << rewrite.strength_reduced
+                << "}\n";
+        }
+    }
+
+    for (const auto& sym : sorted_reachable(analysis)) {
+        out << "{\"kind\": \"reachable\", ";
+        write_json_symbol(out, sym);
+        out << "}\n";
+    }
+
+    for (const auto& sym : sorted_reentrancy(analysis)) {
+        out << "{\"kind\": \"reentrancy\", ";
+        write_json_symbol(out, sym);
+        out << ", \"variants\": [";
+        bool first = true;
+        for (char v : sorted_tags(analysis.reentrancy_variants.at(sym))) {
+            if (!first) out << ", ";
+            write_json_string(out, std::string(1, v));
+            first = false;
+        }
+        out << "]}\n";
+    }
 
-    return out.str();
+    for (const auto& sym : sorted_ref_variants(analysis)) {
+        out << "{\"kind\": \"ref_variants\", ";
+        write_json_symbol(out, sym);
+        out << ", \"masks\": [";
+        std::vector<std::string> masks = sorted_masks(analysis.ref_variants.at(sym));
+        for (size_t i = 0; i < masks.size(); ++i) {
+            if (i > 0) out << ", ";
+            write_json_string(out, masks[i]);
+        }
+        out << "]}\n";
+    }
+
+    for (const auto& entry : sorted_mutability(analysis)) {
+        out << "{\"kind\": \"mutability\", ";
+        write_json_symbol(out, entry.first.sym);
+        out << ", \"mutability\": \"" << mutability_label(entry.second) << "\"}\n";
+    }
+
+    for (const auto& global : sorted_used_globals(analysis)) {
+        out << "{\"kind\": \"used_global\", ";
+        write_json_symbol(out, global.sym);
+        out << "}\n";
+    }
+
+    for (const auto& name : sorted_used_types(analysis)) {
+        out << "{\"kind\": \"used_type\", \"name\": ";
+        write_json_string(out, name);
+        out << "}\n";
+    }
 }
 
 } // namespace vexel
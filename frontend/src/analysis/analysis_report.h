@@ -1,11 +1,20 @@
 #pragma once
 #include "analysis.h"
 #include "optimizer.h"
+#include <ostream>
 #include <string>
 
 namespace vexel {
 
-std::string format_analysis_report(const Module& mod, const AnalysisFacts& analysis,
-                                   const OptimizationFacts* optimization = nullptr);
+// Streams the `--emit-analysis` report section by section, so only the sorted
+// symbol lists of one section are held at a time.
+void write_analysis_report(std::ostream& out, const Module& mod, const AnalysisFacts& analysis,
+                           const OptimizationFacts* optimization = nullptr);
+
+// Same facts as one JSON object per line, each tagged with a "kind" field
+// ("module", "summary", "fold_skip", "reachable", "reentrancy", "ref_variants",
+// "mutability", "used_global", "used_type"), in the text report's order.
+void write_analysis_report_jsonl(std::ostream& out, const Module& mod, const AnalysisFacts& analysis,
+                                 const OptimizationFacts* optimization = nullptr);
 
 } // namespace vexel
@@ -50,59 +50,28 @@ void Analyzer::analyze_usage(const Module& /*mod*/, AnalysisFacts& facts) {
             }
     };
 
-    auto mark_expr_types = [&](const ExprPtr& expr) {
-        if (!expr) return;
-        mark_type(expr->type);
-        mark_type(expr->declared_var_type);
-        mark_type(expr->target_type);
-        if (expr->kind == Expr::Kind::Identifier) {
-            if (Symbol* sym = binding_for(expr)) {
-                mark_type(sym->type);
-            }
-        }
-    };
-
-    auto mark_stmt_types = [&](const StmtPtr& stmt) {
-        if (!stmt) return;
-        if (stmt->kind == Stmt::Kind::VarDecl) {
-            mark_type(stmt->var_type);
-        }
-    };
-
     std::deque<const Symbol*> global_worklist;
     auto note_global = [&](const Symbol* sym) {
         if (!sym) return;
-        if (facts.used_global_vars.insert(sym).second) {
+        if (facts.used_global_vars.insert(sym)) {
             global_worklist.push_back(sym);
         }
     };
 
     // Exported globals are ABI roots and must always be retained.
     for (const auto& instance : program->instances) {
-        for (const auto& pair : instance.symbols) {
-            const Symbol* sym = pair.second;
-            if (!sym || !sym->is_exported || sym->is_local) continue;
-            if (sym->kind != Symbol::Kind::Variable && sym->kind != Symbol::Kind::Constant) continue;
+        instance.for_each_symbol([&](const Symbol* sym) {
+            if (!sym || !sym->is_exported || sym->is_local) return;
+            if (sym->kind != Symbol::Kind::Variable && sym->kind != Symbol::Kind::Constant) return;
             note_global(sym);
-        }
+        });
     }
 
     for (const auto& func_sym : facts.reachable_functions) {
         if (!func_sym || !func_sym->declaration || !func_sym->declaration->body) continue;
-        auto func_scope = scoped_instance(func_sym->instance_id);
-        (void)func_scope;
-        walk_runtime_expr(
-            func_sym->declaration->body,
-            [&](ExprPtr expr) {
-                mark_expr_types(expr);
-                if (!expr || expr->kind != Expr::Kind::Identifier) return;
-                Symbol* sym = binding_for(expr);
-                if (sym && !sym->is_local &&
-                    (sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant)) {
-                    note_global(sym);
-                }
-            },
-            [&](StmtPtr stmt) { mark_stmt_types(stmt); });
+        const BodySummary& body = body_summary(func_sym);
+        for (const auto& name : body.type_names) add_type_name(name);
+        for (const Symbol* used : body.global_reads) note_global(used);
         for (const auto& param : func_sym->declaration->params) {
             mark_type(param.type);
         }
@@ -121,21 +90,11 @@ void Analyzer::analyze_usage(const Module& /*mod*/, AnalysisFacts& facts) {
         const Symbol* sym = global_worklist.front();
         global_worklist.pop_front();
         if (!sym || !sym->declaration) continue;
-        auto global_scope = scoped_instance(sym->instance_id);
-        (void)global_scope;
         mark_type(sym->declaration->var_type);
-        walk_runtime_expr(
-            sym->declaration->var_init,
-            [&](ExprPtr expr) {
-                mark_expr_types(expr);
-                if (!expr || expr->kind != Expr::Kind::Identifier) return;
-                Symbol* used = binding_for(expr);
-                if (used && !used->is_local &&
-                    (used->kind == Symbol::Kind::Variable || used->kind == Symbol::Kind::Constant)) {
-                    note_global(used);
-                }
-            },
-            [&](StmtPtr stmt) { mark_stmt_types(stmt); });
+        if (!sym->declaration->var_init) continue;
+        const BodySummary& body = body_summary(sym);
+        for (const auto& name : body.type_names) add_type_name(name);
+        for (const Symbol* used : body.global_reads) note_global(used);
     }
 
     while (!type_worklist.empty()) {
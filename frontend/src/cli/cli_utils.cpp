@@ -2,7 +2,10 @@
 #include "common.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <string_view>
+#include <unordered_set>
 
 namespace vexel {
 
@@ -48,6 +51,70 @@ bool parse_type_strictness_arg(const char* value, Compiler::Options& opts, std::
     return true;
 }
 
+bool parse_jobs_value(const char* value, int& out_jobs) {
+    if (!value || *value == '\0') return false;
+    int parsed = 0;
+    for (const char* c = value; *c; ++c) {
+        if (*c < '0' || *c > '9' || parsed > 4096) return false;
+        parsed = parsed * 10 + (*c - '0');
+    }
+    if (parsed <= 0) return false;
+    out_jobs = parsed;
+    return true;
+}
+
+bool parse_step_budget_value(const char* value, uint64_t& out_steps) {
+    if (!value || *value == '\0') return false;
+    uint64_t parsed = 0;
+    for (const char* c = value; *c; ++c) {
+        if (*c < '0' || *c > '9' || parsed > UINT64_MAX / 10) return false;
+        parsed = parsed * 10 + static_cast<uint64_t>(*c - '0');
+    }
+    if (parsed == 0) return false;
+    out_steps = parsed;
+    return true;
+}
+
+// A byte count with an optional binary K, M or G suffix.
+bool parse_memory_limit_value(const char* value, uint64_t& out_bytes) {
+    if (!value || *value == '\0') return false;
+    uint64_t parsed = 0;
+    const char* c = value;
+    for (; *c >= '0' && *c <= '9'; ++c) {
+        if (parsed > UINT64_MAX / 10) return false;
+        parsed = parsed * 10 + static_cast<uint64_t>(*c - '0');
+    }
+    if (c == value) return false;
+    unsigned shift = 0;
+    if (*c != '\0') {
+        switch (*c) {
+            case 'K': case 'k': shift = 10; break;
+            case 'M': case 'm': shift = 20; break;
+            case 'G': case 'g': shift = 30; break;
+            default: return false;
+        }
+        if (c[1] != '\0') return false;
+    }
+    if (parsed == 0 || parsed > (UINT64_MAX >> shift)) return false;
+    out_bytes = parsed << shift;
+    return true;
+}
+
+// Option names (text before any `=`) try_parse_common_compiler_option
+// handles. Backend options and input files miss this set and skip the
+// strcmp chain entirely.
+bool is_common_option_name(const char* arg) {
+    static const std::unordered_set<std::string_view> kNames = {
+        "-v", "-o", "-j", "--jobs", "--emit-analysis", "--allow-process", "--check-all", "--strict-types",
+        "--type-strictness", "--time-passes", "--stats-json", "--trace", "-MD", "--depfile", "--cte-cache",
+        "--parse-cache", "--incremental", "--emit-analyzed", "--from-analyzed", "--analyzed-cache",
+        "--process-cache", "--process-input", "--parallel-typecheck", "--parallel-optimize",
+        "--parallel-codegen", "--cte-profile", "--cte-step-budget", "--cte-memory-limit", "--pass-invariants",
+    };
+    const char* eq = std::strchr(arg, '=');
+    return kNames.count(eq ? std::string_view(arg, static_cast<size_t>(eq - arg)) : std::string_view(arg)) != 0;
+}
+
 } // namespace
 
 bool try_read_backend_arg(int argc,
@@ -91,6 +158,9 @@ bool try_parse_common_compiler_option(int argc,
                                       int& index,
                                       Compiler::Options& opts,
                                       std::string& error) {
+    if (!is_common_option_name(argv[index])) {
+        return false;
+    }
     if (std::strcmp(argv[index], "-v") == 0) {
         opts.verbose = true;
         return true;
@@ -99,10 +169,28 @@ bool try_parse_common_compiler_option(int argc,
         opts.emit_analysis = true;
         return true;
     }
+    constexpr const char* kEmitAnalysisPrefix = "--emit-analysis=";
+    if (std::strncmp(argv[index], kEmitAnalysisPrefix, std::strlen(kEmitAnalysisPrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kEmitAnalysisPrefix);
+        if (std::strcmp(value, "text") == 0) {
+            opts.analysis_jsonl = false;
+        } else if (std::strcmp(value, "jsonl") == 0) {
+            opts.analysis_jsonl = true;
+        } else {
+            error = "--emit-analysis expects text or jsonl";
+            return true;
+        }
+        opts.emit_analysis = true;
+        return true;
+    }
     if (std::strcmp(argv[index], "--allow-process") == 0) {
         opts.allow_process = true;
         return true;
     }
+    if (std::strcmp(argv[index], "--check-all") == 0) {
+        opts.check_all = true;
+        return true;
+    }
     if (std::strcmp(argv[index], "--strict-types") == 0) {
         opts.type_strictness = std::max(opts.type_strictness, 1);
         return true;
@@ -137,6 +225,254 @@ bool try_parse_common_compiler_option(int argc,
         (void)parse_type_strictness_arg(value, opts, error);
         return true;
     }
+    if (std::strcmp(argv[index], "--time-passes") == 0) {
+        opts.time_passes = true;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--stats-json") == 0) {
+        if (index + 1 >= argc) {
+            error = "--stats-json requires an argument";
+            return true;
+        }
+        opts.stats_json = argv[++index];
+        return true;
+    }
+    constexpr const char* kStatsJsonPrefix = "--stats-json=";
+    if (std::strncmp(argv[index], kStatsJsonPrefix, std::strlen(kStatsJsonPrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kStatsJsonPrefix);
+        if (*value == '\0') {
+            error = "--stats-json requires a non-empty path";
+            return true;
+        }
+        opts.stats_json = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--trace") == 0) {
+        if (index + 1 >= argc) {
+            error = "--trace requires an argument";
+            return true;
+        }
+        opts.trace = argv[++index];
+        return true;
+    }
+    constexpr const char* kTracePrefix = "--trace=";
+    if (std::strncmp(argv[index], kTracePrefix, std::strlen(kTracePrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kTracePrefix);
+        if (*value == '\0') {
+            error = "--trace requires a non-empty path";
+            return true;
+        }
+        opts.trace = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "-MD") == 0) {
+        opts.emit_depfile = true;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--depfile") == 0) {
+        if (index + 1 >= argc) {
+            error = "--depfile requires an argument";
+            return true;
+        }
+        opts.emit_depfile = true;
+        opts.depfile = argv[++index];
+        return true;
+    }
+    constexpr const char* kDepfilePrefix = "--depfile=";
+    if (std::strncmp(argv[index], kDepfilePrefix, std::strlen(kDepfilePrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kDepfilePrefix);
+        if (*value == '\0') {
+            error = "--depfile requires a non-empty path";
+            return true;
+        }
+        opts.emit_depfile = true;
+        opts.depfile = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--cte-cache") == 0) {
+        opts.cte_cache = true;
+        return true;
+    }
+    constexpr const char* kCteCachePrefix = "--cte-cache=";
+    if (std::strncmp(argv[index], kCteCachePrefix, std::strlen(kCteCachePrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kCteCachePrefix);
+        if (*value == '\0') {
+            error = "--cte-cache requires a non-empty directory";
+            return true;
+        }
+        opts.cte_cache = true;
+        opts.cte_cache_dir = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--parse-cache") == 0) {
+        opts.parse_cache = true;
+        return true;
+    }
+    constexpr const char* kParseCachePrefix = "--parse-cache=";
+    if (std::strncmp(argv[index], kParseCachePrefix, std::strlen(kParseCachePrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kParseCachePrefix);
+        if (*value == '\0') {
+            error = "--parse-cache requires a non-empty directory";
+            return true;
+        }
+        opts.parse_cache = true;
+        opts.parse_cache_dir = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--incremental") == 0) {
+        opts.incremental = true;
+        return true;
+    }
+    constexpr const char* kIncrementalPrefix = "--incremental=";
+    if (std::strncmp(argv[index], kIncrementalPrefix, std::strlen(kIncrementalPrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kIncrementalPrefix);
+        if (*value == '\0') {
+            error = "--incremental requires a non-empty directory";
+            return true;
+        }
+        opts.incremental = true;
+        opts.incremental_dir = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--emit-analyzed") == 0) {
+        if (index + 1 >= argc) {
+            error = "--emit-analyzed requires an argument";
+            return true;
+        }
+        opts.emit_analyzed = argv[++index];
+        return true;
+    }
+    constexpr const char* kEmitAnalyzedPrefix = "--emit-analyzed=";
+    if (std::strncmp(argv[index], kEmitAnalyzedPrefix, std::strlen(kEmitAnalyzedPrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kEmitAnalyzedPrefix);
+        if (*value == '\0') {
+            error = "--emit-analyzed requires a non-empty path";
+            return true;
+        }
+        opts.emit_analyzed = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--from-analyzed") == 0) {
+        if (index + 1 >= argc) {
+            error = "--from-analyzed requires an argument";
+            return true;
+        }
+        opts.from_analyzed = argv[++index];
+        return true;
+    }
+    constexpr const char* kFromAnalyzedPrefix = "--from-analyzed=";
+    if (std::strncmp(argv[index], kFromAnalyzedPrefix, std::strlen(kFromAnalyzedPrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kFromAnalyzedPrefix);
+        if (*value == '\0') {
+            error = "--from-analyzed requires a non-empty path";
+            return true;
+        }
+        opts.from_analyzed = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--analyzed-cache") == 0) {
+        opts.analyzed_cache = true;
+        return true;
+    }
+    constexpr const char* kAnalyzedCachePrefix = "--analyzed-cache=";
+    if (std::strncmp(argv[index], kAnalyzedCachePrefix, std::strlen(kAnalyzedCachePrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kAnalyzedCachePrefix);
+        if (*value == '\0') {
+            error = "--analyzed-cache requires a non-empty directory";
+            return true;
+        }
+        opts.analyzed_cache = true;
+        opts.analyzed_cache_dir = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--process-cache") == 0) {
+        opts.process_cache = true;
+        return true;
+    }
+    constexpr const char* kProcessCachePrefix = "--process-cache=";
+    if (std::strncmp(argv[index], kProcessCachePrefix, std::strlen(kProcessCachePrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kProcessCachePrefix);
+        if (*value == '\0') {
+            error = "--process-cache requires a non-empty directory";
+            return true;
+        }
+        opts.process_cache = true;
+        opts.process_cache_dir = value;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--process-input") == 0) {
+        if (index + 1 >= argc) {
+            error = "--process-input requires an argument";
+            return true;
+        }
+        opts.process_inputs.push_back(argv[++index]);
+        return true;
+    }
+    constexpr const char* kProcessInputPrefix = "--process-input=";
+    if (std::strncmp(argv[index], kProcessInputPrefix, std::strlen(kProcessInputPrefix)) == 0) {
+        const char* value = argv[index] + std::strlen(kProcessInputPrefix);
+        if (*value == '\0') {
+            error = "--process-input requires a non-empty path";
+            return true;
+        }
+        opts.process_inputs.push_back(value);
+        return true;
+    }
+    if (std::strcmp(argv[index], "--parallel-typecheck") == 0) {
+        opts.parallel_typecheck = true;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--parallel-optimize") == 0) {
+        opts.parallel_optimize = true;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--parallel-codegen") == 0) {
+        opts.parallel_codegen = true;
+        return true;
+    }
+    if (std::strcmp(argv[index], "--cte-profile") == 0) {
+        opts.cte_profile = true;
+        return true;
+    }
+    constexpr const char* kStepBudgetPrefix = "--cte-step-budget=";
+    if (std::strncmp(argv[index], kStepBudgetPrefix, std::strlen(kStepBudgetPrefix)) == 0) {
+        if (!parse_step_budget_value(argv[index] + std::strlen(kStepBudgetPrefix), opts.cte_step_budget)) {
+            error = "--cte-step-budget expects a positive integer";
+        }
+        return true;
+    }
+    constexpr const char* kMemoryLimitPrefix = "--cte-memory-limit=";
+    if (std::strncmp(argv[index], kMemoryLimitPrefix, std::strlen(kMemoryLimitPrefix)) == 0) {
+        if (!parse_memory_limit_value(argv[index] + std::strlen(kMemoryLimitPrefix), opts.cte_memory_limit)) {
+            error = "--cte-memory-limit expects a positive byte count, optionally suffixed K, M or G";
+        }
+        return true;
+    }
+    constexpr const char* kPassInvariantsPrefix = "--pass-invariants=";
+    if (std::strncmp(argv[index], kPassInvariantsPrefix, std::strlen(kPassInvariantsPrefix)) == 0) {
+        if (!parse_invariant_config(argv[index] + std::strlen(kPassInvariantsPrefix), opts.invariants)) {
+            error = "--pass-invariants expects off, boundary, sampled[:<period>[:<seed>]] or full";
+        }
+        return true;
+    }
+    if (std::strcmp(argv[index], "-j") == 0 || std::strcmp(argv[index], "--jobs") == 0) {
+        if (index + 1 >= argc) {
+            error = std::string(argv[index]) + " requires an argument";
+            return true;
+        }
+        const char* value = argv[++index];
+        if (!parse_jobs_value(value, opts.jobs)) {
+            error = "--jobs expects a positive integer";
+        }
+        return true;
+    }
+    constexpr const char* kJobsPrefix = "--jobs=";
+    if (std::strncmp(argv[index], kJobsPrefix, std::strlen(kJobsPrefix)) == 0) {
+        if (!parse_jobs_value(argv[index] + std::strlen(kJobsPrefix), opts.jobs)) {
+            error = "--jobs expects a positive integer";
+        }
+        return true;
+    }
     if (std::strcmp(argv[index], "-o") == 0) {
         if (index + 1 >= argc) {
             error = "-o requires an argument";
@@ -179,8 +515,8 @@ int run_compiler_with_diagnostics(const Compiler::Options& opts, std::ostream& e
         return 0;
     } catch (const CompileError& e) {
         err << "Error";
-        if (!e.location.filename.empty()) {
-            err << " at " << e.location.filename
+        if (!e.location.filename().empty()) {
+            err << " at " << e.location.filename()
                 << ":" << e.location.line
                 << ":" << e.location.column;
         }
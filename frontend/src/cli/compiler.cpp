@@ -1,18 +1,34 @@
 #include "compiler.h"
 #include "analysis_report.h"
+#include "analyzed_program_io.h"
 #include "backend_registry.h"
 #include "constants.h"
+#include "content_hash.h"
+#include "cte_persistent_cache.h"
+#include "cte_profile.h"
+#include "depfile.h"
+#include "fingerprint_db.h"
 #include "frontend_pipeline.h"
 #include "io_utils.h"
+#include "module_cache.h"
 #include "module_loader.h"
+#include "path_utils.h"
+#include "pipeline_stats.h"
+#include "pipeline_trace.h"
+#include "process_cache.h"
 #include "analyzed_program_builder.h"
 #include "resolver.h"
+#include "thread_pool.h"
 #include "typechecker.h"
 
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <optional>
 
 namespace vexel {
 
@@ -65,22 +81,466 @@ AnalysisConfig build_analysis_config(const Backend* backend,
 
 struct PreparedCompilation {
     const Backend* backend = nullptr;
+    BackendAnalysisRequirements requirements;
     Compiler::OutputPaths paths;
     Program program;
     Bindings bindings;
     std::unique_ptr<Resolver> resolver;
     std::unique_ptr<TypeChecker> checker;
     FrontendPipelineResult pipeline;
+    PipelineStats stats;
+    std::unique_ptr<CTEPersistentCache> cte_cache;
+    std::unique_ptr<ProcessOutputCache> process_cache;
+    std::unique_ptr<CTEProfile> cte_profile;
+    // Import and resource path lookups of every stage.
+    std::unique_ptr<DirectoryCache> directory_cache;
+    // `--incremental`: project modules as loaded, before any pass rewrites
+    // them, with the program module id of each.
+    std::vector<ModuleFingerprint> module_fingerprints;
+    std::vector<ModuleId> fingerprint_module_ids;
+    // `--from-analyzed` or an analyzed-cache hit: the frontend's result read
+    // back instead of recomputed. Resolver, checker and pipeline stay empty.
+    std::unique_ptr<LoadedAnalyzedProgram> loaded;
+    // Analyzed-cache entry the frontend's result is stored under.
+    std::string analyzed_cache_entry;
 };
 
-PreparedCompilation prepare_compilation(const Compiler::Options& options, const Backend* backend_override = nullptr) {
+bool stats_requested(const Compiler::Options& options) {
+    return options.time_passes || !options.stats_json.empty();
+}
+
+std::string cte_cache_path(const Compiler::Options& options, const Compiler::OutputPaths& paths) {
+    std::filesystem::path dir = options.cte_cache_dir.empty()
+                                    ? paths.dir / ".vexel-cache"
+                                    : std::filesystem::path(options.cte_cache_dir);
+    return (dir / "cte_calls.cache").string();
+}
+
+std::string default_cache_dir(const Compiler::Options& options) {
+    std::filesystem::path dir = std::filesystem::path(options.output_file).parent_path();
+    if (dir.empty()) dir = ".";
+    return (dir / ".vexel-cache").string();
+}
+
+std::string parse_cache_dir(const Compiler::Options& options) {
+    return options.parse_cache_dir.empty() ? default_cache_dir(options) : options.parse_cache_dir;
+}
+
+std::string process_cache_dir(const Compiler::Options& options) {
+    return options.process_cache_dir.empty() ? default_cache_dir(options) : options.process_cache_dir;
+}
+
+std::string incremental_dir(const Compiler::Options& options) {
+    return options.incremental_dir.empty() ? default_cache_dir(options) : options.incremental_dir;
+}
+
+std::string analyzed_cache_dir(const Compiler::Options& options) {
+    return options.analyzed_cache_dir.empty() ? default_cache_dir(options) : options.analyzed_cache_dir;
+}
+
+// Process expressions read host state the recorded inputs cannot see, and a
+// requested compile-time profile describes a frontend run.
+bool analyzed_cache_enabled(const Compiler::Options& options) {
+    return options.analyzed_cache && options.from_analyzed.empty() && !options.allow_process &&
+           !options.cte_profile;
+}
+
+// `--incremental` keeps the parse and CTE caches in its directory, so a build
+// after a body edit re-parses only the edited modules and re-evaluates only
+// the compile-time calls whose inputs changed.
+Compiler::Options with_incremental_caches(const Compiler::Options& options) {
+    if (!options.incremental) return options;
+    Compiler::Options effective = options;
+    effective.parse_cache = true;
+    effective.cte_cache = true;
+    if (effective.parse_cache_dir.empty()) effective.parse_cache_dir = options.incremental_dir;
+    if (effective.cte_cache_dir.empty()) effective.cte_cache_dir = options.incremental_dir;
+    return effective;
+}
+
+std::string absolute_path(const std::string& path) {
+    std::error_code ec;
+    const std::filesystem::path abs = std::filesystem::weakly_canonical(std::filesystem::absolute(path, ec), ec);
+    return ec ? path : abs.string();
+}
+
+// The running binary's size and mtime stand in for the compiler build, whose
+// bundled std modules are not recorded as inputs.
+void add_compiler_build(ContentHasher& hasher) {
+    std::error_code ec;
+    const std::filesystem::path self("/proc/self/exe");
+    const uintmax_t size = std::filesystem::file_size(self, ec);
+    if (!ec) {
+        hasher.add_u64(size);
+        const auto mtime = std::filesystem::last_write_time(self, ec);
+        if (!ec) hasher.add_u64(static_cast<uint64_t>(mtime.time_since_epoch().count()));
+    }
+}
+
+// Everything besides file contents that changes what a build writes.
+std::string incremental_build_key(const Compiler::Options& options) {
+    ContentHasher hasher;
+    add_compiler_build(hasher);
+    hasher.add_string(absolute_path(options.input_file));
+    hasher.add_string(absolute_path(options.project_root));
+    hasher.add_string(absolute_path(options.output_file));
+    hasher.add_string(options.backend);
+    hasher.add_u64(static_cast<uint64_t>(options.type_strictness));
+    hasher.add_tag(options.check_all ? 'a' : '-');
+    hasher.add_u64(options.cte_step_budget);
+    hasher.add_u64(options.cte_memory_limit);
+    hasher.add_tag(options.emit_analysis ? (options.analysis_jsonl ? 'j' : 't') : '-');
+    const std::map<std::string, std::string> backend_options(options.backend_options.begin(),
+                                                             options.backend_options.end());
+    hasher.add_u64(backend_options.size());
+    for (const auto& entry : backend_options) {
+        hasher.add_string(entry.first);
+        hasher.add_string(entry.second);
+    }
+    return hasher.hex();
+}
+
+// Everything besides file contents the frontend's result depends on. Backend
+// name and options are left out: they reach the frontend only through the
+// analysis requirements and boundary reentrancy modes, and loading checks
+// the latter per function.
+std::string analyzed_cache_entry_path(const Compiler::Options& options, const BackendAnalysisRequirements& reqs) {
+    ContentHasher hasher;
+    add_compiler_build(hasher);
+    hasher.add_string(absolute_path(options.input_file));
+    hasher.add_string(absolute_path(options.project_root));
+    hasher.add_u64(static_cast<uint64_t>(options.type_strictness));
+    hasher.add_tag(options.check_all ? 'a' : '-');
+    hasher.add_u64(options.cte_step_budget);
+    hasher.add_u64(options.cte_memory_limit);
+    hasher.add_u64(reqs.required_passes);
+    hasher.add_tag(reqs.default_entry_reentrancy);
+    hasher.add_tag(reqs.default_exit_reentrancy);
+    return (std::filesystem::path(analyzed_cache_dir(options)) / "analyzed" / (hasher.hex() + ".vxa")).string();
+}
+
+std::map<std::string, std::string> sorted_backend_options(const Compiler::Options& options) {
+    return std::map<std::string, std::string>(options.backend_options.begin(), options.backend_options.end());
+}
+
+std::optional<ReentrancyMode> boundary_mode(const Backend* backend,
+                                            const Compiler::Options& options,
+                                            const Symbol& sym,
+                                            ReentrancyBoundaryKind boundary) {
+    if (!backend->boundary_reentrancy_mode) return ReentrancyMode::Default;
+    std::string error;
+    const ReentrancyMode mode = backend->boundary_reentrancy_mode(sym, boundary, options, error);
+    if (!error.empty()) return std::nullopt;
+    return mode;
+}
+
+// Why the facts of `loaded` do not hold for `backend` under `options`; empty
+// when they do. The analysis requirements must match, and a different backend
+// or option set must give every function the boundary reentrancy modes the
+// analysis ran with.
+std::string analyzed_mismatch(const LoadedAnalyzedProgram& loaded,
+                              const Backend* backend,
+                              const Compiler::Options& options,
+                              const BackendAnalysisRequirements& reqs) {
+    const AnalyzedProgramOrigin& origin = loaded.origin;
+    if (origin.analysis_passes != reqs.required_passes ||
+        origin.default_entry_reentrancy != reqs.default_entry_reentrancy ||
+        origin.default_exit_reentrancy != reqs.default_exit_reentrancy) {
+        return "analyzed for backend '" + origin.backend + "' with different analysis requirements";
+    }
+    if (origin.backend == backend->info.name && origin.backend_options == sorted_backend_options(options)) {
+        return "";
+    }
+    const Backend* recorded = find_backend(origin.backend);
+    if (!recorded) return "analyzed for unknown backend '" + origin.backend + "'";
+    Compiler::Options recorded_options = options;
+    recorded_options.backend = origin.backend;
+    recorded_options.backend_options.clear();
+    recorded_options.backend_options.insert(origin.backend_options.begin(), origin.backend_options.end());
+    for (const auto& sym : loaded.state.symbols) {
+        if (sym->kind != Symbol::Kind::Function) continue;
+        for (ReentrancyBoundaryKind boundary : {ReentrancyBoundaryKind::EntryPoint, ReentrancyBoundaryKind::ExitPoint}) {
+            const std::optional<ReentrancyMode> current = boundary_mode(backend, options, *sym, boundary);
+            if (!current || boundary_mode(recorded, recorded_options, *sym, boundary) != current) {
+                return "function '" + sym->name + "' has other boundary reentrancy for backend '" +
+                       backend->info.name + "'";
+            }
+        }
+    }
+    return "";
+}
+
+bool inputs_current(const AnalyzedProgramOrigin& origin) {
+    for (const auto& entry : origin.files) {
+        if (file_digest(entry.first) != entry.second) return false;
+    }
+    for (const auto& entry : origin.directories) {
+        if (directory_digest(entry.first) != entry.second) return false;
+    }
+    return true;
+}
+
+// Fills `prepared.loaded` from the analyzed program at `path`. A file named
+// by --from-analyzed that cannot be used is an error and is not checked
+// against the sources; a cache entry that cannot be used is a miss.
+bool load_analyzed_program(const std::string& path,
+                           bool required,
+                           const Compiler::Options& options,
+                           PreparedCompilation& prepared) {
+    auto unusable = [&](const std::string& reason) {
+        if (required) {
+            throw CompileError("Cannot emit from analyzed program " + path + ": " + reason, SourceLocation());
+        }
+        if (options.verbose) {
+            std::cout << "Analyzed cache: miss (" << reason << ") in " << analyzed_cache_dir(options) << std::endl;
+        }
+        return false;
+    };
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return unusable("no readable file");
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::unique_ptr<LoadedAnalyzedProgram> loaded = deserialize_analyzed_program(data);
+    if (!loaded) return unusable("not written by this compiler build, or damaged");
+    if (!required && !inputs_current(loaded->origin)) return unusable("inputs changed");
+    const std::string mismatch = analyzed_mismatch(*loaded, prepared.backend, options, prepared.requirements);
+    if (!mismatch.empty()) return unusable(mismatch);
+    if (!required && options.verbose) {
+        std::cout << "Analyzed cache: hit in " << analyzed_cache_dir(options) << std::endl;
+    }
+    prepared.loaded = std::move(loaded);
+    return true;
+}
+
+// Concurrent compilers may store the same cache entry; the writer's private
+// temporary and rename keep each store whole.
+void write_analyzed_file(const std::string& target, const std::string& data) {
+    std::error_code ec;
+    const std::filesystem::path parent = std::filesystem::path(target).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    write_text_file_or_throw(target, data);
+}
+
+// Backends name every output `<stem>.<ext>` or `<stem>_<suffix>.<ext>`.
+// Files in the output directory named after the output stem: `<stem>.*` and
+// `<stem>_*`, the shapes backends and reports write.
+std::vector<std::filesystem::path> output_files(const Compiler::OutputPaths& paths) {
+    std::vector<std::filesystem::path> outputs;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(paths.dir, ec)) {
+        if (!entry.is_regular_file()) continue;
+        const std::string name = entry.path().filename().string();
+        if (name.size() <= paths.stem.size() || name.compare(0, paths.stem.size(), paths.stem) != 0) continue;
+        const char next = name[paths.stem.size()];
+        if (next != '.' && next != '_') continue;
+        outputs.push_back(entry.path());
+    }
+    std::sort(outputs.begin(), outputs.end());
+    return outputs;
+}
+
+std::vector<std::pair<std::string, std::string>> output_digests(const Compiler::OutputPaths& paths) {
+    std::vector<std::pair<std::string, std::string>> outputs;
+    for (const std::filesystem::path& file : output_files(paths)) {
+        const std::string path = absolute_path(file.string());
+        outputs.emplace_back(path, file_digest(path));
+    }
+    std::sort(outputs.begin(), outputs.end());
+    return outputs;
+}
+
+std::filesystem::path depfile_path(const Compiler::Options& options, const Compiler::OutputPaths& paths) {
+    return options.depfile.empty() ? paths.dir / (paths.stem + ".d") : std::filesystem::path(options.depfile);
+}
+
+// Writes the build's outputs and inputs as a make rule. Targets keep the
+// spelling of `-o`, which is how the invoking build names them. A directory
+// that did not exist is represented by its nearest existing ancestor, whose
+// listing changes when it appears; the compiler binary stands in for the
+// bundled std modules, as in the incremental build key.
+void write_depfile(const Compiler::Options& options,
+                   const Compiler::OutputPaths& paths,
+                   const Compiler::Inputs& inputs) {
+    const std::filesystem::path depfile = depfile_path(options, paths);
+    const std::string depfile_abs = absolute_path(depfile.string());
+    std::vector<std::string> targets;
+    for (const std::filesystem::path& file : output_files(paths)) {
+        if (absolute_path(file.string()) == depfile_abs) continue;
+        targets.push_back(paths.dir == "." ? file.filename().string() : file.string());
+    }
+
+    std::vector<std::string> prerequisites = inputs.files;
+    std::error_code ec;
+    for (const std::string& dir : inputs.directories) {
+        std::filesystem::path existing(dir);
+        while (!std::filesystem::is_directory(existing, ec) && existing.has_relative_path()) {
+            existing = existing.parent_path();
+        }
+        prerequisites.push_back(existing.string());
+    }
+    const std::filesystem::path self = std::filesystem::canonical("/proc/self/exe", ec);
+    if (!ec) prerequisites.push_back(self.string());
+    std::sort(prerequisites.begin(), prerequisites.end());
+    prerequisites.erase(std::unique(prerequisites.begin(), prerequisites.end()), prerequisites.end());
+
+    if (options.verbose) {
+        std::cout << "Writing dependency file: " << depfile << std::endl;
+    }
+    write_text_file_or_throw(depfile.string(), format_depfile(targets, prerequisites));
+}
+
+void fingerprint_modules(PreparedCompilation& prepared) {
+    for (const ModuleInfo& info : prepared.program.modules) {
+        if (info.origin != ModuleOrigin::Project) continue;
+        ModuleFingerprint fingerprint;
+        fingerprint.path = absolute_path(info.path);
+        fingerprint.content = file_digest(info.path);
+        ContentHasher hasher;
+        hasher.add_string(serialize_module_interface(info.module));
+        fingerprint.interface = hasher.hex();
+        prepared.module_fingerprints.push_back(std::move(fingerprint));
+        prepared.fingerprint_module_ids.push_back(info.id);
+    }
+}
+
+BuildFingerprint build_fingerprint(PreparedCompilation& prepared,
+                                   const Compiler::Inputs& inputs,
+                                   const Compiler::OutputPaths& paths) {
+    BuildFingerprint fingerprint;
+    fingerprint.modules = std::move(prepared.module_fingerprints);
+    std::unordered_map<ModuleId, size_t> index_of;
+    for (size_t i = 0; i < prepared.fingerprint_module_ids.size(); ++i) {
+        index_of[prepared.fingerprint_module_ids[i]] = i;
+    }
+    for (const ModuleInstance& instance : prepared.program.instances) {
+        auto from = index_of.find(instance.module_id);
+        if (from == index_of.end()) continue;
+        std::vector<size_t>& imports = fingerprint.modules[from->second].imports;
+        for (ModuleInstanceId imported : instance.imports) {
+            if (imported < 0 || static_cast<size_t>(imported) >= prepared.program.instances.size()) continue;
+            auto to = index_of.find(prepared.program.instances[static_cast<size_t>(imported)].module_id);
+            if (to != index_of.end() && to->second != from->second) imports.push_back(to->second);
+        }
+        std::sort(imports.begin(), imports.end());
+        imports.erase(std::unique(imports.begin(), imports.end()), imports.end());
+    }
+    for (const std::string& path : inputs.files) fingerprint.files.emplace_back(path, file_digest(path));
+    for (const std::string& path : inputs.directories) {
+        fingerprint.directories.emplace_back(path, directory_digest(path));
+    }
+    fingerprint.outputs = output_digests(paths);
+    return fingerprint;
+}
+
+void report_pipeline_stats(const Compiler::Options& options, const PipelineStats& stats) {
+    if (options.time_passes) {
+        std::cerr << format_pipeline_stats_text(stats);
+    }
+    if (!options.stats_json.empty()) {
+        write_text_file_or_throw(options.stats_json, format_pipeline_stats_json(stats));
+    }
+}
+
+std::unique_ptr<TraceRecorder> trace_recorder(const Compiler::Options& options) {
+    return options.trace.empty() ? nullptr : std::make_unique<TraceRecorder>();
+}
+
+void write_trace(const Compiler::Options& options, const TraceRecorder* trace) {
+    if (trace) write_text_file_or_throw(options.trace, trace->format_json());
+}
+
+Compiler::Inputs collect_inputs(const PreparedCompilation& prepared) {
+    Compiler::Inputs inputs;
+    if (prepared.loaded) {
+        for (const auto& entry : prepared.loaded->origin.files) inputs.files.push_back(entry.first);
+        for (const auto& entry : prepared.loaded->origin.directories) inputs.directories.push_back(entry.first);
+        return inputs;
+    }
+    std::error_code ec;
+    for (const ModuleInfo& info : prepared.program.modules) {
+        if (info.origin != ModuleOrigin::Project) continue;
+        const std::filesystem::path path = std::filesystem::weakly_canonical(info.path, ec);
+        inputs.files.push_back(ec ? info.path : path.string());
+    }
+    std::vector<std::string> resources = prepared.checker->resource_store().files();
+    inputs.files.insert(inputs.files.end(), resources.begin(), resources.end());
+    std::sort(inputs.files.begin(), inputs.files.end());
+    inputs.files.erase(std::unique(inputs.files.begin(), inputs.files.end()), inputs.files.end());
+    inputs.directories = prepared.checker->resource_store().directories();
+    return inputs;
+}
+
+void write_analysis_reports(const Compiler::Options& options,
+                            const Compiler::OutputPaths& paths,
+                            const Module& merged,
+                            const AnalysisFacts& analysis,
+                            const OptimizationFacts& optimization) {
+    const char* extension = options.analysis_jsonl ? ".analysis.jsonl" : ".analysis.txt";
+    std::filesystem::path analysis_path = paths.dir / (paths.stem + extension);
+    if (options.verbose) {
+        std::cout << "Writing analysis report: " << analysis_path << std::endl;
+    }
+    write_file_stream_or_throw(analysis_path.string(), [&](std::ostream& out) {
+        if (options.analysis_jsonl) {
+            write_analysis_report_jsonl(out, merged, analysis, &optimization);
+        } else {
+            write_analysis_report(out, merged, analysis, &optimization);
+        }
+    });
+}
+
+AnalyzedProgramOrigin analyzed_origin(const PreparedCompilation& prepared,
+                                      const Compiler::Options& options,
+                                      const Compiler::Inputs& inputs) {
+    AnalyzedProgramOrigin origin;
+    origin.input_file = options.input_file;
+    origin.backend = prepared.backend->info.name;
+    origin.backend_options = sorted_backend_options(options);
+    origin.analysis_passes = prepared.requirements.required_passes;
+    origin.default_entry_reentrancy = prepared.requirements.default_entry_reentrancy;
+    origin.default_exit_reentrancy = prepared.requirements.default_exit_reentrancy;
+    for (const std::string& path : inputs.files) origin.files.emplace_back(path, file_digest(path));
+    for (const std::string& path : inputs.directories) {
+        origin.directories.emplace_back(path, directory_digest(path));
+    }
+    return origin;
+}
+
+// The program backends emit from: the loaded one, or the frontend's result,
+// which is also written where --emit-analyzed and the analyzed cache ask.
+AnalyzedProgram analyzed_program(PreparedCompilation& prepared,
+                                 const Compiler::Options& options,
+                                 const Compiler::Inputs& inputs) {
+    if (prepared.loaded) {
+        if (!options.emit_analyzed.empty()) {
+            write_analyzed_file(options.emit_analyzed,
+                                serialize_analyzed_program(prepared.loaded->program, prepared.loaded->origin));
+        }
+        return prepared.loaded->program;
+    }
+    AnalyzedProgram analyzed =
+        make_analyzed_program(prepared.pipeline.merged,
+                              *prepared.checker,
+                              prepared.pipeline.analysis,
+                              prepared.pipeline.optimization);
+    if (!options.emit_analyzed.empty() || !prepared.analyzed_cache_entry.empty()) {
+        const std::string data = serialize_analyzed_program(analyzed, analyzed_origin(prepared, options, inputs));
+        if (!options.emit_analyzed.empty()) write_analyzed_file(options.emit_analyzed, data);
+        if (!prepared.analyzed_cache_entry.empty()) write_analyzed_file(prepared.analyzed_cache_entry, data);
+    }
+    return analyzed;
+}
+
+// `validated`: the backend already accepted `options` (CompilerSession).
+PreparedCompilation prepare_compilation(const Compiler::Options& options,
+                                        const Backend* backend_override = nullptr,
+                                        bool validated = false) {
     PreparedCompilation prepared;
     prepared.backend = backend_override ? backend_override : find_backend(options.backend);
     if (!prepared.backend) {
         throw CompileError("Unknown backend: " + options.backend, SourceLocation());
     }
 
-    BackendAnalysisRequirements backend_reqs{};
+    BackendAnalysisRequirements& backend_reqs = prepared.requirements;
     if (prepared.backend->analysis_requirements) {
         std::string req_error;
         backend_reqs = prepared.backend->analysis_requirements(options, req_error);
@@ -94,7 +554,7 @@ PreparedCompilation prepare_compilation(const Compiler::Options& options, const
                                "' returned invalid default reentrancy (expected 'R' or 'N')",
                            SourceLocation());
     }
-    if (prepared.backend->validate_options) {
+    if (!validated && prepared.backend->validate_options) {
         std::string opt_error;
         prepared.backend->validate_options(options, opt_error);
         if (!opt_error.empty()) {
@@ -102,11 +562,58 @@ PreparedCompilation prepare_compilation(const Compiler::Options& options, const
         }
     }
 
-    AnalysisConfig analysis_config = build_analysis_config(prepared.backend, options, backend_reqs);
+    PipelineStats* stats = stats_requested(options) ? &prepared.stats : nullptr;
+    prepared.paths = resolve_output_paths_impl(options.output_file);
+    std::string analyzed_path = options.from_analyzed;
+    if (analyzed_cache_enabled(options)) {
+        prepared.analyzed_cache_entry = analyzed_cache_entry_path(options, backend_reqs);
+        analyzed_path = prepared.analyzed_cache_entry;
+    }
+    if (!analyzed_path.empty()) {
+        PipelineStageTimer load_analyzed_timer(stats, "load-analyzed");
+        if (load_analyzed_program(analyzed_path, !options.from_analyzed.empty(), options, prepared)) {
+            load_analyzed_timer.finish([&]() { return count_ast_nodes(prepared.loaded->merged); });
+            if (options.emit_analysis) {
+                write_analysis_reports(options, prepared.paths, prepared.loaded->merged, prepared.loaded->analysis,
+                                       prepared.loaded->optimization);
+            }
+            return prepared;
+        }
+    }
 
-    ModuleLoader loader(options.project_root);
+    AnalysisConfig analysis_config = build_analysis_config(prepared.backend, options, backend_reqs);
+    PipelineStageTimer load_timer(stats, "load");
+    ModuleLoader loader(options.project_root, options.jobs);
+    prepared.directory_cache = std::make_unique<DirectoryCache>();
+    loader.set_directory_cache(prepared.directory_cache.get());
+    std::unique_ptr<ParsedModuleCache> parse_cache;
+    if (options.parse_cache) {
+        parse_cache = std::make_unique<ParsedModuleCache>(parse_cache_dir(options));
+        loader.set_parse_cache(parse_cache.get());
+    }
+    loader.set_resident_cache(options.resident_modules);
+    const ResidentModuleCache* resident = options.resident_modules;
+    const size_t resident_hits = resident ? resident->hits() : 0;
+    const size_t resident_misses = resident ? resident->misses() : 0;
     prepared.program = loader.load(options.input_file);
+    load_timer.finish([&]() { return count_ast_nodes(prepared.program); });
+    if (options.incremental) {
+        fingerprint_modules(prepared);
+    }
+    if (parse_cache && options.verbose) {
+        std::cout << "Parse cache: " << parse_cache->hits() << " hit(s), " << parse_cache->misses()
+                  << " miss(es) in " << parse_cache->dir() << std::endl;
+    }
+    if (options.verbose) {
+        std::cout << "Directory cache: " << prepared.directory_cache->listings() << " listing(s) for "
+                  << prepared.directory_cache->lookups() << " lookup(s)" << std::endl;
+    }
+    if (resident && options.verbose) {
+        std::cout << "Resident modules: " << resident->hits() - resident_hits << " hit(s), "
+                  << resident->misses() - resident_misses << " miss(es)" << std::endl;
+    }
     prepared.resolver = std::make_unique<Resolver>(prepared.program, prepared.bindings, options.project_root);
+    prepared.resolver->set_directory_cache(prepared.directory_cache.get());
     prepared.checker =
         std::make_unique<TypeChecker>(options.project_root,
                                       options.allow_process,
@@ -114,22 +621,57 @@ PreparedCompilation prepare_compilation(const Compiler::Options& options, const
                                       &prepared.bindings,
                                       &prepared.program,
                                       options.type_strictness);
+    prepared.checker->set_check_all(options.check_all);
+    prepared.checker->set_directory_cache(prepared.directory_cache.get());
+    if (options.parallel_typecheck) {
+        prepared.checker->set_parallel_workers(resolve_worker_count(options.jobs));
+    }
+    if (options.process_cache) {
+        prepared.process_cache =
+            std::make_unique<ProcessOutputCache>(process_cache_dir(options), options.process_inputs);
+        prepared.checker->set_process_cache(prepared.process_cache.get());
+    }
+    if (options.cte_cache) {
+        prepared.cte_cache = std::make_unique<CTEPersistentCache>(cte_cache_path(options, prepared.paths));
+        prepared.cte_cache->load();
+        prepared.checker->set_persistent_cte_cache(prepared.cte_cache.get());
+    }
+    prepared.checker->set_cte_step_budget(options.cte_step_budget);
+    prepared.checker->set_cte_memory_limit(options.cte_memory_limit);
+    if (options.cte_profile) {
+        prepared.cte_profile = std::make_unique<CTEProfile>();
+        prepared.checker->set_cte_profile(prepared.cte_profile.get());
+    }
     prepared.pipeline =
         run_frontend_pipeline(prepared.program,
                               *prepared.resolver,
                               *prepared.checker,
                               options.verbose,
-                              analysis_config);
-    prepared.paths = resolve_output_paths_impl(options.output_file);
-    if (options.emit_analysis) {
-        std::filesystem::path analysis_path = prepared.paths.dir / (prepared.paths.stem + ".analysis.txt");
+                              analysis_config,
+                              stats,
+                              options.parallel_optimize ? resolve_worker_count(options.jobs) : 1,
+                              options.invariants);
+    prepared.stats.cte_peak_bytes = prepared.checker->get_cte_peak_bytes();
+    if (prepared.cte_cache) {
+        prepared.checker->set_persistent_cte_cache(nullptr);
         if (options.verbose) {
-            std::cout << "Writing analysis report: " << analysis_path << std::endl;
+            std::cout << "CTE cache: " << prepared.cte_cache->hits() << " hit(s), "
+                      << prepared.cte_cache->size() << " entr(ies) in " << prepared.cte_cache->path()
+                      << std::endl;
         }
-        write_text_file_or_throw(analysis_path.string(),
-                                 format_analysis_report(prepared.pipeline.merged,
-                                                        prepared.pipeline.analysis,
-                                                        &prepared.pipeline.optimization));
+        prepared.cte_cache->save();
+    }
+    if (prepared.cte_profile) {
+        prepared.checker->set_cte_profile(nullptr);
+        std::cerr << prepared.cte_profile->format_report();
+    }
+    if (prepared.process_cache && options.verbose) {
+        std::cout << "Process cache: " << prepared.process_cache->hits() << " hit(s), "
+                  << prepared.process_cache->runs() << " run(s) in " << prepared.process_cache->dir() << std::endl;
+    }
+    if (options.emit_analysis) {
+        write_analysis_reports(options, prepared.paths, prepared.pipeline.merged, prepared.pipeline.analysis,
+                               prepared.pipeline.optimization);
     }
 
     return prepared;
@@ -139,6 +681,8 @@ PreparedCompilation prepare_compilation(const Compiler::Options& options, const
 
 Compiler::Compiler(const Options& opts) : options(opts) {}
 
+Compiler::Compiler(const Options& opts, const Backend* backend) : options(opts), backend_(backend) {}
+
 Compiler::OutputPaths Compiler::resolve_output_paths(const std::string& output_file) {
     return resolve_output_paths_impl(output_file);
 }
@@ -148,19 +692,68 @@ Compiler::OutputPaths Compiler::compile() {
         std::cout << "Compiling: " << options.input_file << std::endl;
     }
 
-    PreparedCompilation prepared = prepare_compilation(options);
+    inputs_ = Inputs();
+    const std::unique_ptr<TraceRecorder> trace = trace_recorder(options);
+    TraceSession trace_session(trace.get());
+    std::unique_ptr<FingerprintDatabase> fingerprints;
+    std::string build_key;
+    BuildFingerprint previous;
+    bool have_previous = false;
+    if (options.incremental) {
+        fingerprints = std::make_unique<FingerprintDatabase>(incremental_dir(options));
+        build_key = incremental_build_key(options);
+        have_previous = fingerprints->load(build_key, previous);
+        // Process expressions read host state the record cannot see, and
+        // requested stats and traces describe a build that has to run.
+        if (have_previous && !options.allow_process && !stats_requested(options) && !trace &&
+            build_is_current(previous)) {
+            for (const auto& entry : previous.files) inputs_.files.push_back(entry.first);
+            for (const auto& entry : previous.directories) inputs_.directories.push_back(entry.first);
+            if (options.verbose) {
+                std::cout << "Up to date: " << options.input_file << std::endl;
+            }
+            const OutputPaths paths = resolve_output_paths_impl(options.output_file);
+            if (options.emit_depfile) write_depfile(options, paths, inputs_);
+            return paths;
+        }
+    }
+
+    PreparedCompilation prepared =
+        prepare_compilation(with_incremental_caches(options), backend_, backend_ != nullptr);
+    inputs_ = collect_inputs(prepared);
+    // Backends name their output after the input; --from-analyzed has none.
+    if (prepared.loaded && options.input_file.empty()) {
+        options.input_file = prepared.loaded->origin.input_file;
+    }
 
     if (options.verbose) {
         std::cout << "Generating backend: " << prepared.backend->info.name << std::endl;
     }
-    AnalyzedProgram analyzed =
-        make_analyzed_program(prepared.pipeline.merged,
-                              *prepared.checker,
-                              prepared.pipeline.analysis,
-                              prepared.pipeline.optimization);
+    AnalyzedProgram analyzed = analyzed_program(prepared, options, inputs_);
     BackendInput input{analyzed, options, prepared.paths};
+    PipelineStageTimer emit_timer(stats_requested(options) ? &prepared.stats : nullptr, "backend-emit");
     prepared.backend->emit(input);
+    emit_timer.finish([&]() { return count_ast_nodes(*analyzed.module); });
+    report_pipeline_stats(options, prepared.stats);
+    // Before the fingerprint, which records every file named after the stem.
+    if (options.emit_depfile) write_depfile(options, prepared.paths, inputs_);
 
+    if (fingerprints) {
+        BuildFingerprint current = build_fingerprint(prepared, inputs_, prepared.paths);
+        if (options.verbose) {
+            if (have_previous) {
+                const FingerprintDiff diff = compare_fingerprints(previous, current);
+                std::cout << "Incremental: " << diff.changed << " of " << current.modules.size()
+                          << " module(s) changed (" << diff.interface_changed << " interface), "
+                          << diff.affected_dependents << " dependent(s) affected" << std::endl;
+            } else {
+                std::cout << "Incremental: no previous build recorded in " << fingerprints->dir() << std::endl;
+            }
+        }
+        fingerprints->store(build_key, current);
+    }
+
+    write_trace(options, trace.get());
     if (options.verbose) {
         std::cout << "Compilation successful!" << std::endl;
     }
@@ -171,9 +764,12 @@ Compiler::OutputPaths Compiler::compile() {
 bool Compiler::emit_translation_unit(std::string& out_translation_unit, std::string& error) {
     out_translation_unit.clear();
     error.clear();
+    inputs_ = Inputs();
 
     try {
-        const Backend* backend = find_backend(options.backend);
+        const std::unique_ptr<TraceRecorder> trace = trace_recorder(options);
+        TraceSession trace_session(trace.get());
+        const Backend* backend = backend_ ? backend_ : find_backend(options.backend);
         if (!backend) {
             error = "Unknown backend: " + options.backend;
             return false;
@@ -182,21 +778,26 @@ bool Compiler::emit_translation_unit(std::string& out_translation_unit, std::str
             error = "Backend '" + backend->info.name + "' does not support translation-unit emission";
             return false;
         }
-        PreparedCompilation prepared = prepare_compilation(options, backend);
+        PreparedCompilation prepared =
+            prepare_compilation(with_incremental_caches(options), backend, backend_ != nullptr);
+        inputs_ = collect_inputs(prepared);
+        if (prepared.loaded && options.input_file.empty()) {
+            options.input_file = prepared.loaded->origin.input_file;
+        }
 
-        AnalyzedProgram analyzed =
-            make_analyzed_program(prepared.pipeline.merged,
-                                  *prepared.checker,
-                                  prepared.pipeline.analysis,
-                                  prepared.pipeline.optimization);
+        AnalyzedProgram analyzed = analyzed_program(prepared, options, inputs_);
         BackendInput input{analyzed, options, prepared.paths};
         std::string backend_error;
+        PipelineStageTimer emit_timer(stats_requested(options) ? &prepared.stats : nullptr, "backend-emit");
         if (!backend->emit_translation_unit(input, out_translation_unit, backend_error)) {
             error = backend_error.empty()
                         ? "Backend '" + backend->info.name + "' failed to emit translation unit"
                         : backend_error;
             return false;
         }
+        emit_timer.finish([&]() { return count_ast_nodes(*analyzed.module); });
+        report_pipeline_stats(options, prepared.stats);
+        write_trace(options, trace.get());
 
         return true;
     } catch (const CompileError& e) {
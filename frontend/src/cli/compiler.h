@@ -1,10 +1,16 @@
 #pragma once
+#include "invariant_config.h"
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace vexel {
 
+class ResidentModuleCache;
+struct Backend;
+
 // Compiler orchestrates the complete compilation pipeline:
 // 1. Lexing and parsing
 // 2. Type checking and semantic analysis
@@ -20,13 +26,42 @@ public:
         bool verbose;                 // Enable verbose output
         std::string project_root;     // Root directory for module resolution
         bool emit_analysis;           // Emit analysis report alongside backend output
+        bool analysis_jsonl = false;  // Emit the analysis report as JSON lines instead of text
         bool allow_process = false;   // Process expressions execute host commands; keep disabled by default
         int type_strictness = 0;      // 0=relaxed, 1=annotated locals, 2=full strict typing
+        bool check_all = false;       // Type-check unreachable function bodies too (default: only when reached)
+        bool time_passes = false;     // Print per-stage timing/memory table to stderr
+        std::string stats_json;       // Write per-stage timing/memory stats as JSON to this path
+        std::string trace;            // Write a Chrome trace-event timeline of the build to this path
+        bool emit_depfile = false;    // Write a make/ninja dependency file listing the build's inputs
+        std::string depfile;          // Dependency file path (empty = <output dir>/<stem>.d)
+        bool cte_cache = false;       // Reuse pure compile-time call results across builds
+        std::string cte_cache_dir;    // Cache directory (empty = <output dir>/.vexel-cache)
+        bool parse_cache = false;     // Reuse parsed modules of unchanged source files across builds
+        std::string parse_cache_dir;  // Cache directory (empty = <output dir>/.vexel-cache)
+        bool incremental = false;     // Skip up-to-date builds via a fingerprint database; implies parse/CTE caches
+        std::string incremental_dir;  // Database and cache directory (empty = <output dir>/.vexel-cache)
+        std::string emit_analyzed;    // Also write the analyzed program (the frontend's result) to this path
+        std::string from_analyzed;    // Emit from this analyzed program instead of running the frontend
+        bool analyzed_cache = false;  // Reuse the frontend's result across builds that change only backend options
+        std::string analyzed_cache_dir; // Cache directory (empty = <output dir>/.vexel-cache)
+        const ResidentModuleCache* resident_modules = nullptr; // Parsed modules kept across compiles (compile server)
+        bool process_cache = false;   // Run identical process commands once and reuse outputs across builds
+        std::string process_cache_dir; // Cache directory (empty = <output dir>/.vexel-cache)
+        std::vector<std::string> process_inputs; // Files whose contents key every process-cache entry
+        int jobs = 0;                 // Worker threads for parallel frontend stages (0 = hardware concurrency)
+        bool parallel_typecheck = false; // Type-check independent module instances on --jobs workers
+        bool parallel_optimize = false;  // Run compile-time fact queries on --jobs workers
+        bool parallel_codegen = false;   // Let the backend emit functions on --jobs workers
+        bool cte_profile = false;     // Print per-function/initializer compile-time evaluation profile to stderr
+        uint64_t cte_step_budget = 0; // Evaluation steps per compile-time query (0 = evaluator default)
+        uint64_t cte_memory_limit = 0; // Live value bytes per compile-time query (0 = evaluator default)
+        InvariantConfig invariants;   // Structural checks between frontend stages (--pass-invariants)
         std::string backend; // Backend name (registered via backend registry)
         std::unordered_map<std::string, std::string> backend_options; // Backend-specific key=value options
 
         Options() : verbose(false), project_root("."), emit_analysis(false),
-                    allow_process(false), type_strictness(0), backend("") {}
+                    allow_process(false), type_strictness(0), time_passes(false), backend("") {}
     };
 
     struct OutputPaths {
@@ -34,14 +69,29 @@ public:
         std::string stem;
     };
 
+    // Files a successful compilation read: project module sources and `::path`
+    // resource files, plus directories whose listing it depends on (listed
+    // resource directories and resource paths that did not exist). Bundled std
+    // modules are part of the compiler build and are not listed.
+    struct Inputs {
+        std::vector<std::string> files;
+        std::vector<std::string> directories;
+    };
+
     Compiler(const Options& opts);
+    // `backend` was already looked up and has accepted `opts` (CompilerSession),
+    // so compiling skips the registry lookup and option validation.
+    Compiler(const Options& opts, const Backend* backend);
     OutputPaths compile();
     bool emit_translation_unit(std::string& out_translation_unit, std::string& error);
+    const Inputs& inputs() const { return inputs_; }
+    // Output directory (created if missing) and file stem for an `-o` value.
+    static OutputPaths resolve_output_paths(const std::string& output_file);
 
 private:
     Options options;
-
-    OutputPaths resolve_output_paths(const std::string& output_file);
+    const Backend* backend_ = nullptr;
+    Inputs inputs_;
 };
 
 }
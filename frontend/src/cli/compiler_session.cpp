@@ -0,0 +1,109 @@
+#include "compiler_session.h"
+#include "backend_registry.h"
+#include "cli_utils.h"
+#include "common.h"
+
+#include <utility>
+
+namespace vexel {
+
+CompilerSession::CompilerSession(Compiler::Options options) : options_(std::move(options)) {
+    backend_ = find_backend(options_.backend);
+    if (!backend_) {
+        throw CompileError("Unknown backend: " + options_.backend, SourceLocation());
+    }
+    if (backend_->validate_options) {
+        std::string error;
+        backend_->validate_options(options_, error);
+        if (!error.empty()) {
+            throw CompileError(error, SourceLocation());
+        }
+    }
+    if (!options_.resident_modules) {
+        options_.resident_modules = &own_modules_;
+    }
+}
+
+bool CompilerSession::parse_arguments(const std::vector<std::string>& args,
+                                      Compiler::Options& options,
+                                      std::string& error) {
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    const int argc = static_cast<int>(args.size());
+
+    // The backend is resolved first so its own options may appear anywhere.
+    for (int i = 0; i < argc; ++i) {
+        std::string name;
+        if (!try_read_backend_arg(argc, argv.data(), i, name, error)) continue;
+        if (!error.empty()) return false;
+        if (!options.backend.empty() && options.backend != name) {
+            error = "Conflicting backend selections: '" + options.backend + "' and '" + name + "'";
+            return false;
+        }
+        options.backend = name;
+    }
+    const Backend* backend = options.backend.empty() ? nullptr : find_backend(options.backend);
+    if (!options.backend.empty() && !backend) {
+        error = "Unknown backend '" + options.backend + "'";
+        return false;
+    }
+
+    for (int i = 0; i < argc; ++i) {
+        std::string name;
+        if (try_read_backend_arg(argc, argv.data(), i, name, error) ||
+            try_parse_common_compiler_option(argc, argv.data(), i, options, error) ||
+            try_parse_backend_opt_arg(argc, argv.data(), i, options, error)) {
+            if (!error.empty()) return false;
+            continue;
+        }
+        if (argv[i][0] == '-') {
+            if (backend && backend->parse_option) {
+                int backend_index = i;
+                if (backend->parse_option(argc, argv.data(), backend_index, options, error)) {
+                    if (!error.empty()) return false;
+                    i = backend_index;
+                    continue;
+                }
+            }
+            error = "Unknown option: " + args[i];
+            return false;
+        }
+        if (!options.input_file.empty()) {
+            error = "Multiple input files specified ('" + options.input_file + "' and '" + args[i] + "')";
+            return false;
+        }
+        options.input_file = args[i];
+    }
+    return true;
+}
+
+Compiler::Options CompilerSession::options_for(const std::string& input_file,
+                                               const std::string& output_file) const {
+    Compiler::Options options = options_;
+    options.input_file = input_file;
+    if (!output_file.empty()) options.output_file = output_file;
+    return options;
+}
+
+Compiler::OutputPaths CompilerSession::compile(const std::string& input_file,
+                                               const std::string& output_file,
+                                               Compiler::Inputs* inputs) const {
+    Compiler compiler(options_for(input_file, output_file), backend_);
+    Compiler::OutputPaths paths = compiler.compile();
+    if (inputs) *inputs = compiler.inputs();
+    return paths;
+}
+
+bool CompilerSession::emit_translation_unit(const std::string& input_file,
+                                            std::string& out_translation_unit,
+                                            std::string& error,
+                                            Compiler::Inputs* inputs) const {
+    Compiler compiler(options_for(input_file, std::string()), backend_);
+    const bool ok = compiler.emit_translation_unit(out_translation_unit, error);
+    if (inputs) *inputs = compiler.inputs();
+    return ok;
+}
+
+} // namespace vexel
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "compiler.h"
+#include "module_cache.h"
+
+#include <string>
+#include <vector>
+
+namespace vexel {
+
+struct Backend;
+
+// Compiler context for embedders that compile many programs in one process
+// (batch builds, the playground, library users). The options are parsed and
+// the backend is looked up and validated once; every compile then only swaps
+// the input and output paths. Parsed modules of unchanged source files are
+// kept in a resident cache shared by all compiles of the session, so common
+// libraries and std modules are parsed once.
+//
+// compile() and emit_translation_unit() may run concurrently.
+class CompilerSession {
+public:
+    // Throws CompileError when the backend is unknown or rejects `options`.
+    // Uses `options.resident_modules` when set, the session's own cache otherwise.
+    explicit CompilerSession(Compiler::Options options);
+    CompilerSession(const CompilerSession&) = delete;
+    CompilerSession& operator=(const CompilerSession&) = delete;
+
+    // Parses driver-style arguments (without argv[0]) into `options`:
+    // `-b`/`--backend`, the common compiler options, `--backend-opt` and the
+    // selected backend's own options. A positional argument becomes
+    // `options.input_file`. Returns false with `error` set on the first bad one.
+    static bool parse_arguments(const std::vector<std::string>& args,
+                                Compiler::Options& options,
+                                std::string& error);
+
+    // Empty `output_file` keeps the session's output path. `inputs`, when
+    // given, receives the files the compile read.
+    Compiler::OutputPaths compile(const std::string& input_file,
+                                  const std::string& output_file,
+                                  Compiler::Inputs* inputs = nullptr) const;
+    bool emit_translation_unit(const std::string& input_file,
+                               std::string& out_translation_unit,
+                               std::string& error,
+                               Compiler::Inputs* inputs = nullptr) const;
+
+    const Compiler::Options& options() const { return options_; }
+    const Backend& backend() const { return *backend_; }
+    const ResidentModuleCache& modules() const { return *options_.resident_modules; }
+
+private:
+    Compiler::Options options_for(const std::string& input_file, const std::string& output_file) const;
+
+    Compiler::Options options_;
+    const Backend* backend_ = nullptr;
+    ResidentModuleCache own_modules_;
+};
+
+} // namespace vexel
@@ -0,0 +1,46 @@
+#include "depfile.h"
+
+namespace vexel {
+
+std::string escape_depfile_path(const std::string& path) {
+    std::string out;
+    out.reserve(path.size());
+    for (size_t i = 0; i < path.size(); ++i) {
+        const char c = path[i];
+        if (c == ' ') {
+            // A backslash run before a space is doubled so the space stays escaped.
+            for (size_t j = i; j > 0 && path[j - 1] == '\\'; --j) out += '\\';
+            out += "\\ ";
+        } else if (c == '#') {
+            out += "\\#";
+        } else if (c == '$') {
+            out += "$$";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string format_depfile(const std::vector<std::string>& targets,
+                           const std::vector<std::string>& prerequisites) {
+    std::string out;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (i) out += ' ';
+        out += escape_depfile_path(targets[i]);
+    }
+    out += ':';
+    for (const std::string& path : prerequisites) {
+        out += " \\\n  ";
+        out += escape_depfile_path(path);
+    }
+    out += '\n';
+    for (const std::string& path : prerequisites) {
+        out += '\n';
+        out += escape_depfile_path(path);
+        out += ":\n";
+    }
+    return out;
+}
+
+} // namespace vexel
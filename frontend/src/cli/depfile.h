@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace vexel {
+
+// Make-syntax dependency file (the `-MD` format GCC writes, which Ninja's
+// `depfile =` also reads): one rule naming `targets`, then an empty rule per
+// prerequisite so a deleted input does not stop make with "No rule to make
+// target". A prerequisite directory is a dependency on its listing, which
+// changes its mtime when entries are added or removed.
+std::string format_depfile(const std::vector<std::string>& targets,
+                           const std::vector<std::string>& prerequisites);
+
+// Escapes `path` for a make rule: spaces, `#` and `$`.
+std::string escape_depfile_path(const std::string& path);
+
+} // namespace vexel
@@ -2,6 +2,7 @@
 #include "resolver.h"
 #include "module_loader.h"
 #include "frontend_pipeline.h"
+#include "pipeline_stats.h"
 #include <iostream>
 #include <cstring>
 #include <algorithm>
@@ -33,15 +34,19 @@ static void print_usage(const char* prog) {
     std::cout << "Usage: " << prog << " [options] <input.vx>\n\n";
     std::cout << "Options:\n";
     std::cout << "  --allow-process Enable process expressions (executes host commands; disabled by default)\n";
+    std::cout << "  --check-all   Type-check every function body, including ones nothing reaches\n";
     std::cout << "  --type-strictness <0|1|2> Literal/type strictness (0 relaxed, 1 annotated-locals, 2 full)\n";
     std::cout << "  --strict-types[=full] Alias for --type-strictness=1 (or 2 with '=full')\n";
+    std::cout << "  --time-passes Print per-stage wall time, peak RSS growth and AST size to stderr\n";
     std::cout << "  -v           Verbose output\n";
     std::cout << "  -h           Show this help\n";
 }
 
 int main(int argc, char** argv) {
     bool allow_process = false;
+    bool check_all = false;
     bool verbose = false;
+    bool time_passes = false;
     int type_strictness = 0;
     std::string input_file;
 
@@ -53,6 +58,10 @@ int main(int argc, char** argv) {
             verbose = true;
         } else if (std::strcmp(argv[i], "--allow-process") == 0) {
             allow_process = true;
+        } else if (std::strcmp(argv[i], "--check-all") == 0) {
+            check_all = true;
+        } else if (std::strcmp(argv[i], "--time-passes") == 0) {
+            time_passes = true;
         } else if (std::strcmp(argv[i], "--strict-types") == 0) {
             type_strictness = std::max(type_strictness, 1);
         } else if (std::strncmp(argv[i], "--strict-types=", std::strlen("--strict-types=")) == 0) {
@@ -107,9 +116,14 @@ int main(int argc, char** argv) {
     try {
         std::string project_root = ".";
 
+        vexel::PipelineStats stats;
+        vexel::PipelineStats* stats_sink = time_passes ? &stats : nullptr;
+
         if (verbose) std::cout << "Loading modules...\n";
+        vexel::PipelineStageTimer load_timer(stats_sink, "load");
         vexel::ModuleLoader loader(project_root);
         vexel::Program program = loader.load(input_file);
+        load_timer.finish([&]() { return vexel::count_ast_nodes(program); });
 
         vexel::Bindings bindings;
         if (verbose) std::cout << "Resolving...\n";
@@ -121,12 +135,16 @@ int main(int argc, char** argv) {
                                    &bindings,
                                    &program,
                                    type_strictness);
-        (void)vexel::run_frontend_pipeline(program, resolver, checker, verbose);
+        checker.set_check_all(check_all);
+        (void)vexel::run_frontend_pipeline(program, resolver, checker, verbose, vexel::AnalysisConfig{}, stats_sink);
+        if (time_passes) {
+            std::cerr << vexel::format_pipeline_stats_text(stats);
+        }
         return 0;
     } catch (const vexel::CompileError& e) {
         std::cerr << "Error";
-        if (!e.location.filename.empty()) {
-            std::cerr << " at " << e.location.filename << ":" << e.location.line << ":" << e.location.column;
+        if (!e.location.filename().empty()) {
+            std::cerr << " at " << e.location.filename() << ":" << e.location.line << ":" << e.location.column;
         }
         std::cerr << ": " << e.what() << "\n";
         return 1;
@@ -2,17 +2,32 @@
 
 #include "analysis.h"
 #include "ast.h"
+#include "bindings.h"
+#include "constexpr_facts.h"
 #include "optimizer.h"
 #include "program.h"
+#include "symbols.h"
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <unordered_map>
 
 namespace vexel {
 
+// Checker state the backend queries while emitting, frozen at handoff.
+// Nothing writes to it (or to the tables it points at) once it is built, so
+// emitter threads may read it concurrently without locking.
+struct AnalyzedTables {
+    const Bindings* bindings = nullptr;
+    TypeVarTable type_vars;
+    std::unordered_map<int, const Scope*> instance_scopes;
+};
+
 // Strict frontend->backend handoff contract.
-// Backends receive only fully analyzed program state plus pure query hooks.
+// Backends receive only fully analyzed program state plus pure queries. The
+// member queries read the frozen tables directly; the std::function hooks
+// remain for producers that build an AnalyzedProgram without tables.
 struct AnalyzedProgram {
     const Module* module = nullptr;
     const Program* program = nullptr;
@@ -21,11 +36,38 @@ struct AnalyzedProgram {
     int entry_instance_id = 0;
 
     const std::unordered_map<std::string, std::vector<TypePtr>>* forced_tuple_types = nullptr;
+    std::shared_ptr<const AnalyzedTables> tables;
 
     std::function<Symbol*(int instance_id, const void* node)> binding_for;
     std::function<TypePtr(TypePtr)> resolve_type;
     std::function<std::optional<bool>(int instance_id, ExprPtr)> constexpr_condition;
     std::function<Symbol*(int instance_id, const std::string& type_name)> lookup_type_symbol;
+
+    Symbol* bound_symbol(int instance_id, const void* node) const {
+        if (!node) return nullptr;
+        if (tables) return tables->bindings ? tables->bindings->lookup(instance_id, node) : nullptr;
+        return binding_for ? binding_for(instance_id, node) : nullptr;
+    }
+
+    TypePtr resolved_type(TypePtr type) const {
+        if (tables) return resolve_type_vars(type, tables->type_vars);
+        return resolve_type ? resolve_type(type) : type;
+    }
+
+    std::optional<bool> known_condition(int instance_id, const ExprPtr& expr) const {
+        if (!expr) return std::nullopt;
+        if (optimization) return optimization->constexpr_condition(expr_fact_key(instance_id, expr.get()));
+        return constexpr_condition ? constexpr_condition(instance_id, expr) : std::nullopt;
+    }
+
+    Symbol* type_symbol(int instance_id, const std::string& type_name) const {
+        if (tables) {
+            auto it = tables->instance_scopes.find(instance_id);
+            return it != tables->instance_scopes.end() && it->second ? it->second->lookup_type(type_name)
+                                                                     : nullptr;
+        }
+        return lookup_type_symbol ? lookup_type_symbol(instance_id, type_name) : nullptr;
+    }
 };
 
 } // namespace vexel
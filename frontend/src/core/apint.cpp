@@ -1,39 +1,54 @@
 #include "apint.h"
 
 #include <algorithm>
-#include <iomanip>
+#include <cstring>
 #include <limits>
-#include <sstream>
 
 namespace vexel {
 
 namespace {
 
-constexpr uint32_t kLimbBits = 16;
-constexpr uint32_t kLimbBase = uint32_t(1) << kLimbBits;
-constexpr uint32_t kLimbMask = kLimbBase - 1;
+__extension__ typedef unsigned __int128 u128;
+__extension__ typedef __int128 i128;
 
-void normalize_limbs(std::vector<uint32_t>& limbs) {
+using Limbs = std::vector<uint64_t>;
+
+constexpr uint64_t kLimbBits = 64;
+constexpr uint64_t kDecimalChunk = 10000000000000000000ULL; // 10^19
+constexpr size_t kDecimalChunkDigits = 19;
+
+// Operand sizes (in limbs) at which the asymptotically faster algorithms win
+// over their schoolbook counterparts on 64-bit limbs.
+constexpr size_t kKaratsubaThreshold = 24;
+constexpr size_t kDecimalSplitThreshold = 32;
+
+void normalize_limbs(Limbs& limbs) {
     while (!limbs.empty() && limbs.back() == 0) {
         limbs.pop_back();
     }
 }
 
-uint64_t bit_length_u32(uint32_t value) {
+uint64_t bit_length_u64(uint64_t value) {
     uint64_t bits = 0;
-    while (value != 0) {
-        value >>= 1;
-        ++bits;
-    }
-    return bits;
+    if (value >> 32) { value >>= 32; bits += 32; }
+    if (value >> 16) { value >>= 16; bits += 16; }
+    if (value >> 8) { value >>= 8; bits += 8; }
+    if (value >> 4) { value >>= 4; bits += 4; }
+    if (value >> 2) { value >>= 2; bits += 2; }
+    if (value >> 1) { value >>= 1; bits += 1; }
+    return bits + value;
 }
 
-uint64_t bit_length_limbs(const std::vector<uint32_t>& limbs) {
+uint64_t bit_length_u128(uint64_t lo, uint64_t hi) {
+    return hi != 0 ? 64 + bit_length_u64(hi) : bit_length_u64(lo);
+}
+
+uint64_t bit_length_limbs(const Limbs& limbs) {
     if (limbs.empty()) return 0;
-    return uint64_t(limbs.size() - 1) * kLimbBits + bit_length_u32(limbs.back());
+    return uint64_t(limbs.size() - 1) * kLimbBits + bit_length_u64(limbs.back());
 }
 
-int compare_abs_limbs(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+int compare_abs_limbs(const Limbs& a, const Limbs& b) {
     if (a.size() != b.size()) {
         return a.size() < b.size() ? -1 : 1;
     }
@@ -45,238 +60,238 @@ int compare_abs_limbs(const std::vector<uint32_t>& a, const std::vector<uint32_t
     return 0;
 }
 
-void add_small_inplace(std::vector<uint32_t>& limbs, uint32_t value) {
-    uint64_t carry = value;
-    size_t i = 0;
-    while (carry != 0) {
+void add_small_inplace(Limbs& limbs, uint64_t value) {
+    for (size_t i = 0; value != 0; ++i) {
         if (i == limbs.size()) limbs.push_back(0);
-        uint64_t sum = uint64_t(limbs[i]) + carry;
-        limbs[i] = uint32_t(sum & kLimbMask);
-        carry = sum >> kLimbBits;
-        ++i;
+        limbs[i] += value;
+        value = limbs[i] < value ? 1 : 0;
     }
 }
 
-void mul_small_inplace(std::vector<uint32_t>& limbs, uint32_t value) {
+void sub_small_inplace(Limbs& limbs, uint64_t value) {
+    for (size_t i = 0; value != 0 && i < limbs.size(); ++i) {
+        const uint64_t before = limbs[i];
+        limbs[i] = before - value;
+        value = before < value ? 1 : 0;
+    }
+    normalize_limbs(limbs);
+}
+
+void mul_small_inplace(Limbs& limbs, uint64_t value) {
     if (limbs.empty() || value == 1) return;
     if (value == 0) {
         limbs.clear();
         return;
     }
     uint64_t carry = 0;
-    for (uint32_t& limb : limbs) {
-        uint64_t prod = uint64_t(limb) * value + carry;
-        limb = uint32_t(prod & kLimbMask);
-        carry = prod >> kLimbBits;
-    }
-    while (carry != 0) {
-        limbs.push_back(uint32_t(carry & kLimbMask));
-        carry >>= kLimbBits;
+    for (uint64_t& limb : limbs) {
+        const u128 prod = u128(limb) * value + carry;
+        limb = uint64_t(prod);
+        carry = uint64_t(prod >> 64);
     }
+    if (carry != 0) limbs.push_back(carry);
 }
 
-uint32_t div_small_inplace(std::vector<uint32_t>& limbs, uint32_t divisor) {
+uint64_t div_small_inplace(Limbs& limbs, uint64_t divisor) {
     uint64_t remainder = 0;
     for (size_t i = limbs.size(); i-- > 0;) {
-        uint64_t cur = (remainder << kLimbBits) | limbs[i];
-        limbs[i] = uint32_t(cur / divisor);
-        remainder = cur % divisor;
+        const u128 cur = (u128(remainder) << 64) | limbs[i];
+        limbs[i] = uint64_t(cur / divisor);
+        remainder = uint64_t(cur % divisor);
     }
     normalize_limbs(limbs);
-    return uint32_t(remainder);
+    return remainder;
 }
 
-std::vector<uint32_t> add_abs_limbs(const std::vector<uint32_t>& a,
-                                    const std::vector<uint32_t>& b) {
-    const size_t n = std::max(a.size(), b.size());
-    std::vector<uint32_t> out(n, 0);
+// out[offset..] += addend, growing out as needed.
+void add_shifted_inplace(Limbs& out, const Limbs& addend, size_t offset) {
+    if (addend.empty()) return;
+    if (out.size() < offset + addend.size()) out.resize(offset + addend.size(), 0);
     uint64_t carry = 0;
-    for (size_t i = 0; i < n; ++i) {
-        uint64_t sum = carry;
-        if (i < a.size()) sum += a[i];
-        if (i < b.size()) sum += b[i];
-        out[i] = uint32_t(sum & kLimbMask);
-        carry = sum >> kLimbBits;
-    }
-    if (carry != 0) out.push_back(uint32_t(carry));
-    normalize_limbs(out);
+    size_t i = 0;
+    for (; i < addend.size(); ++i) {
+        const u128 sum = u128(out[offset + i]) + addend[i] + carry;
+        out[offset + i] = uint64_t(sum);
+        carry = uint64_t(sum >> 64);
+    }
+    for (size_t pos = offset + i; carry != 0; ++pos) {
+        if (pos == out.size()) out.push_back(0);
+        out[pos] += carry;
+        carry = out[pos] < carry ? 1 : 0;
+    }
+}
+
+Limbs add_abs_limbs(const Limbs& a, const Limbs& b) {
+    Limbs out = a.size() >= b.size() ? a : b;
+    add_shifted_inplace(out, a.size() >= b.size() ? b : a, 0);
     return out;
 }
 
-void sub_abs_inplace(std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
-    int64_t borrow = 0;
+// Requires a >= b.
+void sub_abs_inplace(Limbs& a, const Limbs& b) {
+    uint64_t borrow = 0;
     for (size_t i = 0; i < a.size(); ++i) {
-        int64_t diff = int64_t(a[i]) - borrow - (i < b.size() ? int64_t(b[i]) : 0);
-        if (diff < 0) {
-            diff += int64_t(kLimbBase);
-            borrow = 1;
-        } else {
-            borrow = 0;
-        }
-        a[i] = uint32_t(diff);
+        const uint64_t rhs = i < b.size() ? b[i] : 0;
+        if (rhs == 0 && borrow == 0 && i >= b.size()) break;
+        const uint64_t diff = a[i] - rhs - borrow;
+        borrow = (a[i] < rhs || (a[i] == rhs && borrow != 0)) ? 1 : 0;
+        a[i] = diff;
     }
     normalize_limbs(a);
 }
 
-void sub_small_inplace(std::vector<uint32_t>& limbs, uint32_t value) {
-    int64_t borrow = value;
-    size_t i = 0;
-    while (borrow != 0 && i < limbs.size()) {
-        int64_t diff = int64_t(limbs[i]) - borrow;
-        if (diff < 0) {
-            limbs[i] = uint32_t(diff + int64_t(kLimbBase));
-            borrow = 1;
-        } else {
-            limbs[i] = uint32_t(diff);
-            borrow = 0;
-        }
-        ++i;
-    }
-    normalize_limbs(limbs);
-}
-
-std::vector<uint32_t> sub_abs_limbs(const std::vector<uint32_t>& a,
-                                    const std::vector<uint32_t>& b) {
-    std::vector<uint32_t> out = a;
+Limbs sub_abs_limbs(const Limbs& a, const Limbs& b) {
+    Limbs out = a;
     sub_abs_inplace(out, b);
     return out;
 }
 
-std::vector<uint32_t> mul_abs_limbs(const std::vector<uint32_t>& a,
-                                    const std::vector<uint32_t>& b) {
-    if (a.empty() || b.empty()) return {};
-    std::vector<uint32_t> out(a.size() + b.size(), 0);
+Limbs mul_schoolbook_limbs(const Limbs& a, const Limbs& b) {
+    Limbs out(a.size() + b.size(), 0);
     for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] == 0) continue;
         uint64_t carry = 0;
         for (size_t j = 0; j < b.size(); ++j) {
-            uint64_t accum = uint64_t(out[i + j]) + uint64_t(a[i]) * b[j] + carry;
-            out[i + j] = uint32_t(accum & kLimbMask);
-            carry = accum >> kLimbBits;
-        }
-        size_t pos = i + b.size();
-        while (carry != 0) {
-            if (pos == out.size()) out.push_back(0);
-            uint64_t accum = uint64_t(out[pos]) + carry;
-            out[pos] = uint32_t(accum & kLimbMask);
-            carry = accum >> kLimbBits;
-            ++pos;
+            const u128 accum = u128(a[i]) * b[j] + out[i + j] + carry;
+            out[i + j] = uint64_t(accum);
+            carry = uint64_t(accum >> 64);
         }
+        out[i + b.size()] = carry;
     }
     normalize_limbs(out);
     return out;
 }
 
-std::vector<uint32_t> shift_left_limbs(const std::vector<uint32_t>& limbs, uint64_t shift) {
+Limbs low_limbs(const Limbs& limbs, size_t count) {
+    Limbs out(limbs.begin(), limbs.begin() + std::min(count, limbs.size()));
+    normalize_limbs(out);
+    return out;
+}
+
+Limbs high_limbs(const Limbs& limbs, size_t from) {
+    if (from >= limbs.size()) return {};
+    return Limbs(limbs.begin() + from, limbs.end());
+}
+
+Limbs mul_abs_limbs(const Limbs& a, const Limbs& b) {
+    if (a.empty() || b.empty()) return {};
+    if (std::min(a.size(), b.size()) < kKaratsubaThreshold) {
+        return mul_schoolbook_limbs(a, b);
+    }
+    // Karatsuba: (a1*B + a0)(b1*B + b0) with B = 2^(64*half).
+    const size_t half = std::max(a.size(), b.size()) / 2;
+    if (a.size() <= half || b.size() <= half) {
+        return mul_schoolbook_limbs(a, b);
+    }
+    const Limbs a0 = low_limbs(a, half);
+    const Limbs a1 = high_limbs(a, half);
+    const Limbs b0 = low_limbs(b, half);
+    const Limbs b1 = high_limbs(b, half);
+    const Limbs z0 = mul_abs_limbs(a0, b0);
+    const Limbs z2 = mul_abs_limbs(a1, b1);
+    Limbs z1 = mul_abs_limbs(add_abs_limbs(a0, a1), add_abs_limbs(b0, b1));
+    sub_abs_inplace(z1, z0);
+    sub_abs_inplace(z1, z2);
+
+    Limbs out = z0;
+    out.reserve(a.size() + b.size());
+    add_shifted_inplace(out, z1, half);
+    add_shifted_inplace(out, z2, half * 2);
+    normalize_limbs(out);
+    return out;
+}
+
+Limbs shift_left_limbs(const Limbs& limbs, uint64_t shift) {
     if (limbs.empty() || shift == 0) return limbs;
     const size_t limb_shift = static_cast<size_t>(shift / kLimbBits);
-    const uint32_t bit_shift = uint32_t(shift % kLimbBits);
-    std::vector<uint32_t> out(limb_shift, 0);
+    const uint64_t bit_shift = shift % kLimbBits;
+    Limbs out(limb_shift, 0);
+    out.reserve(limb_shift + limbs.size() + 1);
+    if (bit_shift == 0) {
+        out.insert(out.end(), limbs.begin(), limbs.end());
+        return out;
+    }
     uint64_t carry = 0;
-    for (uint32_t limb : limbs) {
-        uint64_t cur = (uint64_t(limb) << bit_shift) | carry;
-        out.push_back(uint32_t(cur & kLimbMask));
-        carry = cur >> kLimbBits;
+    for (uint64_t limb : limbs) {
+        out.push_back((limb << bit_shift) | carry);
+        carry = limb >> (kLimbBits - bit_shift);
     }
-    if (carry != 0) out.push_back(uint32_t(carry));
-    normalize_limbs(out);
+    if (carry != 0) out.push_back(carry);
     return out;
 }
 
-std::vector<uint32_t> shift_right_limbs(const std::vector<uint32_t>& limbs, uint64_t shift) {
+Limbs shift_right_limbs(const Limbs& limbs, uint64_t shift) {
     if (limbs.empty() || shift == 0) return limbs;
     const size_t limb_shift = static_cast<size_t>(shift / kLimbBits);
     if (limb_shift >= limbs.size()) return {};
-    const uint32_t bit_shift = uint32_t(shift % kLimbBits);
-    std::vector<uint32_t> out(limbs.size() - limb_shift, 0);
-    if (bit_shift == 0) {
-        for (size_t i = limb_shift; i < limbs.size(); ++i) {
-            out[i - limb_shift] = limbs[i];
+    const uint64_t bit_shift = shift % kLimbBits;
+    Limbs out(limbs.size() - limb_shift, 0);
+    for (size_t i = limb_shift; i < limbs.size(); ++i) {
+        uint64_t cur = limbs[i] >> bit_shift;
+        if (bit_shift != 0 && i + 1 < limbs.size()) {
+            cur |= limbs[i + 1] << (kLimbBits - bit_shift);
         }
-        normalize_limbs(out);
-        return out;
-    }
-
-    uint32_t carry = 0;
-    const uint32_t low_mask = (uint32_t(1) << bit_shift) - 1;
-    for (size_t i = limbs.size(); i-- > limb_shift;) {
-        uint32_t cur = limbs[i];
-        out[i - limb_shift] = (cur >> bit_shift) | (carry << (kLimbBits - bit_shift));
-        carry = cur & low_mask;
+        out[i - limb_shift] = cur;
     }
     normalize_limbs(out);
     return out;
 }
 
-bool test_bit_limbs(const std::vector<uint32_t>& limbs, uint64_t bit) {
+bool test_bit_limbs(const Limbs& limbs, uint64_t bit) {
     const size_t limb_index = static_cast<size_t>(bit / kLimbBits);
     if (limb_index >= limbs.size()) return false;
-    const uint32_t bit_index = uint32_t(bit % kLimbBits);
-    return (limbs[limb_index] & (uint32_t(1) << bit_index)) != 0;
+    return ((limbs[limb_index] >> (bit % kLimbBits)) & 1u) != 0;
 }
 
-void set_bit_limbs(std::vector<uint32_t>& limbs, uint64_t bit) {
-    const size_t limb_index = static_cast<size_t>(bit / kLimbBits);
-    const uint32_t bit_index = uint32_t(bit % kLimbBits);
-    if (limb_index >= limbs.size()) limbs.resize(limb_index + 1, 0);
-    limbs[limb_index] |= uint32_t(1) << bit_index;
-}
-
-void shl1_inplace(std::vector<uint32_t>& limbs) {
-    if (limbs.empty()) return;
-    uint32_t carry = 0;
-    for (uint32_t& limb : limbs) {
-        uint32_t next_carry = (limb >> (kLimbBits - 1)) & 1u;
-        limb = ((limb << 1) & kLimbMask) | carry;
-        carry = next_carry;
-    }
-    if (carry != 0) limbs.push_back(carry);
-}
-
-bool any_low_bits(const std::vector<uint32_t>& limbs, uint64_t shift) {
+bool any_low_bits(const Limbs& limbs, uint64_t shift) {
     const size_t full_limbs = static_cast<size_t>(shift / kLimbBits);
-    const uint32_t bit_shift = uint32_t(shift % kLimbBits);
+    const uint64_t bit_shift = shift % kLimbBits;
     for (size_t i = 0; i < std::min(full_limbs, limbs.size()); ++i) {
         if (limbs[i] != 0) return true;
     }
     if (bit_shift != 0 && full_limbs < limbs.size()) {
-        const uint32_t mask = (uint32_t(1) << bit_shift) - 1;
+        const uint64_t mask = (uint64_t(1) << bit_shift) - 1;
         if ((limbs[full_limbs] & mask) != 0) return true;
     }
     return false;
 }
 
-void mask_top_bits_preserve_size(std::vector<uint32_t>& words, uint64_t bit_width) {
+size_t word_count_for_bits(uint64_t bit_width) {
+    return static_cast<size_t>((bit_width + kLimbBits - 1) / kLimbBits);
+}
+
+void mask_top_bits_preserve_size(Limbs& words, uint64_t bit_width) {
     if (bit_width == 0) {
         words.clear();
         return;
     }
-    const uint32_t extra_bits = uint32_t(bit_width % kLimbBits);
+    const uint64_t extra_bits = bit_width % kLimbBits;
     if (extra_bits != 0 && !words.empty()) {
-        const uint32_t mask = (uint32_t(1) << extra_bits) - 1;
-        words.back() &= mask;
+        words.back() &= (uint64_t(1) << extra_bits) - 1;
     }
 }
 
-void mask_top_bits(std::vector<uint32_t>& words, uint64_t bit_width) {
+void mask_top_bits(Limbs& words, uint64_t bit_width) {
     mask_top_bits_preserve_size(words, bit_width);
     normalize_limbs(words);
 }
 
-void twos_complement_negate_inplace(std::vector<uint32_t>& words, uint64_t bit_width) {
-    for (uint32_t& word : words) {
-        word = (~word) & kLimbMask;
+void twos_complement_negate_inplace(Limbs& words, uint64_t bit_width) {
+    for (uint64_t& word : words) {
+        word = ~word;
     }
     add_small_inplace(words, 1);
-    if (words.size() < static_cast<size_t>((bit_width + kLimbBits - 1) / kLimbBits)) {
-        words.resize(static_cast<size_t>((bit_width + kLimbBits - 1) / kLimbBits), 0);
+    if (words.size() < word_count_for_bits(bit_width)) {
+        words.resize(word_count_for_bits(bit_width), 0);
     }
     mask_top_bits_preserve_size(words, bit_width);
 }
 
-void divmod_abs_limbs(const std::vector<uint32_t>& dividend,
-                     const std::vector<uint32_t>& divisor,
-                     std::vector<uint32_t>& quotient,
-                     std::vector<uint32_t>& remainder) {
+// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D on 64-bit limbs.
+void divmod_abs_limbs(const Limbs& dividend,
+                      const Limbs& divisor,
+                      Limbs& quotient,
+                      Limbs& remainder) {
     if (divisor.empty()) {
         throw CompileError("Division by zero in exact integer");
     }
@@ -285,60 +300,187 @@ void divmod_abs_limbs(const std::vector<uint32_t>& dividend,
         remainder = dividend;
         return;
     }
+    if (divisor.size() == 1) {
+        quotient = dividend;
+        const uint64_t rem = div_small_inplace(quotient, divisor[0]);
+        remainder.clear();
+        if (rem != 0) remainder.push_back(rem);
+        return;
+    }
+
+    const size_t n = divisor.size();
+    const size_t m = dividend.size() - n;
+    const uint64_t shift = kLimbBits - bit_length_u64(divisor.back());
+    Limbs v = shift_left_limbs(divisor, shift);
+    Limbs u = shift_left_limbs(dividend, shift);
+    u.resize(dividend.size() + 1, 0);
+
+    quotient.assign(m + 1, 0);
+    const uint64_t v_top = v[n - 1];
+    const uint64_t v_next = v[n - 2];
+    for (size_t j = m + 1; j-- > 0;) {
+        const u128 numerator = (u128(u[j + n]) << 64) | u[j + n - 1];
+        u128 qhat = numerator / v_top;
+        u128 rhat = numerator % v_top;
+        while ((qhat >> 64) != 0 ||
+               qhat * v_next > ((rhat << 64) | u[j + n - 2])) {
+            --qhat;
+            rhat += v_top;
+            if ((rhat >> 64) != 0) break;
+        }
 
-    quotient.clear();
-    remainder.clear();
-    const uint64_t bits = bit_length_limbs(dividend);
-    for (uint64_t i = bits; i-- > 0;) {
-        shl1_inplace(remainder);
-        if (test_bit_limbs(dividend, i)) add_small_inplace(remainder, 1);
-        if (compare_abs_limbs(remainder, divisor) >= 0) {
-            sub_abs_inplace(remainder, divisor);
-            set_bit_limbs(quotient, i);
+        // Multiply and subtract qhat * v from u[j..j+n].
+        i128 borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const u128 prod = qhat * v[i];
+            const i128 diff = i128(u[i + j]) - borrow - i128(uint64_t(prod));
+            u[i + j] = uint64_t(diff);
+            borrow = i128(prod >> 64) - (diff >> 64);
+        }
+        const i128 top = i128(u[j + n]) - borrow;
+        u[j + n] = uint64_t(top);
+
+        quotient[j] = uint64_t(qhat);
+        if (top < 0) {
+            // qhat was one too large; add v back.
+            --quotient[j];
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const u128 sum = u128(u[i + j]) + v[i] + carry;
+                u[i + j] = uint64_t(sum);
+                carry = uint64_t(sum >> 64);
+            }
+            u[j + n] += carry;
         }
     }
     normalize_limbs(quotient);
-    normalize_limbs(remainder);
+    u.resize(n);
+    normalize_limbs(u);
+    remainder = shift_right_limbs(u, shift);
+}
+
+void append_decimal_chunks(Limbs value, size_t pad, std::string& out) {
+    std::vector<uint64_t> chunks;
+    while (!value.empty()) {
+        chunks.push_back(div_small_inplace(value, kDecimalChunk));
+    }
+    std::string digits;
+    digits.reserve(chunks.size() * kDecimalChunkDigits);
+    char buf[kDecimalChunkDigits + 1];
+    for (size_t i = chunks.size(); i-- > 0;) {
+        std::string chunk = std::to_string(chunks[i]);
+        if (i + 1 != chunks.size()) {
+            std::memset(buf, '0', kDecimalChunkDigits - chunk.size());
+            digits.append(buf, kDecimalChunkDigits - chunk.size());
+        }
+        digits += chunk;
+    }
+    if (digits.size() < pad) out.append(pad - digits.size(), '0');
+    out += digits;
 }
 
-std::vector<uint32_t> parse_hex_digits(const std::string& digits,
-                                       const SourceLocation& loc) {
-    std::vector<uint32_t> limbs;
-    for (char c : digits) {
-        mul_small_inplace(limbs, 16);
-        if (c >= '0' && c <= '9') {
-            add_small_inplace(limbs, uint32_t(c - '0'));
-        } else if (c >= 'a' && c <= 'f') {
-            add_small_inplace(limbs, uint32_t(10 + (c - 'a')));
-        } else if (c >= 'A' && c <= 'F') {
-            add_small_inplace(limbs, uint32_t(10 + (c - 'A')));
-        } else {
+// Divide-and-conquer conversion: value < powers[level], where powers[k] is
+// 10^(19 * 2^k). Writes value left-padded with zeros to `pad` digits.
+void append_decimal(const Limbs& value, size_t pad, const std::vector<Limbs>& powers,
+                    size_t level, std::string& out) {
+    if (level == 0 || value.size() < kDecimalSplitThreshold) {
+        append_decimal_chunks(value, pad, out);
+        return;
+    }
+    const Limbs& splitter = powers[level - 1];
+    const size_t low_digits = kDecimalChunkDigits << (level - 1);
+    if (compare_abs_limbs(value, splitter) < 0) {
+        append_decimal(value, pad, powers, level - 1, out);
+        return;
+    }
+    Limbs high;
+    Limbs low;
+    divmod_abs_limbs(value, splitter, high, low);
+    append_decimal(high, pad > low_digits ? pad - low_digits : 0, powers, level - 1, out);
+    append_decimal(low, low_digits, powers, level - 1, out);
+}
+
+unsigned digit_value(char c) {
+    if (c >= '0' && c <= '9') return unsigned(c - '0');
+    if (c >= 'a' && c <= 'f') return unsigned(10 + (c - 'a'));
+    if (c >= 'A' && c <= 'F') return unsigned(10 + (c - 'A'));
+    return 16;
+}
+
+Limbs parse_hex_digits(const std::string& digits,
+                       const SourceLocation& loc) {
+    Limbs limbs(digits.size() / 16 + 1, 0);
+    uint64_t bit = 0;
+    for (size_t i = digits.size(); i-- > 0;) {
+        const unsigned digit = digit_value(digits[i]);
+        if (digit >= 16) {
             throw CompileError("Invalid hexadecimal literal: " + digits, loc);
         }
+        limbs[bit / kLimbBits] |= uint64_t(digit) << (bit % kLimbBits);
+        bit += 4;
     }
+    normalize_limbs(limbs);
     return limbs;
 }
 
-std::vector<uint32_t> parse_decimal_digits(const std::string& digits,
-                                           const SourceLocation& loc) {
-    std::vector<uint32_t> limbs;
+Limbs parse_decimal_digits(const std::string& digits,
+                           const SourceLocation& loc) {
+    Limbs limbs;
+    uint64_t chunk = 0;
+    uint64_t chunk_scale = 1;
     for (char c : digits) {
         if (c < '0' || c > '9') {
             throw CompileError("Invalid integer literal: " + digits, loc);
         }
-        mul_small_inplace(limbs, 10);
-        add_small_inplace(limbs, uint32_t(c - '0'));
+        chunk = chunk * 10 + uint64_t(c - '0');
+        chunk_scale *= 10;
+        if (chunk_scale == kDecimalChunk) {
+            mul_small_inplace(limbs, chunk_scale);
+            add_small_inplace(limbs, chunk);
+            chunk = 0;
+            chunk_scale = 1;
+        }
+    }
+    if (chunk_scale != 1) {
+        mul_small_inplace(limbs, chunk_scale);
+        add_small_inplace(limbs, chunk);
     }
     return limbs;
 }
 
-uint64_t limbs_to_u64(const std::vector<uint32_t>& limbs) {
-    uint64_t out = 0;
-    for (size_t i = limbs.size(); i-- > 0;) {
-        out <<= kLimbBits;
-        out |= limbs[i];
+int compare_u128(uint64_t alo, uint64_t ahi, uint64_t blo, uint64_t bhi) {
+    if (ahi != bhi) return ahi < bhi ? -1 : 1;
+    if (alo != blo) return alo < blo ? -1 : 1;
+    return 0;
+}
+
+// Returns false when the sum does not fit in 128 bits.
+bool add_u128(uint64_t alo, uint64_t ahi, uint64_t blo, uint64_t bhi, uint64_t& lo, uint64_t& hi) {
+    const u128 a = (u128(ahi) << 64) | alo;
+    const u128 sum = a + ((u128(bhi) << 64) | blo);
+    lo = uint64_t(sum);
+    hi = uint64_t(sum >> 64);
+    return sum >= a;
+}
+
+// Requires a >= b.
+void sub_u128(uint64_t alo, uint64_t ahi, uint64_t blo, uint64_t bhi, uint64_t& lo, uint64_t& hi) {
+    const u128 diff = ((u128(ahi) << 64) | alo) - ((u128(bhi) << 64) | blo);
+    lo = uint64_t(diff);
+    hi = uint64_t(diff >> 64);
+}
+
+bool parse_small_literal(const std::string& digits, unsigned base, uint64_t& out) {
+    const size_t max_digits = base == 16 ? 16 : 19;
+    if (digits.empty() || digits.size() > max_digits) return false;
+    uint64_t value = 0;
+    for (char c : digits) {
+        const unsigned digit = digit_value(c);
+        if (digit >= base) return false;
+        value = value * base + digit;
     }
-    return out;
+    out = value;
+    return true;
 }
 
 } // namespace
@@ -346,38 +488,50 @@ uint64_t limbs_to_u64(const std::vector<uint32_t>& limbs) {
 APInt::APInt(int64_t value) {
     if (value < 0) {
         negative_ = true;
-        uint64_t magnitude = value == std::numeric_limits<int64_t>::min()
-                                 ? (uint64_t(1) << 63)
-                                 : uint64_t(-value);
-        while (magnitude != 0) {
-            limbs_.push_back(uint32_t(magnitude & kLimbMask));
-            magnitude >>= kLimbBits;
-        }
+        lo_ = value == std::numeric_limits<int64_t>::min()
+                  ? (uint64_t(1) << 63)
+                  : uint64_t(-value);
     } else {
-        uint64_t magnitude = uint64_t(value);
-        while (magnitude != 0) {
-            limbs_.push_back(uint32_t(magnitude & kLimbMask));
-            magnitude >>= kLimbBits;
-        }
+        lo_ = uint64_t(value);
     }
 }
 
-APInt::APInt(uint64_t value) {
-    while (value != 0) {
-        limbs_.push_back(uint32_t(value & kLimbMask));
-        value >>= kLimbBits;
-    }
-}
+APInt::APInt(uint64_t value) : lo_(value) {}
 
-APInt APInt::from_parts(bool negative, std::vector<uint32_t> limbs) {
+APInt APInt::from_inline(bool negative, uint64_t lo, uint64_t hi) {
     APInt out;
+    out.negative_ = negative && (lo != 0 || hi != 0);
+    out.lo_ = lo;
+    out.hi_ = hi;
+    return out;
+}
+
+APInt APInt::from_parts(bool negative, std::vector<uint64_t> limbs) {
     normalize_limbs(limbs);
-    out.negative_ = negative && !limbs.empty();
+    if (limbs.size() <= 2) {
+        return from_inline(negative,
+                           limbs.empty() ? 0 : limbs[0],
+                           limbs.size() < 2 ? 0 : limbs[1]);
+    }
+    APInt out;
+    out.negative_ = negative;
     out.limbs_ = std::move(limbs);
     return out;
 }
 
-APInt APInt::from_twos_complement_words(std::vector<uint32_t> words, uint64_t bit_width) {
+std::vector<uint64_t> APInt::magnitude_limbs() const {
+    if (!is_inline()) return limbs_;
+    if (hi_ != 0) return {lo_, hi_};
+    if (lo_ != 0) return {lo_};
+    return {};
+}
+
+uint64_t APInt::low_u64_wrapped() const {
+    const uint64_t low = is_inline() ? lo_ : limbs_[0];
+    return negative_ ? uint64_t(0) - low : low;
+}
+
+APInt APInt::from_twos_complement_words(std::vector<uint64_t> words, uint64_t bit_width) {
     mask_top_bits(words, bit_width);
     if (bit_width == 0 || words.empty()) return APInt(uint64_t(0));
     const bool negative = test_bit_limbs(words, bit_width - 1);
@@ -387,24 +541,30 @@ APInt APInt::from_twos_complement_words(std::vector<uint32_t> words, uint64_t bi
 }
 
 uint64_t APInt::abs_bit_length() const {
+    if (is_inline()) return bit_length_u128(lo_, hi_);
     return bit_length_limbs(limbs_);
 }
 
 uint64_t APInt::signed_bit_width() const {
-    if (limbs_.empty()) return 1;
+    if (is_zero()) return 1;
     if (!negative_) return abs_bit_length() + 1;
-    std::vector<uint32_t> minus_one = limbs_;
+    if (is_inline()) {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+        sub_u128(lo_, hi_, 1, 0, lo, hi);
+        return std::max<uint64_t>(1, bit_length_u128(lo, hi) + 1);
+    }
+    std::vector<uint64_t> minus_one = limbs_;
     sub_small_inplace(minus_one, 1);
     return std::max<uint64_t>(1, bit_length_limbs(minus_one) + 1);
 }
 
-std::vector<uint32_t> APInt::to_twos_complement_words(uint64_t bit_width) const {
+std::vector<uint64_t> APInt::to_twos_complement_words(uint64_t bit_width) const {
     if (bit_width == 0) return {};
-    const size_t word_count = static_cast<size_t>((bit_width + kLimbBits - 1) / kLimbBits);
-    std::vector<uint32_t> words(word_count, 0);
-    for (size_t i = 0; i < std::min(word_count, limbs_.size()); ++i) {
-        words[i] = limbs_[i] & kLimbMask;
-    }
+    const size_t word_count = word_count_for_bits(bit_width);
+    std::vector<uint64_t> words(word_count, 0);
+    const std::vector<uint64_t> limbs = magnitude_limbs();
+    std::copy_n(limbs.begin(), std::min(word_count, limbs.size()), words.begin());
     if (negative_) {
         twos_complement_negate_inplace(words, bit_width);
     } else {
@@ -417,32 +577,42 @@ APInt APInt::parse_integer_literal(const std::string& lexeme, const SourceLocati
     if (lexeme.empty()) {
         throw CompileError("Invalid empty integer literal", loc);
     }
+    uint64_t small = 0;
     if (lexeme.size() > 2 && lexeme[0] == '0' && (lexeme[1] == 'x' || lexeme[1] == 'X')) {
+        if (parse_small_literal(lexeme.substr(2), 16, small)) return APInt(small);
         return from_parts(false, parse_hex_digits(lexeme.substr(2), loc));
     }
+    if (parse_small_literal(lexeme, 10, small)) return APInt(small);
     return from_parts(false, parse_decimal_digits(lexeme, loc));
 }
 
 std::string APInt::to_string() const {
-    if (limbs_.empty()) return "0";
-    std::vector<uint32_t> temp = limbs_;
-    std::vector<uint32_t> chunks;
-    while (!temp.empty()) {
-        chunks.push_back(div_small_inplace(temp, 1000000000u));
+    if (fits_inline_u64()) {
+        return negative_ ? "-" + std::to_string(lo_) : std::to_string(lo_);
+    }
+    const std::vector<uint64_t> limbs = magnitude_limbs();
+    std::string out;
+    if (negative_) out.push_back('-');
+    if (limbs.size() < kDecimalSplitThreshold) {
+        append_decimal_chunks(limbs, 0, out);
+        return out;
     }
-    std::ostringstream os;
-    if (negative_) os << '-';
-    os << chunks.back();
-    for (size_t i = chunks.size() - 1; i-- > 0;) {
-        os << std::setw(9) << std::setfill('0') << chunks[i];
+    std::vector<Limbs> powers{Limbs{kDecimalChunk}};
+    while (compare_abs_limbs(powers.back(), limbs) <= 0) {
+        powers.push_back(mul_abs_limbs(powers.back(), powers.back()));
     }
-    return os.str();
+    append_decimal(limbs, 0, powers, powers.size() - 1, out);
+    return out;
 }
 
 double APInt::to_double() const {
     double out = 0.0;
-    for (size_t i = limbs_.size(); i-- > 0;) {
-        out = (out * double(kLimbBase)) + double(limbs_[i]);
+    if (is_inline()) {
+        out = double(hi_) * 18446744073709551616.0 + double(lo_);
+    } else {
+        for (size_t i = limbs_.size(); i-- > 0;) {
+            out = (out * 18446744073709551616.0) + double(limbs_[i]);
+        }
     }
     return negative_ ? -out : out;
 }
@@ -452,44 +622,51 @@ std::vector<uint8_t> APInt::to_unsigned_le_bytes(size_t byte_count) const {
         throw CompileError("Cannot extract unsigned bytes from negative exact integer");
     }
     std::vector<uint8_t> out(byte_count, 0);
-    for (size_t i = 0; i < byte_count; ++i) {
-        const size_t limb_index = i / 2;
-        const uint32_t shift = uint32_t((i % 2) * 8);
-        if (limb_index < limbs_.size()) {
-            out[i] = uint8_t((limbs_[limb_index] >> shift) & 0xFFu);
-        }
+    const std::vector<uint64_t> limbs = magnitude_limbs();
+    for (size_t i = 0; i < std::min(byte_count, limbs.size() * 8); ++i) {
+        out[i] = uint8_t((limbs[i / 8] >> ((i % 8) * 8)) & 0xFFu);
     }
     return out;
 }
 
-bool APInt::is_zero() const { return limbs_.empty(); }
+bool APInt::is_zero() const { return is_inline() && lo_ == 0 && hi_ == 0; }
 bool APInt::is_negative() const { return negative_; }
 
+size_t APInt::hash() const {
+    uint64_t h = negative_ ? 0x9e3779b97f4a7c15ULL : 0;
+    h ^= lo_ + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= hi_ + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    for (uint64_t limb : limbs_) {
+        h ^= limb + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return static_cast<size_t>(h);
+}
+
 bool APInt::fits_u64() const {
-    return !negative_ && abs_bit_length() <= 64;
+    return !negative_ && fits_inline_u64();
 }
 
 bool APInt::fits_i64() const {
-    return signed_bit_width() <= 64;
+    if (!fits_inline_u64()) return false;
+    return negative_ ? lo_ <= (uint64_t(1) << 63) : lo_ < (uint64_t(1) << 63);
 }
 
 uint64_t APInt::to_u64() const {
     if (!fits_u64()) {
         throw CompileError("Exact integer does not fit in uint64_t");
     }
-    return limbs_to_u64(limbs_);
+    return lo_;
 }
 
 int64_t APInt::to_i64() const {
     if (!fits_i64()) {
         throw CompileError("Exact integer does not fit in int64_t");
     }
-    if (!negative_) return int64_t(limbs_to_u64(limbs_));
-    const uint64_t magnitude = limbs_to_u64(limbs_);
-    if (magnitude == (uint64_t(1) << 63)) {
+    if (!negative_) return int64_t(lo_);
+    if (lo_ == (uint64_t(1) << 63)) {
         return std::numeric_limits<int64_t>::min();
     }
-    return -int64_t(magnitude);
+    return -int64_t(lo_);
 }
 
 bool APInt::fits_unsigned(uint64_t bits) const {
@@ -502,32 +679,73 @@ bool APInt::fits_signed(uint64_t bits) const {
 
 APInt APInt::wrapped_unsigned(uint64_t bits) const {
     if (bits == 0) return APInt(uint64_t(0));
+    if (bits <= 64) {
+        const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        return APInt(low_u64_wrapped() & mask);
+    }
     return from_parts(false, to_twos_complement_words(bits));
 }
 
 APInt APInt::wrapped_signed(uint64_t bits) const {
     if (bits == 0) return APInt(uint64_t(0));
+    if (bits <= 64) {
+        const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        const uint64_t raw = low_u64_wrapped() & mask;
+        if ((raw >> (bits - 1)) & 1u) {
+            return from_inline(true, (~raw + 1) & mask, 0);
+        }
+        return APInt(raw);
+    }
     return from_twos_complement_words(to_twos_complement_words(bits), bits);
 }
 
 bool operator<(const APInt& a, const APInt& b) {
     if (a.negative_ != b.negative_) return a.negative_;
-    const int cmp = compare_abs_limbs(a.limbs_, b.limbs_);
+    int cmp = 0;
+    if (a.is_inline() && b.is_inline()) {
+        cmp = compare_u128(a.lo_, a.hi_, b.lo_, b.hi_);
+    } else if (a.is_inline() != b.is_inline()) {
+        cmp = a.is_inline() ? -1 : 1;
+    } else {
+        cmp = compare_abs_limbs(a.limbs_, b.limbs_);
+    }
     return a.negative_ ? (cmp > 0) : (cmp < 0);
 }
 
 APInt APInt::operator-() const {
-    return from_parts(!negative_, limbs_);
+    APInt out = *this;
+    out.negative_ = !negative_ && !is_zero();
+    return out;
 }
 
 APInt APInt::operator+(const APInt& other) const {
+    if (is_inline() && other.is_inline()) {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+        if (negative_ == other.negative_) {
+            if (add_u128(lo_, hi_, other.lo_, other.hi_, lo, hi)) {
+                return from_inline(negative_, lo, hi);
+            }
+        } else {
+            const int cmp = compare_u128(lo_, hi_, other.lo_, other.hi_);
+            if (cmp == 0) return APInt(uint64_t(0));
+            if (cmp > 0) {
+                sub_u128(lo_, hi_, other.lo_, other.hi_, lo, hi);
+                return from_inline(negative_, lo, hi);
+            }
+            sub_u128(other.lo_, other.hi_, lo_, hi_, lo, hi);
+            return from_inline(other.negative_, lo, hi);
+        }
+    }
+    const std::vector<uint64_t> lhs = magnitude_limbs();
+    const std::vector<uint64_t> rhs = other.magnitude_limbs();
     if (negative_ == other.negative_) {
-        return from_parts(negative_, add_abs_limbs(limbs_, other.limbs_));
+        return from_parts(negative_, add_abs_limbs(lhs, rhs));
     }
-    const int cmp = compare_abs_limbs(limbs_, other.limbs_);
+    const int cmp = compare_abs_limbs(lhs, rhs);
     if (cmp == 0) return APInt(uint64_t(0));
-    if (cmp > 0) return from_parts(negative_, sub_abs_limbs(limbs_, other.limbs_));
-    return from_parts(other.negative_, sub_abs_limbs(other.limbs_, limbs_));
+    if (cmp > 0) return from_parts(negative_, sub_abs_limbs(lhs, rhs));
+    return from_parts(other.negative_, sub_abs_limbs(rhs, lhs));
 }
 
 APInt APInt::operator-(const APInt& other) const {
@@ -535,16 +753,24 @@ APInt APInt::operator-(const APInt& other) const {
 }
 
 APInt APInt::operator*(const APInt& other) const {
-    return from_parts(negative_ != other.negative_, mul_abs_limbs(limbs_, other.limbs_));
+    if (fits_inline_u64() && other.fits_inline_u64()) {
+        const u128 prod = u128(lo_) * other.lo_;
+        return from_inline(negative_ != other.negative_, uint64_t(prod), uint64_t(prod >> 64));
+    }
+    return from_parts(negative_ != other.negative_, mul_abs_limbs(magnitude_limbs(), other.magnitude_limbs()));
 }
 
 APInt APInt::operator/(const APInt& other) const {
     if (other.is_zero()) {
         throw CompileError("Division by zero in exact integer");
     }
-    std::vector<uint32_t> quotient;
-    std::vector<uint32_t> remainder;
-    divmod_abs_limbs(limbs_, other.limbs_, quotient, remainder);
+    if (is_inline() && other.is_inline()) {
+        const u128 quotient = ((u128(hi_) << 64) | lo_) / ((u128(other.hi_) << 64) | other.lo_);
+        return from_inline(negative_ != other.negative_, uint64_t(quotient), uint64_t(quotient >> 64));
+    }
+    std::vector<uint64_t> quotient;
+    std::vector<uint64_t> remainder;
+    divmod_abs_limbs(magnitude_limbs(), other.magnitude_limbs(), quotient, remainder);
     return from_parts(negative_ != other.negative_, std::move(quotient));
 }
 
@@ -552,32 +778,45 @@ APInt APInt::operator%(const APInt& other) const {
     if (other.is_zero()) {
         throw CompileError("Division by zero in exact integer");
     }
-    std::vector<uint32_t> quotient;
-    std::vector<uint32_t> remainder;
-    divmod_abs_limbs(limbs_, other.limbs_, quotient, remainder);
+    if (is_inline() && other.is_inline()) {
+        const u128 remainder = ((u128(hi_) << 64) | lo_) % ((u128(other.hi_) << 64) | other.lo_);
+        return from_inline(negative_, uint64_t(remainder), uint64_t(remainder >> 64));
+    }
+    std::vector<uint64_t> quotient;
+    std::vector<uint64_t> remainder;
+    divmod_abs_limbs(magnitude_limbs(), other.magnitude_limbs(), quotient, remainder);
     return from_parts(negative_, std::move(remainder));
 }
 
 APInt APInt::operator&(const APInt& other) const {
+    if (fits_i64() && other.fits_i64()) {
+        return APInt(to_i64() & other.to_i64());
+    }
     const uint64_t width = std::max(signed_bit_width(), other.signed_bit_width());
-    std::vector<uint32_t> lhs = to_twos_complement_words(width);
-    std::vector<uint32_t> rhs = other.to_twos_complement_words(width);
+    std::vector<uint64_t> lhs = to_twos_complement_words(width);
+    std::vector<uint64_t> rhs = other.to_twos_complement_words(width);
     for (size_t i = 0; i < lhs.size(); ++i) lhs[i] &= rhs[i];
     return from_twos_complement_words(std::move(lhs), width);
 }
 
 APInt APInt::operator|(const APInt& other) const {
+    if (fits_i64() && other.fits_i64()) {
+        return APInt(to_i64() | other.to_i64());
+    }
     const uint64_t width = std::max(signed_bit_width(), other.signed_bit_width());
-    std::vector<uint32_t> lhs = to_twos_complement_words(width);
-    std::vector<uint32_t> rhs = other.to_twos_complement_words(width);
+    std::vector<uint64_t> lhs = to_twos_complement_words(width);
+    std::vector<uint64_t> rhs = other.to_twos_complement_words(width);
     for (size_t i = 0; i < lhs.size(); ++i) lhs[i] |= rhs[i];
     return from_twos_complement_words(std::move(lhs), width);
 }
 
 APInt APInt::operator^(const APInt& other) const {
+    if (fits_i64() && other.fits_i64()) {
+        return APInt(to_i64() ^ other.to_i64());
+    }
     const uint64_t width = std::max(signed_bit_width(), other.signed_bit_width());
-    std::vector<uint32_t> lhs = to_twos_complement_words(width);
-    std::vector<uint32_t> rhs = other.to_twos_complement_words(width);
+    std::vector<uint64_t> lhs = to_twos_complement_words(width);
+    std::vector<uint64_t> rhs = other.to_twos_complement_words(width);
     for (size_t i = 0; i < lhs.size(); ++i) lhs[i] ^= rhs[i];
     return from_twos_complement_words(std::move(lhs), width);
 }
@@ -587,15 +826,29 @@ APInt APInt::operator~() const {
 }
 
 APInt APInt::operator<<(uint64_t shift) const {
-    return from_parts(negative_, shift_left_limbs(limbs_, shift));
+    if (shift == 0 || is_zero()) return *this;
+    if (is_inline() && abs_bit_length() + shift <= 128) {
+        const u128 shifted = ((u128(hi_) << 64) | lo_) << shift;
+        return from_inline(negative_, uint64_t(shifted), uint64_t(shifted >> 64));
+    }
+    return from_parts(negative_, shift_left_limbs(magnitude_limbs(), shift));
 }
 
 APInt APInt::operator>>(uint64_t shift) const {
-    if (shift == 0 || limbs_.empty()) return *this;
-    if (!negative_) return from_parts(false, shift_right_limbs(limbs_, shift));
-    std::vector<uint32_t> shifted = shift_right_limbs(limbs_, shift);
-    if (any_low_bits(limbs_, shift)) add_small_inplace(shifted, 1);
-    return from_parts(true, std::move(shifted));
+    if (shift == 0 || is_zero()) return *this;
+    if (is_inline()) {
+        const u128 magnitude = (u128(hi_) << 64) | lo_;
+        u128 shifted = shift >= 128 ? 0 : magnitude >> shift;
+        // Arithmetic shift rounds toward negative infinity.
+        if (negative_ && (shift >= 128 || (shifted << shift) != magnitude)) {
+            ++shifted;
+        }
+        return from_inline(negative_, uint64_t(shifted), uint64_t(shifted >> 64));
+    }
+    const std::vector<uint64_t>& limbs = limbs_;
+    std::vector<uint64_t> shifted = shift_right_limbs(limbs, shift);
+    if (negative_ && any_low_bits(limbs, shift)) add_small_inplace(shifted, 1);
+    return from_parts(negative_, std::move(shifted));
 }
 
 } // namespace vexel
@@ -22,6 +22,8 @@ public:
     std::string to_string() const;
     double to_double() const;
     std::vector<uint8_t> to_unsigned_le_bytes(size_t byte_count) const;
+    // Heap bytes held by the limbs of a value too wide for inline storage.
+    size_t heap_bytes() const { return limbs_.capacity() * sizeof(uint64_t); }
 
     bool is_zero() const;
     bool is_negative() const;
@@ -37,8 +39,11 @@ public:
     APInt wrapped_unsigned(uint64_t bits) const;
     APInt wrapped_signed(uint64_t bits) const;
 
+    // Value hash consistent with operator==.
+    size_t hash() const;
+
     friend bool operator==(const APInt& a, const APInt& b) {
-        return a.negative_ == b.negative_ && a.limbs_ == b.limbs_;
+        return a.negative_ == b.negative_ && a.lo_ == b.lo_ && a.hi_ == b.hi_ && a.limbs_ == b.limbs_;
     }
     friend bool operator!=(const APInt& a, const APInt& b) { return !(a == b); }
     friend bool operator<(const APInt& a, const APInt& b);
@@ -60,15 +65,25 @@ public:
     APInt operator>>(uint64_t shift) const;
 
 private:
-    static APInt from_parts(bool negative, std::vector<uint32_t> limbs);
-    static APInt from_twos_complement_words(std::vector<uint32_t> words, uint64_t bit_width);
+    static APInt from_parts(bool negative, std::vector<uint64_t> limbs);
+    static APInt from_inline(bool negative, uint64_t lo, uint64_t hi);
+    static APInt from_twos_complement_words(std::vector<uint64_t> words, uint64_t bit_width);
 
     uint64_t abs_bit_length() const;
     uint64_t signed_bit_width() const;
-    std::vector<uint32_t> to_twos_complement_words(uint64_t bit_width) const;
-
+    std::vector<uint64_t> to_twos_complement_words(uint64_t bit_width) const;
+    std::vector<uint64_t> magnitude_limbs() const;
+    bool is_inline() const { return limbs_.empty(); }
+    bool fits_inline_u64() const { return limbs_.empty() && hi_ == 0; }
+    uint64_t low_u64_wrapped() const;
+
+    // Magnitudes below 2^128 are stored inline in lo_/hi_ with limbs_ empty;
+    // only wider values spill to little-endian 64-bit limbs (lo_/hi_ zero).
+    // The representation is canonical, so operator== compares members.
     bool negative_ = false;
-    std::vector<uint32_t> limbs_;
+    uint64_t lo_ = 0;
+    uint64_t hi_ = 0;
+    std::vector<uint64_t> limbs_;
 };
 
 } // namespace vexel
@@ -1,14 +1,95 @@
 #include "ast.h"
 #include <sstream>
+#include <unordered_map>
 
 namespace vexel {
 
+BinaryOp binary_op_code(const std::string& spelling) {
+    static const std::unordered_map<std::string, BinaryOp> codes = {
+        {"+", BinaryOp::Add},         {"-", BinaryOp::Sub},        {"*", BinaryOp::Mul},
+        {"/", BinaryOp::Div},         {"%", BinaryOp::Mod},        {"&", BinaryOp::BitAnd},
+        {"|", BinaryOp::BitOr},       {"^", BinaryOp::BitXor},     {"<<", BinaryOp::Shl},
+        {">>", BinaryOp::Shr},        {"==", BinaryOp::Eq},        {"!=", BinaryOp::Ne},
+        {"<", BinaryOp::Lt},          {"<=", BinaryOp::Le},        {">", BinaryOp::Gt},
+        {">=", BinaryOp::Ge},         {"&&", BinaryOp::LogicalAnd}, {"||", BinaryOp::LogicalOr},
+    };
+    auto it = codes.find(spelling);
+    return it == codes.end() ? BinaryOp::Other : it->second;
+}
+
+UnaryOp unary_op_code(const std::string& spelling) {
+    if (spelling == "-") return UnaryOp::Neg;
+    if (spelling == "!") return UnaryOp::Not;
+    if (spelling == "~") return UnaryOp::BitNot;
+    return UnaryOp::Other;
+}
+
+AssignOp assign_op_code(const std::string& spelling) {
+    static const std::unordered_map<std::string, AssignOp> codes = {
+        {"=", AssignOp::Assign},      {"+=", AssignOp::Add},        {"-=", AssignOp::Sub},
+        {"*=", AssignOp::Mul},        {"/=", AssignOp::Div},        {"%=", AssignOp::Mod},
+        {"&=", AssignOp::BitAnd},     {"|=", AssignOp::BitOr},      {"^=", AssignOp::BitXor},
+        {"<<=", AssignOp::Shl},       {">>=", AssignOp::Shr},       {"&&=", AssignOp::LogicalAnd},
+        {"||=", AssignOp::LogicalOr},
+    };
+    auto it = codes.find(spelling);
+    return it == codes.end() ? AssignOp::Other : it->second;
+}
+
+BinaryOp compound_binary_op(AssignOp op) {
+    switch (op) {
+        case AssignOp::Add: return BinaryOp::Add;
+        case AssignOp::Sub: return BinaryOp::Sub;
+        case AssignOp::Mul: return BinaryOp::Mul;
+        case AssignOp::Div: return BinaryOp::Div;
+        case AssignOp::Mod: return BinaryOp::Mod;
+        case AssignOp::BitAnd: return BinaryOp::BitAnd;
+        case AssignOp::BitOr: return BinaryOp::BitOr;
+        case AssignOp::BitXor: return BinaryOp::BitXor;
+        case AssignOp::Shl: return BinaryOp::Shl;
+        case AssignOp::Shr: return BinaryOp::Shr;
+        case AssignOp::LogicalAnd: return BinaryOp::LogicalAnd;
+        case AssignOp::LogicalOr: return BinaryOp::LogicalOr;
+        case AssignOp::Assign:
+        case AssignOp::Other:
+            break;
+    }
+    return BinaryOp::Other;
+}
+
+bool is_comparison_op(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Eq:
+        case BinaryOp::Ne:
+        case BinaryOp::Lt:
+        case BinaryOp::Le:
+        case BinaryOp::Gt:
+        case BinaryOp::Ge:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Expr::set_op(const std::string& spelling) {
+    op = spelling;
+    binary_op = binary_op_code(spelling);
+    unary_op = unary_op_code(spelling);
+    assign_op = assign_op_code(spelling);
+}
+
+bool Expr::same_op(const Expr& other) const {
+    if (binary_op != other.binary_op || unary_op != other.unary_op || assign_op != other.assign_op) return false;
+    const bool coded = binary_op != BinaryOp::Other || unary_op != UnaryOp::Other || assign_op != AssignOp::Other;
+    return coded || op == other.op;
+}
+
 // Type factory methods
 TypePtr Type::make_primitive(PrimitiveType p,
                              const SourceLocation& loc,
                              uint64_t int_bits,
                              int64_t frac_bits) {
-    auto t = std::make_shared<Type>();
+    auto t = make_ast_node<Type>();
     t->kind = Kind::Primitive;
     t->primitive = p;
     t->integer_bits = int_bits;
@@ -18,7 +99,7 @@ TypePtr Type::make_primitive(PrimitiveType p,
 }
 
 TypePtr Type::make_array(TypePtr elem, ExprPtr size, const SourceLocation& loc) {
-    auto t = std::make_shared<Type>();
+    auto t = make_ast_node<Type>();
     t->kind = Kind::Array;
     t->element_type = elem;
     t->array_size = size;
@@ -27,23 +108,24 @@ TypePtr Type::make_array(TypePtr elem, ExprPtr size, const SourceLocation& loc)
 }
 
 TypePtr Type::make_named(const std::string& name, const SourceLocation& loc) {
-    auto t = std::make_shared<Type>();
+    auto t = make_ast_node<Type>();
     t->kind = Kind::Named;
     t->type_name = name;
     t->location = loc;
     return t;
 }
 
-TypePtr Type::make_typevar(const std::string& name, const SourceLocation& loc) {
-    auto t = std::make_shared<Type>();
+TypePtr Type::make_typevar(int id, const std::string& name, const SourceLocation& loc) {
+    auto t = make_ast_node<Type>();
     t->kind = Kind::TypeVar;
+    t->var_id = id;
     t->var_name = name;
     t->location = loc;
     return t;
 }
 
 TypePtr Type::make_typeof(ExprPtr expr, const SourceLocation& loc) {
-    auto t = std::make_shared<Type>();
+    auto t = make_ast_node<Type>();
     t->kind = Kind::TypeOf;
     t->typeof_expr = expr;
     t->location = loc;
@@ -72,6 +154,29 @@ std::string Type::to_string() const {
     return os.str();
 }
 
+TypePtr resolve_type_vars(TypePtr type, const TypeVarTable& type_vars) {
+    if (!type) return nullptr;
+    if (type->kind == Type::Kind::TypeVar) {
+        if (const TypePtr& bound = type_vars.binding(type->var_id)) {
+            return resolve_type_vars(bound, type_vars);
+        }
+        const TypePtr& representative = type_vars.representative(type->var_id);
+        return representative ? representative : type;
+    }
+    if (type->kind == Type::Kind::Array && type->element_type) {
+        TypePtr elem = resolve_type_vars(type->element_type, type_vars);
+        if (elem != type->element_type) {
+            TypePtr cloned = make_ast_node<Type>(*type);
+            cloned->element_type = elem;
+            return cloned;
+        }
+    }
+    if (type->kind == Type::Kind::TypeOf && type->typeof_expr && type->typeof_expr->type) {
+        return resolve_type_vars(type->typeof_expr->type, type_vars);
+    }
+    return type;
+}
+
 TypePtr lower_shape_type_to_array(TypePtr type) {
     if (!type) return nullptr;
 
@@ -88,7 +193,7 @@ TypePtr lower_shape_type_to_array(TypePtr type) {
 
 // Expr factory methods
 ExprPtr Expr::make_int(int64_t val, const SourceLocation& loc, const std::string& raw) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::IntLiteral;
     e->uint_val = (uint64_t)val;
     e->exact_int_val = APInt(val);
@@ -100,7 +205,7 @@ ExprPtr Expr::make_int(int64_t val, const SourceLocation& loc, const std::string
 }
 
 ExprPtr Expr::make_uint(uint64_t val, const SourceLocation& loc, const std::string& raw) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::IntLiteral;
     e->uint_val = val;
     e->exact_int_val = APInt(val);
@@ -115,7 +220,7 @@ ExprPtr Expr::make_int_exact(const APInt& val,
                              bool is_unsigned,
                              const SourceLocation& loc,
                              const std::string& raw) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::IntLiteral;
     e->literal_is_unsigned = is_unsigned;
     e->exact_int_val = val;
@@ -135,7 +240,7 @@ ExprPtr Expr::make_int_exact(const APInt& val,
 }
 
 ExprPtr Expr::make_float(double val, const SourceLocation& loc, const std::string& raw) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::FloatLiteral;
     e->float_val = val;
     e->location = loc;
@@ -144,7 +249,7 @@ ExprPtr Expr::make_float(double val, const SourceLocation& loc, const std::strin
 }
 
 ExprPtr Expr::make_char(uint64_t val, const SourceLocation& loc, const std::string& raw) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::CharLiteral;
     e->uint_val = val;
     e->exact_int_val = APInt(val);
@@ -155,7 +260,7 @@ ExprPtr Expr::make_char(uint64_t val, const SourceLocation& loc, const std::stri
 }
 
 ExprPtr Expr::make_string(const std::string& val, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::StringLiteral;
     e->string_val = val;
     e->location = loc;
@@ -163,7 +268,7 @@ ExprPtr Expr::make_string(const std::string& val, const SourceLocation& loc) {
 }
 
 ExprPtr Expr::make_identifier(const std::string& name, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Identifier;
     e->name = name;
     e->location = loc;
@@ -171,9 +276,9 @@ ExprPtr Expr::make_identifier(const std::string& name, const SourceLocation& loc
 }
 
 ExprPtr Expr::make_binary(const std::string& op, ExprPtr l, ExprPtr r, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Binary;
-    e->op = op;
+    e->set_op(op);
     e->left = l;
     e->right = r;
     e->location = loc;
@@ -181,16 +286,16 @@ ExprPtr Expr::make_binary(const std::string& op, ExprPtr l, ExprPtr r, const Sou
 }
 
 ExprPtr Expr::make_unary(const std::string& op, ExprPtr operand, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Unary;
-    e->op = op;
+    e->set_op(op);
     e->operand = operand;
     e->location = loc;
     return e;
 }
 
 ExprPtr Expr::make_call(ExprPtr func, std::vector<ExprPtr> args, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Call;
     e->operand = func;
     e->args = args;
@@ -205,7 +310,7 @@ ExprPtr Expr::make_constructor_call(ExprPtr func, std::vector<ExprPtr> args, con
 }
 
 ExprPtr Expr::make_index(ExprPtr arr, ExprPtr idx, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Index;
     e->operand = arr;
     e->args.push_back(idx);
@@ -214,7 +319,7 @@ ExprPtr Expr::make_index(ExprPtr arr, ExprPtr idx, const SourceLocation& loc) {
 }
 
 ExprPtr Expr::make_member(ExprPtr obj, const std::string& field, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Member;
     e->operand = obj;
     e->name = field;
@@ -223,7 +328,7 @@ ExprPtr Expr::make_member(ExprPtr obj, const std::string& field, const SourceLoc
 }
 
 ExprPtr Expr::make_array(std::vector<ExprPtr> elems, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::ArrayLiteral;
     e->elements = elems;
     e->location = loc;
@@ -231,7 +336,7 @@ ExprPtr Expr::make_array(std::vector<ExprPtr> elems, const SourceLocation& loc)
 }
 
 ExprPtr Expr::make_tuple(std::vector<ExprPtr> elems, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::TupleLiteral;
     e->elements = elems;
     e->location = loc;
@@ -239,7 +344,7 @@ ExprPtr Expr::make_tuple(std::vector<ExprPtr> elems, const SourceLocation& loc)
 }
 
 ExprPtr Expr::make_block(std::vector<StmtPtr> stmts, ExprPtr result, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Block;
     e->statements = stmts;
     e->result_expr = result;
@@ -248,7 +353,7 @@ ExprPtr Expr::make_block(std::vector<StmtPtr> stmts, ExprPtr result, const Sourc
 }
 
 ExprPtr Expr::make_conditional(ExprPtr cond, ExprPtr t, ExprPtr f, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Conditional;
     e->condition = cond;
     e->true_expr = t;
@@ -258,7 +363,7 @@ ExprPtr Expr::make_conditional(ExprPtr cond, ExprPtr t, ExprPtr f, const SourceL
 }
 
 ExprPtr Expr::make_cast(TypePtr type, ExprPtr expr, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Cast;
     e->target_type = type;
     e->operand = expr;
@@ -270,17 +375,17 @@ ExprPtr Expr::make_assignment(ExprPtr lhs,
                               ExprPtr rhs,
                               const SourceLocation& loc,
                               const std::string& op) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Assignment;
     e->left = lhs;
     e->right = rhs;
-    e->op = op;
+    e->set_op(op);
     e->location = loc;
     return e;
 }
 
 ExprPtr Expr::make_range(ExprPtr start, ExprPtr end, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Range;
     e->left = start;
     e->right = end;
@@ -289,7 +394,7 @@ ExprPtr Expr::make_range(ExprPtr start, ExprPtr end, const SourceLocation& loc)
 }
 
 ExprPtr Expr::make_length(ExprPtr expr, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Length;
     e->operand = expr;
     e->location = loc;
@@ -297,7 +402,7 @@ ExprPtr Expr::make_length(ExprPtr expr, const SourceLocation& loc) {
 }
 
 ExprPtr Expr::make_iteration(ExprPtr iterable, ExprPtr body, bool sorted, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Iteration;
     e->operand = iterable;
     e->right = body;
@@ -307,7 +412,7 @@ ExprPtr Expr::make_iteration(ExprPtr iterable, ExprPtr body, bool sorted, const
 }
 
 ExprPtr Expr::make_repeat(ExprPtr cond, ExprPtr body, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Repeat;
     e->condition = cond;
     e->right = body;
@@ -316,7 +421,7 @@ ExprPtr Expr::make_repeat(ExprPtr cond, ExprPtr body, const SourceLocation& loc)
 }
 
 ExprPtr Expr::make_resource(const std::vector<std::string>& path, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Resource;
     e->resource_path = path;
     e->location = loc;
@@ -324,7 +429,7 @@ ExprPtr Expr::make_resource(const std::vector<std::string>& path, const SourceLo
 }
 
 ExprPtr Expr::make_process(const std::string& command, const SourceLocation& loc) {
-    auto e = std::make_shared<Expr>();
+    auto e = make_ast_node<Expr>();
     e->kind = Kind::Process;
     e->process_command = command;
     e->location = loc;
@@ -333,7 +438,7 @@ ExprPtr Expr::make_process(const std::string& command, const SourceLocation& loc
 
 // Stmt factory methods
 StmtPtr Stmt::make_expr(ExprPtr e, const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::Expr;
     s->expr = e;
     s->location = loc;
@@ -341,7 +446,7 @@ StmtPtr Stmt::make_expr(ExprPtr e, const SourceLocation& loc) {
 }
 
 StmtPtr Stmt::make_return(ExprPtr e, const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::Return;
     s->return_expr = e;
     s->location = loc;
@@ -349,14 +454,14 @@ StmtPtr Stmt::make_return(ExprPtr e, const SourceLocation& loc) {
 }
 
 StmtPtr Stmt::make_break(const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::Break;
     s->location = loc;
     return s;
 }
 
 StmtPtr Stmt::make_continue(const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::Continue;
     s->location = loc;
     return s;
@@ -369,7 +474,7 @@ StmtPtr Stmt::make_var(const std::string& name,
                        const SourceLocation& loc,
                        bool exported,
                        VarLinkageKind linkage) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::VarDecl;
     s->var_name = name;
     s->var_type = type;
@@ -383,7 +488,7 @@ StmtPtr Stmt::make_var(const std::string& name,
 
 StmtPtr Stmt::make_func(const std::string& name, std::vector<Parameter> params, std::vector<std::string> ref_params,
                        TypePtr ret, ExprPtr body, bool external, bool exported, const SourceLocation& loc, const std::string& type_ns, const std::vector<TypePtr>& ret_types) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::FuncDecl;
     s->func_name = name;
     s->type_namespace = type_ns;
@@ -402,7 +507,7 @@ StmtPtr Stmt::make_func(const std::string& name, std::vector<Parameter> params,
 }
 
 StmtPtr Stmt::make_type(const std::string& name, std::vector<Field> fields, const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::TypeDecl;
     s->type_decl_name = name;
     s->fields = fields;
@@ -411,7 +516,7 @@ StmtPtr Stmt::make_type(const std::string& name, std::vector<Field> fields, cons
 }
 
 StmtPtr Stmt::make_import(std::vector<std::string> path, const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::Import;
     s->import_path = path;
     s->location = loc;
@@ -419,7 +524,7 @@ StmtPtr Stmt::make_import(std::vector<std::string> path, const SourceLocation& l
 }
 
 StmtPtr Stmt::make_conditional_stmt(ExprPtr cond, StmtPtr stmt, const SourceLocation& loc) {
-    auto s = std::make_shared<Stmt>();
+    auto s = make_ast_node<Stmt>();
     s->kind = Kind::ConditionalStmt;
     s->condition = cond;
     s->true_stmt = stmt;
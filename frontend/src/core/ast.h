@@ -1,6 +1,9 @@
 #pragma once
 #include "common.h"
 #include "apint.h"
+#include "ast_arena.h"
+#include "ast_fields.h"
+#include "type_vars.h"
 #include <variant>
 
 namespace vexel {
@@ -20,6 +23,38 @@ struct Annotation {
     SourceLocation location;
 };
 
+// Operator codes of Binary, Unary and Assignment expressions. Expr::set_op
+// assigns them from the spelling, which stays in Expr::op for printing,
+// diagnostics and operator-overload lookup. Spellings without a code, such
+// as the per-element `.`-prefixed operators, are Other.
+enum class BinaryOp : uint8_t {
+    Other,
+    Add, Sub, Mul, Div, Mod,
+    BitAnd, BitOr, BitXor, Shl, Shr,
+    Eq, Ne, Lt, Le, Gt, Ge,
+    LogicalAnd, LogicalOr,
+};
+
+enum class UnaryOp : uint8_t {
+    Other,
+    Neg, Not, BitNot,
+};
+
+enum class AssignOp : uint8_t {
+    Other,
+    Assign,
+    Add, Sub, Mul, Div, Mod,
+    BitAnd, BitOr, BitXor, Shl, Shr,
+    LogicalAnd, LogicalOr,
+};
+
+BinaryOp binary_op_code(const std::string& spelling);
+UnaryOp unary_op_code(const std::string& spelling);
+AssignOp assign_op_code(const std::string& spelling);
+// Binary operator a compound assignment applies (Other for `=`).
+BinaryOp compound_binary_op(AssignOp op);
+bool is_comparison_op(BinaryOp op);
+
 enum class VarLinkageKind {
     Normal,
     ExternalSymbol,
@@ -41,7 +76,9 @@ struct Type {
     ExprPtr array_size;
     // For Named
     std::string type_name;
-    // For TypeVar
+    // For TypeVar: the id is the variable's slot in the checker's
+    // TypeVarTable; the name is only its spelling.
+    int var_id = -1;
     std::string var_name;
     // For TypeOf
     ExprPtr typeof_expr;
@@ -52,12 +89,15 @@ struct Type {
                                   int64_t frac_bits = 0);
     static TypePtr make_array(TypePtr elem, ExprPtr size, const SourceLocation& loc = SourceLocation());
     static TypePtr make_named(const std::string& name, const SourceLocation& loc = SourceLocation());
-    static TypePtr make_typevar(const std::string& name, const SourceLocation& loc = SourceLocation());
+    static TypePtr make_typevar(int id, const std::string& name, const SourceLocation& loc = SourceLocation());
     static TypePtr make_typeof(ExprPtr expr, const SourceLocation& loc = SourceLocation());
 
     std::string to_string() const;
 };
 TypePtr lower_shape_type_to_array(TypePtr type);
+// Follows type-variable bindings, array element types and `typeof` to the
+// type they stand for. Unbound variables are returned unchanged.
+TypePtr resolve_type_vars(TypePtr type, const TypeVarTable& type_vars);
 
 struct Expr {
     enum class Kind {
@@ -66,53 +106,63 @@ struct Expr {
         ArrayLiteral, TupleLiteral, Block, Conditional, Cast, Assignment,
         Range, Length, Iteration, Repeat, Resource, Process
     };
+    // Members are laid out small-first and, apart from the operand slots most
+    // kinds use, held in the compact holders of ast_fields.h: a node only pays
+    // for the kind-specific members it sets.
     Kind kind;
     SourceLocation location;
+    int scope_instance_id = -1;  // For identifiers: which scope instance the symbol is from (-1 = not imported)
+
+    // Flags
+    bool has_exact_int_val = false;
+    bool literal_is_unsigned = false;
+    bool is_expr_param_ref = false;  // True if this is a $param reference
+    bool creates_new_variable = false;  // True if this assignment creates a new variable
+    bool is_mutable_binding = false;  // True if identifier refers to a mutable binding
+    bool is_constructor_call = false;
+    bool is_existence_probe = false;
+    bool is_optional_semantic_block = false;
+    bool is_sorted_iteration = false;
+    bool was_parenthesized = false;
+
+    // Binary/Unary/Assignment operator codes
+    BinaryOp binary_op = BinaryOp::Other;
+    UnaryOp unary_op = UnaryOp::Other;
+    AssignOp assign_op = AssignOp::Other;
+
     TypePtr type;
-    std::vector<Annotation> annotations;
+    AstList<Annotation> annotations;
 
     // Literals
     uint64_t uint_val;
-    APInt exact_int_val;
-    bool has_exact_int_val = false;
     double float_val;
-    std::string string_val;
-    std::string raw_literal;
-    bool literal_is_unsigned = false;
+    AstBox<APInt> exact_int_val;
+    AstText string_val;
+    AstText raw_literal;
 
     // Identifier
-    std::string name;
-    bool is_expr_param_ref = false;  // True if this is a $param reference
-    bool creates_new_variable = false;  // True if this assignment creates a new variable
-    TypePtr declared_var_type;  // For declaration assignments, preserve declared/inferred variable type.
-    int scope_instance_id = -1;  // For identifiers: which scope instance the symbol is from (-1 = not imported)
-    bool is_mutable_binding = false;  // True if identifier refers to a mutable binding
+    AstName name;
+    AstBox<TypePtr> declared_var_type;  // For declaration assignments, preserve declared/inferred variable type.
     Symbol* resolved_symbol = nullptr;
 
-    // Binary/Unary
-    std::string op;
+    // Binary/Unary/Assignment
+    AstName op;
     ExprPtr left, right;
     ExprPtr operand;
 
     // Call
-    std::vector<ExprPtr> args;
-    std::vector<ExprPtr> receivers;
-    bool is_constructor_call = false;
-    bool is_existence_probe = false;
+    AstList<ExprPtr> args;
+    AstList<ExprPtr> receivers;
 
     // ArrayLiteral
-    std::vector<ExprPtr> elements;
+    AstList<ExprPtr> elements;
 
     // Block
-    std::vector<StmtPtr> statements;
-    ExprPtr result_expr;
-    bool is_optional_semantic_block = false;
-
-    bool is_sorted_iteration = false;
-    bool was_parenthesized = false;
+    AstList<StmtPtr> statements;
+    AstBox<ExprPtr> result_expr;
 
     // Conditional
-    ExprPtr condition, true_expr, false_expr;
+    AstBox<ExprPtr> condition, true_expr, false_expr;
 
     // Loop invariant:
     // - Iteration stores iterable in operand and body in right.
@@ -120,11 +170,11 @@ struct Expr {
     // - left is intentionally unused for loop nodes.
 
     // Cast
-    TypePtr target_type;
+    AstBox<TypePtr> target_type;
 
     // Resource path segments (for ::foo::bar expressions)
-    std::vector<std::string> resource_path;
-    std::string process_command;
+    AstList<std::string> resource_path;
+    AstText process_command;
 
     static ExprPtr make_int(int64_t val, const SourceLocation& loc = SourceLocation(), const std::string& raw = "");
     static ExprPtr make_uint(uint64_t val, const SourceLocation& loc = SourceLocation(), const std::string& raw = "");
@@ -136,6 +186,12 @@ struct Expr {
     static ExprPtr make_char(uint64_t val, const SourceLocation& loc = SourceLocation(), const std::string& raw = "");
     static ExprPtr make_string(const std::string& val, const SourceLocation& loc = SourceLocation());
     static ExprPtr make_identifier(const std::string& name, const SourceLocation& loc = SourceLocation());
+    // Sets `op` and the operator codes derived from it.
+    void set_op(const std::string& spelling);
+    // Same operator as `other`; spellings are compared only for codes
+    // that do not determine them.
+    bool same_op(const Expr& other) const;
+
     static ExprPtr make_binary(const std::string& op, ExprPtr l, ExprPtr r, const SourceLocation& loc = SourceLocation());
     static ExprPtr make_unary(const std::string& op, ExprPtr operand, const SourceLocation& loc = SourceLocation());
     static ExprPtr make_call(ExprPtr func, std::vector<ExprPtr> args, const SourceLocation& loc = SourceLocation());
@@ -191,50 +247,51 @@ struct Stmt {
         Expr, Return, Break, Continue, VarDecl, FuncDecl,
         TypeDecl, Import, ConditionalStmt
     };
+    // Members as in Expr: kind-specific ones use the ast_fields.h holders.
     Kind kind;
     SourceLocation location;
     int scope_instance_id = -1;  // For imported declarations: which scope instance (-1 = not imported)
-    std::vector<Annotation> annotations;
+    AstList<Annotation> annotations;
     Symbol* resolved_symbol = nullptr;
-    std::vector<Symbol*> ref_param_symbols;
+    AstList<Symbol*> ref_param_symbols;
 
     // Expr
     ExprPtr expr;
 
     // Return/Break/Continue
-    ExprPtr return_expr;
+    AstBox<ExprPtr> return_expr;
 
     // VarDecl
-    std::string var_name;
-    TypePtr var_type;
-    ExprPtr var_init;
+    AstName var_name;
+    AstBox<TypePtr> var_type;
+    AstBox<ExprPtr> var_init;
     bool is_mutable;
     VarLinkageKind var_linkage = VarLinkageKind::Normal;
 
     // FuncDecl
-    std::string func_name;
-    std::string type_namespace;  // For &(r)Type::method syntax (empty if no namespace)
-    std::vector<Parameter> params;
-    std::vector<std::string> ref_params;
-    std::vector<TypePtr> ref_param_types;  // Inferred types for reference/receiver parameters
-    TypePtr return_type;
-    std::vector<TypePtr> return_types;  // For tuple returns (empty if single return)
-    ExprPtr body;
+    AstName func_name;
+    AstName type_namespace;  // For &(r)Type::method syntax (empty if no namespace)
+    AstList<Parameter> params;
+    AstList<std::string> ref_params;
+    AstList<TypePtr> ref_param_types;  // Inferred types for reference/receiver parameters
+    AstBox<TypePtr> return_type;
+    AstList<TypePtr> return_types;  // For tuple returns (empty if single return)
+    AstBox<ExprPtr> body;
     bool is_external = false;
     bool is_exported = false;
     bool is_generic = false;  // True if function has type parameters (params without types)
     bool is_instantiation = false;  // True if this is a concrete generic instantiation
 
     // TypeDecl
-    std::string type_decl_name;
-    std::vector<Field> fields;
+    AstName type_decl_name;
+    AstList<Field> fields;
 
     // Import
-    std::vector<std::string> import_path;
+    AstList<std::string> import_path;
 
     // ConditionalStmt
-    ExprPtr condition;
-    StmtPtr true_stmt;
+    AstBox<ExprPtr> condition;
+    AstBox<StmtPtr> true_stmt;
 
     static StmtPtr make_expr(ExprPtr e, const SourceLocation& loc = SourceLocation());
     static StmtPtr make_return(ExprPtr e, const SourceLocation& loc = SourceLocation());
@@ -0,0 +1,49 @@
+#include "ast_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace vexel {
+
+namespace {
+
+thread_local const std::shared_ptr<AstArena>* current_arena = nullptr;
+
+} // namespace
+
+void* AstArena::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t padding = cursor_ ? (alignment - reinterpret_cast<uintptr_t>(cursor_) % alignment) % alignment : 0;
+    if (!cursor_ || padding + size > remaining_) {
+        const size_t chunk_size = std::max(kChunkSize, size + alignment);
+        chunks_.emplace_back(new unsigned char[chunk_size]);
+        cursor_ = chunks_.back().get();
+        remaining_ = chunk_size;
+        reserved_ += chunk_size;
+        padding = (alignment - reinterpret_cast<uintptr_t>(cursor_) % alignment) % alignment;
+    }
+    void* out = cursor_ + padding;
+    cursor_ += padding + size;
+    remaining_ -= padding + size;
+    return out;
+}
+
+size_t AstArena::bytes_reserved() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reserved_;
+}
+
+AstArenaScope::AstArenaScope(std::shared_ptr<AstArena> arena)
+    : arena_(std::move(arena)), previous_(current_arena) {
+    current_arena = arena_ ? &arena_ : previous_;
+}
+
+AstArenaScope::~AstArenaScope() {
+    current_arena = previous_;
+}
+
+const std::shared_ptr<AstArena>* AstArenaScope::current() {
+    return current_arena;
+}
+
+} // namespace vexel
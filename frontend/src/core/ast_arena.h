@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace vexel {
+
+// Bump allocator backing the AST nodes of one Program. Individual frees are
+// no-ops; chunks are released when the last node allocated from the arena
+// (each one keeps the arena alive through its control block) is destroyed.
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    size_t bytes_reserved() const;
+
+private:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<unsigned char[]>> chunks_;
+    unsigned char* cursor_ = nullptr;
+    size_t remaining_ = 0;
+    size_t reserved_ = 0;
+};
+
+template <typename T>
+class AstArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit AstArenaAllocator(std::shared_ptr<AstArena> arena) : arena_(std::move(arena)) {}
+    template <typename U>
+    AstArenaAllocator(const AstArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena_->allocate(sizeof(T) * count, alignof(T)));
+    }
+    void deallocate(T*, size_t) {}
+
+    const std::shared_ptr<AstArena>& arena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const AstArenaAllocator<U>& other) const { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const AstArenaAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    std::shared_ptr<AstArena> arena_;
+};
+
+// Installs `arena` as the current thread's AST arena for the scope's lifetime.
+// AST factories allocate from the innermost active arena, falling back to the
+// global heap when none is installed.
+class AstArenaScope {
+public:
+    explicit AstArenaScope(std::shared_ptr<AstArena> arena);
+    ~AstArenaScope();
+    AstArenaScope(const AstArenaScope&) = delete;
+    AstArenaScope& operator=(const AstArenaScope&) = delete;
+
+    static const std::shared_ptr<AstArena>* current();
+
+private:
+    std::shared_ptr<AstArena> arena_;
+    const std::shared_ptr<AstArena>* previous_ = nullptr;
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> make_ast_node(Args&&... args) {
+    if (const std::shared_ptr<AstArena>* arena = AstArenaScope::current()) {
+        return std::allocate_shared<T>(AstArenaAllocator<T>(*arena), std::forward<Args>(args)...);
+    }
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+} // namespace vexel
@@ -0,0 +1,569 @@
+#include "ast_codec.h"
+#include "symbols.h"
+
+#include <cstring>
+
+namespace vexel {
+
+namespace {
+
+enum NodeTag : uint8_t {
+    kNullNode = 0,
+    kNewNode = 1,
+    kSharedNode = 2,
+};
+
+// File slot 0 is "no file", slot 1 the stream's own file; later slots index
+// the table written ahead of the body.
+constexpr uint64_t kNoFileSlot = 0;
+constexpr uint64_t kSelfFileSlot = 1;
+
+// Symbol references are Symbol::id + 1; 0 is "none".
+constexpr uint64_t kNoSymbol = 0;
+
+} // namespace
+
+AstEncoder::AstEncoder(const std::string& self_path) : AstEncoder(self_path, Config()) {}
+
+AstEncoder::AstEncoder(const std::string& self_path, Config config)
+    : self_file_(self_path.empty() ? 0 : intern_source_file(self_path)), config_(config) {}
+
+void AstEncoder::u64(uint64_t value) {
+    while (value >= 0x80) {
+        out_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out_.push_back(static_cast<char>(value));
+}
+
+void AstEncoder::i64(int64_t value) {
+    u64((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void AstEncoder::flag(bool value) { out_.push_back(value ? 1 : 0); }
+
+void AstEncoder::str(const std::string& text) {
+    u64(text.size());
+    out_ += text;
+}
+
+void AstEncoder::strings(const std::vector<std::string>& values) {
+    u64(values.size());
+    for (const std::string& value : values) {
+        str(value);
+    }
+}
+
+void AstEncoder::loc(const SourceLocation& location) {
+    if (config_.interface_only) return;
+    if (location.file_id == 0) {
+        u64(kNoFileSlot);
+    } else if (location.file_id == self_file_) {
+        u64(kSelfFileSlot);
+    } else {
+        auto inserted = file_slots_.emplace(location.file_id, files_.size() + 2);
+        if (inserted.second) files_.push_back(location.filename());
+        u64(inserted.first->second);
+    }
+    i64(location.line);
+    i64(location.column);
+}
+
+void AstEncoder::symbol(const Symbol* sym) {
+    u64(sym && sym->id >= 0 ? static_cast<uint64_t>(sym->id) + 1 : kNoSymbol);
+}
+
+void AstEncoder::annotations(const std::vector<Annotation>& values) {
+    u64(values.size());
+    for (const Annotation& ann : values) {
+        str(ann.name);
+        strings(ann.args);
+        loc(ann.location);
+    }
+}
+
+template <typename T>
+bool AstEncoder::begin_node(const T* node, std::unordered_map<const T*, uint64_t>& ids) {
+    if (!node) {
+        u64(kNullNode);
+        return false;
+    }
+    auto inserted = ids.emplace(node, ids.size());
+    if (!inserted.second) {
+        u64(kSharedNode);
+        u64(inserted.first->second);
+        return false;
+    }
+    u64(kNewNode);
+    return true;
+}
+
+void AstEncoder::type(const TypePtr& node) {
+    if (!begin_node(node.get(), type_ids_)) return;
+    u64(static_cast<uint64_t>(node->kind));
+    loc(node->location);
+    u64(static_cast<uint64_t>(node->primitive));
+    u64(node->integer_bits);
+    i64(node->fractional_bits);
+    type(node->element_type);
+    expr(node->array_size);
+    str(node->type_name);
+    i64(node->var_id);
+    str(node->var_name);
+    expr(node->typeof_expr);
+    if (config_.semantic) symbol(node->resolved_symbol);
+}
+
+void AstEncoder::types(const std::vector<TypePtr>& values) {
+    u64(values.size());
+    for (const TypePtr& value : values) {
+        type(value);
+    }
+}
+
+void AstEncoder::exprs(const std::vector<ExprPtr>& values) {
+    u64(values.size());
+    for (const ExprPtr& value : values) {
+        expr(value);
+    }
+}
+
+void AstEncoder::stmts(const std::vector<StmtPtr>& values) {
+    u64(values.size());
+    for (const StmtPtr& value : values) {
+        stmt(value);
+    }
+}
+
+void AstEncoder::expr(const ExprPtr& node) {
+    if (!begin_node(node.get(), expr_ids_)) return;
+    u64(static_cast<uint64_t>(node->kind));
+    loc(node->location);
+    type(node->type);
+    annotations(node->annotations);
+    u64(node->uint_val);
+    flag(node->has_exact_int_val);
+    if (node->has_exact_int_val) str(node->exact_int_val->to_string());
+    uint64_t float_bits = 0;
+    std::memcpy(&float_bits, &node->float_val, sizeof(float_bits));
+    u64(float_bits);
+    str(node->string_val);
+    str(node->raw_literal);
+    flag(node->literal_is_unsigned);
+    str(node->name);
+    flag(node->is_expr_param_ref);
+    flag(node->creates_new_variable);
+    type(node->declared_var_type);
+    i64(node->scope_instance_id);
+    flag(node->is_mutable_binding);
+    str(node->op);
+    expr(node->left);
+    expr(node->right);
+    expr(node->operand);
+    exprs(node->args);
+    exprs(node->receivers);
+    flag(node->is_constructor_call);
+    flag(node->is_existence_probe);
+    exprs(node->elements);
+    stmts(node->statements);
+    expr(node->result_expr);
+    flag(node->is_optional_semantic_block);
+    flag(node->is_sorted_iteration);
+    flag(node->was_parenthesized);
+    expr(node->condition);
+    expr(node->true_expr);
+    expr(node->false_expr);
+    type(node->target_type);
+    strings(node->resource_path);
+    str(node->process_command);
+    if (config_.semantic) symbol(node->resolved_symbol);
+}
+
+void AstEncoder::stmt(const StmtPtr& node) {
+    if (!begin_node(node.get(), stmt_ids_)) return;
+    u64(static_cast<uint64_t>(node->kind));
+    loc(node->location);
+    i64(node->scope_instance_id);
+    annotations(node->annotations);
+    expr(node->expr);
+    expr(node->return_expr);
+    str(node->var_name);
+    type(node->var_type);
+    expr(node->var_init);
+    flag(node->is_mutable);
+    u64(static_cast<uint64_t>(node->var_linkage));
+    str(node->func_name);
+    str(node->type_namespace);
+    u64(node->params.size());
+    for (const Parameter& param : node->params) {
+        str(param.name);
+        type(param.type);
+        flag(param.is_expression_param);
+        loc(param.location);
+        annotations(param.annotations);
+        if (config_.semantic) symbol(param.resolved_symbol);
+    }
+    strings(node->ref_params);
+    types(node->ref_param_types);
+    type(node->return_type);
+    types(node->return_types);
+    expr(config_.interface_only && node->kind == Stmt::Kind::FuncDecl ? nullptr : node->body);
+    flag(node->is_external);
+    flag(node->is_exported);
+    flag(node->is_generic);
+    flag(node->is_instantiation);
+    str(node->type_decl_name);
+    u64(node->fields.size());
+    for (const Field& field : node->fields) {
+        str(field.name);
+        type(field.type);
+        loc(field.location);
+        annotations(field.annotations);
+    }
+    strings(node->import_path);
+    expr(node->condition);
+    stmt(node->true_stmt);
+    if (config_.semantic) {
+        symbol(node->resolved_symbol);
+        u64(node->ref_param_symbols.size());
+        for (const Symbol* sym : node->ref_param_symbols) {
+            symbol(sym);
+        }
+    }
+}
+
+void AstEncoder::module(const Module& module) {
+    loc(module.location);
+    u64(module.top_level.size());
+    for (const StmtPtr& stmt : module.top_level) {
+        this->stmt(stmt);
+    }
+    u64(module.top_level_instance_ids.size());
+    for (int id : module.top_level_instance_ids) {
+        i64(id);
+    }
+}
+
+std::string AstEncoder::finish(const std::string& header) {
+    std::string body;
+    body.swap(out_);
+    out_ += header;
+    out_.push_back('\n');
+    u64(files_.size());
+    for (const std::string& file : files_) {
+        str(file);
+    }
+    out_ += body;
+    return std::move(out_);
+}
+
+AstDecoder::AstDecoder(const std::string& data,
+                       const std::string& self_path,
+                       bool semantic,
+                       const std::vector<Symbol*>* symbols)
+    : in_(data),
+      self_file_(self_path.empty() ? 0 : intern_source_file(self_path)),
+      semantic_(semantic),
+      symbols_(symbols) {}
+
+bool AstDecoder::begin(const std::string& header) {
+    const std::string line = header + "\n";
+    if (in_.compare(0, line.size(), line) != 0) return false;
+    pos_ = line.size();
+    const uint64_t file_count = count();
+    for (uint64_t i = 0; i < file_count && ok_; ++i) {
+        file_ids_.push_back(intern_source_file(str()));
+    }
+    return ok_;
+}
+
+uint64_t AstDecoder::u64() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos_ >= in_.size()) break;
+        const uint8_t byte = static_cast<uint8_t>(in_[pos_++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    ok_ = false;
+    return 0;
+}
+
+int64_t AstDecoder::i64() {
+    const uint64_t raw = u64();
+    return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+}
+
+uint64_t AstDecoder::count() {
+    const uint64_t value = u64();
+    if (value > in_.size() - pos_) {
+        ok_ = false;
+        return 0;
+    }
+    return value;
+}
+
+bool AstDecoder::flag() {
+    if (pos_ >= in_.size()) {
+        ok_ = false;
+        return false;
+    }
+    return in_[pos_++] != 0;
+}
+
+std::string AstDecoder::str() {
+    const uint64_t size = count();
+    if (!ok_) return std::string();
+    std::string text = in_.substr(pos_, size);
+    pos_ += size;
+    return text;
+}
+
+std::vector<std::string> AstDecoder::strings() {
+    std::vector<std::string> values;
+    const uint64_t size = count();
+    for (uint64_t i = 0; i < size && ok_; ++i) {
+        values.push_back(str());
+    }
+    return values;
+}
+
+SourceLocation AstDecoder::loc() {
+    const uint64_t slot = u64();
+    uint32_t file_id = 0;
+    if (slot == kSelfFileSlot) {
+        file_id = self_file_;
+    } else if (slot != kNoFileSlot) {
+        if (slot - 2 >= file_ids_.size()) {
+            ok_ = false;
+        } else {
+            file_id = file_ids_[slot - 2];
+        }
+    }
+    const int line = static_cast<int>(i64());
+    const int column = static_cast<int>(i64());
+    return SourceLocation::in_file(file_id, line, column);
+}
+
+Symbol* AstDecoder::symbol() {
+    const uint64_t ref = u64();
+    if (ref == kNoSymbol) return nullptr;
+    if (!symbols_ || ref - 1 >= symbols_->size()) {
+        ok_ = false;
+        return nullptr;
+    }
+    return (*symbols_)[ref - 1];
+}
+
+std::vector<Annotation> AstDecoder::annotations() {
+    std::vector<Annotation> values;
+    const uint64_t size = count();
+    for (uint64_t i = 0; i < size && ok_; ++i) {
+        Annotation ann;
+        ann.name = str();
+        ann.args = strings();
+        ann.location = loc();
+        values.push_back(std::move(ann));
+    }
+    return values;
+}
+
+template <typename Kind>
+Kind AstDecoder::kind(Kind last) {
+    const uint64_t value = u64();
+    if (value > static_cast<uint64_t>(last)) ok_ = false;
+    return static_cast<Kind>(ok_ ? value : 0);
+}
+
+// Returns true when a new node body follows; `out` is then registered before
+// its children are read, mirroring the encoder's numbering.
+template <typename T>
+bool AstDecoder::begin_node(std::vector<std::shared_ptr<T>>& table, std::shared_ptr<T>& out) {
+    const uint64_t tag = u64();
+    if (!ok_ || tag == kNullNode) return false;
+    if (tag == kSharedNode) {
+        const uint64_t id = u64();
+        if (id >= table.size()) {
+            ok_ = false;
+        } else {
+            out = table[id];
+        }
+        return false;
+    }
+    if (tag != kNewNode) {
+        ok_ = false;
+        return false;
+    }
+    out = make_ast_node<T>();
+    table.push_back(out);
+    return true;
+}
+
+TypePtr AstDecoder::type() {
+    TypePtr node;
+    if (!begin_node(types_, node)) return node;
+    node->kind = kind(Type::Kind::TypeOf);
+    node->location = loc();
+    node->primitive = static_cast<PrimitiveType>(u64());
+    node->integer_bits = u64();
+    node->fractional_bits = i64();
+    node->element_type = type();
+    node->array_size = expr();
+    node->type_name = str();
+    node->var_id = static_cast<int>(i64());
+    node->var_name = str();
+    node->typeof_expr = expr();
+    if (semantic_) node->resolved_symbol = symbol();
+    return node;
+}
+
+std::vector<TypePtr> AstDecoder::types() {
+    std::vector<TypePtr> values;
+    const uint64_t size = count();
+    for (uint64_t i = 0; i < size && ok_; ++i) {
+        values.push_back(type());
+    }
+    return values;
+}
+
+std::vector<ExprPtr> AstDecoder::exprs() {
+    std::vector<ExprPtr> values;
+    const uint64_t size = count();
+    for (uint64_t i = 0; i < size && ok_; ++i) {
+        values.push_back(expr());
+    }
+    return values;
+}
+
+std::vector<StmtPtr> AstDecoder::stmts() {
+    std::vector<StmtPtr> values;
+    const uint64_t size = count();
+    for (uint64_t i = 0; i < size && ok_; ++i) {
+        values.push_back(stmt());
+    }
+    return values;
+}
+
+ExprPtr AstDecoder::expr() {
+    ExprPtr node;
+    if (!begin_node(exprs_, node)) return node;
+    node->kind = kind(Expr::Kind::Process);
+    node->location = loc();
+    node->type = type();
+    node->annotations = annotations();
+    node->uint_val = u64();
+    node->has_exact_int_val = flag();
+    if (node->has_exact_int_val) {
+        std::string digits = str();
+        const bool negative = !digits.empty() && digits[0] == '-';
+        if (negative) digits.erase(0, 1);
+        if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+            ok_ = false;
+            return node;
+        }
+        node->exact_int_val = APInt::parse_integer_literal(digits, SourceLocation());
+        if (negative) node->exact_int_val = -node->exact_int_val.value();
+    }
+    const uint64_t float_bits = u64();
+    std::memcpy(&node->float_val, &float_bits, sizeof(float_bits));
+    node->string_val = str();
+    node->raw_literal = str();
+    node->literal_is_unsigned = flag();
+    node->name = str();
+    node->is_expr_param_ref = flag();
+    node->creates_new_variable = flag();
+    node->declared_var_type = type();
+    node->scope_instance_id = static_cast<int>(i64());
+    node->is_mutable_binding = flag();
+    node->set_op(str());
+    node->left = expr();
+    node->right = expr();
+    node->operand = expr();
+    node->args = exprs();
+    node->receivers = exprs();
+    node->is_constructor_call = flag();
+    node->is_existence_probe = flag();
+    node->elements = exprs();
+    node->statements = stmts();
+    node->result_expr = expr();
+    node->is_optional_semantic_block = flag();
+    node->is_sorted_iteration = flag();
+    node->was_parenthesized = flag();
+    node->condition = expr();
+    node->true_expr = expr();
+    node->false_expr = expr();
+    node->target_type = type();
+    node->resource_path = strings();
+    node->process_command = str();
+    if (semantic_) node->resolved_symbol = symbol();
+    return node;
+}
+
+StmtPtr AstDecoder::stmt() {
+    StmtPtr node;
+    if (!begin_node(stmts_, node)) return node;
+    node->kind = kind(Stmt::Kind::ConditionalStmt);
+    node->location = loc();
+    node->scope_instance_id = static_cast<int>(i64());
+    node->annotations = annotations();
+    node->expr = expr();
+    node->return_expr = expr();
+    node->var_name = str();
+    node->var_type = type();
+    node->var_init = expr();
+    node->is_mutable = flag();
+    node->var_linkage = kind(VarLinkageKind::BackendBound);
+    node->func_name = str();
+    node->type_namespace = str();
+    const uint64_t param_count = count();
+    for (uint64_t i = 0; i < param_count && ok_; ++i) {
+        std::string name = str();
+        TypePtr param_type = type();
+        const bool is_expr = flag();
+        SourceLocation location = loc();
+        Parameter& param = node->params.emplace_back(name, param_type, is_expr, location, annotations());
+        if (semantic_) param.resolved_symbol = symbol();
+    }
+    node->ref_params = strings();
+    node->ref_param_types = types();
+    node->return_type = type();
+    node->return_types = types();
+    node->body = expr();
+    node->is_external = flag();
+    node->is_exported = flag();
+    node->is_generic = flag();
+    node->is_instantiation = flag();
+    node->type_decl_name = str();
+    const uint64_t field_count = count();
+    for (uint64_t i = 0; i < field_count && ok_; ++i) {
+        std::string name = str();
+        TypePtr field_type = type();
+        SourceLocation location = loc();
+        node->fields.emplace_back(name, field_type, location, annotations());
+    }
+    node->import_path = strings();
+    node->condition = expr();
+    node->true_stmt = stmt();
+    if (semantic_) {
+        node->resolved_symbol = symbol();
+        const uint64_t ref_count = count();
+        for (uint64_t i = 0; i < ref_count && ok_; ++i) {
+            node->ref_param_symbols.push_back(symbol());
+        }
+    }
+    return node;
+}
+
+void AstDecoder::module(Module& out) {
+    out.location = loc();
+    const uint64_t top_count = count();
+    for (uint64_t i = 0; i < top_count && ok_; ++i) {
+        out.top_level.push_back(stmt());
+    }
+    const uint64_t id_count = count();
+    for (uint64_t i = 0; i < id_count && ok_; ++i) {
+        out.top_level_instance_ids.push_back(static_cast<int>(i64()));
+    }
+}
+
+} // namespace vexel
@@ -0,0 +1,143 @@
+#pragma once
+#include "ast.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vexel {
+
+// Binary encoding of AST graphs, shared by the parsed-module cache and the
+// analyzed-program contract. Integers are LEB128 varints (signed ones
+// zigzag-encoded). Nodes reachable more than once are written once and
+// restored as shared; each node kind is numbered in first-write order, so a
+// later section can name an already written node by its number.
+//
+// The stream is a header line, the table of source files locations refer
+// to, then the encoded body.
+class AstEncoder {
+public:
+    struct Config {
+        // Drop source locations and function bodies, leaving what importers
+        // of a module can observe.
+        bool interface_only = false;
+        // Also write the resolved-symbol annotations of types, expressions,
+        // statements and parameters, as Symbol::id (the index into
+        // Program::symbols).
+        bool semantic = false;
+    };
+
+    // Locations in `self_path` get a dedicated slot, so an encoded module can
+    // be restored under a different path. Empty when there is no such file.
+    explicit AstEncoder(const std::string& self_path);
+    AstEncoder(const std::string& self_path, Config config);
+
+    void u64(uint64_t value);
+    void i64(int64_t value);
+    void flag(bool value);
+    void str(const std::string& text);
+    void strings(const std::vector<std::string>& values);
+    void loc(const SourceLocation& location);
+    void symbol(const Symbol* sym);
+
+    void type(const TypePtr& node);
+    void expr(const ExprPtr& node);
+    void stmt(const StmtPtr& node);
+    // Location, top-level statements and top-level instance ids.
+    void module(const Module& module);
+
+    // Number a node was written under; false when it was never written.
+    bool type_id(const Type* node, uint64_t& out) const { return find_id(type_ids_, node, out); }
+    bool expr_id(const Expr* node, uint64_t& out) const { return find_id(expr_ids_, node, out); }
+    bool stmt_id(const Stmt* node, uint64_t& out) const { return find_id(stmt_ids_, node, out); }
+    const std::unordered_map<const Stmt*, uint64_t>& stmt_ids() const { return stmt_ids_; }
+
+    // The header line and file table followed by everything written so far.
+    std::string finish(const std::string& header);
+
+private:
+    template <typename T>
+    static bool find_id(const std::unordered_map<const T*, uint64_t>& ids, const T* node, uint64_t& out) {
+        auto it = ids.find(node);
+        if (it == ids.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    template <typename T>
+    bool begin_node(const T* node, std::unordered_map<const T*, uint64_t>& ids);
+    void annotations(const std::vector<Annotation>& values);
+    void types(const std::vector<TypePtr>& values);
+    void exprs(const std::vector<ExprPtr>& values);
+    void stmts(const std::vector<StmtPtr>& values);
+
+    std::string out_;
+    uint32_t self_file_;
+    Config config_;
+    std::unordered_map<uint32_t, uint64_t> file_slots_;
+    std::vector<std::string> files_;
+    std::unordered_map<const Type*, uint64_t> type_ids_;
+    std::unordered_map<const Expr*, uint64_t> expr_ids_;
+    std::unordered_map<const Stmt*, uint64_t> stmt_ids_;
+};
+
+// Reads what AstEncoder wrote. Errors (truncation, out-of-range numbers,
+// unknown kinds) latch: every later read returns a default value and ok()
+// stays false, so callers check once at the end.
+class AstDecoder {
+public:
+    // `symbols` resolves symbol references of a semantic stream and must be
+    // sized before the first node is read; it may be null otherwise.
+    AstDecoder(const std::string& data, const std::string& self_path, bool semantic = false,
+               const std::vector<Symbol*>* symbols = nullptr);
+
+    // Consumes the header line and the file table.
+    bool begin(const std::string& header);
+    bool ok() const { return ok_; }
+    bool at_end() const { return pos_ == in_.size(); }
+    void fail() { ok_ = false; }
+
+    uint64_t u64();
+    int64_t i64();
+    // Element counts can never exceed the remaining bytes; anything larger
+    // fails before it drives an allocation.
+    uint64_t count();
+    bool flag();
+    std::string str();
+    std::vector<std::string> strings();
+    SourceLocation loc();
+    Symbol* symbol();
+
+    TypePtr type();
+    ExprPtr expr();
+    StmtPtr stmt();
+    void module(Module& out);
+
+    // Nodes by the number they were written under.
+    const std::vector<TypePtr>& types_read() const { return types_; }
+    const std::vector<ExprPtr>& exprs_read() const { return exprs_; }
+    const std::vector<StmtPtr>& stmts_read() const { return stmts_; }
+
+private:
+    template <typename Kind>
+    Kind kind(Kind last);
+    template <typename T>
+    bool begin_node(std::vector<std::shared_ptr<T>>& table, std::shared_ptr<T>& out);
+    std::vector<Annotation> annotations();
+    std::vector<TypePtr> types();
+    std::vector<ExprPtr> exprs();
+    std::vector<StmtPtr> stmts();
+
+    const std::string& in_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+    uint32_t self_file_;
+    bool semantic_;
+    const std::vector<Symbol*>* symbols_;
+    std::vector<uint32_t> file_ids_;
+    std::vector<TypePtr> types_;
+    std::vector<ExprPtr> exprs_;
+    std::vector<StmtPtr> stmts_;
+};
+
+} // namespace vexel
@@ -0,0 +1,446 @@
+#pragma once
+#include "atom.h"
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace vexel {
+
+// Compact storage for Expr members. Most members only matter for a few node
+// kinds, so each holder below is one pointer wide, allocates once a value is
+// stored and reads as the default value until then. Holders convert to the
+// type they stand for, so uses read like the plain member they replace; code
+// that needs a mutable reference to the underlying object asks for it
+// explicitly (mutable_vector/mutable_value), which allocates. Once allocated,
+// storage is reused by every later assignment, so such references stay valid
+// as they would for a plain member.
+
+// std::vector replacement that costs one pointer while empty. Iterators are
+// plain pointers.
+template <typename T>
+class AstList {
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    AstList() = default;
+    AstList(std::vector<T> items) { assign(std::move(items)); }
+    AstList(std::initializer_list<T> items) { assign(std::vector<T>(items)); }
+    AstList(const AstList& other) { assign(other.vector()); }
+    AstList(AstList&& other) noexcept = default;
+    AstList& operator=(const AstList& other) {
+        if (this != &other) assign(other.vector());
+        return *this;
+    }
+    AstList& operator=(AstList&& other) noexcept {
+        if (this != &other) {
+            if (!items_) {
+                items_ = std::move(other.items_);
+            } else if (other.items_) {
+                *items_ = std::move(*other.items_);
+            } else {
+                items_->clear();
+            }
+        }
+        return *this;
+    }
+    AstList& operator=(std::vector<T> items) {
+        assign(std::move(items));
+        return *this;
+    }
+
+    operator const std::vector<T>&() const { return vector(); }
+    const std::vector<T>& vector() const { return items_ ? *items_ : empty_items(); }
+    std::vector<T>& mutable_vector() {
+        if (!items_) items_ = std::make_unique<std::vector<T>>();
+        return *items_;
+    }
+
+    bool empty() const { return !items_ || items_->empty(); }
+    size_t size() const { return items_ ? items_->size() : 0; }
+
+    iterator begin() { return items_ ? items_->data() : nullptr; }
+    iterator end() { return items_ ? items_->data() + items_->size() : nullptr; }
+    const_iterator begin() const { return items_ ? items_->data() : nullptr; }
+    const_iterator end() const { return items_ ? items_->data() + items_->size() : nullptr; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    T& operator[](size_t i) { return (*items_)[i]; }
+    const T& operator[](size_t i) const { return (*items_)[i]; }
+    T& front() { return items_->front(); }
+    const T& front() const { return items_->front(); }
+    T& back() { return items_->back(); }
+    const T& back() const { return items_->back(); }
+    T* data() { return begin(); }
+    const T* data() const { return begin(); }
+
+    void push_back(T value) { mutable_vector().push_back(std::move(value)); }
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        return mutable_vector().emplace_back(std::forward<Args>(args)...);
+    }
+    void pop_back() { items_->pop_back(); }
+    iterator insert(const_iterator pos, T value) {
+        const size_t index = offset_of(pos);
+        auto& items = mutable_vector();
+        return &*items.insert(items.begin() + index, std::move(value));
+    }
+    template <typename It>
+    iterator insert(const_iterator pos, It first, It last) {
+        const size_t index = offset_of(pos);
+        auto& items = mutable_vector();
+        items.insert(items.begin() + index, first, last);
+        return items.data() + index;
+    }
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(const_iterator first, const_iterator last) {
+        const size_t index = offset_of(first);
+        items_->erase(items_->begin() + index, items_->begin() + offset_of(last));
+        return items_->data() + index;
+    }
+    void clear() {
+        if (items_) items_->clear();
+    }
+    void swap(std::vector<T>& other) { mutable_vector().swap(other); }
+    void reserve(size_t count) {
+        if (count > 0) mutable_vector().reserve(count);
+    }
+    void resize(size_t count) {
+        if (count > 0 || items_) mutable_vector().resize(count);
+    }
+    void resize(size_t count, const T& value) {
+        if (count > 0 || items_) mutable_vector().resize(count, value);
+    }
+    void assign(std::vector<T> items) {
+        if (items_) {
+            *items_ = std::move(items);
+        } else if (!items.empty()) {
+            items_ = std::make_unique<std::vector<T>>(std::move(items));
+        }
+    }
+
+    friend bool operator==(const AstList& a, const AstList& b) { return a.vector() == b.vector(); }
+    friend bool operator!=(const AstList& a, const AstList& b) { return !(a == b); }
+
+private:
+    static const std::vector<T>& empty_items() {
+        static const std::vector<T> empty;
+        return empty;
+    }
+    size_t offset_of(const_iterator pos) const { return items_ ? static_cast<size_t>(pos - items_->data()) : 0; }
+
+    std::unique_ptr<std::vector<T>> items_;
+};
+
+// Read-only std::string interface shared by the string holders; `Derived`
+// provides str().
+template <typename Derived>
+class AstStringView {
+public:
+    operator const std::string&() const { return text(); }
+    const std::string& str() const { return text(); }
+    bool empty() const { return text().empty(); }
+    size_t size() const { return text().size(); }
+    size_t length() const { return text().size(); }
+    const char* c_str() const { return text().c_str(); }
+    const char* data() const { return text().data(); }
+    char front() const { return text().front(); }
+    char back() const { return text().back(); }
+    char operator[](size_t i) const { return text()[i]; }
+    std::string::const_iterator begin() const { return text().begin(); }
+    std::string::const_iterator end() const { return text().end(); }
+    std::string substr(size_t pos = 0, size_t count = std::string::npos) const { return text().substr(pos, count); }
+    template <typename S>
+    size_t find(const S& needle, size_t pos = 0) const { return text().find(needle, pos); }
+    template <typename S>
+    size_t rfind(const S& needle, size_t pos = std::string::npos) const { return text().rfind(needle, pos); }
+    template <typename S>
+    int compare(const S& other) const { return text().compare(other); }
+
+private:
+    const std::string& text() const { return static_cast<const Derived&>(*this).str(); }
+};
+
+template <typename S>
+using EnableIfAstString = std::enable_if_t<std::is_base_of<AstStringView<S>, S>::value, int>;
+
+template <typename S, EnableIfAstString<S> = 0>
+bool operator==(const S& a, const std::string& b) { return a.str() == b; }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator==(const std::string& a, const S& b) { return a == b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator==(const S& a, const char* b) { return a.str() == b; }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator==(const char* a, const S& b) { return a == b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator!=(const S& a, const std::string& b) { return !(a == b); }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator!=(const std::string& a, const S& b) { return !(a == b); }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator!=(const S& a, const char* b) { return !(a == b); }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator!=(const char* a, const S& b) { return !(a == b); }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator<(const S& a, const std::string& b) { return a.str() < b; }
+template <typename S, EnableIfAstString<S> = 0>
+bool operator<(const std::string& a, const S& b) { return a < b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(const S& a, const std::string& b) { return a.str() + b; }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(const std::string& a, const S& b) { return a + b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(std::string&& a, const S& b) { return std::move(a) + b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(const S& a, const char* b) { return a.str() + b; }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(const char* a, const S& b) { return a + b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(const S& a, char b) { return a.str() + b; }
+template <typename S, EnableIfAstString<S> = 0>
+std::string operator+(char a, const S& b) { return a + b.str(); }
+template <typename S, EnableIfAstString<S> = 0>
+std::ostream& operator<<(std::ostream& out, const S& s) { return out << s.str(); }
+
+// Identifier and operator spellings, held as a pointer into the process-wide
+// atom table. Equal spellings share storage and compare by pointer.
+class AstName : public AstStringView<AstName> {
+public:
+    AstName() = default;
+    AstName(const std::string& text) { assign(text); }
+    AstName(const char* text) { assign(text); }
+    AstName& operator=(const std::string& text) {
+        assign(text);
+        return *this;
+    }
+    AstName& operator=(const char* text) {
+        assign(text);
+        return *this;
+    }
+    AstName& operator+=(const std::string& suffix) { return *this = str() + suffix; }
+    void clear() { text_ = nullptr; }
+
+    const std::string& str() const { return text_ ? *text_ : empty_text(); }
+
+    friend bool operator==(const AstName& a, const AstName& b) { return a.text_ == b.text_; }
+    friend bool operator!=(const AstName& a, const AstName& b) { return a.text_ != b.text_; }
+
+private:
+    static const std::string& empty_text() {
+        static const std::string empty;
+        return empty;
+    }
+    void assign(const std::string& text) { text_ = text.empty() ? nullptr : &interned_spelling(text); }
+
+    const std::string* text_ = nullptr;
+};
+
+// Owned string that costs one pointer while empty, for literal text.
+class AstText : public AstStringView<AstText> {
+public:
+    AstText() = default;
+    AstText(const std::string& text) { assign(text); }
+    AstText(const char* text) { assign(text); }
+    AstText(const AstText& other) { assign(other.str()); }
+    AstText(AstText&&) noexcept = default;
+    AstText& operator=(const AstText& other) {
+        if (this != &other) assign(other.str());
+        return *this;
+    }
+    AstText& operator=(AstText&& other) noexcept {
+        if (this != &other) {
+            if (!text_) {
+                text_ = std::move(other.text_);
+            } else if (other.text_) {
+                *text_ = std::move(*other.text_);
+            } else {
+                text_->clear();
+            }
+        }
+        return *this;
+    }
+    AstText& operator=(const std::string& text) {
+        assign(text);
+        return *this;
+    }
+    AstText& operator=(const char* text) {
+        assign(text);
+        return *this;
+    }
+    AstText& operator+=(const std::string& suffix) {
+        assign(str() + suffix);
+        return *this;
+    }
+    void clear() {
+        if (text_) text_->clear();
+    }
+
+    const std::string& str() const { return text_ ? *text_ : empty_text(); }
+
+    friend bool operator==(const AstText& a, const AstText& b) { return a.str() == b.str(); }
+    friend bool operator!=(const AstText& a, const AstText& b) { return a.str() != b.str(); }
+
+private:
+    static const std::string& empty_text() {
+        static const std::string empty;
+        return empty;
+    }
+    void assign(const std::string& text) {
+        if (text_) {
+            *text_ = text;
+        } else if (!text.empty()) {
+            text_ = std::make_unique<std::string>(text);
+        }
+    }
+
+    std::unique_ptr<std::string> text_;
+};
+
+// Value that costs one pointer until it is first set.
+template <typename T>
+class AstBox {
+public:
+    AstBox() = default;
+    AstBox(T value) { set(std::move(value)); }
+    AstBox(const AstBox& other) {
+        if (other.value_) value_ = std::make_unique<T>(*other.value_);
+    }
+    AstBox(AstBox&&) noexcept = default;
+    AstBox& operator=(const AstBox& other) {
+        if (this != &other) set(other.value());
+        return *this;
+    }
+    AstBox& operator=(AstBox&& other) noexcept {
+        if (this != &other) {
+            if (!value_) {
+                value_ = std::move(other.value_);
+            } else {
+                *value_ = other.value_ ? std::move(*other.value_) : T{};
+            }
+        }
+        return *this;
+    }
+    AstBox& operator=(T value) {
+        set(std::move(value));
+        return *this;
+    }
+
+    operator const T&() const { return value(); }
+    const T& value() const { return value_ ? *value_ : default_value(); }
+    T& mutable_value() {
+        if (!value_) value_ = std::make_unique<T>();
+        return *value_;
+    }
+    const T* operator->() const { return &value(); }
+
+private:
+    static const T& default_value() {
+        static const T value{};
+        return value;
+    }
+    void set(T value) {
+        if (value_) {
+            *value_ = std::move(value);
+        } else if (!(value == default_value())) {
+            value_ = std::make_unique<T>(std::move(value));
+        }
+    }
+
+    std::unique_ptr<T> value_;
+};
+
+// Shared-pointer slot that costs one pointer while null; dereferences to the
+// pointee like the shared_ptr it holds.
+template <typename T>
+class AstBox<std::shared_ptr<T>> {
+public:
+    using element_type = T;
+
+    AstBox() = default;
+    AstBox(std::nullptr_t) {}
+    AstBox(std::shared_ptr<T> value) { set(std::move(value)); }
+    AstBox(const AstBox& other) { set(other.value()); }
+    AstBox(AstBox&&) noexcept = default;
+    AstBox& operator=(const AstBox& other) {
+        if (this != &other) set(other.value());
+        return *this;
+    }
+    AstBox& operator=(AstBox&& other) noexcept {
+        if (this != &other) {
+            if (!value_) {
+                value_ = std::move(other.value_);
+            } else if (other.value_) {
+                *value_ = std::move(*other.value_);
+            } else {
+                value_->reset();
+            }
+        }
+        return *this;
+    }
+    AstBox& operator=(std::shared_ptr<T> value) {
+        set(std::move(value));
+        return *this;
+    }
+    AstBox& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    operator const std::shared_ptr<T>&() const { return value(); }
+    const std::shared_ptr<T>& value() const { return value_ ? *value_ : null_value(); }
+    std::shared_ptr<T>& mutable_value() {
+        if (!value_) value_ = std::make_unique<std::shared_ptr<T>>();
+        return *value_;
+    }
+
+    explicit operator bool() const { return value_ && *value_; }
+    T* get() const { return value_ ? value_->get() : nullptr; }
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+    void reset() {
+        if (value_) value_->reset();
+    }
+
+    friend bool operator==(const AstBox& a, const AstBox& b) { return a.get() == b.get(); }
+    friend bool operator!=(const AstBox& a, const AstBox& b) { return a.get() != b.get(); }
+    friend bool operator==(const AstBox& a, const std::shared_ptr<T>& b) { return a.get() == b.get(); }
+    friend bool operator!=(const AstBox& a, const std::shared_ptr<T>& b) { return a.get() != b.get(); }
+    friend bool operator==(const std::shared_ptr<T>& a, const AstBox& b) { return a.get() == b.get(); }
+    friend bool operator!=(const std::shared_ptr<T>& a, const AstBox& b) { return a.get() != b.get(); }
+    friend bool operator==(const AstBox& a, std::nullptr_t) { return !a; }
+    friend bool operator!=(const AstBox& a, std::nullptr_t) { return static_cast<bool>(a); }
+    friend bool operator==(std::nullptr_t, const AstBox& a) { return !a; }
+    friend bool operator!=(std::nullptr_t, const AstBox& a) { return static_cast<bool>(a); }
+
+private:
+    static const std::shared_ptr<T>& null_value() {
+        static const std::shared_ptr<T> null;
+        return null;
+    }
+    void set(std::shared_ptr<T> value) {
+        if (value_) {
+            *value_ = std::move(value);
+        } else if (value) {
+            value_ = std::make_unique<std::shared_ptr<T>>(std::move(value));
+        }
+    }
+
+    std::unique_ptr<std::shared_ptr<T>> value_;
+};
+
+} // namespace vexel
@@ -0,0 +1,67 @@
+#include "atom.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace vexel {
+
+namespace {
+
+struct AtomTable {
+    std::shared_mutex mutex;
+    // Deque keeps returned references stable as the table grows.
+    std::deque<std::string> names;
+    std::unordered_map<std::string, Atom> ids;
+};
+
+AtomTable& atom_table() {
+    static AtomTable table;
+    return table;
+}
+
+} // namespace
+
+Atom intern_atom(const std::string& name) {
+    AtomTable& table = atom_table();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) return it->second;
+    const Atom atom = static_cast<Atom>(table.names.size());
+    table.names.push_back(name);
+    table.ids.emplace(name, atom);
+    return atom;
+}
+
+const std::string& interned_spelling(const std::string& name) {
+    AtomTable& table = atom_table();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) return table.names[it->second];
+    }
+    const Atom atom = intern_atom(name);
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return table.names[atom];
+}
+
+const std::string& atom_spelling(Atom atom) {
+    AtomTable& table = atom_table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return table.names[atom];
+}
+
+Atom find_atom(const std::string& name) {
+    AtomTable& table = atom_table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    return it == table.ids.end() ? kNoAtom : it->second;
+}
+
+} // namespace vexel
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace vexel {
+
+// Process-wide table of interned identifier spellings. Symbol tables key on
+// the returned atom, so a name is hashed once per lookup no matter how many
+// scopes the lookup walks. Atoms are never released.
+using Atom = uint32_t;
+constexpr Atom kNoAtom = UINT32_MAX;
+
+Atom intern_atom(const std::string& name);
+// Atom of `name` if it was ever interned, otherwise kNoAtom.
+Atom find_atom(const std::string& name);
+// The table's copy of `name`, interning it first; stable for the process.
+const std::string& interned_spelling(const std::string& name);
+// Spelling an atom was interned from.
+const std::string& atom_spelling(Atom atom);
+
+} // namespace vexel
@@ -0,0 +1,73 @@
+#include "bindings.h"
+
+namespace vexel {
+
+Bindings::Slot& Bindings::insert(int instance_id, const void* node) {
+    if ((count_ + 1) * 4 > slots_.size() * 3) grow();
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash(instance_id, node) & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots_[i];
+        if (!slot.node) {
+            slot.node = node;
+            slot.instance_id = instance_id;
+            ++count_;
+            return slot;
+        }
+        if (slot.node == node && slot.instance_id == instance_id) return slot;
+    }
+}
+
+void Bindings::erase(int instance_id, const void* node) {
+    if (slots_.empty()) return;
+    const size_t mask = slots_.size() - 1;
+    size_t hole = hash(instance_id, node) & mask;
+    while (true) {
+        const Slot& slot = slots_[hole];
+        if (!slot.node) return;
+        if (slot.node == node && slot.instance_id == instance_id) break;
+        hole = (hole + 1) & mask;
+    }
+
+    // Shift later members of the probe run back so lookups never need
+    // tombstones: a slot moves into the hole unless its home lies strictly
+    // between the hole and the slot (cyclically).
+    for (size_t i = (hole + 1) & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots_[i];
+        if (!slot.node) break;
+        const size_t home = hash(slot.instance_id, slot.node) & mask;
+        const bool home_after_hole = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (home_after_hole) continue;
+        slots_[hole] = slot;
+        hole = i;
+    }
+    slots_[hole] = Slot();
+    --count_;
+}
+
+void Bindings::grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.assign(old.empty() ? 64 : old.size() * 2, Slot());
+    const size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (!slot.node) continue;
+        size_t i = hash(slot.instance_id, slot.node) & mask;
+        while (slots_[i].node) i = (i + 1) & mask;
+        slots_[i] = slot;
+    }
+}
+
+void Bindings::rebuild(const std::vector<Slot>& entries) {
+    size_t size = entries.empty() ? 0 : 64;
+    while (entries.size() * 4 > size * 3) size *= 2;
+    std::vector<Slot>(size).swap(slots_);
+    count_ = entries.size();
+    const size_t mask = size - 1;
+    for (const Slot& slot : entries) {
+        size_t i = hash(slot.instance_id, slot.node) & mask;
+        while (slots_[i].node) i = (i + 1) & mask;
+        slots_[i] = slot;
+    }
+}
+
+} // namespace vexel
@@ -1,57 +1,138 @@
 #pragma once
 #include "symbols.h"
-#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 namespace vexel {
 
-struct BindingKey {
-    int instance_id = -1;
-    const void* node = nullptr;
-
-    bool operator==(const BindingKey& other) const {
-        return instance_id == other.instance_id && node == other.node;
-    }
-};
-
-struct BindingKeyHash {
-    size_t operator()(const BindingKey& key) const noexcept {
-        return std::hash<int>()(key.instance_id) ^ (std::hash<const void*>()(key.node) << 1);
-    }
-};
-
+// Resolution of AST nodes to symbols, per module instance, together with the
+// "declares a new variable" flag of assignment nodes. Queried by every stage
+// after resolution, so both facts share one open-addressing table (linear
+// probing, backward-shift deletion) keyed by a mixed (instance, node) hash.
+// Accesses are unsynchronized unless concurrent access is enabled, which the
+// parallel type checker does for the duration of its worker waves.
 class Bindings {
 public:
     void bind(int instance_id, const void* node, Symbol* sym) {
         if (!node) return;
-        symbol_map[{instance_id, node}] = sym;
+        WriteLock lock(mutex_.get());
+        insert(instance_id, node).symbol = sym;
     }
 
     Symbol* lookup(int instance_id, const void* node) const {
-        auto it = symbol_map.find({instance_id, node});
-        if (it == symbol_map.end()) return nullptr;
-        return it->second;
+        ReadLock lock(mutex_.get());
+        const Slot* slot = find(instance_id, node);
+        return slot ? slot->symbol : nullptr;
     }
 
     void unbind(int instance_id, const void* node) {
         if (!node) return;
-        symbol_map.erase({instance_id, node});
-        new_var_map.erase({instance_id, node});
+        WriteLock lock(mutex_.get());
+        erase(instance_id, node);
     }
 
     void set_new_variable(int instance_id, const void* node, bool value) {
         if (!node) return;
-        new_var_map[{instance_id, node}] = value;
+        WriteLock lock(mutex_.get());
+        insert(instance_id, node).new_variable = value;
     }
 
     bool is_new_variable(int instance_id, const void* node) const {
-        auto it = new_var_map.find({instance_id, node});
-        if (it == new_var_map.end()) return false;
-        return it->second;
+        ReadLock lock(mutex_.get());
+        const Slot* slot = find(instance_id, node);
+        return slot && slot->new_variable;
+    }
+
+    // Must not be toggled while other threads access the table.
+    void set_concurrent_access(bool enabled) {
+        mutex_ = enabled ? std::make_unique<std::shared_mutex>() : nullptr;
+    }
+
+    size_t size() const { return count_; }
+
+    // Visits every entry as (instance_id, node, symbol, new_variable), in
+    // table order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        ReadLock lock(mutex_.get());
+        for (const Slot& slot : slots_) {
+            if (slot.node) fn(slot.instance_id, slot.node, slot.symbol, slot.new_variable);
+        }
+    }
+
+    // Drops every entry keep(instance_id, node) rejects and shrinks the table
+    // to fit the rest.
+    template <typename Pred>
+    void retain_if(Pred&& keep) {
+        WriteLock lock(mutex_.get());
+        std::vector<Slot> kept;
+        kept.reserve(count_);
+        for (const Slot& slot : slots_) {
+            if (slot.node && keep(slot.instance_id, slot.node)) kept.push_back(slot);
+        }
+        rebuild(kept);
     }
 
 private:
-    std::unordered_map<BindingKey, Symbol*, BindingKeyHash> symbol_map;
-    std::unordered_map<BindingKey, bool, BindingKeyHash> new_var_map;
+    // Lock guards that do nothing for a null mutex.
+    struct ReadLock {
+        explicit ReadLock(std::shared_mutex* mutex) : mutex_(mutex) {
+            if (mutex_) mutex_->lock_shared();
+        }
+        ~ReadLock() {
+            if (mutex_) mutex_->unlock_shared();
+        }
+        std::shared_mutex* mutex_;
+    };
+    struct WriteLock {
+        explicit WriteLock(std::shared_mutex* mutex) : mutex_(mutex) {
+            if (mutex_) mutex_->lock();
+        }
+        ~WriteLock() {
+            if (mutex_) mutex_->unlock();
+        }
+        std::shared_mutex* mutex_;
+    };
+
+    struct Slot {
+        const void* node = nullptr;  // Null marks an empty slot.
+        int instance_id = -1;
+        bool new_variable = false;
+        Symbol* symbol = nullptr;
+    };
+
+    static size_t hash(int instance_id, const void* node) {
+        uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) ^
+                     (static_cast<uint64_t>(static_cast<uint32_t>(instance_id)) * 0x9e3779b97f4a7c15ULL);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    const Slot* find(int instance_id, const void* node) const {
+        if (slots_.empty() || !node) return nullptr;
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = hash(instance_id, node) & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots_[i];
+            if (!slot.node) return nullptr;
+            if (slot.node == node && slot.instance_id == instance_id) return &slot;
+        }
+    }
+
+    Slot& insert(int instance_id, const void* node);
+    void erase(int instance_id, const void* node);
+    void grow();
+    void rebuild(const std::vector<Slot>& entries);
+
+    std::vector<Slot> slots_;  // Power-of-two size, at most 3/4 full.
+    size_t count_ = 0;
+    std::unique_ptr<std::shared_mutex> mutex_;
 };
 
 } // namespace vexel
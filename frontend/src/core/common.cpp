@@ -0,0 +1,42 @@
+#include "common.h"
+
+#include <deque>
+#include <mutex>
+
+namespace vexel {
+
+namespace {
+
+struct SourceFileTable {
+    std::mutex mutex;
+    // Deque keeps returned references stable as the table grows.
+    std::deque<std::string> names{std::string()};
+    std::unordered_map<std::string, uint32_t> ids{{std::string(), 0}};
+};
+
+SourceFileTable& source_file_table() {
+    static SourceFileTable table;
+    return table;
+}
+
+} // namespace
+
+uint32_t intern_source_file(const std::string& filename) {
+    SourceFileTable& table = source_file_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(filename);
+    if (it != table.ids.end()) return it->second;
+    const uint32_t id = static_cast<uint32_t>(table.names.size());
+    table.names.push_back(filename);
+    table.ids.emplace(filename, id);
+    return id;
+}
+
+const std::string& source_file_name(uint32_t file_id) {
+    SourceFileTable& table = source_file_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (file_id >= table.names.size()) return table.names.front();
+    return table.names[file_id];
+}
+
+} // namespace vexel
@@ -9,12 +9,27 @@
 
 namespace vexel {
 
+// Process-wide table of source file names. Locations store the returned id;
+// id 0 is the empty name. Safe to call from concurrent front-end passes.
+uint32_t intern_source_file(const std::string& filename);
+const std::string& source_file_name(uint32_t file_id);
+
 struct SourceLocation {
-    std::string filename;
+    uint32_t file_id;
     int line;
     int column;
     SourceLocation(const std::string& f = "", int l = 0, int c = 0)
-        : filename(f), line(l), column(c) {}
+        : file_id(f.empty() ? 0 : intern_source_file(f)), line(l), column(c) {}
+
+    static SourceLocation in_file(uint32_t file_id, int line, int column) {
+        SourceLocation loc;
+        loc.file_id = file_id;
+        loc.line = line;
+        loc.column = column;
+        return loc;
+    }
+
+    const std::string& filename() const { return source_file_name(file_id); }
 };
 
 enum class CompileErrorCode {
@@ -82,7 +97,7 @@ struct Diagnostic {
             case DiagnosticLevel::Note: level_str = "Note"; break;
         }
 
-        std::string result = level_str + " at " + location.filename + ":" +
+        std::string result = level_str + " at " + location.filename() + ":" +
                            std::to_string(location.line) + ":" +
                            std::to_string(location.column) + ": " + message;
 
@@ -0,0 +1,52 @@
+#include "constexpr_facts.h"
+#include "cte_value_utils.h"
+
+namespace vexel {
+
+void ConstexprFactStore::set_checked_condition(const ExprFactKey& key, std::optional<bool> value) {
+    if (value.has_value()) {
+        checked_conditions_[key] = value.value();
+    } else {
+        checked_conditions_.erase(key);
+    }
+}
+
+std::optional<bool> ConstexprFactStore::checked_condition(const ExprFactKey& key) const {
+    auto it = checked_conditions_.find(key);
+    if (it == checked_conditions_.end()) return std::nullopt;
+    return it->second;
+}
+
+void ConstexprFactStore::merge_checked_conditions(const ConstexprFactStore& other) {
+    for (const auto& entry : other.checked_conditions_) {
+        checked_conditions_[entry.first] = entry.second;
+    }
+}
+
+void ConstexprFactStore::reset_fixpoint_facts() {
+    values_.clear();
+    conditions_.clear();
+}
+
+void ConstexprFactStore::publish_value(const ExprFactKey& key, CTValue value) {
+    values_[key] = std::move(value);
+}
+
+void ConstexprFactStore::publish_condition(const ExprFactKey& key, bool value) {
+    conditions_[key] = value;
+}
+
+const CTValue* ConstexprFactStore::value(const ExprFactKey& key) const {
+    auto it = values_.find(key);
+    return it == values_.end() ? nullptr : &it->second;
+}
+
+std::optional<bool> ConstexprFactStore::condition(const ExprFactKey& key) const {
+    auto it = conditions_.find(key);
+    if (it != conditions_.end()) return it->second;
+    const CTValue* fixpoint_value = value(key);
+    if (!fixpoint_value) return std::nullopt;
+    return cte_scalar_to_bool(*fixpoint_value);
+}
+
+} // namespace vexel
@@ -0,0 +1,87 @@
+#pragma once
+#include "cte_value.h"
+#include <optional>
+#include <unordered_map>
+
+namespace vexel {
+
+struct Expr;
+struct Stmt;
+
+// Stable identity of a node inside one module instance. Every pass that
+// records or consults compile-time facts keys them this way.
+struct ExprFactKey {
+    int instance_id = -1;
+    const Expr* expr = nullptr;
+
+    bool operator==(const ExprFactKey& other) const {
+        return instance_id == other.instance_id && expr == other.expr;
+    }
+};
+
+struct ExprFactKeyHash {
+    std::size_t operator()(const ExprFactKey& key) const noexcept {
+        std::size_t h1 = std::hash<int>{}(key.instance_id);
+        std::size_t h2 = std::hash<const Expr*>{}(key.expr);
+        return h1 ^ (h2 + 0x9e3779b9ULL + (h1 << 6) + (h1 >> 2));
+    }
+};
+
+struct StmtFactKey {
+    int instance_id = -1;
+    const Stmt* stmt = nullptr;
+
+    bool operator==(const StmtFactKey& other) const {
+        return instance_id == other.instance_id && stmt == other.stmt;
+    }
+};
+
+struct StmtFactKeyHash {
+    std::size_t operator()(const StmtFactKey& key) const noexcept {
+        std::size_t h1 = std::hash<int>{}(key.instance_id);
+        std::size_t h2 = std::hash<const Stmt*>{}(key.stmt);
+        return h1 ^ (h2 + 0x9e3779b9ULL + (h1 << 6) + (h1 >> 2));
+    }
+};
+
+inline ExprFactKey expr_fact_key(int instance_id, const Expr* expr) {
+    return ExprFactKey{instance_id, expr};
+}
+
+inline StmtFactKey stmt_fact_key(int instance_id, const Stmt* stmt) {
+    return StmtFactKey{instance_id, stmt};
+}
+
+// Frontend-wide store of compile-time expression facts, owned by the
+// TypeChecker so every pass reaches the same instance. It has two layers:
+// - checked conditions: published while type checking. They decide which
+//   branch was checked, so later checker queries must agree with them.
+// - fixpoint values/conditions: published by the optimizer after each
+//   (re)run and read by residualization, analysis, pruning and backends.
+// Readers call the lookups below instead of re-running CTE queries.
+class ConstexprFactStore {
+public:
+    void set_checked_condition(const ExprFactKey& key, std::optional<bool> value);
+    std::optional<bool> checked_condition(const ExprFactKey& key) const;
+    void merge_checked_conditions(const ConstexprFactStore& other);
+    void clear_checked_conditions() { checked_conditions_.clear(); }
+
+    void reset_fixpoint_facts();
+    void publish_value(const ExprFactKey& key, CTValue value);
+    void publish_condition(const ExprFactKey& key, bool value);
+
+    const CTValue* value(const ExprFactKey& key) const;
+    // Fixpoint condition for `key`, falling back to a scalar fixpoint value.
+    std::optional<bool> condition(const ExprFactKey& key) const;
+    size_t value_count() const { return values_.size(); }
+    size_t condition_count() const { return conditions_.size(); }
+    const std::unordered_map<ExprFactKey, CTValue, ExprFactKeyHash>& values() const { return values_; }
+    const std::unordered_map<ExprFactKey, bool, ExprFactKeyHash>& conditions() const { return conditions_; }
+
+private:
+    std::unordered_map<ExprFactKey, bool, ExprFactKeyHash> checked_conditions_;
+    std::unordered_map<ExprFactKey, CTValue, ExprFactKeyHash> values_;
+    std::unordered_map<ExprFactKey, bool, ExprFactKeyHash> conditions_;
+};
+
+} // namespace vexel
@@ -1,8 +1,106 @@
 #include "cte_value.h"
+#include <algorithm>
+#include <cstring>
 #include <limits>
 
 namespace vexel {
 
+namespace {
+
+thread_local uint64_t allocated_bytes = 0;
+thread_local int64_t live_bytes = 0;
+thread_local int64_t peak_live_bytes = 0;
+
+// A string buffer and its charge share one allocation; CTString points at
+// the text through an aliasing shared_ptr.
+struct ChargedString {
+    std::string text;
+    CTMemoryCharge charge;
+};
+
+} // namespace
+
+uint64_t ct_allocated_bytes() {
+    return allocated_bytes;
+}
+
+void ct_note_allocation(size_t bytes) {
+    allocated_bytes += bytes;
+}
+
+int64_t ct_live_bytes() {
+    return live_bytes;
+}
+
+int64_t ct_reset_peak_live_bytes() {
+    const int64_t outer = peak_live_bytes;
+    peak_live_bytes = live_bytes;
+    return outer;
+}
+
+void ct_restore_peak_live_bytes(int64_t outer_peak) {
+    peak_live_bytes = std::max(peak_live_bytes, outer_peak);
+}
+
+int64_t ct_peak_live_bytes() {
+    return peak_live_bytes;
+}
+
+void CTMemoryCharge::set(size_t bytes) {
+    if (bytes == bytes_) return;
+    live_bytes += static_cast<int64_t>(bytes) - static_cast<int64_t>(bytes_);
+    bytes_ = bytes;
+    if (live_bytes > peak_live_bytes) peak_live_bytes = live_bytes;
+}
+
+CTMemoryCharge& CTMemoryCharge::operator=(CTMemoryCharge&& other) noexcept {
+    if (this != &other) {
+        set(0);
+        bytes_ = other.bytes_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+CTString::CTString() {
+    static const std::shared_ptr<const std::string> empty = std::make_shared<const std::string>();
+    text_ = empty;
+}
+
+CTString::CTString(std::string text) {
+    allocated_bytes += text.size();
+    auto buffer = std::make_shared<ChargedString>();
+    buffer->text = std::move(text);
+    buffer->charge.set(sizeof(ChargedString) + buffer->text.capacity());
+    text_ = std::shared_ptr<const std::string>(buffer, &buffer->text);
+}
+
+size_t ct_composite_bytes(const CTComposite& composite) {
+    return sizeof(CTComposite) +
+           composite.fields.size() * sizeof(std::pair<const std::string, CTValue>);
+}
+
+void ct_note_composite(CTComposite& composite) {
+    const size_t bytes = ct_composite_bytes(composite);
+    allocated_bytes += bytes;
+    composite.charge.set(bytes);
+}
+
+size_t CTArray::lane_bytes() const {
+    return bytes_.capacity() +
+           words_.capacity() * sizeof(uint64_t) +
+           generic_.capacity() * sizeof(CTValue) +
+           uninitialized_.capacity() / 8;
+}
+
+CTArray::GrowthNote::~GrowthNote() {
+    const size_t after = array.lane_bytes();
+    if (after > before) {
+        allocated_bytes += after - before;
+    }
+    array.charge_.set(sizeof(CTArray) + after);
+}
+
 bool ctvalue_is_exact_int(const CTValue& value) {
     return std::holds_alternative<CTExactInt>(value);
 }
@@ -51,6 +149,7 @@ CTValue ctvalue_from_exact_int(const APInt& value, bool is_unsigned) {
     CTExactInt exact;
     exact.value = value;
     exact.is_unsigned = is_unsigned;
+    exact.charge.set(exact.value.heap_bytes());
     return exact;
 }
 
@@ -102,6 +201,306 @@ bool ctvalue_to_u64_exact(const CTValue& value, uint64_t& out) {
     return false;
 }
 
+CTArray::Storage CTArray::lane_for(const CTValue& value) {
+    if (std::holds_alternative<uint64_t>(value)) {
+        return std::get<uint64_t>(value) <= 0xFFu ? Storage::Bytes : Storage::UInt64;
+    }
+    if (std::holds_alternative<bool>(value)) return Storage::Bool;
+    if (std::holds_alternative<int64_t>(value)) return Storage::Int64;
+    if (std::holds_alternative<double>(value)) return Storage::Float64;
+    if (std::holds_alternative<CTUninitialized>(value)) return Storage::Unset;
+    return Storage::Generic;
+}
+
+bool CTArray::fits_lane(const CTValue& value) const {
+    switch (storage_) {
+        case Storage::Unset:
+            return false;
+        case Storage::Bytes:
+            return std::holds_alternative<uint64_t>(value) && std::get<uint64_t>(value) <= 0xFFu;
+        case Storage::Bool:
+            return std::holds_alternative<bool>(value);
+        case Storage::UInt64:
+            return std::holds_alternative<uint64_t>(value);
+        case Storage::Int64:
+            return std::holds_alternative<int64_t>(value);
+        case Storage::Float64:
+            return std::holds_alternative<double>(value);
+        case Storage::Generic:
+            return true;
+        case Storage::Range:
+            return false;
+    }
+    return false;
+}
+
+void CTArray::store_packed(size_t index, const CTValue& value) {
+    switch (storage_) {
+        case Storage::Bytes:
+            bytes_[index] = static_cast<uint8_t>(std::get<uint64_t>(value));
+            break;
+        case Storage::Bool:
+            bytes_[index] = std::get<bool>(value) ? 1 : 0;
+            break;
+        case Storage::UInt64:
+            words_[index] = std::get<uint64_t>(value);
+            break;
+        case Storage::Int64:
+            words_[index] = static_cast<uint64_t>(std::get<int64_t>(value));
+            break;
+        case Storage::Float64: {
+            double dv = std::get<double>(value);
+            std::memcpy(&words_[index], &dv, sizeof(dv));
+            break;
+        }
+        case Storage::Unset:
+        case Storage::Generic:
+        case Storage::Range:
+            break;
+    }
+}
+
+CTArray CTArray::range(int64_t start, int64_t step, size_t count) {
+    CTArray array;
+    array.storage_ = Storage::Range;
+    array.size_ = count;
+    array.range_start_ = start;
+    array.range_step_ = step;
+    return array;
+}
+
+void CTArray::materialize_range() {
+    if (storage_ != Storage::Range) return;
+    words_.reserve(std::max(size_, reserve_hint_));
+    for (size_t i = 0; i < size_; ++i) {
+        words_.push_back(static_cast<uint64_t>(std::get<int64_t>(at(i))));
+    }
+    storage_ = Storage::Int64;
+}
+
+void CTArray::widen_to(Storage target) {
+    materialize_range();
+    if (target == storage_) return;
+    if (target == Storage::Generic) {
+        std::vector<CTValue> generic;
+        generic.reserve(std::max(size_, reserve_hint_));
+        for (size_t i = 0; i < size_; ++i) {
+            generic.push_back(at(i));
+        }
+        generic_ = std::move(generic);
+        bytes_ = std::vector<uint8_t>();
+        words_ = std::vector<uint64_t>();
+        uninitialized_ = std::vector<bool>();
+        uninitialized_count_ = 0;
+    } else if (storage_ == Storage::Unset) {
+        if (target == Storage::Bytes || target == Storage::Bool) {
+            bytes_.reserve(std::max(size_, reserve_hint_));
+            bytes_.assign(size_, 0);
+        } else {
+            words_.reserve(std::max(size_, reserve_hint_));
+            words_.assign(size_, 0);
+        }
+        if (size_ > 0) {
+            uninitialized_.assign(size_, true);
+            uninitialized_count_ = size_;
+        }
+    } else {
+        // Only Bytes -> UInt64 widens between packed lanes.
+        words_.reserve(std::max(size_, reserve_hint_));
+        words_.assign(bytes_.begin(), bytes_.end());
+        bytes_ = std::vector<uint8_t>();
+    }
+    storage_ = target;
+}
+
+void CTArray::mark_initialized(size_t index) {
+    if (uninitialized_.empty() || !uninitialized_[index]) return;
+    uninitialized_[index] = false;
+    if (--uninitialized_count_ == 0) {
+        uninitialized_ = std::vector<bool>();
+    }
+}
+
+void CTArray::reserve(size_t count) {
+    GrowthNote note(*this);
+    materialize_range();
+    reserve_hint_ = count;
+    switch (storage_) {
+        case Storage::Bytes:
+        case Storage::Bool:
+            bytes_.reserve(count);
+            break;
+        case Storage::UInt64:
+        case Storage::Int64:
+        case Storage::Float64:
+            words_.reserve(count);
+            break;
+        case Storage::Generic:
+            generic_.reserve(count);
+            break;
+        case Storage::Unset:
+        case Storage::Range:
+            break;
+    }
+}
+
+void CTArray::push_back(const CTValue& value) {
+    GrowthNote note(*this);
+    materialize_range();
+    const bool uninit = std::holds_alternative<CTUninitialized>(value);
+    if (storage_ == Storage::Unset) {
+        if (uninit) {
+            size_++;
+            return;
+        }
+        widen_to(lane_for(value));
+    } else if (!uninit && !fits_lane(value)) {
+        widen_to(storage_ == Storage::Bytes && std::holds_alternative<uint64_t>(value)
+                     ? Storage::UInt64
+                     : Storage::Generic);
+    }
+    if (storage_ == Storage::Generic) {
+        generic_.push_back(value);
+        size_++;
+        return;
+    }
+    if (storage_ == Storage::Bytes || storage_ == Storage::Bool) {
+        bytes_.push_back(0);
+    } else {
+        words_.push_back(0);
+    }
+    size_++;
+    if (uninit) {
+        if (uninitialized_.empty()) {
+            uninitialized_.assign(size_ - 1, false);
+        }
+        uninitialized_.push_back(true);
+        uninitialized_count_++;
+        return;
+    }
+    if (!uninitialized_.empty()) {
+        uninitialized_.push_back(false);
+    }
+    store_packed(size_ - 1, value);
+}
+
+CTValue CTArray::at(size_t index) const {
+    if (storage_ == Storage::Generic) return generic_[index];
+    if (storage_ == Storage::Range) {
+        return static_cast<int64_t>(static_cast<uint64_t>(range_start_) +
+                                    static_cast<uint64_t>(range_step_) * static_cast<uint64_t>(index));
+    }
+    if (storage_ == Storage::Unset) return CTUninitialized{};
+    if (!uninitialized_.empty() && uninitialized_[index]) return CTUninitialized{};
+    switch (storage_) {
+        case Storage::Bytes:
+            return static_cast<uint64_t>(bytes_[index]);
+        case Storage::Bool:
+            return bytes_[index] != 0;
+        case Storage::UInt64:
+            return words_[index];
+        case Storage::Int64:
+            return static_cast<int64_t>(words_[index]);
+        case Storage::Float64: {
+            double dv = 0.0;
+            std::memcpy(&dv, &words_[index], sizeof(dv));
+            return dv;
+        }
+        case Storage::Unset:
+        case Storage::Generic:
+        case Storage::Range:
+            break;
+    }
+    return CTUninitialized{};
+}
+
+bool CTArray::is_uninitialized(size_t index) const {
+    if (storage_ == Storage::Generic) return std::holds_alternative<CTUninitialized>(generic_[index]);
+    if (storage_ == Storage::Unset) return true;
+    if (storage_ == Storage::Range) return false;
+    return !uninitialized_.empty() && uninitialized_[index];
+}
+
+void CTArray::set(size_t index, const CTValue& value) {
+    GrowthNote note(*this);
+    materialize_range();
+    if (std::holds_alternative<CTUninitialized>(value)) {
+        if (storage_ == Storage::Unset) return;
+        if (storage_ == Storage::Generic) {
+            generic_[index] = value;
+            return;
+        }
+        if (uninitialized_.empty()) {
+            uninitialized_.assign(size_, false);
+        }
+        if (!uninitialized_[index]) {
+            uninitialized_[index] = true;
+            uninitialized_count_++;
+        }
+        return;
+    }
+    if (storage_ == Storage::Unset) {
+        widen_to(lane_for(value));
+    } else if (!fits_lane(value)) {
+        widen_to(storage_ == Storage::Bytes && std::holds_alternative<uint64_t>(value)
+                     ? Storage::UInt64
+                     : Storage::Generic);
+    }
+    if (storage_ == Storage::Generic) {
+        generic_[index] = value;
+        return;
+    }
+    store_packed(index, value);
+    mark_initialized(index);
+}
+
+CTValue& CTArray::generic_slot(size_t index) {
+    GrowthNote note(*this);
+    widen_to(Storage::Generic);
+    return generic_[index];
+}
+
+bool CTArray::compare_packed(const CTArray& other, bool& equal) const {
+    if (storage_ != other.storage_) return false;
+    switch (storage_) {
+        case Storage::Bytes:
+        case Storage::Bool:
+            equal = bytes_ == other.bytes_ && uninitialized_ == other.uninitialized_;
+            return true;
+        case Storage::UInt64:
+        case Storage::Int64:
+            equal = words_ == other.words_ && uninitialized_ == other.uninitialized_;
+            return true;
+        case Storage::Unset:
+            equal = size_ == other.size_;
+            return true;
+        case Storage::Range:
+            equal = size_ == other.size_ && range_start_ == other.range_start_ &&
+                    range_step_ == other.range_step_;
+            return true;
+        case Storage::Float64:
+        case Storage::Generic:
+            return false;
+    }
+    return false;
+}
+
+CTComposite& ct_mutable_composite(std::shared_ptr<CTComposite>& slot) {
+    if (slot.use_count() != 1) {
+        slot = std::make_shared<CTComposite>(*slot);
+        ct_note_composite(*slot);
+    }
+    return *slot;
+}
+
+CTArray& ct_mutable_array(std::shared_ptr<CTArray>& slot) {
+    if (slot.use_count() != 1) {
+        slot = std::make_shared<CTArray>(*slot);
+        allocated_bytes += sizeof(CTArray) + slot->lane_bytes();
+    }
+    return *slot;
+}
+
 CTValue clone_ct_value(const CTValue& value) {
     if (std::holds_alternative<CTNoValue>(value)) {
         return CTNoValue{};
@@ -119,6 +518,7 @@ CTValue clone_ct_value(const CTValue& value) {
         for (const auto& entry : src->fields) {
             dst->fields[entry.first] = clone_ct_value(entry.second);
         }
+        ct_note_composite(*dst);
         return dst;
     }
     if (std::holds_alternative<std::shared_ptr<CTArray>>(value)) {
@@ -126,10 +526,17 @@ CTValue clone_ct_value(const CTValue& value) {
         if (!src) {
             return std::shared_ptr<CTArray>();
         }
+        if (src->storage() != CTArray::Storage::Generic) {
+            // Packed lanes hold no nested storage.
+            auto dst = std::make_shared<CTArray>(*src);
+            allocated_bytes += sizeof(CTArray) + dst->lane_bytes();
+            return dst;
+        }
         auto dst = std::make_shared<CTArray>();
-        dst->elements.reserve(src->elements.size());
-        for (const auto& elem : src->elements) {
-            dst->elements.push_back(clone_ct_value(elem));
+        allocated_bytes += sizeof(CTArray);
+        dst->reserve(src->size());
+        for (const auto& elem : src->generic_lane()) {
+            dst->push_back(clone_ct_value(elem));
         }
         return dst;
     }
@@ -15,9 +15,56 @@ struct CTComposite;
 struct CTArray;
 struct CTNoValue {};
 struct CTUninitialized {};
+
+// Bytes a compile-time value's storage holds against ct_live_bytes(), given
+// back when the holder is destroyed. A copy charges what its source does;
+// a move hands the charge over.
+class CTMemoryCharge {
+public:
+    CTMemoryCharge() = default;
+    CTMemoryCharge(const CTMemoryCharge& other) { set(other.bytes_); }
+    CTMemoryCharge(CTMemoryCharge&& other) noexcept : bytes_(other.bytes_) { other.bytes_ = 0; }
+    CTMemoryCharge& operator=(const CTMemoryCharge& other) {
+        set(other.bytes_);
+        return *this;
+    }
+    CTMemoryCharge& operator=(CTMemoryCharge&& other) noexcept;
+    ~CTMemoryCharge() { set(0); }
+
+    // Re-charges the holder at `bytes`.
+    void set(size_t bytes);
+    size_t bytes() const { return bytes_; }
+
+private:
+    size_t bytes_ = 0;
+};
+
 struct CTExactInt {
     APInt value = APInt(uint64_t(0));
     bool is_unsigned = false;
+    // Limbs of values wider than APInt's inline storage.
+    CTMemoryCharge charge;
+};
+
+// Compile-time strings are immutable, so copies share one buffer. Values are
+// copied into environments, argument lists and memo tables; an embedded
+// resource would otherwise be duplicated at each step of a loop reading it.
+class CTString {
+public:
+    CTString();
+    CTString(std::string text);
+
+    const std::string& str() const { return *text_; }
+    size_t size() const { return text_->size(); }
+
+    friend bool operator==(const CTString& a, const CTString& b) {
+        return a.text_ == b.text_ || *a.text_ == *b.text_;
+    }
+    friend bool operator!=(const CTString& a, const CTString& b) { return !(a == b); }
+    friend bool operator<(const CTString& a, const CTString& b) { return *a.text_ < *b.text_; }
+
+private:
+    std::shared_ptr<const std::string> text_;
 };
 
 using CTValue = std::variant<int64_t,
@@ -25,7 +72,7 @@ using CTValue = std::variant<int64_t,
                              CTExactInt,
                              double,
                              bool,
-                             std::string,
+                             CTString,
                              CTNoValue,
                              CTUninitialized,
                              std::shared_ptr<CTComposite>,
@@ -34,10 +81,84 @@ using CTValue = std::variant<int64_t,
 struct CTComposite {
     std::string type_name;
     std::unordered_map<std::string, CTValue> fields;
+    // Set by ct_note_composite once the fields are in place.
+    CTMemoryCharge charge;
 };
 
-struct CTArray {
-    std::vector<CTValue> elements;
+// Compile-time array storage. Homogeneous scalar payloads stay packed in one
+// machine word (or one byte for bools and small unsigned values) per element;
+// the first element that does not fit the current lane widens the storage,
+// ultimately to generic CTValue elements. Element alternatives round-trip
+// exactly: at(i) returns what was stored at i.
+//
+// A range (`a..b`) is held lazily as its start and direction: its int64_t
+// elements are computed by at(), and the first mutation materializes them
+// into the Int64 lane.
+class CTArray {
+public:
+    enum class Storage { Unset, Bytes, Bool, UInt64, Int64, Float64, Generic, Range };
+
+    CTArray() = default;
+    // `count` elements start, start + step, ...; step is 1 or -1.
+    static CTArray range(int64_t start, int64_t step, size_t count);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void reserve(size_t count);
+    void push_back(const CTValue& value);
+
+    CTValue at(size_t index) const;
+    bool is_uninitialized(size_t index) const;
+    void set(size_t index, const CTValue& value);
+
+    // Element slot for in-place nested mutation; widens storage to Generic.
+    CTValue& generic_slot(size_t index);
+
+    Storage storage() const { return storage_; }
+    // Range storage only.
+    int64_t range_start() const { return range_start_; }
+    int64_t range_step() const { return range_step_; }
+    // Packed lanes only; generic elements hold CTUninitialized themselves.
+    bool has_uninitialized() const { return uninitialized_count_ != 0; }
+    // Lane views, valid for the matching storage kinds.
+    const std::vector<uint8_t>& byte_lane() const { return bytes_; }
+    const std::vector<uint64_t>& word_lane() const { return words_; }
+    const std::vector<CTValue>& generic_lane() const { return generic_; }
+    // Compares lane-wise when both arrays use the same integer or bool lane.
+    // Returns false (undecided) otherwise; callers fall back to element-wise.
+    bool compare_packed(const CTArray& other, bool& equal) const;
+    // Heap bytes reserved by the lanes, excluding nested aggregates.
+    size_t lane_bytes() const;
+
+private:
+    // Reports lane capacity growth of one mutation to ct_note_allocation and
+    // re-charges the array at its new lane size.
+    struct GrowthNote {
+        CTArray& array;
+        size_t before;
+        explicit GrowthNote(CTArray& a) : array(a), before(a.lane_bytes()) {}
+        ~GrowthNote();
+    };
+
+    static Storage lane_for(const CTValue& value);
+    bool fits_lane(const CTValue& value) const;
+    void store_packed(size_t index, const CTValue& value);
+    void widen_to(Storage target);
+    void mark_initialized(size_t index);
+    void materialize_range();
+
+    Storage storage_ = Storage::Unset;
+    size_t size_ = 0;
+    size_t reserve_hint_ = 0;
+    int64_t range_start_ = 0;
+    int64_t range_step_ = 1;
+    std::vector<uint8_t> bytes_;
+    std::vector<uint64_t> words_;
+    std::vector<CTValue> generic_;
+    // Packed lanes only; empty when every element is initialized.
+    std::vector<bool> uninitialized_;
+    size_t uninitialized_count_ = 0;
+    CTMemoryCharge charge_;
 };
 
 enum class CTEQueryStatus {
@@ -50,6 +171,10 @@ struct CTEQueryResult {
     CTEQueryStatus status = CTEQueryStatus::Unknown;
     CTValue value = static_cast<int64_t>(0);
     std::string message;
+    // Unknown because the query ran out of evaluation steps.
+    bool budget_exhausted = false;
+    // Unknown because the query's live values outgrew the memory limit.
+    bool memory_exhausted = false;
 };
 
 inline CTValue copy_ct_value(const CTValue& value) {
@@ -63,6 +188,35 @@ CTValue ctvalue_from_exact_int(const APInt& value, bool is_unsigned);
 bool ctvalue_to_i64_exact(const CTValue& value, int64_t& out);
 bool ctvalue_to_u64_exact(const CTValue& value, uint64_t& out);
 
+// Aggregates are copy-on-write: CTValue copies share CTComposite/CTArray
+// storage, and storage is only mutated in place through a slot that owns it
+// exclusively. Writers call these before mutating; a shared aggregate is
+// replaced in the slot by a one-level copy whose children stay shared.
+CTComposite& ct_mutable_composite(std::shared_ptr<CTComposite>& slot);
+CTArray& ct_mutable_array(std::shared_ptr<CTArray>& slot);
+
+// Running total of aggregate bytes allocated on this thread: array lane
+// growth, copy-on-write and deep copies, composites the evaluator notes when
+// it builds them, and new string buffers. Profilers diff two readings.
+uint64_t ct_allocated_bytes();
+void ct_note_allocation(size_t bytes);
+size_t ct_composite_bytes(const CTComposite& composite);
+// Notes a freshly built composite's allocation and charges it.
+void ct_note_composite(CTComposite& composite);
+
+// Bytes of compile-time value storage alive on this thread: array lanes,
+// composites, string buffers and wide-integer limbs, each charged by the
+// value holding it (see CTMemoryCharge). Storage released on another thread
+// than the one that charged it is given back there, so a single thread's
+// reading is only meaningful as the difference of two readings.
+int64_t ct_live_bytes();
+// Highest ct_live_bytes() since the last reset. A reset returns the previous
+// peak so a nested measurement can fold it back in with restore.
+int64_t ct_reset_peak_live_bytes();
+void ct_restore_peak_live_bytes(int64_t outer_peak);
+int64_t ct_peak_live_bytes();
+
+// Deep copy; only needed when a value must not share storage at any depth.
 CTValue clone_ct_value(const CTValue& value);
 
 } // namespace vexel
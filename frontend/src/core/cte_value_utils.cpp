@@ -34,4 +34,23 @@ std::optional<bool> cte_scalar_to_bool(const CTValue& value) {
     return out;
 }
 
+const CTArray* cte_packed_table(const CTValue& value) {
+    if (!std::holds_alternative<std::shared_ptr<CTArray>>(value)) return nullptr;
+    const CTArray* array = std::get<std::shared_ptr<CTArray>>(value).get();
+    if (!array || array->size() < kPackedTableMinElements) return nullptr;
+    switch (array->storage()) {
+        case CTArray::Storage::Bytes:
+        case CTArray::Storage::Bool:
+        case CTArray::Storage::UInt64:
+        case CTArray::Storage::Int64:
+        case CTArray::Storage::Float64:
+        case CTArray::Storage::Range:
+            break;
+        default:
+            return nullptr;
+    }
+    if (array->has_uninitialized()) return nullptr;
+    return array;
+}
+
 } // namespace vexel
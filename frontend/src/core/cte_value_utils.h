@@ -9,4 +9,12 @@ namespace vexel {
 bool cte_scalar_to_bool(const CTValue& value, bool& out);
 std::optional<bool> cte_scalar_to_bool(const CTValue& value);
 
+// Arrays with at least this many elements in one packed scalar lane are kept
+// as their CTArray from folding to emission instead of one literal per element.
+constexpr size_t kPackedTableMinElements = 256;
+
+// The array `value` holds when it is a fully initialized packed table of at
+// least kPackedTableMinElements scalars; null otherwise.
+const CTArray* cte_packed_table(const CTValue& value);
+
 } // namespace vexel
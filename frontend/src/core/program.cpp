@@ -2,6 +2,55 @@
 
 namespace vexel {
 
+void ModuleDeclarations::add(Symbol::Kind kind, const std::string& name, const std::string& surface_name) {
+    const size_t index = entries.size();
+    entries.push_back({kind, name, surface_name});
+    by_name[name] = index;
+    switch (kind) {
+        case Symbol::Kind::Function: {
+            auto it = overload_index_.find(surface_name);
+            if (it == overload_index_.end()) {
+                overload_index_[surface_name] = function_overloads.size();
+                function_overloads.push_back({surface_name, {index}});
+            } else {
+                function_overloads[it->second].second.push_back(index);
+            }
+            break;
+        }
+        case Symbol::Kind::Type:
+            type_index_[name] = types.size();
+            types.emplace_back(name, index);
+            break;
+        case Symbol::Kind::Variable:
+        case Symbol::Kind::Constant:
+            value_index_[name] = values.size();
+            values.emplace_back(name, index);
+            break;
+    }
+}
+
+const std::vector<size_t>* ModuleDeclarations::overloads(const std::string& surface_name) const {
+    auto it = overload_index_.find(surface_name);
+    return it == overload_index_.end() ? nullptr : &function_overloads[it->second].second;
+}
+
+bool ModuleDeclarations::has_value(const std::string& name) const {
+    return value_index_.count(name) != 0;
+}
+
+bool ModuleDeclarations::has_type(const std::string& name) const {
+    return type_index_.count(name) != 0;
+}
+
+Symbol* ModuleInstance::symbol(const std::string& name) const {
+    if (declarations) {
+        auto it = declarations->by_name.find(name);
+        if (it != declarations->by_name.end()) return declared[it->second];
+    }
+    auto it = generated.find(name);
+    return it == generated.end() ? nullptr : it->second;
+}
+
 ModuleInfo* Program::module(ModuleId id) {
     if (id < 0 || static_cast<size_t>(id) >= modules.size()) return nullptr;
     return &modules[static_cast<size_t>(id)];
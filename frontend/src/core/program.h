@@ -16,21 +16,65 @@ enum class ModuleOrigin {
     BundledStd,
 };
 
+// Top-level declarations of one module, laid out once and shared by every
+// instance of it. Entries follow the module's declaring statements in source
+// order; an instance keeps the Symbol it created for each entry at the same
+// position. Immutable once built.
+struct ModuleDeclarations {
+    struct Entry {
+        Symbol::Kind kind;
+        std::string name;          // Internal name (overloads are disambiguated)
+        std::string surface_name;  // Name importers see
+    };
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> by_name;  // Internal name -> entry
+    // Importable names in declaration order.
+    std::vector<std::pair<std::string, size_t>> values;
+    std::vector<std::pair<std::string, size_t>> types;
+    std::vector<std::pair<std::string, std::vector<size_t>>> function_overloads;
+
+    // Appends an entry and indexes it; the caller has checked for clashes.
+    void add(Symbol::Kind kind, const std::string& name, const std::string& surface_name);
+    const std::vector<size_t>* overloads(const std::string& surface_name) const;
+    bool has_value(const std::string& name) const;
+    bool has_type(const std::string& name) const;
+
+private:
+    std::unordered_map<std::string, size_t> value_index_;
+    std::unordered_map<std::string, size_t> type_index_;
+    std::unordered_map<std::string, size_t> overload_index_;
+};
+
 struct ModuleInfo {
     ModuleId id = -1;
     std::string path;
     ModuleOrigin origin = ModuleOrigin::Project;
     Module module;
+    // Built by the resolver when the module is first instantiated.
+    std::shared_ptr<const ModuleDeclarations> declarations;
 };
 
+// Only per-instance state lives here: the scope, the symbols the instance
+// created for its module's shared declarations, and functions generic
+// instantiation added to it later.
 struct ModuleInstance {
     ModuleInstanceId id = -1;
     ModuleId module_id = -1;
     int scope_id = -1;
-    std::unordered_map<std::string, Symbol*> symbols;
-    std::unordered_map<std::string, Symbol*> value_symbols;
-    std::unordered_map<std::string, Symbol*> type_symbols;
-    std::unordered_map<std::string, std::vector<Symbol*>> function_overloads;
+    std::shared_ptr<const ModuleDeclarations> declarations;
+    std::vector<Symbol*> declared;  // Parallel to declarations->entries
+    std::unordered_map<std::string, Symbol*> generated;
+    std::vector<ModuleInstanceId> imports;  // Instances created by this instance's imports
+
+    // Symbol under an internal name, declared or generated.
+    Symbol* symbol(const std::string& name) const;
+
+    template <typename Fn>
+    void for_each_symbol(Fn&& fn) const {
+        for (Symbol* sym : declared) fn(sym);
+        for (const auto& entry : generated) fn(entry.second);
+    }
 };
 
 struct Program {
@@ -38,6 +82,8 @@ struct Program {
     std::unordered_map<std::string, ModuleId> path_to_id;
     std::vector<ModuleInstance> instances;
     std::vector<std::unique_ptr<Symbol>> symbols;
+    // Backing store for AST nodes built while loading and analyzing this program.
+    std::shared_ptr<AstArena> ast_arena = std::make_shared<AstArena>();
 
     ModuleInfo* module(ModuleId id);
     const ModuleInfo* module(ModuleId id) const;
@@ -0,0 +1,114 @@
+#pragma once
+#include "symbols.h"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace vexel {
+
+// Set of symbols keyed by Symbol::id. Membership is a bit test; iteration
+// visits members in insertion order.
+class SymbolSet {
+public:
+    using const_iterator = std::vector<const Symbol*>::const_iterator;
+
+    // Returns true when `sym` was not already a member.
+    bool insert(const Symbol* sym) {
+        const size_t id = static_cast<size_t>(sym->id);
+        const size_t word = id / 64;
+        const uint64_t bit = uint64_t(1) << (id % 64);
+        if (word >= bits_.size()) bits_.resize(word + 1, 0);
+        if (bits_[word] & bit) return false;
+        bits_[word] |= bit;
+        members_.push_back(sym);
+        return true;
+    }
+
+    size_t count(const Symbol* sym) const {
+        if (!sym || sym->id < 0) return 0;
+        const size_t id = static_cast<size_t>(sym->id);
+        const size_t word = id / 64;
+        return (word < bits_.size() && ((bits_[word] >> (id % 64)) & 1)) ? 1 : 0;
+    }
+
+    void clear() {
+        bits_.clear();
+        members_.clear();
+    }
+
+    bool empty() const { return members_.empty(); }
+    size_t size() const { return members_.size(); }
+    const_iterator begin() const { return members_.begin(); }
+    const_iterator end() const { return members_.end(); }
+
+private:
+    std::vector<uint64_t> bits_;
+    std::vector<const Symbol*> members_;
+};
+
+// Map from symbols to T keyed by Symbol::id: a flat slot array indexes a
+// dense entry vector. Entries iterate in insertion order as (symbol, value)
+// pairs. Inserting may move entries, so references into the map do not
+// survive operator[] on a new key.
+template <typename T>
+class SymbolMap {
+public:
+    using value_type = std::pair<const Symbol*, T>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    T& operator[](const Symbol* sym) {
+        const size_t id = static_cast<size_t>(sym->id);
+        if (id >= slots_.size()) slots_.resize(id + 1, kNoSlot);
+        if (slots_[id] == kNoSlot) {
+            slots_[id] = static_cast<uint32_t>(entries_.size());
+            entries_.emplace_back(sym, T{});
+        }
+        return entries_[slots_[id]].second;
+    }
+
+    iterator find(const Symbol* sym) {
+        const uint32_t slot = slot_of(sym);
+        return slot == kNoSlot ? entries_.end() : entries_.begin() + slot;
+    }
+
+    const_iterator find(const Symbol* sym) const {
+        const uint32_t slot = slot_of(sym);
+        return slot == kNoSlot ? entries_.end() : entries_.begin() + slot;
+    }
+
+    const T& at(const Symbol* sym) const {
+        const uint32_t slot = slot_of(sym);
+        if (slot == kNoSlot) throw std::out_of_range("SymbolMap::at");
+        return entries_[slot].second;
+    }
+
+    size_t count(const Symbol* sym) const { return slot_of(sym) == kNoSlot ? 0 : 1; }
+
+    void clear() {
+        slots_.clear();
+        entries_.clear();
+    }
+
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+    iterator begin() { return entries_.begin(); }
+    iterator end() { return entries_.end(); }
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.end(); }
+
+private:
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    uint32_t slot_of(const Symbol* sym) const {
+        if (!sym || sym->id < 0) return kNoSlot;
+        const size_t id = static_cast<size_t>(sym->id);
+        return id < slots_.size() ? slots_[id] : kNoSlot;
+    }
+
+    std::vector<uint32_t> slots_;
+    std::vector<value_type> entries_;
+};
+
+} // namespace vexel
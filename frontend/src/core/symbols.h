@@ -1,5 +1,6 @@
 #pragma once
 #include "ast.h"
+#include "atom.h"
 #include <unordered_map>
 #include <unordered_set>
 
@@ -20,93 +21,187 @@ struct Symbol {
     int module_id = -1;
     int instance_id = -1;
     bool is_local = false;
+    int id = -1;  // Dense index into Program::symbols.
 };
 
+// Read-only view of an overload set. A view of a scope's overloads stays
+// valid (and keeps its length) when more overloads are defined later, so
+// callers may keep iterating while type checking instantiates new functions.
+class SymbolSpan {
+public:
+    class iterator {
+    public:
+        iterator(const SymbolSpan* span, size_t index) : span_(span), index_(index) {}
+        Symbol* operator*() const { return (*span_)[index_]; }
+        iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const SymbolSpan* span_;
+        size_t index_;
+    };
+
+    SymbolSpan() = default;
+    SymbolSpan(const std::vector<Symbol*>& list) : list_(&list), size_(list.size()) {}
+    explicit SymbolSpan(Symbol* single) : single_(single), size_(single ? 1 : 0) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Symbol* operator[](size_t index) const { return list_ ? (*list_)[index] : single_; }
+    Symbol* front() const { return (*this)[0]; }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size_); }
+    std::vector<Symbol*> to_vector() const {
+        std::vector<Symbol*> out;
+        out.reserve(size_);
+        for (size_t i = 0; i < size_; ++i) out.push_back((*this)[i]);
+        return out;
+    }
+
+private:
+    const std::vector<Symbol*>* list_ = nullptr;
+    Symbol* single_ = nullptr;
+    size_t size_ = 0;
+};
+
+// One hash table per scope, keyed by identifier atom. An entry carries every
+// namespace a name can occupy: the symbol whose internal name it is, plus the
+// value, type or overload set bound under it as a surface name.
 class Scope {
 public:
+    struct Entry {
+        Symbol* internal = nullptr;
+        Symbol* value = nullptr;
+        Symbol* type = nullptr;
+        std::vector<Symbol*> functions;
+    };
+
     Scope* parent;
-    std::unordered_map<std::string, Symbol*> internal_symbols;
-    std::unordered_map<std::string, Symbol*> value_symbols;
-    std::unordered_map<std::string, Symbol*> type_symbols;
-    std::unordered_map<std::string, std::vector<Symbol*>> function_overloads;
     int id;
 
     Scope(Scope* p = nullptr, int scope_id = 0) : parent(p), id(scope_id) {}
 
-    Symbol* lookup(const std::string& name) {
-        if (Symbol* sym = lookup_internal(name)) return sym;
-        if (Symbol* sym = lookup_value(name)) return sym;
-        if (Symbol* sym = lookup_type(name)) return sym;
-        std::vector<Symbol*> overloads = lookup_functions(name);
-        if (overloads.size() == 1) return overloads.front();
+    // Resolution order is internal names, then values, then types, then a
+    // unique overload, each across the whole parent chain. One walk suffices:
+    // the nearest internal name wins outright, the rest are remembered.
+    Symbol* lookup(const std::string& name) const {
+        const Atom atom = find_atom(name);
+        if (atom == kNoAtom) return nullptr;
+        Symbol* value = nullptr;
+        Symbol* type = nullptr;
+        SymbolSpan functions;
+        bool functions_found = false;
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            const Entry* entry = scope->find_entry(atom);
+            if (!entry) continue;
+            if (entry->internal) return entry->internal;
+            if (!value) value = entry->value;
+            if (!type) type = entry->type;
+            if (!functions_found && (entry->value || !entry->functions.empty())) {
+                if (!entry->value) functions = entry->functions;
+                functions_found = true;
+            }
+        }
+        if (value) return value;
+        if (type) return type;
+        if (functions.size() == 1) return functions.front();
         return nullptr;
     }
 
-    Symbol* lookup_internal(const std::string& name) {
-        auto it = internal_symbols.find(name);
-        if (it != internal_symbols.end()) return it->second;
-        if (parent) return parent->lookup_internal(name);
+    Symbol* lookup_internal(const std::string& name) const {
+        const Atom atom = find_atom(name);
+        if (atom == kNoAtom) return nullptr;
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            const Entry* entry = scope->find_entry(atom);
+            if (entry && entry->internal) return entry->internal;
+        }
         return nullptr;
     }
 
-    Symbol* lookup_value(const std::string& name) {
-        auto it = value_symbols.find(name);
-        if (it != value_symbols.end()) return it->second;
-        if (parent) return parent->lookup_value(name);
+    Symbol* lookup_value(const std::string& name) const {
+        const Atom atom = find_atom(name);
+        if (atom == kNoAtom) return nullptr;
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            const Entry* entry = scope->find_entry(atom);
+            if (entry && entry->value) return entry->value;
+        }
         return nullptr;
     }
 
-    Symbol* lookup_type(const std::string& name) {
-        auto it = type_symbols.find(name);
-        if (it != type_symbols.end()) return it->second;
-        if (parent) return parent->lookup_type(name);
+    Symbol* lookup_type(const std::string& name) const {
+        const Atom atom = find_atom(name);
+        if (atom == kNoAtom) return nullptr;
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            const Entry* entry = scope->find_entry(atom);
+            if (entry && entry->type) return entry->type;
+        }
         return nullptr;
     }
 
-    std::vector<Symbol*> lookup_functions(const std::string& name) {
-        if (value_symbols.count(name) > 0) {
-            return {};
+    // Nearest overload set; a value of the same name in a nearer scope hides it.
+    SymbolSpan lookup_functions(const std::string& name) const {
+        const Atom atom = find_atom(name);
+        if (atom == kNoAtom) return {};
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            const Entry* entry = scope->find_entry(atom);
+            if (!entry) continue;
+            if (entry->value) return {};
+            if (!entry->functions.empty()) return entry->functions;
         }
-        auto it = function_overloads.find(name);
-        if (it != function_overloads.end()) return it->second;
-        if (parent) return parent->lookup_functions(name);
         return {};
     }
 
+    // Calls fn(name, symbol) once per type name visible here, with the symbol
+    // lookup_type would return for it.
+    template <typename Fn>
+    void for_each_visible_type(Fn&& fn) const {
+        std::unordered_set<Atom> seen;
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            for (const auto& entry : scope->entries) {
+                if (entry.second.type && seen.insert(entry.first).second) {
+                    fn(atom_spelling(entry.first), entry.second.type);
+                }
+            }
+        }
+    }
+
+    // Overloads defined in this scope only.
+    SymbolSpan functions_in_current(const std::string& name) const {
+        const Entry* entry = find_entry(find_atom(name));
+        return entry ? SymbolSpan(entry->functions) : SymbolSpan();
+    }
+
     void define_value(const std::string& name, Symbol* sym) {
-        if (value_symbols.count(name) || function_overloads.count(name)) {
+        Entry& entry = entries[intern_atom(name)];
+        if (entry.value || !entry.functions.empty()) {
             throw CompileError("Name already defined: " + name, SourceLocation());
         }
-        auto internal_it = internal_symbols.find(sym->name);
-        if (internal_it != internal_symbols.end() && internal_it->second != sym) {
-            throw CompileError("Name already defined: " + sym->name, SourceLocation());
-        }
-        value_symbols[name] = sym;
-        internal_symbols[sym->name] = sym;
+        Entry& internal = internal_entry_for(sym);
+        entry.value = sym;
+        internal.internal = sym;
     }
 
     void define_type(const std::string& name, Symbol* sym) {
-        if (type_symbols.count(name)) {
+        Entry& entry = entries[intern_atom(name)];
+        if (entry.type) {
             throw CompileError("Name already defined: " + name, SourceLocation());
         }
-        auto internal_it = internal_symbols.find(sym->name);
-        if (internal_it != internal_symbols.end() && internal_it->second != sym) {
-            throw CompileError("Name already defined: " + sym->name, SourceLocation());
-        }
-        type_symbols[name] = sym;
-        internal_symbols[sym->name] = sym;
+        Entry& internal = internal_entry_for(sym);
+        entry.type = sym;
+        internal.internal = sym;
     }
 
     void define_function(const std::string& name, Symbol* sym) {
-        if (value_symbols.count(name)) {
+        Entry& entry = entries[intern_atom(name)];
+        if (entry.value) {
             throw CompileError("Name already defined: " + name, SourceLocation());
         }
-        auto internal_it = internal_symbols.find(sym->name);
-        if (internal_it != internal_symbols.end() && internal_it->second != sym) {
-            throw CompileError("Name already defined: " + sym->name, SourceLocation());
-        }
-        function_overloads[name].push_back(sym);
-        internal_symbols[sym->name] = sym;
+        Entry& internal = internal_entry_for(sym);
+        entry.functions.push_back(sym);
+        internal.internal = sym;
     }
 
     void define(const std::string& name, Symbol* sym) {
@@ -125,39 +220,69 @@ public:
     }
 
     bool exists_value_in_current(const std::string& name) const {
-        return value_symbols.count(name) > 0;
+        const Entry* entry = find_entry(find_atom(name));
+        return entry && entry->value;
     }
 
     bool exists_type_in_current(const std::string& name) const {
-        return type_symbols.count(name) > 0;
+        const Entry* entry = find_entry(find_atom(name));
+        return entry && entry->type;
     }
 
     bool exists_function_in_current(const std::string& name) const {
-        return function_overloads.count(name) > 0;
+        const Entry* entry = find_entry(find_atom(name));
+        return entry && !entry->functions.empty();
     }
 
     bool exists_internal_in_current(const std::string& name) const {
-        return internal_symbols.count(name) > 0;
+        const Entry* entry = find_entry(find_atom(name));
+        return entry && entry->internal;
     }
 
-    bool exists_in_current(const std::string& name) {
-        return exists_value_in_current(name) ||
-               exists_type_in_current(name) ||
-               exists_function_in_current(name) ||
-               exists_internal_in_current(name);
+    bool exists_in_current(const std::string& name) const {
+        const Entry* entry = find_entry(find_atom(name));
+        return entry && (entry->internal || visible(*entry));
     }
 
     bool has_visible_name_in_current(const std::string& name) const {
-        return exists_value_in_current(name) ||
-               exists_type_in_current(name) ||
-               exists_function_in_current(name);
+        const Entry* entry = find_entry(find_atom(name));
+        return entry && visible(*entry);
     }
 
     bool has_any_visible_name(const std::string& name) const {
-        if (has_visible_name_in_current(name)) return true;
-        if (parent) return parent->has_any_visible_name(name);
+        const Atom atom = find_atom(name);
+        if (atom == kNoAtom) return false;
+        for (const Scope* scope = this; scope; scope = scope->parent) {
+            const Entry* entry = scope->find_entry(atom);
+            if (entry && visible(*entry)) return true;
+        }
         return false;
     }
+
+private:
+    static bool visible(const Entry& entry) {
+        return entry.value || entry.type || !entry.functions.empty();
+    }
+
+    const Entry* find_entry(Atom atom) const {
+        if (atom == kNoAtom) return nullptr;
+        auto it = entries.find(atom);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    // Entry under `sym`'s internal name, rejecting a different symbol already
+    // registered there.
+    Entry& internal_entry_for(Symbol* sym) {
+        Entry& entry = entries[intern_atom(sym->name)];
+        if (entry.internal && entry.internal != sym) {
+            throw CompileError("Name already defined: " + sym->name, SourceLocation());
+        }
+        return entry;
+    }
+
+    // Node-based map: entries (and overload vectors viewed by SymbolSpan) keep
+    // their address as the table grows.
+    std::unordered_map<Atom, Entry> entries;
 };
 
 } // namespace vexel
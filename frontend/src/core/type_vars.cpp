@@ -0,0 +1,124 @@
+#include "type_vars.h"
+
+#include "ast.h"
+
+#include <utility>
+
+namespace vexel {
+
+namespace {
+
+const TypePtr kNoType;
+
+} // namespace
+
+void TypeVarTable::ensure(int id) {
+    const size_t needed = static_cast<size_t>(id) + 1;
+    if (parent_.size() >= needed) return;
+    const size_t old_size = parent_.size();
+    parent_.resize(needed);
+    rank_.resize(needed, 0);
+    nodes_.resize(needed);
+    bindings_.resize(needed);
+    representatives_.resize(needed);
+    for (size_t i = old_size; i < needed; ++i) {
+        parent_[i] = static_cast<int>(i);
+        representatives_[i] = static_cast<int>(i);
+    }
+}
+
+void TypeVarTable::add(const TypePtr& var) {
+    if (!var || var->var_id < 0) return;
+    ensure(var->var_id);
+    nodes_[static_cast<size_t>(var->var_id)] = var;
+    touch(var->var_id);
+}
+
+int TypeVarTable::find(int id) {
+    if (id < 0 || static_cast<size_t>(id) >= parent_.size()) return id;
+    int root = id;
+    while (parent_[static_cast<size_t>(root)] != root) {
+        root = parent_[static_cast<size_t>(root)];
+    }
+    while (parent_[static_cast<size_t>(id)] != root) {
+        const int next = parent_[static_cast<size_t>(id)];
+        parent_[static_cast<size_t>(id)] = root;
+        id = next;
+    }
+    return root;
+}
+
+int TypeVarTable::find(int id) const {
+    if (id < 0 || static_cast<size_t>(id) >= parent_.size()) return id;
+    while (parent_[static_cast<size_t>(id)] != id) {
+        id = parent_[static_cast<size_t>(id)];
+    }
+    return id;
+}
+
+const TypePtr& TypeVarTable::binding(int id) const {
+    if (id < 0 || static_cast<size_t>(id) >= parent_.size()) return kNoType;
+    return bindings_[static_cast<size_t>(find(id))];
+}
+
+const TypePtr& TypeVarTable::representative(int id) const {
+    return node(representative_id(id));
+}
+
+int TypeVarTable::representative_id(int id) const {
+    if (id < 0 || static_cast<size_t>(id) >= parent_.size()) return id;
+    return representatives_[static_cast<size_t>(find(id))];
+}
+
+const TypePtr& TypeVarTable::node(int id) const {
+    if (id < 0 || static_cast<size_t>(id) >= nodes_.size()) return kNoType;
+    return nodes_[static_cast<size_t>(id)];
+}
+
+void TypeVarTable::bind(int id, TypePtr target) {
+    if (id < 0) return;
+    ensure(id);
+    bindings_[static_cast<size_t>(find(id))] = std::move(target);
+    touch(id);
+}
+
+void TypeVarTable::unite(int var, int target) {
+    if (var < 0 || target < 0) return;
+    ensure(var > target ? var : target);
+    size_t a = static_cast<size_t>(find(var));
+    size_t b = static_cast<size_t>(find(target));
+    if (a == b) return;
+    TypePtr bound = bindings_[b] ? std::move(bindings_[b]) : std::move(bindings_[a]);
+    const int representative = representatives_[b];
+    bindings_[a].reset();
+    bindings_[b].reset();
+    if (rank_[a] > rank_[b]) std::swap(a, b);
+    parent_[a] = static_cast<int>(b);
+    if (rank_[a] == rank_[b]) ++rank_[b];
+    bindings_[b] = std::move(bound);
+    representatives_[b] = representative;
+    touch(var);
+    touch(target);
+}
+
+void TypeVarTable::start_tracking() {
+    touched_.clear();
+    tracking_ = true;
+}
+
+void TypeVarTable::merge(const TypeVarTable& other) {
+    for (int id : other.touched_) {
+        const TypePtr& node = other.nodes_[static_cast<size_t>(id)];
+        if (!node) continue;
+        ensure(id);
+        if (!nodes_[static_cast<size_t>(id)]) nodes_[static_cast<size_t>(id)] = node;
+    }
+    for (int id : other.touched_) {
+        const int spelled_by = other.representatives_[static_cast<size_t>(other.find(id))];
+        unite(id, spelled_by);
+        representatives_[static_cast<size_t>(find(id))] = spelled_by;
+        if (const TypePtr& bound = other.binding(id)) bind(id, bound);
+    }
+}
+
+} // namespace vexel
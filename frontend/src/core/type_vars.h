@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace vexel {
+
+struct Type;
+using TypePtr = std::shared_ptr<Type>;
+
+// Type-variable equivalence classes for inference: a union-find over the
+// integer ids of TypeVar nodes (union by rank, path compression on writes).
+// A class is either bound to the type it stands for or spelled by one of its
+// variables, its representative. Ids are dense but may be handed out by
+// other checkers sharing the id counter, so the table grows to whatever id
+// it sees.
+class TypeVarTable {
+public:
+    // Registers a fresh TypeVar node as a class of its own.
+    void add(const TypePtr& var);
+
+    // Class of `id`. The const form walks without compressing, so frozen
+    // tables can be read concurrently.
+    int find(int id);
+    int find(int id) const;
+    bool same_class(int a, int b) const { return find(a) == find(b); }
+
+    // Binding of `id`'s class; null while it is unbound.
+    const TypePtr& binding(int id) const;
+    // The variable an unbound class resolves to; null for unregistered ids.
+    const TypePtr& representative(int id) const;
+    int representative_id(int id) const;
+    // The registered TypeVar node of `id`; null when there is none.
+    const TypePtr& node(int id) const;
+
+    // Binds `id`'s class to a non-variable type, replacing any earlier binding.
+    void bind(int id, TypePtr target);
+    // Merges the classes of `var` and `target`. The merged class is spelled
+    // like `target`'s and keeps its binding, falling back to that of `var`'s.
+    void unite(int var, int target);
+
+    size_t size() const { return parent_.size(); }
+
+    // From here on, record every id this table registers or changes. A worker
+    // copies its parent's table and starts tracking, so merge() can replay
+    // just what the worker decided.
+    void start_tracking();
+    // Replays what `other` decided about each id it tracked, its decisions
+    // winning over this table's.
+    void merge(const TypeVarTable& other);
+
+private:
+    void ensure(int id);
+    void touch(int id) {
+        if (tracking_) touched_.push_back(id);
+    }
+
+    std::vector<int> parent_;
+    std::vector<unsigned char> rank_;
+    std::vector<TypePtr> nodes_;
+    // Indexed by class root.
+    std::vector<TypePtr> bindings_;
+    std::vector<int> representatives_;
+    std::vector<int> touched_;
+    bool tracking_ = false;
+};
+
+} // namespace vexel
@@ -0,0 +1,143 @@
+#include "chunked_parse.h"
+#include "constants.h"
+#include "lexer.h"
+#include <cctype>
+#include <iterator>
+
+namespace vexel {
+
+namespace {
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// A `}` at depth 0 may close a block inside a global's initializer, which the
+// next token could continue; only a declaration start after it ends the item.
+// `&name` is the parser's own cut for initializers (a plain function start); a
+// chunk where it is really a bitwise and fails to parse and falls back.
+bool declaration_follows(std::string_view source, size_t i) {
+    const size_t n = source.size();
+    while (i < n) {
+        if (is_space(source[i])) {
+            ++i;
+        } else if (source[i] == '/' && i + 1 < n && source[i + 1] == '/') {
+            while (i < n && source[i] != '\n') ++i;
+        } else {
+            break;
+        }
+    }
+    if (i >= n) return false;
+    const char c = source[i];
+    const char next = i + 1 < n ? source[i + 1] : '\0';
+    if (c == '&') {
+        return next == '!' || next == '^' || next == '_' || std::isalpha(static_cast<unsigned char>(next));
+    }
+    return c == '#' || (c == ':' && next == ':') || (c == '[' && next == '[');
+}
+
+} // namespace
+
+std::vector<ParseChunk> split_top_level_chunks(std::string_view source, size_t target_bytes) {
+    const size_t n = source.size();
+    std::vector<ParseChunk> chunks;
+    auto whole = [&]() {
+        ParseChunk only;
+        only.end = n;
+        return std::vector<ParseChunk>{only};
+    };
+
+    ParseChunk current;
+    int depth = 0;
+    int line = 1;
+    size_t line_start = 0;
+    size_t next_cut = target_bytes;
+    size_t i = 0;
+    while (i < n) {
+        const char c = source[i];
+        if (c == '\0' || static_cast<unsigned char>(c) > 0x7F) return whole();
+        if (c == '\n') {
+            ++line;
+            line_start = i + 1;
+        } else if (c == '/' && i + 1 < n && source[i + 1] == '/') {
+            while (i < n && source[i] != '\n') ++i;
+            continue;
+        } else if (c == '"') {
+            for (++i; i < n && source[i] != '"'; ++i) {
+                if (source[i] == '\\') ++i;
+                if (i < n && source[i] == '\n') {
+                    ++line;
+                    line_start = i + 1;
+                }
+            }
+            if (i >= n) return whole();
+        } else if (c == '\'') {
+            const size_t close = i + (i + 1 < n && source[i + 1] == '\\' ? 3 : 2);
+            if (close >= n || source[close] != '\'') return whole();
+            for (++i; i < close; ++i) {
+                if (source[i] == '\n') {
+                    ++line;
+                    line_start = i + 1;
+                }
+            }
+        } else if (c == '(' || c == '[' || c == '{') {
+            ++depth;
+        } else if (c == ')' || c == ']' || c == '}') {
+            if (--depth < 0) return whole();
+        }
+        ++i;
+        if (depth == 0 && i >= next_cut && i < n &&
+            (c == ';' || (c == '}' && declaration_follows(source, i)))) {
+            current.end = i;
+            chunks.push_back(current);
+            current.begin = i;
+            current.line = line;
+            current.line_start = line_start;
+            next_cut = i + target_bytes;
+        }
+    }
+    if (depth != 0) return whole();
+    current.end = n;
+    chunks.push_back(current);
+    return chunks;
+}
+
+ParsedChunk parse_chunk(std::string_view source, const std::string& path, const ParseChunk& chunk) {
+    ParsedChunk out;
+    try {
+        Lexer lexer(source.substr(0, chunk.end), path, chunk.begin, chunk.line, chunk.line_start);
+        Parser parser(lexer);
+        out.top_level = parser.parse_module(path, path).top_level;
+        out.tuple_tmps = parser.tuple_tmps();
+    } catch (const CompileError&) {
+        out.failed = true;
+    }
+    return out;
+}
+
+bool assemble_chunks(const std::string& path, std::vector<ParsedChunk>& parsed, Module& out) {
+    size_t next_tmp = 0;
+    size_t statements = 0;
+    for (ParsedChunk& chunk : parsed) {
+        if (chunk.failed) return false;
+        if (next_tmp > 0) {
+            for (size_t i = 0; i < chunk.tuple_tmps.size(); ++i) {
+                const std::string name = std::string(TUPLE_TMP_PREFIX) + std::to_string(next_tmp + i);
+                chunk.tuple_tmps[i].decl->var_name = name;
+                for (const ExprPtr& ref : chunk.tuple_tmps[i].refs) ref->name = name;
+            }
+        }
+        next_tmp += chunk.tuple_tmps.size();
+        statements += chunk.top_level.size();
+    }
+    out.name = path;
+    out.path = path;
+    out.top_level.reserve(statements);
+    for (ParsedChunk& chunk : parsed) {
+        out.top_level.insert(out.top_level.end(), std::make_move_iterator(chunk.top_level.begin()),
+                             std::make_move_iterator(chunk.top_level.end()));
+    }
+    return true;
+}
+
+} // namespace vexel
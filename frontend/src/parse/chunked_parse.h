@@ -0,0 +1,46 @@
+#pragma once
+#include "ast.h"
+#include "parser.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vexel {
+
+// A byte range of a module source that starts at a top-level declaration,
+// together with the line position the lexer needs to report locations in
+// whole-file terms.
+struct ParseChunk {
+    size_t begin = 0;
+    size_t end = 0;
+    int line = 1;
+    size_t line_start = 0;
+};
+
+// Splits `source` into ranges of roughly `target_bytes` for parsing on
+// separate workers. A byte scan that skips comments, string and char literals
+// cuts only at nesting depth 0, directly after a `;`, or after a `}` that is
+// followed by the start of a function, type, import or annotation. No
+// construct continues across such a cut. A source the scan cannot vouch for
+// (non-ASCII or NUL bytes, unbalanced brackets, malformed literals) stays in
+// one range.
+std::vector<ParseChunk> split_top_level_chunks(std::string_view source, size_t target_bytes);
+
+struct ParsedChunk {
+    std::vector<StmtPtr> top_level;
+    std::vector<Parser::TupleTmp> tuple_tmps; // Numbered from 0 within the chunk.
+    bool failed = false; // Lexer or parser error: the module needs a serial parse.
+};
+
+// Parses one chunk of the module at `path`. Tokens borrow `source`, which must
+// outlive the call.
+ParsedChunk parse_chunk(std::string_view source, const std::string& path, const ParseChunk& chunk);
+
+// Joins parsed chunks in source order into the module a serial parse yields,
+// renumbering the temporaries of each chunk after those of the chunks before
+// it. Returns false when a chunk failed; the caller then parses serially, so
+// diagnostics, including recovery across chunk boundaries, are the serial
+// parser's own.
+bool assemble_chunks(const std::string& path, std::vector<ParsedChunk>& parsed, Module& out);
+
+} // namespace vexel
@@ -1,5 +1,7 @@
 #include "lexer.h"
+#include <array>
 #include <cctype>
+#include <cstring>
 
 namespace vexel {
 
@@ -9,27 +11,95 @@ bool is_vexel_whitespace(char c) {
     return c == ' ' || c == '\t' || c == '\n' || c == '\r';
 }
 
+enum CharClass : uint8_t {
+    kSpace = 1,
+    kDigit = 2,
+    kHexDigit = 4,
+    kIdentTail = 8,
+};
+
+constexpr std::array<uint8_t, 256> make_char_classes() {
+    std::array<uint8_t, 256> classes{};
+    classes[' '] = classes['\t'] = classes['\n'] = classes['\r'] = kSpace;
+    for (int c = '0'; c <= '9'; ++c) classes[c] = kDigit | kHexDigit | kIdentTail;
+    for (int c = 'a'; c <= 'z'; ++c) classes[c] = kIdentTail;
+    for (int c = 'A'; c <= 'Z'; ++c) classes[c] = kIdentTail;
+    for (int c = 'a'; c <= 'f'; ++c) classes[c] |= kHexDigit;
+    for (int c = 'A'; c <= 'F'; ++c) classes[c] |= kHexDigit;
+    classes['_'] = kIdentTail;
+    return classes;
 }
 
-Lexer::Lexer(const std::string& src, const std::string& fname)
-    : source(src), filename(fname), pos(0), line(1), column(1) {}
+constexpr std::array<uint8_t, 256> kCharClasses = make_char_classes();
+
+bool has_class(char c, uint8_t cls) {
+    return (kCharClasses[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+// True when every byte is 7-bit ASCII and non-NUL, checked a word at a time.
+// Such sources can never hit the per-character ASCII diagnostic or an embedded
+// NUL terminator, which is what lets the scanners below skip both checks.
+bool is_plain_ascii(std::string_view text) {
+    constexpr uint64_t kLow = 0x0101010101010101ull;
+    constexpr uint64_t kHigh = 0x8080808080808080ull;
+    const char* data = text.data();
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= text.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if ((word & kHigh) || ((word - kLow) & ~word & kHigh)) return false;
+    }
+    for (; i < text.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == 0 || c > 0x7F) return false;
+    }
+    return true;
+}
+
+}
+
+std::string Token::lexeme() const {
+    switch (type) {
+        case TokenType::StringLiteral:
+            return std::get<std::string>(value);
+        case TokenType::CharLiteral:
+            return std::string(1, static_cast<char>(std::get<uint64_t>(value)));
+        default:
+            return std::string(text);
+    }
+}
+
+Lexer::Lexer(std::string_view src, const std::string& fname)
+    : source(src),
+      file_id(intern_source_file(fname)),
+      pos(0),
+      line(1),
+      line_start(0),
+      plain_ascii(is_plain_ascii(src)) {}
+
+Lexer::Lexer(std::string_view src, const std::string& fname, size_t start, int start_line, size_t start_line_start)
+    : source(src),
+      file_id(intern_source_file(fname)),
+      pos(start),
+      line(start_line),
+      line_start(start_line_start),
+      plain_ascii(is_plain_ascii(src.substr(start))) {}
 
 char Lexer::peek(int offset) {
     if (pos + offset >= source.size()) return '\0';
     char c = source[pos + offset];
-    ensure_ascii(c);
+    if (!plain_ascii) ensure_ascii(c);
     return c;
 }
 
 char Lexer::advance() {
     if (pos >= source.size()) return '\0';
-    char c = source[pos++];
-    ensure_ascii(c);
+    char c = source[pos];
+    if (!plain_ascii) ensure_ascii(c);
+    pos++;
     if (c == '\n') {
         line++;
-        column = 1;
-    } else {
-        column++;
+        line_start = pos;
     }
     return c;
 }
@@ -42,14 +112,34 @@ bool Lexer::match(char expected) {
     return false;
 }
 
-void Lexer::skip_whitespace() {
-    while (is_vexel_whitespace(peek())) {
-        advance();
+void Lexer::advance_while(uint8_t char_class) {
+    if (!plain_ascii) {
+        while (has_class(peek(), char_class)) {
+            advance();
+        }
+        return;
+    }
+    while (pos < source.size() && has_class(source[pos], char_class)) {
+        if (source[pos] == '\n') {
+            line++;
+            line_start = pos + 1;
+        }
+        pos++;
     }
 }
 
+void Lexer::skip_whitespace() {
+    advance_while(kSpace);
+}
+
 void Lexer::skip_comment() {
     if (peek() == '/' && peek(1) == '/') {
+        if (plain_ascii) {
+            const void* newline = std::memchr(source.data() + pos, '\n', source.size() - pos);
+            pos = newline ? static_cast<size_t>(static_cast<const char*>(newline) - source.data())
+                          : source.size();
+            return;
+        }
         while (peek() != '\n' && peek() != '\0') {
             advance();
         }
@@ -57,7 +147,7 @@ void Lexer::skip_comment() {
 }
 
 SourceLocation Lexer::current_location() {
-    return SourceLocation(filename, line, column);
+    return SourceLocation::in_file(file_id, line, static_cast<int>(pos - line_start) + 1);
 }
 
 char Lexer::read_escape() {
@@ -115,56 +205,50 @@ void Lexer::ensure_ascii(char c) {
 
 Token Lexer::read_number() {
     SourceLocation loc = current_location();
-    std::string num;
+    const size_t start = pos;
+    auto spelled = [&]() { return source.substr(start, pos - start); };
     auto ensure_no_identifier_tail = [&](char trailing) {
         if (std::isalpha(static_cast<unsigned char>(trailing)) || trailing == '_') {
-            throw CompileError("Identifier cannot start with a digit (found '" + num + trailing + "')", loc);
+            throw CompileError("Identifier cannot start with a digit (found '" + std::string(spelled()) + trailing + "')", loc);
         }
     };
 
     if (peek() == '0' && (peek(1) == 'x' || peek(1) == 'X')) {
         // hex
-        num += advance();
-        num += advance();
+        advance();
+        advance();
         if (!isxdigit(peek())) {
             throw CompileError("Invalid hexadecimal literal: must have at least one hex digit after 0x", loc);
         }
-        while (isxdigit(peek())) {
-            num += advance();
-        }
+        advance_while(kHexDigit);
         ensure_no_identifier_tail(peek());
-        Token t(TokenType::IntLiteral, num, loc);
+        Token t(TokenType::IntLiteral, spelled(), loc);
         return t;
     }
 
-    while (isdigit(peek())) {
-        num += advance();
-    }
+    advance_while(kDigit);
     ensure_no_identifier_tail(peek());
 
     if (peek() == '.' && isdigit(peek(1))) {
         // float
-        num += advance();
-        while (isdigit(peek())) {
-            num += advance();
-        }
+        advance();
+        advance_while(kDigit);
         // Optional exponent part
         if (peek() == 'e' || peek() == 'E') {
-            num += advance();
+            advance();
             if (peek() == '+' || peek() == '-') {
-                num += advance();
+                advance();
             }
             if (!isdigit(peek())) {
                 throw CompileError("Invalid float literal exponent", loc);
             }
-            while (isdigit(peek())) {
-                num += advance();
-            }
+            advance_while(kDigit);
         }
         ensure_no_identifier_tail(peek());
+        const std::string num(spelled());
         try {
             double val = std::stod(num);
-            Token t(TokenType::FloatLiteral, num, loc);
+            Token t(TokenType::FloatLiteral, spelled(), loc);
             t.value = val;
             return t;
         } catch (const std::exception& e) {
@@ -173,26 +257,36 @@ Token Lexer::read_number() {
     }
 
     // Integer literals are parsed exactly later (parser/APInt). Do not overflow here.
-    Token t(TokenType::IntLiteral, num, loc);
+    Token t(TokenType::IntLiteral, spelled(), loc);
     return t;
 }
 
 Token Lexer::read_identifier() {
     SourceLocation loc = current_location();
-    std::string id;
-    while (isalnum(peek()) || peek() == '_') {
-        id += advance();
-    }
-    return Token(TokenType::Identifier, id, loc);
+    const size_t start = pos;
+    advance_while(kIdentTail);
+    return Token(TokenType::Identifier, source.substr(start, pos - start), loc);
 }
 
 Token Lexer::read_string() {
     SourceLocation loc = current_location();
+    const size_t start = pos;
     advance(); // skip opening quote
     std::string str;
     while (peek() != '"' && peek() != '\0') {
         if (peek() == '\\') {
             str += read_escape();
+        } else if (plain_ascii) {
+            // Copy the run up to the next quote or escape in one append.
+            const size_t run = pos;
+            while (pos < source.size() && source[pos] != '"' && source[pos] != '\\') {
+                if (source[pos] == '\n') {
+                    line++;
+                    line_start = pos + 1;
+                }
+                pos++;
+            }
+            str.append(source.data() + run, pos - run);
         } else {
             str += advance();
         }
@@ -201,13 +295,14 @@ Token Lexer::read_string() {
         throw CompileError("Unterminated string", loc);
     }
     advance(); // skip closing quote
-    Token t(TokenType::StringLiteral, str, loc);
-    t.value = str;
+    Token t(TokenType::StringLiteral, source.substr(start, pos - start), loc);
+    t.value = std::move(str);
     return t;
 }
 
 Token Lexer::read_char() {
     SourceLocation loc = current_location();
+    const size_t start = pos;
     advance(); // skip opening quote
     if (peek() == '\0') {
         throw CompileError("Unterminated char literal", loc);
@@ -225,219 +320,201 @@ Token Lexer::read_char() {
         throw CompileError("Unterminated char literal", loc);
     }
     advance(); // skip closing quote
-    Token t(TokenType::CharLiteral, std::string(1, c), loc);
+    Token t(TokenType::CharLiteral, source.substr(start, pos - start), loc);
     t.value = (uint64_t)(unsigned char)c;
     return t;
 }
 
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
+    do {
+        tokens.push_back(next_token());
+    } while (tokens.back().type != TokenType::EndOfFile);
+    return tokens;
+}
 
-    while (peek() != '\0') {
-        // Skip all whitespace and comments
-        while (is_vexel_whitespace(peek()) || (peek() == '/' && peek(1) == '/')) {
-            skip_whitespace();
-            skip_comment();
-        }
-        if (peek() == '\0') break;
+Token Lexer::next_token() {
+    // Skip all whitespace and comments
+    while (is_vexel_whitespace(peek()) || (peek() == '/' && peek(1) == '/')) {
+        skip_whitespace();
+        skip_comment();
+    }
+    if (peek() == '\0') return Token(TokenType::EndOfFile, "", current_location());
 
-        SourceLocation loc = current_location();
-        char c = peek();
+    SourceLocation loc = current_location();
+    char c = peek();
 
-        if (isdigit(c)) {
-            tokens.push_back(read_number());
-            continue;
-        }
+    if (isdigit(c)) {
+        return read_number();
+    }
 
-        if (isalpha(c) || c == '_') {
-            tokens.push_back(read_identifier());
-            continue;
-        }
+    if (isalpha(c) || c == '_') {
+        return read_identifier();
+    }
 
-        if (c == '"') {
-            tokens.push_back(read_string());
-            continue;
-        }
+    if (c == '"') {
+        return read_string();
+    }
 
-        if (c == '\'') {
-            tokens.push_back(read_char());
-            continue;
-        }
+    if (c == '\'') {
+        return read_char();
+    }
 
-        // Operators and symbols
-        advance();
-        switch (c) {
-            case '$': tokens.emplace_back(TokenType::Dollar, "$", loc); break;
-            case '@':
-                if (match('@')) {
-                    tokens.emplace_back(TokenType::DoubleAt, "@@", loc);
-                } else {
-                    tokens.emplace_back(TokenType::At, "@", loc);
-                }
-                break;
-            case '#': tokens.emplace_back(TokenType::Hash, "#", loc); break;
-            case '+':
-                if (match('=')) {
-                    tokens.emplace_back(TokenType::PlusAssign, "+=", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Plus, "+", loc);
-                }
-                break;
-            case '*':
-                if (match('=')) {
-                    tokens.emplace_back(TokenType::StarAssign, "*=", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Star, "*", loc);
-                }
-                break;
-            case '/':
-                if (match('=')) {
-                    tokens.emplace_back(TokenType::SlashAssign, "/=", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Slash, "/", loc);
-                }
-                break;
-            case '%':
+    // Operators and symbols
+    advance();
+    switch (c) {
+        case '$': return Token(TokenType::Dollar, "$", loc);
+        case '@':
+            if (match('@')) {
+                return Token(TokenType::DoubleAt, "@@", loc);
+            } else {
+                return Token(TokenType::At, "@", loc);
+            }
+        case '#': return Token(TokenType::Hash, "#", loc);
+        case '+':
+            if (match('=')) {
+                return Token(TokenType::PlusAssign, "+=", loc);
+            } else {
+                return Token(TokenType::Plus, "+", loc);
+            }
+        case '*':
+            if (match('=')) {
+                return Token(TokenType::StarAssign, "*=", loc);
+            } else {
+                return Token(TokenType::Star, "*", loc);
+            }
+        case '/':
+            if (match('=')) {
+                return Token(TokenType::SlashAssign, "/=", loc);
+            } else {
+                return Token(TokenType::Slash, "/", loc);
+            }
+        case '%':
+            if (match('=')) {
+                return Token(TokenType::PercentAssign, "%=", loc);
+            } else {
+                return Token(TokenType::Percent, "%", loc);
+            }
+        case '^':
+            if (match('=')) {
+                return Token(TokenType::BitXorAssign, "^=", loc);
+            } else {
+                return Token(TokenType::BitXor, "^", loc);
+            }
+        case '~': return Token(TokenType::BitNot, "~", loc);
+        case '(': return Token(TokenType::LeftParen, "(", loc);
+        case ')': return Token(TokenType::RightParen, ")", loc);
+        case '{': return Token(TokenType::LeftBrace, "{", loc);
+        case '}': return Token(TokenType::RightBrace, "}", loc);
+        case '[': return Token(TokenType::LeftBracket, "[", loc);
+        case ']': return Token(TokenType::RightBracket, "]", loc);
+        case ',': return Token(TokenType::Comma, ",", loc);
+        case ';': return Token(TokenType::Semicolon, ";", loc);
+        case '?': return Token(TokenType::Question, "?", loc);
+
+        case '|':
+            if (match('|')) {
                 if (match('=')) {
-                    tokens.emplace_back(TokenType::PercentAssign, "%=", loc);
+                    return Token(TokenType::LogicalOrAssign, "||=", loc);
                 } else {
-                    tokens.emplace_back(TokenType::Percent, "%", loc);
+                    return Token(TokenType::LogicalOr, "||", loc);
                 }
-                break;
-            case '^':
+            } else if (match('=')) {
+                return Token(TokenType::BitOrAssign, "|=", loc);
+            } else {
+                // Single | is BitOr (also used for length operator)
+                return Token(TokenType::BitOr, "|", loc);
+            }
+
+        case '&':
+            if (match('!')) {
+                return Token(TokenType::AmpersandBang, "&!", loc);
+            } else if (match('^')) {
+                return Token(TokenType::AmpersandCaret, "&^", loc);
+            } else if (match('&')) {
                 if (match('=')) {
-                    tokens.emplace_back(TokenType::BitXorAssign, "^=", loc);
+                    return Token(TokenType::LogicalAndAssign, "&&=", loc);
                 } else {
-                    tokens.emplace_back(TokenType::BitXor, "^", loc);
+                    return Token(TokenType::LogicalAnd, "&&", loc);
                 }
-                break;
-            case '~': tokens.emplace_back(TokenType::BitNot, "~", loc); break;
-            case '(': tokens.emplace_back(TokenType::LeftParen, "(", loc); break;
-            case ')': tokens.emplace_back(TokenType::RightParen, ")", loc); break;
-            case '{': tokens.emplace_back(TokenType::LeftBrace, "{", loc); break;
-            case '}': tokens.emplace_back(TokenType::RightBrace, "}", loc); break;
-            case '[': tokens.emplace_back(TokenType::LeftBracket, "[", loc); break;
-            case ']': tokens.emplace_back(TokenType::RightBracket, "]", loc); break;
-            case ',': tokens.emplace_back(TokenType::Comma, ",", loc); break;
-            case ';': tokens.emplace_back(TokenType::Semicolon, ";", loc); break;
-            case '?': tokens.emplace_back(TokenType::Question, "?", loc); break;
-
-            case '|':
-                if (match('|')) {
-                    if (match('=')) {
-                        tokens.emplace_back(TokenType::LogicalOrAssign, "||=", loc);
-                    } else {
-                        tokens.emplace_back(TokenType::LogicalOr, "||", loc);
-                    }
-                } else if (match('=')) {
-                    tokens.emplace_back(TokenType::BitOrAssign, "|=", loc);
-                } else {
-                    // Single | is BitOr (also used for length operator)
-                    tokens.emplace_back(TokenType::BitOr, "|", loc);
-                }
-                break;
-
-            case '&':
-                if (match('!')) {
-                    tokens.emplace_back(TokenType::AmpersandBang, "&!", loc);
-                } else if (match('^')) {
-                    tokens.emplace_back(TokenType::AmpersandCaret, "&^", loc);
-                } else if (match('&')) {
-                    if (match('=')) {
-                        tokens.emplace_back(TokenType::LogicalAndAssign, "&&=", loc);
-                    } else {
-                        tokens.emplace_back(TokenType::LogicalAnd, "&&", loc);
-                    }
-                } else if (match('=')) {
-                    tokens.emplace_back(TokenType::BitAndAssign, "&=", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Ampersand, "&", loc);
-                }
-                break;
+            } else if (match('=')) {
+                return Token(TokenType::BitAndAssign, "&=", loc);
+            } else {
+                return Token(TokenType::Ampersand, "&", loc);
+            }
 
-            case '!':
+        case '!':
+            if (match('=')) {
+                return Token(TokenType::NotEqual, "!=", loc);
+            } else {
+                return Token(TokenType::LogicalNot, "!", loc);
+            }
+
+        case '=':
+            if (match('=')) {
+                return Token(TokenType::Equal, "==", loc);
+            } else {
+                return Token(TokenType::Assign, "=", loc);
+            }
+
+        case '<':
+            if (match('<')) {
                 if (match('=')) {
-                    tokens.emplace_back(TokenType::NotEqual, "!=", loc);
+                    return Token(TokenType::LeftShiftAssign, "<<=", loc);
                 } else {
-                    tokens.emplace_back(TokenType::LogicalNot, "!", loc);
+                    return Token(TokenType::LeftShift, "<<", loc);
                 }
-                break;
+            } else if (match('=')) {
+                return Token(TokenType::LessEqual, "<=", loc);
+            } else {
+                return Token(TokenType::Less, "<", loc);
+            }
 
-            case '=':
+        case '>':
+            if (match('>')) {
                 if (match('=')) {
-                    tokens.emplace_back(TokenType::Equal, "==", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Assign, "=", loc);
-                }
-                break;
-
-            case '<':
-                if (match('<')) {
-                    if (match('=')) {
-                        tokens.emplace_back(TokenType::LeftShiftAssign, "<<=", loc);
-                    } else {
-                        tokens.emplace_back(TokenType::LeftShift, "<<", loc);
-                    }
-                } else if (match('=')) {
-                    tokens.emplace_back(TokenType::LessEqual, "<=", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Less, "<", loc);
-                }
-                break;
-
-            case '>':
-                if (match('>')) {
-                    if (match('=')) {
-                        tokens.emplace_back(TokenType::RightShiftAssign, ">>=", loc);
-                    } else {
-                        tokens.emplace_back(TokenType::RightShift, ">>", loc);
-                    }
-                } else if (match('=')) {
-                    tokens.emplace_back(TokenType::GreaterEqual, ">=", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Greater, ">", loc);
-                }
-                break;
-
-            case '-':
-                if (match('>')) {
-                    if (match('|')) {
-                        tokens.emplace_back(TokenType::BreakArrow, "->|", loc);
-                    } else if (match('>')) {
-                        tokens.emplace_back(TokenType::ContinueArrow, "->>", loc);
-                    } else {
-                        tokens.emplace_back(TokenType::Arrow, "->", loc);
-                    }
-                } else if (match('=')) {
-                    tokens.emplace_back(TokenType::MinusAssign, "-=", loc);
+                    return Token(TokenType::RightShiftAssign, ">>=", loc);
                 } else {
-                    tokens.emplace_back(TokenType::Minus, "-", loc);
+                    return Token(TokenType::RightShift, ">>", loc);
                 }
-                break;
+            } else if (match('=')) {
+                return Token(TokenType::GreaterEqual, ">=", loc);
+            } else {
+                return Token(TokenType::Greater, ">", loc);
+            }
 
-            case '.':
-                if (match('.')) {
-                    tokens.emplace_back(TokenType::DotDot, "..", loc);
+        case '-':
+            if (match('>')) {
+                if (match('|')) {
+                    return Token(TokenType::BreakArrow, "->|", loc);
+                } else if (match('>')) {
+                    return Token(TokenType::ContinueArrow, "->>", loc);
                 } else {
-                    tokens.emplace_back(TokenType::Dot, ".", loc);
+                    return Token(TokenType::Arrow, "->", loc);
                 }
-                break;
+            } else if (match('=')) {
+                return Token(TokenType::MinusAssign, "-=", loc);
+            } else {
+                return Token(TokenType::Minus, "-", loc);
+            }
 
-            case ':':
-                if (match(':')) {
-                    tokens.emplace_back(TokenType::DoubleColon, "::", loc);
-                } else {
-                    tokens.emplace_back(TokenType::Colon, ":", loc);
-                }
-                break;
+        case '.':
+            if (match('.')) {
+                return Token(TokenType::DotDot, "..", loc);
+            } else {
+                return Token(TokenType::Dot, ".", loc);
+            }
 
-            default:
-                throw CompileError("Unexpected character: " + std::string(1, c), loc);
-        }
-    }
+        case ':':
+            if (match(':')) {
+                return Token(TokenType::DoubleColon, "::", loc);
+            } else {
+                return Token(TokenType::Colon, ":", loc);
+            }
 
-    tokens.emplace_back(TokenType::EndOfFile, "", current_location());
-    return tokens;
+        default:
+            throw CompileError("Unexpected character: " + std::string(1, c), loc);
+    }
 }
 
 }
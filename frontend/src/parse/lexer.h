@@ -1,5 +1,6 @@
 #pragma once
 #include "common.h"
+#include <string_view>
 #include <variant>
 #include <optional>
 
@@ -34,31 +35,47 @@ enum class TokenType {
     AmpersandBang, AmpersandCaret
 };
 
+// `text` is the token's spelling as a view into the lexed source (or a static
+// operator spelling), so tokens must not outlive the source buffer. Only
+// literals that need decoding carry an owned payload in `value`.
 struct Token {
     TokenType type;
-    std::string lexeme;
+    std::string_view text;
     SourceLocation location;
     std::variant<int64_t, uint64_t, double, std::string> value;
 
-    Token(TokenType t, const std::string& lex, const SourceLocation& loc)
-        : type(t), lexeme(lex), location(loc) {}
+    Token(TokenType t, std::string_view txt, const SourceLocation& loc)
+        : type(t), text(txt), location(loc) {}
+
+    // Decoded spelling: string literal contents, the character of a char
+    // literal, otherwise the source text.
+    std::string lexeme() const;
 };
 
+// Lexes a borrowed source buffer; the buffer must outlive the returned tokens.
 class Lexer {
-    std::string source;
-    std::string filename;
+    std::string_view source;
+    uint32_t file_id;
     size_t pos;
     int line;
-    int column;
+    size_t line_start;  // offset of the current line; columns derive from it
+    bool plain_ascii;   // no non-ASCII or NUL bytes: scanners skip per-char checks
 
 public:
-    Lexer(const std::string& src, const std::string& fname);
+    Lexer(std::string_view src, const std::string& fname);
+    // Lexes `src` from offset `start`, which lies on line `start_line` starting
+    // at offset `start_line_start`; locations match a lex of the whole buffer.
+    Lexer(std::string_view src, const std::string& fname, size_t start, int start_line, size_t start_line_start);
     std::vector<Token> tokenize();
+    // Lexes the next token; returns EndOfFile (repeatedly) once the source is
+    // exhausted.
+    Token next_token();
 
 private:
     char peek(int offset = 0);
     char advance();
     bool match(char expected);
+    void advance_while(uint8_t char_class);
     void skip_whitespace();
     void skip_comment();
     SourceLocation current_location();
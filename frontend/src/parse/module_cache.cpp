@@ -0,0 +1,126 @@
+#include "module_cache.h"
+#include "ast_codec.h"
+#include "content_hash.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+
+namespace vexel {
+
+namespace {
+
+// Bump when the encoding changes or the AST gains parser-produced fields. The
+// build stamp keeps entries written by a different compiler build (possibly
+// with a different parser) from being reused.
+constexpr const char* kCacheHeader = "vexel-ast-cache 2 " __DATE__ " " __TIME__;
+
+} // namespace
+
+std::string serialize_module(const Module& module) {
+    AstEncoder encoder(module.path);
+    encoder.module(module);
+    return encoder.finish(kCacheHeader);
+}
+
+std::string serialize_module_interface(const Module& module) {
+    AstEncoder::Config config;
+    config.interface_only = true;
+    AstEncoder encoder(module.path, config);
+    encoder.module(module);
+    return encoder.finish(kCacheHeader);
+}
+
+bool deserialize_module(const std::string& data, const std::string& path, Module& out) {
+    Module module;
+    module.name = path;
+    module.path = path;
+    AstDecoder decoder(data, path);
+    if (!decoder.begin(kCacheHeader)) return false;
+    decoder.module(module);
+    if (!decoder.ok() || !decoder.at_end()) return false;
+    out = std::move(module);
+    return true;
+}
+
+std::string ParsedModuleCache::key_for(std::string_view source) {
+    ContentHasher hasher;
+    hasher.add_bytes(kCacheHeader, std::strlen(kCacheHeader));
+    hasher.add_u64(source.size());
+    hasher.add_bytes(source.data(), source.size());
+    return hasher.hex();
+}
+
+std::string ParsedModuleCache::entry_path(const std::string& key) const {
+    return (std::filesystem::path(dir_) / "parsed" / (key + ".ast")).string();
+}
+
+bool ParsedModuleCache::lookup(const std::string& key, const std::string& path, Module& out) const {
+    std::ifstream file(entry_path(key), std::ios::binary);
+    if (file) {
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (deserialize_module(content, path, out)) {
+            ++hits_;
+            return true;
+        }
+    }
+    ++misses_;
+    return false;
+}
+
+void ParsedModuleCache::store(const std::string& key, const Module& module) const {
+    const std::string target = entry_path(key);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(target).parent_path(), ec);
+
+    // Concurrent compilers may store the same entry; each writes a private
+    // temporary and the last rename wins with identical content.
+    const size_t nonce = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                         static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const std::string tmp_path = target + ".tmp" + std::to_string(nonce);
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw CompileError("Cannot write file: " + tmp_path, SourceLocation());
+        }
+        file << serialize_module(module);
+    }
+    std::filesystem::rename(tmp_path, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        throw CompileError("Cannot write file: " + target, SourceLocation());
+    }
+}
+
+bool ResidentModuleCache::lookup(const std::string& key, const std::string& path, Module& out) const {
+    std::string data;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) data = it->second;
+    }
+    if (!data.empty() && deserialize_module(data, path, out)) {
+        ++hits_;
+        return true;
+    }
+    ++misses_;
+    return false;
+}
+
+void ResidentModuleCache::store(const std::string& key, const Module& module) const {
+    std::string data = serialize_module(module);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!entries_.emplace(key, std::move(data)).second) return;
+    order_.push_back(key);
+    while (order_.size() > max_entries_) {
+        entries_.erase(order_.front());
+        order_.pop_front();
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ast.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace vexel {
+
+// Opt-in on-disk cache of parsed modules, one file per entry. Keys hash the
+// source text together with the compiler build stamp, so an entry is only
+// reused for byte-identical source parsed by the same compiler. The module's
+// own path is rebound on load, which lets identical files at different paths
+// share an entry. Lookups and stores may run on concurrent loader workers.
+class ParsedModuleCache {
+public:
+    explicit ParsedModuleCache(std::string dir) : dir_(std::move(dir)) {}
+
+    static std::string key_for(std::string_view source);
+
+    // Fills `out` (named and located at `path`) from the entry for `key`.
+    // Missing, unreadable or stale entries return false.
+    bool lookup(const std::string& key, const std::string& path, Module& out) const;
+    void store(const std::string& key, const Module& module) const;
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    const std::string& dir() const { return dir_; }
+
+private:
+    std::string entry_path(const std::string& key) const;
+
+    std::string dir_;
+    mutable std::atomic<size_t> hits_{0};
+    mutable std::atomic<size_t> misses_{0};
+};
+
+// In-memory counterpart for processes that compile many times (the compile
+// server): encoded modules under the same keys, kept across compiles and
+// decoded into fresh trees on every hit. Holds at most `max_entries` entries
+// and drops the oldest first, so edited files do not grow it without bound.
+class ResidentModuleCache {
+public:
+    explicit ResidentModuleCache(size_t max_entries = 4096) : max_entries_(max_entries) {}
+
+    bool lookup(const std::string& key, const std::string& path, Module& out) const;
+    void store(const std::string& key, const Module& module) const;
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    size_t max_entries_;
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<std::string, std::string> entries_;
+    mutable std::deque<std::string> order_;  // insertion order, oldest first
+    mutable std::atomic<size_t> hits_{0};
+    mutable std::atomic<size_t> misses_{0};
+};
+
+// Binary encoding of a freshly parsed module. Shared subtrees are written once
+// and restored as shared. Semantic annotations (resolved symbols) are not
+// encoded, since the parser never sets them.
+std::string serialize_module(const Module& module);
+bool deserialize_module(const std::string& data, const std::string& path, Module& out);
+// The same encoding without source locations and function bodies: equal for
+// two versions of a module that differ only inside function bodies or in
+// layout. Used for fingerprints, never decoded.
+std::string serialize_module_interface(const Module& module);
+
+}
@@ -16,20 +16,27 @@ Parser::Parser(std::vector<Token> toks)
       split_top_level_plain_ampersand_funcs(false),
       top_level_init_expr_root_depth(-1) {}
 
+Parser::Parser(Lexer& lexer)
+    : tokens(lexer),
+      pos(0),
+      panic_mode(false),
+      allow_statement_conditionals(false),
+      statement_expr_depth(0),
+      statement_expr_allowed_depth(0),
+      split_top_level_plain_ampersand_funcs(false),
+      top_level_init_expr_root_depth(-1) {}
+
 const Token& Parser::current() {
-    if (pos >= tokens.size()) return tokens.back();
-    return tokens[pos];
+    return tokens.at(pos);
 }
 
 const Token& Parser::peek(int offset) {
-    size_t p = pos + offset;
-    if (p >= tokens.size()) return tokens.back();
-    return tokens[p];
+    return tokens.at(pos + offset);
 }
 
 const Token& Parser::previous() {
-    if (pos == 0) return tokens[0];
-    return tokens[pos - 1];
+    if (pos == 0) return tokens.at(0);
+    return tokens.at(pos - 1);
 }
 
 void Parser::record_error(const std::string& msg, const SourceLocation& loc) {
@@ -88,27 +95,27 @@ bool Parser::match(TokenType type) {
 }
 
 bool Parser::check_dotted_operator(TokenType inner_type) const {
-    if (pos + 1 >= tokens.size()) return false;
-    return tokens[pos].type == TokenType::Dot && tokens[pos + 1].type == inner_type;
+    if (!tokens.contains(pos + 1)) return false;
+    return tokens.at(pos).type == TokenType::Dot && tokens.at(pos + 1).type == inner_type;
 }
 
 bool Parser::match_dotted_operator(TokenType inner_type, std::string& out_op) {
     if (!check_dotted_operator(inner_type)) return false;
-    out_op = "." + tokens[pos + 1].lexeme;
+    out_op = "." + tokens.at(pos + 1).lexeme();
     pos += 2;
     return true;
 }
 
 bool Parser::check_member_dot() const {
-    if (pos + 1 >= tokens.size()) return false;
-    return tokens[pos].type == TokenType::Dot && tokens[pos + 1].type == TokenType::Identifier;
+    if (!tokens.contains(pos + 1)) return false;
+    return tokens.at(pos).type == TokenType::Dot && tokens.at(pos + 1).type == TokenType::Identifier;
 }
 
 bool Parser::check_probe_dot() const {
-    if (pos + 2 >= tokens.size()) return false;
-    return tokens[pos].type == TokenType::Dot &&
-           tokens[pos + 1].type == TokenType::Question &&
-           tokens[pos + 2].type == TokenType::Identifier;
+    if (!tokens.contains(pos + 2)) return false;
+    return tokens.at(pos).type == TokenType::Dot &&
+           tokens.at(pos + 1).type == TokenType::Question &&
+           tokens.at(pos + 2).type == TokenType::Identifier;
 }
 
 Token Parser::consume(TokenType type, const std::string& msg) {
@@ -116,7 +123,7 @@ Token Parser::consume(TokenType type, const std::string& msg) {
         record_error(msg, current().location);
         return current();
     }
-    return tokens[pos++];
+    return tokens.at(pos++);
 }
 
 void Parser::skip_semis() {
@@ -186,14 +193,14 @@ bool Parser::token_starts_top_level(TokenType type) const {
 bool Parser::looks_like_var_decl_with_linkage(bool allow_double_bang_local) const {
     size_t cursor = pos;
 
-    if (cursor < tokens.size() && tokens[cursor].type == TokenType::BitXor) {
+    if (tokens.contains(cursor) && tokens.at(cursor).type == TokenType::BitXor) {
         cursor++;
     }
 
     VarLinkageKind linkage = VarLinkageKind::Normal;
-    if (cursor < tokens.size() && tokens[cursor].type == TokenType::LogicalNot) {
+    if (tokens.contains(cursor) && tokens.at(cursor).type == TokenType::LogicalNot) {
         cursor++;
-        if (cursor < tokens.size() && tokens[cursor].type == TokenType::LogicalNot) {
+        if (tokens.contains(cursor) && tokens.at(cursor).type == TokenType::LogicalNot) {
             linkage = VarLinkageKind::BackendBound;
             cursor++;
         } else {
@@ -204,13 +211,13 @@ bool Parser::looks_like_var_decl_with_linkage(bool allow_double_bang_local) cons
         }
     }
 
-    if (cursor >= tokens.size() || tokens[cursor].type != TokenType::Identifier) {
+    if (!tokens.contains(cursor) || tokens.at(cursor).type != TokenType::Identifier) {
         return false;
     }
     cursor++;
 
-    if (cursor >= tokens.size()) return false;
-    const TokenType next = tokens[cursor].type;
+    if (!tokens.contains(cursor)) return false;
+    const TokenType next = tokens.at(cursor).type;
     const bool typed = next == TokenType::Colon;
     if (!typed && next != TokenType::Assign && next != TokenType::Semicolon) {
         return false;
@@ -243,7 +250,7 @@ StmtPtr Parser::parse_var_decl(bool allow_double_bang_local) {
         throw CompileError("Declarations cannot be both exported and external", loc);
     }
 
-    std::string name = consume(TokenType::Identifier, "Expected variable name").lexeme;
+    std::string name = consume(TokenType::Identifier, "Expected variable name").lexeme();
 
     TypePtr type = nullptr;
     if (match(TokenType::Colon)) {
@@ -318,19 +325,18 @@ bool Parser::try_parse_annotation_block(size_t start, size_t& end, std::vector<A
     size_t cursor = start;
     out.clear();
 
-    if (cursor >= tokens.size() || tokens[cursor].type != TokenType::LeftBracket) {
+    if (!tokens.contains(cursor) || tokens.at(cursor).type != TokenType::LeftBracket) {
         return false;
     }
-    if (cursor + 1 >= tokens.size() || tokens[cursor + 1].type != TokenType::LeftBracket) {
+    if (!tokens.contains(cursor + 1) || tokens.at(cursor + 1).type != TokenType::LeftBracket) {
         return false;
     }
 
     auto token_at = [&](size_t idx) -> const Token& {
-        if (idx < tokens.size()) return tokens[idx];
-        return tokens.back();
+        return tokens.at(idx);
     };
 
-    while (cursor + 1 < tokens.size() &&
+    while (tokens.contains(cursor + 1) &&
            token_at(cursor).type == TokenType::LeftBracket &&
            token_at(cursor + 1).type == TokenType::LeftBracket) {
         cursor += 2;
@@ -340,7 +346,7 @@ bool Parser::try_parse_annotation_block(size_t start, size_t& end, std::vector<A
                 return false;
             }
             Annotation ann;
-            ann.name = token_at(cursor).lexeme;
+            ann.name = token_at(cursor).lexeme();
             ann.location = token_at(cursor).location;
             cursor++;
 
@@ -351,7 +357,7 @@ bool Parser::try_parse_annotation_block(size_t start, size_t& end, std::vector<A
                         if (!token_can_be_annotation_arg(token_at(cursor).type)) {
                             return false;
                         }
-                        ann.args.push_back(token_at(cursor).lexeme);
+                        ann.args.push_back(token_at(cursor).lexeme());
                         cursor++;
                         if (token_at(cursor).type == TokenType::Comma) {
                             cursor++;
@@ -403,7 +409,7 @@ std::vector<Annotation> Parser::parse_annotations_disambiguated(AnnotationContex
         return {};
     }
 
-    TokenType next = (end < tokens.size()) ? tokens[end].type : TokenType::EndOfFile;
+    TokenType next = (tokens.contains(end)) ? tokens.at(end).type : TokenType::EndOfFile;
     if (!token_starts_annotation_target(next, context)) {
         return {};
     }
@@ -420,7 +426,7 @@ std::string Parser::parse_annotation_arg() {
         case TokenType::IntLiteral:
         case TokenType::FloatLiteral: {
             pos++;
-            return tok.lexeme;
+            return tok.lexeme();
         }
         default:
             throw CompileError("Expected annotation argument", tok.location);
@@ -436,7 +442,7 @@ std::vector<Annotation> Parser::parse_annotations() {
         do {
             Token name_tok = consume(TokenType::Identifier, "Expected annotation name");
             Annotation ann;
-            ann.name = name_tok.lexeme;
+            ann.name = name_tok.lexeme();
             ann.location = name_tok.location;
 
             if (match(TokenType::LeftParen)) {
@@ -465,6 +471,9 @@ Module Parser::parse_module(const std::string& name, const std::string& path) {
     while (!check(TokenType::EndOfFile)) {
         skip_semis();
         if (check(TokenType::EndOfFile)) break;
+        // No construct backtracks across a top-level boundary; keep only the
+        // token synchronize() may inspect through previous().
+        tokens.release_before(pos == 0 ? 0 : pos - 1);
 
         if (panic_mode) {
             synchronize();
@@ -478,12 +487,14 @@ Module Parser::parse_module(const std::string& name, const std::string& path) {
             mod.top_level.push_back(top);
             skip_semis();
         } catch (const CompileError& e) {
+            if (tokens.lex_failed()) break;
             errors.emplace_back(DiagnosticLevel::Error, e.what(), e.location);
             synchronize();
             if (check(TokenType::EndOfFile)) break;
         }
     }
 
+    tokens.rethrow_lex_error();
     if (!errors.empty()) {
         std::string combined_msg = "Parse failed with " + std::to_string(errors.size()) + " error(s):\n";
         for (const auto& err : errors) {
@@ -561,8 +572,8 @@ static bool is_per_element_operator_inner_token(TokenType type) {
 
 bool Parser::looks_like_plain_func_decl_start(size_t cursor) const {
     auto token_type = [&](size_t idx) -> TokenType {
-        if (idx >= tokens.size()) return TokenType::EndOfFile;
-        return tokens[idx].type;
+        if (!tokens.contains(idx)) return TokenType::EndOfFile;
+        return tokens.at(idx).type;
     };
 
     if (token_type(cursor) != TokenType::Ampersand) {
@@ -670,11 +681,11 @@ bool Parser::looks_like_plain_func_decl_start(size_t cursor) const {
 
 std::string Parser::parse_function_name() {
     if (check(TokenType::Identifier)) {
-        return consume(TokenType::Identifier, "Expected function name").lexeme;
+        return consume(TokenType::Identifier, "Expected function name").lexeme();
     }
 
     if (check(TokenType::Dot) && is_per_element_operator_inner_token(peek().type)) {
-        std::string op = "." + peek().lexeme;
+        std::string op = "." + peek().lexeme();
         pos += 2;
         return op;
     }
@@ -682,7 +693,7 @@ std::string Parser::parse_function_name() {
     Token tok = current();
     if (is_operator_function_token(tok.type)) {
         pos++;
-        return tok.lexeme;
+        return tok.lexeme();
     }
 
     throw CompileError("Expected function name or overloadable operator", tok.location);
@@ -739,7 +750,7 @@ StmtPtr Parser::parse_func_decl() {
             Token maybe_type = current();
             pos++;
             if (match(TokenType::DoubleColon)) {
-                type_namespace = maybe_type.lexeme;
+                type_namespace = maybe_type.lexeme();
                 namespace_found = true;
             } else {
                 pos = saved_pos;
@@ -798,7 +809,7 @@ StmtPtr Parser::parse_func_decl() {
 StmtPtr Parser::parse_type_decl() {
     SourceLocation loc = current().location;
     consume(TokenType::Hash, "Expected '#'");
-    std::string name = consume(TokenType::Identifier, "Expected type name").lexeme;
+    std::string name = consume(TokenType::Identifier, "Expected type name").lexeme();
     consume(TokenType::LeftParen, "Expected '('");
     std::vector<Field> fields = parse_fields();
     consume(TokenType::RightParen, "Expected ')'");
@@ -813,7 +824,7 @@ StmtPtr Parser::parse_import() {
         std::string command = std::get<std::string>(current().value);
         pos++;
         consume(TokenType::Arrow, "Expected '->' after process command");
-        std::string var_name = consume(TokenType::Identifier, "Expected identifier after ->").lexeme;
+        std::string var_name = consume(TokenType::Identifier, "Expected identifier after ->").lexeme();
         consume(TokenType::Semicolon, "Expected ';'");
         ExprPtr proc = Expr::make_process(command, loc);
         TypePtr str_type = Type::make_primitive(PrimitiveType::String, loc);
@@ -892,7 +903,7 @@ StmtPtr Parser::parse_stmt_no_semi() {
         std::vector<SourceLocation> id_locs;
 
         // Parse first identifier
-        ids.push_back(current().lexeme);
+        ids.push_back(current().lexeme());
         id_locs.push_back(current().location);
         pos++;
 
@@ -905,7 +916,7 @@ StmtPtr Parser::parse_stmt_no_semi() {
                     pos = saved;
                     goto not_multi_assign;
                 }
-                ids.push_back(current().lexeme);
+                ids.push_back(current().lexeme());
                 id_locs.push_back(current().location);
                 pos++;
             } while (match(TokenType::Comma));
@@ -917,18 +928,19 @@ StmtPtr Parser::parse_stmt_no_semi() {
                 ExprPtr rhs = parse_expr();
 
                 // Generate temporary variable name
-                static int tmp_counter = 0;
-                std::string tmp_name = std::string(TUPLE_TMP_PREFIX) + std::to_string(tmp_counter++);
+                std::string tmp_name = std::string(TUPLE_TMP_PREFIX) + std::to_string(tuple_tmp_counter++);
 
                 // Create block to hold desugared statements
                 std::vector<StmtPtr> stmts;
 
                 // __tmp = rhs
                 stmts.push_back(Stmt::make_var(tmp_name, nullptr, rhs, true, loc));
+                tuple_tmp_nodes.push_back({stmts.back(), {}});
 
                 // a = __tmp.__0; b = __tmp.__1; ...
                 for (size_t i = 0; i < ids.size(); i++) {
                     ExprPtr tmp_ref = Expr::make_identifier(tmp_name, loc);
+                    tuple_tmp_nodes.back().refs.push_back(tmp_ref);
                     std::string field_name = std::string(MANGLED_PREFIX) + std::to_string(i);
                     ExprPtr field_access = Expr::make_member(tmp_ref, field_name, id_locs[i]);
                     ExprPtr assignment = Expr::make_assignment(
@@ -1045,7 +1057,7 @@ ExprPtr Parser::parse_assignment() {
         if (op_lexeme.empty()) {
             Token op_tok = current();
             pos++;
-            op_lexeme = op_tok.lexeme;
+            op_lexeme = op_tok.lexeme();
         }
         ExprPtr rhs = parse_assignment();
         return Expr::make_assignment(expr, rhs, expr->location, op_lexeme);
@@ -1109,7 +1121,7 @@ ExprPtr Parser::parse_logic_or() {
     while (check(TokenType::LogicalOr) || check_dotted_operator(TokenType::LogicalOr)) {
         std::string op;
         if (!match_dotted_operator(TokenType::LogicalOr, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_logic_and();
@@ -1125,7 +1137,7 @@ ExprPtr Parser::parse_logic_and() {
     while (check(TokenType::LogicalAnd) || check_dotted_operator(TokenType::LogicalAnd)) {
         std::string op;
         if (!match_dotted_operator(TokenType::LogicalAnd, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_bit_or();
@@ -1141,7 +1153,7 @@ ExprPtr Parser::parse_bit_or() {
     while (check(TokenType::BitOr) || check_dotted_operator(TokenType::BitOr)) {
         std::string op;
         if (!match_dotted_operator(TokenType::BitOr, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_bit_xor();
@@ -1157,7 +1169,7 @@ ExprPtr Parser::parse_bit_xor() {
     while (check(TokenType::BitXor) || check_dotted_operator(TokenType::BitXor)) {
         std::string op;
         if (!match_dotted_operator(TokenType::BitXor, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_bit_and();
@@ -1178,7 +1190,7 @@ ExprPtr Parser::parse_bit_and() {
         }
         std::string op;
         if (!match_dotted_operator(TokenType::Ampersand, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_compare();
@@ -1209,7 +1221,7 @@ ExprPtr Parser::parse_compare() {
             !match_dotted_operator(TokenType::GreaterEqual, op) &&
             !match_dotted_operator(TokenType::Less, op) &&
             !match_dotted_operator(TokenType::Greater, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_shift();
@@ -1232,7 +1244,7 @@ ExprPtr Parser::parse_shift() {
         std::string op;
         if (!match_dotted_operator(TokenType::LeftShift, op) &&
             !match_dotted_operator(TokenType::RightShift, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_range();
@@ -1277,7 +1289,7 @@ ExprPtr Parser::parse_sum() {
         std::string op;
         if (!match_dotted_operator(TokenType::Plus, op) &&
             !match_dotted_operator(TokenType::Minus, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_prod();
@@ -1297,7 +1309,7 @@ ExprPtr Parser::parse_prod() {
         if (!match_dotted_operator(TokenType::Star, op) &&
             !match_dotted_operator(TokenType::Slash, op) &&
             !match_dotted_operator(TokenType::Percent, op)) {
-            op = current().lexeme;
+            op = current().lexeme();
             pos++;
         }
         ExprPtr right = parse_unary();
@@ -1311,7 +1323,7 @@ ExprPtr Parser::parse_unary() {
     SourceLocation loc = current().location;
 
     if (check(TokenType::Minus) || check(TokenType::LogicalNot) || check(TokenType::BitNot)) {
-        std::string op = current().lexeme;
+        std::string op = current().lexeme();
         pos++;
         ExprPtr operand = parse_unary();
         if (op == "-" &&
@@ -1319,7 +1331,7 @@ ExprPtr Parser::parse_unary() {
             operand->kind == Expr::Kind::IntLiteral &&
             !operand->literal_is_unsigned &&
             operand->has_exact_int_val) {
-            APInt negated = -operand->exact_int_val;
+            APInt negated = -operand->exact_int_val.value();
             std::string raw = operand->raw_literal.empty()
                 ? std::string("-") + negated.to_string()
                 : std::string("-") + operand->raw_literal;
@@ -1341,13 +1353,13 @@ ExprPtr Parser::parse_unary() {
         if (check(TokenType::Identifier)) {
             size_t saved = pos;
             std::vector<ExprPtr> receivers;
-            receivers.push_back(Expr::make_identifier(consume(TokenType::Identifier, "").lexeme, loc));
+            receivers.push_back(Expr::make_identifier(consume(TokenType::Identifier, "").lexeme(), loc));
 
             bool is_multi_receiver = false;
             if (match(TokenType::Comma)) {
                 is_multi_receiver = true;
                 do {
-                    receivers.push_back(Expr::make_identifier(consume(TokenType::Identifier, "Expected identifier").lexeme, loc));
+                    receivers.push_back(Expr::make_identifier(consume(TokenType::Identifier, "Expected identifier").lexeme(), loc));
                 } while (match(TokenType::Comma));
             }
 
@@ -1360,7 +1372,7 @@ ExprPtr Parser::parse_unary() {
                     if (is_probe) {
                         consume(TokenType::Question, "Expected '?'");
                     }
-                    std::string method = consume(TokenType::Identifier, "Expected method name").lexeme;
+                    std::string method = consume(TokenType::Identifier, "Expected method name").lexeme();
                     if (!check(TokenType::LeftParen)) {
                         if (is_probe) {
                             throw CompileError("Multi-receiver existence probes require call syntax", current().location);
@@ -1460,7 +1472,7 @@ ExprPtr Parser::parse_postfix_suffix(ExprPtr expr) {
         } else if (check_probe_dot()) {
             pos++; // consume '.'
             consume(TokenType::Question, "Expected '?'");
-            std::string member = consume(TokenType::Identifier, "Expected member name").lexeme;
+            std::string member = consume(TokenType::Identifier, "Expected member name").lexeme();
 
             if (check(TokenType::LeftParen)) {
                 pos++;
@@ -1483,7 +1495,7 @@ ExprPtr Parser::parse_postfix_suffix(ExprPtr expr) {
             }
         } else if (check_member_dot()) {
             pos++; // consume '.'
-            std::string member = consume(TokenType::Identifier, "Expected member name").lexeme;
+            std::string member = consume(TokenType::Identifier, "Expected member name").lexeme();
 
             // Check if this is a method call
             if (check(TokenType::LeftParen)) {
@@ -1526,11 +1538,11 @@ ExprPtr Parser::parse_primary() {
     if (check(TokenType::IntLiteral)) {
         Token t = current();
         pos++;
-        bool is_hex = t.lexeme.size() > 2 &&
-                      t.lexeme[0] == '0' &&
-                      (t.lexeme[1] == 'x' || t.lexeme[1] == 'X');
-        APInt value = APInt::parse_integer_literal(t.lexeme, loc);
-        auto e = Expr::make_int_exact(value, is_hex, loc, t.lexeme);
+        bool is_hex = t.text.size() > 2 &&
+                      t.text[0] == '0' &&
+                      (t.text[1] == 'x' || t.text[1] == 'X');
+        APInt value = APInt::parse_integer_literal(t.lexeme(), loc);
+        auto e = Expr::make_int_exact(value, is_hex, loc, t.lexeme());
         e->annotations = annotations;
         return e;
     }
@@ -1538,7 +1550,7 @@ ExprPtr Parser::parse_primary() {
     if (check(TokenType::FloatLiteral)) {
         double val = std::get<double>(current().value);
         pos++;
-        auto e = Expr::make_float(val, loc, tokens[pos - 1].lexeme);
+        auto e = Expr::make_float(val, loc, tokens.at(pos - 1).lexeme());
         e->annotations = annotations;
         return e;
     }
@@ -1554,7 +1566,7 @@ ExprPtr Parser::parse_primary() {
     if (check(TokenType::CharLiteral)) {
         uint64_t val = std::get<uint64_t>(current().value);
         pos++;
-        auto e = Expr::make_char(val, loc, tokens[pos - 1].lexeme);
+        auto e = Expr::make_char(val, loc, tokens.at(pos - 1).lexeme());
         e->annotations = annotations;
         return e;
     }
@@ -1573,27 +1585,27 @@ ExprPtr Parser::parse_primary() {
 
     if (check(TokenType::Hash)) {
         size_t scan = pos + 1;
-        bool looks_like_constructor = scan < tokens.size() && tokens[scan].type == TokenType::Identifier;
+        bool looks_like_constructor = tokens.contains(scan) && tokens.at(scan).type == TokenType::Identifier;
         if (looks_like_constructor) {
             ++scan;
-            while (scan < tokens.size() && tokens[scan].type == TokenType::DoubleColon) {
+            while (tokens.contains(scan) && tokens.at(scan).type == TokenType::DoubleColon) {
                 ++scan;
-                if (scan >= tokens.size() || tokens[scan].type != TokenType::Identifier) {
+                if (!tokens.contains(scan) || tokens.at(scan).type != TokenType::Identifier) {
                     looks_like_constructor = false;
                     break;
                 }
                 ++scan;
             }
             looks_like_constructor = looks_like_constructor &&
-                                     scan < tokens.size() &&
-                                     tokens[scan].type == TokenType::LeftParen;
+                                     tokens.contains(scan) &&
+                                     tokens.at(scan).type == TokenType::LeftParen;
         }
         if (looks_like_constructor) {
             consume(TokenType::Hash, "Expected '#'");
             std::vector<std::string> path;
-            path.push_back(consume(TokenType::Identifier, "Expected constructor type name after '#'").lexeme);
+            path.push_back(consume(TokenType::Identifier, "Expected constructor type name after '#'").lexeme());
             while (match(TokenType::DoubleColon)) {
-                path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme);
+                path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme());
             }
             consume(TokenType::LeftParen, "Expected '(' after constructor type name");
             std::vector<ExprPtr> args;
@@ -1616,7 +1628,7 @@ ExprPtr Parser::parse_primary() {
 
     // Expression parameter reference: $identifier
     if (match(TokenType::Dollar)) {
-        std::string name = consume(TokenType::Identifier, "Expected identifier after $").lexeme;
+        std::string name = consume(TokenType::Identifier, "Expected identifier after $").lexeme();
         auto id = Expr::make_identifier(name, loc);
         id->is_expr_param_ref = true;  // Mark as expression parameter reference
         id->annotations = annotations;
@@ -1625,11 +1637,11 @@ ExprPtr Parser::parse_primary() {
 
     if (check(TokenType::Identifier)) {
         std::vector<std::string> path;
-        path.push_back(current().lexeme);
+        path.push_back(current().lexeme());
         pos++;
 
         while (match(TokenType::DoubleColon)) {
-            path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme);
+            path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme());
         }
 
         auto id = Expr::make_identifier(path.back(), loc);
@@ -1652,7 +1664,7 @@ ExprPtr Parser::parse_primary() {
         return id;
     }
 
-    throw CompileError("Unexpected token in expression: " + current().lexeme, loc);
+    throw CompileError("Unexpected token in expression: " + current().lexeme(), loc);
 }
 
 ExprPtr Parser::parse_block() {
@@ -1703,9 +1715,9 @@ std::vector<std::string> Parser::parse_resource_path(bool leading_colon_already_
 
     std::vector<std::string> segments;
     auto parse_segment = [&]() {
-        std::string segment = consume(TokenType::Identifier, "Expected identifier").lexeme;
+        std::string segment = consume(TokenType::Identifier, "Expected identifier").lexeme();
         while (match(TokenType::Dot)) {
-            segment += "." + consume(TokenType::Identifier, "Expected identifier").lexeme;
+            segment += "." + consume(TokenType::Identifier, "Expected identifier").lexeme();
         }
         return segment;
     };
@@ -1743,7 +1755,7 @@ TypePtr Parser::parse_type() {
         consume(TokenType::RightBracket, "Expected ']'");
         type = Type::make_typeof(typeof_expr, loc);
     } else {
-        std::string name = consume(TokenType::Identifier, "Expected type name").lexeme;
+        std::string name = consume(TokenType::Identifier, "Expected type name").lexeme();
 
         // Check for primitive types
         auto parse_integer_primitive = [&](char prefix, PrimitiveType primitive_kind) -> TypePtr {
@@ -1785,7 +1797,7 @@ TypePtr Parser::parse_type() {
             Token frac_tok = consume(TokenType::IntLiteral, "Expected fixed-point fractional width after '.'");
             int64_t frac_bits = 0;
             try {
-                unsigned long long parsed = std::stoull(frac_tok.lexeme);
+                unsigned long long parsed = std::stoull(frac_tok.lexeme());
                 if (negative) {
                     if (parsed > static_cast<unsigned long long>(std::numeric_limits<int64_t>::max()) + 1ULL) {
                         throw std::out_of_range("fractional width underflow");
@@ -1803,25 +1815,25 @@ TypePtr Parser::parse_type() {
                 }
             } catch (const std::exception&) {
                 throw CompileError("Invalid fixed-point fractional width in type '#" + name + "." +
-                                       (negative ? "-" : "") + frac_tok.lexeme + "'",
+                                       (negative ? "-" : "") + frac_tok.lexeme() + "'",
                                    loc);
             }
 
             if (frac_bits == std::numeric_limits<int64_t>::min()) {
                 throw CompileError("Fixed-point fractional width is too negative in type '#" + name + "." +
-                                       (negative ? "-" : "") + frac_tok.lexeme + "'",
+                                       (negative ? "-" : "") + frac_tok.lexeme() + "'",
                                    loc);
             }
 
             int64_t total_bits = 0;
             if (base->integer_bits > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
                 throw CompileError("Fixed-point total width is too large in type '#" + name + "." +
-                                       (negative ? "-" : "") + frac_tok.lexeme + "'",
+                                       (negative ? "-" : "") + frac_tok.lexeme() + "'",
                                    loc);
             }
             total_bits = static_cast<int64_t>(base->integer_bits) + frac_bits;
             if (total_bits <= 0) {
-                throw CompileError("Fixed-point type '#" + name + "." + (negative ? "-" : "") + frac_tok.lexeme +
+                throw CompileError("Fixed-point type '#" + name + "." + (negative ? "-" : "") + frac_tok.lexeme() +
                                        "' must satisfy I + F > 0",
                                    loc);
             }
@@ -1883,7 +1895,7 @@ std::vector<Parameter> Parser::parse_params() {
         std::vector<Annotation> annotations = parse_annotations();
         SourceLocation loc = current().location;
         bool is_expr = match(TokenType::Dollar);
-        std::string name = consume(TokenType::Identifier, "Expected parameter name").lexeme;
+        std::string name = consume(TokenType::Identifier, "Expected parameter name").lexeme();
         TypePtr type = nullptr;
         if (match(TokenType::Colon)) {
             type = parse_type();
@@ -1899,7 +1911,7 @@ std::vector<std::string> Parser::parse_ref_params() {
     consume(TokenType::LeftParen, "Expected '('");
 
     do {
-        refs.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme);
+        refs.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme());
     } while (match(TokenType::Comma));
 
     consume(TokenType::RightParen, "Expected ')'");
@@ -1916,7 +1928,7 @@ std::vector<Field> Parser::parse_fields() {
     do {
         std::vector<Annotation> annotations = parse_annotations();
         SourceLocation loc = current().location;
-        std::string name = consume(TokenType::Identifier, "Expected field name").lexeme;
+        std::string name = consume(TokenType::Identifier, "Expected field name").lexeme();
         TypePtr type = nullptr;
         if (match(TokenType::Colon)) {
             type = parse_type();
@@ -1929,10 +1941,10 @@ std::vector<Field> Parser::parse_fields() {
 
 std::vector<std::string> Parser::parse_qualified_name() {
     std::vector<std::string> path;
-    path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme);
+    path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme());
 
     while (match(TokenType::DoubleColon)) {
-        path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme);
+        path.push_back(consume(TokenType::Identifier, "Expected identifier").lexeme());
     }
 
     return path;
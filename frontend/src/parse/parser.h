@@ -1,11 +1,12 @@
 #pragma once
 #include "lexer.h"
+#include "token_stream.h"
 #include "ast.h"
 
 namespace vexel {
 
 class Parser {
-    std::vector<Token> tokens;
+    TokenStream tokens;
     size_t pos;
     std::vector<Diagnostic> errors;
     bool panic_mode;
@@ -14,6 +15,8 @@ class Parser {
     int statement_expr_allowed_depth;
     bool split_top_level_plain_ampersand_funcs;
     int top_level_init_expr_root_depth;
+    // Per-module so generated names do not depend on module parse order.
+    int tuple_tmp_counter = 0;
 
     enum class AnnotationContext {
         TopLevel,
@@ -23,9 +26,21 @@ class Parser {
 
 public:
     Parser(std::vector<Token> toks);
+    // Pulls tokens from `lexer` on demand; the lexer must outlive the parser.
+    explicit Parser(Lexer& lexer);
     Module parse_module(const std::string& name, const std::string& path);
+    // Nodes naming each multi-assignment temporary, indexed by its number.
+    // Temporaries are numbered per module, so joining separately parsed chunks
+    // of one module (chunked_parse.h) renames those of later chunks.
+    struct TupleTmp {
+        StmtPtr decl;
+        std::vector<ExprPtr> refs;
+    };
+    const std::vector<TupleTmp>& tuple_tmps() const { return tuple_tmp_nodes; }
 
 private:
+    std::vector<TupleTmp> tuple_tmp_nodes;
+
     void synchronize();
     void record_error(const std::string& msg, const SourceLocation& loc);
     const Token& previous();
@@ -0,0 +1,50 @@
+#include "token_stream.h"
+
+namespace vexel {
+
+TokenStream::TokenStream(Lexer& lexer) : lexer_(&lexer) {}
+
+TokenStream::TokenStream(std::vector<Token> tokens)
+    : window_(std::make_move_iterator(tokens.begin()), std::make_move_iterator(tokens.end())),
+      at_end_(true) {
+    if (window_.empty() || window_.back().type != TokenType::EndOfFile) {
+        SourceLocation loc = window_.empty() ? SourceLocation() : window_.back().location;
+        window_.emplace_back(TokenType::EndOfFile, "", loc);
+    }
+}
+
+bool TokenStream::fill_to(size_t index) const {
+    while (!at_end_ && index >= base_ + window_.size()) {
+        try {
+            window_.push_back(lexer_->next_token());
+            at_end_ = window_.back().type == TokenType::EndOfFile;
+        } catch (const CompileError& e) {
+            lex_error_ = std::current_exception();
+            at_end_ = true;
+            window_.emplace_back(TokenType::EndOfFile, "", e.location);
+        }
+    }
+    return index >= base_ && index < base_ + window_.size();
+}
+
+const Token& TokenStream::at(size_t index) const {
+    if (!fill_to(index)) return window_.back();
+    return window_[index - base_];
+}
+
+bool TokenStream::contains(size_t index) const {
+    return fill_to(index);
+}
+
+void TokenStream::release_before(size_t index) {
+    while (base_ < index && window_.size() > 1) {
+        window_.pop_front();
+        ++base_;
+    }
+}
+
+void TokenStream::rethrow_lex_error() const {
+    if (lex_error_) std::rethrow_exception(lex_error_);
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "lexer.h"
+#include <deque>
+#include <exception>
+
+namespace vexel {
+
+// Pull-based token window between the Lexer and the Parser. Tokens are lexed
+// on demand and addressed by absolute index; the parser releases the prefix it
+// will never revisit, so only the tokens of the item being parsed (plus its
+// lookahead) stay resident. Accessors are const because pulling more tokens
+// does not change what the stream denotes.
+class TokenStream {
+public:
+    explicit TokenStream(Lexer& lexer);
+    explicit TokenStream(std::vector<Token> tokens);
+
+    // Token at `index`; indices past the end yield the EndOfFile token.
+    const Token& at(size_t index) const;
+    // True when `index` names a real token (EndOfFile included).
+    bool contains(size_t index) const;
+    // Drops tokens below `index`. References to retained tokens stay valid.
+    void release_before(size_t index);
+    size_t buffered() const { return window_.size(); }
+
+    // A lexer error ends the stream with a synthetic EndOfFile so speculative
+    // parses cannot swallow it; the parser rethrows it once it stops.
+    bool lex_failed() const { return static_cast<bool>(lex_error_); }
+    void rethrow_lex_error() const;
+
+private:
+    bool fill_to(size_t index) const;
+
+    Lexer* lexer_ = nullptr;
+    mutable std::deque<Token> window_;
+    size_t base_ = 0;
+    mutable bool at_end_ = false;
+    mutable std::exception_ptr lex_error_;
+};
+
+}
@@ -21,6 +21,16 @@ AnalyzedProgram make_analyzed_program(const Module& merged,
 
     out.forced_tuple_types = &checker.get_forced_tuple_types();
 
+    auto tables = std::make_shared<AnalyzedTables>();
+    tables->bindings = checker.get_bindings();
+    tables->type_vars = checker.get_type_vars();
+    if (out.program) {
+        for (const auto& instance : out.program->instances) {
+            tables->instance_scopes[instance.id] = checker.instance_scope(instance.id);
+        }
+    }
+    out.tables = std::move(tables);
+
     out.binding_for = [&checker](int instance_id, const void* node) -> Symbol* {
         if (!node) return nullptr;
         return checker.binding_for(instance_id, node);
@@ -32,15 +42,7 @@ AnalyzedProgram make_analyzed_program(const Module& merged,
 
     out.constexpr_condition = [&optimization](int instance_id, ExprPtr expr) -> std::optional<bool> {
         if (!expr) return std::nullopt;
-        auto cond_it = optimization.constexpr_conditions.find(expr_fact_key(instance_id, expr.get()));
-        if (cond_it != optimization.constexpr_conditions.end()) {
-            return cond_it->second;
-        }
-        auto value_it = optimization.constexpr_values.find(expr_fact_key(instance_id, expr.get()));
-        if (value_it == optimization.constexpr_values.end()) {
-            return std::nullopt;
-        }
-        return cte_scalar_to_bool(value_it->second);
+        return optimization.constexpr_condition(expr_fact_key(instance_id, expr.get()));
     };
 
     out.lookup_type_symbol = [&checker](int instance_id, const std::string& type_name) -> Symbol* {
@@ -0,0 +1,715 @@
+#include "analyzed_program_io.h"
+
+#include "ast_codec.h"
+#include "cte_persistent_cache.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace vexel {
+
+namespace {
+
+// Bump when the layout below changes. The build stamp keeps programs written
+// by a different compiler build (with possibly different AST fields or fact
+// meanings) from being loaded.
+constexpr const char* kAnalyzedHeader = "vexel-analyzed-program 3 " __DATE__ " " __TIME__;
+
+// Binding keys are AST nodes or members of one: parameters and reference
+// parameter names are addressed by their statement and index.
+enum class BoundNode : uint8_t { Expr, Stmt, Type, Param, RefParam };
+
+struct BindingRecord {
+    BoundNode kind;
+    uint64_t node;
+    uint64_t index;
+    int instance_id;
+    const Symbol* symbol;
+    bool new_variable;
+
+    bool operator<(const BindingRecord& other) const {
+        return std::tie(kind, node, index, instance_id) <
+               std::tie(other.kind, other.node, other.index, other.instance_id);
+    }
+};
+
+template <typename Map>
+std::vector<typename Map::key_type> sorted_keys(const Map& map) {
+    std::vector<typename Map::key_type> keys;
+    keys.reserve(map.size());
+    for (const auto& entry : map) keys.push_back(entry.first);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+bool by_symbol_id(const Symbol* a, const Symbol* b) { return a->id < b->id; }
+
+class AnalyzedWriter {
+public:
+    explicit AnalyzedWriter(const AnalyzedProgram& program) : in_(program), enc_("", semantic()) {}
+
+    std::string write(const AnalyzedProgramOrigin& origin) {
+        const Program& program = *in_.program;
+        write_origin(enc_, origin);
+        enc_.u64(program.symbols.size());
+
+        enc_.u64(program.modules.size());
+        for (const ModuleInfo& info : program.modules) {
+            enc_.i64(info.id);
+            enc_.str(info.path);
+            enc_.u64(static_cast<uint64_t>(info.origin));
+            enc_.str(info.module.name);
+            enc_.str(info.module.path);
+            enc_.module(info.module);
+            enc_.flag(info.declarations != nullptr);
+            if (info.declarations) {
+                enc_.u64(info.declarations->entries.size());
+                for (const ModuleDeclarations::Entry& entry : info.declarations->entries) {
+                    enc_.u64(static_cast<uint64_t>(entry.kind));
+                    enc_.str(entry.name);
+                    enc_.str(entry.surface_name);
+                }
+            }
+        }
+        enc_.u64(program.path_to_id.size());
+        for (const std::string& path : sorted_keys(program.path_to_id)) {
+            enc_.str(path);
+            enc_.i64(program.path_to_id.at(path));
+        }
+        enc_.str(in_.module->name);
+        enc_.str(in_.module->path);
+        enc_.module(*in_.module);
+
+        enc_.u64(program.instances.size());
+        for (const ModuleInstance& instance : program.instances) {
+            enc_.i64(instance.id);
+            enc_.i64(instance.module_id);
+            enc_.i64(instance.scope_id);
+            symbol_list(instance.declared);
+            symbol_table(instance.generated);
+            enc_.u64(instance.imports.size());
+            for (ModuleInstanceId imported : instance.imports) enc_.i64(imported);
+        }
+
+        for (const auto& sym : program.symbols) {
+            enc_.u64(static_cast<uint64_t>(sym->kind));
+            enc_.str(sym->name);
+            enc_.str(sym->surface_name);
+            enc_.type(sym->type);
+            enc_.flag(sym->is_mutable);
+            enc_.flag(sym->is_external);
+            enc_.flag(sym->is_backend_bound);
+            enc_.flag(sym->is_exported);
+            enc_.flag(sym->is_resource_binding);
+            enc_.stmt(sym->declaration);
+            enc_.i64(sym->module_id);
+            enc_.i64(sym->instance_id);
+            enc_.flag(sym->is_local);
+        }
+
+        enc_.i64(in_.entry_instance_id);
+        const auto no_tuples = std::unordered_map<std::string, std::vector<TypePtr>>();
+        const auto& tuples = in_.forced_tuple_types ? *in_.forced_tuple_types : no_tuples;
+        enc_.u64(tuples.size());
+        for (const std::string& name : sorted_keys(tuples)) {
+            enc_.str(name);
+            enc_.u64(tuples.at(name).size());
+            for (const TypePtr& type : tuples.at(name)) enc_.type(type);
+        }
+
+        const AnalyzedTables& tables = *in_.tables;
+        // Per variable id: its node, the id spelling its class and the
+        // class binding.
+        const TypeVarTable& type_vars = tables.type_vars;
+        enc_.u64(type_vars.size());
+        for (int id = 0; id < static_cast<int>(type_vars.size()); ++id) {
+            enc_.type(type_vars.node(id));
+            enc_.i64(type_vars.representative_id(id));
+            enc_.type(type_vars.binding(id));
+        }
+        enc_.u64(tables.instance_scopes.size());
+        for (int instance_id : sorted_keys(tables.instance_scopes)) {
+            enc_.i64(instance_id);
+            std::vector<std::pair<std::string, const Symbol*>> types;
+            if (const Scope* scope = tables.instance_scopes.at(instance_id)) {
+                scope->for_each_visible_type(
+                    [&](const std::string& name, const Symbol* sym) { types.emplace_back(name, sym); });
+            }
+            std::sort(types.begin(), types.end());
+            enc_.u64(types.size());
+            for (const auto& entry : types) {
+                enc_.str(entry.first);
+                enc_.symbol(entry.second);
+            }
+        }
+        write_bindings(tables.bindings);
+
+        write_analysis(*in_.analysis);
+        write_optimization(*in_.optimization);
+        return enc_.finish(kAnalyzedHeader);
+    }
+
+    static void write_origin(AstEncoder& enc, const AnalyzedProgramOrigin& origin) {
+        enc.str(origin.input_file);
+        enc.str(origin.backend);
+        enc.u64(origin.backend_options.size());
+        for (const auto& entry : origin.backend_options) {
+            enc.str(entry.first);
+            enc.str(entry.second);
+        }
+        enc.u64(origin.analysis_passes);
+        enc.u64(static_cast<uint8_t>(origin.default_entry_reentrancy));
+        enc.u64(static_cast<uint8_t>(origin.default_exit_reentrancy));
+        for (const auto* digests : {&origin.files, &origin.directories}) {
+            enc.u64(digests->size());
+            for (const auto& entry : *digests) {
+                enc.str(entry.first);
+                enc.str(entry.second);
+            }
+        }
+    }
+
+private:
+    const AnalyzedProgram& in_;
+    AstEncoder enc_;
+
+    static AstEncoder::Config semantic() {
+        AstEncoder::Config config;
+        config.semantic = true;
+        return config;
+    }
+
+    void symbol_table(const std::unordered_map<std::string, Symbol*>& table) {
+        enc_.u64(table.size());
+        for (const std::string& name : sorted_keys(table)) {
+            enc_.str(name);
+            enc_.symbol(table.at(name));
+        }
+    }
+
+    template <typename Symbols>
+    void symbol_list(const Symbols& symbols) {
+        enc_.u64(symbols.size());
+        for (const Symbol* sym : symbols) enc_.symbol(sym);
+    }
+
+    // Only bindings of nodes the trees above contain are kept; every other
+    // node is unreachable from the handed-off program.
+    void write_bindings(const Bindings* bindings) {
+        std::unordered_map<const void*, std::pair<uint64_t, std::pair<BoundNode, uint64_t>>> members;
+        for (const auto& entry : enc_.stmt_ids()) {
+            const Stmt& stmt = *entry.first;
+            for (size_t i = 0; i < stmt.params.size(); ++i) {
+                members[&stmt.params[i]] = {entry.second, {BoundNode::Param, i}};
+            }
+            for (size_t i = 0; i < stmt.ref_params.size(); ++i) {
+                members[&stmt.ref_params[i]] = {entry.second, {BoundNode::RefParam, i}};
+            }
+        }
+        std::vector<BindingRecord> records;
+        if (bindings) {
+            bindings->for_each([&](int instance_id, const void* node, const Symbol* sym, bool new_variable) {
+                BindingRecord record{BoundNode::Expr, 0, 0, instance_id, sym, new_variable};
+                if (enc_.expr_id(static_cast<const Expr*>(node), record.node)) {
+                    record.kind = BoundNode::Expr;
+                } else if (enc_.stmt_id(static_cast<const Stmt*>(node), record.node)) {
+                    record.kind = BoundNode::Stmt;
+                } else if (enc_.type_id(static_cast<const Type*>(node), record.node)) {
+                    record.kind = BoundNode::Type;
+                } else {
+                    auto member = members.find(node);
+                    if (member == members.end()) return;
+                    record.node = member->second.first;
+                    record.kind = member->second.second.first;
+                    record.index = member->second.second.second;
+                }
+                records.push_back(record);
+            });
+        }
+        std::sort(records.begin(), records.end());
+        enc_.u64(records.size());
+        for (const BindingRecord& record : records) {
+            enc_.u64(static_cast<uint64_t>(record.kind));
+            enc_.u64(record.node);
+            enc_.u64(record.index);
+            enc_.i64(record.instance_id);
+            enc_.symbol(record.symbol);
+            enc_.flag(record.new_variable);
+        }
+    }
+
+    template <typename T, typename WriteValue>
+    void symbol_map(const SymbolMap<T>& map, WriteValue&& write_value) {
+        enc_.u64(map.size());
+        for (const auto& entry : map) {
+            enc_.symbol(entry.first);
+            write_value(entry.second);
+        }
+    }
+
+    void write_analysis(const AnalysisFacts& facts) {
+        symbol_list(facts.reachable_functions);
+        symbol_map(facts.var_mutability, [&](VarMutability value) { enc_.u64(static_cast<uint64_t>(value)); });
+        symbol_map(facts.receiver_mutates, [&](const std::vector<bool>& flags) {
+            enc_.u64(flags.size());
+            for (bool flag : flags) enc_.flag(flag);
+        });
+        symbol_map(facts.ref_variants, [&](const std::unordered_set<std::string>& variants) {
+            std::vector<std::string> sorted(variants.begin(), variants.end());
+            std::sort(sorted.begin(), sorted.end());
+            enc_.strings(sorted);
+        });
+        for (const SymbolMap<bool>* map : {&facts.function_writes_global, &facts.function_is_pure,
+                                           &facts.function_reads_global, &facts.function_writes_params}) {
+            symbol_map(*map, [&](bool value) { enc_.flag(value); });
+        }
+        symbol_list(facts.used_global_vars);
+        std::vector<std::string> type_names(facts.used_type_names.begin(), facts.used_type_names.end());
+        std::sort(type_names.begin(), type_names.end());
+        enc_.strings(type_names);
+        symbol_map(facts.reentrancy_variants, [&](const std::unordered_set<char>& variants) {
+            std::string sorted(variants.begin(), variants.end());
+            std::sort(sorted.begin(), sorted.end());
+            enc_.str(sorted);
+        });
+    }
+
+    // Facts about nodes outside the encoded trees are dropped, like bindings.
+    template <typename Value, typename WriteValue>
+    void expr_facts(const std::unordered_map<ExprFactKey, Value, ExprFactKeyHash>& facts,
+                    WriteValue&& write_value) {
+        std::vector<std::tuple<uint64_t, int, const Value*>> kept;
+        for (const auto& entry : facts) {
+            uint64_t id = 0;
+            if (enc_.expr_id(entry.first.expr, id)) kept.emplace_back(id, entry.first.instance_id, &entry.second);
+        }
+        std::sort(kept.begin(), kept.end());
+        enc_.u64(kept.size());
+        for (const auto& fact : kept) {
+            enc_.u64(std::get<0>(fact));
+            enc_.i64(std::get<1>(fact));
+            write_value(*std::get<2>(fact));
+        }
+    }
+
+    void write_optimization(const OptimizationFacts& facts) {
+        static const ConstexprFactStore kNoFacts;
+        const ConstexprFactStore& store = facts.constexpr_facts ? *facts.constexpr_facts : kNoFacts;
+        expr_facts(store.values(), [&](const CTValue& value) { enc_.str(encode_ct_value(value)); });
+        expr_facts(store.conditions(), [&](bool value) { enc_.flag(value); });
+
+        std::vector<std::pair<uint64_t, int>> inits;
+        for (const StmtFactKey& key : facts.constexpr_inits) {
+            uint64_t id = 0;
+            if (enc_.stmt_id(key.stmt, id)) inits.emplace_back(id, key.instance_id);
+        }
+        std::sort(inits.begin(), inits.end());
+        enc_.u64(inits.size());
+        for (const auto& init : inits) {
+            enc_.u64(init.first);
+            enc_.i64(init.second);
+        }
+
+        std::vector<const Symbol*> foldable(facts.foldable_functions.begin(), facts.foldable_functions.end());
+        std::sort(foldable.begin(), foldable.end(), by_symbol_id);
+        symbol_list(foldable);
+        std::vector<const Symbol*> skipped = sorted_keys(facts.fold_skip_reasons);
+        std::sort(skipped.begin(), skipped.end(), by_symbol_id);
+        enc_.u64(skipped.size());
+        for (const Symbol* sym : skipped) {
+            enc_.symbol(sym);
+            enc_.str(facts.fold_skip_reasons.at(sym));
+        }
+        enc_.u64(facts.specializations.size());
+        for (const auto& spec : facts.specializations) {
+            enc_.symbol(spec.clone);
+            enc_.symbol(spec.original);
+            enc_.str(spec.bindings);
+        }
+        enc_.u64(facts.loop_rewrites.size());
+        for (const auto& rewrite : facts.loop_rewrites) {
+            enc_.symbol(rewrite.function);
+            enc_.u64(rewrite.hoisted);
+            enc_.u64(rewrite.strength_reduced);
+        }
+    }
+};
+
+class AnalyzedReader {
+public:
+    AnalyzedReader(const std::string& data, LoadedAnalyzedProgram& out)
+        : out_(out), dec_(data, "", true, &symbols_) {}
+
+    static bool read_origin(AstDecoder& dec, AnalyzedProgramOrigin& origin) {
+        origin.input_file = dec.str();
+        origin.backend = dec.str();
+        const uint64_t option_count = dec.count();
+        for (uint64_t i = 0; i < option_count && dec.ok(); ++i) {
+            std::string key = dec.str();
+            origin.backend_options[key] = dec.str();
+        }
+        origin.analysis_passes = static_cast<uint32_t>(dec.u64());
+        origin.default_entry_reentrancy = static_cast<char>(dec.u64());
+        origin.default_exit_reentrancy = static_cast<char>(dec.u64());
+        for (auto* digests : {&origin.files, &origin.directories}) {
+            const uint64_t count = dec.count();
+            for (uint64_t i = 0; i < count && dec.ok(); ++i) {
+                std::string path = dec.str();
+                digests->emplace_back(std::move(path), dec.str());
+            }
+        }
+        return dec.ok();
+    }
+
+    bool read() {
+        if (!dec_.begin(kAnalyzedHeader) || !read_origin(dec_, out_.origin)) return false;
+        Program& program = out_.state;
+        AstArenaScope arena_scope(program.ast_arena);
+
+        const uint64_t symbol_count = dec_.count();
+        for (uint64_t i = 0; i < symbol_count && dec_.ok(); ++i) {
+            auto sym = std::make_unique<Symbol>();
+            sym->id = static_cast<int>(i);
+            symbols_.push_back(sym.get());
+            program.symbols.push_back(std::move(sym));
+        }
+
+        const uint64_t module_count = dec_.count();
+        for (uint64_t i = 0; i < module_count && dec_.ok(); ++i) {
+            ModuleInfo info;
+            info.id = static_cast<ModuleId>(dec_.i64());
+            info.path = dec_.str();
+            const uint64_t origin = dec_.u64();
+            if (origin > static_cast<uint64_t>(ModuleOrigin::BundledStd)) dec_.fail();
+            info.origin = static_cast<ModuleOrigin>(dec_.ok() ? origin : 0);
+            info.module.name = dec_.str();
+            info.module.path = dec_.str();
+            dec_.module(info.module);
+            if (dec_.flag()) {
+                auto decls = std::make_shared<ModuleDeclarations>();
+                const uint64_t entry_count = dec_.count();
+                for (uint64_t j = 0; j < entry_count && dec_.ok(); ++j) {
+                    const uint64_t kind = dec_.u64();
+                    if (kind > static_cast<uint64_t>(Symbol::Kind::Constant)) dec_.fail();
+                    std::string name = dec_.str();
+                    std::string surface_name = dec_.str();
+                    if (dec_.ok()) decls->add(static_cast<Symbol::Kind>(kind), name, surface_name);
+                }
+                info.declarations = std::move(decls);
+            }
+            program.modules.push_back(std::move(info));
+        }
+        const uint64_t path_count = dec_.count();
+        for (uint64_t i = 0; i < path_count && dec_.ok(); ++i) {
+            std::string path = dec_.str();
+            program.path_to_id[path] = static_cast<ModuleId>(dec_.i64());
+        }
+        out_.merged.name = dec_.str();
+        out_.merged.path = dec_.str();
+        dec_.module(out_.merged);
+
+        const uint64_t instance_count = dec_.count();
+        for (uint64_t i = 0; i < instance_count && dec_.ok(); ++i) {
+            ModuleInstance instance;
+            instance.id = static_cast<ModuleInstanceId>(dec_.i64());
+            instance.module_id = static_cast<ModuleId>(dec_.i64());
+            instance.scope_id = static_cast<int>(dec_.i64());
+            instance.declared = symbol_list();
+            symbol_table(instance.generated);
+            const ModuleInfo* mod_info = program.module(instance.module_id);
+            instance.declarations = mod_info ? mod_info->declarations : nullptr;
+            const size_t entry_count = instance.declarations ? instance.declarations->entries.size() : 0;
+            if (instance.declared.size() != entry_count) dec_.fail();
+            const uint64_t import_count = dec_.count();
+            for (uint64_t j = 0; j < import_count && dec_.ok(); ++j) {
+                instance.imports.push_back(static_cast<ModuleInstanceId>(dec_.i64()));
+            }
+            program.instances.push_back(std::move(instance));
+        }
+
+        for (Symbol* sym : symbols_) {
+            if (!dec_.ok()) break;
+            const uint64_t kind = dec_.u64();
+            if (kind > static_cast<uint64_t>(Symbol::Kind::Constant)) dec_.fail();
+            sym->kind = static_cast<Symbol::Kind>(dec_.ok() ? kind : 0);
+            sym->name = dec_.str();
+            sym->surface_name = dec_.str();
+            sym->type = dec_.type();
+            sym->is_mutable = dec_.flag();
+            sym->is_external = dec_.flag();
+            sym->is_backend_bound = dec_.flag();
+            sym->is_exported = dec_.flag();
+            sym->is_resource_binding = dec_.flag();
+            sym->declaration = dec_.stmt();
+            sym->module_id = static_cast<int>(dec_.i64());
+            sym->instance_id = static_cast<int>(dec_.i64());
+            sym->is_local = dec_.flag();
+        }
+
+        const int entry_instance_id = static_cast<int>(dec_.i64());
+        const uint64_t tuple_count = dec_.count();
+        for (uint64_t i = 0; i < tuple_count && dec_.ok(); ++i) {
+            std::string name = dec_.str();
+            std::vector<TypePtr>& elems = out_.forced_tuple_types[name];
+            const uint64_t elem_count = dec_.count();
+            for (uint64_t j = 0; j < elem_count && dec_.ok(); ++j) elems.push_back(dec_.type());
+        }
+
+        auto tables = std::make_shared<AnalyzedTables>();
+        const uint64_t var_count = dec_.count();
+        for (uint64_t i = 0; i < var_count && dec_.ok(); ++i) {
+            const int id = static_cast<int>(i);
+            TypePtr node = dec_.type();
+            if (node && node->var_id != id) dec_.fail();
+            tables->type_vars.add(node);
+            const int64_t representative = dec_.i64();
+            if (representative < 0 || static_cast<uint64_t>(representative) >= var_count) dec_.fail();
+            if (dec_.ok() && representative != id) {
+                tables->type_vars.unite(id, static_cast<int>(representative));
+            }
+            if (TypePtr bound = dec_.type()) tables->type_vars.bind(id, std::move(bound));
+        }
+        const uint64_t scope_count = dec_.count();
+        for (uint64_t i = 0; i < scope_count && dec_.ok(); ++i) {
+            const int instance_id = static_cast<int>(dec_.i64());
+            auto scope = std::make_unique<Scope>();
+            const uint64_t type_count = dec_.count();
+            for (uint64_t j = 0; j < type_count && dec_.ok(); ++j) {
+                std::string name = dec_.str();
+                Symbol* sym = dec_.symbol();
+                if (!sym) {
+                    dec_.fail();
+                    break;
+                }
+                try {
+                    scope->define_type(name, sym);
+                } catch (const CompileError&) {
+                    dec_.fail();
+                }
+            }
+            tables->instance_scopes[instance_id] = scope.get();
+            out_.instance_scopes.push_back(std::move(scope));
+        }
+        read_bindings();
+        tables->bindings = &out_.bindings;
+
+        read_analysis(out_.analysis);
+        read_optimization(out_.optimization);
+        if (!dec_.ok() || !dec_.at_end()) return false;
+
+        AnalyzedProgram& view = out_.program;
+        view.module = &out_.merged;
+        view.program = &out_.state;
+        view.analysis = &out_.analysis;
+        view.optimization = &out_.optimization;
+        view.entry_instance_id = entry_instance_id;
+        view.forced_tuple_types = &out_.forced_tuple_types;
+        view.tables = std::move(tables);
+        return true;
+    }
+
+private:
+    LoadedAnalyzedProgram& out_;
+    std::vector<Symbol*> symbols_;
+    AstDecoder dec_;
+
+    // A present entry that names no symbol is damage, not an absent value.
+    Symbol* required_symbol() {
+        Symbol* sym = dec_.symbol();
+        if (!sym) dec_.fail();
+        return sym;
+    }
+
+    void symbol_table(std::unordered_map<std::string, Symbol*>& table) {
+        const uint64_t count = dec_.count();
+        for (uint64_t i = 0; i < count && dec_.ok(); ++i) {
+            std::string name = dec_.str();
+            table[name] = dec_.symbol();
+        }
+    }
+
+    std::vector<Symbol*> symbol_list() {
+        std::vector<Symbol*> symbols;
+        const uint64_t count = dec_.count();
+        for (uint64_t i = 0; i < count && dec_.ok(); ++i) symbols.push_back(dec_.symbol());
+        return symbols;
+    }
+
+    template <typename Node>
+    const Node* node_at(const std::vector<std::shared_ptr<Node>>& nodes, uint64_t id) {
+        if (id >= nodes.size()) {
+            dec_.fail();
+            return nullptr;
+        }
+        return nodes[id].get();
+    }
+
+    void read_bindings() {
+        const uint64_t count = dec_.count();
+        for (uint64_t i = 0; i < count && dec_.ok(); ++i) {
+            const uint64_t kind = dec_.u64();
+            const uint64_t id = dec_.u64();
+            const uint64_t index = dec_.u64();
+            const int instance_id = static_cast<int>(dec_.i64());
+            Symbol* sym = dec_.symbol();
+            const bool new_variable = dec_.flag();
+            const void* node = nullptr;
+            switch (static_cast<BoundNode>(kind)) {
+                case BoundNode::Expr:
+                    node = node_at(dec_.exprs_read(), id);
+                    break;
+                case BoundNode::Stmt:
+                    node = node_at(dec_.stmts_read(), id);
+                    break;
+                case BoundNode::Type:
+                    node = node_at(dec_.types_read(), id);
+                    break;
+                case BoundNode::Param:
+                case BoundNode::RefParam: {
+                    const Stmt* stmt = node_at(dec_.stmts_read(), id);
+                    if (!stmt) break;
+                    const bool param = static_cast<BoundNode>(kind) == BoundNode::Param;
+                    if (index >= (param ? stmt->params.size() : stmt->ref_params.size())) break;
+                    node = param ? static_cast<const void*>(&stmt->params[index])
+                                 : static_cast<const void*>(&stmt->ref_params[index]);
+                    break;
+                }
+            }
+            if (!node) {
+                dec_.fail();
+                break;
+            }
+            out_.bindings.bind(instance_id, node, sym);
+            if (new_variable) out_.bindings.set_new_variable(instance_id, node, true);
+        }
+    }
+
+    template <typename T, typename ReadValue>
+    void symbol_map(SymbolMap<T>& map, ReadValue&& read_value) {
+        const uint64_t count = dec_.count();
+        for (uint64_t i = 0; i < count && dec_.ok(); ++i) {
+            Symbol* sym = required_symbol();
+            T value = read_value();
+            if (sym) map[sym] = std::move(value);
+        }
+    }
+
+    void symbol_set(SymbolSet& set) {
+        const uint64_t count = dec_.count();
+        for (uint64_t i = 0; i < count && dec_.ok(); ++i) {
+            if (Symbol* sym = required_symbol()) set.insert(sym);
+        }
+    }
+
+    void read_analysis(AnalysisFacts& facts) {
+        symbol_set(facts.reachable_functions);
+        symbol_map(facts.var_mutability, [&]() {
+            const uint64_t value = dec_.u64();
+            if (value > static_cast<uint64_t>(VarMutability::Constexpr)) dec_.fail();
+            return static_cast<VarMutability>(dec_.ok() ? value : 0);
+        });
+        symbol_map(facts.receiver_mutates, [&]() {
+            std::vector<bool> flags;
+            const uint64_t count = dec_.count();
+            for (uint64_t i = 0; i < count && dec_.ok(); ++i) flags.push_back(dec_.flag());
+            return flags;
+        });
+        symbol_map(facts.ref_variants, [&]() {
+            std::vector<std::string> variants = dec_.strings();
+            return std::unordered_set<std::string>(variants.begin(), variants.end());
+        });
+        for (SymbolMap<bool>* map : {&facts.function_writes_global, &facts.function_is_pure,
+                                     &facts.function_reads_global, &facts.function_writes_params}) {
+            symbol_map(*map, [&]() { return dec_.flag(); });
+        }
+        symbol_set(facts.used_global_vars);
+        std::vector<std::string> type_names = dec_.strings();
+        facts.used_type_names.insert(type_names.begin(), type_names.end());
+        symbol_map(facts.reentrancy_variants, [&]() {
+            std::string variants = dec_.str();
+            return std::unordered_set<char>(variants.begin(), variants.end());
+        });
+    }
+
+    template <typename Publish>
+    void expr_facts(Publish&& publish) {
+        const uint64_t count = dec_.count();
+        for (uint64_t i = 0; i < count && dec_.ok(); ++i) {
+            const Expr* expr = node_at(dec_.exprs_read(), dec_.u64());
+            const int instance_id = static_cast<int>(dec_.i64());
+            publish(expr_fact_key(instance_id, expr));
+        }
+    }
+
+    void read_optimization(OptimizationFacts& facts) {
+        ConstexprFactStore& store = out_.constexpr_facts;
+        expr_facts([&](const ExprFactKey& key) {
+            CTValue value;
+            if (!decode_ct_value(dec_.str(), value)) {
+                dec_.fail();
+                return;
+            }
+            store.publish_value(key, std::move(value));
+        });
+        expr_facts([&](const ExprFactKey& key) { store.publish_condition(key, dec_.flag()); });
+        facts.constexpr_facts = &store;
+
+        const uint64_t init_count = dec_.count();
+        for (uint64_t i = 0; i < init_count && dec_.ok(); ++i) {
+            const Stmt* stmt = node_at(dec_.stmts_read(), dec_.u64());
+            facts.constexpr_inits.insert(stmt_fact_key(static_cast<int>(dec_.i64()), stmt));
+        }
+        for (Symbol* sym : symbol_list()) {
+            if (sym) facts.foldable_functions.insert(sym);
+        }
+        const uint64_t skip_count = dec_.count();
+        for (uint64_t i = 0; i < skip_count && dec_.ok(); ++i) {
+            Symbol* sym = required_symbol();
+            std::string reason = dec_.str();
+            if (sym) facts.fold_skip_reasons[sym] = std::move(reason);
+        }
+        const uint64_t spec_count = dec_.count();
+        for (uint64_t i = 0; i < spec_count && dec_.ok(); ++i) {
+            OptimizationFacts::Specialization spec;
+            spec.clone = dec_.symbol();
+            spec.original = dec_.symbol();
+            spec.bindings = dec_.str();
+            facts.specializations.push_back(std::move(spec));
+        }
+        const uint64_t rewrite_count = dec_.count();
+        for (uint64_t i = 0; i < rewrite_count && dec_.ok(); ++i) {
+            OptimizationFacts::LoopRewrite rewrite;
+            rewrite.function = dec_.symbol();
+            rewrite.hoisted = static_cast<size_t>(dec_.u64());
+            rewrite.strength_reduced = static_cast<size_t>(dec_.u64());
+            facts.loop_rewrites.push_back(rewrite);
+        }
+    }
+};
+
+} // namespace
+
+std::string serialize_analyzed_program(const AnalyzedProgram& program, const AnalyzedProgramOrigin& origin) {
+    if (!program.module || !program.program || !program.analysis || !program.optimization || !program.tables) {
+        throw CompileError("Internal error: serializing an incomplete analyzed program", SourceLocation());
+    }
+    AnalyzedWriter writer(program);
+    return writer.write(origin);
+}
+
+std::unique_ptr<LoadedAnalyzedProgram> deserialize_analyzed_program(const std::string& data) {
+    auto loaded = std::make_unique<LoadedAnalyzedProgram>();
+    AnalyzedReader reader(data, *loaded);
+    if (!reader.read()) return nullptr;
+    return loaded;
+}
+
+bool read_analyzed_program_origin(const std::string& data, AnalyzedProgramOrigin& out) {
+    AstDecoder dec(data, "");
+    AnalyzedProgramOrigin origin;
+    if (!dec.begin(kAnalyzedHeader) || !AnalyzedReader::read_origin(dec, origin)) return false;
+    out = std::move(origin);
+    return true;
+}
+
+} // namespace vexel
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "analysis.h"
+#include "analyzed_program.h"
+#include "bindings.h"
+#include "constexpr_facts.h"
+#include "optimizer.h"
+#include "program.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vexel {
+
+// What an analyzed program was built for, stored with it so a consumer can
+// tell whether it may emit from it: the input file, the backend whose analysis
+// requirements and boundary reentrancy modes shaped the facts (with the
+// backend options those were queried under), and the files and directories
+// the frontend read as (path, digest) pairs.
+struct AnalyzedProgramOrigin {
+    std::string input_file;
+    std::string backend;
+    std::map<std::string, std::string> backend_options;
+    uint32_t analysis_passes = kAllAnalysisPasses;
+    char default_entry_reentrancy = 'R';
+    char default_exit_reentrancy = 'R';
+    std::vector<std::pair<std::string, std::string>> files;
+    std::vector<std::pair<std::string, std::string>> directories;
+};
+
+// A decoded analyzed program together with the state it points into.
+// `program` refers to the other members, so the object is not copyable.
+struct LoadedAnalyzedProgram {
+    AnalyzedProgramOrigin origin;
+    Program state;
+    Module merged;
+    Bindings bindings;
+    AnalysisFacts analysis;
+    ConstexprFactStore constexpr_facts;
+    OptimizationFacts optimization;
+    std::unordered_map<std::string, std::vector<TypePtr>> forced_tuple_types;
+    std::vector<std::unique_ptr<Scope>> instance_scopes;
+    AnalyzedProgram program;
+
+    LoadedAnalyzedProgram() = default;
+    LoadedAnalyzedProgram(const LoadedAnalyzedProgram&) = delete;
+    LoadedAnalyzedProgram& operator=(const LoadedAnalyzedProgram&) = delete;
+};
+
+// Versioned binary encoding of the frontend->backend contract: the merged
+// module and every module's tree with their resolved symbols, the program's
+// symbols and instances, the AnalyzedTables snapshot, and the analysis and
+// optimization facts backends read. Requires `program.tables`. The
+// std::function hooks are not encoded; a loaded program answers every query
+// from its tables. Checker-internal and rerun-only state (checked conditions,
+// refreshed top-level statements) is left out.
+std::string serialize_analyzed_program(const AnalyzedProgram& program, const AnalyzedProgramOrigin& origin);
+// Null when `data` was not written by this compiler build or is damaged.
+std::unique_ptr<LoadedAnalyzedProgram> deserialize_analyzed_program(const std::string& data);
+// Reads only the origin record; false under the same conditions.
+bool read_analyzed_program_origin(const std::string& data, AnalyzedProgramOrigin& out);
+
+} // namespace vexel
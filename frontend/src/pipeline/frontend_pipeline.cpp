@@ -2,13 +2,19 @@
 
 #include "analysis.h"
 #include "ast_walk.h"
+#include "binding_cleanup.h"
+#include "inliner.h"
+#include "loop_optimizer.h"
 #include "lowerer.h"
 #include "monomorphizer.h"
 #include "optimizer.h"
 #include "pass_invariants.h"
+#include "pipeline_trace.h"
 #include "program.h"
 #include "residualizer.h"
 #include "resolver.h"
+#include "specializer.h"
+#include "symbol_map.h"
 #include "typechecker.h"
 
 #include <iostream>
@@ -20,19 +26,6 @@ namespace vexel {
 
 namespace {
 
-#ifdef VEXEL_DEBUG_PASS_INVARIANTS
-void validate_program_stage(const Program& program, const char* stage) {
-    validate_program_invariants(program, stage);
-}
-
-void validate_module_stage(const Module& mod, const char* stage) {
-    validate_module_invariants(mod, stage);
-}
-#else
-void validate_program_stage(const Program&, const char*) {}
-void validate_module_stage(const Module&, const char*) {}
-#endif
-
 bool keep_top_level_stmt(StmtPtr stmt,
                          Symbol* sym,
                          const AnalysisFacts& analysis) {
@@ -53,38 +46,41 @@ bool keep_top_level_stmt(StmtPtr stmt,
     }
 }
 
-Module merge_live_program_instances(const Program& program,
-                                    TypeChecker& checker,
-                                    const AnalysisFacts& analysis) {
-    Module merged;
-    if (program.modules.empty()) {
-        return merged;
+// Frontend DCE prune: filters the merged module in place, so only statements
+// that survived lowering and residualization are considered and no second
+// merge of program instances is needed.
+void prune_merged_module(Module& merged,
+                         TypeChecker& checker,
+                         const AnalysisFacts& analysis) {
+    if (merged.top_level_instance_ids.size() != merged.top_level.size()) {
+        throw CompileError("Internal error: frontend DCE prune requires top-level instance IDs aligned with merged module",
+                           merged.location);
     }
 
-    merged.name = program.modules.front().module.name;
-    merged.path = program.modules.front().path;
-
-    for (const auto& instance : program.instances) {
-        const auto& mod_info = program.modules[static_cast<size_t>(instance.module_id)];
-        for (const auto& stmt : mod_info.module.top_level) {
-            Symbol* sym = nullptr;
-            if (stmt && (stmt->kind == Stmt::Kind::FuncDecl || stmt->kind == Stmt::Kind::VarDecl)) {
-                sym = checker.binding_for(instance.id, stmt.get());
-                if (!sym) {
-                    throw CompileError("Internal error: missing top-level binding during frontend DCE prune",
-                                       stmt->location);
-                }
-            }
-            if (keep_top_level_stmt(stmt, sym, analysis)) {
-                merged.top_level.push_back(stmt);
-                merged.top_level_instance_ids.push_back(instance.id);
+    size_t kept = 0;
+    for (size_t i = 0; i < merged.top_level.size(); ++i) {
+        const StmtPtr& stmt = merged.top_level[i];
+        const int instance_id = merged.top_level_instance_ids[i];
+        Symbol* sym = nullptr;
+        if (stmt && (stmt->kind == Stmt::Kind::FuncDecl || stmt->kind == Stmt::Kind::VarDecl)) {
+            sym = checker.binding_for(instance_id, stmt.get());
+            if (!sym) {
+                throw CompileError("Internal error: missing top-level binding during frontend DCE prune",
+                                   stmt->location);
             }
         }
+        if (!keep_top_level_stmt(stmt, sym, analysis)) continue;
+        if (kept != i) {
+            merged.top_level[kept] = std::move(merged.top_level[i]);
+            merged.top_level_instance_ids[kept] = instance_id;
+        }
+        ++kept;
     }
-
-    return merged;
+    merged.top_level.resize(kept);
+    merged.top_level_instance_ids.resize(kept);
 }
 
+#ifdef VEXEL_DEBUG_PASS_INVARIANTS
 void collect_internal_calls_in_stmt(const StmtPtr& stmt,
                                     int instance_id,
                                     TypeChecker& checker,
@@ -95,11 +91,7 @@ std::optional<bool> constexpr_condition_for(const OptimizationFacts& optimizatio
                                             int instance_id,
                                             ExprPtr condition) {
     if (!condition) return std::nullopt;
-    auto it = optimization.constexpr_conditions.find(expr_fact_key(instance_id, condition.get()));
-    if (it == optimization.constexpr_conditions.end()) {
-        return std::nullopt;
-    }
-    return it->second;
+    return optimization.constexpr_condition(expr_fact_key(instance_id, condition.get()));
 }
 
 void collect_internal_calls_in_expr(const ExprPtr& expr,
@@ -208,7 +200,7 @@ void validate_prune_linkage(const Program& program,
             root.second->kind == Stmt::Kind::VarDecl &&
             root.second->var_init) {
             const ExprFactKey init_key = expr_fact_key(root.first, root.second->var_init.get());
-            if (optimization.constexpr_values.count(init_key) != 0) {
+            if (optimization.constexpr_value(init_key)) {
                 continue;
             }
         }
@@ -231,7 +223,82 @@ void validate_prune_linkage(const Program& program,
     }
 }
 
-Module merge_program_instances(const Program& program) {
+#else
+void validate_prune_linkage(const Program&, TypeChecker&, const AnalysisFacts&, const OptimizationFacts&) {}
+#endif
+
+// Conservative reachability right after type checking. Every function that
+// an exported function, a global initializer or another top-level statement
+// names is a candidate, with no constexpr pruning, so the set covers whatever
+// the post-analysis prune could keep. Functions outside it are not merged and
+// skip monomorphization, lowering and the optimizer. Functions whose body
+// check was deferred (generic instantiations and unused-until-now
+// declarations) are materialized as the scan reaches them.
+class LiveFunctionScan {
+public:
+    explicit LiveFunctionScan(TypeChecker& checker) : checker_(checker) {}
+
+    SymbolSet run(const Program& program) {
+        for (const auto& instance : program.instances) {
+            const auto& mod_info = program.modules[static_cast<size_t>(instance.module_id)];
+            instance_id_ = instance.id;
+            for (const auto& stmt : mod_info.module.top_level) {
+                if (!stmt) continue;
+                if (stmt->kind != Stmt::Kind::FuncDecl) {
+                    scan_stmt(stmt);
+                    continue;
+                }
+                Symbol* sym = checker_.binding_for(instance.id, stmt.get());
+                if (sym && sym->is_exported) {
+                    note(sym);
+                }
+            }
+        }
+        while (!worklist_.empty()) {
+            const Symbol* sym = worklist_.back();
+            worklist_.pop_back();
+            instance_id_ = sym->instance_id;
+            checker_.materialize_function(sym);
+            scan_stmt(sym->declaration);
+        }
+        return std::move(live_);
+    }
+
+private:
+    void note(Symbol* sym) {
+        if (sym && sym->kind == Symbol::Kind::Function && live_.insert(sym)) {
+            worklist_.push_back(sym);
+        }
+    }
+
+    void scan_expr(const ExprPtr& expr) {
+        if (!expr) return;
+        if (expr->kind == Expr::Kind::Identifier) {
+            note(checker_.binding_for(instance_id_, expr.get()));
+        }
+        for_each_expr_child(
+            expr,
+            [&](const ExprPtr& child) { scan_expr(child); },
+            [&](const StmtPtr& child) { scan_stmt(child); });
+    }
+
+    void scan_stmt(const StmtPtr& stmt) {
+        if (!stmt) return;
+        for_each_stmt_child(
+            stmt,
+            [&](const ExprPtr& child) { scan_expr(child); },
+            [&](const StmtPtr& child) { scan_stmt(child); });
+    }
+
+    TypeChecker& checker_;
+    SymbolSet live_;
+    std::vector<const Symbol*> worklist_;
+    int instance_id_ = -1;
+};
+
+Module merge_program_instances(const Program& program,
+                               TypeChecker& checker,
+                               const SymbolSet& live_functions) {
     Module merged;
     if (program.modules.empty()) {
         return merged;
@@ -242,6 +309,10 @@ Module merge_program_instances(const Program& program) {
     for (const auto& instance : program.instances) {
         const auto& mod_info = program.modules[static_cast<size_t>(instance.module_id)];
         for (const auto& stmt : mod_info.module.top_level) {
+            if (stmt && stmt->kind == Stmt::Kind::FuncDecl) {
+                Symbol* sym = checker.binding_for(instance.id, stmt.get());
+                if (sym && !live_functions.count(sym)) continue;
+            }
             merged.top_level.push_back(stmt);
             merged.top_level_instance_ids.push_back(instance.id);
         }
@@ -249,64 +320,166 @@ Module merge_program_instances(const Program& program) {
     return merged;
 }
 
+// Releases what backends never read, so emission runs with only the live
+// program resident: module statements the prune removed (backends walk
+// Program::modules for declaration order but skip statements outside the
+// merged module), declarations of value and function symbols no live tree
+// holds, bindings of nodes outside the live trees, and the checker's query
+// state. Type symbols keep their declarations; backends look named types up
+// by scope.
+void compact_for_backend(Program& program, const Module& merged, TypeChecker& checker) {
+    std::unordered_set<const void*> live;
+    auto note = [&](const void* node) { live.insert(node); };
+    for (const auto& stmt : merged.top_level) {
+        for_each_bindable_node(stmt, note);
+    }
+
+    for (ModuleInfo& info : program.modules) {
+        Module& module = info.module;
+        const bool has_instance_ids = module.top_level_instance_ids.size() == module.top_level.size();
+        size_t kept = 0;
+        for (size_t i = 0; i < module.top_level.size(); ++i) {
+            if (!live.count(module.top_level[i].get())) continue;
+            if (kept != i) {
+                module.top_level[kept] = std::move(module.top_level[i]);
+                if (has_instance_ids) module.top_level_instance_ids[kept] = module.top_level_instance_ids[i];
+            }
+            ++kept;
+        }
+        module.top_level.resize(kept);
+        module.top_level.shrink_to_fit();
+        if (has_instance_ids) module.top_level_instance_ids.resize(kept);
+    }
+    for (const auto& sym : program.symbols) {
+        if (sym->kind != Symbol::Kind::Type && sym->declaration && !live.count(sym->declaration.get())) {
+            sym->declaration.reset();
+        }
+    }
+    checker.release_checking_state(live);
+}
+
 } // namespace
 
 FrontendPipelineResult run_frontend_pipeline(Program& program,
                                              Resolver& resolver,
                                              TypeChecker& checker,
                                              bool verbose,
-                                             const AnalysisConfig& analysis_config) {
+                                             const AnalysisConfig& analysis_config,
+                                             PipelineStats* stats,
+                                             unsigned optimizer_workers,
+                                             const InvariantConfig& invariants) {
+    AstArenaScope arena_scope(program.ast_arena);
+    auto validate_program_stage = [&](const Program& checked, const char* stage) {
+        validate_program_invariants(checked, stage, invariants);
+    };
+    auto validate_module_stage = [&](const Module& checked, const char* stage) {
+        validate_module_invariants(checked, stage, invariants);
+    };
     validate_program_stage(program, "post-load");
+    auto program_nodes = [&]() { return count_ast_nodes(program); };
 
+    PipelineStageTimer resolve_timer(stats, "resolve");
     resolver.resolve();
+    resolve_timer.finish(program_nodes);
     validate_program_stage(program, "post-resolve");
 
     if (verbose) {
         std::cout << "Type checking..." << std::endl;
     }
+    PipelineStageTimer typecheck_timer(stats, "typecheck");
     checker.check_program(program);
+    typecheck_timer.finish(program_nodes);
     validate_program_stage(program, "post-typecheck");
 
-    Module merged = merge_program_instances(program);
+    PipelineStageTimer merge_timer(stats, "merge");
+    const SymbolSet live_functions = LiveFunctionScan(checker).run(program);
+    Module merged = merge_program_instances(program, checker, live_functions);
+    auto merged_nodes = [&]() { return count_ast_nodes(merged); };
+    merge_timer.finish(merged_nodes);
     validate_module_stage(merged, "post-merge");
 
+    PipelineStageTimer monomorphize_timer(stats, "monomorphize");
     Monomorphizer monomorphizer(&checker);
+    monomorphizer.set_live_functions(&live_functions);
     monomorphizer.run(merged);
+    monomorphize_timer.finish(merged_nodes);
     validate_module_stage(merged, "post-monomorphize");
 
+    PipelineStageTimer lower_timer(stats, "lower");
     Lowerer lowerer(&checker);
     lowerer.run(merged);
+    lower_timer.finish(merged_nodes);
     validate_module_stage(merged, "post-lower");
 
+    PipelineStageTimer inline_timer(stats, "inline");
+    Inliner(&checker).run(merged);
+    inline_timer.finish(merged_nodes);
+    validate_module_stage(merged, "post-inline");
+
+    PipelineStageTimer optimize_timer(stats, "optimize");
     Optimizer optimizer(&checker);
-    OptimizationFacts optimization;
+    optimizer.set_parallel_workers(optimizer_workers);
+    OptimizationFacts optimization = optimizer.run(merged);
     static constexpr int kMaxResidualFixpointIterations = 64;
     int residual_iters = 0;
+    Residualizer residualizer(optimization);
+    Specializer specializer(&checker);
+    LoopOptimizer loop_rewriter(&checker);
+    bool loops_optimized = false;
+    auto traced = [](const char* name, auto&& pass) {
+        TraceSpan span("optimize", name);
+        return pass();
+    };
     while (true) {
-        optimization = optimizer.run(merged);
-        Residualizer residualizer(optimization);
-        if (!residualizer.run(merged)) {
-            break;
+        if (!traced("residualize", [&]() { return residualizer.run(merged); })) {
+            // At the residual fixpoint, calls with literal arguments move to
+            // specialized clones, which then get their own fixpoint rounds.
+            if (traced("specialize", [&]() { return specializer.run(merged); })) {
+                optimization = optimizer.rerun(merged, specializer.rewritten_top_level());
+                continue;
+            }
+            // Runtime loops are final once nothing else folds; their
+            // rewrites run once, and the new locals get one more round.
+            if (loops_optimized) break;
+            loops_optimized = true;
+            if (!traced("loop-rewrite", [&]() { return loop_rewriter.run(merged); })) break;
+            optimization = optimizer.rerun(merged, loop_rewriter.rewritten_top_level());
+            continue;
         }
         residual_iters++;
         if (residual_iters >= kMaxResidualFixpointIterations) {
             throw CompileError("Internal error: residualization did not converge",
                                merged.location);
         }
+        // Only rewritten top-level statements (and their symbol dependents) are re-solved.
+        optimization = optimizer.rerun(merged, residualizer.rewritten_top_level());
     }
+    specializer.publish(optimization);
+    loop_rewriter.publish(optimization);
+    optimize_timer.finish(merged_nodes, residual_iters);
     validate_module_stage(merged, "post-optimize");
 
+    PipelineStageTimer analysis_timer(stats, "analysis");
     Analyzer analyzer(&checker, &optimization, analysis_config);
     AnalysisFacts analysis = analyzer.run(merged);
+    analysis_timer.finish(merged_nodes);
     validate_module_stage(merged, "post-analysis");
 
+    PipelineStageTimer type_use_timer(stats, "type-use");
     checker.validate_type_usage(merged, analysis);
+    type_use_timer.finish(merged_nodes);
     validate_module_stage(merged, "post-type-use");
 
+    PipelineStageTimer prune_timer(stats, "dce-prune");
     validate_prune_linkage(program, checker, analysis, optimization);
-    merged = merge_live_program_instances(program, checker, analysis);
+    prune_merged_module(merged, checker, analysis);
+    prune_timer.finish(merged_nodes);
     validate_module_stage(merged, "post-dce-prune");
 
+    PipelineStageTimer compact_timer(stats, "compact");
+    compact_for_backend(program, merged, checker);
+    compact_timer.finish(merged_nodes);
+
     FrontendPipelineResult result;
     result.merged = std::move(merged);
     result.optimization = std::move(optimization);
@@ -3,6 +3,8 @@
 #include "analysis.h"
 #include "ast.h"
 #include "optimizer.h"
+#include "pass_invariants.h"
+#include "pipeline_stats.h"
 
 namespace vexel {
 
@@ -20,6 +22,9 @@ FrontendPipelineResult run_frontend_pipeline(Program& program,
                                              Resolver& resolver,
                                              TypeChecker& checker,
                                              bool verbose,
-                                             const AnalysisConfig& analysis_config = AnalysisConfig{});
+                                             const AnalysisConfig& analysis_config = AnalysisConfig{},
+                                             PipelineStats* stats = nullptr,
+                                             unsigned optimizer_workers = 1,
+                                             const InvariantConfig& invariants = InvariantConfig{});
 
 } // namespace vexel
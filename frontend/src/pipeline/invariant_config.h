@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vexel {
+
+// How much of the tree the structural invariant checks walk at each stage.
+// - Off: no checks.
+// - Boundary: full checks, but only at the hand-off stages (after type
+//   checking and on the final backend input).
+// - Sampled: every stage, cheap module-level checks plus one top-level
+//   statement in `sample_period`; the seed picks which one per stage.
+// - Full: every stage, every statement.
+enum class InvariantLevel { Off, Boundary, Sampled, Full };
+
+// Full in builds with VEXEL_DEBUG_PASS_INVARIANTS, Off otherwise.
+InvariantLevel default_invariant_level();
+
+struct InvariantConfig {
+    InvariantLevel level = default_invariant_level();
+    uint32_t sample_period = 16;
+    uint64_t sample_seed = 0;
+};
+
+// Parses "off", "boundary", "sampled[:<period>[:<seed>]]" or "full".
+bool parse_invariant_config(const std::string& text, InvariantConfig& out);
+
+} // namespace vexel
@@ -118,7 +118,43 @@ void validate_stmt(const StmtPtr& stmt, const std::string& stage) {
         [&](const StmtPtr& child) { validate_stmt(child, stage); });
 }
 
-void validate_module(const Module& mod, const std::string& stage) {
+bool is_boundary_stage(const std::string& stage) {
+    return stage == "post-typecheck" || stage == "post-dce-prune";
+}
+
+// Decides which top-level statements one stage checks. Sampling offsets
+// differ per stage so successive stages cover different statements.
+class StmtSampler {
+public:
+    StmtSampler(const InvariantConfig& config, const std::string& stage)
+        : full_(config.level != InvariantLevel::Sampled),
+          period_(config.sample_period == 0 ? 1 : config.sample_period) {
+        if (!full_) {
+            uint64_t h = config.sample_seed ^ 0x9e3779b97f4a7c15ULL;
+            for (char c : stage) {
+                h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+            }
+            next_ = h % period_;
+        }
+    }
+
+    bool take() {
+        if (full_) return true;
+        if (next_ == 0) {
+            next_ = period_ - 1;
+            return true;
+        }
+        --next_;
+        return false;
+    }
+
+private:
+    bool full_;
+    uint64_t period_;
+    uint64_t next_ = 0;
+};
+
+void validate_module(const Module& mod, const std::string& stage, StmtSampler& sampler) {
     if (!mod.top_level_instance_ids.empty() &&
         mod.top_level_instance_ids.size() != mod.top_level.size()) {
         invariant_fail(stage, mod.location, "top-level instance IDs are not aligned with top-level declarations");
@@ -127,20 +163,88 @@ void validate_module(const Module& mod, const std::string& stage) {
         if (!stmt) {
             invariant_fail(stage, mod.location, "top-level statement is null");
         }
-        validate_stmt(stmt, stage);
+        if (sampler.take()) {
+            validate_stmt(stmt, stage);
+        }
     }
 }
 
+bool stage_enabled(const InvariantConfig& config, const std::string& stage) {
+    switch (config.level) {
+        case InvariantLevel::Off:
+            return false;
+        case InvariantLevel::Boundary:
+            return is_boundary_stage(stage);
+        case InvariantLevel::Sampled:
+        case InvariantLevel::Full:
+            return true;
+    }
+    return false;
+}
+
+bool parse_sample_number(const std::string& text, uint64_t& out) {
+    if (text.empty() || text.size() > 19) return false;
+    uint64_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    out = value;
+    return true;
+}
+
 } // namespace
 
-void validate_module_invariants(const Module& mod, const char* stage) {
-    validate_module(mod, stage ? stage : "unknown");
+InvariantLevel default_invariant_level() {
+#ifdef VEXEL_DEBUG_PASS_INVARIANTS
+    return InvariantLevel::Full;
+#else
+    return InvariantLevel::Off;
+#endif
+}
+
+bool parse_invariant_config(const std::string& text, InvariantConfig& out) {
+    InvariantConfig config = out;
+    if (text == "off") {
+        config.level = InvariantLevel::Off;
+    } else if (text == "boundary") {
+        config.level = InvariantLevel::Boundary;
+    } else if (text == "full") {
+        config.level = InvariantLevel::Full;
+    } else if (text.compare(0, 7, "sampled") == 0 && (text.size() == 7 || text[7] == ':')) {
+        config.level = InvariantLevel::Sampled;
+        if (text.size() > 7) {
+            const std::string rest = text.substr(8);
+            const size_t colon = rest.find(':');
+            uint64_t period = 0;
+            if (!parse_sample_number(rest.substr(0, colon), period) || period == 0 || period > UINT32_MAX) {
+                return false;
+            }
+            config.sample_period = static_cast<uint32_t>(period);
+            if (colon != std::string::npos && !parse_sample_number(rest.substr(colon + 1), config.sample_seed)) {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+    out = config;
+    return true;
+}
+
+void validate_module_invariants(const Module& mod, const char* stage, const InvariantConfig& config) {
+    const std::string stage_name = stage ? stage : "unknown";
+    if (!stage_enabled(config, stage_name)) return;
+    StmtSampler sampler(config, stage_name);
+    validate_module(mod, stage_name, sampler);
 }
 
-void validate_program_invariants(const Program& program, const char* stage) {
-    std::string stage_name = stage ? stage : "unknown";
+void validate_program_invariants(const Program& program, const char* stage, const InvariantConfig& config) {
+    const std::string stage_name = stage ? stage : "unknown";
+    if (!stage_enabled(config, stage_name)) return;
+    StmtSampler sampler(config, stage_name);
     for (const auto& mod_info : program.modules) {
-        validate_module(mod_info.module, stage_name);
+        validate_module(mod_info.module, stage_name, sampler);
     }
 }
 
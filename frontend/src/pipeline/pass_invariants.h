@@ -1,13 +1,16 @@
 #pragma once
 
 #include "ast.h"
+#include "invariant_config.h"
 #include "program.h"
 
 namespace vexel {
 
-// Debug-only structural invariants checked between frontend passes.
+// Structural invariants checked between frontend passes.
 // Keep these checks aligned with compiler.cpp stage boundaries.
-void validate_module_invariants(const Module& mod, const char* stage);
-void validate_program_invariants(const Program& program, const char* stage);
+void validate_module_invariants(const Module& mod, const char* stage,
+                                const InvariantConfig& config = InvariantConfig{});
+void validate_program_invariants(const Program& program, const char* stage,
+                                 const InvariantConfig& config = InvariantConfig{});
 
 } // namespace vexel
@@ -0,0 +1,176 @@
+#include "pipeline_stats.h"
+
+#include "ast_walk.h"
+#include "program.h"
+
+#include <cstdio>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define VEXEL_HAS_GETRUSAGE 1
+#else
+#define VEXEL_HAS_GETRUSAGE 0
+#endif
+
+namespace vexel {
+
+namespace {
+
+size_t count_stmt_nodes(const StmtPtr& stmt);
+
+size_t count_expr_nodes(const ExprPtr& expr) {
+    if (!expr) return 0;
+    size_t count = 1;
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { count += count_expr_nodes(child); },
+        [&](const StmtPtr& child) { count += count_stmt_nodes(child); });
+    return count;
+}
+
+size_t count_stmt_nodes(const StmtPtr& stmt) {
+    if (!stmt) return 0;
+    size_t count = 1;
+    for_each_stmt_child(
+        stmt,
+        [&](const ExprPtr& child) { count += count_expr_nodes(child); },
+        [&](const StmtPtr& child) { count += count_stmt_nodes(child); });
+    return count;
+}
+
+std::string format_ms(double ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", ms);
+    return buf;
+}
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c; break;
+        }
+    }
+    return out;
+}
+
+std::string pad_left(const std::string& text, size_t width) {
+    if (text.size() >= width) return text;
+    return std::string(width - text.size(), ' ') + text;
+}
+
+std::string pad_right(const std::string& text, size_t width) {
+    if (text.size() >= width) return text;
+    return text + std::string(width - text.size(), ' ');
+}
+
+} // namespace
+
+PipelineStageTimer::PipelineStageTimer(PipelineStats* stats, const char* name)
+    : stats_(stats), name_(name), span_("stage", name) {
+    if (!stats_) return;
+    start_peak_rss_kb_ = current_peak_rss_kb();
+    start_ = std::chrono::steady_clock::now();
+}
+
+void PipelineStageTimer::finish(const std::function<size_t()>& count_ast_nodes, int residual_iters) {
+    span_.end();
+    if (!stats_) return;
+    auto end = std::chrono::steady_clock::now();
+    PipelineStageStats stage;
+    stage.name = name_;
+    stage.wall_ms = std::chrono::duration<double, std::milli>(end - start_).count();
+    long end_peak_rss_kb = current_peak_rss_kb();
+    stage.peak_rss_delta_kb = end_peak_rss_kb > start_peak_rss_kb_ ? end_peak_rss_kb - start_peak_rss_kb_ : 0;
+    stage.ast_nodes = count_ast_nodes ? count_ast_nodes() : 0;
+    stage.residual_iters = residual_iters;
+    stats_->stages.push_back(std::move(stage));
+    if (end_peak_rss_kb > stats_->peak_rss_kb) {
+        stats_->peak_rss_kb = end_peak_rss_kb;
+    }
+}
+
+long current_peak_rss_kb() {
+#if VEXEL_HAS_GETRUSAGE
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<long>(usage.ru_maxrss / 1024);
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+    return 0;
+#endif
+}
+
+size_t count_ast_nodes(const Module& mod) {
+    size_t count = 0;
+    for (const auto& stmt : mod.top_level) {
+        count += count_stmt_nodes(stmt);
+    }
+    return count;
+}
+
+size_t count_ast_nodes(const Program& program) {
+    size_t count = 0;
+    for (const auto& info : program.modules) {
+        count += count_ast_nodes(info.module);
+    }
+    return count;
+}
+
+std::string format_pipeline_stats_text(const PipelineStats& stats) {
+    std::ostringstream out;
+    double total_ms = 0.0;
+    out << "=== Pipeline stats ===\n";
+    out << pad_right("stage", 18)
+        << pad_left("wall(ms)", 12)
+        << pad_left("rss+(KiB)", 12)
+        << pad_left("ast-nodes", 12)
+        << pad_left("residual", 10) << "\n";
+    for (const auto& stage : stats.stages) {
+        total_ms += stage.wall_ms;
+        out << pad_right(stage.name, 18)
+            << pad_left(format_ms(stage.wall_ms), 12)
+            << pad_left(std::to_string(stage.peak_rss_delta_kb), 12)
+            << pad_left(std::to_string(stage.ast_nodes), 12)
+            << pad_left(std::to_string(stage.residual_iters), 10) << "\n";
+    }
+    out << pad_right("total", 18)
+        << pad_left(format_ms(total_ms), 12)
+        << pad_left("peak " + std::to_string(stats.peak_rss_kb), 12) << "\n";
+    out << "cte peak live values: " << stats.cte_peak_bytes << " bytes\n";
+    return out.str();
+}
+
+std::string format_pipeline_stats_json(const PipelineStats& stats) {
+    std::ostringstream out;
+    double total_ms = 0.0;
+    out << "{\n  \"stages\": [";
+    for (size_t i = 0; i < stats.stages.size(); ++i) {
+        const auto& stage = stats.stages[i];
+        total_ms += stage.wall_ms;
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << json_escape(stage.name) << "\""
+            << ", \"wall_ms\": " << format_ms(stage.wall_ms)
+            << ", \"peak_rss_delta_kb\": " << stage.peak_rss_delta_kb
+            << ", \"ast_nodes\": " << stage.ast_nodes
+            << ", \"residual_iters\": " << stage.residual_iters << "}";
+    }
+    out << (stats.stages.empty() ? "],\n" : "\n  ],\n");
+    out << "  \"total_wall_ms\": " << format_ms(total_ms) << ",\n";
+    out << "  \"peak_rss_kb\": " << stats.peak_rss_kb << ",\n";
+    out << "  \"cte_peak_bytes\": " << stats.cte_peak_bytes << "\n";
+    out << "}\n";
+    return out.str();
+}
+
+} // namespace vexel
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ast.h"
+#include "pipeline_trace.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vexel {
+
+struct Program;
+
+// Per-stage measurements collected when `--time-passes` / `--stats-json` is requested.
+// Memory is reported as growth of the process peak RSS high-water mark across the stage,
+// so a stage that reuses memory freed by an earlier stage reports 0.
+struct PipelineStageStats {
+    std::string name;
+    double wall_ms = 0.0;
+    long peak_rss_delta_kb = 0;
+    size_t ast_nodes = 0;
+    int residual_iters = 0;
+};
+
+struct PipelineStats {
+    std::vector<PipelineStageStats> stages;
+    long peak_rss_kb = 0;
+    // Most live compile-time value bytes any one evaluator query held.
+    uint64_t cte_peak_bytes = 0;
+};
+
+// Measures one stage; a null stats sink makes every call a no-op. The stage is
+// also a span of an active trace.
+class PipelineStageTimer {
+public:
+    PipelineStageTimer(PipelineStats* stats, const char* name);
+
+    // Node counting walks the whole AST, so it only runs when stats are enabled.
+    void finish(const std::function<size_t()>& count_ast_nodes, int residual_iters = 0);
+
+private:
+    PipelineStats* stats_;
+    const char* name_;
+    std::chrono::steady_clock::time_point start_;
+    long start_peak_rss_kb_ = 0;
+    TraceSpan span_;
+};
+
+long current_peak_rss_kb();
+size_t count_ast_nodes(const Module& mod);
+size_t count_ast_nodes(const Program& program);
+
+std::string format_pipeline_stats_text(const PipelineStats& stats);
+std::string format_pipeline_stats_json(const PipelineStats& stats);
+
+} // namespace vexel
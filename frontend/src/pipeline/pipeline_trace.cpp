@@ -0,0 +1,135 @@
+#include "pipeline_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+
+namespace vexel {
+
+namespace {
+
+std::atomic<TraceRecorder*> active_recorder{nullptr};
+
+std::string json_escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                    out += buf;
+                } else {
+                    out += c;
+                }
+                break;
+        }
+    }
+    return out;
+}
+
+std::string format_us(double us) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", us);
+    return buf;
+}
+
+} // namespace
+
+// The thread that creates the recorder is shown as "main".
+TraceRecorder::TraceRecorder() : origin_(std::chrono::steady_clock::now()) {
+    tids_.emplace(std::this_thread::get_id(), 1);
+}
+
+void TraceRecorder::add_span(std::string name,
+                             const char* category,
+                             std::chrono::steady_clock::time_point start,
+                             std::chrono::steady_clock::time_point end) {
+    using Micros = std::chrono::duration<double, std::micro>;
+    const double start_us = Micros(start - origin_).count();
+    const double duration_us = Micros(end - start).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int tid = tids_.emplace(std::this_thread::get_id(), static_cast<int>(tids_.size()) + 1).first->second;
+    events_.push_back({std::move(name), category, start_us, duration_us, tid});
+}
+
+std::string TraceRecorder::format_json() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<const Event*> ordered;
+    ordered.reserve(events_.size());
+    for (const Event& event : events_) ordered.push_back(&event);
+    // Parents start no later than their children; at equal starts the longer
+    // span is the parent, which viewers expect first.
+    std::stable_sort(ordered.begin(), ordered.end(), [](const Event* a, const Event* b) {
+        if (a->tid != b->tid) return a->tid < b->tid;
+        if (a->start_us != b->start_us) return a->start_us < b->start_us;
+        return a->duration_us > b->duration_us;
+    });
+
+    std::vector<int> tids;
+    for (const auto& entry : tids_) tids.push_back(entry.second);
+    std::sort(tids.begin(), tids.end());
+
+    std::ostringstream out;
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    auto separator = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    for (int tid : tids) {
+        separator();
+        out << "  {\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"" << (tid == 1 ? std::string("main") : "worker " + std::to_string(tid - 1))
+            << "\"}}";
+    }
+    for (const Event* event : ordered) {
+        separator();
+        out << "  {\"ph\": \"X\", \"name\": \"" << json_escape(event->name) << "\", \"cat\": \"" << event->category
+            << "\", \"pid\": 1, \"tid\": " << event->tid << ", \"ts\": " << format_us(event->start_us)
+            << ", \"dur\": " << format_us(event->duration_us) << "}";
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+TraceSession::TraceSession(TraceRecorder* recorder) : previous_(active_recorder.exchange(recorder)) {}
+
+TraceSession::~TraceSession() {
+    active_recorder.store(previous_);
+}
+
+bool trace_active() {
+    return active_recorder.load(std::memory_order_relaxed) != nullptr;
+}
+
+TraceSpan::TraceSpan(const char* category, const char* name)
+    : recorder_(active_recorder.load(std::memory_order_acquire)), category_(category) {
+    if (!recorder_) return;
+    name_ = name;
+    start_ = std::chrono::steady_clock::now();
+}
+
+TraceSpan::TraceSpan(const char* category, const char* name, const std::string& subject)
+    : recorder_(active_recorder.load(std::memory_order_acquire)), category_(category) {
+    if (!recorder_) return;
+    name_.reserve(std::char_traits<char>::length(name) + 1 + subject.size());
+    name_ += name;
+    name_ += ' ';
+    name_ += subject;
+    start_ = std::chrono::steady_clock::now();
+}
+
+void TraceSpan::end() {
+    if (!recorder_) return;
+    recorder_->add_span(std::move(name_), category_, start_, std::chrono::steady_clock::now());
+    recorder_ = nullptr;
+}
+
+} // namespace vexel
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vexel {
+
+// Timeline collected when `--trace=<file.json>` is requested: one complete
+// ("X") event per span in the Chrome trace-event format, which chrome://tracing
+// and Perfetto load directly. Viewers nest spans of one thread by time, so a
+// span only has to close before its parent does. Spans from worker threads are
+// recorded concurrently.
+class TraceRecorder {
+public:
+    TraceRecorder();
+
+    void add_span(std::string name,
+                  const char* category,
+                  std::chrono::steady_clock::time_point start,
+                  std::chrono::steady_clock::time_point end);
+    std::string format_json() const;
+
+private:
+    struct Event {
+        std::string name;
+        const char* category;
+        double start_us;
+        double duration_us;
+        int tid;
+    };
+
+    std::chrono::steady_clock::time_point origin_;
+    mutable std::mutex mutex_;
+    std::vector<Event> events_;
+    std::unordered_map<std::thread::id, int> tids_;
+};
+
+// Makes `recorder` the process's active trace for the session's lifetime; a
+// null recorder leaves tracing off.
+class TraceSession {
+public:
+    explicit TraceSession(TraceRecorder* recorder);
+    ~TraceSession();
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+
+private:
+    TraceRecorder* previous_;
+};
+
+bool trace_active();
+
+// One span on the calling thread, ending at end() or destruction. Without an
+// active trace it costs one atomic load, and `subject` is never copied.
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name);
+    // Named "<name> <subject>", e.g. "typecheck main".
+    TraceSpan(const char* category, const char* name, const std::string& subject);
+    ~TraceSpan() { end(); }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void end();
+
+private:
+    TraceRecorder* recorder_;
+    const char* category_;
+    std::string name_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace vexel
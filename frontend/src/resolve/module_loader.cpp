@@ -2,14 +2,23 @@
 #include "module_loader.h"
 #include "expr_access.h"
 #include "lexer.h"
+#include "module_cache.h"
 #include "parser.h"
+#include "io_utils.h"
 #include "path_utils.h"
+#include "pipeline_trace.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
-#include <fstream>
 
 namespace vexel {
 
 namespace {
+// Below twice this size a module is parsed on one worker; smaller chunks cost
+// more in task overhead than they save.
+constexpr size_t kMinParseChunkBytes = 256 * 1024;
+
 std::string normalize_path(const std::string& path) {
     if (path.empty()) return path;
     return std::filesystem::path(path).lexically_normal().string();
@@ -18,43 +27,171 @@ std::string normalize_path(const std::string& path) {
 
 Program ModuleLoader::load(const std::string& entry_path) {
     Program program;
-    load_module(normalize_path(entry_path), program);
+    AstArenaScope arena_scope(program.ast_arena);
+    const std::string entry = normalize_path(entry_path);
+    {
+        ThreadPool pool(resolve_worker_count(jobs));
+        schedule_parse(entry, pool, program.ast_arena);
+        pool.wait();
+    }
+    load_module(entry, program);
+    parsed.clear();
     return program;
 }
 
+void ModuleLoader::schedule_parse(const std::string& path,
+                                  ThreadPool& pool,
+                                  const std::shared_ptr<AstArena>& arena) {
+    ParsedModule* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(parsed_mutex);
+        auto inserted = parsed.emplace(path, nullptr);
+        if (!inserted.second) return;
+        inserted.first->second = std::make_unique<ParsedModule>();
+        slot = inserted.first->second.get();
+    }
+    pool.submit([this, path, slot, &pool, arena]() { parse_and_discover(path, *slot, pool, arena); });
+}
+
+void ModuleLoader::parse_and_discover(const std::string& path,
+                                      ParsedModule& out,
+                                      ThreadPool& pool,
+                                      const std::shared_ptr<AstArena>& arena) {
+    AstArenaScope arena_scope(arena);
+    try {
+        auto source = std::make_shared<MappedTextFile>(path);
+        std::string cache_key;
+        if (!lookup_cached_module(path, source->view(), cache_key, out.module)) {
+            const size_t size = source->view().size();
+            if (pool.size() > 1 && size >= 2 * kMinParseChunkBytes) {
+                const size_t target = std::max(kMinParseChunkBytes, size / (pool.size() * 4));
+                std::vector<ParseChunk> chunks = split_top_level_chunks(source->view(), target);
+                if (chunks.size() > 1) {
+                    parse_chunks(path, out, pool, arena, source, std::move(cache_key), std::move(chunks));
+                    return;
+                }
+            }
+            TraceSpan span("parse", "parse", path);
+            Lexer lexer(source->view(), path);
+            Parser parser(lexer);
+            out.module = parser.parse_module(path, path);
+            store_cached_module(cache_key, out.module);
+        }
+    } catch (...) {
+        out.error = std::current_exception();
+        return;
+    }
+    discover_imports(path, out, pool, arena);
+}
+
+// Chunks are parsed as independent pool tasks rather than awaited here, so a
+// worker never blocks on work queued behind it. The last chunk to finish joins
+// the module and carries on with its imports.
+void ModuleLoader::parse_chunks(const std::string& path,
+                                ParsedModule& out,
+                                ThreadPool& pool,
+                                const std::shared_ptr<AstArena>& arena,
+                                const std::shared_ptr<MappedTextFile>& source,
+                                std::string cache_key,
+                                std::vector<ParseChunk> chunks) {
+    struct State {
+        std::shared_ptr<MappedTextFile> source;
+        std::string cache_key;
+        std::vector<ParseChunk> chunks;
+        std::vector<ParsedChunk> parsed;
+        std::atomic<size_t> remaining;
+    };
+    auto state = std::make_shared<State>();
+    state->source = source;
+    state->cache_key = std::move(cache_key);
+    state->chunks = std::move(chunks);
+    state->parsed.resize(state->chunks.size());
+    state->remaining.store(state->chunks.size());
+
+    for (size_t i = 0; i < state->chunks.size(); ++i) {
+        pool.submit([this, path, &out, &pool, arena, state, i]() {
+            AstArenaScope arena_scope(arena);
+            const std::string_view view = state->source->view();
+            {
+                TraceSpan span("parse", "parse chunk", path);
+                try {
+                    state->parsed[i] = parse_chunk(view, path, state->chunks[i]);
+                } catch (...) {
+                    state->parsed[i].failed = true;
+                }
+            }
+            if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            try {
+                TraceSpan span("parse", "parse", path);
+                if (!assemble_chunks(path, state->parsed, out.module)) {
+                    // Re-parse the whole file so errors and recovery match -j 1.
+                    Lexer lexer(view, path);
+                    Parser parser(lexer);
+                    out.module = parser.parse_module(path, path);
+                }
+                store_cached_module(state->cache_key, out.module);
+            } catch (...) {
+                out.error = std::current_exception();
+                return;
+            }
+            discover_imports(path, out, pool, arena);
+        });
+    }
+}
+
+void ModuleLoader::discover_imports(const std::string& path,
+                                    ParsedModule& out,
+                                    ThreadPool& pool,
+                                    const std::shared_ptr<AstArena>& arena) {
+    try {
+        std::vector<std::vector<std::string>> imports;
+        for (const auto& stmt : out.module.top_level) {
+            collect_imports(stmt, imports);
+        }
+        for (const auto& import_path : imports) {
+            std::string resolved;
+            if (!resolve_module_path(import_path, path, resolved)) {
+                continue; // Resolver will report missing imports later.
+            }
+            out.imports.push_back(normalize_path(resolved));
+        }
+    } catch (...) {
+        out.error = std::current_exception();
+        return;
+    }
+    for (const auto& import : out.imports) {
+        schedule_parse(import, pool, arena);
+    }
+}
+
 ModuleId ModuleLoader::load_module(const std::string& path, Program& program) {
-    std::string normalized = normalize_path(path);
-    auto it = program.path_to_id.find(normalized);
+    auto it = program.path_to_id.find(path);
     if (it != program.path_to_id.end()) {
         return it->second;
     }
 
+    ParsedModule& parsed_module = *parsed.at(path);
+    if (parsed_module.error) {
+        std::rethrow_exception(parsed_module.error);
+    }
+
     ModuleInfo info;
     info.id = static_cast<ModuleId>(program.modules.size());
-    info.path = normalized;
+    info.path = path;
     std::string bundled_std_rel;
-    if (is_bundled_std_path(normalized, &bundled_std_rel)) {
+    if (is_bundled_std_path(path, &bundled_std_rel, directory_cache)) {
         info.origin = ModuleOrigin::BundledStd;
     }
-    info.module = parse_module_file(normalized);
+    info.module = std::move(parsed_module.module);
+    const ModuleId id = info.id;
     program.modules.push_back(std::move(info));
-    program.path_to_id[normalized] = program.modules.back().id;
+    program.path_to_id[path] = id;
 
-    // Collect imports from this module to load recursively.
-    std::vector<std::vector<std::string>> imports;
-    for (const auto& stmt : program.modules.back().module.top_level) {
-        collect_imports(stmt, imports);
+    for (const auto& import : parsed_module.imports) {
+        load_module(import, program);
     }
 
-    for (const auto& import_path : imports) {
-        std::string resolved;
-        if (!resolve_module_path(import_path, normalized, resolved)) {
-            continue; // Resolver will report missing imports later.
-        }
-        load_module(normalize_path(resolved), program);
-    }
-
-    return program.modules.back().id;
+    return id;
 }
 
 void ModuleLoader::collect_imports(StmtPtr stmt, std::vector<std::vector<std::string>>& out) const {
@@ -80,20 +217,32 @@ bool ModuleLoader::resolve_module_path(const std::vector<std::string>& import_pa
                                        const std::string& current_file,
                                        std::string& out_path) const {
     std::string relative = join_import_path(import_path) + ".vx";
-    return try_resolve_relative_path(relative, current_file, project_root, out_path);
+    return try_resolve_relative_path(relative, current_file, project_root, out_path, directory_cache);
 }
 
-Module ModuleLoader::parse_module_file(const std::string& path) const {
-    std::ifstream file(path);
-    if (!file) {
-        throw CompileError("Cannot open file: " + path, SourceLocation());
+bool ModuleLoader::lookup_cached_module(const std::string& path,
+                                       std::string_view source,
+                                       std::string& cache_key,
+                                       Module& out) const {
+    if (!parse_cache && !resident_cache) return false;
+    cache_key = ParsedModuleCache::key_for(source);
+    if (resident_cache && resident_cache->lookup(cache_key, path, out)) {
+        return true;
+    }
+    if (parse_cache && parse_cache->lookup(cache_key, path, out)) {
+        if (resident_cache) resident_cache->store(cache_key, out);
+        return true;
     }
-    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return false;
+}
 
-    Lexer lexer(source, path);
-    std::vector<Token> tokens = lexer.tokenize();
-    Parser parser(tokens);
-    return parser.parse_module(path, path);
+void ModuleLoader::store_cached_module(const std::string& cache_key, const Module& module) const {
+    if (parse_cache) {
+        parse_cache->store(cache_key, module);
+    }
+    if (resident_cache) {
+        resident_cache->store(cache_key, module);
+    }
 }
 
 } // namespace vexel
@@ -1,24 +1,70 @@
 #pragma once
+#include "chunked_parse.h"
 #include "program.h"
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace vexel {
 
+class ThreadPool;
+class ParsedModuleCache;
+class ResidentModuleCache;
+class DirectoryCache;
+class MappedTextFile;
+
+// Loads the entry module and its transitive imports. Files are read and parsed
+// concurrently on `jobs` workers (0 = hardware concurrency) as imports are
+// discovered; module ids are then assigned in the serial depth-first import
+// order, so the resulting Program does not depend on scheduling. A large module
+// is itself split at top-level boundaries and its chunks parsed on the same
+// workers (chunked_parse.h).
 class ModuleLoader {
 public:
-    explicit ModuleLoader(const std::string& root) : project_root(root) {}
+    explicit ModuleLoader(const std::string& root, int jobs = 0) : project_root(root), jobs(jobs) {}
     Program load(const std::string& entry_path);
+    // Reuse parsed modules across invocations; the cache must outlive load().
+    void set_parse_cache(const ParsedModuleCache* cache) { parse_cache = cache; }
+    // Consulted before the on-disk cache and filled from parses and disk hits.
+    void set_resident_cache(const ResidentModuleCache* cache) { resident_cache = cache; }
+    // Answers import path lookups from directory listings; shared by workers.
+    void set_directory_cache(DirectoryCache* cache) { directory_cache = cache; }
 
 private:
+    struct ParsedModule {
+        Module module;
+        std::vector<std::string> imports;  // Resolved, normalized, in source order.
+        std::exception_ptr error;
+    };
+
     std::string project_root;
+    int jobs;
+    const ParsedModuleCache* parse_cache = nullptr;
+    const ResidentModuleCache* resident_cache = nullptr;
+    DirectoryCache* directory_cache = nullptr;
+    std::mutex parsed_mutex;
+    std::unordered_map<std::string, std::unique_ptr<ParsedModule>> parsed;
 
+    void schedule_parse(const std::string& path, ThreadPool& pool, const std::shared_ptr<AstArena>& arena);
+    void parse_and_discover(const std::string& path, ParsedModule& out, ThreadPool& pool,
+                            const std::shared_ptr<AstArena>& arena);
+    void parse_chunks(const std::string& path, ParsedModule& out, ThreadPool& pool,
+                      const std::shared_ptr<AstArena>& arena, const std::shared_ptr<MappedTextFile>& source,
+                      std::string cache_key, std::vector<ParseChunk> chunks);
+    void discover_imports(const std::string& path, ParsedModule& out, ThreadPool& pool,
+                          const std::shared_ptr<AstArena>& arena);
     ModuleId load_module(const std::string& path, Program& program);
     void collect_imports(StmtPtr stmt, std::vector<std::vector<std::string>>& out) const;
     void collect_imports_expr(ExprPtr expr, std::vector<std::vector<std::string>>& out) const;
     bool resolve_module_path(const std::vector<std::string>& import_path,
                              const std::string& current_file,
                              std::string& out_path) const;
-    Module parse_module_file(const std::string& path) const;
+    bool lookup_cached_module(const std::string& path, std::string_view source, std::string& cache_key,
+                              Module& out) const;
+    void store_cached_module(const std::string& cache_key, const Module& module) const;
 };
 
 } // namespace vexel
@@ -73,7 +73,7 @@ Symbol* Resolver::lookup_type_in_instance(int instance_id, const std::string& na
     return scope->lookup_type(name);
 }
 
-std::vector<Symbol*> Resolver::lookup_functions_in_instance(int instance_id, const std::string& name) const {
+SymbolSpan Resolver::lookup_functions_in_instance(int instance_id, const std::string& name) const {
     Scope* scope = instance_scope(instance_id);
     if (!scope) return {};
     return scope->lookup_functions(name);
@@ -95,7 +95,7 @@ void Resolver::resolve_generated_function(StmtPtr func, int instance_id) {
     std::string surface_name = qualified_name_for_func(func);
     std::string internal_name = surface_name;
 
-    if (inst.symbols.count(internal_name)) {
+    if (inst.symbol(internal_name)) {
         throw CompileError("Name already defined: " + internal_name, func->location);
     }
 
@@ -105,8 +105,7 @@ void Resolver::resolve_generated_function(StmtPtr func, int instance_id) {
     sym->module_id = inst.module_id;
     sym->instance_id = inst.id;
 
-    inst.symbols[internal_name] = sym;
-    inst.function_overloads[surface_name].push_back(sym);
+    inst.generated[internal_name] = sym;
     Scope* scope = instance_scope(instance_id);
     if (scope) {
         scope->define_function(surface_name, sym);
@@ -128,6 +127,25 @@ void Resolver::resolve_generated_function(StmtPtr func, int instance_id) {
     current_module_id = saved_module;
 }
 
+void Resolver::resolve_generated_body(StmtPtr func, int instance_id) {
+    if (!func || func->kind != Stmt::Kind::FuncDecl) return;
+
+    ModuleInstance& inst = program.instances[static_cast<size_t>(instance_id)];
+    Scope* saved_scope = current_scope;
+    int saved_instance = current_instance_id;
+    int saved_module = current_module_id;
+
+    current_scope = instance_scope(instance_id);
+    current_instance_id = instance_id;
+    current_module_id = inst.module_id;
+
+    resolve_func_body(func);
+
+    current_scope = saved_scope;
+    current_instance_id = saved_instance;
+    current_module_id = saved_module;
+}
+
 void Resolver::push_scope(int forced_id) {
     int id = forced_id >= 0 ? forced_id : scope_counter++;
     if (forced_id >= 0 && scope_counter <= forced_id) {
@@ -159,7 +177,7 @@ void Resolver::verify_no_shadowing(const std::string& name, Symbol::Kind kind, c
                 throw CompileError("Name shadows existing definition: " + name, loc);
             }
             if (kind == Symbol::Kind::Function) {
-                std::vector<Symbol*> overloads = current_scope->lookup_functions(name);
+                SymbolSpan overloads = current_scope->lookup_functions(name);
                 if (!overloads.empty() && !current_scope->exists_function_in_current(name)) {
                     throw CompileError("Name shadows existing definition: " + name, loc);
                 }
@@ -193,15 +211,16 @@ void Resolver::resolve_instance(int instance_id) {
     push_scope(instance.scope_id);
     instance_scopes[instance.id] = current_scope;
 
-    for (const auto& pair : instance.value_symbols) {
-        current_scope->define_value(pair.first, pair.second);
+    const ModuleDeclarations& decls = *instance.declarations;
+    for (const auto& pair : decls.values) {
+        current_scope->define_value(pair.first, instance.declared[pair.second]);
     }
-    for (const auto& pair : instance.type_symbols) {
-        current_scope->define_type(pair.first, pair.second);
+    for (const auto& pair : decls.types) {
+        current_scope->define_type(pair.first, instance.declared[pair.second]);
     }
-    for (const auto& pair : instance.function_overloads) {
-        for (Symbol* sym : pair.second) {
-            current_scope->define_function(pair.first, sym);
+    for (const auto& pair : decls.function_overloads) {
+        for (size_t index : pair.second) {
+            current_scope->define_function(pair.first, instance.declared[index]);
         }
     }
 
@@ -225,16 +244,17 @@ void Resolver::resolve_instance(int instance_id) {
     current_module_id = saved_module_id;
 }
 
-void Resolver::predeclare_instance_symbols(ModuleInstance& instance) {
-    ModuleInfo* mod_info = program.module(instance.module_id);
-    if (!mod_info) return;
+const ModuleDeclarations& Resolver::module_declarations(ModuleInfo& mod_info) {
+    if (mod_info.declarations) return *mod_info.declarations;
+
+    auto decls = std::make_shared<ModuleDeclarations>();
     std::unordered_map<std::string, size_t> function_counts;
-    for (const auto& stmt : mod_info->module.top_level) {
+    for (const auto& stmt : mod_info.module.top_level) {
         if (!stmt || stmt->kind != Stmt::Kind::FuncDecl) continue;
         function_counts[qualified_name_for_func(stmt)] += 1;
     }
     std::unordered_map<std::string, size_t> function_ordinals;
-    for (const auto& stmt : mod_info->module.top_level) {
+    for (const auto& stmt : mod_info.module.top_level) {
         if (!stmt) continue;
         if (stmt->kind == Stmt::Kind::FuncDecl) {
             std::string surface_name = qualified_name_for_func(stmt);
@@ -243,63 +263,65 @@ void Resolver::predeclare_instance_symbols(ModuleInstance& instance) {
                 throw CompileError("ABI-visible function overloads are not supported: " + surface_name,
                                    stmt->location);
             }
-            bool disambiguate_first = ordinal == 0 && instance.symbols.count(surface_name);
+            bool disambiguate_first = ordinal == 0 && decls->by_name.count(surface_name);
             std::string internal_name = overload_internal_name(surface_name, ordinal, disambiguate_first);
-            if (instance.symbols.count(internal_name)) {
+            if (decls->by_name.count(internal_name)) {
                 throw CompileError("Name already defined: " + internal_name, stmt->location);
             }
-            Symbol* sym = create_symbol(Symbol::Kind::Function,
-                                        internal_name,
-                                        stmt,
-                                        false,
-                                        false,
-                                        surface_name);
-            sym->is_external = stmt->is_external;
-            sym->is_exported = stmt->is_exported;
-            sym->module_id = instance.module_id;
-            sym->instance_id = instance.id;
-            instance.symbols[internal_name] = sym;
-            instance.function_overloads[surface_name].push_back(sym);
-            bindings.bind(instance.id, stmt.get(), sym);
+            decls->add(Symbol::Kind::Function, internal_name, surface_name);
         } else if (stmt->kind == Stmt::Kind::TypeDecl) {
-            if (instance.type_symbols.count(stmt->type_decl_name)) {
+            if (decls->has_type(stmt->type_decl_name)) {
                 throw CompileError("Name already defined: " + stmt->type_decl_name, stmt->location);
             }
-            Symbol* sym = create_symbol(Symbol::Kind::Type,
-                                        stmt->type_decl_name,
-                                        stmt,
-                                        false,
-                                        false,
-                                        stmt->type_decl_name);
-            sym->module_id = instance.module_id;
-            sym->instance_id = instance.id;
-            instance.symbols[stmt->type_decl_name] = sym;
-            instance.type_symbols[stmt->type_decl_name] = sym;
-            bindings.bind(instance.id, stmt.get(), sym);
+            decls->add(Symbol::Kind::Type, stmt->type_decl_name, stmt->type_decl_name);
         } else if (stmt->kind == Stmt::Kind::VarDecl) {
-            if (instance.value_symbols.count(stmt->var_name) || instance.function_overloads.count(stmt->var_name)) {
+            if (decls->has_value(stmt->var_name) || decls->overloads(stmt->var_name)) {
                 throw CompileError("Name already defined: " + stmt->var_name, stmt->location);
             }
-            bool is_resource_binding =
-                stmt->var_init &&
-                (stmt->var_init->kind == Expr::Kind::Resource ||
-                 stmt->var_init->kind == Expr::Kind::Process);
-            Symbol* sym = create_symbol(stmt->is_mutable ? Symbol::Kind::Variable : Symbol::Kind::Constant,
-                                        stmt->var_name,
-                                        stmt,
-                                        stmt->is_mutable,
-                                        false,
-                                        stmt->var_name);
+            decls->add(stmt->is_mutable ? Symbol::Kind::Variable : Symbol::Kind::Constant,
+                       stmt->var_name,
+                       stmt->var_name);
+        }
+    }
+    mod_info.declarations = std::move(decls);
+    return *mod_info.declarations;
+}
+
+void Resolver::predeclare_instance_symbols(ModuleInstance& instance) {
+    ModuleInfo* mod_info = program.module(instance.module_id);
+    if (!mod_info) return;
+    const ModuleDeclarations& decls = module_declarations(*mod_info);
+    instance.declarations = mod_info->declarations;
+    instance.declared.reserve(decls.entries.size());
+    for (const auto& stmt : mod_info->module.top_level) {
+        if (!stmt) continue;
+        if (stmt->kind != Stmt::Kind::FuncDecl && stmt->kind != Stmt::Kind::TypeDecl &&
+            stmt->kind != Stmt::Kind::VarDecl) {
+            continue;
+        }
+        const ModuleDeclarations::Entry& entry = decls.entries[instance.declared.size()];
+        Symbol* sym = create_symbol(entry.kind,
+                                    entry.name,
+                                    stmt,
+                                    entry.kind == Symbol::Kind::Variable,
+                                    false,
+                                    entry.surface_name);
+        if (stmt->kind == Stmt::Kind::FuncDecl) {
+            sym->is_external = stmt->is_external;
+            sym->is_exported = stmt->is_exported;
+        } else if (stmt->kind == Stmt::Kind::VarDecl) {
             sym->is_external = stmt->var_linkage != VarLinkageKind::Normal;
             sym->is_backend_bound = stmt->var_linkage == VarLinkageKind::BackendBound;
             sym->is_exported = stmt->is_exported;
-            sym->is_resource_binding = is_resource_binding;
-            sym->module_id = instance.module_id;
-            sym->instance_id = instance.id;
-            instance.symbols[stmt->var_name] = sym;
-            instance.value_symbols[stmt->var_name] = sym;
-            bindings.bind(instance.id, stmt.get(), sym);
+            sym->is_resource_binding =
+                stmt->var_init &&
+                (stmt->var_init->kind == Expr::Kind::Resource ||
+                 stmt->var_init->kind == Expr::Kind::Process);
         }
+        sym->module_id = instance.module_id;
+        sym->instance_id = instance.id;
+        instance.declared.push_back(sym);
+        bindings.bind(instance.id, stmt.get(), sym);
     }
 }
 
@@ -316,6 +338,7 @@ Symbol* Resolver::create_symbol(Symbol::Kind kind,
     sym->is_mutable = is_mutable;
     sym->declaration = decl;
     sym->is_local = is_local;
+    sym->id = static_cast<int>(program.symbols.size());
     Symbol* out = sym.get();
     program.symbols.push_back(std::move(sym));
     return out;
@@ -384,7 +407,7 @@ void Resolver::resolve_func_decl(StmtPtr stmt, bool define_symbol) {
     if (define_symbol) {
         verify_no_shadowing(func_name, Symbol::Kind::Function, stmt->location);
         size_t ordinal = current_scope->exists_function_in_current(func_name)
-                             ? current_scope->function_overloads[func_name].size()
+                             ? current_scope->functions_in_current(func_name).size()
                              : 0;
         bool disambiguate_first = ordinal == 0 && current_scope->exists_internal_in_current(func_name);
         std::string internal_name = overload_internal_name(func_name, ordinal, disambiguate_first);
@@ -417,6 +440,10 @@ void Resolver::resolve_func_decl(StmtPtr stmt, bool define_symbol) {
         resolve_type(stmt->return_type);
     }
 
+    resolve_func_body(stmt);
+}
+
+void Resolver::resolve_func_body(StmtPtr stmt) {
     if (stmt->is_external || !stmt->body) {
         return;
     }
@@ -575,7 +602,7 @@ void Resolver::resolve_expr(ExprPtr expr) {
                     if (expr->is_constructor_call) {
                         sym = current_scope->lookup_type(expr->operand->name);
                     } else {
-                        std::vector<Symbol*> overloads = current_scope->lookup_functions(expr->operand->name);
+                        SymbolSpan overloads = current_scope->lookup_functions(expr->operand->name);
                         if (overloads.size() == 1) {
                             sym = overloads.front();
                         }
@@ -724,7 +751,7 @@ void Resolver::handle_import(StmtPtr stmt) {
     if (!stmt || !current_scope) return;
 
     std::string resolved_path;
-    if (!try_resolve_module_path(stmt->import_path, stmt->location.filename, resolved_path)) {
+    if (!try_resolve_module_path(stmt->import_path, stmt->location.filename(), resolved_path)) {
         throw CompileError("Import failed: cannot resolve module",
                            stmt->location,
                            CompileErrorCode::ImportResolveFailed);
@@ -745,46 +772,55 @@ void Resolver::handle_import(StmtPtr stmt) {
     scope_loaded_modules[current_scope].insert(module_id);
 
     ModuleInstance& instance = get_or_create_instance(module_id, current_scope->id, stmt->location);
+    if (current_instance_id >= 0) {
+        std::vector<ModuleInstanceId>& imports = program.instances[static_cast<size_t>(current_instance_id)].imports;
+        if (std::find(imports.begin(), imports.end(), instance.id) == imports.end()) {
+            imports.push_back(instance.id);
+        }
+    }
 
     std::string module_prefix = qualified_import_prefix(stmt->import_path);
-    for (const auto& pair : instance.value_symbols) {
+    const ModuleDeclarations& decls = *instance.declarations;
+    for (const auto& pair : decls.values) {
+        Symbol* sym = instance.declared[pair.second];
         if (current_scope->has_visible_name_in_current(pair.first)) {
             throw CompileError("Name already defined: " + pair.first, stmt->location);
         }
-        current_scope->define_value(pair.first, pair.second);
+        current_scope->define_value(pair.first, sym);
         if (!module_prefix.empty()) {
             std::string qualified = module_prefix + "::" + pair.first;
             if (!current_scope->has_visible_name_in_current(qualified)) {
-                current_scope->define_value(qualified, pair.second);
+                current_scope->define_value(qualified, sym);
             }
         }
     }
-    for (const auto& pair : instance.type_symbols) {
+    for (const auto& pair : decls.types) {
+        Symbol* sym = instance.declared[pair.second];
         if (current_scope->exists_type_in_current(pair.first)) {
             throw CompileError("Name already defined: " + pair.first, stmt->location);
         }
-        current_scope->define_type(pair.first, pair.second);
+        current_scope->define_type(pair.first, sym);
         if (!module_prefix.empty()) {
             std::string qualified = module_prefix + "::" + pair.first;
             if (!current_scope->exists_type_in_current(qualified)) {
-                current_scope->define_type(qualified, pair.second);
+                current_scope->define_type(qualified, sym);
             }
         }
     }
-    for (const auto& pair : instance.function_overloads) {
+    for (const auto& pair : decls.function_overloads) {
         if (current_scope->exists_value_in_current(pair.first)) {
             throw CompileError("Name already defined: " + pair.first, stmt->location);
         }
-        for (Symbol* sym : pair.second) {
-            current_scope->define_function(pair.first, sym);
+        for (size_t index : pair.second) {
+            current_scope->define_function(pair.first, instance.declared[index]);
         }
         if (!module_prefix.empty()) {
             std::string qualified = module_prefix + "::" + pair.first;
             if (current_scope->exists_value_in_current(qualified)) {
                 throw CompileError("Name already defined: " + qualified, stmt->location);
             }
-            for (Symbol* sym : pair.second) {
-                current_scope->define_function(qualified, sym);
+            for (size_t index : pair.second) {
+                current_scope->define_function(qualified, instance.declared[index]);
             }
         }
     }
@@ -806,7 +842,7 @@ bool Resolver::try_resolve_module_path(const std::vector<std::string>& import_pa
                                        const std::string& current_file,
                                        std::string& out_path) const {
     std::string relative = join_import_path(import_path) + ".vx";
-    if (!try_resolve_relative_path(relative, current_file, project_root, out_path)) {
+    if (!try_resolve_relative_path(relative, current_file, project_root, out_path, directory_cache)) {
         return false;
     }
     out_path = std::filesystem::path(out_path).lexically_normal().string();
@@ -832,6 +868,61 @@ void Resolver::build_module_imports() {
             }
         }
     }
+    build_module_components();
+}
+
+// Iterative Tarjan over module_imports.
+void Resolver::build_module_components() {
+    module_components.clear();
+    std::unordered_map<int, int> index;
+    std::unordered_map<int, int> lowlink;
+    std::unordered_set<int> on_stack;
+    std::vector<int> stack;
+    struct Frame {
+        int module;
+        size_t next_dep;
+    };
+    int next_index = 0;
+    int next_component = 0;
+    for (const auto& mod_info : program.modules) {
+        if (index.count(mod_info.id)) continue;
+        std::vector<Frame> frames{{mod_info.id, 0}};
+        index[mod_info.id] = lowlink[mod_info.id] = next_index++;
+        stack.push_back(mod_info.id);
+        on_stack.insert(mod_info.id);
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            const int module = frame.module;
+            auto deps_it = module_imports.find(module);
+            if (deps_it != module_imports.end() && frame.next_dep < deps_it->second.size()) {
+                const int dep = deps_it->second[frame.next_dep++];
+                if (!index.count(dep)) {
+                    index[dep] = lowlink[dep] = next_index++;
+                    stack.push_back(dep);
+                    on_stack.insert(dep);
+                    frames.push_back({dep, 0});
+                } else if (on_stack.count(dep)) {
+                    lowlink[module] = std::min(lowlink[module], index[dep]);
+                }
+                continue;
+            }
+            if (lowlink[module] == index[module]) {
+                int member = -1;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack.erase(member);
+                    module_components[member] = next_component;
+                } while (member != module);
+                ++next_component;
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                const int parent = frames.back().module;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[module]);
+            }
+        }
+    }
 }
 
 void Resolver::collect_imports(StmtPtr stmt, std::vector<std::vector<std::string>>& out) const {
@@ -855,6 +946,20 @@ void Resolver::collect_imports_expr(ExprPtr expr, std::vector<std::vector<std::s
 
 bool Resolver::module_depends_on(int module_id, int target_module_id) const {
     if (module_id == target_module_id) return true;
+    auto component = module_components.find(module_id);
+    auto target_component = module_components.find(target_module_id);
+    if (component != module_components.end() && target_component != module_components.end()) {
+        if (component->second == target_component->second) return true;
+        // When the target imports the module, a path back to the target would
+        // have put both in one component. Callers ask exactly this for each
+        // import, which keeps the check from walking the whole graph.
+        auto target_deps = module_imports.find(target_module_id);
+        if (target_deps != module_imports.end() &&
+            std::find(target_deps->second.begin(), target_deps->second.end(), module_id) !=
+                target_deps->second.end()) {
+            return false;
+        }
+    }
     std::unordered_set<int> visited;
     std::vector<int> stack;
     stack.push_back(module_id);
@@ -11,18 +11,25 @@
 
 namespace vexel {
 
+class DirectoryCache;
+
 class Resolver {
 public:
     Resolver(Program& program, Bindings& bindings, const std::string& project_root = ".");
+    // Optional listing cache for import path resolution (not owned).
+    void set_directory_cache(DirectoryCache* cache) { directory_cache = cache; }
 
     void resolve();
     void resolve_generated_function(StmtPtr func, int instance_id);
+    // Resolves the body of a generated function declared earlier through
+    // resolve_generated_function without one.
+    void resolve_generated_body(StmtPtr func, int instance_id);
 
     Scope* instance_scope(int instance_id) const;
     Symbol* lookup_internal_in_instance(int instance_id, const std::string& name) const;
     Symbol* lookup_value_in_instance(int instance_id, const std::string& name) const;
     Symbol* lookup_type_in_instance(int instance_id, const std::string& name) const;
-    std::vector<Symbol*> lookup_functions_in_instance(int instance_id, const std::string& name) const;
+    SymbolSpan lookup_functions_in_instance(int instance_id, const std::string& name) const;
 
 private:
     // Resolver invariants (after resolve()):
@@ -41,9 +48,12 @@ private:
     std::unordered_set<int> resolved_instances;
     std::unordered_map<int, std::vector<int>> pending_imports;
     std::unordered_map<int, std::vector<int>> module_imports;
+    // Strongly connected component of each module in the import graph.
+    std::unordered_map<int, int> module_components;
     std::unordered_set<const Symbol*> defined_globals;
     int scope_counter;
     std::string project_root;
+    DirectoryCache* directory_cache = nullptr;
     Module* current_module;
     int current_instance_id;
     int current_module_id;
@@ -53,17 +63,20 @@ private:
     void verify_no_shadowing(const std::string& name, Symbol::Kind kind, const SourceLocation& loc);
 
     void resolve_instance(int instance_id);
+    const ModuleDeclarations& module_declarations(ModuleInfo& mod_info);
     void predeclare_instance_symbols(ModuleInstance& instance);
     void resolve_stmt(StmtPtr stmt);
     void resolve_expr(ExprPtr expr);
     void resolve_type(TypePtr type);
 
     void resolve_func_decl(StmtPtr stmt, bool define_symbol);
+    void resolve_func_body(StmtPtr stmt);
     void resolve_type_decl(StmtPtr stmt);
     void resolve_var_decl(StmtPtr stmt);
 
     void handle_import(StmtPtr stmt);
     void build_module_imports();
+    void build_module_components();
     void collect_imports(StmtPtr stmt, std::vector<std::vector<std::string>>& out) const;
     void collect_imports_expr(ExprPtr expr, std::vector<std::vector<std::string>>& out) const;
     bool module_depends_on(int module_id, int target_module_id) const;
@@ -3,6 +3,8 @@
 #include "ast.h"
 #include "expr_access.h"
 
+#include <cstddef>
+
 namespace vexel {
 
 template <typename ExprFn, typename StmtFn>
@@ -80,5 +82,29 @@ inline void for_each_stmt_child(const StmtPtr& stmt, ExprFn&& on_expr_child, Stm
     }
 }
 
+inline size_t count_stmt_nodes(const StmtPtr& stmt, size_t limit);
+
+// Nodes in `expr` and everything below it, stopping once the count exceeds
+// `limit`.
+inline size_t count_expr_nodes(const ExprPtr& expr, size_t limit) {
+    if (!expr) return 0;
+    size_t count = 1;
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { if (count <= limit) count += count_expr_nodes(child, limit - count + 1); },
+        [&](const StmtPtr& child) { if (count <= limit) count += count_stmt_nodes(child, limit - count + 1); });
+    return count;
+}
+
+inline size_t count_stmt_nodes(const StmtPtr& stmt, size_t limit) {
+    if (!stmt) return 0;
+    size_t count = 1;
+    for_each_stmt_child(
+        stmt,
+        [&](const ExprPtr& child) { if (count <= limit) count += count_expr_nodes(child, limit - count + 1); },
+        [&](const StmtPtr& child) { if (count <= limit) count += count_stmt_nodes(child, limit - count + 1); });
+    return count;
+}
+
 } // namespace vexel
 
@@ -1,38 +1,48 @@
 #include "backend_registry.h"
 
+#include <deque>
+#include <unordered_map>
+
 namespace vexel {
 
-static std::vector<Backend>& backend_registry() {
-    static std::vector<Backend> backends;
-    return backends;
+namespace {
+
+// Registration order is kept for listings; lookups go through the name index.
+// A deque keeps returned Backend pointers valid across later registrations.
+struct BackendRegistry {
+    std::deque<Backend> backends;
+    std::unordered_map<std::string, const Backend*> by_name;
+};
+
+BackendRegistry& backend_registry() {
+    static BackendRegistry registry;
+    return registry;
 }
 
+} // namespace
+
 bool register_backend(Backend backend) {
     if (backend.info.name.empty() || backend.emit == nullptr) {
         return false;
     }
-    auto& backends = backend_registry();
-    for (const auto& existing : backends) {
-        if (existing.info.name == backend.info.name) {
-            return false;
-        }
+    auto& registry = backend_registry();
+    if (registry.by_name.count(backend.info.name)) {
+        return false;
     }
-    backends.push_back(std::move(backend));
+    registry.backends.push_back(std::move(backend));
+    registry.by_name.emplace(registry.backends.back().info.name, &registry.backends.back());
     return true;
 }
 
 const Backend* find_backend(const std::string& name) {
-    for (const auto& backend : backend_registry()) {
-        if (backend.info.name == name) {
-            return &backend;
-        }
-    }
-    return nullptr;
+    const auto& by_name = backend_registry().by_name;
+    auto it = by_name.find(name);
+    return it == by_name.end() ? nullptr : it->second;
 }
 
 std::vector<BackendInfo> list_backends() {
     std::vector<BackendInfo> out;
-    for (const auto& backend : backend_registry()) {
+    for (const auto& backend : backend_registry().backends) {
         out.push_back(backend.info);
     }
     return out;
@@ -5,60 +5,69 @@
 
 namespace vexel {
 
-inline void unbind_type_tree(Bindings& bindings, int instance_id, const TypePtr& type);
-inline void unbind_expr_tree(Bindings& bindings, int instance_id, const ExprPtr& expr);
-inline void unbind_stmt_tree(Bindings& bindings, int instance_id, const StmtPtr& stmt);
+template <typename Fn>
+void for_each_bindable_node(const TypePtr& type, Fn& fn);
+template <typename Fn>
+void for_each_bindable_node(const ExprPtr& expr, Fn& fn);
+template <typename Fn>
+void for_each_bindable_node(const StmtPtr& stmt, Fn& fn);
 
-inline void unbind_type_tree(Bindings& bindings, int instance_id, const TypePtr& type) {
+// Calls fn(node) for every address a tree can have bindings under: its type,
+// expression and statement nodes, function parameters and reference
+// parameter names.
+template <typename Fn>
+void for_each_bindable_node(const TypePtr& type, Fn& fn) {
     if (!type) return;
-    bindings.unbind(instance_id, type.get());
+    fn(static_cast<const void*>(type.get()));
     if (type->kind == Type::Kind::Array) {
-        unbind_type_tree(bindings, instance_id, type->element_type);
-        unbind_expr_tree(bindings, instance_id, type->array_size);
+        for_each_bindable_node(type->element_type, fn);
+        for_each_bindable_node(type->array_size, fn);
     } else if (type->kind == Type::Kind::TypeOf) {
-        unbind_expr_tree(bindings, instance_id, type->typeof_expr);
+        for_each_bindable_node(type->typeof_expr, fn);
     }
 }
 
-inline void unbind_expr_tree(Bindings& bindings, int instance_id, const ExprPtr& expr) {
+template <typename Fn>
+void for_each_bindable_node(const ExprPtr& expr, Fn& fn) {
     if (!expr) return;
-    bindings.unbind(instance_id, expr.get());
+    fn(static_cast<const void*>(expr.get()));
     if (expr->target_type) {
-        unbind_type_tree(bindings, instance_id, expr->target_type);
+        for_each_bindable_node(expr->target_type, fn);
     }
     for_each_expr_child(
         expr,
-        [&](const ExprPtr& child) { unbind_expr_tree(bindings, instance_id, child); },
-        [&](const StmtPtr& child) { unbind_stmt_tree(bindings, instance_id, child); });
+        [&](const ExprPtr& child) { for_each_bindable_node(child, fn); },
+        [&](const StmtPtr& child) { for_each_bindable_node(child, fn); });
 }
 
-inline void unbind_stmt_tree(Bindings& bindings, int instance_id, const StmtPtr& stmt) {
+template <typename Fn>
+void for_each_bindable_node(const StmtPtr& stmt, Fn& fn) {
     if (!stmt) return;
-    bindings.unbind(instance_id, stmt.get());
+    fn(static_cast<const void*>(stmt.get()));
 
     switch (stmt->kind) {
         case Stmt::Kind::FuncDecl:
             for (const auto& ref : stmt->ref_params) {
-                bindings.unbind(instance_id, &ref);
+                fn(static_cast<const void*>(&ref));
             }
             for (const auto& param : stmt->params) {
-                bindings.unbind(instance_id, &param);
-                unbind_type_tree(bindings, instance_id, param.type);
+                fn(static_cast<const void*>(&param));
+                for_each_bindable_node(param.type, fn);
             }
-            unbind_type_tree(bindings, instance_id, stmt->return_type);
+            for_each_bindable_node(stmt->return_type, fn);
             for (const auto& ret_type : stmt->return_types) {
-                unbind_type_tree(bindings, instance_id, ret_type);
+                for_each_bindable_node(ret_type, fn);
             }
             for (const auto& ref_type : stmt->ref_param_types) {
-                unbind_type_tree(bindings, instance_id, ref_type);
+                for_each_bindable_node(ref_type, fn);
             }
             break;
         case Stmt::Kind::VarDecl:
-            unbind_type_tree(bindings, instance_id, stmt->var_type);
+            for_each_bindable_node(stmt->var_type, fn);
             break;
         case Stmt::Kind::TypeDecl:
             for (const auto& field : stmt->fields) {
-                unbind_type_tree(bindings, instance_id, field.type);
+                for_each_bindable_node(field.type, fn);
             }
             break;
         default:
@@ -67,8 +76,23 @@ inline void unbind_stmt_tree(Bindings& bindings, int instance_id, const StmtPtr&
 
     for_each_stmt_child(
         stmt,
-        [&](const ExprPtr& child) { unbind_expr_tree(bindings, instance_id, child); },
-        [&](const StmtPtr& child) { unbind_stmt_tree(bindings, instance_id, child); });
+        [&](const ExprPtr& child) { for_each_bindable_node(child, fn); },
+        [&](const StmtPtr& child) { for_each_bindable_node(child, fn); });
+}
+
+inline void unbind_type_tree(Bindings& bindings, int instance_id, const TypePtr& type) {
+    auto unbind = [&](const void* node) { bindings.unbind(instance_id, node); };
+    for_each_bindable_node(type, unbind);
+}
+
+inline void unbind_expr_tree(Bindings& bindings, int instance_id, const ExprPtr& expr) {
+    auto unbind = [&](const void* node) { bindings.unbind(instance_id, node); };
+    for_each_bindable_node(expr, unbind);
+}
+
+inline void unbind_stmt_tree(Bindings& bindings, int instance_id, const StmtPtr& stmt) {
+    auto unbind = [&](const void* node) { bindings.unbind(instance_id, node); };
+    for_each_bindable_node(stmt, unbind);
 }
 
 } // namespace vexel
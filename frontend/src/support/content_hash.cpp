@@ -0,0 +1,81 @@
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace vexel {
+
+namespace {
+
+uint64_t mix_lane_b(uint64_t h, uint8_t byte) {
+    h ^= byte;
+    h *= 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29);
+}
+
+} // namespace
+
+void ContentHasher::add_bytes(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        lane_a_ ^= bytes[i];
+        lane_a_ *= 0x100000001b3ULL;
+        lane_b_ = mix_lane_b(lane_b_, bytes[i]);
+    }
+}
+
+void ContentHasher::add_string(const std::string& text) {
+    add_u64(text.size());
+    add_bytes(text.data(), text.size());
+}
+
+void ContentHasher::add_u64(uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+    add_bytes(bytes, sizeof(bytes));
+}
+
+std::string ContentHasher::hex() const {
+    char buf[33];
+    std::snprintf(buf, sizeof(buf), "%016llx%016llx",
+                  static_cast<unsigned long long>(lane_a_),
+                  static_cast<unsigned long long>(lane_b_));
+    return buf;
+}
+
+std::string file_digest(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::string();
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ContentHasher hasher;
+    hasher.add_string(content);
+    return hasher.hex();
+}
+
+std::string directory_digest(const std::string& path) {
+    ContentHasher hasher;
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        std::vector<std::string> names;
+        for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+            if (entry.is_regular_file()) names.push_back(entry.path().filename().string());
+        }
+        std::sort(names.begin(), names.end());
+        hasher.add_tag('d');
+        hasher.add_u64(names.size());
+        for (const std::string& name : names) hasher.add_string(name);
+    } else if (std::filesystem::exists(path, ec)) {
+        hasher.add_tag('f');
+    } else {
+        hasher.add_tag('-');
+    }
+    return hasher.hex();
+}
+
+} // namespace vexel
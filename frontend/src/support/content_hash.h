@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vexel {
+
+// Stable 128-bit content hash used for persistent cache keys.
+// Two independent 64-bit lanes keep accidental collisions out of reach for
+// cache sizes we care about; the value is never used for equality of ASTs.
+class ContentHasher {
+public:
+    void add_bytes(const void* data, size_t size);
+    void add_string(const std::string& text);
+    void add_u64(uint64_t value);
+    void add_tag(char tag) { add_bytes(&tag, 1); }
+    std::string hex() const;
+
+private:
+    uint64_t lane_a_ = 0xcbf29ce484222325ULL;
+    uint64_t lane_b_ = 0x84222325cbf29ce4ULL;
+};
+
+// Content hash of a file's bytes; empty when the file cannot be read.
+std::string file_digest(const std::string& path);
+// Hash of the names of the regular files in `path`, or of its absence, the
+// way resource directory expressions see it.
+std::string directory_digest(const std::string& path);
+
+} // namespace vexel
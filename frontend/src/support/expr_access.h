@@ -13,8 +13,9 @@ inline bool is_loop_expr(const ExprPtr& expr) {
 // Canonical loop subject access:
 // - Iteration uses operand (iterable)
 // - Repeat uses condition (re-evaluated condition)
-inline ExprPtr loop_subject(const ExprPtr& expr) {
-    if (!expr) return nullptr;
+inline const ExprPtr& loop_subject(const ExprPtr& expr) {
+    static const ExprPtr kNoExpr;
+    if (!expr) return kNoExpr;
     switch (expr->kind) {
         case Expr::Kind::Iteration:
             return expr->operand;
@@ -26,8 +27,9 @@ inline ExprPtr loop_subject(const ExprPtr& expr) {
 }
 
 // Canonical loop body access for both Iteration and Repeat.
-inline ExprPtr loop_body(const ExprPtr& expr) {
-    if (!expr) return nullptr;
+inline const ExprPtr& loop_body(const ExprPtr& expr) {
+    static const ExprPtr kNoExpr;
+    if (!expr) return kNoExpr;
     if (!is_loop_expr(expr)) {
         throw CompileError("Internal error: loop_body called on non-loop expression", expr->location);
     }
@@ -42,7 +44,7 @@ inline ExprPtr& loop_subject_ref(const ExprPtr& expr) {
         case Expr::Kind::Iteration:
             return expr->operand;
         case Expr::Kind::Repeat:
-            return expr->condition;
+            return expr->condition.mutable_value();
         default:
             throw CompileError("Internal error: loop_subject_ref called on non-loop expression", expr->location);
     }
@@ -0,0 +1,174 @@
+#include "fingerprint_db.h"
+
+#include "content_hash.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace vexel {
+
+namespace {
+
+// Bump when the record format changes. The build stamp keeps records written
+// by a different compiler build, which may compile the same sources
+// differently, from ever being current.
+constexpr const char* kRecordHeader = "vexel-fingerprints 1 " __DATE__ " " __TIME__;
+
+bool parse_digest_line(const std::string& rest, std::pair<std::string, std::string>& out) {
+    const size_t space = rest.find(' ');
+    if (space == std::string::npos || space == 0 || space + 1 >= rest.size()) return false;
+    out.second = rest.substr(0, space);
+    out.first = rest.substr(space + 1);
+    return true;
+}
+
+} // namespace
+
+std::string FingerprintDatabase::entry_path(const std::string& key) const {
+    return (std::filesystem::path(dir_) / "incremental" / (key + ".fp")).string();
+}
+
+// Record lines after the header:
+//   m <content> <interface> <path>   one per module, in index order
+//   i <module> <imported module>     import edge between module indexes
+//   f|d|o <digest> <path>            input file, input directory, output file
+bool FingerprintDatabase::load(const std::string& key, BuildFingerprint& out) const {
+    std::ifstream file(entry_path(key), std::ios::binary);
+    if (!file) return false;
+    std::string line;
+    if (!std::getline(file, line) || line != kRecordHeader) return false;
+    BuildFingerprint record;
+    while (std::getline(file, line)) {
+        if (line.size() < 3 || line[1] != ' ') return false;
+        const std::string rest = line.substr(2);
+        std::pair<std::string, std::string> entry;
+        switch (line[0]) {
+            case 'm': {
+                std::istringstream fields(rest);
+                ModuleFingerprint module;
+                if (!(fields >> module.content >> module.interface)) return false;
+                fields.get();
+                if (!std::getline(fields, module.path) || module.path.empty()) return false;
+                record.modules.push_back(std::move(module));
+                break;
+            }
+            case 'i': {
+                std::istringstream fields(rest);
+                size_t from = 0;
+                size_t to = 0;
+                if (!(fields >> from >> to) || from >= record.modules.size() || to >= record.modules.size()) {
+                    return false;
+                }
+                record.modules[from].imports.push_back(to);
+                break;
+            }
+            case 'f':
+            case 'd':
+            case 'o':
+                if (!parse_digest_line(rest, entry)) return false;
+                (line[0] == 'f' ? record.files : line[0] == 'd' ? record.directories : record.outputs)
+                    .push_back(std::move(entry));
+                break;
+            default:
+                return false;
+        }
+    }
+    out = std::move(record);
+    return true;
+}
+
+void FingerprintDatabase::store(const std::string& key, const BuildFingerprint& fingerprint) const {
+    std::ostringstream record;
+    record << kRecordHeader << "\n";
+    auto has_newline = [](const std::string& path) { return path.find('\n') != std::string::npos; };
+    for (const ModuleFingerprint& module : fingerprint.modules) {
+        if (has_newline(module.path)) return;
+        record << "m " << module.content << " " << module.interface << " " << module.path << "\n";
+    }
+    for (size_t i = 0; i < fingerprint.modules.size(); ++i) {
+        for (size_t imported : fingerprint.modules[i].imports) {
+            record << "i " << i << " " << imported << "\n";
+        }
+    }
+    auto write_entries = [&](char kind, const std::vector<std::pair<std::string, std::string>>& entries) {
+        for (const auto& entry : entries) {
+            if (entry.second.empty() || has_newline(entry.first)) return false;
+            record << kind << " " << entry.second << " " << entry.first << "\n";
+        }
+        return true;
+    };
+    if (!write_entries('f', fingerprint.files) || !write_entries('d', fingerprint.directories) ||
+        !write_entries('o', fingerprint.outputs)) {
+        return;
+    }
+
+    const std::string target = entry_path(key);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(target).parent_path(), ec);
+    const std::string tmp_path =
+        target + ".tmp" +
+        std::to_string(static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file << record.str();
+        if (!file) return;
+    }
+    std::filesystem::rename(tmp_path, target, ec);
+    if (ec) std::filesystem::remove(tmp_path, ec);
+}
+
+bool build_is_current(const BuildFingerprint& fingerprint) {
+    for (const auto& entry : fingerprint.files) {
+        if (file_digest(entry.first) != entry.second) return false;
+    }
+    for (const auto& entry : fingerprint.directories) {
+        if (directory_digest(entry.first) != entry.second) return false;
+    }
+    for (const auto& entry : fingerprint.outputs) {
+        if (file_digest(entry.first) != entry.second) return false;
+    }
+    return !fingerprint.outputs.empty();
+}
+
+FingerprintDiff compare_fingerprints(const BuildFingerprint& previous, const BuildFingerprint& current) {
+    std::unordered_map<std::string, const ModuleFingerprint*> before;
+    for (const ModuleFingerprint& module : previous.modules) before[module.path] = &module;
+
+    FingerprintDiff diff;
+    const size_t count = current.modules.size();
+    std::vector<bool> changed(count, false);
+    std::vector<bool> affected(count, false);
+    std::vector<std::vector<size_t>> importers(count);
+    std::vector<size_t> worklist;
+    for (size_t i = 0; i < count; ++i) {
+        const ModuleFingerprint& module = current.modules[i];
+        for (size_t imported : module.imports) {
+            if (imported < count) importers[imported].push_back(i);
+        }
+        auto it = before.find(module.path);
+        if (it != before.end() && it->second->content == module.content) continue;
+        changed[i] = true;
+        ++diff.changed;
+        if (it == before.end() || it->second->interface != module.interface) {
+            ++diff.interface_changed;
+            worklist.push_back(i);
+        }
+    }
+    while (!worklist.empty()) {
+        const size_t module = worklist.back();
+        worklist.pop_back();
+        for (size_t importer : importers[module]) {
+            if (affected[importer]) continue;
+            affected[importer] = true;
+            worklist.push_back(importer);
+            if (!changed[importer]) ++diff.affected_dependents;
+        }
+    }
+    return diff;
+}
+
+} // namespace vexel
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vexel {
+
+// Per-module record of one build. `content` hashes the source bytes and
+// `interface` what importers can observe (declarations without function
+// bodies); `imports` indexes the modules this one imports.
+struct ModuleFingerprint {
+    std::string path;
+    std::string content;
+    std::string interface;
+    std::vector<size_t> imports;
+};
+
+// Everything `--incremental` remembers about the last build of one input and
+// option set: its project modules, the digests of every file and directory
+// it read, and the digests of the outputs it wrote (path, digest pairs).
+struct BuildFingerprint {
+    std::vector<ModuleFingerprint> modules;
+    std::vector<std::pair<std::string, std::string>> files;
+    std::vector<std::pair<std::string, std::string>> directories;
+    std::vector<std::pair<std::string, std::string>> outputs;
+};
+
+struct FingerprintDiff {
+    size_t changed = 0;             // modules that are new or whose source changed
+    size_t interface_changed = 0;   // of those, modules whose interface changed
+    size_t affected_dependents = 0; // unchanged modules importing one of them, transitively
+};
+
+// Build records in `<dir>/incremental/<key>.fp`, one per build key. Records
+// written by another compiler build are ignored.
+class FingerprintDatabase {
+public:
+    explicit FingerprintDatabase(std::string dir) : dir_(std::move(dir)) {}
+
+    // False when there is no readable record for `key`.
+    bool load(const std::string& key, BuildFingerprint& out) const;
+    // Best effort: a record that cannot be written just misses next time.
+    void store(const std::string& key, const BuildFingerprint& fingerprint) const;
+
+    const std::string& dir() const { return dir_; }
+
+private:
+    std::string entry_path(const std::string& key) const;
+
+    std::string dir_;
+};
+
+// True when every recorded file, directory and output still has its digest.
+bool build_is_current(const BuildFingerprint& fingerprint);
+// Modules are matched by path.
+FingerprintDiff compare_fingerprints(const BuildFingerprint& previous, const BuildFingerprint& current);
+
+} // namespace vexel
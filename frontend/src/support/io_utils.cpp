@@ -1,11 +1,127 @@
 #include "io_utils.h"
 #include "common.h"
 
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <thread>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VEXEL_HAVE_MMAP 1
+#endif
 
 namespace vexel {
 
+namespace {
+
+// Concurrent compilers may write the same output; each uses its own
+// temporary and the last rename wins.
+std::string temporary_sibling(const std::string& path) {
+    size_t nonce = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                   static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#if defined(VEXEL_HAVE_MMAP)
+    nonce ^= static_cast<size_t>(::getpid()) << 20;
+#endif
+    return path + ".tmp" + std::to_string(nonce);
+}
+
+// Sizes first, so a changed output is usually told apart without reading it.
+bool file_holds(const std::string& path, std::string_view content) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) return false;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec || size != content.size()) return false;
+    try {
+        MappedTextFile existing(path);
+        return existing.view() == content;
+    } catch (const CompileError&) {
+        return false;
+    }
+}
+
+bool files_equal(const std::string& a, const std::string& b) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(b, ec)) return false;
+    const uintmax_t size = std::filesystem::file_size(a, ec);
+    if (ec || size != std::filesystem::file_size(b, ec) || ec) return false;
+    try {
+        MappedTextFile mapped(a);
+        return file_holds(b, mapped.view());
+    } catch (const CompileError&) {
+        return false;
+    }
+}
+
+// True when `path` lies in /proc, directly or through a symlinked directory
+// such as /dev/fd.
+bool in_proc(const std::filesystem::path& path) {
+    std::error_code ec;
+    const std::filesystem::path parent = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    const std::filesystem::path dir = std::filesystem::weakly_canonical(parent, ec);
+    const std::string text = (ec ? parent : dir).string();
+    return text == "/proc" || text.rfind("/proc/", 0) == 0;
+}
+
+// The file a write to `path` lands in: symlinks are followed, even dangling
+// ones, so renaming a temporary over the result replaces the link's target
+// rather than the link. False when the path or a link on the way is in
+// /proc (`/dev/stdout`, `/dev/fd/1`): it names an open descriptor whose file
+// must be written, never replaced.
+bool resolve_symlinks(const std::string& path, std::string& target_out) {
+    std::filesystem::path target(path);
+    if (in_proc(target)) return false;
+    std::error_code ec;
+    for (int hops = 0; hops < 40 && std::filesystem::is_symlink(target, ec); ++hops) {
+        const std::filesystem::path link = std::filesystem::read_symlink(target, ec);
+        if (ec) break;
+        target = link.is_absolute() ? link : target.parent_path() / link;
+        if (in_proc(target)) return false;
+    }
+    target_out = target.string();
+    return true;
+}
+
+// Moves a fully written temporary into place, or drops it when `target`
+// already holds the same bytes. An existing target keeps its permissions.
+void commit_temporary(const std::string& tmp_path, const std::string& target, const std::string& path) {
+    std::error_code ec;
+    if (files_equal(tmp_path, target)) {
+        std::filesystem::remove(tmp_path, ec);
+        return;
+    }
+    const std::filesystem::file_status existing = std::filesystem::status(target, ec);
+    if (!ec && std::filesystem::is_regular_file(existing)) {
+        std::filesystem::permissions(tmp_path, existing.permissions(), ec);
+    }
+    std::filesystem::rename(tmp_path, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        throw CompileError("Cannot write file: " + path, SourceLocation());
+    }
+}
+
+// Devices, pipes and descriptors (`/dev/stdout`) cannot be replaced; they
+// are written directly. Appending keeps what a redirected stream already
+// holds.
+void write_in_place(const std::string& path, const std::function<void(std::ostream&)>& write) {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (!file) {
+        throw CompileError("Cannot write file: " + path, SourceLocation());
+    }
+    write(file);
+    file.flush();
+    if (!file) {
+        throw CompileError("Cannot write file: " + path, SourceLocation());
+    }
+}
+
+} // namespace
+
 std::string read_text_file_or_throw(const std::string& path) {
     std::ifstream file(path);
     if (!file) {
@@ -15,11 +131,83 @@ std::string read_text_file_or_throw(const std::string& path) {
 }
 
 void write_text_file_or_throw(const std::string& path, const std::string& content) {
-    std::ofstream file(path);
+    std::string target;
+    if (resolve_symlinks(path, target) && file_holds(target, content)) return;
+    write_file_stream_or_throw(path, [&](std::ostream& out) { out << content; });
+}
+
+void write_file_stream_or_throw(const std::string& path, const std::function<void(std::ostream&)>& write) {
+    std::error_code ec;
+    const std::filesystem::file_status status = std::filesystem::status(path, ec);
+    std::string target;
+    if ((!ec && std::filesystem::exists(status) && !std::filesystem::is_regular_file(status)) ||
+        !resolve_symlinks(path, target)) {
+        write_in_place(path, write);
+        return;
+    }
+    const std::string tmp_path = temporary_sibling(target);
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw CompileError("Cannot write file: " + path, SourceLocation());
+        }
+        try {
+            write(file);
+        } catch (...) {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            throw;
+        }
+        file.flush();
+        if (!file) {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp_path, ec);
+            throw CompileError("Cannot write file: " + path, SourceLocation());
+        }
+    }
+    commit_temporary(tmp_path, target, path);
+}
+
+MappedTextFile::MappedTextFile(const std::string& path) {
+#if defined(VEXEL_HAVE_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            if (st.st_size == 0) {
+                ::close(fd);
+                return;
+            }
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::close(fd);
+                data_ = static_cast<const char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+                mapped_ = true;
+                return;
+            }
+        }
+        ::close(fd);
+    }
+#endif
+    // Binary mode so the fallback sees the same bytes as the mapping.
+    std::ifstream file(path, std::ios::binary);
     if (!file) {
-        throw CompileError("Cannot write file: " + path, SourceLocation());
+        throw CompileError("Cannot open file: " + path, SourceLocation());
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedTextFile::~MappedTextFile() {
+#if defined(VEXEL_HAVE_MMAP)
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
     }
-    file << content;
+#endif
 }
 
 } // namespace vexel
@@ -1,10 +1,42 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <ostream>
 #include <string>
+#include <string_view>
 
 namespace vexel {
 
 std::string read_text_file_or_throw(const std::string& path);
+// Output writers leave `path` untouched, modification time included, when it
+// already holds exactly the new content, so build systems tracking generated
+// files see no change. Otherwise the content goes to a private temporary
+// next to the file `path` names, symlinks followed, that is renamed over it
+// with the old file's permissions, and readers never see a partial file.
+// Paths that exist but are not regular files (devices, pipes) and paths that
+// reach a file through /proc (`/dev/stdout`, `/dev/fd/N`) are appended to in
+// place. Both throw if the file cannot be written.
 void write_text_file_or_throw(const std::string& path, const std::string& content);
+// Lets `write` stream the content, so large outputs never exist as one string.
+void write_file_stream_or_throw(const std::string& path, const std::function<void(std::ostream&)>& write);
+
+// Read-only raw bytes of a file, memory-mapped where the host supports it and
+// read into memory otherwise. view() stays valid for the object's life.
+class MappedTextFile {
+public:
+    explicit MappedTextFile(const std::string& path);
+    ~MappedTextFile();
+    MappedTextFile(const MappedTextFile&) = delete;
+    MappedTextFile& operator=(const MappedTextFile&) = delete;
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+};
 
 } // namespace vexel
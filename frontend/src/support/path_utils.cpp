@@ -1,5 +1,5 @@
 #include "path_utils.h"
-#include <filesystem>
+#include <algorithm>
 #include <cstdlib>
 
 namespace vexel {
@@ -36,6 +36,63 @@ bool try_builtin_std_root_from_macro(std::filesystem::path& out) {
 #endif
     return false;
 }
+
+bool path_exists(const std::filesystem::path& path, DirectoryCache* cache) {
+    return cache ? cache->exists(path) : std::filesystem::exists(path);
+}
+
+bool lookup_builtin_std_root(std::string& out_path, DirectoryCache* cache) {
+    return cache ? cache->builtin_std_root(out_path) : try_get_builtin_std_root(out_path);
+}
+}
+
+bool DirectoryCache::exists(const std::filesystem::path& path) {
+    ++lookups_;
+    const std::filesystem::path name = path.filename();
+    if (name.empty() || name == "." || name == "..") {
+        return std::filesystem::exists(path);
+    }
+    std::filesystem::path dir = path.parent_path();
+    if (dir.empty()) dir = ".";
+    // "./lib" and "lib" share a listing; ".." is left alone, as it need not
+    // name the lexical parent when symlinks are involved.
+    if (std::find(dir.begin(), dir.end(), "..") == dir.end()) {
+        dir = dir.lexically_normal();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = listings_.find(dir.string());
+    if (it == listings_.end()) {
+        Listing listing;
+        std::error_code ec;
+        std::filesystem::directory_iterator entries(dir, ec);
+        if (!ec) {
+            listing.readable = true;
+            for (const auto& entry : entries) {
+                // A dangling symlink is listed but does not exist.
+                std::error_code entry_ec;
+                if (entry.is_symlink(entry_ec) && !entry.exists(entry_ec)) continue;
+                listing.entries.insert(entry.path().filename().string());
+            }
+        }
+        it = listings_.emplace(dir.string(), std::move(listing)).first;
+    }
+    return it->second.readable && it->second.entries.count(name.string()) > 0;
+}
+
+bool DirectoryCache::builtin_std_root(std::string& out_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!std_root_known_) {
+        has_std_root_ = try_get_builtin_std_root(std_root_);
+        std_root_known_ = true;
+    }
+    if (has_std_root_) out_path = std_root_;
+    return has_std_root_;
+}
+
+size_t DirectoryCache::listings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return listings_.size();
 }
 
 std::string join_import_path(const std::vector<std::string>& import_path) {
@@ -50,13 +107,14 @@ std::string join_import_path(const std::vector<std::string>& import_path) {
 bool try_resolve_relative_path(const std::string& relative,
                                const std::string& current_file,
                                const std::string& project_root,
-                               std::string& out_path) {
+                               std::string& out_path,
+                               DirectoryCache* cache) {
     std::filesystem::path rel_path(relative);
     const bool std_path = has_std_prefix(relative);
 
     if (!project_root.empty()) {
         std::filesystem::path full = std::filesystem::path(project_root) / rel_path;
-        if (std::filesystem::exists(full)) {
+        if (path_exists(full, cache)) {
             out_path = full.string();
             return true;
         }
@@ -68,7 +126,7 @@ bool try_resolve_relative_path(const std::string& relative,
         std::filesystem::path current_dir = std::filesystem::path(current_file).parent_path();
         if (!current_dir.empty()) {
             std::filesystem::path full = current_dir / rel_path;
-            if (std::filesystem::exists(full)) {
+            if (path_exists(full, cache)) {
                 out_path = full.string();
                 return true;
             }
@@ -77,10 +135,10 @@ bool try_resolve_relative_path(const std::string& relative,
 
     if (std_path) {
         std::string builtin_std_root;
-        if (try_get_builtin_std_root(builtin_std_root)) {
+        if (lookup_builtin_std_root(builtin_std_root, cache)) {
             std::filesystem::path subpath = rel_path.lexically_relative("std");
             std::filesystem::path full = std::filesystem::path(builtin_std_root) / subpath;
-            if (std::filesystem::exists(full)) {
+            if (path_exists(full, cache)) {
                 out_path = full.string();
                 return true;
             }
@@ -93,9 +151,10 @@ bool try_resolve_relative_path(const std::string& relative,
 bool try_resolve_resource_path(const std::vector<std::string>& import_path,
                                const std::string& current_file,
                                const std::string& project_root,
-                               std::string& out_path) {
+                               std::string& out_path,
+                               DirectoryCache* cache) {
     std::string relative = join_import_path(import_path);
-    return try_resolve_relative_path(relative, current_file, project_root, out_path);
+    return try_resolve_relative_path(relative, current_file, project_root, out_path, cache);
 }
 
 bool try_get_builtin_std_root(std::string& out_path) {
@@ -113,9 +172,9 @@ bool try_get_builtin_std_root(std::string& out_path) {
     return false;
 }
 
-bool is_bundled_std_path(const std::string& path, std::string* std_relative_path) {
+bool is_bundled_std_path(const std::string& path, std::string* std_relative_path, DirectoryCache* cache) {
     std::string builtin_std_root;
-    if (!try_get_builtin_std_root(builtin_std_root)) {
+    if (!lookup_builtin_std_root(builtin_std_root, cache)) {
         return false;
     }
     std::filesystem::path root = std::filesystem::absolute(std::filesystem::path(builtin_std_root)).lexically_normal();
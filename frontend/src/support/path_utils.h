@@ -1,20 +1,58 @@
 #pragma once
+#include <atomic>
+#include <filesystem>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace vexel {
 
+// Per-compilation cache of the directories searched for imports and resources.
+// Each directory is listed once, the first time a candidate under it is
+// queried, and every later existence check is answered from that listing, so
+// resolving the same std and library imports from many modules costs one
+// directory read per directory instead of a stat per candidate. Entries are
+// matched by exact name. Listings are not refreshed: files created during the
+// compilation are not seen. Safe to share between worker threads.
+class DirectoryCache {
+public:
+    // Same answer as std::filesystem::exists(path).
+    bool exists(const std::filesystem::path& path);
+    // try_get_builtin_std_root, looked up once.
+    bool builtin_std_root(std::string& out_path);
+
+    size_t lookups() const { return lookups_; }
+    size_t listings() const;
+
+private:
+    struct Listing {
+        bool readable = false;
+        std::unordered_set<std::string> entries;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Listing> listings_;
+    std::atomic<size_t> lookups_{0};
+    bool std_root_known_ = false;
+    bool has_std_root_ = false;
+    std::string std_root_;
+};
+
 std::string join_import_path(const std::vector<std::string>& import_path);
 
 bool try_resolve_relative_path(const std::string& relative,
                                const std::string& current_file,
                                const std::string& project_root,
-                               std::string& out_path);
+                               std::string& out_path,
+                               DirectoryCache* cache = nullptr);
 
 bool try_resolve_resource_path(const std::vector<std::string>& import_path,
                                const std::string& current_file,
                                const std::string& project_root,
-                               std::string& out_path);
+                               std::string& out_path,
+                               DirectoryCache* cache = nullptr);
 
 // Return the bundled std/ root directory if available in this build context.
 // This is used as a fallback for ::std::* imports when no project-local module
@@ -24,6 +62,7 @@ bool try_get_builtin_std_root(std::string& out_path);
 // Returns true when `path` resolves under the bundled std/ tree used by the
 // compiler runtime, and optionally writes the module-relative suffix
 // (e.g. "math.vx").
-bool is_bundled_std_path(const std::string& path, std::string* std_relative_path = nullptr);
+bool is_bundled_std_path(const std::string& path, std::string* std_relative_path = nullptr,
+                         DirectoryCache* cache = nullptr);
 
 } // namespace vexel
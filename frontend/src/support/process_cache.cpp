@@ -0,0 +1,114 @@
+#include "process_cache.h"
+
+#include "common.h"
+#include "content_hash.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace vexel {
+
+namespace {
+
+// The build stamp keeps entries from a different compiler build out, since the
+// shell invocation details may change between builds.
+constexpr const char* kCacheHeader = "vexel-process-cache 1 " __DATE__ " " __TIME__;
+
+}
+
+std::string ProcessOutputCache::key_for(const std::string& command) {
+    // Declared inputs are hashed once per compilation, on first use.
+    if (!inputs_hashed_) {
+        ContentHasher inputs;
+        inputs.add_u64(inputs_.size());
+        for (const std::string& input : inputs_) {
+            inputs.add_string(input);
+            std::ifstream file(input, std::ios::binary);
+            if (!file) {
+                inputs.add_tag('-');
+                continue;
+            }
+            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            inputs.add_tag('+');
+            inputs.add_string(content);
+        }
+        inputs_digest_ = inputs.hex();
+        inputs_hashed_ = true;
+    }
+
+    std::error_code ec;
+    const std::filesystem::path cwd = std::filesystem::current_path(ec);
+    ContentHasher hasher;
+    hasher.add_bytes(kCacheHeader, std::strlen(kCacheHeader));
+    hasher.add_string(ec ? std::string() : cwd.string());
+    hasher.add_string(command);
+    hasher.add_string(inputs_digest_);
+    return hasher.hex();
+}
+
+std::string ProcessOutputCache::entry_path(const std::string& key) const {
+    return (std::filesystem::path(dir_) / "process" / (key + ".out")).string();
+}
+
+bool ProcessOutputCache::load_entry(const std::string& key, std::string& out) const {
+    std::ifstream file(entry_path(key), std::ios::binary);
+    if (!file) return false;
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const size_t header_size = std::strlen(kCacheHeader);
+    if (content.size() <= header_size || content.compare(0, header_size, kCacheHeader) != 0 ||
+        content[header_size] != '\n') {
+        return false;
+    }
+    out = content.substr(header_size + 1);
+    return true;
+}
+
+void ProcessOutputCache::store_entry(const std::string& key, const std::string& output) const {
+    const std::string target = entry_path(key);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(target).parent_path(), ec);
+
+    const size_t nonce = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                         static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const std::string tmp_path = target + ".tmp" + std::to_string(nonce);
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw CompileError("Cannot write file: " + tmp_path, SourceLocation());
+        }
+        file << kCacheHeader << '\n' << output;
+    }
+    std::filesystem::rename(tmp_path, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        throw CompileError("Cannot write file: " + target, SourceLocation());
+    }
+}
+
+std::string ProcessOutputCache::output_for(const std::string& command, const std::function<std::string()>& run) {
+    // Held across `run` so concurrent requests for one command execute it once.
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string key = key_for(command);
+    auto it = outputs_.find(key);
+    if (it != outputs_.end()) {
+        ++hits_;
+        return it->second;
+    }
+
+    std::string output;
+    if (!dir_.empty() && load_entry(key, output)) {
+        ++hits_;
+    } else {
+        output = run();
+        ++runs_;
+        if (!dir_.empty()) store_entry(key, output);
+    }
+    outputs_.emplace(key, output);
+    return output;
+}
+
+} // namespace vexel
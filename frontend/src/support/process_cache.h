@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vexel {
+
+// Opt-in cache of process-expression outputs. Keys hash the command string,
+// the working directory it runs in and the contents of a declared set of input
+// files, so identical commands run once per compilation and, with a cache
+// directory, once across builds until an input changes. Commands are assumed
+// to depend on nothing beyond those inputs; undeclared dependencies are the
+// caller's responsibility.
+class ProcessOutputCache {
+public:
+    // An empty `dir` keeps entries in memory only.
+    ProcessOutputCache(std::string dir, std::vector<std::string> inputs)
+        : dir_(std::move(dir)), inputs_(std::move(inputs)) {}
+
+    // Output of `command`, from the cache or by calling `run` and recording it.
+    // Errors thrown by `run` propagate and are not cached.
+    std::string output_for(const std::string& command, const std::function<std::string()>& run);
+
+    size_t hits() const { return hits_; }
+    size_t runs() const { return runs_; }
+    const std::string& dir() const { return dir_; }
+
+private:
+    std::string key_for(const std::string& command);
+    std::string entry_path(const std::string& key) const;
+    bool load_entry(const std::string& key, std::string& out) const;
+    void store_entry(const std::string& key, const std::string& output) const;
+
+    std::string dir_;
+    std::vector<std::string> inputs_;
+    std::string inputs_digest_;
+    bool inputs_hashed_ = false;
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::string> outputs_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> runs_{0};
+};
+
+} // namespace vexel
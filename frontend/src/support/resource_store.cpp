@@ -0,0 +1,101 @@
+#include "resource_store.h"
+
+#include "common.h"
+#include "io_utils.h"
+
+#include <algorithm>
+
+namespace vexel {
+
+namespace {
+
+std::string canonical_key(const std::filesystem::path& path) {
+    std::error_code ec;
+    const std::filesystem::path key_path = std::filesystem::weakly_canonical(path, ec);
+    return ec ? path.string() : key_path.string();
+}
+
+} // namespace
+
+std::shared_ptr<const std::string> ResourceStore::read_file(const std::filesystem::path& path) {
+    const std::string key = canonical_key(path);
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) return nullptr;
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(key);
+        if (it != files_.end() && it->second.size == size && it->second.mtime == mtime) {
+            return it->second.data;
+        }
+    }
+
+    std::shared_ptr<const std::string> data;
+    try {
+        MappedTextFile file(path.string());
+        data = std::make_shared<const std::string>(file.view());
+    } catch (const CompileError&) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CachedFile& cached = files_[key];
+    cached.size = size;
+    cached.mtime = mtime;
+    cached.data = data;
+    ++files_read_;
+    return data;
+}
+
+std::vector<ResourceStore::Entry> ResourceStore::read_directory(const std::filesystem::path& dir) {
+    note_directory(dir);
+    std::vector<std::filesystem::path> paths;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.is_regular_file()) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end(), [](const auto& a, const auto& b) {
+        return a.filename().string() < b.filename().string();
+    });
+
+    std::vector<Entry> entries;
+    entries.reserve(paths.size());
+    for (const auto& path : paths) {
+        entries.push_back({path.filename().string(), read_file(path)});
+    }
+    return entries;
+}
+
+void ResourceStore::note_directory(const std::filesystem::path& path) {
+    const std::string key = canonical_key(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    directories_.insert(key);
+}
+
+size_t ResourceStore::files_read() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_read_;
+}
+
+std::vector<std::string> ResourceStore::files() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    out.reserve(files_.size());
+    for (const auto& entry : files_) {
+        out.push_back(entry.first);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+std::vector<std::string> ResourceStore::directories() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<std::string>(directories_.begin(), directories_.end());
+}
+
+} // namespace vexel
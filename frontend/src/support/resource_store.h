@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vexel {
+
+// Contents of `::path` resource files for one compilation. Each file is read
+// once (memory-mapped where supported) and its payload shared by every
+// reference; an entry is re-read only if the file's size or mtime changes.
+class ResourceStore {
+public:
+    struct Entry {
+        std::string name;  // File name within its directory.
+        std::shared_ptr<const std::string> data;
+    };
+
+    // Returns null when the file cannot be opened.
+    std::shared_ptr<const std::string> read_file(const std::filesystem::path& path);
+    // Regular files of `dir` sorted by file name; `data` is null for a listed
+    // file that cannot be opened.
+    std::vector<Entry> read_directory(const std::filesystem::path& dir);
+    // Records a path whose directory listing the compilation depends on. Also
+    // used for resource paths that named nothing, since creating them later
+    // would change the result.
+    void note_directory(const std::filesystem::path& path);
+
+    size_t files_read() const;
+    // Canonical paths of every file read and every noted directory, sorted.
+    std::vector<std::string> files() const;
+    std::vector<std::string> directories() const;
+
+private:
+    struct CachedFile {
+        uintmax_t size = 0;
+        std::filesystem::file_time_type mtime;
+        std::shared_ptr<const std::string> data;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, CachedFile> files_;
+    std::set<std::string> directories_;
+    size_t files_read_ = 0;
+};
+
+} // namespace vexel
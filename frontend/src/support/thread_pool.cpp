@@ -0,0 +1,73 @@
+#include "thread_pool.h"
+
+namespace vexel {
+
+unsigned resolve_worker_count(int requested) {
+#if defined(__EMSCRIPTEN__)
+    (void)requested;
+    return 1;
+#else
+    if (requested > 0) return static_cast<unsigned>(requested);
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : hardware;
+#endif
+}
+
+ThreadPool::ThreadPool(unsigned workers) : workers_(workers == 0 ? 1 : workers) {
+    if (workers_ == 1) return;
+    threads_.reserve(workers_);
+    for (unsigned i = 0; i < workers_; ++i) {
+        threads_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (threads_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    work_ready_.notify_one();
+}
+
+void ThreadPool::wait() {
+    if (threads_.empty()) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return tasks_.empty() && active_ == 0; });
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++active_;
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+            if (tasks_.empty() && active_ == 0) idle_.notify_all();
+        }
+    }
+}
+
+} // namespace vexel
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vexel {
+
+// Worker count for parallel frontend stages: `requested` when positive,
+// otherwise the host's hardware concurrency. Always 1 on single-threaded
+// targets (the wasm playground).
+unsigned resolve_worker_count(int requested);
+
+// Fixed-size pool for independent frontend tasks. Tasks may submit further
+// tasks. With a single worker no threads are started and tasks run inline on
+// the submitting thread, which keeps the serial path identical to a plain loop.
+// Tasks must not throw; capture failures and rethrow after wait().
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned workers);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task (including nested ones) has finished.
+    void wait();
+    unsigned size() const { return workers_; }
+
+private:
+    void worker_loop();
+
+    unsigned workers_ = 1;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable idle_;
+    std::deque<std::function<void()>> tasks_;
+    size_t active_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace vexel
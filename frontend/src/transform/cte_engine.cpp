@@ -5,19 +5,34 @@
 
 namespace vexel {
 
-CTEEngine::CTEEngine(TypeChecker* checker)
-    : type_checker_(checker),
-      evaluator_(std::make_unique<CompileTimeEvaluator>(checker)) {}
+CTEEngine::CTEEngine(TypeChecker* checker) : type_checker_(checker) {}
 
-void CTEEngine::prepare_query(const std::unordered_map<const Symbol*, CTValue>& symbol_constants,
-                              ExprValueObserver value_observer,
-                              SymbolReadObserver symbol_read_observer) {
-    evaluator_->reset_state();
-    for (const auto& entry : symbol_constants) {
-        evaluator_->set_symbol_constant(entry.first, entry.second);
+// Holds one nesting level for the duration of a query.
+class CTEEngine::ActiveQuery {
+public:
+    explicit ActiveQuery(CTEEngine& engine) : engine_(engine) { ++engine_.depth_; }
+    ~ActiveQuery() { --engine_.depth_; }
+    ActiveQuery(const ActiveQuery&) = delete;
+    ActiveQuery& operator=(const ActiveQuery&) = delete;
+
+private:
+    CTEEngine& engine_;
+};
+
+CompileTimeEvaluator& CTEEngine::prepare_query(const std::unordered_map<const Symbol*, CTValue>& symbol_constants,
+                                               ExprValueObserver value_observer,
+                                               SymbolReadObserver symbol_read_observer) {
+    if (evaluators_.size() < depth_) {
+        auto evaluator = std::make_unique<CompileTimeEvaluator>(type_checker_);
+        evaluator->set_resolved_symbol_log(resolved_symbol_log_);
+        evaluators_.push_back(std::move(evaluator));
     }
-    evaluator_->set_value_observer(std::move(value_observer));
-    evaluator_->set_symbol_read_observer(std::move(symbol_read_observer));
+    CompileTimeEvaluator& evaluator = *evaluators_[depth_ - 1];
+    evaluator.reset_state();
+    evaluator.set_symbol_constants(&symbol_constants);
+    evaluator.set_value_observer(std::move(value_observer));
+    evaluator.set_symbol_read_observer(std::move(symbol_read_observer));
+    return evaluator;
 }
 
 CTEQueryResult CTEEngine::query(int instance_id,
@@ -25,19 +40,14 @@ CTEQueryResult CTEEngine::query(int instance_id,
                                 const std::unordered_map<const Symbol*, CTValue>& symbol_constants,
                                 ExprValueObserver value_observer,
                                 SymbolReadObserver symbol_read_observer) {
-    if (!evaluator_) {
-        return CTEQueryResult{};
-    }
-
+    ActiveQuery active(*this);
     if (type_checker_) {
         auto scope = type_checker_->scoped_instance(instance_id);
         (void)scope;
-        prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer));
-        return evaluator_->query(expr);
+        return prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer))
+            .query(expr);
     }
-
-    prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer));
-    return evaluator_->query(expr);
+    return prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer)).query(expr);
 }
 
 bool CTEEngine::try_evaluate(int instance_id,
@@ -46,19 +56,15 @@ bool CTEEngine::try_evaluate(int instance_id,
                              const std::unordered_map<const Symbol*, CTValue>& symbol_constants,
                              ExprValueObserver value_observer,
                              SymbolReadObserver symbol_read_observer) {
-    if (!evaluator_) {
-        return false;
-    }
-
+    ActiveQuery active(*this);
     if (type_checker_) {
         auto scope = type_checker_->scoped_instance(instance_id);
         (void)scope;
-        prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer));
-        return evaluator_->try_evaluate(expr, out);
+        return prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer))
+            .evaluate(expr, out);
     }
-
-    prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer));
-    return evaluator_->try_evaluate(expr, out);
+    return prepare_query(symbol_constants, std::move(value_observer), std::move(symbol_read_observer))
+        .evaluate(expr, out);
 }
 
 } // namespace vexel
@@ -6,6 +6,7 @@
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace vexel {
 
@@ -15,7 +16,12 @@ struct Symbol;
 using ExprPtr = std::shared_ptr<Expr>;
 
 // Canonical frontend service for compile-time expression queries.
-// Callers seed symbol constants and optional trace observers per query.
+// Callers seed symbol constants and optional trace observers per query. The
+// evaluator reads the caller's map in place and keeps its memo tables between
+// queries; an entry is dropped once a seeded symbol it read changes value.
+// Queries may nest: a query that calls a function whose body check was
+// deferred checks it first, which can issue queries of its own. Each nesting
+// level runs on its own evaluator.
 class CTEEngine {
 public:
     using ExprValueObserver = std::function<void(const Expr*, const CTValue&)>;
@@ -36,13 +42,26 @@ public:
                       ExprValueObserver value_observer = {},
                       SymbolReadObserver symbol_read_observer = {});
 
+    // See CompileTimeEvaluator::set_resolved_symbol_log.
+    void set_resolved_symbol_log(CompileTimeEvaluator::ResolvedSymbolLog* log) {
+        resolved_symbol_log_ = log;
+        for (auto& evaluator : evaluators_) {
+            evaluator->set_resolved_symbol_log(log);
+        }
+    }
+
 private:
-    void prepare_query(const std::unordered_map<const Symbol*, CTValue>& symbol_constants,
-                       ExprValueObserver value_observer,
-                       SymbolReadObserver symbol_read_observer);
+    class ActiveQuery;
+
+    CompileTimeEvaluator& prepare_query(const std::unordered_map<const Symbol*, CTValue>& symbol_constants,
+                                        ExprValueObserver value_observer,
+                                        SymbolReadObserver symbol_read_observer);
 
     TypeChecker* type_checker_ = nullptr;
-    std::unique_ptr<CompileTimeEvaluator> evaluator_;
+    // evaluators_[d] runs queries nested d deep.
+    std::vector<std::unique_ptr<CompileTimeEvaluator>> evaluators_;
+    size_t depth_ = 0;
+    CompileTimeEvaluator::ResolvedSymbolLog* resolved_symbol_log_ = nullptr;
 };
 
 } // namespace vexel
@@ -0,0 +1,146 @@
+#include "cte_math.h"
+#include <cmath>
+#include <unordered_map>
+
+namespace vexel {
+
+namespace {
+
+enum class MathShape { UnaryF64, BinaryF64, PredicateF64, UnaryF32, BinaryF32, ExactUnaryF32, PredicateF32 };
+
+struct MathEntry {
+    MathShape shape;
+    double (*unary)(double) = nullptr;
+    double (*binary)(double, double) = nullptr;
+    float (*exact_f32)(float) = nullptr;
+    bool (*predicate)(double) = nullptr;
+};
+
+MathEntry unary_f64(double (*fn)(double)) { return MathEntry{MathShape::UnaryF64, fn}; }
+MathEntry binary_f64(double (*fn)(double, double)) { return MathEntry{MathShape::BinaryF64, nullptr, fn}; }
+MathEntry unary_f32(double (*fn)(double)) { return MathEntry{MathShape::UnaryF32, fn}; }
+MathEntry binary_f32(double (*fn)(double, double)) { return MathEntry{MathShape::BinaryF32, nullptr, fn}; }
+MathEntry exact_f32(float (*fn)(float)) { return MathEntry{MathShape::ExactUnaryF32, nullptr, nullptr, fn}; }
+MathEntry predicate(MathShape shape, bool (*fn)(double)) { return MathEntry{shape, nullptr, nullptr, nullptr, fn}; }
+
+double d_sin(double x) { return std::sin(x); }
+double d_cos(double x) { return std::cos(x); }
+double d_tan(double x) { return std::tan(x); }
+double d_asin(double x) { return std::asin(x); }
+double d_acos(double x) { return std::acos(x); }
+double d_atan(double x) { return std::atan(x); }
+double d_exp(double x) { return std::exp(x); }
+double d_log(double x) { return std::log(x); }
+double d_log2(double x) { return std::log2(x); }
+double d_log10(double x) { return std::log10(x); }
+double d_floor(double x) { return std::floor(x); }
+double d_ceil(double x) { return std::ceil(x); }
+double d_trunc(double x) { return std::trunc(x); }
+double d_round(double x) { return std::round(x); }
+double d_fabs(double x) { return std::fabs(x); }
+double d_sqrt(double x) { return std::sqrt(x); }
+double d_pow(double x, double y) { return std::pow(x, y); }
+double d_atan2(double y, double x) { return std::atan2(y, x); }
+double d_fmod(double x, double y) { return std::fmod(x, y); }
+
+float f_floor(float x) { return std::floor(x); }
+float f_ceil(float x) { return std::ceil(x); }
+float f_trunc(float x) { return std::trunc(x); }
+float f_round(float x) { return std::round(x); }
+float f_fabs(float x) { return std::fabs(x); }
+float f_sqrt(float x) { return std::sqrt(x); }
+
+bool is_nan(double x) { return std::isnan(x); }
+bool is_inf(double x) { return std::isinf(x); }
+bool is_finite(double x) { return std::isfinite(x); }
+
+const std::unordered_map<std::string, MathEntry>& math_table() {
+    static const std::unordered_map<std::string, MathEntry> table = {
+        {"sin", unary_f64(d_sin)},
+        {"cos", unary_f64(d_cos)},
+        {"tan", unary_f64(d_tan)},
+        {"asin", unary_f64(d_asin)},
+        {"acos", unary_f64(d_acos)},
+        {"atan", unary_f64(d_atan)},
+        {"exp", unary_f64(d_exp)},
+        {"log", unary_f64(d_log)},
+        {"log2", unary_f64(d_log2)},
+        {"log10", unary_f64(d_log10)},
+        {"floor", unary_f64(d_floor)},
+        {"ceil", unary_f64(d_ceil)},
+        {"trunc", unary_f64(d_trunc)},
+        {"round", unary_f64(d_round)},
+        {"fabs", unary_f64(d_fabs)},
+        {"sqrt", unary_f64(d_sqrt)},
+        {"pow", binary_f64(d_pow)},
+        {"atan2", binary_f64(d_atan2)},
+        {"fmod", binary_f64(d_fmod)},
+        {"isnan", predicate(MathShape::PredicateF64, is_nan)},
+        {"isinf", predicate(MathShape::PredicateF64, is_inf)},
+        {"isfinite", predicate(MathShape::PredicateF64, is_finite)},
+
+        {"sinf", unary_f32(d_sin)},
+        {"cosf", unary_f32(d_cos)},
+        {"tanf", unary_f32(d_tan)},
+        {"asinf", unary_f32(d_asin)},
+        {"acosf", unary_f32(d_acos)},
+        {"atanf", unary_f32(d_atan)},
+        {"expf", unary_f32(d_exp)},
+        {"logf", unary_f32(d_log)},
+        {"log2f", unary_f32(d_log2)},
+        {"log10f", unary_f32(d_log10)},
+        {"floorf", exact_f32(f_floor)},
+        {"ceilf", exact_f32(f_ceil)},
+        {"truncf", exact_f32(f_trunc)},
+        {"roundf", exact_f32(f_round)},
+        {"fabsf", exact_f32(f_fabs)},
+        {"sqrtf", exact_f32(f_sqrt)},
+        {"powf", binary_f32(d_pow)},
+        {"atan2f", binary_f32(d_atan2)},
+        // fmod is exact, so the f64 result of two f32 operands is already an f32.
+        {"fmodf", binary_f32(d_fmod)},
+        {"isnanf", predicate(MathShape::PredicateF32, is_nan)},
+        {"isinff", predicate(MathShape::PredicateF32, is_inf)},
+        {"isfinitef", predicate(MathShape::PredicateF32, is_finite)},
+    };
+    return table;
+}
+
+double to_f32(double x) { return static_cast<double>(static_cast<float>(x)); }
+
+} // namespace
+
+bool fold_std_math_call(const std::string& name, const std::vector<double>& args, CTValue& out) {
+    const auto& table = math_table();
+    auto it = table.find(name);
+    if (it == table.end()) return false;
+    const MathEntry& entry = it->second;
+    const bool binary = entry.shape == MathShape::BinaryF64 || entry.shape == MathShape::BinaryF32;
+    if (args.size() != (binary ? 2u : 1u)) return false;
+    switch (entry.shape) {
+        case MathShape::UnaryF64:
+            out = entry.unary(args[0]);
+            return true;
+        case MathShape::BinaryF64:
+            out = entry.binary(args[0], args[1]);
+            return true;
+        case MathShape::PredicateF64:
+            out = entry.predicate(args[0]);
+            return true;
+        case MathShape::UnaryF32:
+            out = to_f32(entry.unary(to_f32(args[0])));
+            return true;
+        case MathShape::BinaryF32:
+            out = to_f32(entry.binary(to_f32(args[0]), to_f32(args[1])));
+            return true;
+        case MathShape::ExactUnaryF32:
+            out = static_cast<double>(entry.exact_f32(static_cast<float>(args[0])));
+            return true;
+        case MathShape::PredicateF32:
+            out = entry.predicate(to_f32(args[0]));
+            return true;
+    }
+    return false;
+}
+
+} // namespace vexel
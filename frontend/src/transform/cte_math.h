@@ -0,0 +1,20 @@
+#pragma once
+#include "cte_value.h"
+#include <string>
+#include <vector>
+
+namespace vexel {
+
+// Compile-time implementations of the bundled `std::math` externals.
+// - Operations IEEE 754 defines exactly (sqrt, fmod, floor, ceil, trunc,
+//   round, fabs and the classification predicates) give the same bits as
+//   every conforming C runtime.
+// - f64 transcendentals use the host libm, which is what glibc targets run.
+// - f32 transcendentals are evaluated in f64 and rounded once, so they are
+//   correctly rounded except for results within one f64 ulp of a halfway
+//   point, and do not depend on the host's float routines.
+// Returns false when `name` is not a std::math external or `args` has the
+// wrong arity.
+bool fold_std_math_call(const std::string& name, const std::vector<double>& args, CTValue& out);
+
+} // namespace vexel
@@ -0,0 +1,330 @@
+#include "cte_persistent_cache.h"
+
+#include "common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace vexel {
+
+namespace {
+
+// Bump when the value encoding or key derivation changes. The build stamp keeps
+// entries written by a different compiler build (possibly with different
+// evaluator semantics) from being reused.
+constexpr const char* kCacheHeader = "vexel-cte-cache 1 " __DATE__ " " __TIME__;
+
+void append_length_prefixed(std::string& out, const std::string& text) {
+    out += std::to_string(text.size());
+    out.push_back(':');
+    out += text;
+}
+
+void encode_value(std::string& out, const CTValue& value) {
+    if (std::holds_alternative<int64_t>(value)) {
+        out += "i" + std::to_string(std::get<int64_t>(value)) + ";";
+    } else if (std::holds_alternative<uint64_t>(value)) {
+        out += "u" + std::to_string(std::get<uint64_t>(value)) + ";";
+    } else if (std::holds_alternative<CTExactInt>(value)) {
+        const CTExactInt& exact = std::get<CTExactInt>(value);
+        out += exact.is_unsigned ? "U" : "I";
+        out += exact.value.to_string() + ";";
+    } else if (std::holds_alternative<double>(value)) {
+        uint64_t bits = 0;
+        double dv = std::get<double>(value);
+        std::memcpy(&bits, &dv, sizeof(bits));
+        char buf[24];
+        std::snprintf(buf, sizeof(buf), "f%016llx;", static_cast<unsigned long long>(bits));
+        out += buf;
+    } else if (std::holds_alternative<bool>(value)) {
+        out += std::get<bool>(value) ? "b1;" : "b0;";
+    } else if (std::holds_alternative<CTString>(value)) {
+        out.push_back('s');
+        append_length_prefixed(out, std::get<CTString>(value).str());
+    } else if (std::holds_alternative<CTNoValue>(value)) {
+        out.push_back('n');
+    } else if (std::holds_alternative<CTUninitialized>(value)) {
+        out.push_back('x');
+    } else if (std::holds_alternative<std::shared_ptr<CTComposite>>(value)) {
+        auto comp = std::get<std::shared_ptr<CTComposite>>(value);
+        if (!comp) {
+            out.push_back('n');
+            return;
+        }
+        std::vector<const std::string*> names;
+        names.reserve(comp->fields.size());
+        for (const auto& field : comp->fields) {
+            names.push_back(&field.first);
+        }
+        std::sort(names.begin(), names.end(),
+                  [](const std::string* a, const std::string* b) { return *a < *b; });
+        out.push_back('c');
+        append_length_prefixed(out, comp->type_name);
+        out += std::to_string(names.size()) + ":";
+        for (const std::string* name : names) {
+            append_length_prefixed(out, *name);
+            encode_value(out, comp->fields.at(*name));
+        }
+    } else if (std::holds_alternative<std::shared_ptr<CTArray>>(value)) {
+        auto arr = std::get<std::shared_ptr<CTArray>>(value);
+        if (!arr) {
+            out.push_back('n');
+            return;
+        }
+        out += "a" + std::to_string(arr->size()) + ":";
+        for (size_t i = 0; i < arr->size(); ++i) {
+            encode_value(out, arr->at(i));
+        }
+    }
+}
+
+class ValueDecoder {
+public:
+    explicit ValueDecoder(const std::string& text) : text_(text) {}
+
+    bool decode(CTValue& out) {
+        if (!decode_value(out)) return false;
+        return pos_ == text_.size();
+    }
+
+private:
+    const std::string& text_;
+    size_t pos_ = 0;
+
+    bool read_until(char delim, std::string& out) {
+        size_t end = text_.find(delim, pos_);
+        if (end == std::string::npos) return false;
+        out = text_.substr(pos_, end - pos_);
+        pos_ = end + 1;
+        return true;
+    }
+
+    bool read_count(size_t& out) {
+        std::string digits;
+        if (!read_until(':', digits) || digits.empty()) return false;
+        for (char c : digits) {
+            if (c < '0' || c > '9') return false;
+        }
+        out = static_cast<size_t>(std::stoull(digits));
+        return true;
+    }
+
+    bool read_length_prefixed(std::string& out) {
+        size_t len = 0;
+        if (!read_count(len) || pos_ + len > text_.size()) return false;
+        out = text_.substr(pos_, len);
+        pos_ += len;
+        return true;
+    }
+
+    bool decode_exact(bool is_unsigned, CTValue& out) {
+        std::string digits;
+        if (!read_until(';', digits) || digits.empty()) return false;
+        bool negative = digits[0] == '-';
+        if (negative) digits.erase(0, 1);
+        if (digits.empty()) return false;
+        for (char c : digits) {
+            if (c < '0' || c > '9') return false;
+        }
+        CTExactInt exact;
+        exact.value = APInt::parse_integer_literal(digits, SourceLocation());
+        if (negative) exact.value = -exact.value;
+        exact.is_unsigned = is_unsigned;
+        exact.charge.set(exact.value.heap_bytes());
+        out = std::move(exact);
+        return true;
+    }
+
+    bool decode_value(CTValue& out) {
+        if (pos_ >= text_.size()) return false;
+        const char tag = text_[pos_++];
+        std::string token;
+        switch (tag) {
+            case 'i':
+                if (!read_until(';', token) || token.empty()) return false;
+                out = static_cast<int64_t>(std::stoll(token));
+                return true;
+            case 'u':
+                if (!read_until(';', token) || token.empty()) return false;
+                out = static_cast<uint64_t>(std::stoull(token));
+                return true;
+            case 'I':
+                return decode_exact(false, out);
+            case 'U':
+                return decode_exact(true, out);
+            case 'f': {
+                if (!read_until(';', token) || token.size() != 16) return false;
+                uint64_t bits = std::stoull(token, nullptr, 16);
+                double dv = 0.0;
+                std::memcpy(&dv, &bits, sizeof(dv));
+                out = dv;
+                return true;
+            }
+            case 'b':
+                if (!read_until(';', token) || (token != "0" && token != "1")) return false;
+                out = token == "1";
+                return true;
+            case 's':
+                if (!read_length_prefixed(token)) return false;
+                out = token;
+                return true;
+            case 'n':
+                out = CTNoValue{};
+                return true;
+            case 'x':
+                out = CTUninitialized{};
+                return true;
+            case 'c': {
+                auto comp = std::make_shared<CTComposite>();
+                size_t count = 0;
+                if (!read_length_prefixed(comp->type_name) || !read_count(count)) return false;
+                for (size_t i = 0; i < count; ++i) {
+                    std::string name;
+                    CTValue field;
+                    if (!read_length_prefixed(name) || !decode_value(field)) return false;
+                    comp->fields[name] = std::move(field);
+                }
+                out = comp;
+                return true;
+            }
+            case 'a': {
+                auto arr = std::make_shared<CTArray>();
+                size_t count = 0;
+                if (!read_count(count)) return false;
+                arr->reserve(count);
+                for (size_t i = 0; i < count; ++i) {
+                    CTValue elem;
+                    if (!decode_value(elem)) return false;
+                    arr->push_back(elem);
+                }
+                out = arr;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+};
+
+} // namespace
+
+void hash_ct_value(ContentHasher& hasher, const CTValue& value) {
+    hasher.add_string(encode_ct_value(value));
+}
+
+std::string encode_ct_value(const CTValue& value) {
+    std::string encoded;
+    encode_value(encoded, value);
+    return encoded;
+}
+
+bool decode_ct_value(const std::string& text, CTValue& out) {
+    try {
+        ValueDecoder decoder(text);
+        return decoder.decode(out);
+    } catch (const std::exception&) {
+        // Corrupt numeric payloads.
+        return false;
+    }
+}
+
+void CTEPersistentCache::load() {
+    entries_.clear();
+    dirty_ = false;
+    std::ifstream file(path_, std::ios::binary);
+    if (!file) return;
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const std::string header = std::string(kCacheHeader) + "\n";
+    if (content.compare(0, header.size(), header) != 0) return;
+
+    size_t pos = header.size();
+    while (pos < content.size()) {
+        size_t space = content.find(' ', pos);
+        size_t newline = content.find('\n', pos);
+        if (space == std::string::npos || newline == std::string::npos || space > newline) break;
+        std::string key = content.substr(pos, space - pos);
+        std::string len_text = content.substr(space + 1, newline - space - 1);
+        if (key.empty() || len_text.empty() ||
+            len_text.find_first_not_of("0123456789") != std::string::npos) {
+            break;
+        }
+        size_t len = static_cast<size_t>(std::stoull(len_text));
+        size_t payload = newline + 1;
+        if (payload + len + 1 > content.size() || content[payload + len] != '\n') break;
+        entries_[key] = content.substr(payload, len);
+        pos = payload + len + 1;
+    }
+}
+
+void CTEPersistentCache::save() const {
+    if (!dirty_) return;
+    std::filesystem::path target(path_);
+    if (target.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+
+    std::vector<const std::pair<const std::string, std::string>*> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        sorted.push_back(&entry);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    std::string tmp_path = path_ + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw CompileError("Cannot write file: " + tmp_path, SourceLocation());
+        }
+        file << kCacheHeader << "\n";
+        for (const auto* entry : sorted) {
+            file << entry->first << " " << entry->second.size() << "\n" << entry->second << "\n";
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path_, ec);
+    if (ec) {
+        throw CompileError("Cannot write file: " + path_, SourceLocation());
+    }
+}
+
+size_t CTEPersistentCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool CTEPersistentCache::lookup(const std::string& key, CTValue& out) const {
+    std::string payload;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return false;
+        payload = it->second;
+    }
+    // Corrupt payloads are treated as misses.
+    CTValue decoded;
+    if (!decode_ct_value(payload, decoded)) return false;
+    out = std::move(decoded);
+    hits_++;
+    return true;
+}
+
+void CTEPersistentCache::store(const std::string& key, const CTValue& value) {
+    std::string encoded = encode_ct_value(value);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->second == encoded) return;
+    entries_[key] = std::move(encoded);
+    dirty_ = true;
+}
+
+} // namespace vexel
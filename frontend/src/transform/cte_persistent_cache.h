@@ -0,0 +1,49 @@
+#pragma once
+
+#include "content_hash.h"
+#include "cte_value.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace vexel {
+
+// Appends a canonical encoding of `value` (composite fields sorted by name).
+void hash_ct_value(ContentHasher& hasher, const CTValue& value);
+// That canonical encoding as a self-delimiting string, and back. Composite
+// fields decode in name order.
+std::string encode_ct_value(const CTValue& value);
+bool decode_ct_value(const std::string& text, CTValue& out);
+
+// Opt-in on-disk cache of pure compile-time call results, shared by every
+// evaluator instance of one compilation. Keys are content hashes built by the
+// evaluator from the callee's transitive declarations and argument values.
+// Lookups and stores may come from concurrent optimizer workers.
+class CTEPersistentCache {
+public:
+    explicit CTEPersistentCache(std::string path) : path_(std::move(path)) {}
+
+    // Missing, unreadable or stale-format files start an empty cache.
+    void load();
+    // Writes the cache back only when new entries were stored.
+    void save() const;
+
+    bool lookup(const std::string& key, CTValue& out) const;
+    void store(const std::string& key, const CTValue& value);
+
+    size_t hits() const { return hits_; }
+    size_t size() const;
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    std::unordered_map<std::string, std::string> entries_;
+    bool dirty_ = false;
+    mutable std::atomic<size_t> hits_{0};
+    mutable std::mutex mutex_;
+};
+
+} // namespace vexel
@@ -0,0 +1,152 @@
+#include "cte_profile.h"
+
+#include "ast.h"
+#include "symbols.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+
+namespace vexel {
+
+namespace {
+
+std::string format_ms(double ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", ms);
+    return buf;
+}
+
+std::string pad_left(const std::string& text, size_t width) {
+    if (text.size() >= width) return text;
+    return std::string(width - text.size(), ' ') + text;
+}
+
+std::string pad_right(const std::string& text, size_t width) {
+    if (text.size() >= width) return text;
+    return text + std::string(width - text.size(), ' ');
+}
+
+std::string subject_location(const Symbol* sym) {
+    if (!sym->declaration) return "";
+    const SourceLocation& loc = sym->declaration->location;
+    std::string file = std::filesystem::path(loc.filename()).filename().string();
+    return file + ":" + std::to_string(loc.line);
+}
+
+} // namespace
+
+void CTEProfile::Counters::add(const Counters& other) {
+    evaluations += other.evaluations;
+    memo_hits += other.memo_hits;
+    memo_misses += other.memo_misses;
+    loop_iterations += other.loop_iterations;
+    steps += other.steps;
+    allocated_bytes += other.allocated_bytes;
+    total_ms += other.total_ms;
+    budget_exhausted += other.budget_exhausted;
+    memory_exhausted += other.memory_exhausted;
+}
+
+void CTEProfile::register_initializer(const Expr* init, const Symbol* sym) {
+    if (!init || !sym) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    initializers_.emplace(init, sym);
+}
+
+const Symbol* CTEProfile::initializer_subject(const Expr* expr) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = initializers_.find(expr);
+    return it == initializers_.end() ? nullptr : it->second;
+}
+
+void CTEProfile::merge(const PendingCounters& pending, const Counters& query) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : pending) {
+        subjects_[entry.first].add(entry.second);
+        if (!locations_.count(entry.first)) {
+            locations_.emplace(entry.first, subject_location(entry.first));
+        }
+    }
+    queries_.add(query);
+}
+
+std::string CTEProfile::format_report() const {
+    struct Row {
+        std::string kind;
+        std::string name;
+        std::string location;
+        Counters counters;
+    };
+    std::vector<Row> rows;
+    Counters queries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rows.reserve(subjects_.size());
+        for (const auto& entry : subjects_) {
+            const Symbol* sym = entry.first;
+            rows.push_back({sym->kind == Symbol::Kind::Function ? "fn" : "init",
+                            sym->name,
+                            locations_.at(sym),
+                            entry.second});
+        }
+        queries = queries_;
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        if (a.counters.total_ms != b.counters.total_ms) return a.counters.total_ms > b.counters.total_ms;
+        if (a.name != b.name) return a.name < b.name;
+        return a.location < b.location;
+    });
+
+    std::ostringstream out;
+    out << "=== Compile-time evaluation profile ===\n";
+    out << pad_right("kind", 6)
+        << pad_right("subject", 28)
+        << pad_right("location", 20)
+        << pad_left("evals", 10)
+        << pad_left("memo-hit", 10)
+        << pad_left("memo-miss", 10)
+        << pad_left("loop-iters", 12)
+        << pad_left("steps", 12)
+        << pad_left("alloc(B)", 12)
+        << pad_left("total(ms)", 12) << "\n";
+    for (const Row& row : rows) {
+        const Counters& c = row.counters;
+        out << pad_right(row.kind, 6)
+            << pad_right(row.name, 28)
+            << pad_right(row.location, 20)
+            << pad_left(std::to_string(c.evaluations), 10)
+            << pad_left(std::to_string(c.memo_hits), 10)
+            << pad_left(std::to_string(c.memo_misses), 10)
+            << pad_left(std::to_string(c.loop_iterations), 12)
+            << pad_left(std::to_string(c.steps), 12)
+            << pad_left(std::to_string(c.allocated_bytes), 12)
+            << pad_left(format_ms(c.total_ms), 12);
+        if (c.budget_exhausted > 0) {
+            out << "  budget exhausted x" << c.budget_exhausted;
+        }
+        if (c.memory_exhausted > 0) {
+            out << "  memory limit x" << c.memory_exhausted;
+        }
+        out << "\n";
+    }
+    out << pad_right("queries", 54)
+        << pad_left(std::to_string(queries.evaluations), 10)
+        << pad_left("", 20)
+        << pad_left(std::to_string(queries.loop_iterations), 12)
+        << pad_left(std::to_string(queries.steps), 12)
+        << pad_left(std::to_string(queries.allocated_bytes), 12)
+        << pad_left(format_ms(queries.total_ms), 12);
+    if (queries.budget_exhausted > 0) {
+        out << "  budget exhausted x" << queries.budget_exhausted;
+    }
+    if (queries.memory_exhausted > 0) {
+        out << "  memory limit x" << queries.memory_exhausted;
+    }
+    out << "\n";
+    return out.str();
+}
+
+} // namespace vexel
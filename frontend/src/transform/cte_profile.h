@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace vexel {
+
+struct Expr;
+struct Symbol;
+
+// Opt-in `--cte-profile` accounting of compile-time evaluation, shared by every
+// evaluator instance of one compilation. Subjects are function symbols (one
+// entry per evaluated call) and global symbols (one entry per evaluation of
+// their initializer, whether queried directly or read by another query).
+// Evaluators accumulate locally and merge once per root query, so merges may
+// come from concurrent optimizer workers.
+class CTEProfile {
+public:
+    struct Counters {
+        uint64_t evaluations = 0;
+        uint64_t memo_hits = 0;
+        uint64_t memo_misses = 0;
+        // Inclusive of callees; recursive re-entries are charged once, at the
+        // outermost frame of the subject.
+        uint64_t loop_iterations = 0;
+        uint64_t steps = 0;
+        uint64_t allocated_bytes = 0;
+        double total_ms = 0.0;
+        // Queries that ran out of steps while this subject was innermost.
+        uint64_t budget_exhausted = 0;
+        // Queries that hit the memory limit while this subject was innermost.
+        uint64_t memory_exhausted = 0;
+
+        void add(const Counters& other);
+    };
+
+    using PendingCounters = std::unordered_map<const Symbol*, Counters>;
+
+    // Names the global whose initializer `init` is, so root queries on the
+    // initializer itself are charged to it.
+    void register_initializer(const Expr* init, const Symbol* sym);
+    const Symbol* initializer_subject(const Expr* expr) const;
+
+    // Folds one root query: per-subject counters plus the query's own totals.
+    void merge(const PendingCounters& pending, const Counters& query);
+
+    // Text table sorted by total time, then a totals line over root queries.
+    std::string format_report() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<const Expr*, const Symbol*> initializers_;
+    PendingCounters subjects_;
+    // Declaration locations, taken when a subject is first merged: the
+    // pipeline drops pruned declarations before the report is formatted.
+    std::unordered_map<const Symbol*, std::string> locations_;
+    Counters queries_;
+};
+
+} // namespace vexel
@@ -34,6 +34,32 @@ bool fixed_any_meta(const TypePtr& type,
     return true;
 }
 
+// Wraps a host-word integer to an Int/UInt width of at most 64 bits, the way
+// the APInt path does, so calls on primitive-typed functions coerce their
+// arguments and results without leaving machine words.
+bool wrap_word_integer(const CTValue& input, uint64_t bits, bool to_unsigned, CTValue& output) {
+    if (bits == 0 || bits > 64) return false;
+    uint64_t raw = 0;
+    if (std::holds_alternative<int64_t>(input)) {
+        raw = static_cast<uint64_t>(std::get<int64_t>(input));
+    } else if (std::holds_alternative<uint64_t>(input)) {
+        raw = std::get<uint64_t>(input);
+    } else if (std::holds_alternative<bool>(input)) {
+        raw = std::get<bool>(input) ? 1 : 0;
+    } else {
+        return false;
+    }
+    const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    raw &= mask;
+    if (to_unsigned) {
+        output = raw;
+        return true;
+    }
+    if ((raw >> (bits - 1)) & 1u) raw |= ~mask;
+    output = static_cast<int64_t>(raw);
+    return true;
+}
+
 } // namespace
 
 CTEQueryResult CompileTimeEvaluator::query(ExprPtr expr) {
@@ -42,36 +68,166 @@ CTEQueryResult CompileTimeEvaluator::query(ExprPtr expr) {
 
     CTEQueryResult out;
     CTValue value;
-    if (try_evaluate(expr, value)) {
+    if (evaluate(expr, value)) {
         out.status = CTEQueryStatus::Known;
         out.value = copy_ct_value(value);
         return out;
     }
 
     out.status = hard_error ? CTEQueryStatus::Error : CTEQueryStatus::Unknown;
-    out.message = error_msg;
+    out.budget_exhausted = budget_exhausted;
+    out.memory_exhausted = memory_exhausted;
+    // Callers may have replaced the message while unwinding.
+    out.message = budget_exhausted ? step_budget_message() : memory_exhausted ? memory_limit_message() : error_msg;
     return out;
 }
 
+bool CompileTimeEvaluator::evaluate(ExprPtr expr, CTValue& result) {
+    completion = Completion::Normal;
+    memory_base = ct_live_bytes();
+    const int64_t outer_peak = ct_reset_peak_live_bytes();
+    const bool ok = profile ? evaluate_profiled(expr, result) : try_evaluate(expr, result);
+    const int64_t peak = ct_peak_live_bytes() - memory_base;
+    if (peak > 0 && type_checker) {
+        type_checker->note_cte_peak_bytes(static_cast<uint64_t>(peak));
+    }
+    ct_restore_peak_live_bytes(outer_peak);
+    return ok;
+}
+
+bool CompileTimeEvaluator::evaluate_profiled(ExprPtr expr, CTValue& result) {
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t start_steps = steps;
+    const uint64_t start_loops = loop_iterations;
+    const uint64_t start_bytes = ct_allocated_bytes();
+    bool ok = false;
+    {
+        ProfileScope scope(this, expr ? profile->initializer_subject(expr.get()) : nullptr);
+        ok = try_evaluate(expr, result);
+    }
+
+    CTEProfile::Counters totals;
+    totals.evaluations = 1;
+    totals.steps = steps - start_steps;
+    totals.loop_iterations = loop_iterations - start_loops;
+    totals.allocated_bytes = ct_allocated_bytes() - start_bytes;
+    totals.total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    totals.budget_exhausted = budget_exhausted ? 1 : 0;
+    totals.memory_exhausted = memory_exhausted ? 1 : 0;
+    profile->merge(profile_pending, totals);
+    profile_pending.clear();
+    return ok;
+}
+
+std::string CompileTimeEvaluator::step_budget_message() const {
+    return "Compile-time evaluation exceeded the step budget of " + std::to_string(step_budget) +
+           " steps (raise it with --cte-step-budget)";
+}
+
+std::string CompileTimeEvaluator::memory_limit_message() const {
+    return "Compile-time evaluation exceeded the memory limit of " + std::to_string(memory_limit) +
+           " bytes (raise it with --cte-memory-limit)";
+}
+
+bool CompileTimeEvaluator::within_memory_limit() {
+    if (memory_exhausted) return false;
+    const int64_t used = ct_live_bytes() - memory_base;
+    if (used <= 0 || static_cast<uint64_t>(used) <= memory_limit) return true;
+    memory_exhausted = true;
+    if (!profile_frames.empty()) {
+        profile_pending[profile_frames.back().subject].memory_exhausted++;
+    }
+    return false;
+}
+
+CompileTimeEvaluator::ProfileScope::ProfileScope(CompileTimeEvaluator* evaluator, const Symbol* subject) {
+    if (!evaluator->profile || !subject) return;
+    self = evaluator;
+    self->profile_frames.push_back({subject,
+                                    std::chrono::steady_clock::now(),
+                                    self->steps,
+                                    self->loop_iterations,
+                                    ct_allocated_bytes()});
+    self->profile_open_frames[subject]++;
+}
+
+CompileTimeEvaluator::ProfileScope::~ProfileScope() {
+    if (!self) return;
+    const ProfileFrame frame = self->profile_frames.back();
+    self->profile_frames.pop_back();
+    CTEProfile::Counters& counters = self->profile_pending[frame.subject];
+    counters.evaluations++;
+    if (--self->profile_open_frames[frame.subject] > 0) return;
+    counters.steps += self->steps - frame.steps;
+    counters.loop_iterations += self->loop_iterations - frame.loop_iterations;
+    counters.allocated_bytes += ct_allocated_bytes() - frame.allocated_bytes;
+    counters.total_ms +=
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.start).count();
+}
+
+void CompileTimeEvaluator::record_memo_lookup(const Symbol* func_sym, bool hit) {
+    if (!profile || !func_sym) return;
+    CTEProfile::Counters& counters = profile_pending[func_sym];
+    if (hit) {
+        counters.memo_hits++;
+    } else {
+        counters.memo_misses++;
+    }
+}
+
+void CompileTimeEvaluator::cache_resolved_symbol(const ExprPtr& expr, Symbol* sym) {
+    if (!resolved_symbol_log) {
+        expr->resolved_symbol = sym;
+    } else if (sym) {
+        resolved_symbol_log->emplace_back(expr.get(), sym);
+    }
+}
+
+void CompileTimeEvaluator::cache_resolved_symbol(const TypePtr& type, Symbol* sym) {
+    // Named types are shared across workers and have no log; concurrent
+    // queries simply skip the cache and re-resolve.
+    if (!resolved_symbol_log) {
+        type->resolved_symbol = sym;
+    }
+}
+
 void CompileTimeEvaluator::reset_state() {
     constants.clear();
-    symbol_constants.clear();
     uninitialized_locals.clear();
     ref_param_stack.clear();
     error_msg.clear();
     recursion_depth = 0;
     loop_depth = 0;
     return_depth = 0;
+    completion = Completion::Normal;
     constant_eval_stack.clear();
-    constant_value_cache.clear();
-    call_result_cache.clear();
+    if (constant_value_cache.size() + call_result_cache.size() > MAX_RETAINED_MEMO_ENTRIES) {
+        constant_value_cache.clear();
+        call_result_cache.clear();
+        memo_hasher.clear();
+    }
     active_call_memo_keys.clear();
+    read_frames.clear();
+    read_frame_seen.clear();
+    ++query_serial;
     expr_param_stack.clear();
     expanding_expr_params.clear();
     expr_param_expansion_depth = 0;
     hard_error = false;
     value_observer = nullptr;
     symbol_read_observer = nullptr;
+    steps = 0;
+    budget_exhausted = false;
+    const uint64_t configured_budget = type_checker ? type_checker->get_cte_step_budget() : 0;
+    step_budget = configured_budget > 0 ? configured_budget : DEFAULT_STEP_BUDGET;
+    memory_exhausted = false;
+    const uint64_t configured_limit = type_checker ? type_checker->get_cte_memory_limit() : 0;
+    memory_limit = configured_limit > 0 ? configured_limit : DEFAULT_MEMORY_LIMIT;
+    profile = type_checker ? type_checker->get_cte_profile() : nullptr;
+    loop_iterations = 0;
+    profile_frames.clear();
+    profile_open_frames.clear();
+    profile_pending.clear();
 }
 
 bool CompileTimeEvaluator::try_evaluate(ExprPtr expr, CTValue& result) {
@@ -86,6 +242,22 @@ bool CompileTimeEvaluator::try_evaluate(ExprPtr expr, CTValue& result) {
         return false;
     }
 
+    if (++steps > step_budget) {
+        if (!budget_exhausted) {
+            budget_exhausted = true;
+            if (!profile_frames.empty()) {
+                profile_pending[profile_frames.back().subject].budget_exhausted++;
+            }
+        }
+        error_msg = step_budget_message();
+        return false;
+    }
+
+    if (!within_memory_limit()) {
+        error_msg = memory_limit_message();
+        return false;
+    }
+
     struct DepthGuard {
         int& depth;
         explicit DepthGuard(int& d) : depth(d) { depth++; }
@@ -154,24 +326,6 @@ bool CompileTimeEvaluator::try_evaluate(ExprPtr expr, CTValue& result) {
             success = false;
             break;
         }
-    } catch (const EvalBreak&) {
-        if (loop_depth > 0) {
-            throw;
-        }
-        error_msg = "Break used outside of loop in compile-time evaluation";
-        success = false;
-    } catch (const EvalContinue&) {
-        if (loop_depth > 0) {
-            throw;
-        }
-        error_msg = "Continue used outside of loop in compile-time evaluation";
-        success = false;
-    } catch (const EvalReturn&) {
-        if (return_depth > 0) {
-            throw;
-        }
-        error_msg = "Return used outside of function in compile-time evaluation";
-        success = false;
     } catch (const CompileError& e) {
         error_msg = e.what();
         hard_error = true;
@@ -184,6 +338,103 @@ bool CompileTimeEvaluator::try_evaluate(ExprPtr expr, CTValue& result) {
     return success;
 }
 
+const CTValue* CompileTimeEvaluator::find_symbol_constant(const Symbol* sym) const {
+    if (!symbol_constants) return nullptr;
+    auto it = symbol_constants->find(sym);
+    return it == symbol_constants->end() ? nullptr : &it->second;
+}
+
+void CompileTimeEvaluator::note_symbol_read(const Symbol* sym) {
+    if (symbol_read_observer) {
+        symbol_read_observer(sym);
+    }
+    if (read_frames.empty()) return;
+    ReadFrame& frame = *read_frames.back();
+    uint64_t& seen = read_frame_seen[sym];
+    if (seen == frame.serial) return;
+    seen = frame.serial;
+    SymbolRead read;
+    read.sym = sym;
+    if (const CTValue* seeded = find_symbol_constant(sym)) {
+        read.seeded = true;
+        read.value = *seeded;
+    }
+    frame.reads.direct.push_back(std::move(read));
+}
+
+void CompileTimeEvaluator::add_nested_reads(const std::shared_ptr<const ReadSet>& reads) {
+    if (!reads || read_frames.empty()) return;
+    ReadFrame& frame = *read_frames.back();
+    uint64_t& seen = read_frame_seen[reads.get()];
+    if (seen == frame.serial) return;
+    seen = frame.serial;
+    frame.reads.nested.push_back(reads);
+}
+
+bool CompileTimeEvaluator::reuse_memo_entry(const MemoEntry& entry) {
+    if (!entry.reads) return true;
+    // Read sets form a DAG; each walk visits a set once and stops at sets
+    // already known to hold in this query.
+    const uint64_t walk = ++read_walk_serial;
+    std::vector<const ReadSet*> pending{entry.reads.get()};
+    std::vector<const ReadSet*> walked;
+    while (!pending.empty()) {
+        const ReadSet* reads = pending.back();
+        pending.pop_back();
+        if (reads->valid_query == query_serial || reads->walked == walk) continue;
+        reads->walked = walk;
+        for (const auto& read : reads->direct) {
+            const CTValue* seeded = find_symbol_constant(read.sym);
+            if ((seeded != nullptr) != read.seeded || (seeded && !memo_values_equal(*seeded, read.value))) {
+                return false;
+            }
+        }
+        walked.push_back(reads);
+        for (const auto& nested : reads->nested) pending.push_back(nested.get());
+    }
+    for (const ReadSet* reads : walked) reads->valid_query = query_serial;
+
+    if (symbol_read_observer) {
+        pending.assign(1, entry.reads.get());
+        while (!pending.empty()) {
+            const ReadSet* reads = pending.back();
+            pending.pop_back();
+            if (reads->replayed_query == query_serial) continue;
+            reads->replayed_query = query_serial;
+            for (const auto& read : reads->direct) symbol_read_observer(read.sym);
+            for (const auto& nested : reads->nested) pending.push_back(nested.get());
+        }
+    }
+    add_nested_reads(entry.reads);
+    return true;
+}
+
+CompileTimeEvaluator::ReadFrame::ReadFrame(CompileTimeEvaluator* evaluator)
+    : self(evaluator), serial(++evaluator->next_read_frame) {
+    self->read_frames.push_back(this);
+}
+
+CompileTimeEvaluator::ReadFrame::~ReadFrame() {
+    if (!self->read_frames.empty() && self->read_frames.back() == this) {
+        self->read_frames.pop_back();
+        // Reads of a failed evaluation still reached the enclosing one.
+        if (!self->read_frames.empty()) {
+            auto partial = std::make_shared<const ReadSet>(std::move(reads));
+            self->add_nested_reads(partial);
+        }
+    }
+}
+
+std::shared_ptr<const CompileTimeEvaluator::ReadSet> CompileTimeEvaluator::ReadFrame::finish() {
+    self->read_frames.pop_back();
+    auto done = std::make_shared<const ReadSet>(std::move(reads));
+    // Built under this query's seeded values, and its reads already reported.
+    done->valid_query = self->query_serial;
+    done->replayed_query = self->query_serial;
+    self->add_nested_reads(done);
+    return done;
+}
+
 bool CompileTimeEvaluator::evaluate_constant_symbol(Symbol* sym, CTValue& result) {
     if (!sym || sym->kind != Symbol::Kind::Constant || !sym->declaration || !sym->declaration->var_init) {
         return false;
@@ -191,8 +442,12 @@ bool CompileTimeEvaluator::evaluate_constant_symbol(Symbol* sym, CTValue& result
 
     auto cached = constant_value_cache.find(sym);
     if (cached != constant_value_cache.end()) {
-        result = copy_ct_value(cached->second);
-        return true;
+        // A value cached before the symbol had a type was never coerced.
+        if ((cached->second.typed || !sym->type) && reuse_memo_entry(cached->second)) {
+            result = copy_ct_value(cached->second.value);
+            return true;
+        }
+        constant_value_cache.erase(cached);
     }
 
     if (constant_eval_stack.count(sym) > 0) {
@@ -202,7 +457,12 @@ bool CompileTimeEvaluator::evaluate_constant_symbol(Symbol* sym, CTValue& result
     }
 
     constant_eval_stack.insert(sym);
-    const bool ok = try_evaluate(sym->declaration->var_init, result);
+    bool ok = false;
+    ReadFrame reads(this);
+    {
+        ProfileScope scope(this, sym);
+        ok = try_evaluate(sym->declaration->var_init, result);
+    }
     constant_eval_stack.erase(sym);
     if (!ok) {
         return false;
@@ -216,7 +476,10 @@ bool CompileTimeEvaluator::evaluate_constant_symbol(Symbol* sym, CTValue& result
         result = copy_ct_value(coerced);
     }
 
-    constant_value_cache[sym] = copy_ct_value(result);
+    MemoEntry& entry = constant_value_cache[sym];
+    entry.value = copy_ct_value(result);
+    entry.reads = reads.finish();
+    entry.typed = sym->type != nullptr;
     return true;
 }
 
@@ -242,11 +505,11 @@ bool CompileTimeEvaluator::declare_uninitialized_local(const StmtPtr& stmt) {
         Symbol* type_sym = type->resolved_symbol;
         if (!type_sym && type_checker) {
             type_sym = type_checker->binding_for(type.get());
-            type->resolved_symbol = type_sym;
+            cache_resolved_symbol(type, type_sym);
         }
         if (!type_sym && type_checker && type_checker->get_scope()) {
             type_sym = type_checker->get_scope()->lookup(type->type_name);
-            type->resolved_symbol = type_sym;
+            cache_resolved_symbol(type, type_sym);
         }
         if (type_sym &&
             type_sym->declaration &&
@@ -291,13 +554,17 @@ bool CompileTimeEvaluator::declare_uninitialized_local(const StmtPtr& stmt) {
                 }
 
                 auto array = std::make_shared<CTArray>();
-                array->elements.reserve(static_cast<size_t>(size));
+                array->reserve(static_cast<size_t>(size));
                 for (int64_t i = 0; i < size; ++i) {
+                    if (!within_memory_limit()) {
+                        error_msg = memory_limit_message();
+                        return false;
+                    }
                     CTValue elem = CTUninitialized{};
                     if (!materialize(type->element_type, elem)) {
                         return false;
                     }
-                    array->elements.push_back(std::move(elem));
+                    array->push_back(elem);
                 }
                 out = array;
                 return true;
@@ -314,6 +581,7 @@ bool CompileTimeEvaluator::declare_uninitialized_local(const StmtPtr& stmt) {
                     }
                     composite->fields[field.name] = std::move(field_storage);
                 }
+                ct_note_composite(*composite);
                 out = composite;
                 return true;
             }
@@ -335,156 +603,153 @@ bool CompileTimeEvaluator::declare_uninitialized_local(const StmtPtr& stmt) {
     return true;
 }
 
-bool CompileTimeEvaluator::eval_block(ExprPtr expr, CTValue& result) {
-    if (!expr || expr->kind != Expr::Kind::Block) {
-        return false;
+void CompileTimeEvaluator::shadow_binding(LocalFrame& frame, const std::string& name) {
+    if (name.empty()) return;
+    for (const auto& entry : frame) {
+        if (entry.name == name) return;
     }
+    ShadowedBinding entry;
+    entry.name = name;
+    auto it = constants.find(name);
+    if (it != constants.end()) {
+        entry.had_value = true;
+        entry.old_value = copy_ct_value(it->second);
+    }
+    entry.was_uninitialized = uninitialized_locals.count(name) > 0;
+    frame.push_back(std::move(entry));
+}
 
-    struct LocalShadow {
-        bool had_const = false;
-        CTValue old_const = static_cast<int64_t>(0);
-        bool had_uninitialized = false;
-    };
-
-    std::unordered_map<std::string, LocalShadow> shadows;
-    std::vector<std::string> local_names;
-
-    auto remember_local = [&](const std::string& name) {
-        if (name.empty() || shadows.count(name) > 0) {
-            return;
+void CompileTimeEvaluator::restore_frame(LocalFrame& frame) {
+    for (auto& entry : frame) {
+        if (entry.had_value) {
+            constants[entry.name] = std::move(entry.old_value);
+        } else {
+            constants.erase(entry.name);
         }
-
-        LocalShadow shadow;
-        auto const_it = constants.find(name);
-        if (const_it != constants.end()) {
-            shadow.had_const = true;
-            shadow.old_const = copy_ct_value(const_it->second);
+        if (entry.was_uninitialized) {
+            uninitialized_locals.insert(entry.name);
+        } else {
+            uninitialized_locals.erase(entry.name);
         }
-        shadow.had_uninitialized = uninitialized_locals.count(name) > 0;
-        shadows[name] = std::move(shadow);
-        local_names.push_back(name);
-    };
+    }
+    frame.clear();
+}
 
-    auto cleanup_locals = [&]() {
-        for (const auto& name : local_names) {
-            constants.erase(name);
-            uninitialized_locals.erase(name);
-            const LocalShadow& shadow = shadows[name];
-            if (shadow.had_const) {
-                constants[name] = copy_ct_value(shadow.old_const);
-            }
-            if (shadow.had_uninitialized) {
-                uninitialized_locals.insert(name);
+bool CompileTimeEvaluator::eval_block_stmt(const StmtPtr& stmt, LocalFrame& frame) {
+    if (!stmt) return true;
+
+    switch (stmt->kind) {
+        case Stmt::Kind::Expr: {
+            if (!stmt->expr) return true;
+            if (stmt->expr->kind == Expr::Kind::Assignment &&
+                stmt->expr->creates_new_variable &&
+                stmt->expr->left &&
+                stmt->expr->left->kind == Expr::Kind::Identifier) {
+                shadow_binding(frame, stmt->expr->left->name);
             }
-        }
-    };
-
-    std::function<bool(const StmtPtr&)> eval_stmt = [&](const StmtPtr& stmt) -> bool {
-        if (!stmt) return true;
-
-        switch (stmt->kind) {
-            case Stmt::Kind::Expr: {
-                if (!stmt->expr) return true;
-                if (stmt->expr->kind == Expr::Kind::Assignment &&
-                    stmt->expr->creates_new_variable &&
-                    stmt->expr->left &&
-                    stmt->expr->left->kind == Expr::Kind::Identifier) {
-                    remember_local(stmt->expr->left->name);
-                }
-                CTValue ignored;
-                if (!try_evaluate(stmt->expr, ignored)) {
-                    cleanup_locals();
+            CTValue ignored;
+            return try_evaluate(stmt->expr, ignored);
+        }
+        case Stmt::Kind::VarDecl: {
+            shadow_binding(frame, stmt->var_name);
+            if (stmt->var_init) {
+                CTValue init_val;
+                if (!try_evaluate(stmt->var_init, init_val)) {
                     return false;
                 }
-                return true;
-            }
-            case Stmt::Kind::VarDecl: {
-                remember_local(stmt->var_name);
-                if (stmt->var_init) {
-                    CTValue init_val;
-                    if (!try_evaluate(stmt->var_init, init_val)) {
-                        cleanup_locals();
-                        return false;
-                    }
-                    CTValue stored_val = copy_ct_value(init_val);
-                    if (stmt->var_type &&
-                        !coerce_value_to_type(stored_val, stmt->var_type, stored_val)) {
-                        cleanup_locals();
-                        return false;
-                    }
-                    constants[stmt->var_name] = copy_ct_value(stored_val);
-                    uninitialized_locals.erase(stmt->var_name);
-                } else if (!declare_uninitialized_local(stmt)) {
-                    cleanup_locals();
+                CTValue stored_val = copy_ct_value(init_val);
+                if (stmt->var_type &&
+                    !coerce_value_to_type(stored_val, stmt->var_type, stored_val)) {
                     return false;
                 }
+                constants[stmt->var_name] = copy_ct_value(stored_val);
+                uninitialized_locals.erase(stmt->var_name);
                 return true;
             }
-            case Stmt::Kind::ConditionalStmt: {
-                CTValue cond_val;
-                if (!try_evaluate(stmt->condition, cond_val)) {
-                    cleanup_locals();
-                    return false;
-                }
-                bool is_true = false;
-                if (!cte_scalar_to_bool(cond_val, is_true)) {
-                    error_msg = "Conditional expression condition must be a scalar value";
-                    cleanup_locals();
-                    return false;
-                }
-                if (is_true && !eval_stmt(stmt->true_stmt)) {
-                    return false;
-                }
-                return true;
+            return declare_uninitialized_local(stmt);
+        }
+        case Stmt::Kind::ConditionalStmt: {
+            CTValue cond_val;
+            if (!try_evaluate(stmt->condition, cond_val)) {
+                return false;
             }
-            case Stmt::Kind::Return: {
-                if (!stmt->return_expr) {
-                    error_msg = "Return statement requires an expression at compile time";
-                    cleanup_locals();
-                    return false;
-                }
-                CTValue ret_val;
-                if (!try_evaluate(stmt->return_expr, ret_val)) {
-                    cleanup_locals();
-                    return false;
-                }
-                throw EvalReturn{copy_ct_value(ret_val)};
+            bool is_true = false;
+            if (!cte_scalar_to_bool(cond_val, is_true)) {
+                error_msg = "Conditional expression condition must be a scalar value";
+                return false;
             }
-            case Stmt::Kind::Break:
-                if (loop_depth > 0) {
-                    throw EvalBreak{};
-                }
-                error_msg = "Break used outside of loop in compile-time evaluation";
-                cleanup_locals();
+            return !is_true || eval_block_stmt(stmt->true_stmt, frame);
+        }
+        case Stmt::Kind::Return: {
+            if (!stmt->return_expr) {
+                error_msg = "Return statement requires an expression at compile time";
                 return false;
-            case Stmt::Kind::Continue:
-                if (loop_depth > 0) {
-                    throw EvalContinue{};
-                }
-                error_msg = "Continue used outside of loop in compile-time evaluation";
-                cleanup_locals();
+            }
+            if (return_depth == 0) {
+                error_msg = "Return used outside of function in compile-time evaluation";
                 return false;
-            default:
-                return true;
+            }
+            CTValue ret_val;
+            if (!try_evaluate(stmt->return_expr, ret_val)) {
+                return false;
+            }
+            return_value = std::move(ret_val);
+            completion = Completion::Return;
+            return false;
         }
-    };
+        case Stmt::Kind::Break:
+            if (loop_depth > 0) {
+                completion = Completion::Break;
+            } else {
+                error_msg = "Break used outside of loop in compile-time evaluation";
+            }
+            return false;
+        case Stmt::Kind::Continue:
+            if (loop_depth > 0) {
+                completion = Completion::Continue;
+            } else {
+                error_msg = "Continue used outside of loop in compile-time evaluation";
+            }
+            return false;
+        default:
+            return true;
+    }
+}
 
+bool CompileTimeEvaluator::eval_block(ExprPtr expr, CTValue& result) {
+    if (!expr || expr->kind != Expr::Kind::Block) {
+        return false;
+    }
+
+    // Every exit, including break/continue/return completions, restores the
+    // names this block's locals shadowed.
+    LocalFrame frame;
     for (const auto& stmt : expr->statements) {
-        if (!eval_stmt(stmt)) {
+        if (!eval_block_stmt(stmt, frame)) {
+            restore_frame(frame);
             return false;
         }
     }
 
     if (expr->result_expr) {
         if (!try_evaluate(expr->result_expr, result)) {
-            cleanup_locals();
+            restore_frame(frame);
+            return false;
+        }
+        // Integer results wrap to the block's width, as a call result wraps
+        // to its return type; inlined calls rely on this.
+        const TypePtr& type = expr->type;
+        if (type && type->kind == Type::Kind::Primitive &&
+            (is_signed_int(type->primitive) || is_unsigned_int(type->primitive)) &&
+            !coerce_value_to_type(result, type, result)) {
+            restore_frame(frame);
             return false;
         }
     } else {
         result = CTNoValue{};
     }
 
-    cleanup_locals();
+    restore_frame(frame);
     return true;
 }
 
@@ -495,7 +760,7 @@ bool CompileTimeEvaluator::eval_literal(ExprPtr expr, CTValue& result) {
                 expr->type->kind == Type::Kind::Primitive &&
                 expr->type->primitive == PrimitiveType::Bool) {
                 if (expr->has_exact_int_val) {
-                    result = !expr->exact_int_val.is_zero();
+                    result = !expr->exact_int_val->is_zero();
                 } else {
                     result = (expr->uint_val != 0u);
                 }
@@ -510,13 +775,13 @@ bool CompileTimeEvaluator::eval_literal(ExprPtr expr, CTValue& result) {
             }
             return true;
         case Expr::Kind::FloatLiteral:
-            result = expr->float_val;
+            result = float_at_type_precision(expr->float_val, expr->type);
             return true;
         case Expr::Kind::CharLiteral:
             result = (int64_t)(uint8_t)expr->uint_val;
             return true;
         case Expr::Kind::StringLiteral:
-            result = expr->string_val;
+            result = CTString(expr->string_val.str());
             return true;
         default:
             error_msg = "Not a literal";
@@ -545,11 +810,11 @@ bool CompileTimeEvaluator::eval_unary(ExprPtr expr, CTValue& result) {
                                 : v.wrapped_unsigned(fixed_bits);
         };
         raw = wrap_raw(raw);
-        if (expr->op == "-") {
+        if (expr->unary_op == UnaryOp::Neg) {
             result = ctvalue_from_exact_int(wrap_raw(-raw), !fixed_signed);
             return true;
         }
-        if (expr->op == "~") {
+        if (expr->unary_op == UnaryOp::BitNot) {
             if (fixed_signed || fixed_frac != 0) {
                 error_msg =
                     "Fixed-point compile-time bitwise not requires an unsigned fixed-point operand with zero fractional bits";
@@ -558,13 +823,13 @@ bool CompileTimeEvaluator::eval_unary(ExprPtr expr, CTValue& result) {
             result = ctvalue_from_exact_int(wrap_raw(~raw), true);
             return true;
         }
-        if (expr->op == "!") {
+        if (expr->unary_op == UnaryOp::Not) {
             result = raw.is_zero();
             return true;
         }
     }
 
-    if (expr->op == "~") {
+    if (expr->unary_op == UnaryOp::BitNot) {
         APInt v(uint64_t(0));
         bool is_unsigned = false;
         if (!ctvalue_to_exact_int(operand_val, v, is_unsigned)) {
@@ -582,11 +847,11 @@ bool CompileTimeEvaluator::eval_unary(ExprPtr expr, CTValue& result) {
             error_msg = "Unsupported operand type for unary operation";
             return false;
         }
-        if (expr->op == "-") {
+        if (expr->unary_op == UnaryOp::Neg) {
             result = ctvalue_from_exact_int(-v, false);
             return true;
         }
-        if (expr->op == "!") {
+        if (expr->unary_op == UnaryOp::Not) {
             result = v.is_zero();
             return true;
         }
@@ -596,8 +861,8 @@ bool CompileTimeEvaluator::eval_unary(ExprPtr expr, CTValue& result) {
 
     if (std::holds_alternative<double>(operand_val)) {
         double v = std::get<double>(operand_val);
-        if (expr->op == "-") result = -v;
-        else if (expr->op == "!") result = !v;
+        if (expr->unary_op == UnaryOp::Neg) result = -v;
+        else if (expr->unary_op == UnaryOp::Not) result = !v;
         else {
             error_msg = "Unsupported unary operator: " + expr->op;
             return false;
@@ -607,7 +872,7 @@ bool CompileTimeEvaluator::eval_unary(ExprPtr expr, CTValue& result) {
 
     if (std::holds_alternative<bool>(operand_val)) {
         bool v = std::get<bool>(operand_val);
-        if (expr->op == "!") {
+        if (expr->unary_op == UnaryOp::Not) {
             result = !v;
             return true;
         }
@@ -640,7 +905,7 @@ bool CompileTimeEvaluator::eval_identifier(ExprPtr expr, CTValue& result) {
     Symbol* sym = expr->resolved_symbol;
     if (expr_param_expansion_depth == 0 && !sym && type_checker) {
         sym = type_checker->binding_for(expr.get());
-        expr->resolved_symbol = sym;
+        cache_resolved_symbol(expr, sym);
     }
 
     if (sym &&
@@ -668,22 +933,19 @@ bool CompileTimeEvaluator::eval_identifier(ExprPtr expr, CTValue& result) {
     // Try to look up global constant
     if (!sym && type_checker) {
         sym = type_checker->binding_for(expr.get());
-        expr->resolved_symbol = sym;
+        cache_resolved_symbol(expr, sym);
     }
     if (!sym && type_checker && type_checker->get_scope()) {
         sym = type_checker->get_scope()->lookup(expr->name);
     }
-    if (sym && symbol_read_observer) {
-        symbol_read_observer(sym);
-    }
     if (sym) {
-        auto known = symbol_constants.find(sym);
-        if (known != symbol_constants.end()) {
-            if (std::holds_alternative<CTUninitialized>(known->second)) {
+        note_symbol_read(sym);
+        if (const CTValue* known = find_symbol_constant(sym)) {
+            if (std::holds_alternative<CTUninitialized>(*known)) {
                 error_msg = "uninitialized variable accessed at compile time: " + expr->name;
                 return false;
             }
-            result = copy_ct_value(known->second);
+            result = copy_ct_value(*known);
             return true;
         }
     }
@@ -715,6 +977,13 @@ int64_t CompileTimeEvaluator::to_int(const CTValue& v) {
                        SourceLocation());
 }
 
+double CompileTimeEvaluator::float_at_type_precision(double value, TypePtr type) const {
+    if (type && type->kind == Type::Kind::Primitive && type->primitive == PrimitiveType::F32) {
+        return static_cast<double>(static_cast<float>(value));
+    }
+    return value;
+}
+
 double CompileTimeEvaluator::to_float(const CTValue& v) {
     if (std::holds_alternative<double>(v)) return std::get<double>(v);
     if (std::holds_alternative<int64_t>(v)) return (double)std::get<int64_t>(v);
@@ -739,7 +1008,7 @@ bool CompileTimeEvaluator::eval_type_constructor(ExprPtr expr, CTValue& result)
     Symbol* sym = expr->operand->resolved_symbol;
     if (!sym && type_checker) {
         sym = type_checker->binding_for(expr->operand.get());
-        expr->operand->resolved_symbol = sym;
+        cache_resolved_symbol(expr->operand, sym);
     }
     if (!sym && type_checker && type_checker->get_scope()) {
         sym = type_checker->get_scope()->lookup(type_name);
@@ -781,6 +1050,7 @@ bool CompileTimeEvaluator::eval_type_constructor(ExprPtr expr, CTValue& result)
         composite->fields[field_name] = copy_ct_value(arg_val);
     }
 
+    ct_note_composite(*composite);
     result = composite;
     return true;
 }
@@ -870,6 +1140,9 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
                     error_msg = "Type mismatch in compile-time coercion to unresolved signed integer";
                     return false;
                 }
+                if (wrap_word_integer(input, target_type->integer_bits, false, output)) {
+                    return true;
+                }
                 APInt exact(uint64_t(0));
                 bool source_unsigned = false;
                 if (!ctvalue_to_exact_int(input, exact, source_unsigned)) {
@@ -895,6 +1168,9 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
                     error_msg = "Type mismatch in compile-time coercion to unresolved unsigned integer";
                     return false;
                 }
+                if (wrap_word_integer(input, target_type->integer_bits, true, output)) {
+                    return true;
+                }
                 APInt exact(uint64_t(0));
                 bool source_unsigned = false;
                 if (!ctvalue_to_exact_int(input, exact, source_unsigned)) {
@@ -938,7 +1214,7 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
             case PrimitiveType::F16:
             case PrimitiveType::F32:
             case PrimitiveType::F64:
-                output = to_float(input);
+                output = float_at_type_precision(to_float(input), target_type);
                 return true;
             case PrimitiveType::Bool:
                 {
@@ -951,11 +1227,11 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
                     return true;
                 }
             case PrimitiveType::String:
-                if (!std::holds_alternative<std::string>(input)) {
+                if (!std::holds_alternative<CTString>(input)) {
                     error_msg = "Type mismatch in compile-time coercion to string";
                     return false;
                 }
-                output = std::get<std::string>(input);
+                output = std::get<CTString>(input).str();
                 return true;
         }
     }
@@ -982,14 +1258,15 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
                 return false;
             }
             if (expected_size < 0 ||
-                static_cast<size_t>(expected_size) != in_array->elements.size()) {
+                static_cast<size_t>(expected_size) != in_array->size()) {
                 error_msg = "Array size mismatch in compile-time coercion";
                 return false;
             }
         }
         auto out_array = std::make_shared<CTArray>();
-        out_array->elements.reserve(in_array->elements.size());
-        for (const auto& elem : in_array->elements) {
+        out_array->reserve(in_array->size());
+        for (size_t i = 0; i < in_array->size(); ++i) {
+            const CTValue elem = in_array->at(i);
             CTValue coerced_elem;
             if (target_type->element_type) {
                 if (!coerce_value_to_type(elem, target_type->element_type, coerced_elem)) {
@@ -998,7 +1275,7 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
             } else {
                 coerced_elem = copy_ct_value(elem);
             }
-            out_array->elements.push_back(copy_ct_value(coerced_elem));
+            out_array->push_back(coerced_elem);
         }
         output = out_array;
         return true;
@@ -1036,6 +1313,7 @@ bool CompileTimeEvaluator::coerce_value_to_type(const CTValue& input,
                 }
                 out_comp->fields[field.name] = copy_ct_value(coerced_field);
             }
+            ct_note_composite(*out_comp);
             output = out_comp;
             return true;
         }
@@ -1068,7 +1346,7 @@ bool CompileTimeEvaluator::coerce_value_to_lvalue_type(ExprPtr lvalue,
         Symbol* sym = lvalue->resolved_symbol;
         if (!sym && type_checker) {
             sym = type_checker->binding_for(lvalue.get());
-            lvalue->resolved_symbol = sym;
+            cache_resolved_symbol(lvalue, sym);
         }
         if (!sym && type_checker && type_checker->get_scope()) {
             sym = type_checker->get_scope()->lookup(lvalue->name);
@@ -1088,13 +1366,13 @@ bool CompileTimeEvaluator::coerce_value_to_lvalue_type(ExprPtr lvalue,
 bool CompileTimeEvaluator::eval_array_literal(ExprPtr expr, CTValue& result) {
     if (!expr) return false;
     auto array = std::make_shared<CTArray>();
-    array->elements.reserve(expr->elements.size());
+    array->reserve(expr->elements.size());
     for (const auto& elem : expr->elements) {
         CTValue elem_val;
         if (!try_evaluate(elem, elem_val)) {
             return false;
         }
-        array->elements.push_back(copy_ct_value(elem_val));
+        array->push_back(elem_val);
     }
     result = array;
     return true;
@@ -1114,6 +1392,7 @@ bool CompileTimeEvaluator::eval_tuple_literal(ExprPtr expr, CTValue& result) {
         std::string field_name = std::string(MANGLED_PREFIX) + std::to_string(i);
         tuple->fields[field_name] = copy_ct_value(elem_val);
     }
+    ct_note_composite(*tuple);
     result = tuple;
     return true;
 }
@@ -1146,20 +1425,11 @@ bool CompileTimeEvaluator::eval_range(ExprPtr expr, CTValue& result) {
         return false;
     }
 
-    auto array = std::make_shared<CTArray>();
-    if (start < end) {
-        array->elements.reserve(static_cast<size_t>(end - start));
-        for (int64_t v = start; v < end; ++v) {
-            array->elements.push_back((int64_t)v);
-        }
-    } else {
-        array->elements.reserve(static_cast<size_t>(start - end));
-        for (int64_t v = start; v > end; --v) {
-            array->elements.push_back((int64_t)v);
-        }
-    }
-
-    result = array;
+    // Kept lazy: iteration, indexing and length read it without building
+    // the elements.
+    const uint64_t count = start < end ? static_cast<uint64_t>(end) - static_cast<uint64_t>(start)
+                                       : static_cast<uint64_t>(start) - static_cast<uint64_t>(end);
+    result = std::make_shared<CTArray>(CTArray::range(start, start < end ? 1 : -1, static_cast<size_t>(count)));
     return true;
 }
 
@@ -1196,20 +1466,20 @@ bool CompileTimeEvaluator::eval_index(ExprPtr expr, CTValue& result) {
             error_msg = "Indexing null array";
             return false;
         }
-        if (static_cast<size_t>(idx) >= array->elements.size()) {
+        if (static_cast<size_t>(idx) >= array->size()) {
             error_msg = "Index out of bounds in compile-time evaluation";
             return false;
         }
-        if (std::holds_alternative<CTUninitialized>(array->elements[static_cast<size_t>(idx)])) {
+        if (array->is_uninitialized(static_cast<size_t>(idx))) {
             error_msg = "uninitialized array element accessed at compile time";
             return false;
         }
-        result = array->elements[static_cast<size_t>(idx)];
+        result = array->at(static_cast<size_t>(idx));
         return true;
     }
 
-    if (std::holds_alternative<std::string>(container_val)) {
-        const auto& str = std::get<std::string>(container_val);
+    if (std::holds_alternative<CTString>(container_val)) {
+        const auto& str = std::get<CTString>(container_val).str();
         if (static_cast<size_t>(idx) >= str.size()) {
             error_msg = "Index out of bounds in compile-time evaluation";
             return false;
@@ -1241,10 +1511,15 @@ bool CompileTimeEvaluator::eval_iteration(ExprPtr expr, CTValue& result) {
         return false;
     }
 
-    const std::vector<CTValue>* elements = &array->elements;
+    // Plain iteration reads packed storage directly; sorting needs a value copy.
     std::vector<CTValue> sorted_elements;
-    if (expr->is_sorted_iteration && elements->size() > 1) {
-        sorted_elements = *elements;
+    const std::vector<CTValue>* elements = nullptr;
+    const bool already_sorted = array->storage() == CTArray::Storage::Range && array->range_step() > 0;
+    if (expr->is_sorted_iteration && array->size() > 1 && !already_sorted) {
+        sorted_elements.reserve(array->size());
+        for (size_t i = 0; i < array->size(); ++i) {
+            sorted_elements.push_back(array->at(i));
+        }
         elements = &sorted_elements;
         auto same_kind = [&](const CTValue& a, const CTValue& b) -> bool {
             return a.index() == b.index();
@@ -1283,10 +1558,10 @@ bool CompileTimeEvaluator::eval_iteration(ExprPtr expr, CTValue& result) {
                       [](const CTValue& a, const CTValue& b) {
                           return std::get<bool>(a) < std::get<bool>(b);
                       });
-        } else if (std::holds_alternative<std::string>((*elements)[0])) {
+        } else if (std::holds_alternative<CTString>((*elements)[0])) {
             std::sort(sorted_elements.begin(), sorted_elements.end(),
                       [](const CTValue& a, const CTValue& b) {
-                          return std::get<std::string>(a) < std::get<std::string>(b);
+                          return std::get<CTString>(a).str() < std::get<CTString>(b).str();
                       });
         } else {
             error_msg = "Sorted iteration not supported for composite values at compile time";
@@ -1307,21 +1582,23 @@ bool CompileTimeEvaluator::eval_iteration(ExprPtr expr, CTValue& result) {
         ~LoopGuard() { depth--; }
     } loop_guard(loop_depth);
 
-    for (const auto& elem : *elements) {
-        constants["_"] = copy_ct_value(elem);
+    const size_t count = elements ? elements->size() : array->size();
+    for (size_t i = 0; i < count; ++i) {
+        constants["_"] = elements ? (*elements)[i] : array->at(i);
         uninitialized_locals.erase("_");
+        loop_iterations++;
 
         CTValue body_val;
-        try {
-            if (!try_evaluate(expr->right, body_val)) {
-                return false;
+        if (!try_evaluate(expr->right, body_val)) {
+            if (completion == Completion::Continue) {
+                completion = Completion::Normal;
+                continue;
             }
-        } catch (const EvalContinue&) {
-            continue;
-        } catch (const EvalBreak&) {
-            break;
-        } catch (const EvalReturn&) {
-            throw;
+            if (completion == Completion::Break) {
+                completion = Completion::Normal;
+                break;
+            }
+            return false;
         }
     }
 
@@ -1349,7 +1626,6 @@ bool CompileTimeEvaluator::eval_repeat(ExprPtr expr, CTValue& result) {
         ~LoopGuard() { depth--; }
     } loop_guard(loop_depth);
 
-    int iterations = 0;
     while (true) {
         CTValue cond_val;
         if (!try_evaluate(expr->condition, cond_val)) {
@@ -1364,22 +1640,19 @@ bool CompileTimeEvaluator::eval_repeat(ExprPtr expr, CTValue& result) {
             break;
         }
 
-        if (iterations++ >= MAX_LOOP_ITERATIONS) {
-            error_msg = "Repeat loop exceeded compile-time iteration limit";
-            return false;
-        }
+        loop_iterations++;
 
         CTValue body_val;
-        try {
-            if (!try_evaluate(expr->right, body_val)) {
-                return false;
+        if (!try_evaluate(expr->right, body_val)) {
+            if (completion == Completion::Continue) {
+                completion = Completion::Normal;
+                continue;
             }
-        } catch (const EvalContinue&) {
-            continue;
-        } catch (const EvalBreak&) {
-            break;
-        } catch (const EvalReturn&) {
-            throw;
+            if (completion == Completion::Break) {
+                completion = Completion::Normal;
+                break;
+            }
+            return false;
         }
     }
 
@@ -1391,6 +1664,7 @@ bool CompileTimeEvaluator::eval_length(ExprPtr expr, CTValue& result) {
     if (!expr || !expr->operand) return false;
     CTValue val;
     bool evaluated = try_evaluate(expr->operand, val);
+    if (!evaluated && completion != Completion::Normal) return false;
     if (evaluated) {
         if (std::holds_alternative<std::shared_ptr<CTArray>>(val)) {
             auto array = std::get<std::shared_ptr<CTArray>>(val);
@@ -1398,12 +1672,12 @@ bool CompileTimeEvaluator::eval_length(ExprPtr expr, CTValue& result) {
                 error_msg = "Length on null array";
                 return false;
             }
-            uint64_t len = static_cast<uint64_t>(array->elements.size());
+            uint64_t len = static_cast<uint64_t>(array->size());
             result = ctvalue_from_exact_int(APInt(len), true);
             return true;
         }
-        if (std::holds_alternative<std::string>(val)) {
-            uint64_t len = static_cast<uint64_t>(std::get<std::string>(val).size());
+        if (std::holds_alternative<CTString>(val)) {
+            uint64_t len = static_cast<uint64_t>(std::get<CTString>(val).str().size());
             result = ctvalue_from_exact_int(APInt(len), true);
             return true;
         }
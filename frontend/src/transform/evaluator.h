@@ -1,6 +1,9 @@
 #pragma once
 #include "ast.h"
+#include "cte_profile.h"
 #include "cte_value.h"
+#include "evaluator_memo.h"
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <unordered_map>
@@ -25,6 +28,15 @@ public:
     // Query compile-time knowledge without collapsing Unknown and Error into one state.
     CTEQueryResult query(ExprPtr expr);
 
+    // Root entry for one query: try_evaluate plus profiler accounting.
+    bool evaluate(ExprPtr expr, CTValue& result);
+
+    // Steps each query may take when the checker does not set a budget.
+    static constexpr uint64_t DEFAULT_STEP_BUDGET = 10000000;
+    // Live value bytes each query may hold when the checker does not set a
+    // limit.
+    static constexpr uint64_t DEFAULT_MEMORY_LIMIT = uint64_t(1) << 30;
+
     // Get the last error message
     std::string get_error() const { return error_msg; }
 
@@ -33,10 +45,11 @@ public:
         constants[name] = value;
     }
 
-    // Seed a compile-time constant value for a specific bound symbol.
-    void set_symbol_constant(const Symbol* sym, const CTValue& value) {
-        if (!sym) return;
-        symbol_constants[sym] = value;
+    // Known values of bound symbols for the next query. The caller owns the
+    // map and keeps it alive and unchanged while a query runs; it may change
+    // between queries.
+    void set_symbol_constants(const std::unordered_map<const Symbol*, CTValue>* values) {
+        symbol_constants = values;
     }
 
     void set_value_observer(ExprValueObserver observer) {
@@ -47,21 +60,45 @@ public:
         symbol_read_observer = std::move(observer);
     }
 
-    // Reset all transient evaluation state so one evaluator instance can be safely reused.
+    // Reset per-query state so one evaluator instance can run the next query.
+    // Memoized call results and constant values are kept: each remembers the
+    // seeded symbols it read and is only reused while they hold the same values.
     void reset_state();
 
+    // Concurrent evaluators must not write shared AST nodes. With a log set,
+    // identifier symbols found via bindings are appended to it instead of
+    // being cached on the node; the owner applies the log once workers stop.
+    using ResolvedSymbolLog = std::vector<std::pair<Expr*, Symbol*>>;
+    void set_resolved_symbol_log(ResolvedSymbolLog* log) { resolved_symbol_log = log; }
+
 private:
     TypeChecker* type_checker;
     std::unordered_map<std::string, CTValue> constants;
-    std::unordered_map<const Symbol*, CTValue> symbol_constants;
+    const std::unordered_map<const Symbol*, CTValue>* symbol_constants = nullptr;
     std::unordered_set<std::string> uninitialized_locals;
     std::vector<std::unordered_set<std::string>> ref_param_stack;
     std::string error_msg;
     int recursion_depth = 0;
     int loop_depth = 0;
     int return_depth = 0;
+    // Break, continue and return unwind as a failed evaluation with a pending
+    // completion; the nearest enclosing loop or call consumes it.
+    enum class Completion { Normal, Break, Continue, Return };
+    Completion completion = Completion::Normal;
+    CTValue return_value;
+    // Host-stack guard; the step budget bounds total work.
     static const int MAX_RECURSION_DEPTH = 1000;
-    static const int MAX_LOOP_ITERATIONS = 1000000;
+    // One step per try_evaluate, counted per query since reset_state().
+    uint64_t steps = 0;
+    uint64_t step_budget = DEFAULT_STEP_BUDGET;
+    bool budget_exhausted = false;
+    // Live value bytes (ct_live_bytes()) the query has added since it
+    // started, checked once per step and in loops that build storage
+    // without taking steps.
+    uint64_t memory_limit = DEFAULT_MEMORY_LIMIT;
+    int64_t memory_base = 0;
+    bool memory_exhausted = false;
+    bool within_memory_limit();
 
     bool eval_literal(ExprPtr expr, CTValue& result);
     bool eval_binary(ExprPtr expr, CTValue& result);
@@ -81,29 +118,136 @@ private:
     bool eval_repeat(ExprPtr expr, CTValue& result);
     bool eval_length(ExprPtr expr, CTValue& result);
     bool eval_block(ExprPtr expr, CTValue& result);
+
+    // Prior state of a name bound by a block local or call parameter, put back
+    // when the frame that bound it exits.
+    struct ShadowedBinding {
+        std::string name;
+        bool had_value = false;
+        CTValue old_value;
+        bool was_uninitialized = false;
+    };
+    using LocalFrame = std::vector<ShadowedBinding>;
+    // Records `name` once per frame, before its first binding in the frame.
+    void shadow_binding(LocalFrame& frame, const std::string& name);
+    void restore_frame(LocalFrame& frame);
+    bool eval_block_stmt(const StmtPtr& stmt, LocalFrame& frame);
     bool declare_uninitialized_local(const StmtPtr& stmt);
     bool coerce_value_to_type(const CTValue& input, TypePtr target_type, CTValue& output);
     bool coerce_value_to_lvalue_type(ExprPtr lvalue, const CTValue& input, CTValue& output);
     bool evaluate_constant_symbol(Symbol* sym, CTValue& result);
+    // Content key for the persistent call cache; false when the callee's
+    // transitive declarations read state that is not part of the source.
+    bool persistent_call_key(const Symbol* func_sym,
+                             const ExprPtr& call,
+                             const std::vector<CTValue>& receivers,
+                             const std::vector<CTValue>& args,
+                             std::string& out_key);
 
     int64_t to_int(const CTValue& v);
     double to_float(const CTValue& v);
+    // `value` at the precision of the float type `type`: f32 results are
+    // rounded to the nearest float, as the target computes them.
+    double float_at_type_precision(double value, TypePtr type) const;
 
     void push_ref_params(StmtPtr func);
     void pop_ref_params();
     bool is_ref_param(const std::string& name) const;
     std::string base_identifier(ExprPtr expr) const;
 
+    // A symbol read during a memoized evaluation, with the value it was
+    // seeded with (if any) at the time.
+    struct SymbolRead {
+        const Symbol* sym = nullptr;
+        bool seeded = false;
+        CTValue value;
+    };
+    // Reads of one memoized evaluation: its own, plus the read sets of the
+    // memo entries it reused or created, shared rather than copied so a chain
+    // of constants stays linear in size.
+    struct ReadSet {
+        std::vector<SymbolRead> direct;
+        std::vector<std::shared_ptr<const ReadSet>> nested;
+        // Walk bookkeeping. A read set is only reachable from the evaluator
+        // that built it, so these never race.
+        mutable uint64_t walked = 0;          // reuse_memo_entry walk serial
+        mutable uint64_t valid_query = 0;     // all reads hold in this query
+        mutable uint64_t replayed_query = 0;  // reported in this query
+    };
+    struct MemoEntry {
+        CTValue value;
+        std::shared_ptr<const ReadSet> reads;
+        bool typed = true;  // constants: coerced to the symbol's type
+    };
+    // Collects the reads of a memoized evaluation in progress.
+    struct ReadFrame {
+        CompileTimeEvaluator* self;
+        uint64_t serial;
+        ReadSet reads;
+        explicit ReadFrame(CompileTimeEvaluator* evaluator);
+        ~ReadFrame();
+        // Ends collection; the frame's reads become a nested set of its parent.
+        std::shared_ptr<const ReadSet> finish();
+    };
+    // Retained memo entries beyond which reset_state() starts over.
+    static const size_t MAX_RETAINED_MEMO_ENTRIES = 1 << 16;
+
+    const CTValue* find_symbol_constant(const Symbol* sym) const;
+    // Reports a read to the observer and to the innermost frame.
+    void note_symbol_read(const Symbol* sym);
+    void add_nested_reads(const std::shared_ptr<const ReadSet>& reads);
+    // True when every seeded read behind `entry` still holds; then reports
+    // its reads as if the evaluation had run again.
+    bool reuse_memo_entry(const MemoEntry& entry);
+
+    std::vector<ReadFrame*> read_frames;
+    uint64_t next_read_frame = 0;
+    // Last frame serial each symbol or nested set was added to.
+    std::unordered_map<const void*, uint64_t> read_frame_seen;
+    uint64_t query_serial = 0;
+    uint64_t read_walk_serial = 0;
+
     std::unordered_set<const Symbol*> constant_eval_stack;
-    std::unordered_map<const Symbol*, CTValue> constant_value_cache;
-    std::unordered_map<std::string, CTValue> call_result_cache;
-    std::unordered_set<std::string> active_call_memo_keys;
+    std::unordered_map<const Symbol*, MemoEntry> constant_value_cache;
+    std::unordered_map<CTMemoKey, MemoEntry, CTMemoKeyHash> call_result_cache;
+    std::unordered_set<CTMemoKey, CTMemoKeyHash> active_call_memo_keys;
+    CTMemoHasher memo_hasher;
     std::vector<std::unordered_map<std::string, ExprPtr>> expr_param_stack;
     std::unordered_set<std::string> expanding_expr_params;
     int expr_param_expansion_depth = 0;
     bool hard_error = false;
     ExprValueObserver value_observer;
     SymbolReadObserver symbol_read_observer;
+    ResolvedSymbolLog* resolved_symbol_log = nullptr;
+
+    void cache_resolved_symbol(const ExprPtr& expr, Symbol* sym);
+    void cache_resolved_symbol(const TypePtr& type, Symbol* sym);
+    std::string step_budget_message() const;
+    std::string memory_limit_message() const;
+    bool evaluate_profiled(ExprPtr expr, CTValue& result);
+
+    // Profiling is active when the checker carries a CTEProfile. Frames nest
+    // like the evaluation; counters gather in profile_pending until the root
+    // query finishes and merges them.
+    struct ProfileFrame {
+        const Symbol* subject;
+        std::chrono::steady_clock::time_point start;
+        uint64_t steps;
+        uint64_t loop_iterations;
+        uint64_t allocated_bytes;
+    };
+    struct ProfileScope {
+        CompileTimeEvaluator* self = nullptr;
+        ProfileScope(CompileTimeEvaluator* evaluator, const Symbol* subject);
+        ~ProfileScope();
+    };
+    void record_memo_lookup(const Symbol* func_sym, bool hit);
+
+    CTEProfile* profile = nullptr;
+    uint64_t loop_iterations = 0;
+    std::vector<ProfileFrame> profile_frames;
+    std::unordered_map<const Symbol*, int> profile_open_frames;
+    CTEProfile::PendingCounters profile_pending;
 };
 
 } // namespace vexel
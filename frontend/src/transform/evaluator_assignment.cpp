@@ -92,7 +92,7 @@ bool fixed_raw_mod(const APInt& lhs,
 } // namespace
 
 bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
-    const std::string assign_op = expr->op.empty() ? "=" : expr->op;
+    const AssignOp assign_op = expr->op.empty() ? AssignOp::Assign : expr->assign_op;
 
     auto is_local = [&](const std::string& name) {
         return constants.count(name) > 0 || uninitialized_locals.count(name) > 0;
@@ -137,24 +137,6 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
         }
     }
 
-    auto clone_composite = [&](const std::shared_ptr<CTComposite>& src) {
-        if (!src) return std::shared_ptr<CTComposite>();
-        auto dst = std::make_shared<CTComposite>();
-        dst->type_name = src->type_name;
-        for (const auto& entry : src->fields) {
-            dst->fields[entry.first] = clone_ct_value(entry.second);
-        }
-        return dst;
-    };
-    auto clone_array = [&](const std::shared_ptr<CTArray>& src) {
-        if (!src) return std::shared_ptr<CTArray>();
-        auto dst = std::make_shared<CTArray>();
-        dst->elements.reserve(src->elements.size());
-        for (const auto& entry : src->elements) {
-            dst->elements.push_back(clone_ct_value(entry));
-        }
-        return dst;
-    };
     auto parse_index = [&](ExprPtr index_expr, int64_t& idx) -> bool {
         CTValue index_val;
         if (!try_evaluate(index_expr, index_val)) return false;
@@ -176,78 +158,116 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
         return true;
     };
 
-    std::function<bool(ExprPtr, CTValue*&)> resolve_lvalue_slot;
-    resolve_lvalue_slot = [&](ExprPtr target, CTValue*& out) -> bool {
+    // Index operands are evaluated before any storage is touched: evaluating them
+    // (or the right-hand side) may share aggregates that the write then detaches.
+    struct LValueStep {
+        ExprPtr target;
+        size_t index = 0;
+    };
+    std::string root_name;
+    std::vector<LValueStep> lvalue_path;
+    std::function<bool(ExprPtr)> collect_lvalue_path;
+    collect_lvalue_path = [&](ExprPtr target) -> bool {
         if (!target) {
             error_msg = "Assignment target is not addressable at compile time";
             return false;
         }
         switch (target->kind) {
-            case Expr::Kind::Identifier: {
-                auto it = constants.find(target->name);
-                if (it == constants.end()) {
-                    // Assignment writes can materialize an lvalue slot without reading prior value.
-                    constants[target->name] = CTUninitialized{};
-                    it = constants.find(target->name);
-                }
-                out = &it->second;
+            case Expr::Kind::Identifier:
+                root_name = target->name;
                 return true;
-            }
-            case Expr::Kind::Member: {
-                CTValue* base_slot = nullptr;
-                if (!resolve_lvalue_slot(target->operand, base_slot)) return false;
-                if (!base_slot || !std::holds_alternative<std::shared_ptr<CTComposite>>(*base_slot)) {
-                    error_msg = "Member access on non-composite value";
-                    return false;
-                }
-                auto& comp_ref = std::get<std::shared_ptr<CTComposite>>(*base_slot);
-                if (!comp_ref) {
-                    error_msg = "Member access on null composite value";
-                    return false;
-                }
-                if (!comp_ref.unique()) {
-                    comp_ref = clone_composite(comp_ref);
-                }
-                auto it = comp_ref->fields.find(target->name);
-                if (it == comp_ref->fields.end()) {
-                    error_msg = "Field not found: " + target->name;
-                    return false;
-                }
-                out = &it->second;
+            case Expr::Kind::Member:
+                if (!collect_lvalue_path(target->operand)) return false;
+                lvalue_path.push_back(LValueStep{target, 0});
                 return true;
-            }
             case Expr::Kind::Index: {
                 if (target->args.empty()) {
                     error_msg = "Index expression missing index";
                     return false;
                 }
-                CTValue* base_slot = nullptr;
-                if (!resolve_lvalue_slot(target->operand, base_slot)) return false;
-                if (!base_slot || !std::holds_alternative<std::shared_ptr<CTArray>>(*base_slot)) {
-                    error_msg = "Indexing non-array value at compile time";
+                if (!collect_lvalue_path(target->operand)) return false;
+                int64_t idx = 0;
+                if (!parse_index(target->args[0], idx)) return false;
+                lvalue_path.push_back(LValueStep{target, static_cast<size_t>(idx)});
+                return true;
+            }
+            default:
+                error_msg = "Assignment target is not addressable at compile time";
+                return false;
+        }
+    };
+
+    // Walks the collected path to the target slot. With `for_write`, shared
+    // aggregates along the path are detached so the slot is exclusively owned.
+    // A final index step is written back through CTArray::set so packed
+    // storage stays packed; `element_value` holds that element's current value.
+    CTValue missing_root = CTUninitialized{};
+    CTValue element_value;
+    CTArray* target_array = nullptr;
+    size_t target_index = 0;
+    auto walk_lvalue_path = [&](bool for_write, CTValue*& out) -> bool {
+        target_array = nullptr;
+        auto it = constants.find(root_name);
+        if (it == constants.end()) {
+            if (for_write) {
+                // Assignment writes can materialize an lvalue slot without reading prior value.
+                it = constants.emplace(root_name, CTUninitialized{}).first;
+                out = &it->second;
+            } else {
+                out = &missing_root;
+            }
+        } else {
+            out = &it->second;
+        }
+        for (size_t step_index = 0; step_index < lvalue_path.size(); ++step_index) {
+            const LValueStep& step = lvalue_path[step_index];
+            if (step.target->kind == Expr::Kind::Member) {
+                if (!std::holds_alternative<std::shared_ptr<CTComposite>>(*out)) {
+                    error_msg = "Member access on non-composite value";
                     return false;
                 }
-                auto& array_ref = std::get<std::shared_ptr<CTArray>>(*base_slot);
-                if (!array_ref) {
-                    error_msg = "Indexing null array";
+                auto& comp_ref = std::get<std::shared_ptr<CTComposite>>(*out);
+                if (!comp_ref) {
+                    error_msg = "Member access on null composite value";
                     return false;
                 }
-                if (!array_ref.unique()) {
-                    array_ref = clone_array(array_ref);
-                }
-                int64_t idx = 0;
-                if (!parse_index(target->args[0], idx)) return false;
-                if (static_cast<size_t>(idx) >= array_ref->elements.size()) {
-                    error_msg = "Index out of bounds in compile-time evaluation";
+                CTComposite& comp = for_write ? ct_mutable_composite(comp_ref) : *comp_ref;
+                auto field = comp.fields.find(step.target->name);
+                if (field == comp.fields.end()) {
+                    error_msg = "Field not found: " + step.target->name;
                     return false;
                 }
-                out = &array_ref->elements[static_cast<size_t>(idx)];
-                return true;
+                out = &field->second;
+                continue;
             }
-            default:
-                error_msg = "Assignment target is not addressable at compile time";
+            if (!std::holds_alternative<std::shared_ptr<CTArray>>(*out)) {
+                error_msg = "Indexing non-array value at compile time";
                 return false;
+            }
+            auto& array_ref = std::get<std::shared_ptr<CTArray>>(*out);
+            if (!array_ref) {
+                error_msg = "Indexing null array";
+                return false;
+            }
+            if (step.index >= array_ref->size()) {
+                error_msg = "Index out of bounds in compile-time evaluation";
+                return false;
+            }
+            CTArray& array = for_write ? ct_mutable_array(array_ref) : *array_ref;
+            if (step_index + 1 == lvalue_path.size()) {
+                target_array = &array;
+                target_index = step.index;
+                element_value = array.at(step.index);
+                out = &element_value;
+            } else if (array.storage() == CTArray::Storage::Generic) {
+                out = &array.generic_slot(step.index);
+            } else {
+                // Packed elements are scalars; the next step reports the mismatch.
+                element_value = array.at(step.index);
+                out = &element_value;
+            }
         }
+        return true;
     };
 
     if (creates_local_identifier &&
@@ -256,29 +276,30 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
         constants[expr->left->name] = CTUninitialized{};
     }
 
-    CTValue* slot = nullptr;
-    if (!resolve_lvalue_slot(expr->left, slot)) {
+    if (!collect_lvalue_path(expr->left)) {
         return false;
     }
-    if (!slot) {
-        error_msg = "Assignment target is not addressable at compile time";
+    CTValue* read_slot = nullptr;
+    if (!walk_lvalue_path(false, read_slot)) {
         return false;
     }
+    // The right-hand side may rebind the target, so compound reads use a snapshot.
+    const CTValue current = *read_slot;
 
     auto evaluate_rhs = [&](CTValue& out) -> bool {
         return try_evaluate(expr->right, out);
     };
     auto apply_compound = [&](const CTValue& lhs_in, const CTValue& rhs_in, CTValue& out) -> bool {
-        const std::string binary_op = assign_op.substr(0, assign_op.size() - 1);
+        const BinaryOp binary_op = compound_binary_op(assign_op);
         TypePtr fixed_type = expr && expr->left ? expr->left->type : nullptr;
         if (!is_fixed_primitive_type(fixed_type) && expr && expr->type && is_fixed_primitive_type(expr->type)) {
             fixed_type = expr->type;
         }
         if (is_fixed_primitive_type(fixed_type) &&
-            (binary_op == "&" || binary_op == "|" || binary_op == "^" ||
-             binary_op == "<<" || binary_op == ">>" ||
-             binary_op == "+" || binary_op == "-" ||
-             binary_op == "*" || binary_op == "/" || binary_op == "%")) {
+            (binary_op == BinaryOp::BitAnd || binary_op == BinaryOp::BitOr || binary_op == BinaryOp::BitXor ||
+             binary_op == BinaryOp::Shl || binary_op == BinaryOp::Shr ||
+             binary_op == BinaryOp::Add || binary_op == BinaryOp::Sub ||
+             binary_op == BinaryOp::Mul || binary_op == BinaryOp::Div || binary_op == BinaryOp::Mod)) {
             uint64_t fixed_bits = 0;
             bool fixed_signed = false;
             int64_t fixed_frac = 0;
@@ -287,12 +308,12 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
                 return false;
             }
             const bool is_bitwise_shift_op =
-                (binary_op == "&" || binary_op == "|" || binary_op == "^" ||
-                 binary_op == "<<" || binary_op == ">>");
+                (binary_op == BinaryOp::BitAnd || binary_op == BinaryOp::BitOr || binary_op == BinaryOp::BitXor ||
+                 binary_op == BinaryOp::Shl || binary_op == BinaryOp::Shr);
             const bool is_any_frac_addsub_op =
-                (binary_op == "+" || binary_op == "-");
+                (binary_op == BinaryOp::Add || binary_op == BinaryOp::Sub);
             const bool is_any_frac_muldivmod_op =
-                (binary_op == "*" || binary_op == "/" || binary_op == "%");
+                (binary_op == BinaryOp::Mul || binary_op == BinaryOp::Div || binary_op == BinaryOp::Mod);
             if (!is_bitwise_shift_op &&
                 !is_any_frac_addsub_op &&
                 !is_any_frac_muldivmod_op) {
@@ -311,22 +332,22 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
             };
             l = wrap_raw(l);
             r = wrap_raw(r);
-            if (binary_op == "+" || binary_op == "-") {
-                out = ctvalue_from_exact_int(binary_op == "+" ? wrap_raw(l + r) : wrap_raw(l - r),
+            if (binary_op == BinaryOp::Add || binary_op == BinaryOp::Sub) {
+                out = ctvalue_from_exact_int(binary_op == BinaryOp::Add ? wrap_raw(l + r) : wrap_raw(l - r),
                                              !fixed_signed);
                 return true;
             }
-            if (binary_op == "*" || binary_op == "/" || binary_op == "%") {
-                if ((binary_op == "/" || binary_op == "%") && r.is_zero()) {
-                    error_msg = (binary_op == "/")
+            if (binary_op == BinaryOp::Mul || binary_op == BinaryOp::Div || binary_op == BinaryOp::Mod) {
+                if ((binary_op == BinaryOp::Div || binary_op == BinaryOp::Mod) && r.is_zero()) {
+                    error_msg = (binary_op == BinaryOp::Div)
                         ? "Division by zero in compile-time evaluation"
                         : "Modulo by zero in compile-time evaluation";
                     return false;
                 }
                 APInt raw(uint64_t(0));
-                if (binary_op == "*") {
+                if (binary_op == BinaryOp::Mul) {
                     raw = scale_by_pow2_trunc_zero(l * r, -fixed_frac);
-                } else if (binary_op == "/") {
+                } else if (binary_op == BinaryOp::Div) {
                     if (!fixed_raw_div(l, r, fixed_frac, raw)) {
                         error_msg = "Division by zero in compile-time evaluation";
                         return false;
@@ -340,15 +361,15 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
                 out = ctvalue_from_exact_int(wrap_raw(raw), !fixed_signed);
                 return true;
             }
-            if (binary_op == "&") {
+            if (binary_op == BinaryOp::BitAnd) {
                 out = ctvalue_from_exact_int(wrap_raw(l & r), !fixed_signed);
                 return true;
             }
-            if (binary_op == "|") {
+            if (binary_op == BinaryOp::BitOr) {
                 out = ctvalue_from_exact_int(wrap_raw(l | r), !fixed_signed);
                 return true;
             }
-            if (binary_op == "^") {
+            if (binary_op == BinaryOp::BitXor) {
                 out = ctvalue_from_exact_int(wrap_raw(l ^ r), !fixed_signed);
                 return true;
             }
@@ -361,7 +382,7 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
                 return false;
             }
             uint64_t shift = r.to_u64();
-            if (binary_op == "<<") {
+            if (binary_op == BinaryOp::Shl) {
                 out = ctvalue_from_exact_int(wrap_raw(l << shift), !fixed_signed);
             } else {
                 out = ctvalue_from_exact_int(wrap_raw(l >> shift), !fixed_signed);
@@ -387,27 +408,27 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
             };
             l = wrap_raw(l);
             r = wrap_raw(r);
-            if (binary_op == "+") {
+            if (binary_op == BinaryOp::Add) {
                 out = ctvalue_from_exact_int(wrap_raw(l + r), !fixed_signed);
                 return true;
             }
-            if (binary_op == "-") {
+            if (binary_op == BinaryOp::Sub) {
                 out = ctvalue_from_exact_int(wrap_raw(l - r), !fixed_signed);
                 return true;
             }
-            if (binary_op == "*" || binary_op == "/" || binary_op == "%") {
+            if (binary_op == BinaryOp::Mul || binary_op == BinaryOp::Div || binary_op == BinaryOp::Mod) {
                 uint64_t muldiv_bits = 0;
                 bool muldiv_signed = false;
                 int64_t muldiv_frac = 0;
                 if (!fixed_muldiv_meta_supported(fixed_type, muldiv_bits, muldiv_signed, muldiv_frac)) {
-                    error_msg = "Fixed-point compound assignment '" + assign_op +
+                    error_msg = "Fixed-point compound assignment '" + expr->op +
                                 "' currently supports only native storage widths (8/16/32/64)";
                     return false;
                 }
                 APInt raw(uint64_t(0));
-                if (binary_op == "*") {
+                if (binary_op == BinaryOp::Mul) {
                     raw = scale_by_pow2_trunc_zero(l * r, -muldiv_frac);
-                } else if (binary_op == "/") {
+                } else if (binary_op == BinaryOp::Div) {
                     if (!fixed_raw_div(l, r, muldiv_frac, raw)) {
                         error_msg = "Division by zero in compile-time evaluation";
                         return false;
@@ -425,14 +446,14 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
             }
         }
 
-        if (binary_op == "&&" || binary_op == "||") {
+        if (binary_op == BinaryOp::LogicalAnd || binary_op == BinaryOp::LogicalOr) {
             bool lhs_bool = false;
             bool rhs_bool = false;
             if (!cte_scalar_to_bool(lhs_in, lhs_bool) || !cte_scalar_to_bool(rhs_in, rhs_bool)) {
                 error_msg = "Unsupported operand types for logical compound assignment";
                 return false;
             }
-            out = (binary_op == "&&") ? (lhs_bool && rhs_bool) : (lhs_bool || rhs_bool);
+            out = (binary_op == BinaryOp::LogicalAnd) ? (lhs_bool && rhs_bool) : (lhs_bool || rhs_bool);
             return true;
         }
 
@@ -446,8 +467,8 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
             return false;
         };
 
-        if (binary_op == "|" || binary_op == "&" || binary_op == "^" ||
-            binary_op == "<<" || binary_op == ">>") {
+        if (binary_op == BinaryOp::BitOr || binary_op == BinaryOp::BitAnd || binary_op == BinaryOp::BitXor ||
+            binary_op == BinaryOp::Shl || binary_op == BinaryOp::Shr) {
             if (!is_integer_like(lhs_in) || !is_integer_like(rhs_in)) {
                 error_msg = "Unsupported operand types for bitwise compound assignment";
                 return false;
@@ -460,9 +481,9 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
                 return false;
             }
             bool use_unsigned = integer_unsigned_hint(lhs_in) || integer_unsigned_hint(rhs_in);
-            if (binary_op == "|") out = ctvalue_from_exact_int(l | r, use_unsigned);
-            else if (binary_op == "&") out = ctvalue_from_exact_int(l & r, use_unsigned);
-            else if (binary_op == "^") out = ctvalue_from_exact_int(l ^ r, use_unsigned);
+            if (binary_op == BinaryOp::BitOr) out = ctvalue_from_exact_int(l | r, use_unsigned);
+            else if (binary_op == BinaryOp::BitAnd) out = ctvalue_from_exact_int(l & r, use_unsigned);
+            else if (binary_op == BinaryOp::BitXor) out = ctvalue_from_exact_int(l ^ r, use_unsigned);
             else {
                 if (r.is_negative()) {
                     error_msg = "Negative shift count in compile-time evaluation";
@@ -473,7 +494,7 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
                     return false;
                 }
                 uint64_t shift = r.to_u64();
-                if (binary_op == "<<") out = ctvalue_from_exact_int(l << shift, use_unsigned);
+                if (binary_op == BinaryOp::Shl) out = ctvalue_from_exact_int(l << shift, use_unsigned);
                 else out = ctvalue_from_exact_int(l >> shift, use_unsigned);
             }
             return true;
@@ -482,17 +503,17 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
         if (std::holds_alternative<double>(lhs_in) || std::holds_alternative<double>(rhs_in)) {
             double l = to_float(lhs_in);
             double r = to_float(rhs_in);
-            if (binary_op == "+") out = l + r;
-            else if (binary_op == "-") out = l - r;
-            else if (binary_op == "*") out = l * r;
-            else if (binary_op == "/") {
+            if (binary_op == BinaryOp::Add) out = l + r;
+            else if (binary_op == BinaryOp::Sub) out = l - r;
+            else if (binary_op == BinaryOp::Mul) out = l * r;
+            else if (binary_op == BinaryOp::Div) {
                 if (r == 0.0) {
                     error_msg = "Division by zero in compile-time evaluation";
                     return false;
                 }
                 out = l / r;
             } else {
-                error_msg = "Unsupported compound assignment operator at compile time: " + assign_op;
+                error_msg = "Unsupported compound assignment operator at compile time: " + expr->op;
                 return false;
             }
             return true;
@@ -507,23 +528,23 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
                 return false;
             }
             bool use_unsigned = integer_unsigned_hint(lhs_in) || integer_unsigned_hint(rhs_in);
-            if (binary_op == "+") out = ctvalue_from_exact_int(l + r, use_unsigned);
-            else if (binary_op == "-") out = ctvalue_from_exact_int(l - r, use_unsigned);
-            else if (binary_op == "*") out = ctvalue_from_exact_int(l * r, use_unsigned);
-            else if (binary_op == "/") {
+            if (binary_op == BinaryOp::Add) out = ctvalue_from_exact_int(l + r, use_unsigned);
+            else if (binary_op == BinaryOp::Sub) out = ctvalue_from_exact_int(l - r, use_unsigned);
+            else if (binary_op == BinaryOp::Mul) out = ctvalue_from_exact_int(l * r, use_unsigned);
+            else if (binary_op == BinaryOp::Div) {
                 if (r.is_zero()) {
                     error_msg = "Division by zero in compile-time evaluation";
                     return false;
                 }
                 out = ctvalue_from_exact_int(l / r, use_unsigned);
-            } else if (binary_op == "%") {
+            } else if (binary_op == BinaryOp::Mod) {
                 if (r.is_zero()) {
                     error_msg = "Modulo by zero in compile-time evaluation";
                     return false;
                 }
                 out = ctvalue_from_exact_int(l % r, use_unsigned);
             } else {
-                error_msg = "Unsupported compound assignment operator at compile time: " + assign_op;
+                error_msg = "Unsupported compound assignment operator at compile time: " + expr->op;
                 return false;
             }
             return true;
@@ -534,21 +555,21 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
     };
 
     CTValue assign_val;
-    if (assign_op == "=") {
+    if (assign_op == AssignOp::Assign) {
         if (!evaluate_rhs(assign_val)) {
             return false;
         }
-    } else if (assign_op == "&&=" || assign_op == "||=") {
-        if (std::holds_alternative<CTUninitialized>(*slot)) {
+    } else if (assign_op == AssignOp::LogicalAnd || assign_op == AssignOp::LogicalOr) {
+        if (std::holds_alternative<CTUninitialized>(current)) {
             error_msg = "Compound assignment reads uninitialized value";
             return false;
         }
         bool lhs_bool = false;
-        if (!cte_scalar_to_bool(*slot, lhs_bool)) {
+        if (!cte_scalar_to_bool(current, lhs_bool)) {
             error_msg = "Unsupported operand types for logical compound assignment";
             return false;
         }
-        const bool short_circuit = (assign_op == "&&=") ? !lhs_bool : lhs_bool;
+        const bool short_circuit = (assign_op == AssignOp::LogicalAnd) ? !lhs_bool : lhs_bool;
         if (short_circuit) {
             assign_val = lhs_bool;
         } else {
@@ -556,12 +577,12 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
             if (!evaluate_rhs(rhs_val)) {
                 return false;
             }
-            if (!apply_compound(*slot, rhs_val, assign_val)) {
+            if (!apply_compound(current, rhs_val, assign_val)) {
                 return false;
             }
         }
     } else {
-        if (std::holds_alternative<CTUninitialized>(*slot)) {
+        if (std::holds_alternative<CTUninitialized>(current)) {
             error_msg = "Compound assignment reads uninitialized value";
             return false;
         }
@@ -569,7 +590,7 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
         if (!evaluate_rhs(rhs_val)) {
             return false;
         }
-        if (!apply_compound(*slot, rhs_val, assign_val)) {
+        if (!apply_compound(current, rhs_val, assign_val)) {
             return false;
         }
     }
@@ -589,7 +610,15 @@ bool CompileTimeEvaluator::eval_assignment(ExprPtr expr, CTValue& result) {
     if (!coerce_value_to_lvalue_type(expr->left, assign_val, stored_val)) {
         return false;
     }
-    *slot = copy_ct_value(stored_val);
+    CTValue* slot = nullptr;
+    if (!walk_lvalue_path(true, slot)) {
+        return false;
+    }
+    if (target_array) {
+        target_array->set(target_index, stored_val);
+    } else {
+        *slot = copy_ct_value(stored_val);
+    }
     ExprPtr root_ident = expr->left;
     while (root_ident &&
            (root_ident->kind == Expr::Kind::Member || root_ident->kind == Expr::Kind::Index)) {
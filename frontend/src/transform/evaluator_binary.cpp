@@ -1,10 +1,88 @@
 #include "evaluator.h"
 #include "cte_value_utils.h"
 
+#include <cstdint>
+#include <limits>
+
 namespace vexel {
 
 namespace {
 
+__extension__ typedef __int128 i128;
+
+// Host-word integer operands widened to 128 bits, where every operator below
+// is exact. Exact ints always take the APInt path.
+bool word_operand(const CTValue& value, i128& out) {
+    if (std::holds_alternative<int64_t>(value)) {
+        out = std::get<int64_t>(value);
+        return true;
+    }
+    if (std::holds_alternative<uint64_t>(value)) {
+        out = std::get<uint64_t>(value);
+        return true;
+    }
+    if (std::holds_alternative<bool>(value)) {
+        out = std::get<bool>(value) ? 1 : 0;
+        return true;
+    }
+    return false;
+}
+
+// Mirrors ctvalue_from_exact_int; false when the value needs an exact int.
+bool word_result(i128 value, bool is_unsigned, CTValue& out) {
+    if (is_unsigned) {
+        if (value < 0 || value > static_cast<i128>(std::numeric_limits<uint64_t>::max())) return false;
+        out = static_cast<uint64_t>(value);
+        return true;
+    }
+    if (value < std::numeric_limits<int64_t>::min() || value > std::numeric_limits<int64_t>::max()) return false;
+    out = static_cast<int64_t>(value);
+    return true;
+}
+
+bool fits_i64(i128 value) {
+    return value >= std::numeric_limits<int64_t>::min() && value <= std::numeric_limits<int64_t>::max();
+}
+
+// Integer binary operators on host-word operands without materializing APInt
+// values; results match the exact path bit for bit. Returns false to defer to
+// the exact path, which also owns every diagnostic (zero divisors, bad shifts).
+bool eval_word_binary(BinaryOp op, i128 l, i128 r, bool use_unsigned, CTValue& result) {
+    switch (op) {
+        case BinaryOp::Add: return word_result(l + r, use_unsigned, result);
+        case BinaryOp::Sub: return word_result(l - r, use_unsigned, result);
+        case BinaryOp::Mul:
+            if (!fits_i64(l) || !fits_i64(r)) return false;
+            return word_result(l * r, use_unsigned, result);
+        case BinaryOp::Div:
+            if (r == 0) return false;
+            return word_result(l / r, use_unsigned, result);
+        case BinaryOp::Mod:
+            if (r == 0) return false;
+            return word_result(l % r, use_unsigned, result);
+        case BinaryOp::BitAnd: return word_result(l & r, use_unsigned, result);
+        case BinaryOp::BitOr: return word_result(l | r, use_unsigned, result);
+        case BinaryOp::BitXor: return word_result(l ^ r, use_unsigned, result);
+        case BinaryOp::Lt: result = static_cast<int64_t>(l < r); return true;
+        case BinaryOp::Gt: result = static_cast<int64_t>(l > r); return true;
+        case BinaryOp::Eq: result = static_cast<int64_t>(l == r); return true;
+        case BinaryOp::Ne: result = static_cast<int64_t>(l != r); return true;
+        case BinaryOp::Le: result = static_cast<int64_t>(l <= r); return true;
+        case BinaryOp::Ge: result = static_cast<int64_t>(l >= r); return true;
+        case BinaryOp::Shl:
+            if (r < 0 || r > 62) return false;
+            return word_result(l * (static_cast<i128>(1) << static_cast<int>(r)), use_unsigned, result);
+        case BinaryOp::Shr: {
+            if (r < 0) return false;
+            // Arithmetic shift rounds toward negative infinity, like APInt.
+            const i128 shifted = r >= 127 ? (l < 0 ? -1 : 0) : (l >> static_cast<int>(r));
+            return word_result(shifted, use_unsigned, result);
+        }
+        default:
+            return false;
+    }
+}
+
 bool is_fixed_primitive_type(const TypePtr& type) {
     return type &&
            type->kind == Type::Kind::Primitive &&
@@ -89,6 +167,7 @@ bool fixed_raw_mod(const APInt& lhs,
 } // namespace
 
 bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
+    const BinaryOp op = expr->binary_op;
     CTValue left_val, right_val;
     if (!try_evaluate(expr->left, left_val)) return false;
 
@@ -102,18 +181,18 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
         return false;
     };
 
-    if (expr->op == "&&" || expr->op == "||") {
+    if (op == BinaryOp::LogicalAnd || op == BinaryOp::LogicalOr) {
         bool left_bool = false;
         if (!cte_scalar_to_bool(left_val, left_bool)) {
             error_msg = "Unsupported operand types for logical operation";
             return false;
         }
 
-        if (expr->op == "&&" && !left_bool) {
+        if (op == BinaryOp::LogicalAnd && !left_bool) {
             result = false;
             return true;
         }
-        if (expr->op == "||" && left_bool) {
+        if (op == BinaryOp::LogicalOr && left_bool) {
             result = true;
             return true;
         }
@@ -124,19 +203,14 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
             error_msg = "Unsupported operand types for logical operation";
             return false;
         }
-        result = (expr->op == "&&") ? (left_bool && right_bool) : (left_bool || right_bool);
+        result = (op == BinaryOp::LogicalAnd) ? (left_bool && right_bool) : (left_bool || right_bool);
         return true;
     }
 
     if (!try_evaluate(expr->right, right_val)) return false;
 
     if (expr && expr->type && is_fixed_primitive_type(expr->type) &&
-        (expr->op == "&" || expr->op == "|" || expr->op == "^" ||
-         expr->op == "<<" || expr->op == ">>" ||
-         expr->op == "+" || expr->op == "-" || expr->op == "*" ||
-         expr->op == "/" || expr->op == "%" ||
-         expr->op == "==" || expr->op == "!=" || expr->op == "<" ||
-         expr->op == "<=" || expr->op == ">" || expr->op == ">=")) {
+        op != BinaryOp::Other) {
         uint64_t fixed_bits = 0;
         bool fixed_signed = false;
         int64_t fixed_frac = 0;
@@ -145,14 +219,13 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
             return false;
         }
         const bool is_bitwise_shift_op =
-            (expr->op == "&" || expr->op == "|" || expr->op == "^" ||
-             expr->op == "<<" || expr->op == ">>");
+            (op == BinaryOp::BitAnd || op == BinaryOp::BitOr || op == BinaryOp::BitXor ||
+             op == BinaryOp::Shl || op == BinaryOp::Shr);
         const bool is_any_frac_addsubcmp_op =
-            (expr->op == "+" || expr->op == "-" ||
-             expr->op == "==" || expr->op == "!=" || expr->op == "<" ||
-             expr->op == "<=" || expr->op == ">" || expr->op == ">=");
+            (op == BinaryOp::Add || op == BinaryOp::Sub ||
+             is_comparison_op(op));
         const bool is_any_frac_muldivmod_op =
-            (expr->op == "*" || expr->op == "/" || expr->op == "%");
+            (op == BinaryOp::Mul || op == BinaryOp::Div || op == BinaryOp::Mod);
         if (!is_bitwise_shift_op &&
             !is_any_frac_addsubcmp_op &&
             !is_any_frac_muldivmod_op) {
@@ -172,21 +245,21 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
         };
         l = wrap_raw(l);
         r = wrap_raw(r);
-        if (expr->op == "+" || expr->op == "-") {
-            result = ctvalue_from_exact_int(expr->op == "+" ? wrap_raw(l + r) : wrap_raw(l - r), !fixed_signed);
+        if (op == BinaryOp::Add || op == BinaryOp::Sub) {
+            result = ctvalue_from_exact_int(op == BinaryOp::Add ? wrap_raw(l + r) : wrap_raw(l - r), !fixed_signed);
             return true;
         }
-        if (expr->op == "*" || expr->op == "/" || expr->op == "%") {
-            if ((expr->op == "/" || expr->op == "%") && r.is_zero()) {
-                error_msg = (expr->op == "/")
+        if (op == BinaryOp::Mul || op == BinaryOp::Div || op == BinaryOp::Mod) {
+            if ((op == BinaryOp::Div || op == BinaryOp::Mod) && r.is_zero()) {
+                error_msg = (op == BinaryOp::Div)
                     ? "Division by zero in compile-time evaluation"
                     : "Modulo by zero in compile-time evaluation";
                 return false;
             }
             APInt raw(uint64_t(0));
-            if (expr->op == "*") {
+            if (op == BinaryOp::Mul) {
                 raw = scale_by_pow2_trunc_zero(l * r, -fixed_frac);
-            } else if (expr->op == "/") {
+            } else if (op == BinaryOp::Div) {
                 if (!fixed_raw_div(l, r, fixed_frac, raw)) {
                     error_msg = "Division by zero in compile-time evaluation";
                     return false;
@@ -200,25 +273,24 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
             result = ctvalue_from_exact_int(wrap_raw(raw), !fixed_signed);
             return true;
         }
-        if (expr->op == "==" || expr->op == "!=" || expr->op == "<" ||
-            expr->op == "<=" || expr->op == ">" || expr->op == ">=") {
-            if (expr->op == "==") result = (int64_t)(l == r);
-            else if (expr->op == "!=") result = (int64_t)(l != r);
-            else if (expr->op == "<") result = (int64_t)(l < r);
-            else if (expr->op == "<=") result = (int64_t)(l <= r);
-            else if (expr->op == ">") result = (int64_t)(l > r);
+        if (is_comparison_op(op)) {
+            if (op == BinaryOp::Eq) result = (int64_t)(l == r);
+            else if (op == BinaryOp::Ne) result = (int64_t)(l != r);
+            else if (op == BinaryOp::Lt) result = (int64_t)(l < r);
+            else if (op == BinaryOp::Le) result = (int64_t)(l <= r);
+            else if (op == BinaryOp::Gt) result = (int64_t)(l > r);
             else result = (int64_t)(l >= r);
             return true;
         }
-        if (expr->op == "&") {
+        if (op == BinaryOp::BitAnd) {
             result = ctvalue_from_exact_int(wrap_raw(l & r), !fixed_signed);
             return true;
         }
-        if (expr->op == "|") {
+        if (op == BinaryOp::BitOr) {
             result = ctvalue_from_exact_int(wrap_raw(l | r), !fixed_signed);
             return true;
         }
-        if (expr->op == "^") {
+        if (op == BinaryOp::BitXor) {
             result = ctvalue_from_exact_int(wrap_raw(l ^ r), !fixed_signed);
             return true;
         }
@@ -231,7 +303,7 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
             return false;
         }
         uint64_t shift = r.to_u64();
-        if (expr->op == "<<") {
+        if (op == BinaryOp::Shl) {
             result = ctvalue_from_exact_int(wrap_raw(l << shift), !fixed_signed);
         } else {
             result = ctvalue_from_exact_int(wrap_raw(l >> shift), !fixed_signed);
@@ -259,25 +331,24 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
         };
         l = wrap_raw(l);
         r = wrap_raw(r);
-        if (expr->op == "+") {
+        if (op == BinaryOp::Add) {
             result = ctvalue_from_exact_int(wrap_raw(l + r), !fixed_signed);
             return true;
         }
-        if (expr->op == "-") {
+        if (op == BinaryOp::Sub) {
             result = ctvalue_from_exact_int(wrap_raw(l - r), !fixed_signed);
             return true;
         }
-        if (expr->op == "==" || expr->op == "!=" || expr->op == "<" ||
-            expr->op == "<=" || expr->op == ">" || expr->op == ">=") {
-            if (expr->op == "==") result = (int64_t)(l == r);
-            else if (expr->op == "!=") result = (int64_t)(l != r);
-            else if (expr->op == "<") result = (int64_t)(l < r);
-            else if (expr->op == "<=") result = (int64_t)(l <= r);
-            else if (expr->op == ">") result = (int64_t)(l > r);
+        if (is_comparison_op(op)) {
+            if (op == BinaryOp::Eq) result = (int64_t)(l == r);
+            else if (op == BinaryOp::Ne) result = (int64_t)(l != r);
+            else if (op == BinaryOp::Lt) result = (int64_t)(l < r);
+            else if (op == BinaryOp::Le) result = (int64_t)(l <= r);
+            else if (op == BinaryOp::Gt) result = (int64_t)(l > r);
             else result = (int64_t)(l >= r);
             return true;
         }
-        if ((expr->op == "*" || expr->op == "/" || expr->op == "%")) {
+        if ((op == BinaryOp::Mul || op == BinaryOp::Div || op == BinaryOp::Mod)) {
             uint64_t muldiv_bits = 0;
             bool muldiv_signed = false;
             int64_t muldiv_frac = 0;
@@ -287,9 +358,9 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
                 return false;
             }
             APInt raw(uint64_t(0));
-            if (expr->op == "*") {
+            if (op == BinaryOp::Mul) {
                 raw = scale_by_pow2_trunc_zero(l * r, -muldiv_frac);
-            } else if (expr->op == "/") {
+            } else if (op == BinaryOp::Div) {
                 if (!fixed_raw_div(l, r, muldiv_frac, raw)) {
                     error_msg = "Division by zero in compile-time evaluation";
                     return false;
@@ -313,6 +384,14 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
     const bool right_has_float = std::holds_alternative<double>(right_val);
     if (!left_has_float && !right_has_float &&
         is_integer_like(left_val) && is_integer_like(right_val)) {
+        const bool use_unsigned = integer_unsigned_hint(left_val) || integer_unsigned_hint(right_val);
+        i128 lw = 0;
+        i128 rw = 0;
+        if (word_operand(left_val, lw) && word_operand(right_val, rw) &&
+            eval_word_binary(op, lw, rw, use_unsigned, result)) {
+            return true;
+        }
+
         APInt l(uint64_t(0));
         APInt r(uint64_t(0));
         bool l_unsigned = false;
@@ -322,13 +401,12 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
             error_msg = "Unsupported operand types for binary operation";
             return false;
         }
-        const bool use_unsigned = integer_unsigned_hint(left_val) || integer_unsigned_hint(right_val);
 
-        if (expr->op == "|" || expr->op == "&" || expr->op == "^" ||
-            expr->op == "<<" || expr->op == ">>") {
-            if (expr->op == "|") result = ctvalue_from_exact_int(l | r, use_unsigned);
-            else if (expr->op == "&") result = ctvalue_from_exact_int(l & r, use_unsigned);
-            else if (expr->op == "^") result = ctvalue_from_exact_int(l ^ r, use_unsigned);
+        if (op == BinaryOp::BitOr || op == BinaryOp::BitAnd || op == BinaryOp::BitXor ||
+            op == BinaryOp::Shl || op == BinaryOp::Shr) {
+            if (op == BinaryOp::BitOr) result = ctvalue_from_exact_int(l | r, use_unsigned);
+            else if (op == BinaryOp::BitAnd) result = ctvalue_from_exact_int(l & r, use_unsigned);
+            else if (op == BinaryOp::BitXor) result = ctvalue_from_exact_int(l ^ r, use_unsigned);
             else {
                 if (r.is_negative()) {
                     error_msg = "Negative shift count in compile-time evaluation";
@@ -339,35 +417,35 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
                     return false;
                 }
                 const uint64_t shift = r.to_u64();
-                if (expr->op == "<<") result = ctvalue_from_exact_int(l << shift, use_unsigned);
+                if (op == BinaryOp::Shl) result = ctvalue_from_exact_int(l << shift, use_unsigned);
                 else result = ctvalue_from_exact_int(l >> shift, use_unsigned);
             }
             return true;
         }
 
-        if (expr->op == "+") result = ctvalue_from_exact_int(l + r, use_unsigned);
-        else if (expr->op == "-") result = ctvalue_from_exact_int(l - r, use_unsigned);
-        else if (expr->op == "*") result = ctvalue_from_exact_int(l * r, use_unsigned);
-        else if (expr->op == "/") {
+        if (op == BinaryOp::Add) result = ctvalue_from_exact_int(l + r, use_unsigned);
+        else if (op == BinaryOp::Sub) result = ctvalue_from_exact_int(l - r, use_unsigned);
+        else if (op == BinaryOp::Mul) result = ctvalue_from_exact_int(l * r, use_unsigned);
+        else if (op == BinaryOp::Div) {
             if (r.is_zero()) {
                 error_msg = "Division by zero in compile-time evaluation";
                 return false;
             }
             result = ctvalue_from_exact_int(l / r, use_unsigned);
         }
-        else if (expr->op == "%") {
+        else if (op == BinaryOp::Mod) {
             if (r.is_zero()) {
                 error_msg = "Modulo by zero in compile-time evaluation";
                 return false;
             }
             result = ctvalue_from_exact_int(l % r, use_unsigned);
         }
-        else if (expr->op == "==") result = (int64_t)(l == r);
-        else if (expr->op == "!=") result = (int64_t)(l != r);
-        else if (expr->op == "<") result = (int64_t)(l < r);
-        else if (expr->op == "<=") result = (int64_t)(l <= r);
-        else if (expr->op == ">") result = (int64_t)(l > r);
-        else if (expr->op == ">=") result = (int64_t)(l >= r);
+        else if (op == BinaryOp::Eq) result = (int64_t)(l == r);
+        else if (op == BinaryOp::Ne) result = (int64_t)(l != r);
+        else if (op == BinaryOp::Lt) result = (int64_t)(l < r);
+        else if (op == BinaryOp::Le) result = (int64_t)(l <= r);
+        else if (op == BinaryOp::Gt) result = (int64_t)(l > r);
+        else if (op == BinaryOp::Ge) result = (int64_t)(l >= r);
         else {
             error_msg = "Unsupported binary operator at compile time: " + expr->op;
             return false;
@@ -375,16 +453,16 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
         return true;
     }
 
-    if (std::holds_alternative<std::string>(left_val) &&
-        std::holds_alternative<std::string>(right_val)) {
-        const auto& l = std::get<std::string>(left_val);
-        const auto& r = std::get<std::string>(right_val);
-        if (expr->op == "==") result = (int64_t)(l == r);
-        else if (expr->op == "!=") result = (int64_t)(l != r);
-        else if (expr->op == "<") result = (int64_t)(l < r);
-        else if (expr->op == "<=") result = (int64_t)(l <= r);
-        else if (expr->op == ">") result = (int64_t)(l > r);
-        else if (expr->op == ">=") result = (int64_t)(l >= r);
+    if (std::holds_alternative<CTString>(left_val) &&
+        std::holds_alternative<CTString>(right_val)) {
+        const auto& l = std::get<CTString>(left_val).str();
+        const auto& r = std::get<CTString>(right_val).str();
+        if (op == BinaryOp::Eq) result = (int64_t)(l == r);
+        else if (op == BinaryOp::Ne) result = (int64_t)(l != r);
+        else if (op == BinaryOp::Lt) result = (int64_t)(l < r);
+        else if (op == BinaryOp::Le) result = (int64_t)(l <= r);
+        else if (op == BinaryOp::Gt) result = (int64_t)(l > r);
+        else if (op == BinaryOp::Ge) result = (int64_t)(l >= r);
         else {
             error_msg = "Unsupported binary operator for strings at compile time: " + expr->op;
             return false;
@@ -393,22 +471,22 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
     }
 
     auto eval_float = [&](double l, double r) -> bool {
-        if (expr->op == "+") result = l + r;
-        else if (expr->op == "-") result = l - r;
-        else if (expr->op == "*") result = l * r;
-        else if (expr->op == "/") {
+        if (op == BinaryOp::Add) result = l + r;
+        else if (op == BinaryOp::Sub) result = l - r;
+        else if (op == BinaryOp::Mul) result = l * r;
+        else if (op == BinaryOp::Div) {
             if (r == 0.0) {
                 error_msg = "Division by zero in compile-time evaluation";
                 return false;
             }
             result = l / r;
         }
-        else if (expr->op == "==") result = (int64_t)(l == r);
-        else if (expr->op == "!=") result = (int64_t)(l != r);
-        else if (expr->op == "<") result = (int64_t)(l < r);
-        else if (expr->op == "<=") result = (int64_t)(l <= r);
-        else if (expr->op == ">") result = (int64_t)(l > r);
-        else if (expr->op == ">=") result = (int64_t)(l >= r);
+        else if (op == BinaryOp::Eq) result = (int64_t)(l == r);
+        else if (op == BinaryOp::Ne) result = (int64_t)(l != r);
+        else if (op == BinaryOp::Lt) result = (int64_t)(l < r);
+        else if (op == BinaryOp::Le) result = (int64_t)(l <= r);
+        else if (op == BinaryOp::Gt) result = (int64_t)(l > r);
+        else if (op == BinaryOp::Ge) result = (int64_t)(l >= r);
         else {
             error_msg = "Unsupported binary operator at compile time: " + expr->op;
             return false;
@@ -420,7 +498,11 @@ bool CompileTimeEvaluator::eval_binary(ExprPtr expr, CTValue& result) {
     if (std::holds_alternative<double>(left_val) || std::holds_alternative<double>(right_val)) {
         double l = to_float(left_val);
         double r = to_float(right_val);
-        return eval_float(l, r);
+        if (!eval_float(l, r)) return false;
+        if (std::holds_alternative<double>(result)) {
+            result = float_at_type_precision(std::get<double>(result), expr->type);
+        }
+        return true;
     }
 
     error_msg = "Unsupported operand types for binary operation";
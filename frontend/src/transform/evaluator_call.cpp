@@ -1,67 +1,17 @@
 #include "evaluator.h"
 #include "constants.h"
+#include "cte_math.h"
+#include "cte_persistent_cache.h"
 #include "evaluator_internal.h"
 #include "typechecker.h"
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <optional>
 #include <utility>
 
 namespace vexel {
 
-namespace {
-
-void append_u64_hex(std::string& out, uint64_t v) {
-    static const char* kHex = "0123456789abcdef";
-    out += "0x";
-    for (int shift = 60; shift >= 0; shift -= 4) {
-        out.push_back(kHex[(v >> shift) & 0xFu]);
-    }
-}
-
-bool append_memo_key_value(std::string& out, const CTValue& value) {
-    if (std::holds_alternative<int64_t>(value)) {
-        out += "i:";
-        out += std::to_string(std::get<int64_t>(value));
-        return true;
-    }
-    if (std::holds_alternative<uint64_t>(value)) {
-        out += "u:";
-        out += std::to_string(std::get<uint64_t>(value));
-        return true;
-    }
-    if (std::holds_alternative<CTExactInt>(value)) {
-        const CTExactInt& exact = std::get<CTExactInt>(value);
-        out += exact.is_unsigned ? "U:" : "I:";
-        out += exact.value.to_string();
-        return true;
-    }
-    if (std::holds_alternative<bool>(value)) {
-        out += std::get<bool>(value) ? "b:1" : "b:0";
-        return true;
-    }
-    if (std::holds_alternative<double>(value)) {
-        uint64_t bits = 0;
-        double dv = std::get<double>(value);
-        static_assert(sizeof(bits) == sizeof(dv), "double/u64 size mismatch");
-        std::memcpy(&bits, &dv, sizeof(bits));
-        out += "f:";
-        append_u64_hex(out, bits);
-        return true;
-    }
-    if (std::holds_alternative<std::string>(value)) {
-        const std::string& s = std::get<std::string>(value);
-        out += "s:";
-        out += std::to_string(s.size());
-        out.push_back(':');
-        out += s;
-        return true;
-    }
-    return false;
-}
-
-} // namespace
-
 bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
     // Look up function or type
     if (!expr->operand || expr->operand->kind != Expr::Kind::Identifier) {
@@ -77,7 +27,7 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
     if (!sym && type_checker) {
         sym = type_checker->binding_for(expr->operand.get());
         if (expr->operand) {
-            expr->operand->resolved_symbol = sym;
+            cache_resolved_symbol(expr->operand, sym);
         }
     }
     if (!sym && type_checker && type_checker->get_scope()) {
@@ -87,7 +37,7 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
         } else {
             sym = scope->lookup_internal(func_name);
             if (!sym) {
-                std::vector<Symbol*> overloads = scope->lookup_functions(func_name);
+                SymbolSpan overloads = scope->lookup_functions(func_name);
                 if (overloads.size() == 1) {
                     sym = overloads.front();
                 }
@@ -99,6 +49,8 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
         error_msg = "Symbol not found: " + func_name;
         return false;
     }
+    // Callees feed the optimizer's dependency edges like global reads do.
+    note_symbol_read(sym);
 
     // Check if this is a type constructor call
     if (sym->kind == Symbol::Kind::Type && !expr->is_constructor_call) {
@@ -115,6 +67,9 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
         return false;
     }
 
+    if (type_checker) {
+        type_checker->materialize_function(sym);
+    }
     StmtPtr func = sym->declaration;
     if (expr->args.size() != func->params.size()) {
         error_msg = "Argument count mismatch in compile-time evaluation";
@@ -156,87 +111,12 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
             }
         }
 
-        auto unary_f64 = [&](double (*fn)(double)) -> bool {
-            if (args.size() != 1) return false;
-            out = fn(to_float(args[0]));
-            return true;
-        };
-        auto binary_f64 = [&](double (*fn)(double, double)) -> bool {
-            if (args.size() != 2) return false;
-            out = fn(to_float(args[0]), to_float(args[1]));
-            return true;
-        };
-        auto unary_f32 = [&](float (*fn)(float)) -> bool {
-            if (args.size() != 1) return false;
-            float x = static_cast<float>(to_float(args[0]));
-            out = static_cast<double>(fn(x));
-            return true;
-        };
-        auto binary_f32 = [&](float (*fn)(float, float)) -> bool {
-            if (args.size() != 2) return false;
-            float a = static_cast<float>(to_float(args[0]));
-            float b = static_cast<float>(to_float(args[1]));
-            out = static_cast<double>(fn(a, b));
-            return true;
-        };
-        auto unary_pred_f64 = [&](bool (*fn)(double)) -> bool {
-            if (args.size() != 1) return false;
-            out = fn(to_float(args[0]));
-            return true;
-        };
-        auto unary_pred_f32 = [&](bool (*fn)(float)) -> bool {
-            if (args.size() != 1) return false;
-            float x = static_cast<float>(to_float(args[0]));
-            out = fn(x);
-            return true;
-        };
-
-        if (name == "sin") return unary_f64(static_cast<double (*)(double)>(std::sin));
-        if (name == "cos") return unary_f64(static_cast<double (*)(double)>(std::cos));
-        if (name == "tan") return unary_f64(static_cast<double (*)(double)>(std::tan));
-        if (name == "asin") return unary_f64(static_cast<double (*)(double)>(std::asin));
-        if (name == "acos") return unary_f64(static_cast<double (*)(double)>(std::acos));
-        if (name == "atan") return unary_f64(static_cast<double (*)(double)>(std::atan));
-        if (name == "exp") return unary_f64(static_cast<double (*)(double)>(std::exp));
-        if (name == "log") return unary_f64(static_cast<double (*)(double)>(std::log));
-        if (name == "log2") return unary_f64(static_cast<double (*)(double)>(std::log2));
-        if (name == "log10") return unary_f64(static_cast<double (*)(double)>(std::log10));
-        if (name == "floor") return unary_f64(static_cast<double (*)(double)>(std::floor));
-        if (name == "ceil") return unary_f64(static_cast<double (*)(double)>(std::ceil));
-        if (name == "trunc") return unary_f64(static_cast<double (*)(double)>(std::trunc));
-        if (name == "round") return unary_f64(static_cast<double (*)(double)>(std::round));
-        if (name == "fabs") return unary_f64(static_cast<double (*)(double)>(std::fabs));
-        if (name == "sqrt") return unary_f64(static_cast<double (*)(double)>(std::sqrt));
-        if (name == "pow") return binary_f64(static_cast<double (*)(double, double)>(std::pow));
-        if (name == "atan2") return binary_f64(static_cast<double (*)(double, double)>(std::atan2));
-        if (name == "fmod") return binary_f64(static_cast<double (*)(double, double)>(std::fmod));
-        if (name == "isnan") return unary_pred_f64([](double x) { return std::isnan(x); });
-        if (name == "isinf") return unary_pred_f64([](double x) { return std::isinf(x); });
-        if (name == "isfinite") return unary_pred_f64([](double x) { return std::isfinite(x); });
-
-        if (name == "sinf") return unary_f32([](float x) { return std::sin(x); });
-        if (name == "cosf") return unary_f32([](float x) { return std::cos(x); });
-        if (name == "tanf") return unary_f32([](float x) { return std::tan(x); });
-        if (name == "asinf") return unary_f32([](float x) { return std::asin(x); });
-        if (name == "acosf") return unary_f32([](float x) { return std::acos(x); });
-        if (name == "atanf") return unary_f32([](float x) { return std::atan(x); });
-        if (name == "expf") return unary_f32([](float x) { return std::exp(x); });
-        if (name == "logf") return unary_f32([](float x) { return std::log(x); });
-        if (name == "log2f") return unary_f32([](float x) { return std::log2(x); });
-        if (name == "log10f") return unary_f32([](float x) { return std::log10(x); });
-        if (name == "floorf") return unary_f32([](float x) { return std::floor(x); });
-        if (name == "ceilf") return unary_f32([](float x) { return std::ceil(x); });
-        if (name == "truncf") return unary_f32([](float x) { return std::trunc(x); });
-        if (name == "roundf") return unary_f32([](float x) { return std::round(x); });
-        if (name == "fabsf") return unary_f32([](float x) { return std::fabs(x); });
-        if (name == "sqrtf") return unary_f32([](float x) { return std::sqrt(x); });
-        if (name == "powf") return binary_f32([](float x, float y) { return std::pow(x, y); });
-        if (name == "atan2f") return binary_f32([](float y, float x) { return std::atan2(y, x); });
-        if (name == "fmodf") return binary_f32([](float x, float y) { return std::fmod(x, y); });
-        if (name == "isnanf") return unary_pred_f32([](float x) { return std::isnan(x); });
-        if (name == "isinff") return unary_pred_f32([](float x) { return std::isinf(x); });
-        if (name == "isfinitef") return unary_pred_f32([](float x) { return std::isfinite(x); });
-        return false;
+        std::vector<double> operands;
+        operands.reserve(args.size());
+        for (const CTValue& arg : args) {
+            operands.push_back(to_float(arg));
+        }
+        return fold_std_math_call(name, operands, out);
     };
 
     auto try_eval_std_bits_external = [&](CTValue& out) -> bool {
@@ -349,41 +229,48 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
             }
         }
     }
-    std::vector<CTValue> memo_receivers;
-    std::vector<CTValue> memo_args;
-    memo_receivers.reserve(expr->receivers.size());
-    memo_args.reserve(expr->args.size());
-
-    // Evaluate arguments
-    std::unordered_map<std::string, CTValue> saved_constants = constants;
-    std::unordered_set<std::string> saved_uninitialized = uninitialized_locals;
-    std::unordered_set<std::string> call_bindings;
-    std::unordered_map<std::string, ExprPtr> expr_param_bindings;
-
-    auto restore_all_state = [&]() {
-        constants = saved_constants;
-        uninitialized_locals = saved_uninitialized;
-    };
-
-    auto restore_binding = [&](const std::string& name) {
-        auto it = saved_constants.find(name);
-        if (it != saved_constants.end()) {
-            constants[name] = copy_ct_value(it->second);
-        } else {
-            constants.erase(name);
-        }
-        if (saved_uninitialized.count(name) > 0) {
-            uninitialized_locals.insert(name);
-        } else {
-            uninitialized_locals.erase(name);
+    if (memo_candidate && (!constants.empty() || !uninitialized_locals.empty())) {
+        // Conservative capture-safety rule: only memoize when the caller's frame
+        // holds no local bindings beyond names this call rebinds. This avoids
+        // unsound reuse for nested functions that may capture locals.
+        auto binds_name = [&](const std::string& name) {
+            for (const auto& ref : func->ref_params) {
+                if (ref == name) return true;
+            }
+            for (const auto& param : func->params) {
+                if (param.name == name) return true;
+            }
+            return false;
+        };
+        for (const auto& entry : constants) {
+            if (!binds_name(entry.first)) {
+                memo_candidate = false;
+                break;
+            }
         }
-    };
-
-    auto cleanup_call_frame = [&]() {
-        for (const auto& name : call_bindings) {
-            restore_binding(name);
+        if (memo_candidate) {
+            for (const auto& name : uninitialized_locals) {
+                if (!binds_name(name)) {
+                    memo_candidate = false;
+                    break;
+                }
+            }
         }
+    }
+    CTMemoKey memo_key;
+    memo_key.function = sym;
+    memo_key.receivers.reserve(expr->receivers.size());
+    memo_key.args.reserve(expr->args.size());
+
+    // Every argument is evaluated in the caller's environment before any
+    // parameter is bound, so a later argument never reads an earlier parameter.
+    struct PendingBinding {
+        const std::string* name;
+        CTValue value;
     };
+    std::vector<PendingBinding> pending_bindings;
+    pending_bindings.reserve(func->ref_params.size() + expr->args.size());
+    std::unordered_map<std::string, ExprPtr> expr_param_bindings;
 
     if (!func->ref_params.empty()) {
         if (expr->receivers.size() != func->ref_params.size()) {
@@ -391,111 +278,59 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
             return false;
         }
         for (size_t i = 0; i < func->ref_params.size(); i++) {
-            call_bindings.insert(func->ref_params[i]);
             CTValue rec_val;
             if (!try_evaluate(expr->receivers[i], rec_val)) {
-                restore_all_state();
                 return false;
             }
             if (i < func->ref_param_types.size() && func->ref_param_types[i]) {
                 CTValue coerced;
                 if (!coerce_value_to_type(rec_val, func->ref_param_types[i], coerced)) {
-                    restore_all_state();
                     return false;
                 }
-                constants[func->ref_params[i]] = copy_ct_value(coerced);
-                if (memo_candidate) {
-                    memo_receivers.push_back(clone_ct_value(coerced));
-                }
-            } else {
-                constants[func->ref_params[i]] = copy_ct_value(rec_val);
-                if (memo_candidate) {
-                    memo_receivers.push_back(clone_ct_value(rec_val));
-                }
+                rec_val = std::move(coerced);
             }
-            uninitialized_locals.erase(func->ref_params[i]);
+            if (memo_candidate) {
+                memo_key.receivers.push_back(copy_ct_value(rec_val));
+            }
+            pending_bindings.push_back({&func->ref_params[i], std::move(rec_val)});
         }
     }
     for (size_t i = 0; i < expr->args.size(); i++) {
         const Parameter& param = func->params[i];
-        call_bindings.insert(param.name);
         if (param.is_expression_param) {
             expr_param_bindings[param.name] = expr->args[i];
             continue;
         }
         CTValue arg_val;
         if (!try_evaluate(expr->args[i], arg_val)) {
-            restore_all_state();
             return false;
         }
         if (param.type) {
             CTValue coerced;
             if (!coerce_value_to_type(arg_val, param.type, coerced)) {
-                restore_all_state();
                 return false;
             }
-            constants[param.name] = copy_ct_value(coerced);
-            if (memo_candidate) {
-                memo_args.push_back(clone_ct_value(coerced));
-            }
-        } else {
-            constants[param.name] = copy_ct_value(arg_val);
-            if (memo_candidate) {
-                memo_args.push_back(clone_ct_value(arg_val));
-            }
+            arg_val = std::move(coerced);
         }
-        uninitialized_locals.erase(param.name);
+        if (memo_candidate) {
+            memo_key.args.push_back(copy_ct_value(arg_val));
+        }
+        pending_bindings.push_back({&param.name, std::move(arg_val)});
     }
 
-    std::string memo_key;
     bool memo_key_active = false;
     bool memo_store_allowed = false;
     if (memo_candidate) {
-        // Conservative capture-safety rule: only memoize when the current evaluator
-        // frame contains no ambient local bindings beyond this call's own bindings.
-        // This avoids unsound reuse for nested functions that may capture locals.
-        for (const auto& entry : constants) {
-            if (!call_bindings.count(entry.first)) {
-                memo_candidate = false;
-                break;
-            }
-        }
-    }
-    if (memo_candidate) {
-        for (const auto& name : uninitialized_locals) {
-            if (!call_bindings.count(name)) {
-                memo_candidate = false;
-                break;
-            }
-        }
-    }
-    if (memo_candidate) {
-        memo_key.reserve(96 + (memo_receivers.size() + memo_args.size()) * 24);
-        memo_key += "fn:";
-        memo_key += std::to_string(reinterpret_cast<uintptr_t>(sym));
-        memo_key += "|r:";
-        for (const auto& v : memo_receivers) {
-            if (!append_memo_key_value(memo_key, v)) {
-                memo_candidate = false;
-                break;
-            }
-            memo_key.push_back('|');
-        }
-        if (memo_candidate) {
-            memo_key += "|a:";
-            for (const auto& v : memo_args) {
-                if (!append_memo_key_value(memo_key, v)) {
-                    memo_candidate = false;
-                    break;
-                }
-                memo_key.push_back('|');
-            }
-        }
+        memo_candidate = memo_hasher.finalize(memo_key);
         if (memo_candidate) {
             auto cached = call_result_cache.find(memo_key);
+            if (cached != call_result_cache.end() && !reuse_memo_entry(cached->second)) {
+                call_result_cache.erase(cached);
+                cached = call_result_cache.end();
+            }
+            record_memo_lookup(sym, cached != call_result_cache.end());
             if (cached != call_result_cache.end()) {
-                result = clone_ct_value(cached->second);
-                cleanup_call_frame();
+                result = copy_ct_value(cached->second.value);
                 return true;
             }
             if (!active_call_memo_keys.count(memo_key)) {
@@ -505,9 +340,26 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
             }
         }
     }
+    // Only outermost calls consult the cross-build cache: nested results are
+    // already covered by their caller's entry and the in-memory memo.
+    CTEPersistentCache* persistent_cache =
+        type_checker ? type_checker->get_persistent_cte_cache() : nullptr;
+    std::string persistent_key;
+    if (memo_store_allowed && persistent_cache && return_depth == 0 &&
+        persistent_call_key(sym, expr, memo_key.receivers, memo_key.args, persistent_key)) {
+        CTValue cached;
+        if (persistent_cache->lookup(persistent_key, cached)) {
+            active_call_memo_keys.erase(memo_key);
+            call_result_cache[memo_key].value = copy_ct_value(cached);
+            result = std::move(cached);
+            return true;
+        }
+    } else {
+        persistent_cache = nullptr;
+    }
     struct MemoGuard {
         CompileTimeEvaluator* self = nullptr;
-        std::string* key = nullptr;
+        const CTMemoKey* key = nullptr;
         bool active = false;
         ~MemoGuard() {
             if (active && self && key) {
@@ -515,14 +367,29 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
             }
         }
     } memo_guard{this, &memo_key, memo_key_active};
+    std::optional<ReadFrame> call_reads;
+    if (memo_store_allowed) {
+        call_reads.emplace(this);
+    }
 
     // Evaluate function body
     if (!func->body) {
         error_msg = "Function has no body";
-        restore_all_state();
         return false;
     }
 
+    // One frame holds whatever the parameters shadow in the caller.
+    LocalFrame call_frame;
+    call_frame.reserve(pending_bindings.size() + expr_param_bindings.size());
+    for (auto& binding : pending_bindings) {
+        shadow_binding(call_frame, *binding.name);
+        constants[*binding.name] = std::move(binding.value);
+        uninitialized_locals.erase(*binding.name);
+    }
+    for (const auto& entry : expr_param_bindings) {
+        shadow_binding(call_frame, entry.first);
+    }
+
     push_ref_params(func);
     struct RefParamGuard {
         CompileTimeEvaluator* self;
@@ -553,10 +420,13 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
     } return_guard(return_depth);
 
     bool success = false;
-    try {
+    {
+        ProfileScope profile_scope(this, sym);
         success = try_evaluate(func->body, result);
-    } catch (const EvalReturn& ret) {
-        result = copy_ct_value(ret.value);
+    }
+    if (!success && completion == Completion::Return) {
+        completion = Completion::Normal;
+        result = std::move(return_value);
         success = true;
     }
     if (success) {
@@ -593,6 +463,7 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
                         out_comp->fields[field_name] = copy_ct_value(coerced_field);
                     }
                     if (success) {
+                        ct_note_composite(*out_comp);
                         result = out_comp;
                     }
                 }
@@ -607,15 +478,20 @@ bool CompileTimeEvaluator::eval_call(ExprPtr expr, CTValue& result) {
         }
     }
     if (!success) {
-        restore_all_state();
+        restore_frame(call_frame);
         return false;
     }
 
     if (memo_store_allowed) {
-        call_result_cache[memo_key] = clone_ct_value(result);
+        MemoEntry& entry = call_result_cache[memo_key];
+        entry.value = copy_ct_value(result);
+        entry.reads = call_reads->finish();
+    }
+    if (persistent_cache) {
+        persistent_cache->store(persistent_key, result);
     }
 
-    cleanup_call_frame();
+    restore_frame(call_frame);
     return true;
 }
 
@@ -119,11 +119,11 @@ bool CompileTimeEvaluator::eval_cast(ExprPtr expr, CTValue& result) {
         value_bits = value_bits.wrapped_unsigned(bits);
 
         auto array = std::make_shared<CTArray>();
-        array->elements.reserve(static_cast<size_t>(length));
+        array->reserve(static_cast<size_t>(length));
         for (int64_t i = 0; i < length; ++i) {
             uint64_t shift = static_cast<uint64_t>((length - 1 - i) * 8);
             APInt byte = (value_bits >> shift) & APInt(uint64_t(0xFF));
-            array->elements.push_back(ctvalue_from_exact_int(byte, true));
+            array->push_back(ctvalue_from_exact_int(byte, true));
         }
         result = array;
         return true;
@@ -145,7 +145,7 @@ bool CompileTimeEvaluator::eval_cast(ExprPtr expr, CTValue& result) {
                 error_msg = "Cast from null boolean array";
                 return false;
             }
-            length = static_cast<int64_t>(array->elements.size());
+            length = static_cast<int64_t>(array->size());
         } else if (expr->operand->type->array_size) {
             CTValue size_val;
             if (!try_evaluate(expr->operand->type->array_size, size_val)) {
@@ -204,7 +204,7 @@ bool CompileTimeEvaluator::eval_cast(ExprPtr expr, CTValue& result) {
             error_msg = "Cast from null boolean array";
             return false;
         }
-        if (static_cast<int64_t>(array->elements.size()) != length) {
+        if (static_cast<int64_t>(array->size()) != length) {
             error_msg = "Boolean array size mismatch for cast to #" +
                         primitive_name(target_type->primitive,
                                        target_type->integer_bits,
@@ -213,7 +213,7 @@ bool CompileTimeEvaluator::eval_cast(ExprPtr expr, CTValue& result) {
         }
         for (int64_t i = 0; i < length; ++i) {
             bool bit = false;
-            if (!to_bit(array->elements[static_cast<size_t>(i)], bit)) {
+            if (!to_bit(array->at(static_cast<size_t>(i)), bit)) {
                 error_msg = "Boolean array contains non-boolean value";
                 return false;
             }
@@ -393,7 +393,7 @@ bool CompileTimeEvaluator::eval_cast(ExprPtr expr, CTValue& result) {
         return true;
     } else if (is_float(target_type->primitive)) {
         // Cast to float
-        result = to_float(operand_val);
+        result = float_at_type_precision(to_float(operand_val), target_type);
         return true;
     } else if (target_type->primitive == PrimitiveType::Bool) {
         bool b = false;
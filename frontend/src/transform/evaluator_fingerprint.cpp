@@ -0,0 +1,306 @@
+#include "evaluator.h"
+#include "cte_persistent_cache.h"
+#include "typechecker.h"
+
+#include <cstring>
+#include <deque>
+#include <unordered_set>
+
+namespace vexel {
+
+namespace {
+
+// Hashes a callee declaration together with every declaration it can reach
+// statically (called functions, read global constants, named types). Symbol
+// resolution mirrors the evaluator so the closure covers what evaluation reads.
+class DeclarationFingerprinter {
+public:
+    explicit DeclarationFingerprinter(TypeChecker* checker) : checker_(checker) {}
+
+    bool run(const Symbol* root, ContentHasher& hasher) {
+        hasher_ = &hasher;
+        enqueue(root);
+        while (ok_ && !pending_.empty()) {
+            const Symbol* sym = pending_.front();
+            pending_.pop_front();
+            hash_symbol(sym);
+        }
+        return ok_;
+    }
+
+private:
+    TypeChecker* checker_ = nullptr;
+    ContentHasher* hasher_ = nullptr;
+    bool ok_ = true;
+    std::deque<const Symbol*> pending_;
+    std::unordered_set<const Symbol*> seen_;
+
+    void fail() { ok_ = false; }
+
+    void enqueue(const Symbol* sym) {
+        if (!sym) return;
+        if (seen_.insert(sym).second) {
+            pending_.push_back(sym);
+        }
+    }
+
+    Scope* scope() const { return checker_ ? checker_->get_scope() : nullptr; }
+
+    Symbol* resolve_identifier(const ExprPtr& expr) const {
+        Symbol* sym = expr->resolved_symbol;
+        if (!sym && checker_) sym = checker_->binding_for(expr.get());
+        if (!sym && scope()) sym = scope()->lookup(expr->name);
+        return sym;
+    }
+
+    Symbol* resolve_callee(const ExprPtr& call) const {
+        const ExprPtr& callee = call->operand;
+        Symbol* sym = callee->resolved_symbol;
+        if (!sym && checker_) sym = checker_->binding_for(callee.get());
+        if (!sym && scope()) {
+            if (call->is_constructor_call) {
+                sym = scope()->lookup_type(callee->name);
+            } else {
+                sym = scope()->lookup_internal(callee->name);
+                if (!sym) {
+                    SymbolSpan overloads = scope()->lookup_functions(callee->name);
+                    if (overloads.size() == 1) sym = overloads.front();
+                }
+            }
+        }
+        return sym;
+    }
+
+    void reference_symbol(const Symbol* sym) {
+        if (!sym) return;
+        hasher_->add_string(sym->name);
+        if (sym->is_local) return;
+        switch (sym->kind) {
+            case Symbol::Kind::Function:
+            case Symbol::Kind::Type:
+                enqueue(sym);
+                return;
+            case Symbol::Kind::Constant:
+                if (sym->is_external || sym->is_backend_bound) {
+                    fail();
+                    return;
+                }
+                enqueue(sym);
+                return;
+            case Symbol::Kind::Variable:
+                // Mutable globals can be seeded per query; their value is not content.
+                fail();
+                return;
+        }
+    }
+
+    void hash_symbol(const Symbol* sym) {
+        hasher_->add_tag('S');
+        hasher_->add_u64(static_cast<uint64_t>(sym->kind));
+        hasher_->add_string(sym->name);
+        hasher_->add_u64(sym->is_external ? 1 : 0);
+        if (!sym->declaration) {
+            if (sym->kind != Symbol::Kind::Type) fail();
+            return;
+        }
+        hash_stmt(sym->declaration);
+    }
+
+    void hash_type(const TypePtr& type) {
+        if (!type) {
+            hasher_->add_tag('0');
+            return;
+        }
+        hasher_->add_tag('T');
+        hasher_->add_u64(static_cast<uint64_t>(type->kind));
+        switch (type->kind) {
+            case Type::Kind::Primitive:
+                hasher_->add_u64(static_cast<uint64_t>(type->primitive));
+                hasher_->add_u64(type->integer_bits);
+                hasher_->add_u64(static_cast<uint64_t>(type->fractional_bits));
+                break;
+            case Type::Kind::Array:
+                hash_type(type->element_type);
+                hash_expr(type->array_size);
+                break;
+            case Type::Kind::Named: {
+                hasher_->add_string(type->type_name);
+                Symbol* type_sym = type->resolved_symbol;
+                if (!type_sym && checker_) type_sym = checker_->binding_for(type.get());
+                if (!type_sym && scope()) type_sym = scope()->lookup(type->type_name);
+                if (type_sym) enqueue(type_sym);
+                break;
+            }
+            case Type::Kind::TypeVar:
+                hasher_->add_string(type->var_name);
+                break;
+            case Type::Kind::TypeOf:
+                hash_expr(type->typeof_expr);
+                break;
+        }
+    }
+
+    void hash_exprs(const std::vector<ExprPtr>& exprs) {
+        hasher_->add_u64(exprs.size());
+        for (const auto& expr : exprs) hash_expr(expr);
+    }
+
+    void hash_expr(const ExprPtr& expr) {
+        if (!ok_) return;
+        if (!expr) {
+            hasher_->add_tag('0');
+            return;
+        }
+        hasher_->add_tag('E');
+        hasher_->add_u64(static_cast<uint64_t>(expr->kind));
+        hash_type(expr->type);
+
+        switch (expr->kind) {
+            case Expr::Kind::IntLiteral:
+            case Expr::Kind::CharLiteral:
+                hasher_->add_u64(expr->uint_val);
+                hasher_->add_u64(expr->literal_is_unsigned ? 1 : 0);
+                hasher_->add_string(expr->has_exact_int_val ? expr->exact_int_val->to_string() : std::string());
+                hasher_->add_string(expr->raw_literal);
+                return;
+            case Expr::Kind::FloatLiteral: {
+                uint64_t bits = 0;
+                std::memcpy(&bits, &expr->float_val, sizeof(bits));
+                hasher_->add_u64(bits);
+                return;
+            }
+            case Expr::Kind::StringLiteral:
+                hasher_->add_string(expr->string_val);
+                return;
+            case Expr::Kind::Identifier:
+                hasher_->add_string(expr->name);
+                hasher_->add_u64(expr->is_expr_param_ref ? 1 : 0);
+                reference_symbol(resolve_identifier(expr));
+                return;
+            case Expr::Kind::Resource:
+            case Expr::Kind::Process:
+                // Host files and commands are outside the AST content hash.
+                fail();
+                return;
+            case Expr::Kind::Call:
+                hasher_->add_u64(expr->is_constructor_call ? 1 : 0);
+                hasher_->add_u64(expr->is_existence_probe ? 1 : 0);
+                if (expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
+                    hasher_->add_string(expr->operand->name);
+                    Symbol* callee = resolve_callee(expr);
+                    if (!callee) {
+                        fail();
+                        return;
+                    }
+                    reference_symbol(callee);
+                } else {
+                    hash_expr(expr->operand);
+                }
+                hash_exprs(expr->receivers);
+                hash_exprs(expr->args);
+                return;
+            default:
+                break;
+        }
+
+        hasher_->add_string(expr->op);
+        hasher_->add_string(expr->name);
+        hasher_->add_u64(expr->creates_new_variable ? 1 : 0);
+        hasher_->add_u64(expr->is_sorted_iteration ? 1 : 0);
+        hash_type(expr->declared_var_type);
+        hash_type(expr->target_type);
+        hash_expr(expr->left);
+        hash_expr(expr->right);
+        hash_expr(expr->operand);
+        hash_exprs(expr->args);
+        hash_exprs(expr->elements);
+        hasher_->add_u64(expr->statements.size());
+        for (const auto& stmt : expr->statements) hash_stmt(stmt);
+        hash_expr(expr->result_expr);
+        hash_expr(expr->condition);
+        hash_expr(expr->true_expr);
+        hash_expr(expr->false_expr);
+    }
+
+    void hash_stmt(const StmtPtr& stmt) {
+        if (!ok_) return;
+        if (!stmt) {
+            hasher_->add_tag('0');
+            return;
+        }
+        hasher_->add_tag('D');
+        hasher_->add_u64(static_cast<uint64_t>(stmt->kind));
+        switch (stmt->kind) {
+            case Stmt::Kind::Expr:
+                hash_expr(stmt->expr);
+                break;
+            case Stmt::Kind::Return:
+                hash_expr(stmt->return_expr);
+                break;
+            case Stmt::Kind::VarDecl:
+                hasher_->add_string(stmt->var_name);
+                hasher_->add_u64(stmt->is_mutable ? 1 : 0);
+                hash_type(stmt->var_type);
+                hash_expr(stmt->var_init);
+                break;
+            case Stmt::Kind::FuncDecl:
+                hasher_->add_string(stmt->func_name);
+                hasher_->add_string(stmt->type_namespace);
+                hasher_->add_u64(stmt->is_external ? 1 : 0);
+                hasher_->add_u64(stmt->params.size());
+                for (const auto& param : stmt->params) {
+                    hasher_->add_string(param.name);
+                    hasher_->add_u64(param.is_expression_param ? 1 : 0);
+                    hash_type(param.type);
+                }
+                hasher_->add_u64(stmt->ref_params.size());
+                for (const auto& name : stmt->ref_params) hasher_->add_string(name);
+                hasher_->add_u64(stmt->ref_param_types.size());
+                for (const auto& type : stmt->ref_param_types) hash_type(type);
+                hash_type(stmt->return_type);
+                hasher_->add_u64(stmt->return_types.size());
+                for (const auto& type : stmt->return_types) hash_type(type);
+                hash_expr(stmt->body);
+                break;
+            case Stmt::Kind::TypeDecl:
+                hasher_->add_string(stmt->type_decl_name);
+                hasher_->add_u64(stmt->fields.size());
+                for (const auto& field : stmt->fields) {
+                    hasher_->add_string(field.name);
+                    hash_type(field.type);
+                }
+                break;
+            case Stmt::Kind::ConditionalStmt:
+                hash_expr(stmt->condition);
+                hash_stmt(stmt->true_stmt);
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+} // namespace
+
+bool CompileTimeEvaluator::persistent_call_key(const Symbol* func_sym,
+                                               const ExprPtr& call,
+                                               const std::vector<CTValue>& receivers,
+                                               const std::vector<CTValue>& args,
+                                               std::string& out_key) {
+    ContentHasher hasher;
+    DeclarationFingerprinter fingerprinter(type_checker);
+    if (!fingerprinter.run(func_sym, hasher)) {
+        return false;
+    }
+    // Tuple results take their type name from the call site.
+    hasher.add_tag('C');
+    hasher.add_string(call && call->type ? call->type->to_string() : std::string());
+    hasher.add_u64(receivers.size());
+    for (const auto& value : receivers) hash_ct_value(hasher, value);
+    hasher.add_u64(args.size());
+    for (const auto& value : args) hash_ct_value(hasher, value);
+    out_key = hasher.hex();
+    return true;
+}
+
+} // namespace vexel
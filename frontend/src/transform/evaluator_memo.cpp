@@ -0,0 +1,166 @@
+#include "evaluator_memo.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace vexel {
+
+namespace {
+
+size_t mix_hash(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+uint64_t double_bits(double value) {
+    uint64_t bits = 0;
+    static_assert(sizeof(bits) == sizeof(value), "double/u64 size mismatch");
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool values_equal(const std::vector<CTValue>& a, const std::vector<CTValue>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!memo_values_equal(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool memo_values_equal(const CTValue& a, const CTValue& b) {
+    if (a.index() != b.index()) return false;
+    if (std::holds_alternative<int64_t>(a)) return std::get<int64_t>(a) == std::get<int64_t>(b);
+    if (std::holds_alternative<uint64_t>(a)) return std::get<uint64_t>(a) == std::get<uint64_t>(b);
+    if (std::holds_alternative<CTExactInt>(a)) {
+        const CTExactInt& lhs = std::get<CTExactInt>(a);
+        const CTExactInt& rhs = std::get<CTExactInt>(b);
+        return lhs.is_unsigned == rhs.is_unsigned && lhs.value == rhs.value;
+    }
+    // Bitwise, so -0.0/0.0 stay distinct and NaN keys can still hit.
+    if (std::holds_alternative<double>(a)) return double_bits(std::get<double>(a)) == double_bits(std::get<double>(b));
+    if (std::holds_alternative<bool>(a)) return std::get<bool>(a) == std::get<bool>(b);
+    if (std::holds_alternative<CTString>(a)) return std::get<CTString>(a).str() == std::get<CTString>(b).str();
+    if (std::holds_alternative<std::shared_ptr<CTComposite>>(a)) {
+        const auto& lhs = std::get<std::shared_ptr<CTComposite>>(a);
+        const auto& rhs = std::get<std::shared_ptr<CTComposite>>(b);
+        if (lhs == rhs) return true;
+        if (!lhs || !rhs) return false;
+        if (lhs->type_name != rhs->type_name || lhs->fields.size() != rhs->fields.size()) return false;
+        for (const auto& field : lhs->fields) {
+            auto it = rhs->fields.find(field.first);
+            if (it == rhs->fields.end() || !memo_values_equal(field.second, it->second)) return false;
+        }
+        return true;
+    }
+    if (std::holds_alternative<std::shared_ptr<CTArray>>(a)) {
+        const auto& lhs = std::get<std::shared_ptr<CTArray>>(a);
+        const auto& rhs = std::get<std::shared_ptr<CTArray>>(b);
+        if (lhs == rhs) return true;
+        if (!lhs || !rhs) return false;
+        if (lhs->size() != rhs->size()) return false;
+        bool packed_equal = false;
+        if (lhs->compare_packed(*rhs, packed_equal)) return packed_equal;
+        for (size_t i = 0; i < lhs->size(); ++i) {
+            if (!memo_values_equal(lhs->at(i), rhs->at(i))) return false;
+        }
+        return true;
+    }
+    // CTNoValue / CTUninitialized never reach a key.
+    return true;
+}
+
+bool CTMemoKey::operator==(const CTMemoKey& other) const {
+    return hash == other.hash &&
+           function == other.function &&
+           values_equal(receivers, other.receivers) &&
+           values_equal(args, other.args);
+}
+
+bool CTMemoHasher::hash_value(const CTValue& value, size_t& out) {
+    size_t h = value.index();
+    if (std::holds_alternative<int64_t>(value)) {
+        out = mix_hash(h, std::hash<int64_t>()(std::get<int64_t>(value)));
+        return true;
+    }
+    if (std::holds_alternative<uint64_t>(value)) {
+        out = mix_hash(h, std::hash<uint64_t>()(std::get<uint64_t>(value)));
+        return true;
+    }
+    if (std::holds_alternative<CTExactInt>(value)) {
+        const CTExactInt& exact = std::get<CTExactInt>(value);
+        out = mix_hash(mix_hash(h, exact.is_unsigned ? 1 : 0), exact.value.hash());
+        return true;
+    }
+    if (std::holds_alternative<double>(value)) {
+        out = mix_hash(h, std::hash<uint64_t>()(double_bits(std::get<double>(value))));
+        return true;
+    }
+    if (std::holds_alternative<bool>(value)) {
+        out = mix_hash(h, std::get<bool>(value) ? 1 : 0);
+        return true;
+    }
+    if (std::holds_alternative<CTString>(value)) {
+        out = mix_hash(h, std::hash<std::string>()(std::get<CTString>(value).str()));
+        return true;
+    }
+
+    const void* storage = nullptr;
+    if (std::holds_alternative<std::shared_ptr<CTComposite>>(value)) {
+        storage = std::get<std::shared_ptr<CTComposite>>(value).get();
+    } else if (std::holds_alternative<std::shared_ptr<CTArray>>(value)) {
+        storage = std::get<std::shared_ptr<CTArray>>(value).get();
+    }
+    if (!storage) {
+        return false;
+    }
+    auto cached = aggregate_hashes_.find(storage);
+    if (cached != aggregate_hashes_.end()) {
+        out = cached->second.second;
+        return true;
+    }
+
+    if (std::holds_alternative<std::shared_ptr<CTComposite>>(value)) {
+        const auto& comp = std::get<std::shared_ptr<CTComposite>>(value);
+        h = mix_hash(h, std::hash<std::string>()(comp->type_name));
+        // Field order in the map is unspecified; combine fields commutatively.
+        size_t fields_hash = 0;
+        for (const auto& field : comp->fields) {
+            size_t field_hash = 0;
+            if (!hash_value(field.second, field_hash)) return false;
+            fields_hash += mix_hash(std::hash<std::string>()(field.first), field_hash);
+        }
+        h = mix_hash(h, fields_hash);
+    } else {
+        const auto& array = std::get<std::shared_ptr<CTArray>>(value);
+        h = mix_hash(h, array->size());
+        for (size_t i = 0; i < array->size(); ++i) {
+            size_t elem_hash = 0;
+            if (!hash_value(array->at(i), elem_hash)) return false;
+            h = mix_hash(h, elem_hash);
+        }
+    }
+    aggregate_hashes_.emplace(storage, std::make_pair(value, h));
+    out = h;
+    return true;
+}
+
+bool CTMemoHasher::finalize(CTMemoKey& key) {
+    size_t h = std::hash<const void*>()(key.function);
+    h = mix_hash(h, key.receivers.size());
+    for (const auto& value : key.receivers) {
+        size_t value_hash = 0;
+        if (!hash_value(value, value_hash)) return false;
+        h = mix_hash(h, value_hash);
+    }
+    h = mix_hash(h, key.args.size());
+    for (const auto& value : key.args) {
+        size_t value_hash = 0;
+        if (!hash_value(value, value_hash)) return false;
+        h = mix_hash(h, value_hash);
+    }
+    key.hash = h;
+    return true;
+}
+
+} // namespace vexel
@@ -0,0 +1,46 @@
+#pragma once
+#include "cte_value.h"
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vexel {
+
+struct Symbol;
+
+// Structural key for compile-time call memoization.
+// Aggregate arguments are held by shared pointer rather than cloned: evaluator
+// assignment is copy-on-write, so storage referenced by a key is never mutated.
+struct CTMemoKey {
+    const Symbol* function = nullptr;
+    std::vector<CTValue> receivers;
+    std::vector<CTValue> args;
+    size_t hash = 0;
+
+    bool operator==(const CTMemoKey& other) const;
+};
+
+struct CTMemoKeyHash {
+    size_t operator()(const CTMemoKey& key) const { return key.hash; }
+};
+
+// Structural equality with a shared-storage fast path for aggregates.
+bool memo_values_equal(const CTValue& a, const CTValue& b);
+
+// Hashes memo key values, remembering the hash of each aggregate it has seen.
+// Remembered aggregates are pinned, which keeps them immutable under
+// copy-on-write, so repeated aggregate arguments hash in O(1).
+class CTMemoHasher {
+public:
+    // Returns false when the key contains values that are not memoizable.
+    bool finalize(CTMemoKey& key);
+    void clear() { aggregate_hashes_.clear(); }
+
+private:
+    bool hash_value(const CTValue& value, size_t& out);
+
+    std::unordered_map<const void*, std::pair<CTValue, size_t>> aggregate_hashes_;
+};
+
+} // namespace vexel
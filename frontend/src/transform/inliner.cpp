@@ -0,0 +1,279 @@
+#include "inliner.h"
+#include "ast_walk.h"
+#include "typechecker.h"
+#include <string>
+
+namespace vexel {
+
+namespace {
+
+// Size heuristics. Small bodies are inlined at every call site; a function
+// with a single call site may be larger since the copy replaces the original.
+// The caller bound keeps repeated inlining from blowing up one function.
+constexpr size_t kMaxInlineBodyNodes = 40;
+constexpr size_t kMaxSingleSiteBodyNodes = 200;
+constexpr size_t kMaxCallerNodes = 4000;
+
+template <typename Fn>
+void visit_exprs(const ExprPtr& expr, Fn& on_expr);
+
+template <typename Fn>
+void visit_stmt_exprs(const StmtPtr& stmt, Fn& on_expr) {
+    for_each_stmt_child(
+        stmt,
+        [&](const ExprPtr& child) { visit_exprs(child, on_expr); },
+        [&](const StmtPtr& child) { visit_stmt_exprs(child, on_expr); });
+}
+
+template <typename Fn>
+void visit_exprs(const ExprPtr& expr, Fn& on_expr) {
+    if (!expr) return;
+    on_expr(expr);
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { visit_exprs(child, on_expr); },
+        [&](const StmtPtr& child) { visit_stmt_exprs(child, on_expr); });
+}
+
+bool stmt_contains_return_or_function(const StmtPtr& stmt);
+
+bool contains_return_or_function(const ExprPtr& expr) {
+    bool found = false;
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { found = found || contains_return_or_function(child); },
+        [&](const StmtPtr& child) { found = found || stmt_contains_return_or_function(child); });
+    return found;
+}
+
+bool stmt_contains_return_or_function(const StmtPtr& stmt) {
+    if (!stmt) return false;
+    // Nested functions capture the enclosing frame by name.
+    if (stmt->kind == Stmt::Kind::Return || stmt->kind == Stmt::Kind::FuncDecl) return true;
+    bool found = false;
+    for_each_stmt_child(
+        stmt,
+        [&](const ExprPtr& child) { found = found || contains_return_or_function(child); },
+        [&](const StmtPtr& child) { found = found || stmt_contains_return_or_function(child); });
+    return found;
+}
+
+// True when evaluating `expr` in place can have an effect. Block statements
+// are emitted ahead of the enclosing expression in source order, so only the
+// part that stays in place counts.
+bool has_inplace_effects(const ExprPtr& expr) {
+    if (!expr) return false;
+    if (expr->kind == Expr::Kind::Call) return true;
+    if (expr->kind == Expr::Kind::Assignment && !expr->creates_new_variable) return true;
+    if (expr->kind == Expr::Kind::Block) return has_inplace_effects(expr->result_expr);
+    bool found = false;
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { found = found || has_inplace_effects(child); },
+        [&](const StmtPtr&) {});
+    return found;
+}
+
+bool is_array_type(const TypePtr& type) {
+    return type && type->kind == Type::Kind::Array;
+}
+
+} // namespace
+
+Inliner::Inliner(TypeChecker* checker) : checker(checker) {}
+
+size_t Inliner::run(Module& mod) {
+    if (!checker || mod.top_level_instance_ids.size() != mod.top_level.size()) return 0;
+
+    for (size_t i = 0; i < mod.top_level.size(); ++i) {
+        const StmtPtr& stmt = mod.top_level[i];
+        if (!stmt || stmt->kind != Stmt::Kind::FuncDecl || !stmt->body) continue;
+        const int instance_id = mod.top_level_instance_ids[i];
+        Symbol* sym = checker->binding_for(instance_id, stmt.get());
+        if (!sym || sym->kind != Symbol::Kind::Function || functions_.count(sym)) continue;
+        FunctionInfo& info = functions_[sym];
+        info.decl = stmt;
+        info.instance_id = instance_id;
+        graph_.add_node(sym);
+    }
+
+    // Call sites over every body and global initializer; graph edges only
+    // between functions that have a body here.
+    for (size_t i = 0; i < mod.top_level.size(); ++i) {
+        const StmtPtr& stmt = mod.top_level[i];
+        if (!stmt) continue;
+        const int instance_id = mod.top_level_instance_ids[i];
+        const Symbol* caller = stmt->kind == Stmt::Kind::FuncDecl ? checker->binding_for(instance_id, stmt.get())
+                                                                   : nullptr;
+        const uint32_t caller_node = caller ? graph_.find(caller) : CallGraph::kNoNode;
+        auto visit = [&](const ExprPtr& expr) {
+            if (expr->kind != Expr::Kind::Call) return;
+            Symbol* callee = callee_of(expr, instance_id);
+            auto it = callee ? functions_.find(callee) : functions_.end();
+            if (it == functions_.end()) return;
+            it->second.call_sites++;
+            if (caller_node != CallGraph::kNoNode) graph_.add_edge(caller_node, graph_.find(callee));
+        };
+        visit_stmt_exprs(stmt, visit);
+    }
+    graph_.finalize();
+
+    // Callees first: by the time a caller is rewritten, each callee body
+    // already holds its own inlined calls and its eligibility is final.
+    for (uint32_t comp = 0; comp < graph_.component_count(); ++comp) {
+        const bool cyclic = graph_.component_is_cyclic(comp);
+        for (uint32_t node : graph_.component_nodes(comp)) {
+            const Symbol* sym = graph_.symbol(node);
+            FunctionInfo& info = functions_[sym];
+            if (!info.decl->is_generic) {
+                size_t caller_nodes = count_expr_nodes(info.decl->body, kMaxCallerNodes);
+                inline_calls(info.decl->body.mutable_value(), sym, info.instance_id, caller_nodes, true);
+            }
+            info.inlinable = !cyclic && inlinable_body(sym, info);
+        }
+    }
+    return inlined_;
+}
+
+Symbol* Inliner::callee_of(const ExprPtr& call, int instance_id) const {
+    if (call->is_constructor_call || !call->receivers.empty() || !call->operand ||
+        call->operand->kind != Expr::Kind::Identifier) {
+        return nullptr;
+    }
+    Symbol* callee = checker->binding_for(instance_id, call->operand.get());
+    return callee && callee->kind == Symbol::Kind::Function ? callee : nullptr;
+}
+
+bool Inliner::inlinable_body(const Symbol* callee, const FunctionInfo& info) const {
+    const StmtPtr& decl = info.decl;
+    if (callee->is_external || callee->is_exported || decl->is_external || decl->is_exported || decl->is_generic ||
+        !decl->annotations.empty() || !decl->ref_params.empty() || !decl->type_namespace.empty() ||
+        !decl->return_type || !decl->return_types.empty() || is_array_type(decl->return_type)) {
+        return false;
+    }
+    for (const auto& param : decl->params) {
+        if (param.is_expression_param || is_array_type(param.type)) return false;
+    }
+    const size_t limit = info.call_sites == 1 ? kMaxSingleSiteBodyNodes : kMaxInlineBodyNodes;
+    if (count_expr_nodes(decl->body, limit) > limit) return false;
+    return !contains_return_or_function(decl->body);
+}
+
+void Inliner::inline_calls(ExprPtr& expr, const Symbol* caller, int instance_id, size_t& caller_nodes,
+                           bool may_inline) {
+    if (!expr) return;
+    // Operands evaluated before a position must stay effect-free in place,
+    // or hoisting the inlined statements would reorder effects.
+    auto ordered = [&](std::vector<ExprPtr>& items) {
+        bool open = may_inline;
+        for (auto& item : items) {
+            inline_calls(item, caller, instance_id, caller_nodes, open);
+            open = open && !has_inplace_effects(item);
+        }
+    };
+
+    switch (expr->kind) {
+        case Expr::Kind::Binary:
+        case Expr::Kind::Range: {
+            inline_calls(expr->left, caller, instance_id, caller_nodes, may_inline);
+            const bool short_circuit = expr->binary_op == BinaryOp::LogicalAnd || expr->binary_op == BinaryOp::LogicalOr;
+            inline_calls(expr->right, caller, instance_id, caller_nodes,
+                         may_inline && !short_circuit && !has_inplace_effects(expr->left));
+            break;
+        }
+        case Expr::Kind::Assignment:
+            inline_calls(expr->right, caller, instance_id, caller_nodes,
+                         may_inline && !has_inplace_effects(expr->left));
+            break;
+        case Expr::Kind::Unary:
+        case Expr::Kind::Cast:
+        case Expr::Kind::Length:
+        case Expr::Kind::Member:
+            inline_calls(expr->operand, caller, instance_id, caller_nodes, may_inline);
+            break;
+        case Expr::Kind::Call:
+            ordered(expr->args.mutable_vector());
+            break;
+        case Expr::Kind::Index: {
+            inline_calls(expr->operand, caller, instance_id, caller_nodes, may_inline);
+            const bool open = may_inline && !has_inplace_effects(expr->operand);
+            for (auto& arg : expr->args) inline_calls(arg, caller, instance_id, caller_nodes, open);
+            break;
+        }
+        case Expr::Kind::ArrayLiteral:
+        case Expr::Kind::TupleLiteral:
+            ordered(expr->elements.mutable_vector());
+            break;
+        case Expr::Kind::Block:
+            for (auto& stmt : expr->statements) inline_calls(stmt, caller, instance_id, caller_nodes, true);
+            inline_calls(expr->result_expr.mutable_value(), caller, instance_id, caller_nodes, may_inline);
+            break;
+        case Expr::Kind::Conditional:
+            // Branches are evaluated conditionally; only the condition is
+            // always reached.
+            inline_calls(expr->condition.mutable_value(), caller, instance_id, caller_nodes, may_inline);
+            inline_calls(expr->true_expr.mutable_value(), caller, instance_id, caller_nodes, false);
+            inline_calls(expr->false_expr.mutable_value(), caller, instance_id, caller_nodes, false);
+            break;
+        case Expr::Kind::Iteration:
+        case Expr::Kind::Repeat: {
+            // A repeat condition is re-evaluated on every pass.
+            inline_calls(loop_subject_ref(expr), caller, instance_id, caller_nodes,
+                         may_inline && expr->kind == Expr::Kind::Iteration);
+            inline_calls(loop_body_ref(expr), caller, instance_id, caller_nodes, false);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (!may_inline || expr->kind != Expr::Kind::Call) return;
+    Symbol* callee = callee_of(expr, instance_id);
+    auto it = callee ? functions_.find(callee) : functions_.end();
+    if (it == functions_.end() || callee == caller || !it->second.inlinable ||
+        it->second.instance_id != instance_id) {
+        return;
+    }
+    // Only calls that pass some constants gain from inlining: with none
+    // nothing new folds, and a call on constants alone that is still here
+    // after typing may have effects the copy would only duplicate.
+    size_t constant_args = 0;
+    for (const auto& arg : expr->args) {
+        if (checker->reads_only_constants(arg, instance_id)) constant_args++;
+    }
+    if (constant_args == 0 || constant_args == expr->args.size()) return;
+    const size_t body_nodes = count_expr_nodes(it->second.decl->body, kMaxCallerNodes);
+    if (caller_nodes + body_nodes > kMaxCallerNodes) return;
+    const std::string suffix = "__in" + std::to_string(inlined_);
+    ExprPtr inlined = checker->inline_call_body(expr, it->second.decl, instance_id, suffix);
+    if (!inlined) return;
+    expr = inlined;
+    caller_nodes += body_nodes;
+    inlined_++;
+    // Calls in the copy may now receive constant parameters.
+    inline_calls(expr, caller, instance_id, caller_nodes, may_inline);
+}
+
+void Inliner::inline_calls(StmtPtr& stmt, const Symbol* caller, int instance_id, size_t& caller_nodes,
+                           bool may_inline) {
+    if (!stmt) return;
+    switch (stmt->kind) {
+        case Stmt::Kind::Expr:
+            inline_calls(stmt->expr, caller, instance_id, caller_nodes, may_inline);
+            break;
+        case Stmt::Kind::Return:
+            inline_calls(stmt->return_expr.mutable_value(), caller, instance_id, caller_nodes, may_inline);
+            break;
+        case Stmt::Kind::VarDecl:
+            inline_calls(stmt->var_init.mutable_value(), caller, instance_id, caller_nodes, may_inline);
+            break;
+        case Stmt::Kind::ConditionalStmt:
+            inline_calls(stmt->condition.mutable_value(), caller, instance_id, caller_nodes, may_inline);
+            inline_calls(stmt->true_stmt.mutable_value(), caller, instance_id, caller_nodes, may_inline);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace vexel
@@ -0,0 +1,44 @@
+#pragma once
+#include "analysis_call_graph.h"
+#include "ast.h"
+#include <unordered_map>
+
+namespace vexel {
+
+class TypeChecker;
+
+// Cross-function inlining on the lowered module, before compile-time facts
+// are collected. Calls that pass some constant arguments to small
+// non-recursive internal functions (or larger ones with a single call site)
+// are replaced by a Block that binds the arguments to renamed parameter
+// locals and holds a typed copy of the body, so constant propagation flows
+// through what used to be an opaque call.
+// Functions are visited callees-first along the call graph, so an inlined
+// body already contains its own inlined callees.
+class Inliner {
+public:
+    explicit Inliner(TypeChecker* checker);
+
+    // Returns the number of call sites replaced.
+    size_t run(Module& mod);
+
+private:
+    struct FunctionInfo {
+        StmtPtr decl;
+        int instance_id = -1;
+        size_t call_sites = 0;
+        bool inlinable = false;
+    };
+
+    TypeChecker* checker;
+    std::unordered_map<const Symbol*, FunctionInfo> functions_;
+    CallGraph graph_;
+    size_t inlined_ = 0;
+
+    Symbol* callee_of(const ExprPtr& call, int instance_id) const;
+    bool inlinable_body(const Symbol* callee, const FunctionInfo& info) const;
+    void inline_calls(ExprPtr& expr, const Symbol* caller, int instance_id, size_t& caller_nodes, bool may_inline);
+    void inline_calls(StmtPtr& stmt, const Symbol* caller, int instance_id, size_t& caller_nodes, bool may_inline);
+};
+
+} // namespace vexel
@@ -0,0 +1,575 @@
+#include "loop_optimizer.h"
+#include "ast_walk.h"
+#include "common.h"
+#include "typechecker.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace vexel {
+
+namespace {
+
+bool is_scalar_type(const TypePtr& type) {
+    if (!type || type->kind != Type::Kind::Primitive) return false;
+    return type->primitive != PrimitiveType::String;
+}
+
+bool is_integer_type(const TypePtr& type) {
+    return type && type->kind == Type::Kind::Primitive &&
+           (is_signed_int(type->primitive) || is_unsigned_int(type->primitive));
+}
+
+bool is_float_type(const TypePtr& type) {
+    return type && type->kind == Type::Kind::Primitive &&
+           (type->primitive == PrimitiveType::F32 || type->primitive == PrimitiveType::F64);
+}
+
+bool same_type(const TypePtr& a, const TypePtr& b) {
+    return a && b && a->to_string() == b->to_string();
+}
+
+// Operators that neither trap nor depend on state, so evaluating them ahead
+// of a loop that might not run is unobservable. Division, remainder and
+// shifts are left in place.
+bool is_hoistable_binary_op(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Add:
+        case BinaryOp::Sub:
+        case BinaryOp::Mul:
+        case BinaryOp::BitAnd:
+        case BinaryOp::BitOr:
+        case BinaryOp::BitXor:
+        case BinaryOp::LogicalAnd:
+        case BinaryOp::LogicalOr:
+            return true;
+        default:
+            return is_comparison_op(op);
+    }
+}
+
+bool has_binary_read(const ExprPtr& expr, bool& saw_binary, bool& saw_read) {
+    if (!expr) return false;
+    if (expr->kind == Expr::Kind::Binary) saw_binary = true;
+    if (expr->kind == Expr::Kind::Identifier) saw_read = true;
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { has_binary_read(child, saw_binary, saw_read); },
+        [&](const StmtPtr&) {});
+    return saw_binary && saw_read;
+}
+
+// Visits every expression slot of a loop body except those inside nested
+// loops and nested functions, pre-order. `on_slot` returns false to skip the
+// slot's children (or when it replaced the slot).
+template <typename Fn>
+void visit_slots(ExprPtr& slot, Fn& on_slot);
+
+template <typename Fn>
+void visit_stmt_slots(const StmtPtr& stmt, Fn& on_slot) {
+    if (!stmt) return;
+    switch (stmt->kind) {
+        case Stmt::Kind::Expr:
+            visit_slots(stmt->expr, on_slot);
+            break;
+        case Stmt::Kind::Return:
+            visit_slots(stmt->return_expr.mutable_value(), on_slot);
+            break;
+        case Stmt::Kind::VarDecl:
+            visit_slots(stmt->var_init.mutable_value(), on_slot);
+            break;
+        case Stmt::Kind::ConditionalStmt:
+            visit_slots(stmt->condition.mutable_value(), on_slot);
+            visit_stmt_slots(stmt->true_stmt, on_slot);
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename Fn>
+void visit_slots(ExprPtr& slot, Fn& on_slot) {
+    if (!slot || is_loop_expr(slot) || !on_slot(slot)) return;
+    Expr& expr = *slot;
+    switch (expr.kind) {
+        case Expr::Kind::Binary:
+        case Expr::Kind::Assignment:
+        case Expr::Kind::Range:
+            visit_slots(expr.left, on_slot);
+            visit_slots(expr.right, on_slot);
+            break;
+        case Expr::Kind::Unary:
+        case Expr::Kind::Cast:
+        case Expr::Kind::Length:
+        case Expr::Kind::Member:
+            visit_slots(expr.operand, on_slot);
+            break;
+        case Expr::Kind::Call:
+            for (auto& arg : expr.args) visit_slots(arg, on_slot);
+            break;
+        case Expr::Kind::Index:
+            visit_slots(expr.operand, on_slot);
+            for (auto& arg : expr.args) visit_slots(arg, on_slot);
+            break;
+        case Expr::Kind::ArrayLiteral:
+        case Expr::Kind::TupleLiteral:
+            for (auto& elem : expr.elements) visit_slots(elem, on_slot);
+            break;
+        case Expr::Kind::Block:
+            for (const auto& stmt : expr.statements) visit_stmt_slots(stmt, on_slot);
+            visit_slots(expr.result_expr.mutable_value(), on_slot);
+            break;
+        case Expr::Kind::Conditional:
+            visit_slots(expr.condition.mutable_value(), on_slot);
+            visit_slots(expr.true_expr.mutable_value(), on_slot);
+            visit_slots(expr.false_expr.mutable_value(), on_slot);
+            break;
+        default:
+            break;
+    }
+}
+
+// Integer value of a literal loop bound; false for anything else.
+bool literal_int(const ExprPtr& expr, int64_t& out) {
+    if (!expr || expr->kind != Expr::Kind::IntLiteral) return false;
+    if (expr->has_exact_int_val) {
+        if (!expr->exact_int_val->fits_i64()) return false;
+        out = expr->exact_int_val->to_i64();
+        return true;
+    }
+    if (expr->literal_is_unsigned && expr->uint_val > static_cast<uint64_t>(INT64_MAX)) return false;
+    out = static_cast<int64_t>(expr->uint_val);
+    return true;
+}
+
+// First value and direction of a subject that walks consecutive integers:
+// a literal range or a literal array folded from one.
+bool consecutive_subject(const ExprPtr& subject, int64_t& start, bool& ascending) {
+    if (!subject) return false;
+    if (subject->kind == Expr::Kind::Range) {
+        int64_t end = 0;
+        if (!literal_int(subject->left, start) || !literal_int(subject->right, end) || start == end) return false;
+        ascending = start < end;
+        return true;
+    }
+    if (subject->kind != Expr::Kind::ArrayLiteral || subject->elements.size() < 2) return false;
+    std::vector<int64_t> values;
+    values.reserve(subject->elements.size());
+    for (const auto& element : subject->elements) {
+        int64_t value = 0;
+        if (!literal_int(element, value)) return false;
+        values.push_back(value);
+    }
+    ascending = values[1] > values[0];
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (values[i] != (ascending ? values[i - 1] + 1 : values[i - 1] - 1)) return false;
+    }
+    start = values.front();
+    return true;
+}
+
+} // namespace
+
+struct LoopOptimizer::LoopScope {
+    const Symbol* underscore = nullptr;
+    std::unordered_set<const Symbol*> declared;
+    std::unordered_set<const Symbol*> assigned;
+    bool has_calls = false;
+    bool has_continue = false;
+    int depth = 0;
+    // Invariants hoisted for this loop, reused for equal expressions.
+    std::vector<std::pair<ExprPtr, Symbol*>> hoisted;
+};
+
+LoopOptimizer::LoopOptimizer(TypeChecker* checker) : checker(checker) {}
+
+bool LoopOptimizer::run(Module& mod) {
+    rewritten_top_level_.clear();
+    if (!checker || mod.top_level_instance_ids.size() != mod.top_level.size()) return false;
+
+    for (size_t i = 0; i < mod.top_level.size(); ++i) {
+        const StmtPtr& stmt = mod.top_level[i];
+        if (!stmt || stmt->kind != Stmt::Kind::FuncDecl || !stmt->body || stmt->is_generic) continue;
+        instance_id_ = mod.top_level_instance_ids[i];
+        function_has_nested_ = false;
+        std::function<void(const StmtPtr&)> find_nested;
+        std::function<void(const ExprPtr&)> find_nested_expr = [&](const ExprPtr& expr) {
+            for_each_expr_child(expr, find_nested_expr, find_nested);
+        };
+        find_nested = [&](const StmtPtr& child) {
+            if (!child || function_has_nested_) return;
+            if (child->kind == Stmt::Kind::FuncDecl) {
+                function_has_nested_ = true;
+                return;
+            }
+            for_each_stmt_child(child, find_nested_expr, find_nested);
+        };
+        find_nested_expr(stmt->body);
+
+        hoisted_ = 0;
+        reduced_ = 0;
+        rewrite_expr(stmt->body);
+        if (hoisted_ == 0 && reduced_ == 0) continue;
+
+        rewritten_top_level_.insert(stmt.get());
+        const Symbol* function = checker->binding_for(instance_id_, stmt.get());
+        auto index_it = rewrite_index_.find(function);
+        if (index_it == rewrite_index_.end()) {
+            index_it = rewrite_index_.emplace(function, rewrites_.size()).first;
+            rewrites_.push_back({function, 0, 0});
+        }
+        rewrites_[index_it->second].hoisted += hoisted_;
+        rewrites_[index_it->second].strength_reduced += reduced_;
+    }
+    instance_id_ = -1;
+    return !rewritten_top_level_.empty();
+}
+
+void LoopOptimizer::publish(OptimizationFacts& facts) const {
+    facts.loop_rewrites = rewrites_;
+}
+
+void LoopOptimizer::rewrite_block(const ExprPtr& block) {
+    std::vector<StmtPtr> rewritten;
+    rewritten.reserve(block->statements.size());
+    for (const auto& stmt : block->statements) {
+        std::vector<StmtPtr> prefix;
+        rewrite_stmt(stmt, prefix);
+        rewritten.insert(rewritten.end(), prefix.begin(), prefix.end());
+        rewritten.push_back(stmt);
+    }
+    if (block->result_expr) {
+        rewrite_expr(block->result_expr);
+        if (is_loop_expr(block->result_expr)) {
+            std::vector<StmtPtr> prefix;
+            optimize_loop(block->result_expr, prefix);
+            rewritten.insert(rewritten.end(), prefix.begin(), prefix.end());
+        }
+    }
+    block->statements.swap(rewritten);
+}
+
+void LoopOptimizer::rewrite_stmt(const StmtPtr& stmt, std::vector<StmtPtr>& prefix) {
+    if (!stmt) return;
+    switch (stmt->kind) {
+        case Stmt::Kind::Expr:
+            rewrite_expr(stmt->expr);
+            if (is_loop_expr(stmt->expr)) optimize_loop(stmt->expr, prefix);
+            break;
+        case Stmt::Kind::VarDecl:
+            rewrite_expr(stmt->var_init);
+            break;
+        case Stmt::Kind::Return:
+            rewrite_expr(stmt->return_expr);
+            break;
+        case Stmt::Kind::ConditionalStmt: {
+            rewrite_expr(stmt->condition);
+            // The condition may write what the loop reads, so the loop's
+            // prefix runs after it: `cond ? { prefix; loop };`.
+            std::vector<StmtPtr> guarded;
+            rewrite_stmt(stmt->true_stmt, guarded);
+            if (!guarded.empty()) {
+                const SourceLocation& loc = stmt->true_stmt->location;
+                guarded.push_back(stmt->true_stmt);
+                stmt->true_stmt = Stmt::make_expr(Expr::make_block(guarded, nullptr, loc), loc);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LoopOptimizer::rewrite_expr(const ExprPtr& expr) {
+    if (!expr) return;
+    if (expr->kind == Expr::Kind::Block) {
+        rewrite_block(expr);
+        return;
+    }
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { rewrite_expr(child); },
+        [&](const StmtPtr& child) {
+            std::vector<StmtPtr> prefix;
+            rewrite_stmt(child, prefix);
+        });
+}
+
+void LoopOptimizer::scan_loop(const ExprPtr& expr, LoopScope& scope) const {
+    if (!expr) return;
+    switch (expr->kind) {
+        case Expr::Kind::Identifier:
+            if (expr->name == "_") {
+                const Symbol* sym = checker->binding_for(instance_id_, expr.get());
+                scope.declared.insert(sym);
+                if (scope.depth == 0 && !scope.underscore) scope.underscore = sym;
+            }
+            break;
+        case Expr::Kind::Assignment:
+            if (expr->creates_new_variable) {
+                scope.declared.insert(checker->binding_for(instance_id_, expr->left.get()));
+            } else {
+                ExprPtr base = expr->left;
+                while (base && (base->kind == Expr::Kind::Index || base->kind == Expr::Kind::Member)) {
+                    base = base->operand;
+                }
+                if (base) scope.assigned.insert(checker->binding_for(instance_id_, base.get()));
+            }
+            break;
+        case Expr::Kind::Call:
+            scope.has_calls = true;
+            for (const auto& rec : expr->receivers) {
+                ExprPtr base = rec;
+                while (base && (base->kind == Expr::Kind::Index || base->kind == Expr::Kind::Member)) {
+                    base = base->operand;
+                }
+                if (base) scope.assigned.insert(checker->binding_for(instance_id_, base.get()));
+            }
+            break;
+        case Expr::Kind::Process:
+            scope.has_calls = true;
+            break;
+        default:
+            break;
+    }
+    const bool nested = is_loop_expr(expr);
+    if (nested) scope.depth++;
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { scan_loop(child, scope); },
+        [&](const StmtPtr& child) { scan_loop_stmt(child, scope); });
+    if (nested) scope.depth--;
+}
+
+void LoopOptimizer::scan_loop_stmt(const StmtPtr& stmt, LoopScope& scope) const {
+    if (!stmt) return;
+    switch (stmt->kind) {
+        case Stmt::Kind::VarDecl:
+            scope.declared.insert(checker->binding_for(instance_id_, stmt.get()));
+            break;
+        case Stmt::Kind::Continue:
+            if (scope.depth == 0) scope.has_continue = true;
+            break;
+        case Stmt::Kind::FuncDecl:
+            // Calls into a nested function can write anything it captures.
+            scope.has_calls = true;
+            return;
+        default:
+            break;
+    }
+    for_each_stmt_child(
+        stmt,
+        [&](const ExprPtr& child) { scan_loop(child, scope); },
+        [&](const StmtPtr& child) { scan_loop_stmt(child, scope); });
+}
+
+bool LoopOptimizer::is_invariant(const ExprPtr& expr, const LoopScope& scope) const {
+    if (!expr || !is_scalar_type(expr->type)) return false;
+    switch (expr->kind) {
+        case Expr::Kind::IntLiteral:
+        case Expr::Kind::FloatLiteral:
+        case Expr::Kind::CharLiteral:
+            return true;
+        case Expr::Kind::Identifier: {
+            if (expr->is_expr_param_ref) return false;
+            const Symbol* sym = checker->binding_for(instance_id_, expr.get());
+            if (!sym || (sym->kind != Symbol::Kind::Variable && sym->kind != Symbol::Kind::Constant) ||
+                sym->is_external || sym->is_backend_bound || sym->is_resource_binding) {
+                return false;
+            }
+            if (scope.declared.count(sym) || scope.assigned.count(sym)) return false;
+            // Calls may write globals, and through nested functions any
+            // captured local.
+            return !(scope.has_calls && sym->is_mutable && (!sym->is_local || function_has_nested_));
+        }
+        case Expr::Kind::Binary:
+            return is_hoistable_binary_op(expr->binary_op) && is_invariant(expr->left, scope) &&
+                   is_invariant(expr->right, scope);
+        case Expr::Kind::Unary:
+            return expr->unary_op != UnaryOp::Other && is_invariant(expr->operand, scope);
+        case Expr::Kind::Cast:
+            // Float-to-integer conversion of an out-of-range value traps on
+            // some targets.
+            return expr->operand && is_scalar_type(expr->operand->type) &&
+                   !(is_float_type(expr->operand->type) && !is_float_type(expr->type)) &&
+                   is_invariant(expr->operand, scope);
+        default:
+            return false;
+    }
+}
+
+namespace {
+
+bool same_invariant(const ExprPtr& a, const ExprPtr& b, const TypeChecker& checker, int instance_id) {
+    if (!a || !b) return a == b;
+    if (a->kind != b->kind || !same_type(a->type, b->type)) return false;
+    switch (a->kind) {
+        case Expr::Kind::IntLiteral:
+        case Expr::Kind::CharLiteral:
+            return a->uint_val == b->uint_val && a->has_exact_int_val == b->has_exact_int_val &&
+                   (!a->has_exact_int_val || a->exact_int_val == b->exact_int_val);
+        case Expr::Kind::FloatLiteral:
+            return std::memcmp(&a->float_val, &b->float_val, sizeof(a->float_val)) == 0;
+        case Expr::Kind::Identifier:
+            return checker.binding_for(instance_id, a.get()) == checker.binding_for(instance_id, b.get());
+        case Expr::Kind::Binary:
+            return a->same_op(*b) && same_invariant(a->left, b->left, checker, instance_id) &&
+                   same_invariant(a->right, b->right, checker, instance_id);
+        case Expr::Kind::Unary:
+            return a->same_op(*b) && same_invariant(a->operand, b->operand, checker, instance_id);
+        case Expr::Kind::Cast:
+            return same_invariant(a->operand, b->operand, checker, instance_id);
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+void LoopOptimizer::hoist_invariants(ExprPtr& expr, LoopScope& scope, std::vector<StmtPtr>& prefix) {
+    auto on_slot = [&](ExprPtr& slot) {
+        bool saw_binary = false;
+        bool saw_read = false;
+        if (!has_binary_read(slot, saw_binary, saw_read) || !is_invariant(slot, scope)) return true;
+        Symbol* local = nullptr;
+        for (const auto& entry : scope.hoisted) {
+            if (same_invariant(entry.first, slot, *checker, instance_id_)) local = entry.second;
+        }
+        if (!local) {
+            StmtPtr decl = checker->declare_synthesized_local(fresh_name("inv"), slot, false, instance_id_);
+            if (!decl) return false;
+            local = checker->binding_for(instance_id_, decl->expr->left.get());
+            hoisted_decls_.insert(decl.get());
+            prefix.push_back(decl);
+            scope.hoisted.emplace_back(slot, local);
+        }
+        slot = checker->make_symbol_reference(local, instance_id_, slot->location);
+        hoisted_++;
+        return false;
+    };
+    visit_slots(expr, on_slot);
+}
+
+void LoopOptimizer::hoist_invariants(const StmtPtr& stmt, LoopScope& scope, std::vector<StmtPtr>& prefix) {
+    auto on_stmt = [&](ExprPtr& slot) {
+        hoist_invariants(slot, scope, prefix);
+        return false;
+    };
+    visit_stmt_slots(stmt, on_stmt);
+}
+
+void LoopOptimizer::optimize_loop(const ExprPtr& loop, std::vector<StmtPtr>& prefix) {
+    LoopScope scope;
+    scan_loop(loop_subject(loop), scope);
+    scan_loop(loop_body(loop), scope);
+    ExprPtr& body = loop_body_ref(loop);
+
+    // Locals hoisted out of inner loops move on when this loop does not
+    // change them either.
+    if (body && body->kind == Expr::Kind::Block) {
+        std::vector<StmtPtr> kept;
+        kept.reserve(body->statements.size());
+        for (const auto& stmt : body->statements) {
+            if (hoisted_decls_.count(stmt.get()) && is_invariant(stmt->expr->right, scope)) {
+                scope.declared.erase(checker->binding_for(instance_id_, stmt->expr->left.get()));
+                prefix.push_back(stmt);
+                continue;
+            }
+            kept.push_back(stmt);
+        }
+        body->statements.swap(kept);
+    }
+
+    if (loop->kind == Expr::Kind::Repeat) {
+        hoist_invariants(loop_subject_ref(loop), scope, prefix);
+    }
+    hoist_invariants(body, scope, prefix);
+    reduce_strength(loop, scope, prefix);
+}
+
+void LoopOptimizer::reduce_strength(const ExprPtr& loop, LoopScope& scope, std::vector<StmtPtr>& prefix) {
+    if (loop->kind != Expr::Kind::Iteration || loop->is_sorted_iteration || !scope.underscore ||
+        scope.has_continue || !is_integer_type(scope.underscore->type)) {
+        return;
+    }
+    ExprPtr& body = loop_body_ref(loop);
+    int64_t start = 0;
+    bool ascending = true;
+    if (!body || body->kind != Expr::Kind::Block || !consecutive_subject(loop_subject(loop), start, ascending)) {
+        return;
+    }
+    const TypePtr& type = scope.underscore->type;
+
+    // `_ * c` and `c * _` products, grouped by multiplier.
+    struct Product {
+        ExprPtr multiplier;
+        std::vector<ExprPtr*> slots;
+    };
+    std::vector<Product> products;
+    auto on_slot = [&](ExprPtr& slot) {
+        if (slot->kind != Expr::Kind::Binary || slot->binary_op != BinaryOp::Mul || !same_type(slot->type, type)) return true;
+        auto is_underscore = [&](const ExprPtr& side) {
+            return side && side->kind == Expr::Kind::Identifier &&
+                   checker->binding_for(instance_id_, side.get()) == scope.underscore;
+        };
+        ExprPtr multiplier;
+        if (is_underscore(slot->left)) multiplier = slot->right;
+        else if (is_underscore(slot->right)) multiplier = slot->left;
+        if (!multiplier || !same_type(multiplier->type, type) ||
+            (multiplier->kind != Expr::Kind::IntLiteral && multiplier->kind != Expr::Kind::Identifier) ||
+            !is_invariant(multiplier, scope)) {
+            return true;
+        }
+        for (auto& product : products) {
+            if (same_invariant(product.multiplier, multiplier, *checker, instance_id_)) {
+                product.slots.push_back(&slot);
+                return false;
+            }
+        }
+        products.push_back({multiplier, {&slot}});
+        return false;
+    };
+    visit_slots(body, on_slot);
+    if (products.empty()) return;
+
+    if (body->result_expr) {
+        body->statements.push_back(Stmt::make_expr(body->result_expr, body->result_expr->location));
+        body->result_expr = nullptr;
+    }
+    auto copy_multiplier = [&](const ExprPtr& multiplier) {
+        if (multiplier->kind == Expr::Kind::Identifier) {
+            return checker->make_symbol_reference(checker->binding_for(instance_id_, multiplier.get()), instance_id_,
+                                                  multiplier->location);
+        }
+        return make_ast_node<Expr>(*multiplier);
+    };
+    for (const auto& product : products) {
+        const SourceLocation& loc = product.multiplier->location;
+        ExprPtr first = Expr::make_int(start, loc);
+        first->type = type;
+        ExprPtr init = Expr::make_binary("*", first, copy_multiplier(product.multiplier), loc);
+        init->type = type;
+        StmtPtr decl = checker->declare_synthesized_local(fresh_name("ind"), init, true, instance_id_);
+        if (!decl) return;
+        Symbol* local = checker->binding_for(instance_id_, decl->expr->left.get());
+        prefix.push_back(decl);
+
+        for (ExprPtr* slot : product.slots) {
+            *slot = checker->make_symbol_reference(local, instance_id_, (*slot)->location);
+        }
+        reduced_ += product.slots.size();
+
+        ExprPtr step = Expr::make_binary(ascending ? "+" : "-", checker->make_symbol_reference(local, instance_id_, loc),
+                                         copy_multiplier(product.multiplier), loc);
+        step->type = type;
+        ExprPtr advance = Expr::make_assignment(checker->make_symbol_reference(local, instance_id_, loc), step, loc);
+        advance->type = type;
+        body->statements.push_back(Stmt::make_expr(advance, loc));
+    }
+}
+
+std::string LoopOptimizer::fresh_name(const char* stem) {
+    return std::string(stem) + "__lp" + std::to_string(next_local_++);
+}
+
+} // namespace vexel
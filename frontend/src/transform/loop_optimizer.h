@@ -0,0 +1,64 @@
+#pragma once
+#include "ast.h"
+#include "optimizer.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vexel {
+
+class TypeChecker;
+
+// Runtime-loop rewrites at the residual fixpoint, once nothing else folds:
+// - pure, non-trapping loop-invariant subexpressions of `Iteration` and
+//   `Repeat` bodies (and repeat conditions) move to immutable locals declared
+//   ahead of the loop; locals hoisted out of an inner loop move further out
+//   when they are invariant in the enclosing loop too,
+// - `_ * c` with `c` invariant, in loops over consecutive integer ranges,
+//   becomes an induction local stepped by `c` at the end of each pass.
+// Invariance is syntactic: a read is invariant when its symbol is neither
+// declared nor assigned in the loop, and calls in the loop make mutable
+// globals (and locals that nested functions can capture) variant.
+class LoopOptimizer {
+public:
+    explicit LoopOptimizer(TypeChecker* checker);
+
+    // True when a loop was rewritten.
+    bool run(Module& mod);
+
+    // Function statements rewritten by the last run().
+    const std::unordered_set<const Stmt*>& rewritten_top_level() const { return rewritten_top_level_; }
+
+    // Records per-function rewrite counts in `facts`.
+    void publish(OptimizationFacts& facts) const;
+
+private:
+    struct LoopScope;
+
+    TypeChecker* checker;
+    std::unordered_set<const Stmt*> rewritten_top_level_;
+    std::unordered_set<const Stmt*> hoisted_decls_;
+    std::vector<OptimizationFacts::LoopRewrite> rewrites_;
+    std::unordered_map<const Symbol*, size_t> rewrite_index_;
+    int instance_id_ = -1;
+    bool function_has_nested_ = false;
+    size_t hoisted_ = 0;
+    size_t reduced_ = 0;
+    size_t next_local_ = 0;
+
+    void rewrite_block(const ExprPtr& block);
+    void rewrite_stmt(const StmtPtr& stmt, std::vector<StmtPtr>& prefix);
+    void rewrite_expr(const ExprPtr& expr);
+    void optimize_loop(const ExprPtr& loop, std::vector<StmtPtr>& prefix);
+
+    void scan_loop(const ExprPtr& expr, LoopScope& scope) const;
+    void scan_loop_stmt(const StmtPtr& stmt, LoopScope& scope) const;
+    bool is_invariant(const ExprPtr& expr, const LoopScope& scope) const;
+    void hoist_invariants(ExprPtr& expr, LoopScope& scope, std::vector<StmtPtr>& prefix);
+    void hoist_invariants(const StmtPtr& stmt, LoopScope& scope, std::vector<StmtPtr>& prefix);
+    void reduce_strength(const ExprPtr& loop, LoopScope& scope, std::vector<StmtPtr>& prefix);
+    std::string fresh_name(const char* stem);
+};
+
+} // namespace vexel
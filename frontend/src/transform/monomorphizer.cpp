@@ -3,6 +3,9 @@
 #include "program.h"
 #include "typechecker.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 namespace vexel {
 
 Monomorphizer::Monomorphizer(TypeChecker* checker)
@@ -10,22 +13,27 @@ Monomorphizer::Monomorphizer(TypeChecker* checker)
 
 namespace {
 
-void append_unique_stmt(std::vector<StmtPtr>& stmts,
-                        std::vector<int>* instance_ids,
-                        const StmtPtr& stmt,
-                        int instance_id) {
-    if (!stmt) return;
-    for (size_t i = 0; i < stmts.size(); ++i) {
-        const auto& existing = stmts[i];
-        if (existing.get() == stmt.get()) {
-            return;
-        }
+// Top-level statements in order, with hashed membership so appending stays
+// linear in the number of instantiations.
+class TopLevelAppender {
+public:
+    TopLevelAppender(std::vector<StmtPtr>& stmts, std::vector<int>* instance_ids)
+        : stmts_(stmts), instance_ids_(instance_ids) {
+        members_.reserve(stmts.size());
+        for (const auto& stmt : stmts) members_.insert(stmt.get());
     }
-    stmts.push_back(stmt);
-    if (instance_ids) {
-        instance_ids->push_back(instance_id);
+
+    void append(const StmtPtr& stmt, int instance_id) {
+        if (!stmt || !members_.insert(stmt.get()).second) return;
+        stmts_.push_back(stmt);
+        if (instance_ids_) instance_ids_->push_back(instance_id);
     }
-}
+
+private:
+    std::vector<StmtPtr>& stmts_;
+    std::vector<int>* instance_ids_;
+    std::unordered_set<const Stmt*> members_;
+};
 
 } // namespace
 
@@ -33,47 +41,47 @@ void Monomorphizer::run(Module& mod) {
     if (!checker) return;
     Program* program = checker->get_program();
 
+    TopLevelAppender merged(mod.top_level, mod.top_level_instance_ids.empty() ? nullptr : &mod.top_level_instance_ids);
+    std::unordered_map<int, TopLevelAppender> module_top_levels;
+
     // Invariant: monomorphization only materializes instantiations recorded by the type checker.
     auto& pending = checker->get_pending_instantiations();
     while (!pending.empty()) {
-        std::vector<StmtPtr> batch;
+        std::vector<PendingInstantiation> batch;
         batch.swap(pending);
         for (auto& inst : batch) {
+            const StmtPtr& decl = inst.declaration;
             const Symbol* generated_sym = nullptr;
             int generated_instance_id = -1;
             if (program) {
-                for (const auto& instance : program->instances) {
-                    Symbol* sym = checker->binding_for(instance.id, inst.get());
-                    if (sym) {
-                        generated_sym = sym;
-                        generated_instance_id = sym->instance_id;
-                        break;
-                    }
-                }
-
+                generated_sym = inst.symbol;
                 if (!generated_sym) {
                     throw CompileError("Internal error: missing symbol for monomorphized function",
-                                       inst ? inst->location : SourceLocation());
+                                       decl ? decl->location : SourceLocation());
                 }
+                generated_instance_id = inst.instance_id;
             } else if (!mod.top_level_instance_ids.empty()) {
                 throw CompileError("Internal error: monomorphizer requires Program context to append instance IDs",
-                                   inst ? inst->location : SourceLocation());
+                                   decl ? decl->location : SourceLocation());
             }
 
-            append_unique_stmt(
-                mod.top_level,
-                mod.top_level_instance_ids.empty() ? nullptr : &mod.top_level_instance_ids,
-                inst,
-                generated_instance_id);
+            if (live_functions && generated_sym && !live_functions->count(generated_sym)) continue;
+
+            merged.append(decl, generated_instance_id);
 
             if (!program) continue;
 
             ModuleInfo* mod_info = program->module(generated_sym->module_id);
             if (!mod_info) {
                 throw CompileError("Internal error: missing module for monomorphized function",
-                                   inst ? inst->location : SourceLocation());
+                                   decl ? decl->location : SourceLocation());
+            }
+            auto it = module_top_levels.find(generated_sym->module_id);
+            if (it == module_top_levels.end()) {
+                it = module_top_levels.emplace(generated_sym->module_id,
+                                               TopLevelAppender(mod_info->module.top_level, nullptr)).first;
             }
-            append_unique_stmt(mod_info->module.top_level, nullptr, inst, -1);
+            it->second.append(decl, -1);
         }
     }
 }
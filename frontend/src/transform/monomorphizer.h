@@ -1,5 +1,6 @@
 #pragma once
 #include "ast.h"
+#include "symbol_map.h"
 
 namespace vexel {
 
@@ -8,10 +9,13 @@ class TypeChecker;
 class Monomorphizer {
 public:
     explicit Monomorphizer(TypeChecker* checker);
+    // Instantiations outside `live` are dropped instead of appended.
+    void set_live_functions(const SymbolSet* live) { live_functions = live; }
     void run(Module& mod);
 
 private:
     TypeChecker* checker;
+    const SymbolSet* live_functions = nullptr;
 };
 
 } // namespace vexel
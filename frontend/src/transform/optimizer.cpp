@@ -1,10 +1,16 @@
 #include "optimizer.h"
 
 #include "cte_engine.h"
+#include "cte_profile.h"
 #include "cte_value_utils.h"
 #include "expr_access.h"
+#include "pipeline_trace.h"
+#include "thread_pool.h"
 #include "typechecker.h"
 
+#include <atomic>
+#include <exception>
+#include <memory>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -14,6 +20,22 @@ namespace vexel {
 
 namespace {
 
+// Literal nodes are never replaced by their fixpoint value.
+bool is_literal_node(const Expr* expr) {
+    if (!expr) return false;
+    switch (expr->kind) {
+        case Expr::Kind::IntLiteral:
+        case Expr::Kind::FloatLiteral:
+        case Expr::Kind::StringLiteral:
+        case Expr::Kind::CharLiteral:
+        case Expr::Kind::ArrayLiteral:
+        case Expr::Kind::TupleLiteral:
+            return true;
+        default:
+            return false;
+    }
+}
+
 // Strict semantic equality is used only where monotonic symbol promotion
 // requires value identity across fixpoint iterations.
 bool ctvalue_equal_strict(const CTValue& a, const CTValue& b) {
@@ -36,8 +58,8 @@ bool ctvalue_equal_strict(const CTValue& a, const CTValue& b) {
     if (std::holds_alternative<bool>(a)) {
         return std::get<bool>(a) == std::get<bool>(b);
     }
-    if (std::holds_alternative<std::string>(a)) {
-        return std::get<std::string>(a) == std::get<std::string>(b);
+    if (std::holds_alternative<CTString>(a)) {
+        return std::get<CTString>(a).str() == std::get<CTString>(b).str();
     }
     if (std::holds_alternative<CTNoValue>(a)) {
         return true;
@@ -62,9 +84,12 @@ bool ctvalue_equal_strict(const CTValue& a, const CTValue& b) {
         auto aa = std::get<std::shared_ptr<CTArray>>(a);
         auto ab = std::get<std::shared_ptr<CTArray>>(b);
         if (!aa || !ab) return aa == ab;
-        if (aa->elements.size() != ab->elements.size()) return false;
-        for (size_t i = 0; i < aa->elements.size(); ++i) {
-            if (!ctvalue_equal_strict(aa->elements[i], ab->elements[i])) return false;
+        if (aa == ab) return true;
+        if (aa->size() != ab->size()) return false;
+        bool packed_equal = false;
+        if (aa->compare_packed(*ab, packed_equal)) return packed_equal;
+        for (size_t i = 0; i < aa->size(); ++i) {
+            if (!ctvalue_equal_strict(aa->at(i), ab->at(i))) return false;
         }
         return true;
     }
@@ -94,8 +119,8 @@ bool ctvalue_equal_scheduler(const CTValue& a, const CTValue& b) {
     if (std::holds_alternative<bool>(a)) {
         return std::get<bool>(a) == std::get<bool>(b);
     }
-    if (std::holds_alternative<std::string>(a)) {
-        return std::get<std::string>(a) == std::get<std::string>(b);
+    if (std::holds_alternative<CTString>(a)) {
+        return std::get<CTString>(a).str() == std::get<CTString>(b).str();
     }
     if (std::holds_alternative<CTNoValue>(a)) {
         return true;
@@ -133,15 +158,19 @@ class ExprCollector {
 public:
     explicit ExprCollector(TypeChecker* checker) : type_checker_(checker) {}
 
-    void collect_module(const Module& mod) {
-        if (mod.top_level_instance_ids.size() != mod.top_level.size()) {
-            throw CompileError("Internal error: optimizer requires top-level instance IDs aligned with merged module",
-                               mod.location);
-        }
-
-        for (size_t i = 0; i < mod.top_level.size(); ++i) {
-            collect_stmt(mod.top_level[i], mod.top_level_instance_ids[i], true);
-        }
+    // Collects one merged top-level statement. Output lists are reset per call so
+    // the scheduler can own collected state per top-level entry.
+    void collect_top_level(const StmtPtr& stmt, int instance_id) {
+        all_exprs_.clear();
+        context_roots_.clear();
+        var_init_candidates_.clear();
+        global_constant_candidates_.clear();
+        condition_keys_.clear();
+        seen_expr_keys_.clear();
+        seen_context_roots_.clear();
+        function_symbols_.clear();
+        function_body_keys_.clear();
+        collect_stmt(stmt, instance_id, true);
     }
 
     const std::vector<CollectedExpr>& all_exprs() const { return all_exprs_; }
@@ -430,34 +459,59 @@ ExprPtrSet collect_root_expr_nodes(const ExprPtr& root) {
     return out;
 }
 
+
+} // namespace
+
 class CTEFixpointScheduler {
 public:
-    CTEFixpointScheduler(TypeChecker* checker, const Module& mod)
-        : type_checker_(checker), collector_(checker), cte_engine_(checker) {
-        collector_.collect_module(mod);
-        expr_enqueued_.assign(collector_.all_exprs().size(), false);
-        root_enqueued_.assign(collector_.context_roots().size(), false);
-
-        for (size_t i = 0; i < collector_.all_exprs().size(); ++i) {
-            expr_index_by_key_[collector_.all_exprs()[i].key] = i;
-        }
-        root_expr_node_sets_.reserve(collector_.context_roots().size());
-        root_expr_node_lists_.reserve(collector_.context_roots().size());
-        for (size_t i = 0; i < collector_.context_roots().size(); ++i) {
-            ExprPtrSet nodes = collect_root_expr_nodes(collector_.context_roots()[i].expr);
-            std::vector<const Expr*> node_list;
-            node_list.reserve(nodes.size());
-            for (const Expr* expr : nodes) {
-                node_list.push_back(expr);
+    explicit CTEFixpointScheduler(TypeChecker* checker, unsigned workers)
+        : type_checker_(checker), collector_(checker), cte_engine_(checker), workers_(workers == 0 ? 1 : workers) {}
+
+    // Synchronizes collected state with `mod`. Top-level statements that were
+    // not seen before, or whose pointer is in `rewritten`, are (re)collected and
+    // their roots queued; entries that disappeared are retired. Roots/expressions
+    // that read symbols defined by retired entries are re-queued as dependents.
+    void refresh(const Module& mod, const std::unordered_set<const Stmt*>* rewritten) {
+        if (mod.top_level_instance_ids.size() != mod.top_level.size()) {
+            throw CompileError("Internal error: optimizer requires top-level instance IDs aligned with merged module",
+                               mod.location);
+        }
+
+        std::vector<StmtFactKey> next_order;
+        next_order.reserve(mod.top_level.size());
+        std::unordered_set<StmtFactKey, StmtFactKeyHash> live;
+        for (size_t i = 0; i < mod.top_level.size(); ++i) {
+            StmtFactKey key = stmt_fact_key(mod.top_level_instance_ids[i], mod.top_level[i].get());
+            if (live.insert(key).second) {
+                next_order.push_back(key);
             }
-            root_expr_node_lists_.push_back(std::move(node_list));
-            root_expr_node_sets_.push_back(std::move(nodes));
-            enqueue_root(i);
         }
-        for (const auto& candidate : collector_.global_constant_candidates()) {
-            tracked_symbols_.insert(candidate.first);
-            strict_stability_keys_.insert(candidate.second);
+
+        auto is_dirty = [&](const StmtFactKey& key) {
+            return rewritten && rewritten->count(key.stmt) != 0;
+        };
+
+        std::vector<const Symbol*> invalidated_symbols;
+        for (const StmtFactKey& key : entry_order_) {
+            if (live.count(key) && !is_dirty(key)) continue;
+            auto it = entries_.find(key);
+            if (it == entries_.end()) continue;
+            retire_entry(it->second, invalidated_symbols);
+            entries_.erase(it);
         }
+
+        std::unordered_map<StmtFactKey, StmtPtr, StmtFactKeyHash> stmt_by_key;
+        for (size_t i = 0; i < mod.top_level.size(); ++i) {
+            stmt_by_key.emplace(stmt_fact_key(mod.top_level_instance_ids[i], mod.top_level[i].get()),
+                                mod.top_level[i]);
+        }
+        for (const StmtFactKey& key : next_order) {
+            if (entries_.count(key)) continue;
+            entries_.emplace(key, add_entry(stmt_by_key[key], key.instance_id));
+        }
+        entry_order_ = std::move(next_order);
+
+        enqueue_dependents(invalidated_symbols);
     }
 
     OptimizationFacts run() {
@@ -466,7 +520,6 @@ public:
             return facts;
         }
 
-        static constexpr int kMaxCteFixpointIterations = 64;
         int iter = 0;
         while (iter < kMaxCteFixpointIterations) {
             bool progressed = false;
@@ -489,21 +542,40 @@ public:
                                SourceLocation());
         }
 
-        facts.constexpr_values = stable_values_;
-
-        for (const auto& key : collector_.condition_keys()) {
+        ConstexprFactStore& store = type_checker_->constexpr_facts();
+        std::unordered_set<ExprFactKey, ExprFactKeyHash> fresh_keys;
+        for (const auto& entry : stable_values_) {
+            if (is_literal_node(entry.first.expr)) continue;
+            const CTValue* previous = store.value(entry.first);
+            if (!previous || !ctvalue_equal_strict(*previous, entry.second)) {
+                fresh_keys.insert(entry.first);
+            }
+        }
+        store.reset_fixpoint_facts();
+        for (const auto& entry : stable_values_) {
+            store.publish_value(entry.first, entry.second);
+        }
+        for (const auto& entry : condition_refs_) {
+            const ExprFactKey& key = entry.first;
             auto it = stable_values_.find(key);
             if (it == stable_values_.end()) continue;
             bool cond = false;
             if (!cte_scalar_to_bool(it->second, cond)) continue;
-            facts.constexpr_conditions[key] = cond;
+            store.publish_condition(key, cond);
         }
+        facts.constexpr_facts = &store;
 
-        for (const auto& candidate : collector_.var_init_candidates()) {
-            const StmtFactKey& stmt_key = candidate.first;
-            const ExprFactKey& expr_key = candidate.second;
-            if (stable_values_.count(expr_key)) {
-                facts.constexpr_inits.insert(stmt_key);
+        for (const StmtFactKey& entry_key : entry_order_) {
+            const TopLevelEntry& entry = entries_.at(entry_key);
+            if (!fresh_keys.empty() && entry_has_fresh_value(entry, fresh_keys)) {
+                facts.refreshed_top_level.insert(entry_key);
+            }
+            for (const auto& candidate : entry.var_init_candidates) {
+                const StmtFactKey& stmt_key = candidate.first;
+                const ExprFactKey& expr_key = candidate.second;
+                if (stable_values_.count(expr_key)) {
+                    facts.constexpr_inits.insert(stmt_key);
+                }
             }
         }
 
@@ -513,12 +585,61 @@ public:
     }
 
 private:
+    static constexpr int kMaxCteFixpointIterations = 64;
+
+    // Collected state owned by one merged top-level statement (per instance).
+    struct TopLevelEntry {
+        std::vector<size_t> roots;
+        std::vector<size_t> exprs;
+        std::vector<ExprFactKey> condition_keys;
+        std::vector<std::pair<StmtFactKey, ExprFactKey>> var_init_candidates;
+        std::vector<std::pair<const Symbol*, ExprFactKey>> global_constant_candidates;
+        std::vector<const Symbol*> function_symbols;
+        std::vector<std::pair<const Symbol*, ExprFactKey>> function_body_keys;
+    };
+
+    // Per-thread query context used when a drain runs in parallel.
+    struct QueryWorker {
+        std::unique_ptr<TypeChecker> checker;
+        std::unique_ptr<CTEEngine> engine;
+        CompileTimeEvaluator::ResolvedSymbolLog resolved_symbols;
+    };
+
     TypeChecker* type_checker_ = nullptr;
     ExprCollector collector_;
     CTEEngine cte_engine_;
+    unsigned workers_ = 1;
+    std::unique_ptr<ThreadPool> pool_;
+    std::vector<std::unique_ptr<QueryWorker>> query_workers_;
+
+    std::unordered_map<StmtFactKey, TopLevelEntry, StmtFactKeyHash> entries_;
+    std::vector<StmtFactKey> entry_order_;
+
+    // Expression/root slots are shared between entries when the same node is
+    // reachable from several top-level statements (for example array-size
+    // expressions inside shared types), so each slot is reference counted.
+    std::vector<CollectedExpr> exprs_;
+    std::vector<int> expr_refs_;
+    std::vector<CollectedExpr> roots_;
+    std::vector<int> root_refs_;
+    std::unordered_map<ExprFactKey, size_t, ExprFactKeyHash> root_index_by_key_;
+    std::unordered_map<ExprFactKey, int, ExprFactKeyHash> condition_refs_;
+
+    // Root-level dependency graph used to drain roots in topological order. A
+    // root depends on the root producing each tracked symbol it reads: the
+    // initializer of a global constant or the body of a function. Reads are the
+    // ones observed on the root's last query plus its lexical identifiers, so
+    // roots that were never queried still get ordered.
+    std::unordered_map<const Symbol*, size_t> symbol_producer_roots_;
+    std::vector<std::vector<const Symbol*>> root_produced_symbols_;
+    std::vector<std::vector<std::pair<const Symbol*, ExprFactKey>>> root_constant_candidates_;
+    std::vector<std::vector<const Symbol*>> root_lexical_symbols_;
+    std::vector<int> root_pending_pos_;
 
     std::unordered_map<ExprFactKey, CTValue, ExprFactKeyHash> stable_values_;
     std::unordered_set<ExprFactKey, ExprFactKeyHash> unstable_values_;
+    // Keys whose last query ran past the compile-time memory limit.
+    std::unordered_set<ExprFactKey, ExprFactKeyHash> memory_limited_;
     std::unordered_map<const Symbol*, CTValue> known_symbol_values_;
     std::unordered_set<const Symbol*> tracked_symbols_;
 
@@ -536,6 +657,189 @@ private:
     std::unordered_map<ExprFactKey, std::unordered_set<const Symbol*>, ExprFactKeyHash> expr_to_symbols_;
     std::unordered_set<ExprFactKey, ExprFactKeyHash> strict_stability_keys_;
 
+    bool entry_has_fresh_value(const TopLevelEntry& entry,
+                               const std::unordered_set<ExprFactKey, ExprFactKeyHash>& fresh_keys) const {
+        for (size_t root : entry.roots) {
+            if (fresh_keys.count(roots_[root].key)) return true;
+        }
+        for (size_t expr : entry.exprs) {
+            if (fresh_keys.count(exprs_[expr].key)) return true;
+        }
+        for (const ExprFactKey& key : entry.condition_keys) {
+            if (fresh_keys.count(key)) return true;
+        }
+        return false;
+    }
+
+    TopLevelEntry add_entry(const StmtPtr& stmt, int instance_id) {
+        TopLevelEntry entry;
+        collector_.collect_top_level(stmt, instance_id);
+
+        for (const CollectedExpr& item : collector_.all_exprs()) {
+            auto it = expr_index_by_key_.find(item.key);
+            if (it != expr_index_by_key_.end()) {
+                expr_refs_[it->second]++;
+                entry.exprs.push_back(it->second);
+                continue;
+            }
+            size_t idx = exprs_.size();
+            exprs_.push_back(item);
+            expr_refs_.push_back(1);
+            expr_enqueued_.push_back(false);
+            expr_index_by_key_[item.key] = idx;
+            entry.exprs.push_back(idx);
+        }
+
+        for (const CollectedExpr& item : collector_.context_roots()) {
+            auto it = root_index_by_key_.find(item.key);
+            if (it != root_index_by_key_.end()) {
+                root_refs_[it->second]++;
+                entry.roots.push_back(it->second);
+                continue;
+            }
+            size_t idx = roots_.size();
+            roots_.push_back(item);
+            root_refs_.push_back(1);
+            root_enqueued_.push_back(false);
+            root_index_by_key_[item.key] = idx;
+            ExprPtrSet nodes = collect_root_expr_nodes(item.expr);
+            std::vector<const Expr*> node_list;
+            node_list.reserve(nodes.size());
+            for (const Expr* expr : nodes) {
+                node_list.push_back(expr);
+            }
+            root_lexical_symbols_.push_back(lexical_symbols(item.instance_id, node_list));
+            root_expr_node_lists_.push_back(std::move(node_list));
+            root_expr_node_sets_.push_back(std::move(nodes));
+            root_produced_symbols_.emplace_back();
+            root_constant_candidates_.emplace_back();
+            root_pending_pos_.push_back(-1);
+            entry.roots.push_back(idx);
+            enqueue_root(idx);
+        }
+
+        for (const auto& key : collector_.condition_keys()) {
+            condition_refs_[key]++;
+            entry.condition_keys.push_back(key);
+        }
+        entry.var_init_candidates = collector_.var_init_candidates();
+        entry.global_constant_candidates = collector_.global_constant_candidates();
+        for (const auto& candidate : entry.global_constant_candidates) {
+            tracked_symbols_.insert(candidate.first);
+            strict_stability_keys_.insert(candidate.second);
+        }
+        entry.function_symbols.assign(collector_.function_symbols().begin(),
+                                      collector_.function_symbols().end());
+        for (const Symbol* sym : entry.function_symbols) {
+            // Calls report their callee through the symbol-read hook, so rewriting a
+            // function body can re-queue only the roots that executed it.
+            tracked_symbols_.insert(sym);
+        }
+        entry.function_body_keys.assign(collector_.function_body_keys().begin(),
+                                        collector_.function_body_keys().end());
+
+        CTEProfile* profile = type_checker_ ? type_checker_->get_cte_profile() : nullptr;
+        for (const auto& candidate : entry.global_constant_candidates) {
+            auto root_it = root_index_by_key_.find(candidate.second);
+            if (root_it == root_index_by_key_.end()) continue;
+            if (profile) {
+                profile->register_initializer(roots_[root_it->second].expr.get(), candidate.first);
+            }
+            set_symbol_producer(candidate.first, root_it->second);
+            root_constant_candidates_[root_it->second].push_back(candidate);
+        }
+        for (const auto& body : entry.function_body_keys) {
+            auto root_it = root_index_by_key_.find(body.second);
+            if (root_it == root_index_by_key_.end()) continue;
+            set_symbol_producer(body.first, root_it->second);
+        }
+        return entry;
+    }
+
+    void set_symbol_producer(const Symbol* sym, size_t root_idx) {
+        symbol_producer_roots_[sym] = root_idx;
+        root_produced_symbols_[root_idx].push_back(sym);
+    }
+
+    std::vector<const Symbol*> lexical_symbols(int instance_id, const std::vector<const Expr*>& nodes) const {
+        std::vector<const Symbol*> out;
+        std::unordered_set<const Symbol*> seen;
+        for (const Expr* expr : nodes) {
+            if (!expr || expr->kind != Expr::Kind::Identifier) continue;
+            const Symbol* sym = type_checker_ ? type_checker_->binding_for(instance_id, expr) : nullptr;
+            if (!sym) sym = expr->resolved_symbol;
+            if (sym && seen.insert(sym).second) {
+                out.push_back(sym);
+            }
+        }
+        return out;
+    }
+
+    void retire_entry(const TopLevelEntry& entry, std::vector<const Symbol*>& invalidated_symbols) {
+        for (size_t idx : entry.roots) {
+            if (--root_refs_[idx] == 0) {
+                retire_root(idx);
+            }
+        }
+        for (size_t idx : entry.exprs) {
+            if (--expr_refs_[idx] == 0) {
+                retire_expr(idx);
+            }
+        }
+        for (const auto& key : entry.condition_keys) {
+            auto it = condition_refs_.find(key);
+            if (it != condition_refs_.end() && --it->second == 0) {
+                condition_refs_.erase(it);
+            }
+        }
+        for (const auto& candidate : entry.global_constant_candidates) {
+            // Residualized initializers are re-promoted from scratch; keeping the old
+            // value would make a representation change look non-monotonic.
+            known_symbol_values_.erase(candidate.first);
+            invalidated_symbols.push_back(candidate.first);
+        }
+        for (const Symbol* sym : entry.function_symbols) {
+            invalidated_symbols.push_back(sym);
+        }
+    }
+
+    void retire_root(size_t idx) {
+        update_root_dependencies(idx, {});
+        root_to_symbols_.erase(idx);
+        root_index_by_key_.erase(roots_[idx].key);
+        for (const Expr* expr_node : root_expr_node_lists_[idx]) {
+            ExprFactKey key = expr_fact_key(roots_[idx].instance_id, expr_node);
+            if (expr_index_by_key_.count(key)) continue;
+            stable_values_.erase(key);
+            unstable_values_.erase(key);
+            memory_limited_.erase(key);
+        }
+        memory_limited_.erase(roots_[idx].key);
+        for (const Symbol* sym : root_produced_symbols_[idx]) {
+            auto it = symbol_producer_roots_.find(sym);
+            if (it != symbol_producer_roots_.end() && it->second == idx) {
+                symbol_producer_roots_.erase(it);
+            }
+        }
+        roots_[idx] = CollectedExpr{};
+        root_expr_node_sets_[idx].clear();
+        root_expr_node_lists_[idx].clear();
+        root_produced_symbols_[idx].clear();
+        root_constant_candidates_[idx].clear();
+        root_lexical_symbols_[idx].clear();
+    }
+
+    void retire_expr(size_t idx) {
+        const ExprFactKey key = exprs_[idx].key;
+        update_expr_dependencies(key, {});
+        expr_to_symbols_.erase(key);
+        expr_index_by_key_.erase(key);
+        stable_values_.erase(key);
+        unstable_values_.erase(key);
+        memory_limited_.erase(key);
+        exprs_[idx] = CollectedExpr{};
+    }
+
     bool values_equal_for_stability(const ExprFactKey& key,
                                     const CTValue& a,
                                     const CTValue& b) const {
@@ -614,6 +918,14 @@ private:
         old = normalized;
     }
 
+    void note_memory_limited(const ExprFactKey& key, bool exhausted) {
+        if (exhausted) {
+            memory_limited_.insert(key);
+        } else {
+            memory_limited_.erase(key);
+        }
+    }
+
     bool observe_expr_value(const ExprFactKey& key, CTValue value) {
         if (!key.expr) return false;
 
@@ -636,162 +948,431 @@ private:
         return true;
     }
 
-    bool drain_root_queue() {
+    // Outcome of one root query, computed without touching scheduler state so
+    // independent roots can run on concurrent workers.
+    struct RootQueryOutcome {
+        bool known = false;
+        bool memory_exhausted = false;
+        std::unordered_map<const Expr*, CTValue> local_stable;
+        std::unordered_set<const Expr*> local_unstable;
+        std::unordered_set<const Expr*> local_observed;
+        std::unordered_set<const Symbol*> local_symbols;
+    };
+
+    struct ExprQueryOutcome {
+        CTEQueryResult query;
+        std::unordered_set<const Symbol*> local_symbols;
+    };
+
+    RootQueryOutcome query_root(CTEEngine& engine, TypeChecker& checker, size_t root_idx) const {
+        const CollectedExpr& root = roots_[root_idx];
+        auto scope = checker.scoped_instance(root.instance_id);
+        (void)scope;
+
+        const ExprPtrSet& root_expr_nodes = root_expr_node_sets_[root_idx];
+        RootQueryOutcome out;
+
+        auto observe_local = [&](const Expr* expr_node, const CTValue& value) {
+            if (!expr_node || out.local_unstable.count(expr_node)) return;
+            out.local_observed.insert(expr_node);
+            auto it = out.local_stable.find(expr_node);
+            if (it == out.local_stable.end()) {
+                out.local_stable.emplace(expr_node, copy_ct_value(value));
+                return;
+            }
+            const ExprFactKey key = expr_fact_key(root.instance_id, expr_node);
+            if (!values_equal_for_stability(key, it->second, value)) {
+                out.local_stable.erase(it);
+                out.local_unstable.insert(expr_node);
+            }
+        };
+        CTEQueryResult query =
+            engine.query(
+                root.instance_id,
+                root.expr,
+                known_symbol_values_,
+                [&](const Expr* expr, const CTValue& value) {
+                    if (!expr) return;
+                    if (!root_expr_nodes.count(expr)) return;
+                    observe_local(expr, value);
+                },
+                [&](const Symbol* sym) {
+                    if (!sym) return;
+                    out.local_symbols.insert(sym);
+                });
+        out.known = query.status == CTEQueryStatus::Known;
+        out.memory_exhausted = query.memory_exhausted;
+        return out;
+    }
+
+    bool apply_root_outcome(size_t root_idx, RootQueryOutcome& outcome) {
         bool changed = false;
+        const CollectedExpr& root = roots_[root_idx];
+        update_root_dependencies(root_idx, outcome.local_symbols);
+        note_memory_limited(root.key, outcome.memory_exhausted);
+        if (outcome.known) {
+            for (const Expr* expr_node : outcome.local_unstable) {
+                ExprFactKey key = expr_fact_key(root.instance_id, expr_node);
+                if (stable_values_.count(key)) {
+                    stable_values_.erase(key);
+                    unstable_values_.insert(key);
+                    changed = true;
+                } else if (!unstable_values_.count(key)) {
+                    unstable_values_.insert(key);
+                    changed = true;
+                }
+            }
+            for (auto& entry : outcome.local_stable) {
+                ExprFactKey key = expr_fact_key(root.instance_id, entry.first);
+                if (observe_expr_value(key, std::move(entry.second))) {
+                    changed = true;
+                }
+            }
+        }
+
+        // Root execution can short-circuit on runtime-dependent paths.
+        // Queue only unresolved nodes from this root for targeted deferred
+        // queries instead of maintaining a full eager per-expression pass.
+        for (const Expr* expr_node : root_expr_node_lists_[root_idx]) {
+            if (!expr_node) continue;
+            ExprFactKey key = expr_fact_key(root.instance_id, expr_node);
+            if (outcome.known && outcome.local_observed.count(expr_node)) continue;
+            if (stable_values_.count(key) || unstable_values_.count(key)) continue;
+            auto idx_it = expr_index_by_key_.find(key);
+            if (idx_it == expr_index_by_key_.end()) continue;
+            if (enqueue_expr(idx_it->second)) {
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    ExprQueryOutcome query_expr(CTEEngine& engine, TypeChecker& checker, size_t expr_idx) const {
+        const CollectedExpr& item = exprs_[expr_idx];
+        auto scope = checker.scoped_instance(item.instance_id);
+        (void)scope;
+
+        ExprQueryOutcome out;
+        out.query =
+            engine.query(
+                item.instance_id,
+                item.expr,
+                known_symbol_values_,
+                {},
+                [&](const Symbol* sym) {
+                    if (!sym) return;
+                    out.local_symbols.insert(sym);
+                });
+        return out;
+    }
+
+    bool apply_expr_outcome(size_t expr_idx, ExprQueryOutcome& outcome) {
+        const ExprFactKey key = exprs_[expr_idx].key;
+        update_expr_dependencies(key, outcome.local_symbols);
+        note_memory_limited(key, outcome.query.memory_exhausted);
+        if (outcome.query.status == CTEQueryStatus::Known) {
+            return observe_expr_value(key, std::move(outcome.query.value));
+        }
+        return false;
+    }
+
+    // Runs `query(engine, checker, batch[i])` for every batch slot on the
+    // worker pool. Workers only read scheduler state; symbols they would have
+    // cached on AST nodes are applied afterwards in worker order, and the first
+    // failing slot's exception is rethrown, as the serial drain would.
+    template <typename Outcome, typename Query>
+    std::vector<Outcome> run_parallel_batch(const std::vector<size_t>& batch, Query query) {
+        ensure_query_workers();
+        std::vector<Outcome> outcomes(batch.size());
+        std::vector<std::exception_ptr> errors(batch.size());
+        std::atomic<size_t> next{0};
+        Program* program = type_checker_->get_program();
+        for (auto& worker : query_workers_) {
+            pool_->submit([&, worker_ptr = worker.get()]() {
+                std::unique_ptr<AstArenaScope> arena_scope;
+                if (program) arena_scope = std::make_unique<AstArenaScope>(program->ast_arena);
+                for (size_t i = next++; i < batch.size(); i = next++) {
+                    try {
+                        outcomes[i] = query(*worker_ptr->engine, *worker_ptr->checker, batch[i]);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                }
+            });
+        }
+        pool_->wait();
+        for (auto& worker : query_workers_) {
+            for (const auto& entry : worker->resolved_symbols) {
+                if (!entry.first->resolved_symbol) entry.first->resolved_symbol = entry.second;
+            }
+            worker->resolved_symbols.clear();
+        }
+        for (const std::exception_ptr& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+        return outcomes;
+    }
+
+    void ensure_query_workers() {
+        if (!pool_) pool_ = std::make_unique<ThreadPool>(workers_);
+        while (query_workers_.size() < workers_) {
+            auto worker = std::make_unique<QueryWorker>();
+            worker->checker = type_checker_->make_query_worker();
+            worker->engine = std::make_unique<CTEEngine>(worker->checker.get());
+            worker->engine->set_resolved_symbol_log(&worker->resolved_symbols);
+            query_workers_.push_back(std::move(worker));
+        }
+    }
+
+    bool run_batch_in_parallel(size_t batch_size) const {
+        return workers_ > 1 && batch_size >= 2;
+    }
+
+    bool drain_root_queue() {
+        std::vector<size_t> pending;
         while (!root_queue_.empty()) {
             size_t root_idx = root_queue_.front();
             root_queue_.pop();
-            if (root_idx < root_enqueued_.size()) {
-                root_enqueued_[root_idx] = false;
-            }
-            if (root_idx >= collector_.context_roots().size()) continue;
+            // Level-local iteration may already have run a queued root.
+            if (root_idx >= root_enqueued_.size() || !root_enqueued_[root_idx]) continue;
+            root_enqueued_[root_idx] = false;
+            if (root_idx >= roots_.size() || root_refs_[root_idx] == 0) continue;
+            pending.push_back(root_idx);
+        }
 
-            const CollectedExpr& root = collector_.context_roots()[root_idx];
-            auto scope = type_checker_->scoped_instance(root.instance_id);
-            (void)scope;
+        bool changed = false;
+        for (std::vector<size_t>& level : schedule_root_levels(pending)) {
+            changed |= run_root_level(std::move(level));
+        }
+        return changed;
+    }
 
-            const ExprPtrSet& root_expr_nodes = root_expr_node_sets_[root_idx];
-            const std::vector<const Expr*>& root_expr_list = root_expr_node_lists_[root_idx];
+    // Splits `pending` into topological levels of the root dependency graph
+    // restricted to `pending`: every root only depends on roots of earlier
+    // levels or of its own strongly connected component, which shares its
+    // level. Roots keep their queue order within a level.
+    std::vector<std::vector<size_t>> schedule_root_levels(const std::vector<size_t>& pending) {
+        std::vector<std::vector<size_t>> levels;
+        if (pending.empty()) return levels;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            root_pending_pos_[pending[i]] = static_cast<int>(i);
+        }
 
-            std::unordered_map<const Expr*, CTValue> local_stable;
-            std::unordered_set<const Expr*> local_unstable;
-            std::unordered_set<const Expr*> local_observed;
-            std::unordered_set<const Symbol*> local_symbols;
+        std::vector<std::vector<size_t>> deps(pending.size());
+        auto add_dep = [&](size_t from, const Symbol* sym) {
+            auto producer = symbol_producer_roots_.find(sym);
+            if (producer == symbol_producer_roots_.end()) return;
+            int pos = root_pending_pos_[producer->second];
+            if (pos >= 0) deps[from].push_back(static_cast<size_t>(pos));
+        };
+        for (size_t i = 0; i < pending.size(); ++i) {
+            for (const Symbol* sym : root_lexical_symbols_[pending[i]]) {
+                add_dep(i, sym);
+            }
+            auto observed = root_to_symbols_.find(pending[i]);
+            if (observed == root_to_symbols_.end()) continue;
+            for (const Symbol* sym : observed->second) {
+                add_dep(i, sym);
+            }
+        }
+        for (size_t root_idx : pending) {
+            root_pending_pos_[root_idx] = -1;
+        }
 
-            auto observe_local = [&](const Expr* expr_node, const CTValue& value) {
-                if (!expr_node || local_unstable.count(expr_node)) return;
-                local_observed.insert(expr_node);
-                auto it = local_stable.find(expr_node);
-                if (it == local_stable.end()) {
-                    local_stable.emplace(expr_node, copy_ct_value(value));
-                    return;
-                }
-                const ExprFactKey key = expr_fact_key(root.instance_id, expr_node);
-                if (!values_equal_for_stability(key, it->second, value)) {
-                    local_stable.erase(it);
-                    local_unstable.insert(expr_node);
+        // Iterative Tarjan. Components complete dependencies-first, so a
+        // component's level is known once all of its out-edges are.
+        constexpr size_t kUnvisited = static_cast<size_t>(-1);
+        std::vector<size_t> index(pending.size(), kUnvisited);
+        std::vector<size_t> lowlink(pending.size(), 0);
+        std::vector<size_t> component(pending.size(), kUnvisited);
+        std::vector<bool> on_stack(pending.size(), false);
+        std::vector<size_t> stack;
+        std::vector<size_t> component_level;
+        std::vector<std::pair<size_t, size_t>> frames;
+        size_t next_index = 0;
+        for (size_t start = 0; start < pending.size(); ++start) {
+            if (index[start] != kUnvisited) continue;
+            frames.push_back({start, 0});
+            while (!frames.empty()) {
+                const size_t node = frames.back().first;
+                size_t& edge = frames.back().second;
+                if (edge == 0 && index[node] == kUnvisited) {
+                    index[node] = lowlink[node] = next_index++;
+                    stack.push_back(node);
+                    on_stack[node] = true;
                 }
-            };
-            CTEQueryResult query =
-                cte_engine_.query(
-                    root.instance_id,
-                    root.expr,
-                    known_symbol_values_,
-                    [&](const Expr* expr, const CTValue& value) {
-                        if (!expr) return;
-                        if (!root_expr_nodes.count(expr)) return;
-                        observe_local(expr, value);
-                    },
-                    [&](const Symbol* sym) {
-                        if (!sym) return;
-                        local_symbols.insert(sym);
-                    });
-            update_root_dependencies(root_idx, local_symbols);
-            const bool root_known = query.status == CTEQueryStatus::Known;
-            if (root_known) {
-                for (const Expr* expr_node : local_unstable) {
-                    ExprFactKey key = expr_fact_key(root.instance_id, expr_node);
-                    if (stable_values_.count(key)) {
-                        stable_values_.erase(key);
-                        unstable_values_.insert(key);
-                        changed = true;
-                    } else if (!unstable_values_.count(key)) {
-                        unstable_values_.insert(key);
-                        changed = true;
+                if (edge < deps[node].size()) {
+                    size_t dep = deps[node][edge++];
+                    if (index[dep] == kUnvisited) {
+                        frames.push_back({dep, 0});
+                    } else if (on_stack[dep]) {
+                        lowlink[node] = std::min(lowlink[node], index[dep]);
                     }
+                    continue;
+                }
+                frames.pop_back();
+                if (!frames.empty()) {
+                    size_t parent = frames.back().first;
+                    lowlink[parent] = std::min(lowlink[parent], lowlink[node]);
+                }
+                if (lowlink[node] != index[node]) continue;
+
+                const size_t id = component_level.size();
+                std::vector<size_t> members;
+                size_t member = kUnvisited;
+                while (member != node) {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    component[member] = id;
+                    members.push_back(member);
                 }
-                for (auto& entry : local_stable) {
-                    ExprFactKey key = expr_fact_key(root.instance_id, entry.first);
-                    if (observe_expr_value(key, std::move(entry.second))) {
-                        changed = true;
+                size_t level = 0;
+                for (size_t m : members) {
+                    for (size_t dep : deps[m]) {
+                        if (component[dep] != id) level = std::max(level, component_level[component[dep]] + 1);
                     }
                 }
+                component_level.push_back(level);
             }
+        }
 
-            // Root execution can short-circuit on runtime-dependent paths.
-            // Queue only unresolved nodes from this root for targeted deferred
-            // queries instead of maintaining a full eager per-expression pass.
-            for (const Expr* expr_node : root_expr_list) {
-                if (!expr_node) continue;
-                ExprFactKey key = expr_fact_key(root.instance_id, expr_node);
-                if (root_known && local_observed.count(expr_node)) continue;
-                if (stable_values_.count(key) || unstable_values_.count(key)) continue;
-                auto idx_it = expr_index_by_key_.find(key);
-                if (idx_it == expr_index_by_key_.end()) continue;
-                if (enqueue_expr(idx_it->second)) {
-                    changed = true;
-                }
+        for (size_t i = 0; i < pending.size(); ++i) {
+            size_t level = component_level[component[i]];
+            if (levels.size() <= level) levels.resize(level + 1);
+            levels[level].push_back(pending[i]);
+        }
+        return levels;
+    }
+
+    // Queries one level, publishes the global constants it produced, and re-runs
+    // the roots of the level that read them (a cyclic component) until the
+    // level settles. Later levels then see converged inputs on their first query.
+    bool run_root_level(std::vector<size_t> level) {
+        bool changed = false;
+        for (int round = 0; !level.empty() && round < kMaxCteFixpointIterations; ++round) {
+            TraceSpan span("optimize", "cte-round");
+            changed |= query_root_batch(level);
+            changed |= drain_expr_queue();
+
+            std::vector<const Symbol*> changed_symbols;
+            changed |= promote_root_constants(level, changed_symbols);
+            if (changed_symbols.empty()) break;
+            enqueue_dependents(changed_symbols);
+            changed = true;
+
+            std::vector<size_t> again;
+            for (size_t root_idx : level) {
+                if (!root_enqueued_[root_idx]) continue;
+                root_enqueued_[root_idx] = false;
+                again.push_back(root_idx);
             }
+            level = std::move(again);
+        }
+        return changed;
+    }
+
+    bool query_root_batch(const std::vector<size_t>& batch) {
+        bool changed = false;
+        // Roots of one level only read known values of earlier levels, which
+        // stay fixed while the level runs, so its roots are independent.
+        if (run_batch_in_parallel(batch.size())) {
+            auto outcomes = run_parallel_batch<RootQueryOutcome>(
+                batch, [this](CTEEngine& engine, TypeChecker& checker, size_t idx) {
+                    return query_root(engine, checker, idx);
+                });
+            for (size_t i = 0; i < batch.size(); ++i) {
+                changed |= apply_root_outcome(batch[i], outcomes[i]);
+            }
+            return changed;
+        }
+        for (size_t root_idx : batch) {
+            RootQueryOutcome outcome = query_root(cte_engine_, *type_checker_, root_idx);
+            changed |= apply_root_outcome(root_idx, outcome);
         }
         return changed;
     }
 
     bool drain_expr_queue() {
         bool changed = false;
+        std::vector<size_t> batch;
         while (!expr_queue_.empty()) {
             size_t expr_idx = expr_queue_.front();
             expr_queue_.pop();
             if (expr_idx < expr_enqueued_.size()) {
                 expr_enqueued_[expr_idx] = false;
             }
-            if (expr_idx >= collector_.all_exprs().size()) continue;
+            if (expr_idx >= exprs_.size() || expr_refs_[expr_idx] == 0) continue;
 
-            const CollectedExpr& item = collector_.all_exprs()[expr_idx];
-            ExprFactKey key = item.key;
+            // Each queued expression only publishes its own key, so filtering
+            // before any query runs matches filtering at pop time.
+            ExprFactKey key = exprs_[expr_idx].key;
             if (stable_values_.count(key) || unstable_values_.count(key)) {
                 continue;
             }
+            batch.push_back(expr_idx);
+        }
 
-            auto scope = type_checker_->scoped_instance(item.instance_id);
-            (void)scope;
-
-            std::unordered_set<const Symbol*> local_symbols;
-            CTEQueryResult query =
-                cte_engine_.query(
-                    item.instance_id,
-                    item.expr,
-                    known_symbol_values_,
-                    {},
-                    [&](const Symbol* sym) {
-                        if (!sym) return;
-                        local_symbols.insert(sym);
-                    });
-            update_expr_dependencies(key, local_symbols);
-            if (query.status == CTEQueryStatus::Known) {
-                if (observe_expr_value(key, std::move(query.value))) {
-                    changed = true;
-                }
+        if (run_batch_in_parallel(batch.size())) {
+            auto outcomes = run_parallel_batch<ExprQueryOutcome>(
+                batch, [this](CTEEngine& engine, TypeChecker& checker, size_t idx) {
+                    return query_expr(engine, checker, idx);
+                });
+            for (size_t i = 0; i < batch.size(); ++i) {
+                changed |= apply_expr_outcome(batch[i], outcomes[i]);
             }
+            return changed;
+        }
+        for (size_t expr_idx : batch) {
+            ExprQueryOutcome outcome = query_expr(cte_engine_, *type_checker_, expr_idx);
+            changed |= apply_expr_outcome(expr_idx, outcome);
         }
         return changed;
     }
 
     bool promote_global_constants(std::vector<const Symbol*>& changed_symbols) {
         bool changed = false;
-        for (const auto& candidate : collector_.global_constant_candidates()) {
-            const Symbol* sym = candidate.first;
-            const ExprFactKey& key = candidate.second;
-            auto value_it = stable_values_.find(key);
-            if (value_it == stable_values_.end()) {
-                continue;
-            }
-
-            auto known_it = known_symbol_values_.find(sym);
-            if (known_it == known_symbol_values_.end()) {
-                known_symbol_values_[sym] = copy_ct_value(value_it->second);
-                changed_symbols.push_back(sym);
-                changed = true;
-                continue;
+        for (const StmtFactKey& entry_key : entry_order_) {
+            const TopLevelEntry& entry = entries_.at(entry_key);
+            for (const auto& candidate : entry.global_constant_candidates) {
+                changed |= promote_global_constant(candidate.first, candidate.second, changed_symbols);
             }
+        }
+        return changed;
+    }
 
-            if (!ctvalue_equal_strict(known_it->second, value_it->second)) {
-                throw CompileError("Internal error: non-monotonic compile-time value for symbol '" + sym->name + "'",
-                                   sym->declaration ? sym->declaration->location : SourceLocation());
+    bool promote_root_constants(const std::vector<size_t>& roots, std::vector<const Symbol*>& changed_symbols) {
+        bool changed = false;
+        for (size_t root_idx : roots) {
+            for (const auto& candidate : root_constant_candidates_[root_idx]) {
+                changed |= promote_global_constant(candidate.first, candidate.second, changed_symbols);
             }
         }
         return changed;
     }
 
+    bool promote_global_constant(const Symbol* sym,
+                                 const ExprFactKey& key,
+                                 std::vector<const Symbol*>& changed_symbols) {
+        auto value_it = stable_values_.find(key);
+        if (value_it == stable_values_.end()) {
+            return false;
+        }
+
+        auto known_it = known_symbol_values_.find(sym);
+        if (known_it == known_symbol_values_.end()) {
+            known_symbol_values_[sym] = copy_ct_value(value_it->second);
+            changed_symbols.push_back(sym);
+            return true;
+        }
+
+        if (!ctvalue_equal_strict(known_it->second, value_it->second)) {
+            throw CompileError("Internal error: non-monotonic compile-time value for symbol '" + sym->name + "'",
+                               sym->declaration ? sym->declaration->location : SourceLocation());
+        }
+        return false;
+    }
+
     void enqueue_dependents(const std::vector<const Symbol*>& changed_symbols) {
         for (const Symbol* sym : changed_symbols) {
             auto root_it = symbol_to_roots_.find(sym);
@@ -814,7 +1395,17 @@ private:
     }
 
     void finalize_foldable_functions(OptimizationFacts& facts) const {
-        for (const Symbol* sym : collector_.function_symbols()) {
+        std::unordered_set<const Symbol*> function_symbols;
+        std::unordered_map<const Symbol*, ExprFactKey> function_body_keys;
+        for (const StmtFactKey& entry_key : entry_order_) {
+            const TopLevelEntry& entry = entries_.at(entry_key);
+            function_symbols.insert(entry.function_symbols.begin(), entry.function_symbols.end());
+            for (const auto& body : entry.function_body_keys) {
+                function_body_keys[body.first] = body.second;
+            }
+        }
+
+        for (const Symbol* sym : function_symbols) {
             if (!sym || sym->kind != Symbol::Kind::Function || !sym->declaration) {
                 continue;
             }
@@ -832,8 +1423,8 @@ private:
                 continue;
             }
 
-            auto body_it = collector_.function_body_keys().find(sym);
-            if (body_it == collector_.function_body_keys().end()) {
+            auto body_it = function_body_keys.find(sym);
+            if (body_it == function_body_keys.end()) {
                 facts.fold_skip_reasons[sym] = "missing-body-key";
                 continue;
             }
@@ -845,7 +1436,9 @@ private:
             }
             auto value_it = stable_values_.find(body_key);
             if (value_it == stable_values_.end()) {
-                facts.fold_skip_reasons[sym] = "evaluation-failed-or-runtime-dependent";
+                facts.fold_skip_reasons[sym] = memory_limited_.count(body_key)
+                                                   ? "cte-memory-limit"
+                                                   : "evaluation-failed-or-runtime-dependent";
                 continue;
             }
             if (!is_scalar_ctvalue(value_it->second)) {
@@ -858,11 +1451,24 @@ private:
     }
 };
 
-} // namespace
+Optimizer::Optimizer(TypeChecker* tc) : type_checker(tc) {}
+
+Optimizer::~Optimizer() = default;
 
 OptimizationFacts Optimizer::run(const Module& mod) {
-    CTEFixpointScheduler scheduler(type_checker, mod);
-    return scheduler.run();
+    TraceSpan span("optimize", "cte-fixpoint");
+    scheduler_ = std::make_unique<CTEFixpointScheduler>(type_checker, parallel_workers);
+    scheduler_->refresh(mod, nullptr);
+    return scheduler_->run();
+}
+
+OptimizationFacts Optimizer::rerun(const Module& mod, const std::unordered_set<const Stmt*>& rewritten) {
+    if (!scheduler_) {
+        return run(mod);
+    }
+    TraceSpan span("optimize", "cte-fixpoint");
+    scheduler_->refresh(mod, &rewritten);
+    return scheduler_->run();
 }
 
 } // namespace vexel
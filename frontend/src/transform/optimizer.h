@@ -1,70 +1,79 @@
 #pragma once
+#include "constexpr_facts.h"
 #include "cte_value.h"
 #include "symbols.h"
+#include <memory>
+#include <optional>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace vexel {
 
 class TypeChecker;
 
-struct ExprFactKey {
-    int instance_id = -1;
-    const Expr* expr = nullptr;
-
-    bool operator==(const ExprFactKey& other) const {
-        return instance_id == other.instance_id && expr == other.expr;
-    }
-};
-
-struct ExprFactKeyHash {
-    std::size_t operator()(const ExprFactKey& key) const noexcept {
-        std::size_t h1 = std::hash<int>{}(key.instance_id);
-        std::size_t h2 = std::hash<const Expr*>{}(key.expr);
-        return h1 ^ (h2 + 0x9e3779b9ULL + (h1 << 6) + (h1 >> 2));
-    }
-};
-
-struct StmtFactKey {
-    int instance_id = -1;
-    const Stmt* stmt = nullptr;
-
-    bool operator==(const StmtFactKey& other) const {
-        return instance_id == other.instance_id && stmt == other.stmt;
-    }
-};
-
-struct StmtFactKeyHash {
-    std::size_t operator()(const StmtFactKey& key) const noexcept {
-        std::size_t h1 = std::hash<int>{}(key.instance_id);
-        std::size_t h2 = std::hash<const Stmt*>{}(key.stmt);
-        return h1 ^ (h2 + 0x9e3779b9ULL + (h1 << 6) + (h1 >> 2));
-    }
-};
-
-inline ExprFactKey expr_fact_key(int instance_id, const Expr* expr) {
-    return ExprFactKey{instance_id, expr};
-}
-
-inline StmtFactKey stmt_fact_key(int instance_id, const Stmt* stmt) {
-    return StmtFactKey{instance_id, stmt};
-}
-
 struct OptimizationFacts {
-    std::unordered_map<ExprFactKey, CTValue, ExprFactKeyHash> constexpr_values;
+    // Fixpoint values and conditions are published into the checker's fact
+    // store; null when the optimizer ran without a checker.
+    const ConstexprFactStore* constexpr_facts = nullptr;
     std::unordered_set<StmtFactKey, StmtFactKeyHash> constexpr_inits;
     std::unordered_set<const Symbol*> foldable_functions;
-    std::unordered_map<ExprFactKey, bool, ExprFactKeyHash> constexpr_conditions;
     std::unordered_map<const Symbol*, std::string> fold_skip_reasons;
+    // Clones made by the specializer, in creation order. `bindings` lists the
+    // bound parameters as `name=literal`.
+    struct Specialization {
+        const Symbol* clone = nullptr;
+        const Symbol* original = nullptr;
+        std::string bindings;
+    };
+    std::vector<Specialization> specializations;
+    // Loop rewrites per function, in the order functions were first
+    // rewritten: invariant subexpressions hoisted and `_ * c` products
+    // replaced by induction locals.
+    struct LoopRewrite {
+        const Symbol* function = nullptr;
+        size_t hoisted = 0;
+        size_t strength_reduced = 0;
+    };
+    std::vector<LoopRewrite> loop_rewrites;
+    // Top-level statements owning a fixpoint value that is new or changed
+    // since the previous (re)run, ignoring literals (they already are their
+    // value). The residualizer revisits only these.
+    std::unordered_set<StmtFactKey, StmtFactKeyHash> refreshed_top_level;
+
+    const CTValue* constexpr_value(const ExprFactKey& key) const {
+        return constexpr_facts ? constexpr_facts->value(key) : nullptr;
+    }
+    std::optional<bool> constexpr_condition(const ExprFactKey& key) const {
+        return constexpr_facts ? constexpr_facts->condition(key) : std::nullopt;
+    }
 };
 
+class CTEFixpointScheduler;
+
 class Optimizer {
 public:
-    explicit Optimizer(TypeChecker* tc) : type_checker(tc) {}
+    explicit Optimizer(TypeChecker* tc);
+    ~Optimizer();
+
+    // Full run: discards facts kept from any previous round.
     OptimizationFacts run(const Module& mod);
 
+    // Residualization round: keeps facts for untouched top-level statements and
+    // re-queues only statements in `rewritten` (by pointer), new/removed ones,
+    // and roots that read symbols they define.
+    OptimizationFacts rerun(const Module& mod, const std::unordered_set<const Stmt*>& rewritten);
+
+    // Worker threads for the fact fixpoint. Above 1, each drain of the root and
+    // expression queues is queried concurrently and merged in queue order, so
+    // facts match the serial run.
+    void set_parallel_workers(unsigned workers) { parallel_workers = workers == 0 ? 1 : workers; }
+
 private:
     TypeChecker* type_checker;
+    unsigned parallel_workers = 1;
+    std::unique_ptr<CTEFixpointScheduler> scheduler_;
 };
 
 } // namespace vexel
@@ -16,7 +16,7 @@ bool literal_to_bool(const ExprPtr& expr, bool& out) {
     switch (expr->kind) {
         case Expr::Kind::IntLiteral:
             if (expr->has_exact_int_val) {
-                out = !expr->exact_int_val.is_zero();
+                out = !expr->exact_int_val->is_zero();
             } else {
                 out = expr->uint_val != 0;
             }
@@ -63,7 +63,7 @@ bool expr_structurally_equal(const ExprPtr& a, const ExprPtr& b) {
         case Expr::Kind::Identifier:
             return a->name == b->name;
         case Expr::Kind::Unary:
-            return a->op == b->op &&
+            return a->same_op(*b) &&
                    expr_structurally_equal(a->operand, b->operand);
         case Expr::Kind::Cast:
             return a->target_type && b->target_type &&
@@ -71,7 +71,7 @@ bool expr_structurally_equal(const ExprPtr& a, const ExprPtr& b) {
                    expr_structurally_equal(a->operand, b->operand);
         case Expr::Kind::Binary:
         case Expr::Kind::Range:
-            return a->op == b->op &&
+            return a->same_op(*b) &&
                    expr_structurally_equal(a->left, b->left) &&
                    expr_structurally_equal(a->right, b->right);
         case Expr::Kind::Member:
@@ -116,15 +116,28 @@ bool reads_external_binding(const ExprPtr& expr) {
     return false;
 }
 
+bool reads_global_binding(const ExprPtr& expr) {
+    if (!expr || expr->kind != Expr::Kind::Identifier) return false;
+    const Symbol* sym = expr->resolved_symbol;
+    return sym && !sym->is_local &&
+           (sym->kind == Symbol::Kind::Variable || sym->kind == Symbol::Kind::Constant);
+}
+
 } // namespace
 
 bool Residualizer::run(Module& mod) {
-    changed_ = false;
-    rebuild_type_field_order(mod);
     if (mod.top_level_instance_ids.size() != mod.top_level.size()) {
         throw CompileError("Internal error: residualizer requires top-level instance IDs aligned with merged module",
                            mod.location);
     }
+    // Residualization never adds or removes type declarations.
+    if (!ran_) {
+        build_type_field_order(mod);
+    }
+    const bool walk_all = !ran_;
+    ran_ = true;
+    changed_ = false;
+    rewritten_top_level_.clear();
 
     std::vector<StmtPtr> rewritten;
     std::vector<int> rewritten_instance_ids;
@@ -133,7 +146,22 @@ bool Residualizer::run(Module& mod) {
 
     for (size_t i = 0; i < mod.top_level.size(); ++i) {
         current_instance_id_ = mod.top_level_instance_ids[i];
+        // One walk reaches a fixpoint for the facts it saw, so a statement
+        // whose facts did not change since the previous run stays as it is.
+        if (!walk_all &&
+            !facts_.refreshed_top_level.count(stmt_fact_key(current_instance_id_, mod.top_level[i].get()))) {
+            rewritten.push_back(mod.top_level[i]);
+            rewritten_instance_ids.push_back(current_instance_id_);
+            continue;
+        }
+        const bool changed_before = changed_;
+        changed_ = false;
         StmtPtr next = rewrite_stmt(mod.top_level[i], true);
+        if (changed_) {
+            rewritten_top_level_.insert(mod.top_level[i].get());
+            if (next) rewritten_top_level_.insert(next.get());
+        }
+        changed_ = changed_ || changed_before;
         if (!next) {
             changed_ = true;
             continue;
@@ -151,9 +179,7 @@ bool Residualizer::run(Module& mod) {
     return changed_;
 }
 
-void Residualizer::rebuild_type_field_order(const Module& mod) {
-    type_field_order_.clear();
-    type_field_types_.clear();
+void Residualizer::build_type_field_order(const Module& mod) {
     for (const auto& stmt : mod.top_level) {
         if (!stmt || stmt->kind != Stmt::Kind::TypeDecl) continue;
         std::vector<std::string> names;
@@ -174,13 +200,18 @@ StmtPtr Residualizer::rewrite_stmt(StmtPtr stmt, bool top_level) {
 
     switch (stmt->kind) {
         case Stmt::Kind::FuncDecl:
-            if (stmt->body) {
+            // A table builder's calls fold to the table; its body is left as
+            // written rather than turned into a literal nobody runs.
+            if (stmt->body && !folds_to_packed_table(stmt->body)) {
                 stmt->body = rewrite_expr(stmt->body);
             }
             return stmt;
 
         case Stmt::Kind::VarDecl:
             if (stmt->var_init) {
+                // Packed tables reach the backend as their folded value, so the
+                // initializer is not rebuilt as one literal per element.
+                if (top_level && folds_to_packed_table(stmt->var_init)) return stmt;
                 stmt->var_init = rewrite_expr(stmt->var_init);
             }
             return stmt;
@@ -231,9 +262,12 @@ ExprPtr Residualizer::rewrite_expr(ExprPtr expr, bool allow_fold) {
     if (!expr) return nullptr;
 
     if (allow_fold && can_fold_expr(expr) && !is_literal_expr_kind(expr->kind)) {
-        auto value_it = facts_.constexpr_values.find(expr_fact_key(current_instance_id_, expr.get()));
-        if (value_it != facts_.constexpr_values.end()) {
-            ExprPtr folded = ctvalue_to_expr(value_it->second, expr, expr ? expr->type : nullptr);
+        if (const CTValue* value = facts_.constexpr_value(expr_fact_key(current_instance_id_, expr.get()))) {
+            // A global table is read in place rather than copied into every use.
+            if (reads_global_binding(expr) && cte_packed_table(*value)) {
+                return expr;
+            }
+            ExprPtr folded = ctvalue_to_expr(*value, expr, expr ? expr->type : nullptr);
             if (folded) {
                 if (expr_structurally_equal(expr, folded)) {
                     return expr;
@@ -297,7 +331,7 @@ ExprPtr Residualizer::rewrite_expr(ExprPtr expr, bool allow_fold) {
             return expr;
 
         case Expr::Kind::Block:
-            rewrite_stmt_list(expr->statements, false);
+            rewrite_stmt_list(expr->statements.mutable_vector(), false);
             if (expr->result_expr) {
                 expr->result_expr = rewrite_expr(expr->result_expr);
             }
@@ -506,17 +540,17 @@ ExprPtr Residualizer::ctvalue_to_expr(const CTValue& value, const ExprPtr& origi
         result = Expr::make_uint(std::get<bool>(value) ? 1u : 0u, value_loc);
     } else if (std::holds_alternative<double>(value)) {
         result = Expr::make_float(std::get<double>(value), value_loc);
-    } else if (std::holds_alternative<std::string>(value)) {
-        result = Expr::make_string(std::get<std::string>(value), value_loc);
+    } else if (std::holds_alternative<CTString>(value)) {
+        result = Expr::make_string(std::get<CTString>(value).str(), value_loc);
     } else if (std::holds_alternative<std::shared_ptr<CTArray>>(value)) {
         auto array = std::get<std::shared_ptr<CTArray>>(value);
         if (!array) return nullptr;
 
         std::vector<ExprPtr> elems;
-        elems.reserve(array->elements.size());
+        elems.reserve(array->size());
         TypePtr elem_expected = expected_elem_type(expected_type);
-        for (const auto& elem : array->elements) {
-            ExprPtr elem_expr = ctvalue_to_expr(elem, origin, elem_expected);
+        for (size_t i = 0; i < array->size(); ++i) {
+            ExprPtr elem_expr = ctvalue_to_expr(array->at(i), origin, elem_expected);
             if (!elem_expr) {
                 return nullptr;
             }
@@ -622,7 +656,7 @@ ExprPtr Residualizer::ctvalue_to_expr(const CTValue& value, const ExprPtr& origi
             result->type = Type::make_primitive(PrimitiveType::Bool, value_loc);
         } else if (std::holds_alternative<double>(value)) {
             result->type = Type::make_primitive(PrimitiveType::F64, value_loc);
-        } else if (std::holds_alternative<std::string>(value)) {
+        } else if (std::holds_alternative<CTString>(value)) {
             result->type = Type::make_primitive(PrimitiveType::String, value_loc);
         }
     }
@@ -631,26 +665,13 @@ ExprPtr Residualizer::ctvalue_to_expr(const CTValue& value, const ExprPtr& origi
 
 std::optional<bool> Residualizer::constexpr_condition(const ExprPtr& cond, const Expr* original) const {
     if (original) {
-        auto it = facts_.constexpr_conditions.find(expr_fact_key(current_instance_id_, original));
-        if (it != facts_.constexpr_conditions.end()) {
-            return it->second;
+        if (auto fact = facts_.constexpr_condition(expr_fact_key(current_instance_id_, original))) {
+            return fact;
         }
     }
-
-    if (cond) {
-        auto it = facts_.constexpr_conditions.find(expr_fact_key(current_instance_id_, cond.get()));
-        if (it != facts_.constexpr_conditions.end()) {
-            return it->second;
-        }
-    }
-
     if (cond) {
-        auto value_it = facts_.constexpr_values.find(expr_fact_key(current_instance_id_, cond.get()));
-        if (value_it != facts_.constexpr_values.end()) {
-            bool out = false;
-            if (cte_scalar_to_bool(value_it->second, out)) {
-                return out;
-            }
+        if (auto fact = facts_.constexpr_condition(expr_fact_key(current_instance_id_, cond.get()))) {
+            return fact;
         }
     }
 
@@ -664,15 +685,20 @@ std::optional<bool> Residualizer::constexpr_condition(const ExprPtr& cond, const
 bool Residualizer::constexpr_no_value(const ExprPtr& expr, const Expr* original) const {
     auto is_no_value_fact = [&](const Expr* key_expr) -> bool {
         if (!key_expr) return false;
-        auto it = facts_.constexpr_values.find(expr_fact_key(current_instance_id_, key_expr));
-        if (it == facts_.constexpr_values.end()) return false;
-        return std::holds_alternative<CTNoValue>(it->second);
+        const CTValue* value = facts_.constexpr_value(expr_fact_key(current_instance_id_, key_expr));
+        return value && std::holds_alternative<CTNoValue>(*value);
     };
 
     if (is_no_value_fact(original)) return true;
     return is_no_value_fact(expr.get());
 }
 
+bool Residualizer::folds_to_packed_table(const ExprPtr& expr) const {
+    if (!expr || is_literal_expr_kind(expr->kind)) return false;
+    const CTValue* value = facts_.constexpr_value(expr_fact_key(current_instance_id_, expr.get()));
+    return value && cte_packed_table(*value);
+}
+
 bool Residualizer::can_fold_expr(const ExprPtr& expr) const {
     if (!expr) return false;
 
@@ -4,6 +4,7 @@
 #include "optimizer.h"
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace vexel {
@@ -13,15 +14,27 @@ namespace vexel {
 // - replace compile-time-known expressions with literals
 // - prune compile-time-known conditional branches
 // - drop dead pure expression statements
+// Packed tables (cte_packed_table) are the exception: global initializers
+// keep their value in the facts for the backend, and reads of such globals
+// stay references instead of per-use copies.
+// One residualizer follows the optimizer across fixpoint rounds: `facts` is
+// re-read on every run(), and after the first run only top-level statements
+// named in `refreshed_top_level` are walked.
 class Residualizer {
 public:
     explicit Residualizer(const OptimizationFacts& facts) : facts_(facts) {}
 
     bool run(Module& mod);
 
+    // Top-level statements (by pointer, before and after rewriting) touched by
+    // the last run(); the optimizer re-queues only these on the next round.
+    const std::unordered_set<const Stmt*>& rewritten_top_level() const { return rewritten_top_level_; }
+
 private:
     const OptimizationFacts& facts_;
     bool changed_ = false;
+    bool ran_ = false;
+    std::unordered_set<const Stmt*> rewritten_top_level_;
     int current_instance_id_ = -1;
     std::unordered_map<std::string, std::vector<std::string>> type_field_order_;
     std::unordered_map<std::string, std::unordered_map<std::string, TypePtr>> type_field_types_;
@@ -37,10 +50,11 @@ private:
     static void copy_expr_meta(const ExprPtr& from, const ExprPtr& to);
     static TypePtr expected_elem_type(TypePtr type);
     bool can_fold_expr(const ExprPtr& expr) const;
+    bool folds_to_packed_table(const ExprPtr& expr) const;
     ExprPtr ctvalue_to_expr(const CTValue& value, const ExprPtr& origin, TypePtr expected_type) const;
     std::optional<bool> constexpr_condition(const ExprPtr& cond, const Expr* original) const;
     bool constexpr_no_value(const ExprPtr& expr, const Expr* original) const;
-    void rebuild_type_field_order(const Module& mod);
+    void build_type_field_order(const Module& mod);
 };
 
 } // namespace vexel
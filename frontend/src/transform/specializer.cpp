@@ -0,0 +1,261 @@
+#include "specializer.h"
+#include "ast_walk.h"
+#include "common.h"
+#include "lowerer.h"
+#include "program.h"
+#include "typechecker.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace vexel {
+
+namespace {
+
+// Clone limits. The body bound keeps code growth proportional to the number
+// of clones; the counts bound it overall.
+constexpr size_t kMaxSpecializedBodyNodes = 256;
+constexpr size_t kMaxClonesPerFunction = 8;
+constexpr size_t kMaxSpecializations = 64;
+
+bool is_scalar_param_type(const TypePtr& type) {
+    if (!type || type->kind != Type::Kind::Primitive) return false;
+    switch (type->primitive) {
+        case PrimitiveType::Int:
+        case PrimitiveType::UInt:
+        case PrimitiveType::F32:
+        case PrimitiveType::F64:
+        case PrimitiveType::Bool:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Literal argument spelling: `key` identifies the value exactly, `text` is
+// what the report shows. False for anything but a numeric or char literal,
+// optionally negated.
+bool literal_spelling(const ExprPtr& arg, std::string& key, std::string& text) {
+    if (!arg) return false;
+    switch (arg->kind) {
+        case Expr::Kind::IntLiteral:
+        case Expr::Kind::CharLiteral: {
+            const std::string value =
+                arg->has_exact_int_val ? arg->exact_int_val->to_string() : std::to_string(arg->uint_val);
+            key = (arg->kind == Expr::Kind::CharLiteral ? "c" : "i") + value;
+            text = arg->raw_literal.empty() ? value : arg->raw_literal.str();
+            return true;
+        }
+        case Expr::Kind::FloatLiteral: {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &arg->float_val, sizeof(bits));
+            key = "f" + std::to_string(bits);
+            if (arg->raw_literal.empty()) {
+                char buf[32];
+                std::snprintf(buf, sizeof(buf), "%.17g", arg->float_val);
+                text = buf;
+            } else {
+                text = arg->raw_literal;
+            }
+            return true;
+        }
+        case Expr::Kind::Unary:
+            if (arg->unary_op != UnaryOp::Neg || !arg->operand || arg->operand->kind == Expr::Kind::Unary) return false;
+            if (!literal_spelling(arg->operand, key, text)) return false;
+            key = "-" + key;
+            text = "-" + text;
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <typename Fn>
+void walk_expr(const ExprPtr& expr, Fn& on_expr);
+
+template <typename Fn>
+void walk_stmt(const StmtPtr& stmt, Fn& on_expr) {
+    for_each_stmt_child(
+        stmt,
+        [&](const ExprPtr& child) { walk_expr(child, on_expr); },
+        [&](const StmtPtr& child) { walk_stmt(child, on_expr); });
+}
+
+// Post-order, so a call is visited after its arguments.
+template <typename Fn>
+void walk_expr(const ExprPtr& expr, Fn& on_expr) {
+    for_each_expr_child(
+        expr,
+        [&](const ExprPtr& child) { walk_expr(child, on_expr); },
+        [&](const StmtPtr& child) { walk_stmt(child, on_expr); });
+    if (expr) on_expr(expr);
+}
+
+bool reads_symbol(const ExprPtr& body, const TypeChecker& checker, int instance_id, const Symbol* sym) {
+    bool found = false;
+    auto visit = [&](const ExprPtr& expr) {
+        if (!found && expr->kind == Expr::Kind::Identifier && checker.binding_for(instance_id, expr.get()) == sym) {
+            found = true;
+        }
+    };
+    walk_expr(body, visit);
+    return found;
+}
+
+} // namespace
+
+Specializer::Specializer(TypeChecker* checker) : checker(checker) {}
+
+size_t Specializer::body_size(const Symbol* callee) {
+    auto it = body_sizes_.find(callee);
+    if (it != body_sizes_.end()) return it->second;
+    const size_t size = count_expr_nodes(callee->declaration->body, kMaxSpecializedBodyNodes);
+    body_sizes_[callee] = size;
+    return size;
+}
+
+bool Specializer::run(Module& mod) {
+    rewritten_top_level_.clear();
+    if (!checker || mod.top_level_instance_ids.size() != mod.top_level.size()) return false;
+
+    bool changed = false;
+    const std::vector<StmtPtr> functions = mod.top_level;
+    const std::vector<int> instance_ids = mod.top_level_instance_ids;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        const StmtPtr& stmt = functions[i];
+        if (!stmt || stmt->kind != Stmt::Kind::FuncDecl || !stmt->body) continue;
+        const int instance_id = instance_ids[i];
+        bool rewritten = false;
+        auto visit = [&](const ExprPtr& expr) {
+            if (expr->kind == Expr::Kind::Call && specialize_call(mod, expr, instance_id)) rewritten = true;
+        };
+        walk_expr(stmt->body, visit);
+        if (rewritten) {
+            rewritten_top_level_.insert(stmt.get());
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool Specializer::specialize_call(Module& mod, const ExprPtr& call, int instance_id) {
+    if (call->is_constructor_call || !call->receivers.empty() || !call->operand ||
+        call->operand->kind != Expr::Kind::Identifier) {
+        return false;
+    }
+    Symbol* callee = checker->binding_for(instance_id, call->operand.get());
+    if (!callee || callee->kind != Symbol::Kind::Function || callee->is_external) return false;
+    const StmtPtr& decl = callee->declaration;
+    if (!decl || decl->kind != Stmt::Kind::FuncDecl || !decl->body || decl->is_external || decl->is_generic ||
+        !decl->ref_params.empty() || !decl->type_namespace.empty() || decl->params.size() != call->args.size()) {
+        return false;
+    }
+    for (const auto& param : decl->params) {
+        if (param.is_expression_param) return false;
+    }
+
+    const int callee_instance = callee->instance_id;
+    std::vector<std::pair<size_t, ExprPtr>> bound;
+    std::string key = std::to_string(reinterpret_cast<uintptr_t>(callee));
+    std::string bindings;
+    size_t literal_args = 0;
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        std::string arg_key;
+        std::string arg_text;
+        if (!literal_spelling(call->args[i], arg_key, arg_text)) continue;
+        ++literal_args;
+        if (!is_scalar_param_type(decl->params[i].type)) continue;
+        const Symbol* param_sym = checker->binding_for(callee_instance, &decl->params[i]);
+        // A parameter the body assigns would become an immutable local that
+        // the optimizer folds through; leave it a parameter.
+        if (!param_sym || !reads_symbol(decl->body, *checker, callee_instance, param_sym) ||
+            checker->writes_symbol(decl->body, param_sym, callee_instance)) {
+            continue;
+        }
+        bound.emplace_back(i, call->args[i]);
+        key += "|" + std::to_string(i) + ":" + arg_key;
+        if (!bindings.empty()) bindings += ", ";
+        bindings += decl->params[i].name + "=" + arg_text;
+    }
+    // Calls whose every argument is known and that still did not fold are
+    // impure; a clone would only duplicate their effects.
+    if (bound.empty() || literal_args == call->args.size()) return false;
+
+    Symbol* clone = nullptr;
+    auto cached = clones_by_key_.find(key);
+    if (cached != clones_by_key_.end()) {
+        clone = cached->second;
+    } else {
+        auto origin_it = origin_.find(callee);
+        const Symbol* original = origin_it != origin_.end() ? origin_it->second : callee;
+        if (body_size(callee) > kMaxSpecializedBodyNodes) {
+            declined_[original] = "body-too-large";
+            return false;
+        }
+        if (clone_counts_[original] >= kMaxClonesPerFunction || specializations_.size() >= kMaxSpecializations) {
+            declined_[original] = "specialization-limit";
+            return false;
+        }
+
+        clone = checker->create_specialization(decl, bound, callee_instance);
+        if (!clone || !clone->declaration) {
+            throw CompileError("Internal error: specialization of " + callee->name + " has no symbol",
+                               call->location);
+        }
+        Module lowered;
+        lowered.top_level.push_back(clone->declaration);
+        Lowerer(checker).run(lowered);
+
+        // Clones follow their original (and earlier clones of it) in the
+        // module, so output order tracks the source.
+        auto anchor_it = last_clone_.find(original);
+        const Stmt* anchor = anchor_it != last_clone_.end() ? anchor_it->second : original->declaration.get();
+        auto insert_after = [&](std::vector<StmtPtr>& stmts) -> size_t {
+            size_t pos = stmts.size();
+            for (size_t i = 0; i < stmts.size(); ++i) {
+                if (stmts[i].get() == anchor) pos = i + 1;
+            }
+            stmts.insert(stmts.begin() + static_cast<std::ptrdiff_t>(pos), clone->declaration);
+            return pos;
+        };
+        const size_t pos = insert_after(mod.top_level);
+        mod.top_level_instance_ids.insert(mod.top_level_instance_ids.begin() + static_cast<std::ptrdiff_t>(pos),
+                                          callee_instance);
+        if (Program* program = checker->get_program()) {
+            if (ModuleInfo* mod_info = program->module(clone->module_id)) {
+                insert_after(mod_info->module.top_level);
+            }
+        }
+        last_clone_[original] = clone->declaration.get();
+        rewritten_top_level_.insert(clone->declaration.get());
+
+        clones_by_key_[key] = clone;
+        origin_[clone] = original;
+        clone_counts_[original]++;
+        specializations_.push_back({clone, original, bindings});
+    }
+
+    std::vector<ExprPtr> remaining;
+    size_t next_bound = 0;
+    for (size_t i = 0; i < call->args.size(); ++i) {
+        if (next_bound < bound.size() && bound[next_bound].first == i) {
+            ++next_bound;
+            continue;
+        }
+        remaining.push_back(call->args[i]);
+    }
+    call->args = std::move(remaining);
+    checker->rebind_call_target(instance_id, call, clone);
+    return true;
+}
+
+void Specializer::publish(OptimizationFacts& facts) const {
+    facts.specializations = specializations_;
+    for (const auto& entry : declined_) {
+        std::string& reason = facts.fold_skip_reasons[entry.first];
+        reason += (reason.empty() ? "" : "; ") + std::string("not-specialized: ") + entry.second;
+    }
+}
+
+} // namespace vexel
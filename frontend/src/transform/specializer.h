@@ -0,0 +1,49 @@
+#pragma once
+#include "ast.h"
+#include "optimizer.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vexel {
+
+class TypeChecker;
+
+// Partial evaluation of internal functions on constant arguments. A call that
+// passes literal scalars is redirected to a clone (`<name>_S<n>`) in which
+// those parameters are immutable locals holding the literal; the optimizer
+// then folds through them like any other constant. Clones are shared by every
+// call with the same literal tuple and are bounded in body size, per function
+// and in total. Declined candidates keep their fold-skip reason with a
+// `not-specialized: <why>` suffix.
+class Specializer {
+public:
+    explicit Specializer(TypeChecker* checker);
+
+    // One round over the function bodies present at entry; clones appended by
+    // this round are considered on the next. True when a call was redirected.
+    bool run(Module& mod);
+
+    // Caller statements rewritten and clones added by the last run().
+    const std::unordered_set<const Stmt*>& rewritten_top_level() const { return rewritten_top_level_; }
+
+    // Records specializations and declined candidates in `facts`.
+    void publish(OptimizationFacts& facts) const;
+
+private:
+    TypeChecker* checker;
+    std::unordered_set<const Stmt*> rewritten_top_level_;
+    std::unordered_map<std::string, Symbol*> clones_by_key_;
+    std::unordered_map<const Symbol*, const Symbol*> origin_;
+    std::unordered_map<const Symbol*, size_t> clone_counts_;
+    std::unordered_map<const Symbol*, const Stmt*> last_clone_;
+    std::unordered_map<const Symbol*, std::string> declined_;
+    std::vector<OptimizationFacts::Specialization> specializations_;
+    std::unordered_map<const Symbol*, size_t> body_sizes_;
+
+    bool specialize_call(Module& mod, const ExprPtr& call, int instance_id);
+    size_t body_size(const Symbol* callee);
+};
+
+} // namespace vexel
@@ -0,0 +1,111 @@
+#include "type_interner.h"
+
+#include <functional>
+
+namespace vexel {
+
+namespace {
+
+bool has_width(PrimitiveType primitive) {
+    return is_signed_int(primitive) || is_unsigned_int(primitive) ||
+           is_signed_fixed(primitive) || is_unsigned_fixed(primitive);
+}
+
+void hash_combine(size_t& hash, size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+// Literal sizes are frozen so the canonical node does not alias an AST
+// expression that later passes may rewrite.
+ExprPtr freeze_array_size(const ExprPtr& size) {
+    if (!size || size->kind != Expr::Kind::IntLiteral) return size;
+    if (size->has_exact_int_val) {
+        return Expr::make_int_exact(size->exact_int_val,
+                                    size->literal_is_unsigned,
+                                    size->location,
+                                    size->raw_literal.empty() ? size->exact_int_val->to_string()
+                                                              : size->raw_literal.str());
+    }
+    return Expr::make_uint(size->uint_val, size->location, std::to_string(size->uint_val));
+}
+
+} // namespace
+
+bool TypeInterner::Key::operator==(const Key& other) const {
+    return kind == other.kind && primitive == other.primitive &&
+           integer_bits == other.integer_bits && fractional_bits == other.fractional_bits &&
+           element == other.element && text == other.text && identity == other.identity;
+}
+
+size_t TypeInterner::KeyHash::operator()(const Key& key) const {
+    size_t hash = static_cast<size_t>(key.kind);
+    hash_combine(hash, static_cast<size_t>(key.primitive));
+    hash_combine(hash, std::hash<uint64_t>{}(key.integer_bits));
+    hash_combine(hash, std::hash<int64_t>{}(key.fractional_bits));
+    hash_combine(hash, std::hash<const void*>{}(key.element));
+    hash_combine(hash, std::hash<std::string>{}(key.text));
+    hash_combine(hash, std::hash<const void*>{}(key.identity));
+    return hash;
+}
+
+TypePtr TypeInterner::intern(TypePtr type) {
+    if (!type) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return intern_locked(type);
+}
+
+size_t TypeInterner::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return table_.size();
+}
+
+TypePtr TypeInterner::intern_locked(const TypePtr& type) {
+    if (!type) return nullptr;
+
+    Key key;
+    key.kind = type->kind;
+    TypePtr element;
+    switch (type->kind) {
+        case Type::Kind::Primitive:
+            key.primitive = type->primitive;
+            if (has_width(type->primitive)) {
+                key.integer_bits = type->integer_bits;
+                key.fractional_bits = type->fractional_bits;
+            }
+            break;
+        case Type::Kind::Array:
+            element = intern_locked(type->element_type);
+            key.element = element.get();
+            if (type->array_size && type->array_size->kind == Expr::Kind::IntLiteral) {
+                const Expr& size = *type->array_size;
+                key.text = size.has_exact_int_val
+                               ? (size.literal_is_unsigned ? "u" : "s") + size.exact_int_val->to_string()
+                               : std::to_string(size.uint_val);
+            } else {
+                key.identity = type->array_size.get();
+            }
+            break;
+        case Type::Kind::Named:
+            key.text = type->type_name;
+            break;
+        case Type::Kind::TypeVar:
+            key.text = type->var_name;
+            break;
+        case Type::Kind::TypeOf:
+            key.identity = type->typeof_expr.get();
+            break;
+    }
+
+    auto it = table_.find(key);
+    if (it != table_.end()) return it->second;
+
+    TypePtr canonical = make_ast_node<Type>(*type);
+    if (type->kind == Type::Kind::Array) {
+        canonical->element_type = element;
+        canonical->array_size = freeze_array_size(type->array_size);
+    }
+    table_.emplace(std::move(key), canonical);
+    return canonical;
+}
+
+} // namespace vexel
@@ -0,0 +1,41 @@
+#pragma once
+#include "ast.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace vexel {
+
+// Hash-consed table of instantiation signature types. Structurally identical
+// types map to one canonical node, so a signature built from interned types
+// compares and hashes by pointer. Canonical nodes are frozen copies owned by
+// the table and must not be mutated or spliced into the AST. Parallel checker
+// workers share one table, so interning is guarded by a mutex.
+class TypeInterner {
+public:
+    TypePtr intern(TypePtr type);
+    size_t size() const;
+
+private:
+    struct Key {
+        Type::Kind kind = Type::Kind::Primitive;
+        PrimitiveType primitive = PrimitiveType::Int;
+        uint64_t integer_bits = 0;
+        int64_t fractional_bits = 0;
+        const Type* element = nullptr;  // Canonical element of an array
+        std::string text;               // Named/TypeVar spelling, or a literal array size
+        const void* identity = nullptr; // typeof expression or non-literal array size
+
+        bool operator==(const Key& other) const;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    TypePtr intern_locked(const TypePtr& type);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, TypePtr, KeyHash> table_;
+};
+
+} // namespace vexel
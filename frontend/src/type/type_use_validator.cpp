@@ -1,7 +1,9 @@
 #include "type_use_validator.h"
 #include "common.h"
 #include "expr_access.h"
+#include "symbol_map.h"
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <unordered_map>
@@ -12,39 +14,51 @@ namespace vexel {
 
 namespace {
 
-bool type_is_concrete(const TypeUseContext* ctx, TypePtr type) {
-    if (!type) return false;
-    if (ctx && ctx->resolve_type) {
-        type = ctx->resolve_type(type);
+// Concreteness of each type node, memoized per validation run. Type-var
+// bindings are final once type checking is done, so a node's resolved form
+// never changes while the validator runs.
+class TypeConcreteness {
+public:
+    explicit TypeConcreteness(const TypeUseContext& ctx) : ctx_(ctx) {}
+
+    bool concrete(const TypePtr& type) { return type && (flags(type) & kConcrete); }
+    bool unresolved_integer(const TypePtr& type) { return type && (flags(type) & kUnresolvedInteger); }
+
+private:
+    static constexpr uint8_t kConcrete = 1;
+    static constexpr uint8_t kUnresolvedInteger = 2;
+
+    uint8_t flags(const TypePtr& type) {
+        auto it = flags_.find(type.get());
+        if (it != flags_.end()) return it->second;
+        const uint8_t computed = compute(type);
+        flags_.emplace(type.get(), computed);
+        return computed;
     }
-    switch (type->kind) {
-        case Type::Kind::Primitive:
-            if ((type->primitive == PrimitiveType::Int || type->primitive == PrimitiveType::UInt) &&
-                type->integer_bits == 0) {
-                return false;
-            }
-            return true;
-        case Type::Kind::TypeVar:
-            return false;
-        case Type::Kind::TypeOf:
-            return false;
-        case Type::Kind::Array:
-            return type_is_concrete(ctx, type->element_type);
-        default:
-            return true;
-    }
-}
 
-bool type_is_unresolved_integer(const TypeUseContext* ctx, TypePtr type) {
-    if (!type) return false;
-    if (ctx && ctx->resolve_type) {
-        type = ctx->resolve_type(type);
+    uint8_t compute(const TypePtr& type) {
+        TypePtr resolved = ctx_.resolve_type ? ctx_.resolve_type(type) : type;
+        if (!resolved) return 0;
+        switch (resolved->kind) {
+            case Type::Kind::Primitive:
+                if ((resolved->primitive == PrimitiveType::Int || resolved->primitive == PrimitiveType::UInt) &&
+                    resolved->integer_bits == 0) {
+                    return kUnresolvedInteger;
+                }
+                return kConcrete;
+            case Type::Kind::TypeVar:
+            case Type::Kind::TypeOf:
+                return 0;
+            case Type::Kind::Array:
+                return concrete(resolved->element_type) ? kConcrete : 0;
+            default:
+                return kConcrete;
+        }
     }
-    return type &&
-           type->kind == Type::Kind::Primitive &&
-           (type->primitive == PrimitiveType::Int || type->primitive == PrimitiveType::UInt) &&
-           type->integer_bits == 0;
-}
+
+    const TypeUseContext& ctx_;
+    std::unordered_map<const Type*, uint8_t> flags_;
+};
 
 std::string qualified_func_name(const Symbol* sym) {
     if (!sym) return "";
@@ -74,324 +88,246 @@ void for_each_call_value_arg(const Symbol* callee, ExprPtr call_expr, const ArgF
     }
 }
 
-template <typename StmtFn, typename ExprFn>
-void visit_function_body(const ExprPtr& body, bool result_required, const StmtFn& on_stmt, const ExprFn& on_expr) {
-    if (!body) return;
-    if (body->kind == Expr::Kind::Block) {
-        for (const auto& stmt : body->statements) {
-            on_stmt(stmt);
-        }
-        on_expr(body->result_expr, result_required);
-        return;
-    }
-    on_expr(body, result_required);
+// How much a walked value is needed: not at all, only when the enclosing
+// function's return value is used by some caller, or unconditionally.
+enum class Need : uint8_t { None, IfReturn, Always };
+
+Need need_if(bool required) {
+    return required ? Need::Always : Need::None;
 }
 
-struct CallCollector {
+// First type-use diagnostic of one walk. Recorded instead of thrown so a
+// single walk serves both return contexts; the caller throws it once it
+// knows whether the return value is required.
+struct PendingTypeUseError {
+    bool set = false;
+    size_t order = 0;
+    std::string message;
+    SourceLocation location;
+    ExprPtr expr;
+};
+
+// One walk over a body that does both halves of type-use validation. With
+// two needs per value it collects the calls whose results are used (phase
+// one input to the return-required fixpoint) and the first concreteness
+// error for each return context (phase two), so every body is walked once.
+struct BodyTypeUse {
     const TypeUseContext* ctx = nullptr;
+    TypeConcreteness* types = nullptr;
     int instance_id = -1;
-    bool return_required = false;
-    std::unordered_set<const Symbol*> calls;
+    Need return_need = Need::IfReturn;
+
+    std::vector<const Symbol*> calls_always;
+    std::vector<const Symbol*> calls_if_return;
+    PendingTypeUseError error_always;
+    PendingTypeUseError error_if_return;
+    size_t next_order = 0;
+
+    void walk_body(const ExprPtr& body) {
+        if (!body) return;
+        if (body->kind == Expr::Kind::Block) {
+            for (const auto& stmt : body->statements) {
+                walk_stmt(stmt);
+            }
+            walk_expr(body->result_expr, return_need, return_need);
+            return;
+        }
+        walk_expr(body, return_need, return_need);
+    }
 
-    void collect_expr(ExprPtr expr, bool value_required) {
-        if (!expr) return;
-        switch (expr->kind) {
-            case Expr::Kind::Call: {
-                if (value_required && expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
-                    const Symbol* sym = ctx && ctx->binding ? ctx->binding(instance_id, expr->operand) : nullptr;
-                    if (sym) {
-                        calls.insert(sym);
-                    }
-                }
-                for (const auto& rec : expr->receivers) {
-                    collect_expr(rec, true);
+    // Throws the first diagnostic that applies when the return value is (or
+    // is not) required.
+    void throw_first_error(bool return_required) const {
+        const PendingTypeUseError* error = error_always.set ? &error_always : nullptr;
+        if (return_required && error_if_return.set && (!error || error_if_return.order < error->order)) {
+            error = &error_if_return;
+        }
+        if (!error) return;
+        if (error->expr) {
+            if (const char* debug = std::getenv("VEXEL_DEBUG_TYPE_USE"); debug && *debug) {
+                const ExprPtr& expr = error->expr;
+                std::cerr << "Type-use debug: kind=" << static_cast<int>(expr->kind)
+                          << " type=" << (expr->type ? expr->type->to_string() : "<null>");
+                if (expr->kind == Expr::Kind::Identifier) {
+                    std::cerr << " name=" << expr->name;
                 }
-                const Symbol* callee = bound_callee(ctx, instance_id, expr);
-                for_each_call_value_arg(callee, expr, [&](size_t, ExprPtr arg) { collect_expr(arg, true); });
-                break;
+                std::cerr << " at " << expr->location.filename() << ":" << expr->location.line
+                          << ":" << expr->location.column << "\n";
             }
-            case Expr::Kind::Binary:
-                collect_expr(expr->left, true);
-                collect_expr(expr->right, true);
-                break;
-            case Expr::Kind::Unary:
-            case Expr::Kind::Cast:
-            case Expr::Kind::Length:
-                collect_expr(expr->operand, true);
-                break;
-            case Expr::Kind::Index:
-                collect_expr(expr->operand, true);
-                if (!expr->args.empty()) {
-                    collect_expr(expr->args[0], true);
-                }
-                break;
-            case Expr::Kind::Member:
-                collect_expr(expr->operand, true);
-                break;
-            case Expr::Kind::ArrayLiteral:
-            case Expr::Kind::TupleLiteral:
-                for (const auto& elem : expr->elements) {
-                    collect_expr(elem, true);
-                }
-                break;
-            case Expr::Kind::Block:
-                for (const auto& stmt : expr->statements) {
-                    collect_stmt(stmt);
-                }
-                collect_expr(expr->result_expr, value_required);
-                break;
-            case Expr::Kind::Conditional:
-                if (ctx && ctx->constexpr_condition) {
-                    auto cond = ctx->constexpr_condition(instance_id, expr->condition);
-                    if (cond.has_value()) {
-                        // Invariant: skip compile-time-dead branches to avoid requiring
-                        // concrete types for values that will never be used.
-                        collect_expr(cond.value() ? expr->true_expr : expr->false_expr, value_required);
-                        break;
-                    }
-                }
-                collect_expr(expr->condition, true);
-                collect_expr(expr->true_expr, value_required);
-                collect_expr(expr->false_expr, value_required);
-                break;
-            case Expr::Kind::Assignment:
-                collect_expr(expr->left, true);
-                collect_expr(expr->right, true);
-                break;
-            case Expr::Kind::Range:
-                collect_expr(expr->left, true);
-                collect_expr(expr->right, true);
-                break;
-            case Expr::Kind::Iteration:
-                collect_expr(loop_subject(expr), true);
-                collect_expr(loop_body(expr), false);
-                break;
-            case Expr::Kind::Repeat:
-                collect_expr(loop_subject(expr), true);
-                collect_expr(loop_body(expr), false);
-                break;
-            default:
-                break;
         }
+        throw CompileError(error->message, error->location);
     }
 
-    void collect_stmt(StmtPtr stmt) {
+    void walk_stmt(const StmtPtr& stmt) {
         if (!stmt) return;
         switch (stmt->kind) {
-            case Stmt::Kind::VarDecl:
-                collect_expr(stmt->var_init, true);
+            case Stmt::Kind::VarDecl: {
+                const bool var_concrete = types->concrete(stmt->var_type);
+                if (!var_concrete && ctx->type_strictness >= 1) {
+                    record_error(Need::Always, "Variable '" + stmt->var_name + "' requires a concrete type",
+                                 stmt->location, nullptr);
+                }
+                walk_expr(stmt->var_init, Need::Always, need_if(var_concrete));
                 break;
+            }
             case Stmt::Kind::Expr:
-                collect_expr(stmt->expr, false);
+                walk_expr(stmt->expr, Need::None, Need::None);
                 break;
             case Stmt::Kind::Return:
-                collect_expr(stmt->return_expr, return_required);
+                walk_expr(stmt->return_expr, return_need, return_need);
                 break;
             case Stmt::Kind::ConditionalStmt:
-                if (ctx && ctx->constexpr_condition) {
+                if (ctx->constexpr_condition) {
                     auto cond = ctx->constexpr_condition(instance_id, stmt->condition);
                     if (cond.has_value()) {
+                        // Invariant: compile-time-dead branches are ignored by type-use validation.
                         if (cond.value()) {
-                            collect_stmt(stmt->true_stmt);
+                            walk_stmt(stmt->true_stmt);
                         }
                         break;
                     }
                 }
-                collect_expr(stmt->condition, true);
-                collect_stmt(stmt->true_stmt);
+                walk_expr(stmt->condition, Need::Always, Need::Always);
+                walk_stmt(stmt->true_stmt);
                 break;
             default:
                 break;
         }
     }
-};
 
-struct TypeUseValidator {
-    const TypeUseContext* ctx = nullptr;
-    bool return_required = false;
-    std::string func_name;
-    int instance_id = -1;
-
-    void validate_lvalue(ExprPtr expr) {
-        if (!expr) return;
-        switch (expr->kind) {
-            case Expr::Kind::Identifier:
-                return;
-            case Expr::Kind::Member:
-                validate_expr(expr->operand, true);
-                return;
-            case Expr::Kind::Index:
-                validate_expr(expr->operand, true);
-                if (!expr->args.empty()) {
-                    validate_expr(expr->args[0], true);
-                }
-                return;
-            default:
-                validate_expr(expr, true);
-                return;
-        }
-    }
-
-    void validate_expr(ExprPtr expr, bool value_required) {
+    // `used` is how much the value feeds a caller (call collection);
+    // `checked` is how much it must have a concrete type (validation).
+    void walk_expr(const ExprPtr& expr, Need used, Need checked) {
         if (!expr) return;
         bool allow_untyped = expr->kind == Expr::Kind::ArrayLiteral && expr->elements.empty();
-        if (value_required && !expr->is_expr_param_ref && !allow_untyped) {
+        if (checked != Need::None && !expr->is_expr_param_ref && !allow_untyped) {
             if (!expr->type) {
-                throw CompileError("Expression produces no value", expr->location);
-            }
-            if (!type_is_concrete(ctx, expr->type)) {
-                if (ctx->type_strictness < 2 &&
-                    type_is_unresolved_integer(ctx, expr->type)) {
-                    // Relaxed modes allow unresolved integer flow until a concrete
-                    // type context forces representability.
-                } else {
-                    if (const char* debug = std::getenv("VEXEL_DEBUG_TYPE_USE"); debug && *debug) {
-                        std::cerr << "Type-use debug: kind=" << static_cast<int>(expr->kind)
-                                  << " type=" << (expr->type ? expr->type->to_string() : "<null>");
-                        if (expr->kind == Expr::Kind::Identifier) {
-                            std::cerr << " name=" << expr->name;
-                        }
-                        std::cerr << " at " << expr->location.filename << ":" << expr->location.line
-                                  << ":" << expr->location.column << "\n";
-                    }
-                    throw CompileError("Expression requires a concrete type", expr->location);
+                record_error(checked, "Expression produces no value", expr->location, nullptr);
+            } else if (!types->concrete(expr->type)) {
+                // Relaxed modes allow unresolved integer flow until a concrete
+                // type context forces representability.
+                if (ctx->type_strictness >= 2 || !types->unresolved_integer(expr->type)) {
+                    record_error(checked, "Expression requires a concrete type", expr->location, expr);
                 }
             }
         }
 
         switch (expr->kind) {
+            case Expr::Kind::Call: {
+                if (used != Need::None && expr->operand && expr->operand->kind == Expr::Kind::Identifier) {
+                    if (const Symbol* sym = ctx->binding ? ctx->binding(instance_id, expr->operand) : nullptr) {
+                        (used == Need::Always ? calls_always : calls_if_return).push_back(sym);
+                    }
+                }
+                for (const auto& rec : expr->receivers) {
+                    walk_expr(rec, Need::Always, Need::Always);
+                }
+                const Symbol* callee = bound_callee(ctx, instance_id, expr);
+                for_each_call_value_arg(callee, expr, [&](size_t param_index, ExprPtr arg) {
+                    const bool arg_is_unresolved = types->unresolved_integer(arg ? arg->type : nullptr);
+                    Need arg_checked = arg_is_unresolved ? checked : Need::Always;
+                    if (arg_is_unresolved && callee && callee->kind == Symbol::Kind::Function && callee->declaration &&
+                        param_index < callee->declaration->params.size()) {
+                        const TypePtr& param_type = callee->declaration->params[param_index].type;
+                        if (!param_type || !types->concrete(param_type)) {
+                            // Unresolved literal flow through unconstrained call boundaries is legal in relaxed modes.
+                            arg_checked = Need::None;
+                        }
+                    }
+                    walk_expr(arg, Need::Always, arg_checked);
+                });
+                break;
+            }
             case Expr::Kind::Binary:
-                validate_expr(expr->left, true);
-                validate_expr(expr->right, true);
+            case Expr::Kind::Range:
+                walk_expr(expr->left, Need::Always, Need::Always);
+                walk_expr(expr->right, Need::Always, Need::Always);
                 break;
             case Expr::Kind::Unary:
             case Expr::Kind::Cast:
             case Expr::Kind::Length:
-                validate_expr(expr->operand, true);
-                break;
-            case Expr::Kind::Call:
-                for (const auto& rec : expr->receivers) {
-                    validate_expr(rec, true);
-                }
-                {
-                    const Symbol* callee = bound_callee(ctx, instance_id, expr);
-                    for_each_call_value_arg(callee, expr, [&](size_t param_index, ExprPtr arg) {
-                        bool arg_value_required = true;
-                        bool arg_is_unresolved = type_is_unresolved_integer(ctx, arg ? arg->type : nullptr);
-                        if (arg_is_unresolved && !value_required) {
-                            arg_value_required = false;
-                        }
-                        if (callee && callee->kind == Symbol::Kind::Function && callee->declaration &&
-                            param_index < callee->declaration->params.size()) {
-                            TypePtr param_type = callee->declaration->params[param_index].type;
-                            bool param_allows_unresolved =
-                                !param_type || !type_is_concrete(ctx, param_type);
-                            if (param_allows_unresolved && arg_is_unresolved) {
-                                // Unresolved literal flow through unconstrained call boundaries is legal in relaxed modes.
-                                arg_value_required = false;
-                            }
-                        }
-                        validate_expr(arg, arg_value_required);
-                    });
-                }
+            case Expr::Kind::Member:
+                walk_expr(expr->operand, Need::Always, Need::Always);
                 break;
             case Expr::Kind::Index:
-                validate_expr(expr->operand, true);
+                walk_expr(expr->operand, Need::Always, Need::Always);
                 if (!expr->args.empty()) {
-                    validate_expr(expr->args[0], true);
+                    walk_expr(expr->args[0], Need::Always, Need::Always);
                 }
                 break;
-            case Expr::Kind::Member:
-                validate_expr(expr->operand, true);
-                break;
             case Expr::Kind::ArrayLiteral:
             case Expr::Kind::TupleLiteral:
                 for (const auto& elem : expr->elements) {
-                    validate_expr(elem, true);
+                    walk_expr(elem, Need::Always, Need::Always);
                 }
                 break;
             case Expr::Kind::Block:
                 for (const auto& stmt : expr->statements) {
-                    validate_stmt(stmt);
+                    walk_stmt(stmt);
                 }
-                validate_expr(expr->result_expr, value_required);
+                walk_expr(expr->result_expr, used, checked);
                 break;
             case Expr::Kind::Conditional:
-                if (ctx && ctx->constexpr_condition) {
+                if (ctx->constexpr_condition) {
                     auto cond = ctx->constexpr_condition(instance_id, expr->condition);
                     if (cond.has_value()) {
-                        // Invariant: compile-time-dead branch is ignored by type-use validation.
-                        validate_expr(cond.value() ? expr->true_expr : expr->false_expr, value_required);
+                        // Invariant: skip compile-time-dead branches to avoid requiring
+                        // concrete types for values that will never be used.
+                        walk_expr(cond.value() ? expr->true_expr : expr->false_expr, used, checked);
                         break;
                     }
                 }
-                validate_expr(expr->condition, true);
-                validate_expr(expr->true_expr, value_required);
-                validate_expr(expr->false_expr, value_required);
+                walk_expr(expr->condition, Need::Always, Need::Always);
+                walk_expr(expr->true_expr, used, checked);
+                walk_expr(expr->false_expr, used, checked);
                 break;
             case Expr::Kind::Assignment:
-                validate_lvalue(expr->left);
-                {
-                    bool rhs_required = true;
-                    TypePtr lhs_type = expr->left ? expr->left->type : nullptr;
-                    if (!type_is_concrete(ctx, lhs_type)) {
-                        rhs_required = false;
-                    }
-                    validate_expr(expr->right, rhs_required);
-                }
-                break;
-            case Expr::Kind::Range:
-                validate_expr(expr->left, true);
-                validate_expr(expr->right, true);
+                walk_lvalue(expr->left);
+                walk_expr(expr->right, Need::Always,
+                          need_if(types->concrete(expr->left ? expr->left->type : nullptr)));
                 break;
             case Expr::Kind::Iteration:
-                validate_expr(loop_subject(expr), true);
-                validate_expr(loop_body(expr), false);
-                break;
             case Expr::Kind::Repeat:
-                validate_expr(loop_subject(expr), true);
-                validate_expr(loop_body(expr), false);
+                walk_expr(loop_subject(expr), Need::Always, Need::Always);
+                walk_expr(loop_body(expr), Need::None, Need::None);
                 break;
             default:
                 break;
         }
     }
 
-    void validate_stmt(StmtPtr stmt) {
-        if (!stmt) return;
-        switch (stmt->kind) {
-            case Stmt::Kind::VarDecl:
-                if (!type_is_concrete(ctx, stmt->var_type) && ctx->type_strictness >= 1) {
-                    throw CompileError("Variable '" + stmt->var_name + "' requires a concrete type", stmt->location);
-                }
-                {
-                    bool init_required = type_is_concrete(ctx, stmt->var_type);
-                    validate_expr(stmt->var_init, init_required);
-                }
-                break;
-            case Stmt::Kind::Expr:
-                validate_expr(stmt->expr, false);
-                break;
-            case Stmt::Kind::Return:
-                validate_expr(stmt->return_expr, return_required);
-                break;
-            case Stmt::Kind::ConditionalStmt:
-                if (ctx && ctx->constexpr_condition) {
-                    auto cond = ctx->constexpr_condition(instance_id, stmt->condition);
-                    if (cond.has_value()) {
-                        if (cond.value()) {
-                            validate_stmt(stmt->true_stmt);
-                        }
-                        break;
-                    }
+    // Assignment targets: the target node itself needs no concrete type,
+    // only the values it reads.
+    void walk_lvalue(const ExprPtr& expr) {
+        if (!expr) return;
+        switch (expr->kind) {
+            case Expr::Kind::Identifier:
+                return;
+            case Expr::Kind::Member:
+                walk_expr(expr->operand, Need::Always, Need::Always);
+                return;
+            case Expr::Kind::Index:
+                walk_expr(expr->operand, Need::Always, Need::Always);
+                if (!expr->args.empty()) {
+                    walk_expr(expr->args[0], Need::Always, Need::Always);
                 }
-                validate_expr(stmt->condition, true);
-                validate_stmt(stmt->true_stmt);
-                break;
+                return;
             default:
-                break;
+                walk_expr(expr, Need::Always, Need::Always);
+                return;
         }
     }
+
+    void record_error(Need need, std::string message, const SourceLocation& location, const ExprPtr& expr) {
+        const size_t order = next_order++;
+        PendingTypeUseError& slot = need == Need::Always ? error_always : error_if_return;
+        if (slot.set) return;
+        slot.set = true;
+        slot.order = order;
+        slot.message = std::move(message);
+        slot.location = location;
+        slot.expr = expr;
+    }
 };
 
 } // namespace
@@ -402,81 +338,68 @@ void validate_type_usage(const Module& /*mod*/, const AnalysisFacts& facts, cons
     // - Only *used* values must have concrete types; unused chains are allowed.
     // - Compile-time-dead branches are ignored (via ctx.constexpr_condition).
     // - Expression-parameter arguments are treated as opaque and skipped.
-    std::unordered_map<const Symbol*, StmtPtr> functions;
+    // Reachability order (callers before their callees), so the first
+    // diagnostic does not depend on hashing.
+    TypeConcreteness types(ctx);
+    struct FunctionTypeUse {
+        const Symbol* sym = nullptr;
+        StmtPtr func;
+        BodyTypeUse body;
+    };
+    std::vector<FunctionTypeUse> functions;
+    std::unordered_map<const Symbol*, size_t> function_index;
     for (const auto& sym : facts.reachable_functions) {
         if (!sym || sym->kind != Symbol::Kind::Function || !sym->declaration) continue;
-        functions[sym] = sym->declaration;
+        FunctionTypeUse entry;
+        entry.sym = sym;
+        entry.func = sym->declaration;
+        entry.body.ctx = &ctx;
+        entry.body.types = &types;
+        entry.body.instance_id = sym->instance_id;
+        entry.body.walk_body(entry.func->body);
+        function_index.emplace(sym, functions.size());
+        functions.push_back(std::move(entry));
     }
 
-    std::unordered_map<const Symbol*, std::unordered_set<const Symbol*>> calls_always;
-    std::unordered_map<const Symbol*, std::unordered_set<const Symbol*>> calls_if_return;
-    std::unordered_set<const Symbol*> return_required;
-
-    for (const auto& pair : functions) {
-        const Symbol* sym = pair.first;
-        const StmtPtr& func = pair.second;
-        CallCollector collect_false;
-        collect_false.ctx = &ctx;
-        collect_false.instance_id = sym->instance_id;
-        collect_false.return_required = false;
-        visit_function_body(
-            func->body,
-            false,
-            [&](StmtPtr stmt) { collect_false.collect_stmt(stmt); },
-            [&](ExprPtr expr, bool required) { collect_false.collect_expr(expr, required); });
-        CallCollector collect_true;
-        collect_true.ctx = &ctx;
-        collect_true.instance_id = sym->instance_id;
-        collect_true.return_required = true;
-        visit_function_body(
-            func->body,
-            true,
-            [&](StmtPtr stmt) { collect_true.collect_stmt(stmt); },
-            [&](ExprPtr expr, bool required) { collect_true.collect_expr(expr, required); });
-
-        calls_always[sym] = collect_false.calls;
-        std::unordered_set<const Symbol*> diff;
-        for (const auto& callee : collect_true.calls) {
-            if (!collect_false.calls.count(callee)) {
-                diff.insert(callee);
-            }
+    SymbolSet return_required;
+    std::vector<const Symbol*> worklist;
+    auto require_return = [&](const Symbol* callee) {
+        if (return_required.insert(callee)) {
+            worklist.push_back(callee);
         }
-        calls_if_return[sym] = std::move(diff);
-
-        for (const auto& callee : collect_false.calls) {
-            return_required.insert(callee);
+    };
+    for (const auto& entry : functions) {
+        for (const Symbol* callee : entry.body.calls_always) {
+            require_return(callee);
         }
     }
 
+    std::vector<BodyTypeUse> globals;
     for (const auto& sym : facts.used_global_vars) {
         if (!sym || !sym->declaration) continue;
         // Invariant: used globals must have concrete types, and their initializers
         // are treated as value-required.
-        CallCollector collector;
-        collector.ctx = &ctx;
-        collector.instance_id = sym->instance_id;
-        collector.return_required = true;
-        collector.collect_expr(sym->declaration->var_init, true);
-        for (const auto& callee : collector.calls) {
-            return_required.insert(callee);
+        BodyTypeUse init;
+        init.ctx = &ctx;
+        init.types = &types;
+        init.instance_id = sym->instance_id;
+        init.return_need = Need::Always;
+        init.walk_expr(sym->declaration->var_init, Need::Always, Need::Always);
+        for (const Symbol* callee : init.calls_always) {
+            require_return(callee);
         }
+        globals.push_back(std::move(init));
     }
 
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        // Invariant: if a function's return is required, then any callee
-        // reachable only in the "return value used" context also becomes required.
-        for (const auto& key : std::vector<const Symbol*>(return_required.begin(), return_required.end())) {
-            auto it = calls_if_return.find(key);
-            if (it == calls_if_return.end()) {
-                continue;
-            }
-            for (const auto& callee : it->second) {
-                if (return_required.insert(callee).second) {
-                    changed = true;
-                }
-            }
+    // Invariant: if a function's return is required, then any callee
+    // reachable only in the "return value used" context also becomes required.
+    while (!worklist.empty()) {
+        const Symbol* sym = worklist.back();
+        worklist.pop_back();
+        auto it = function_index.find(sym);
+        if (it == function_index.end()) continue;
+        for (const Symbol* callee : functions[it->second].body.calls_if_return) {
+            require_return(callee);
         }
     }
 
@@ -484,9 +407,9 @@ void validate_type_usage(const Module& /*mod*/, const AnalysisFacts& facts, cons
     // value use or ABI boundary requires materialization. Enforce concreteness
     // at those use sites instead of rejecting declarations preemptively.
 
-    for (const auto& pair : functions) {
-        const Symbol* sym = pair.first;
-        const StmtPtr& func = pair.second;
+    for (const auto& entry : functions) {
+        const Symbol* sym = entry.sym;
+        const StmtPtr& func = entry.func;
         if (func->is_generic) {
             continue;
         }
@@ -496,10 +419,10 @@ void validate_type_usage(const Module& /*mod*/, const AnalysisFacts& facts, cons
             if (param.is_expression_param) {
                 continue;
             }
-            if (!type_is_concrete(&ctx, param.type)) {
+            if (!types.concrete(param.type)) {
                 bool allow_relaxed_unresolved =
                     ctx.type_strictness < 2 &&
-                    type_is_unresolved_integer(&ctx, param.type);
+                    types.unresolved_integer(param.type);
                 if (allow_relaxed_unresolved) {
                     continue;
                 }
@@ -517,7 +440,7 @@ void validate_type_usage(const Module& /*mod*/, const AnalysisFacts& facts, cons
             if (!ref_type && !func->type_namespace.empty() && i == 0) {
                 ref_type = Type::make_named(func->type_namespace, func->location);
             }
-            if (!type_is_concrete(&ctx, ref_type)) {
+            if (!types.concrete(ref_type)) {
                 throw CompileError("Receiver '" + func->ref_params[i] + "' in function '" +
                                    qualified_func_name(sym) + "' requires a concrete type",
                                    func->location);
@@ -526,7 +449,7 @@ void validate_type_usage(const Module& /*mod*/, const AnalysisFacts& facts, cons
 
         if (!func->return_types.empty()) {
             for (const auto& rt : func->return_types) {
-                if (!type_is_concrete(&ctx, rt)) {
+                if (!types.concrete(rt)) {
                     throw CompileError("Return type in function '" + qualified_func_name(sym) +
                                        "' requires a concrete type", func->location);
                 }
@@ -537,38 +460,23 @@ void validate_type_usage(const Module& /*mod*/, const AnalysisFacts& facts, cons
                                    "' is used but the function returns nothing",
                                    func->location);
             }
-            if (!type_is_concrete(&ctx, func->return_type)) {
+            if (!types.concrete(func->return_type)) {
                 throw CompileError("Return value of function '" + qualified_func_name(sym) +
                                    "' is used but its return type is unresolved",
                                    func->location);
             }
         }
 
-        if (!func->body) {
-            continue;
-        }
-        TypeUseValidator validator;
-        validator.ctx = &ctx;
-        validator.return_required = ret_required;
-        validator.func_name = qualified_func_name(sym);
-        validator.instance_id = sym->instance_id;
-        visit_function_body(
-            func->body,
-            ret_required,
-            [&](StmtPtr stmt) { validator.validate_stmt(stmt); },
-            [&](ExprPtr expr, bool required) { validator.validate_expr(expr, required); });
+        entry.body.throw_first_error(ret_required);
     }
 
+    size_t global_index = 0;
     for (const auto& sym : facts.used_global_vars) {
         if (!sym || !sym->declaration) continue;
-        if (!type_is_concrete(&ctx, sym->declaration->var_type)) {
+        if (!types.concrete(sym->declaration->var_type)) {
             throw CompileError("Global '" + sym->name + "' requires a concrete type", sym->declaration->location);
         }
-        TypeUseValidator validator;
-        validator.ctx = &ctx;
-        validator.return_required = true;
-        validator.instance_id = sym->instance_id;
-        validator.validate_expr(sym->declaration->var_init, true);
+        globals[global_index++].throw_first_error(true);
     }
 }
 
@@ -1,7 +1,9 @@
 #include "typechecker.h"
 #include "binding_cleanup.h"
 #include "cte_engine.h"
+#include "cte_profile.h"
 #include "expr_access.h"
+#include "pipeline_trace.h"
 #include "resolver.h"
 #include "type_use_validator.h"
 #include <algorithm>
@@ -84,6 +86,11 @@ Symbol* TypeChecker::binding_for(int instance_id, const void* node) const {
     return bindings->lookup(instance_id, node);
 }
 
+const Scope* TypeChecker::instance_scope(int instance_id) const {
+    if (resolver) return resolver->instance_scope(instance_id);
+    return instance_id == current_instance_id ? global_scope : nullptr;
+}
+
 void TypeChecker::set_current_instance(int instance_id) {
     if (current_instance_id == instance_id) {
         return;
@@ -117,7 +124,7 @@ Symbol* TypeChecker::lookup_type_global(const std::string& name) const {
     return global_scope->lookup_type(name);
 }
 
-std::vector<Symbol*> TypeChecker::lookup_functions_global(const std::string& name) const {
+SymbolSpan TypeChecker::lookup_functions_global(const std::string& name) const {
     if (resolver) {
         return resolver->lookup_functions_in_instance(current_instance_id, name);
     }
@@ -134,16 +141,20 @@ bool TypeChecker::try_evaluate_constexpr(ExprPtr expr, CTValue& out) {
     if (!cte_engine) {
         cte_engine = std::make_unique<CTEEngine>(this);
     }
-    const auto seed_values = known_constexpr_values;
-    return cte_engine->try_evaluate(current_instance_id, expr, out, seed_values);
+    return cte_engine->try_evaluate(current_instance_id, expr, out, known_constexpr_values);
+}
+
+void TypeChecker::note_cte_peak_bytes(uint64_t bytes) {
+    uint64_t seen = cte_peak_bytes->load(std::memory_order_relaxed);
+    while (bytes > seen && !cte_peak_bytes->compare_exchange_weak(seen, bytes, std::memory_order_relaxed)) {
+    }
 }
 
 CTEQueryResult TypeChecker::query_constexpr(ExprPtr expr) {
     if (!cte_engine) {
         cte_engine = std::make_unique<CTEEngine>(this);
     }
-    const auto seed_values = known_constexpr_values;
-    return cte_engine->query(current_instance_id, expr, seed_values);
+    return cte_engine->query(current_instance_id, expr, known_constexpr_values);
 }
 
 void TypeChecker::remember_constexpr_value(Symbol* sym, const CTValue& value) {
@@ -160,19 +171,26 @@ void TypeChecker::forget_all_constexpr_values() {
     known_constexpr_values.clear();
 }
 
+void TypeChecker::release_checking_state(const std::unordered_set<const void*>& live_nodes) {
+    if (bindings) {
+        bindings->retain_if([&](int, const void* node) { return live_nodes.count(node) != 0; });
+    }
+    cte_engine.reset();
+    known_constexpr_values = {};
+    checked_statements = {};
+    instantiations = {};
+    pending_instantiations = {};
+    generic_templates = {};
+    deferred_instantiations = {};
+    deferred_function_bodies = {};
+    constexpr_facts_.clear_checked_conditions();
+}
+
 unsigned long long TypeChecker::stmt_key(const Stmt* stmt) const {
     return (static_cast<unsigned long long>(static_cast<uint32_t>(current_instance_id)) << 32) ^
            static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(stmt));
 }
 
-unsigned long long TypeChecker::expr_key(int instance_id, const Expr* expr) const {
-    return (static_cast<unsigned long long>(static_cast<uint32_t>(instance_id)) << 32) ^
-           static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(expr));
-}
-
-unsigned long long TypeChecker::expr_key(const Expr* expr) const {
-    return expr_key(current_instance_id, expr);
-}
 
 void TypeChecker::replace_expr_in_place(ExprPtr target, ExprPtr replacement) {
     if (!target || !replacement) return;
@@ -197,8 +215,12 @@ void TypeChecker::replace_expr_in_place(ExprPtr target, ExprPtr replacement) {
 void TypeChecker::check_program(Program& program_in) {
     set_program(&program_in);
     checked_statements.clear();
-    constexpr_condition_cache.clear();
+    constexpr_facts_.clear_checked_conditions();
     forget_all_constexpr_values();
+    if (parallel_workers > 1 && program_in.instances.size() > 1) {
+        check_program_parallel(program_in);
+        return;
+    }
     for (const auto& instance : program_in.instances) {
         set_current_instance(instance.id);
         check_module(program_in.modules[static_cast<size_t>(instance.module_id)].module);
@@ -211,17 +233,27 @@ void TypeChecker::check_module(Module& mod) {
     // because imports/generic instantiations can append new statements.
     for (size_t i = 0; i < mod.top_level.size(); ++i) {
         StmtPtr stmt = mod.top_level[i];
+        // Functions open their own span in check_func_decl.
+        if (stmt && stmt->kind == Stmt::Kind::VarDecl) {
+            TraceSpan span("typecheck", "typecheck", stmt->var_name);
+            check_stmt(stmt);
+            continue;
+        }
         check_stmt(stmt);
     }
+    if (deferred_body_error) std::rethrow_exception(deferred_body_error);
     validate_invariants(mod);
 }
 
 void TypeChecker::check_stmt(StmtPtr stmt) {
     if (!stmt) return;
-    if (checked_statements.count(stmt_key(stmt.get()))) {
+    const unsigned long long key = stmt_key(stmt.get());
+    if (shared_checked_statements && shared_checked_statements->count(key)) {
+        return;
+    }
+    if (!checked_statements.insert(key).second) {
         return;
     }
-    checked_statements.insert(stmt_key(stmt.get()));
 
     switch (stmt->kind) {
         case Stmt::Kind::FuncDecl:
@@ -257,10 +289,8 @@ void TypeChecker::check_stmt(StmtPtr stmt) {
                                  stmt->condition ? stmt->condition->location : stmt->location,
                                  "Conditional statement");
             auto cond = constexpr_condition(stmt->condition);
-            if (stmt->condition && cond.has_value()) {
-                constexpr_condition_cache[expr_key(stmt->condition.get())] = cond.value();
-            } else if (stmt->condition) {
-                constexpr_condition_cache.erase(expr_key(stmt->condition.get()));
+            if (stmt->condition) {
+                constexpr_facts_.set_checked_condition(expr_fact_key(current_instance_id, stmt->condition.get()), cond);
             }
             if (cond.has_value()) {
                 if (cond.value()) {
@@ -284,6 +314,7 @@ void TypeChecker::check_func_decl(StmtPtr stmt) {
     if (!stmt->type_namespace.empty()) {
         func_name = stmt->type_namespace + "::" + stmt->func_name;
     }
+    TraceSpan span("typecheck", "typecheck", func_name);
 
     // Check if function is generic (has parameters without types)
     if (!stmt->is_instantiation) {
@@ -349,6 +380,28 @@ void TypeChecker::check_func_decl(StmtPtr stmt) {
         return;
     }
 
+    if (defers_function_body(stmt)) {
+        deferred_function_bodies.emplace(func_sym, current_instance_id);
+        return;
+    }
+    check_func_body(stmt);
+}
+
+// Callers see only the signature of a function whose parameter and return
+// types are all declared, so its body can wait until the function is
+// reachable. Exported and external functions are ABI surface and stay eager.
+bool TypeChecker::defers_function_body(const StmtPtr& stmt) const {
+    if (check_all || stmt->is_external || stmt->is_exported || stmt->is_instantiation || !stmt->body) {
+        return false;
+    }
+    // Parallel workers could not materialize a body another worker deferred.
+    if (parallel_workers > 1 || shared_checked_statements) {
+        return false;
+    }
+    return signature_is_concrete(*stmt);
+}
+
+void TypeChecker::check_func_body(StmtPtr stmt) {
     if (!stmt->is_external && stmt->body) {
         struct ConstexprScopeGuard {
             TypeChecker& tc;
@@ -610,6 +663,10 @@ void TypeChecker::check_var_decl(StmtPtr stmt) {
                            stmt->location);
     }
 
+    if (cte_profile && !sym->is_local && stmt->var_init) {
+        cte_profile->register_initializer(stmt->var_init.get(), sym);
+    }
+
     bool inferred_mutable = stmt->is_mutable;
     if (is_external_binding) {
         inferred_mutable = true;
@@ -753,9 +810,9 @@ void TypeChecker::validate_invariants(const Module& mod) {
             case Expr::Kind::Conditional:
                 validate_expr(expr->condition);
                 if (expr->condition) {
-                    auto it = constexpr_condition_cache.find(expr_key(expr->condition.get()));
-                    if (it != constexpr_condition_cache.end()) {
-                        if (it->second) {
+                    auto checked = constexpr_facts_.checked_condition(expr_fact_key(current_instance_id, expr->condition.get()));
+                    if (checked.has_value()) {
+                        if (checked.value()) {
                             validate_expr(expr->true_expr);
                         } else {
                             validate_expr(expr->false_expr);
@@ -865,7 +922,7 @@ void TypeChecker::validate_invariants(const Module& mod) {
                                            stmt->func_name + "'", stmt->location);
                     }
                 }
-                if (stmt->body) {
+                if (stmt->body && !deferred_function_bodies.count(lookup_binding(stmt.get()))) {
                     validate_expr(stmt->body);
                 }
                 break;
@@ -890,9 +947,9 @@ void TypeChecker::validate_invariants(const Module& mod) {
             case Stmt::Kind::ConditionalStmt:
                 validate_expr(stmt->condition);
                 if (stmt->condition) {
-                    auto it = constexpr_condition_cache.find(expr_key(stmt->condition.get()));
-                    if (it != constexpr_condition_cache.end()) {
-                        if (it->second) {
+                    auto checked = constexpr_facts_.checked_condition(expr_fact_key(current_instance_id, stmt->condition.get()));
+                    if (checked.has_value()) {
+                        if (checked.value()) {
                             validate_stmt(stmt->true_stmt);
                         }
                         break;
@@ -917,9 +974,12 @@ void TypeChecker::validate_type_usage(const Module& mod, const AnalysisFacts& fa
     ctx.resolve_type = [this](TypePtr type) { return resolve_type(type); };
     ctx.constexpr_condition = [this](int instance_id, ExprPtr expr) {
         if (expr) {
-            auto it = constexpr_condition_cache.find(expr_key(instance_id, expr.get()));
-            if (it != constexpr_condition_cache.end()) {
-                return std::optional<bool>(it->second);
+            const ExprFactKey key = expr_fact_key(instance_id, expr.get());
+            if (auto checked = constexpr_facts_.checked_condition(key)) {
+                return checked;
+            }
+            if (auto fixpoint = constexpr_facts_.condition(key)) {
+                return fixpoint;
             }
         }
         auto scope = scoped_instance(instance_id);
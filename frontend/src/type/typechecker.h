@@ -1,9 +1,14 @@
 #pragma once
 #include "ast.h"
 #include "bindings.h"
+#include "constexpr_facts.h"
 #include "cte_value.h"
 #include "program.h"
+#include "resource_store.h"
 #include "symbols.h"
+#include "type_interner.h"
+#include <atomic>
+#include <exception>
 #include <optional>
 #include <memory>
 #include <unordered_map>
@@ -15,21 +20,19 @@ namespace vexel {
 struct AnalysisFacts;
 class Resolver;
 class CTEEngine;
+class CTEPersistentCache;
+class CTEProfile;
+class ProcessOutputCache;
+class DirectoryCache;
 
-// Type signature for generic instantiations
+// Type signature for generic instantiations. Parameter types are interned
+// through the checker's TypeInterner, so equality and hashing are per-pointer.
 struct TypeSignature {
     std::vector<TypePtr> param_types;
 
     bool operator==(const TypeSignature& other) const {
-        if (param_types.size() != other.param_types.size()) return false;
-        for (size_t i = 0; i < param_types.size(); i++) {
-            if (!types_equal_static(param_types[i], other.param_types[i])) return false;
-        }
-        return true;
+        return param_types == other.param_types;
     }
-
-private:
-    static bool types_equal_static(TypePtr a, TypePtr b);
 };
 
 // Hash function for TypeSignature
@@ -37,13 +40,10 @@ struct TypeSignatureHash {
     size_t operator()(const TypeSignature& sig) const {
         size_t hash = 0;
         for (const auto& t : sig.param_types) {
-            hash ^= type_hash(t) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<const Type*>{}(t.get()) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
         }
         return hash;
     }
-
-private:
-    static size_t type_hash(TypePtr t);
 };
 
 // Generic instantiation record
@@ -52,6 +52,31 @@ struct GenericInstantiation {
     StmtPtr declaration;
 };
 
+// Instantiation awaiting materialization, with the symbol the resolver bound
+// it to and that symbol's instance.
+struct PendingInstantiation {
+    StmtPtr declaration;
+    Symbol* symbol = nullptr;
+    int instance_id = -1;
+};
+
+// Instantiation declared with its signature only. The body is cloned,
+// resolved and checked when the function is first found reachable.
+struct DeferredInstantiation {
+    StmtPtr generic_func;
+    std::vector<TypePtr> concrete_types;
+    int instance_id = -1;
+};
+
+// Facts about a generic declaration that every instantiation would otherwise
+// recompute. Built on first instantiation; the generic body itself is never
+// checked, so it stays a valid template for later clones.
+struct GenericTemplate {
+    // False when no annotation inside the body names a type variable; such
+    // bodies clone without consulting the substitution map.
+    bool body_mentions_type_vars = false;
+};
+
 class Resolver;
 
 class TypeChecker {
@@ -60,25 +85,56 @@ class TypeChecker {
     Program* program;
     Scope* global_scope;
     int type_var_counter;
+    std::string type_var_prefix = "T";  // Parallel workers use per-instance prefixes
+    // Type-variable ids, shared with this checker's workers so ids never clash
+    // when their tables are merged.
+    std::shared_ptr<std::atomic<int>> type_var_ids = std::make_shared<std::atomic<int>>(0);
     int loop_depth;
     int type_strictness;
-    std::unordered_map<std::string, TypePtr> type_var_bindings;
+    TypeVarTable type_vars;
 
     // Generic instantiation tracking
     std::unordered_map<std::string,
         std::unordered_map<TypeSignature, GenericInstantiation, TypeSignatureHash>> instantiations;
-    std::vector<StmtPtr> pending_instantiations;
+    std::vector<PendingInstantiation> pending_instantiations;
+    std::unordered_map<const Stmt*, GenericTemplate> generic_templates;
+    // Keyed by the declared instantiation. Not part of speculative snapshots:
+    // a rolled-back instantiation is simply never materialized.
+    std::unordered_map<const Stmt*, DeferredInstantiation> deferred_instantiations;
+    // Functions whose signature was checked but whose body waits until the
+    // function is found reachable, with the instance to check it in.
+    std::unordered_map<const Symbol*, int> deferred_function_bodies;
+    // First error from a body materialized inside a compile-time query, which
+    // reports it as a failed evaluation; check_module rethrows it.
+    std::exception_ptr deferred_body_error;
+    bool check_all = false;
+    // Shared with parallel workers so their signatures stay comparable.
+    std::shared_ptr<TypeInterner> type_interner = std::make_shared<TypeInterner>();
     // Raw pointer keys are safe here because the owning Module/AST lives for the duration of type checking.
     // If the checker ever caches across runs or reuses freed nodes, switch to stable IDs or shared_ptr keys.
     std::unordered_set<unsigned long long> checked_statements;
+    // Statements checked before a parallel wave started; read-only while
+    // worker checkers consult it.
+    const std::unordered_set<unsigned long long>* shared_checked_statements = nullptr;
+    unsigned parallel_workers = 1;
 
     std::string project_root;
     bool allow_process;
     std::unordered_map<std::string, std::vector<TypePtr>> forced_tuple_types;
     int current_instance_id = -1;
     std::unordered_map<const Symbol*, CTValue> known_constexpr_values;
-    std::unordered_map<unsigned long long, bool> constexpr_condition_cache;
+    ConstexprFactStore constexpr_facts_;
     std::unique_ptr<CTEEngine> cte_engine;
+    CTEPersistentCache* persistent_cte_cache = nullptr;
+    ProcessOutputCache* process_cache = nullptr;
+    DirectoryCache* directory_cache = nullptr;
+    uint64_t cte_step_budget = 0;
+    uint64_t cte_memory_limit = 0;
+    // Highest live value bytes any compile-time query held, shared with
+    // workers so every evaluator reports into one reading.
+    std::shared_ptr<std::atomic<uint64_t>> cte_peak_bytes = std::make_shared<std::atomic<uint64_t>>(0);
+    CTEProfile* cte_profile = nullptr;
+    ResourceStore resources;
 
 public:
     class InstanceScope {
@@ -120,6 +176,7 @@ public:
     Scope* get_scope() { return global_scope; }
     void set_resolver(Resolver* resolver);
     void set_bindings(Bindings* bindings_in);
+    const Bindings* get_bindings() const { return bindings; }
     void set_program(Program* program_in);
     Symbol* binding_for(const void* node) const { return lookup_binding(node); }
     Symbol* binding_for(int instance_id, const void* node) const;
@@ -127,6 +184,39 @@ public:
     void set_current_instance(int instance_id);
     InstanceScope scoped_instance(int instance_id) { return InstanceScope(*this, instance_id); }
     Program* get_program() const { return program; }
+    // Optional cross-build cache of pure compile-time call results (not owned).
+    void set_persistent_cte_cache(CTEPersistentCache* cache) { persistent_cte_cache = cache; }
+    CTEPersistentCache* get_persistent_cte_cache() const { return persistent_cte_cache; }
+    // Worker threads for check_program. Above 1, module instances whose imports
+    // are already checked and whose import closure declares no generics are
+    // checked concurrently; everything else keeps the serial order.
+    void set_parallel_workers(unsigned workers) { parallel_workers = workers == 0 ? 1 : workers; }
+    // By default the bodies of non-exported functions with fully declared
+    // signatures are checked only once materialize_function() finds them
+    // reachable, so unused library code costs nothing. `--check-all` checks
+    // every body up front and reports errors in unreachable code too.
+    void set_check_all(bool enabled) { check_all = enabled; }
+    // Optional dedup/cross-build cache of process-expression outputs (not owned).
+    void set_process_cache(ProcessOutputCache* cache) { process_cache = cache; }
+    // Optional listing cache for resource path resolution (not owned).
+    void set_directory_cache(DirectoryCache* cache) { directory_cache = cache; }
+    // `::path` resources read so far (the compilation's non-module inputs).
+    const ResourceStore& resource_store() const { return resources; }
+    // Steps each compile-time query may take (0 = evaluator default).
+    void set_cte_step_budget(uint64_t steps) { cte_step_budget = steps; }
+    uint64_t get_cte_step_budget() const { return cte_step_budget; }
+    // Live value bytes each compile-time query may hold (0 = evaluator default).
+    void set_cte_memory_limit(uint64_t bytes) { cte_memory_limit = bytes; }
+    uint64_t get_cte_memory_limit() const { return cte_memory_limit; }
+    void note_cte_peak_bytes(uint64_t bytes);
+    uint64_t get_cte_peak_bytes() const { return cte_peak_bytes->load(std::memory_order_relaxed); }
+    // Optional `--cte-profile` sink for compile-time evaluation counters (not owned).
+    void set_cte_profile(CTEProfile* profile) { cte_profile = profile; }
+    CTEProfile* get_cte_profile() const { return cte_profile; }
+    // Read-only checker view for a concurrent compile-time query worker after
+    // type checking. It shares bindings, scopes and caches but owns its
+    // current-instance state, so scoped_instance() on it is thread-local.
+    std::unique_ptr<TypeChecker> make_query_worker() const;
     TypePtr resolve_type(TypePtr type);
     std::optional<bool> constexpr_condition(ExprPtr expr);
     TypePtr recheck_lowered_expr(ExprPtr expr);
@@ -136,8 +226,51 @@ public:
                                             const std::vector<TypePtr>& call_types,
                                             StmtPtr generic_func,
                                             int owner_instance_id);
-    std::vector<StmtPtr>& get_pending_instantiations() { return pending_instantiations; }
+    std::vector<PendingInstantiation>& get_pending_instantiations() { return pending_instantiations; }
+    // Checks the body of a function whose body check was deferred, cloning
+    // and resolving it first for a deferred instantiation; no-op for any
+    // other function. Call before walking a function found live.
+    void materialize_function(const Symbol* func_sym);
+    // Partial evaluation: clones checked function `func` of `instance_id` with
+    // each parameter in `bound` (index, literal) turned into an immutable local
+    // initialized from the literal, then resolves and checks the clone as
+    // `<name>_S<n>` (first free n). Returns the clone's symbol, whose
+    // declaration is the clone.
+    Symbol* create_specialization(StmtPtr func,
+                                  const std::vector<std::pair<size_t, ExprPtr>>& bound,
+                                  int instance_id);
+    // Points the callee identifier of `call` (checked in `instance_id`) at `target`.
+    void rebind_call_target(int instance_id, const ExprPtr& call, Symbol* target);
+    // Inlining: the body of checked function `callee` as a typed, bound Block
+    // that replaces `call` (both in `instance_id`). Arguments initialize
+    // copies of the parameters ahead of the body; every local is copied as
+    // `<name><suffix>`. The arguments are moved, not copied, out of `call`.
+    ExprPtr inline_call_body(const ExprPtr& call, const StmtPtr& callee, int instance_id, const std::string& suffix);
+    // True when `expr` (checked in `instance_id`) only combines literals and
+    // named constants, so its value is fixed at compile time.
+    bool reads_only_constants(const ExprPtr& expr, int instance_id) const;
+    // True when checked `body` (in `instance_id`) assigns `sym`, or an element
+    // or member of it, or passes it as a call receiver. Such a parameter must
+    // stay a variable when a call's argument for it is known.
+    bool writes_symbol(const ExprPtr& body, const Symbol* sym, int instance_id) const;
+    // A declaring assignment of a fresh runtime local initialized by the
+    // checked `init`, for rewrites of checked bodies in `instance_id`, and an
+    // identifier (typed and bound) that reads it or any other symbol.
+    StmtPtr declare_synthesized_local(const std::string& name, ExprPtr init, bool is_mutable, int instance_id);
+    ExprPtr make_symbol_reference(Symbol* sym, int instance_id, const SourceLocation& loc);
     const std::unordered_map<std::string, std::vector<TypePtr>>& get_forced_tuple_types() const { return forced_tuple_types; }
+    const TypeVarTable& get_type_vars() const { return type_vars; }
+    // Top-level scope of a module instance, without switching to it.
+    const Scope* instance_scope(int instance_id) const;
+    ConstexprFactStore& constexpr_facts() { return constexpr_facts_; }
+    const ConstexprFactStore& constexpr_facts() const { return constexpr_facts_; }
+    // Once the pipeline is done: keeps the bindings of `live_nodes` only and
+    // drops what checking and compile-time queries alone use (the CTE engine
+    // with its memo tables, checked-statement keys, instantiation and
+    // deferred-body bookkeeping, checked conditions). Type-variable bindings,
+    // scopes, forced tuple types, fixpoint facts and resources stay for the
+    // analyzed program and the driver.
+    void release_checking_state(const std::unordered_set<const void*>& live_nodes);
     void register_tuple_type(const std::string& name, const std::vector<TypePtr>& elem_types);
 
 private:
@@ -151,16 +284,23 @@ private:
     Symbol* lookup_internal_global(const std::string& name) const;
     Symbol* lookup_value_global(const std::string& name) const;
     Symbol* lookup_type_global(const std::string& name) const;
-    std::vector<Symbol*> lookup_functions_global(const std::string& name) const;
+    SymbolSpan lookup_functions_global(const std::string& name) const;
     Symbol* lookup_binding(const void* node) const;
     unsigned long long stmt_key(const Stmt* stmt) const;
-    unsigned long long expr_key(int instance_id, const Expr* expr) const;
-    unsigned long long expr_key(const Expr* expr) const;
     void replace_expr_in_place(ExprPtr target, ExprPtr replacement);
     void validate_invariants(const Module& mod);
 
+    void check_program_parallel(Program& program);
+    std::vector<bool> parallel_check_candidates(const Program& program);
+    bool module_blocks_parallel_check(const Module& mod);
+    std::unique_ptr<TypeChecker> make_instance_worker(int instance_id);
+    void merge_instance_worker(TypeChecker& worker);
+
     void check_stmt(StmtPtr stmt);
     void check_func_decl(StmtPtr stmt);
+    void check_func_body(StmtPtr stmt);
+    bool defers_function_body(const StmtPtr& stmt) const;
+    void check_deferred_body(StmtPtr func, int instance_id);
     void check_type_decl(StmtPtr stmt);
     void check_var_decl(StmtPtr stmt);
     void enforce_declared_initializer_type(TypePtr declared_type,
@@ -196,7 +336,7 @@ private:
         Status status = Status::NoMatch;
         Symbol* symbol = nullptr;
     };
-    OverloadResolutionResult resolve_function_overload(const std::vector<Symbol*>& candidates,
+    OverloadResolutionResult resolve_function_overload(SymbolSpan candidates,
                                                        const std::vector<TypePtr>& receiver_types,
                                                        const std::vector<ExprPtr>& args);
 
@@ -234,13 +374,19 @@ private:
     // Path helpers moved to path_utils.
 
     // Generic monomorphization helpers
-    StmtPtr clone_function(StmtPtr func);
-    StmtPtr clone_stmt(StmtPtr stmt);
-    ExprPtr clone_expr(ExprPtr expr);
-    void substitute_types(StmtPtr func, const std::vector<TypePtr>& concrete_types);
-    void substitute_types_in_stmt(StmtPtr stmt, const std::unordered_map<std::string, TypePtr>& type_map);
-    void substitute_types_in_expr(ExprPtr expr, const std::unordered_map<std::string, TypePtr>& type_map);
+    using TypeSubstitution = std::unordered_map<std::string, TypePtr>;
+    const GenericTemplate& generic_template_for(StmtPtr generic_func);
+    // True when every caller-visible type of `func` is known without checking
+    // its body, so the body can wait until the function is found reachable.
+    static bool signature_is_concrete(const Stmt& func);
+    StmtPtr clone_function(StmtPtr func, const std::vector<TypePtr>& concrete_types, bool clone_body = true);
+    void check_instantiation(StmtPtr func, int instance_id);
+    // Set while cloning a checked body for create_specialization.
+    int clone_declarations_of_instance = -1;
+    StmtPtr clone_stmt(StmtPtr stmt, const TypeSubstitution* type_map);
+    ExprPtr clone_expr(ExprPtr expr, const TypeSubstitution* type_map);
     TypePtr substitute_type_with_map(TypePtr type, const std::unordered_map<std::string, TypePtr>& type_map);
+    TypeSignature make_type_signature(const std::vector<TypePtr>& types);
     std::string mangle_generic_name(const std::string& base_name, const std::vector<TypePtr>& types);
     void require_boolean(TypePtr type, const SourceLocation& loc, const std::string& context);
     void require_boolean_expr(ExprPtr expr, TypePtr type, const SourceLocation& loc, const std::string& context);
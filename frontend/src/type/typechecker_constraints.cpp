@@ -27,9 +27,22 @@ bool is_numeric_or_bool_primitive(const TypePtr& type) {
            type->primitive == PrimitiveType::F64;
 }
 
-bool is_binary_value_op(const std::string& op) {
-    return op == "+" || op == "-" || op == "*" || op == "/" || op == "%" ||
-           op == "&" || op == "|" || op == "^" || op == "<<" || op == ">>";
+bool is_binary_value_op(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Add:
+        case BinaryOp::Sub:
+        case BinaryOp::Mul:
+        case BinaryOp::Div:
+        case BinaryOp::Mod:
+        case BinaryOp::BitAnd:
+        case BinaryOp::BitOr:
+        case BinaryOp::BitXor:
+        case BinaryOp::Shl:
+        case BinaryOp::Shr:
+            return true;
+        default:
+            return false;
+    }
 }
 
 bool is_tuple_field_member_name(const std::string& name, size_t& index_out) {
@@ -154,7 +167,7 @@ bool TypeChecker::apply_type_constraint(const ExprPtr& expr, TypePtr target) {
             return false;
         }
         if (sym->declaration && sym->declaration->kind == Stmt::Kind::VarDecl) {
-            if (!refine_slot(sym->declaration->var_type, sym->type)) {
+            if (!refine_slot(sym->declaration->var_type.mutable_value(), sym->type)) {
                 return false;
             }
         }
@@ -250,7 +263,7 @@ bool TypeChecker::apply_type_constraint(const ExprPtr& expr, TypePtr target) {
             return true;
 
         case Expr::Kind::Binary:
-            if (is_binary_value_op(expr->op)) {
+            if (is_binary_value_op(expr->binary_op)) {
                 if (expr->left && !apply_type_constraint(expr->left, target)) return false;
                 if (expr->right && !apply_type_constraint(expr->right, target)) return false;
             }
@@ -370,8 +383,8 @@ bool TypeChecker::apply_type_constraint(const ExprPtr& expr, TypePtr target) {
             if (lowered_target->array_size &&
                 lowered_target->array_size->kind == Expr::Kind::IntLiteral &&
                 (lowered_target->array_size->has_exact_int_val
-                     ? (!lowered_target->array_size->exact_int_val.fits_u64() ||
-                        expr->elements.size() != lowered_target->array_size->exact_int_val.to_u64())
+                     ? (!lowered_target->array_size->exact_int_val->fits_u64() ||
+                        expr->elements.size() != lowered_target->array_size->exact_int_val->to_u64())
                      : (expr->elements.size() != lowered_target->array_size->uint_val))) {
                 return false;
             }
@@ -409,7 +422,7 @@ bool TypeChecker::apply_type_constraint(const ExprPtr& expr, TypePtr target) {
                 // External functions without declared return types must stay unresolved.
                 return false;
             }
-            if (!refine_slot(func->return_type, target)) {
+            if (!refine_slot(func->return_type.mutable_value(), target)) {
                 return false;
             }
 
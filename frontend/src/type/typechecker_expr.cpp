@@ -119,10 +119,10 @@ bool exact_array_size_u64(const TypePtr& type, uint64_t& out) {
         return false;
     }
     if (size_expr->has_exact_int_val) {
-        if (!size_expr->exact_int_val.fits_u64()) {
+        if (!size_expr->exact_int_val->fits_u64()) {
             return false;
         }
-        out = size_expr->exact_int_val.to_u64();
+        out = size_expr->exact_int_val->to_u64();
         return true;
     }
     out = size_expr->uint_val;
@@ -355,7 +355,7 @@ bool TypeChecker::try_rewrite_dotted_array_binary(ExprPtr expr, TypePtr left_typ
 
     TypePtr scalar_left_type = peel_array_element_type(lhs ? lhs : left_type);
     const bool preserve_dotted_leaf_op = scalar_left_type && scalar_left_type->kind == Type::Kind::Named;
-    const std::string leaf_op = preserve_dotted_leaf_op ? expr->op : expr->op.substr(1);
+    const std::string leaf_op = preserve_dotted_leaf_op ? expr->op.str() : expr->op.substr(1);
 
     std::function<ExprPtr(size_t, std::vector<uint64_t>&)> build;
     build = [&](size_t depth, std::vector<uint64_t>& result_indices) -> ExprPtr {
@@ -529,8 +529,8 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
             throw CompileError("Fixed-point operators currently require matching fixed-point operand types",
                                expr->location);
         }
-        if (expr->op == "&" || expr->op == "|" || expr->op == "^" ||
-            expr->op == "<<" || expr->op == ">>") {
+        if (expr->binary_op == BinaryOp::BitAnd || expr->binary_op == BinaryOp::BitOr || expr->binary_op == BinaryOp::BitXor ||
+            expr->binary_op == BinaryOp::Shl || expr->binary_op == BinaryOp::Shr) {
             if (!fixed_bitwise_shift_supported(left_type)) {
                 throw CompileError(
                     "Fixed-point bitwise/shift operators require fixed-point operands with positive storage width",
@@ -539,16 +539,16 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
             expr->type = left_type;
             return expr->type;
         }
-        if (expr->op == "+" || expr->op == "-") {
+        if (expr->binary_op == BinaryOp::Add || expr->binary_op == BinaryOp::Sub) {
             expr->type = left_type;
             return expr->type;
         }
-        if (expr->op == "*" || expr->op == "/" || expr->op == "%") {
+        if (expr->binary_op == BinaryOp::Mul || expr->binary_op == BinaryOp::Div || expr->binary_op == BinaryOp::Mod) {
             expr->type = left_type;
             return expr->type;
         }
-        if (expr->op == "==" || expr->op == "!=" || expr->op == "<" ||
-            expr->op == "<=" || expr->op == ">" || expr->op == ">=") {
+        if (expr->binary_op == BinaryOp::Eq || expr->binary_op == BinaryOp::Ne || expr->binary_op == BinaryOp::Lt ||
+            expr->binary_op == BinaryOp::Le || expr->binary_op == BinaryOp::Gt || expr->binary_op == BinaryOp::Ge) {
             expr->type = Type::make_primitive(PrimitiveType::Bool, expr->location);
             return expr->type;
         }
@@ -559,8 +559,8 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
         return !t || t->kind == Type::Kind::TypeVar || is_numeric_primitive_type(t);
     };
 
-    if (expr->op == "&&" || expr->op == "||") {
-        std::string context = expr->op == "&&" ? "Logical operator &&" : "Logical operator ||";
+    if (expr->binary_op == BinaryOp::LogicalAnd || expr->binary_op == BinaryOp::LogicalOr) {
+        std::string context = expr->binary_op == BinaryOp::LogicalAnd ? "Logical operator &&" : "Logical operator ||";
         require_boolean_expr(expr->left, left_type, expr->left->location, context);
         require_boolean_expr(expr->right, right_type, expr->right->location, context);
         expr->type = Type::make_primitive(PrimitiveType::Bool, expr->location);
@@ -575,7 +575,7 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
     }
 
     // Arithmetic operators
-    if (expr->op == "+" || expr->op == "-" || expr->op == "*" || expr->op == "/") {
+    if (expr->binary_op == BinaryOp::Add || expr->binary_op == BinaryOp::Sub || expr->binary_op == BinaryOp::Mul || expr->binary_op == BinaryOp::Div) {
         concretize_untyped_against(expr->left, left_type, right_type, expr->op);
         concretize_untyped_against(expr->right, right_type, left_type, expr->op);
         if (!is_numeric_like(left_type) || !is_numeric_like(right_type)) {
@@ -590,8 +590,8 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
     }
 
     // Modulo and bitwise: unsigned only
-    if (expr->op == "%" || expr->op == "&" || expr->op == "|" || expr->op == "^" ||
-        expr->op == "<<" || expr->op == ">>") {
+    if (expr->binary_op == BinaryOp::Mod || expr->binary_op == BinaryOp::BitAnd || expr->binary_op == BinaryOp::BitOr || expr->binary_op == BinaryOp::BitXor ||
+        expr->binary_op == BinaryOp::Shl || expr->binary_op == BinaryOp::Shr) {
         concretize_untyped_against(expr->left, left_type, right_type, expr->op);
         concretize_untyped_against(expr->right, right_type, left_type, expr->op);
         auto materialize_unsigned_untyped = [&](ExprPtr side_expr, TypePtr& side_type) {
@@ -630,7 +630,7 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
         require_unsigned_integer(right_type, expr->right ? expr->right->location : expr->location,
                                  "Operator " + expr->op);
 
-        if (expr->op == "<<" || expr->op == ">>") {
+        if (expr->binary_op == BinaryOp::Shl || expr->binary_op == BinaryOp::Shr) {
             expr->type = left_type;
             return expr->type;
         }
@@ -643,8 +643,8 @@ TypePtr TypeChecker::check_binary(ExprPtr expr) {
     }
 
     // Comparison operators
-    if (expr->op == "==" || expr->op == "!=" || expr->op == "<" ||
-        expr->op == "<=" || expr->op == ">" || expr->op == ">=") {
+    if (expr->binary_op == BinaryOp::Eq || expr->binary_op == BinaryOp::Ne || expr->binary_op == BinaryOp::Lt ||
+        expr->binary_op == BinaryOp::Le || expr->binary_op == BinaryOp::Gt || expr->binary_op == BinaryOp::Ge) {
         concretize_untyped_against(expr->left, left_type, right_type, expr->op);
         concretize_untyped_against(expr->right, right_type, left_type, expr->op);
         auto concretize_bool_literal = [&](ExprPtr side_expr, TypePtr& side_type, TypePtr target_type) {
@@ -695,7 +695,7 @@ TypePtr TypeChecker::try_operator_overload(ExprPtr expr, const std::string& op,
     }
 
     std::string func_name = left_type->type_name + "::" + op;
-    std::vector<Symbol*> overloads = lookup_functions_global(func_name);
+    SymbolSpan overloads = lookup_functions_global(func_name);
     if (overloads.size() != 1) {
         return nullptr;
     }
@@ -750,7 +750,7 @@ TypePtr TypeChecker::check_unary(ExprPtr expr) {
         return !t || t->kind == Type::Kind::TypeVar || is_numeric_primitive_type(t);
     };
 
-    if (expr->op == "-") {
+    if (expr->unary_op == UnaryOp::Neg) {
         if (is_fixed_primitive_type(operand_type)) {
             if (!(fixed_native_storage_width_supported(operand_type) ||
                   type_bits(operand_type->primitive, operand_type->integer_bits, operand_type->fractional_bits) > 0)) {
@@ -774,7 +774,7 @@ TypePtr TypeChecker::check_unary(ExprPtr expr) {
         return operand_type;
     }
 
-    if (expr->op == "!") {
+    if (expr->unary_op == UnaryOp::Not) {
         require_boolean_expr(expr->operand, operand_type,
                              expr->operand ? expr->operand->location : expr->location,
                              "Logical operator !");
@@ -782,7 +782,7 @@ TypePtr TypeChecker::check_unary(ExprPtr expr) {
         return expr->type;
     }
 
-        if (expr->op == "~") {
+        if (expr->unary_op == UnaryOp::BitNot) {
         if (is_fixed_primitive_type(operand_type)) {
             if (!fixed_bitwise_shift_supported(operand_type)) {
                 throw CompileError(
@@ -801,7 +801,7 @@ TypePtr TypeChecker::check_unary(ExprPtr expr) {
 }
 
 TypeChecker::OverloadResolutionResult TypeChecker::resolve_function_overload(
-    const std::vector<Symbol*>& candidates,
+    SymbolSpan candidates,
     const std::vector<TypePtr>& receiver_types,
     const std::vector<ExprPtr>& args) {
     OverloadResolutionResult result;
@@ -917,7 +917,7 @@ TypePtr TypeChecker::check_probe_call(ExprPtr expr) {
         expr->literal_is_unsigned = false;
         expr->raw_literal = exists ? "1" : "0";
         expr->name.clear();
-        expr->op.clear();
+        expr->set_op("");
         expr->left = nullptr;
         expr->right = nullptr;
         expr->operand = nullptr;
@@ -994,7 +994,7 @@ TypePtr TypeChecker::check_probe_call(ExprPtr expr) {
         }
     }
 
-    std::vector<Symbol*> candidates = lookup_functions_global(func_name);
+    SymbolSpan candidates = lookup_functions_global(func_name);
     if (candidates.empty() && resolver && current_instance_id >= 0) {
         candidates = resolver->lookup_functions_in_instance(current_instance_id, func_name);
     }
@@ -1019,7 +1019,7 @@ TypePtr TypeChecker::check_probe_member(ExprPtr expr) {
         expr->literal_is_unsigned = false;
         expr->raw_literal = exists ? "1" : "0";
         expr->name.clear();
-        expr->op.clear();
+        expr->set_op("");
         expr->left = nullptr;
         expr->right = nullptr;
         expr->operand = nullptr;
@@ -1151,9 +1151,9 @@ TypePtr TypeChecker::check_call(ExprPtr expr) {
             expr->operand->name = sym->surface_name;
             has_symbol = true;
         } else {
-            std::vector<Symbol*> candidates;
+            SymbolSpan candidates;
             if (sym && sym->kind == Symbol::Kind::Function) {
-                candidates.push_back(sym);
+                candidates = SymbolSpan(sym);
             }
             if (candidates.empty()) {
                 candidates = lookup_functions_global(func_name);
@@ -1490,8 +1490,7 @@ TypePtr TypeChecker::check_call(ExprPtr expr) {
                 }
             }
 
-            TypeSignature sig;
-            sig.param_types = call_types;
+            TypeSignature sig = make_type_signature(call_types);
             std::string lookup_key = sym->name + "_inst" + std::to_string(instantiation_owner);
             auto func_it = instantiations.find(lookup_key);
             if (func_it != instantiations.end()) {
@@ -1791,6 +1790,7 @@ TypePtr TypeChecker::check_tuple_literal(ExprPtr expr) {
 
 bool TypeChecker::types_equal(TypePtr a, TypePtr b) {
     if (!a || !b) return false;
+    if (a == b) return true;
     if (a->kind != b->kind) return false;
 
     switch (a->kind) {
@@ -1820,7 +1820,7 @@ bool TypeChecker::types_equal(TypePtr a, TypePtr b) {
         case Type::Kind::Named:
             return a->type_name == b->type_name;
         case Type::Kind::TypeVar:
-            return a->var_name == b->var_name;
+            return a->var_id == b->var_id;
         case Type::Kind::TypeOf:
             return a->typeof_expr.get() == b->typeof_expr.get();
     }
@@ -1888,9 +1888,6 @@ TypePtr TypeChecker::unify_types(TypePtr a, TypePtr b) {
     if (!a) return b;
     if (!b) return a;
     if (a->kind == Type::Kind::TypeVar && b->kind == Type::Kind::TypeVar) {
-        if (a->var_name == b->var_name) {
-            return a;
-        }
         bind_typevar(b, a);
         return a;
     }
@@ -1975,31 +1972,17 @@ TypePtr TypeChecker::unify_types(TypePtr a, TypePtr b) {
 }
 
 TypePtr TypeChecker::resolve_type(TypePtr type) {
-    if (!type) return nullptr;
-    if (type->kind == Type::Kind::TypeVar) {
-        auto it = type_var_bindings.find(type->var_name);
-        if (it != type_var_bindings.end()) {
-            return resolve_type(it->second);
-        }
-    }
-    if (type->kind == Type::Kind::Array && type->element_type) {
-        TypePtr elem = resolve_type(type->element_type);
-        if (elem != type->element_type) {
-            TypePtr cloned = std::make_shared<Type>(*type);
-            cloned->element_type = elem;
-            return cloned;
-        }
-    }
-    if (type->kind == Type::Kind::TypeOf && type->typeof_expr && type->typeof_expr->type) {
-        return resolve_type(type->typeof_expr->type);
-    }
-    return type;
+    return resolve_type_vars(type, type_vars);
 }
 
 TypePtr TypeChecker::bind_typevar(TypePtr var, TypePtr target) {
     if (!var || var->kind != Type::Kind::TypeVar) return target;
     if (!target) return target;
-    type_var_bindings[var->var_name] = target;
+    if (target->kind == Type::Kind::TypeVar) {
+        type_vars.unite(var->var_id, target->var_id);
+    } else {
+        type_vars.bind(var->var_id, target);
+    }
     return target;
 }
 
@@ -2147,7 +2130,11 @@ bool TypeChecker::literal_assignable_to(TypePtr target, ExprPtr expr) {
 }
 
 TypePtr TypeChecker::make_fresh_typevar() {
-    return Type::make_typevar("T" + std::to_string(type_var_counter++), SourceLocation());
+    TypePtr var = Type::make_typevar(type_var_ids->fetch_add(1, std::memory_order_relaxed),
+                                     type_var_prefix + std::to_string(type_var_counter++),
+                                     SourceLocation());
+    type_vars.add(var);
+    return var;
 }
 
 }
@@ -8,7 +8,6 @@
 #include <array>
 #include <cstdio>
 #include <filesystem>
-#include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
@@ -18,6 +17,7 @@
 #include "lexer.h"
 #include "parser.h"
 #include "path_utils.h"
+#include "process_cache.h"
 
 namespace vexel {
 namespace {
@@ -323,7 +323,7 @@ bool TypeChecker::try_custom_iteration(ExprPtr expr, TypePtr iterable_type) {
     std::string method_token = expr->is_sorted_iteration ? "@@" : "@";
     std::string method_name = iterable_type->type_name + "::" + method_token;
 
-    std::vector<Symbol*> overloads = lookup_functions_global(method_name);
+    SymbolSpan overloads = lookup_functions_global(method_name);
     if (overloads.size() != 1) {
         return false;
     }
@@ -487,15 +487,15 @@ TypePtr TypeChecker::check_block(ExprPtr expr) {
             }
         }
         for (const auto& pending : pending_instantiations) {
-            snapshot_stmt(pending);
+            snapshot_stmt(pending.declaration);
         }
 
-        auto saved_type_var_bindings = type_var_bindings;
+        auto saved_type_vars = type_vars;
         auto saved_instantiations = instantiations;
         auto saved_pending_instantiations = pending_instantiations;
         auto saved_forced_tuple_types = forced_tuple_types;
         auto saved_constexpr_values = known_constexpr_values;
-        auto saved_constexpr_conditions = constexpr_condition_cache;
+        auto saved_constexpr_facts = constexpr_facts_;
         auto saved_checked_statements = checked_statements;
 
         auto restore_snapshot = [&]() {
@@ -517,12 +517,12 @@ TypePtr TypeChecker::check_block(ExprPtr expr) {
                     stmt->fields[i].type = snap.field_types[i];
                 }
             }
-            type_var_bindings = saved_type_var_bindings;
+            type_vars = saved_type_vars;
             instantiations = saved_instantiations;
             pending_instantiations = saved_pending_instantiations;
             forced_tuple_types = saved_forced_tuple_types;
             known_constexpr_values = saved_constexpr_values;
-            constexpr_condition_cache = saved_constexpr_conditions;
+            constexpr_facts_ = saved_constexpr_facts;
             checked_statements = saved_checked_statements;
         };
 
@@ -574,10 +574,9 @@ TypePtr TypeChecker::check_conditional(ExprPtr expr) {
     // for the dead branch. The type-use validator mirrors this by skipping
     // constexpr-dead branches.
     auto static_value = constexpr_condition(expr->condition);
-    if (expr->condition && static_value.has_value()) {
-        constexpr_condition_cache[expr_key(expr->condition.get())] = static_value.value();
-    } else if (expr->condition) {
-        constexpr_condition_cache.erase(expr_key(expr->condition.get()));
+    if (expr->condition) {
+        constexpr_facts_.set_checked_condition(expr_fact_key(current_instance_id, expr->condition.get()),
+                                               static_value);
     }
     if (static_value.has_value()) {
         if (static_value.value()) {
@@ -661,10 +660,10 @@ TypePtr TypeChecker::check_cast(ExprPtr expr) {
         uint64_t count = 0;
         if (operand_type->array_size && operand_type->array_size->kind == Expr::Kind::IntLiteral) {
             if (operand_type->array_size->has_exact_int_val) {
-                if (!operand_type->array_size->exact_int_val.fits_u64()) {
+                if (!operand_type->array_size->exact_int_val->fits_u64()) {
                     throw CompileError("Boolean array size is too large for cast validation", expr->location);
                 }
-                count = operand_type->array_size->exact_int_val.to_u64();
+                count = operand_type->array_size->exact_int_val->to_u64();
             } else {
                 count = operand_type->array_size->uint_val;
             }
@@ -745,8 +744,8 @@ TypePtr TypeChecker::check_cast(ExprPtr expr) {
 
 TypePtr TypeChecker::check_assignment(ExprPtr expr) {
     expr->declared_var_type = nullptr;
-    std::string assign_op = expr->op.empty() ? "=" : expr->op;
-    expr->op = assign_op;
+    if (expr->op.empty()) expr->set_op("=");
+    AssignOp assign_op = expr->assign_op;
     auto fixed_assignment_passthrough_ok = [&](TypePtr lhs, TypePtr rhs) -> bool {
         lhs = resolve_type(lhs);
         rhs = resolve_type(rhs);
@@ -806,22 +805,22 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
         return rec(root);
     };
 
-    if (is_dotted_compound_assignment(assign_op)) {
+    if (is_dotted_compound_assignment(expr->op)) {
         if (creates_new_variable) {
             throw CompileError("Per-element compound assignment cannot declare a new variable", expr->location);
         }
         if (expr_has_side_effects(expr->left)) {
             throw CompileError("Per-element compound assignment requires a side-effect-free assignment target", expr->location);
         }
-        std::string binary_op = assign_op.substr(0, assign_op.size() - 1);
+        std::string binary_op = expr->op.substr(0, expr->op.size() - 1);
         ExprPtr dotted_binary = Expr::make_binary(binary_op, expr->left, expr->right, expr->location);
-        expr->op = "=";
+        expr->set_op("=");
         expr->right = dotted_binary;
-        assign_op = "=";
+        assign_op = AssignOp::Assign;
     }
 
     if (creates_new_variable) {
-        if (assign_op != "=") {
+        if (assign_op != AssignOp::Assign) {
             throw CompileError("Compound assignment cannot declare a new variable", expr->location);
         }
         if (expr->left->kind != Expr::Kind::Identifier) {
@@ -943,35 +942,35 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
     TypePtr rhs_type = check_expr(expr->right);
     if (is_fixed_primitive(lhs_type) || is_fixed_primitive(rhs_type)) {
         if (!fixed_assignment_passthrough_ok(lhs_type, rhs_type)) {
-            if (assign_op == "=") {
+            if (assign_op == AssignOp::Assign) {
                 throw CompileError("Fixed-point assignments currently support only same-type pass-through",
                                    expr->location);
             }
             throw CompileError("Fixed-point compound assignments currently require matching fixed-point operand types",
                                expr->location);
         }
-        if (assign_op != "=" && assign_op != "+=" && assign_op != "-=" &&
-            assign_op != "*=" && assign_op != "/=" && assign_op != "%=" &&
-            assign_op != "&=" && assign_op != "|=" && assign_op != "^=" &&
-            assign_op != "<<=" && assign_op != ">>=") {
-            throw CompileError("Fixed-point compound assignment '" + assign_op + "' is not implemented yet",
+        if (assign_op != AssignOp::Assign && assign_op != AssignOp::Add && assign_op != AssignOp::Sub &&
+            assign_op != AssignOp::Mul && assign_op != AssignOp::Div && assign_op != AssignOp::Mod &&
+            assign_op != AssignOp::BitAnd && assign_op != AssignOp::BitOr && assign_op != AssignOp::BitXor &&
+            assign_op != AssignOp::Shl && assign_op != AssignOp::Shr) {
+            throw CompileError("Fixed-point compound assignment '" + expr->op + "' is not implemented yet",
                                expr->location);
         }
-        if (assign_op == "&=" || assign_op == "|=" || assign_op == "^=" ||
-            assign_op == "<<=" || assign_op == ">>=") {
+        if (assign_op == AssignOp::BitAnd || assign_op == AssignOp::BitOr || assign_op == AssignOp::BitXor ||
+            assign_op == AssignOp::Shl || assign_op == AssignOp::Shr) {
             if (!fixed_bitwise_shift_supported(lhs_type)) {
                 throw CompileError(
                     "Fixed-point compound bitwise/shift assignments require fixed-point operands with positive storage width",
                     expr->location);
             }
-        } else if ((assign_op == "+=" || assign_op == "-=") &&
+        } else if ((assign_op == AssignOp::Add || assign_op == AssignOp::Sub) &&
                    type_bits(lhs_type->primitive, lhs_type->integer_bits, lhs_type->fractional_bits) > 0) {
             // Supported for any fixed-point width via raw same-type integer-like lowering.
-        } else if ((assign_op == "*=" || assign_op == "/=" || assign_op == "%=") &&
+        } else if ((assign_op == AssignOp::Mul || assign_op == AssignOp::Div || assign_op == AssignOp::Mod) &&
                    (!fixed_native_storage_width_supported(lhs_type) ||
                     fixed_zero_frac_supported_any_width(lhs_type))) {
             // Supported for non-native fixed-point widths and zero-fraction fixed-point widths.
-        } else if (assign_op != "=") {
+        } else if (assign_op != AssignOp::Assign) {
             int64_t fixed_bits = type_bits(lhs_type->primitive, lhs_type->integer_bits, lhs_type->fractional_bits);
             if (!(fixed_bits == 8 || fixed_bits == 16 || fixed_bits == 32 || fixed_bits == 64)) {
                 throw CompileError(
@@ -979,12 +978,12 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
                     expr->location);
             }
         }
-        if ((assign_op == "*=" || assign_op == "/=" || assign_op == "%=") &&
+        if ((assign_op == AssignOp::Mul || assign_op == AssignOp::Div || assign_op == AssignOp::Mod) &&
             fixed_native_storage_width_supported(lhs_type) &&
             !fixed_zero_frac_supported_any_width(lhs_type) &&
             !fixed_muldiv_storage_width_supported(lhs_type)) {
             throw CompileError(
-                "Fixed-point compound assignment '" + assign_op +
+                "Fixed-point compound assignment '" + expr->op +
                     "' currently supports only native storage widths (8/16/32/64)",
                 expr->location);
         }
@@ -995,7 +994,7 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
     }
 
     TypePtr compound_value_type = lhs_type;
-    if (assign_op == "=") {
+    if (assign_op == AssignOp::Assign) {
         if (is_untyped_integer_primitive(rhs_type) &&
             literal_assignable_to(lhs_type, expr->right)) {
             apply_type_constraint(expr->right, lhs_type);
@@ -1085,34 +1084,36 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
             side_type = inferred;
         };
 
-        const std::string binary_op = assign_op.substr(0, assign_op.size() - 1);
+        const std::string binary_op = expr->op.substr(0, expr->op.size() - 1);
+        const BinaryOp binary_code = compound_binary_op(assign_op);
         if (is_fixed_primitive(lhs_type) || is_fixed_primitive(rhs_type)) {
             if (!(is_fixed_primitive(lhs_type) && is_fixed_primitive(rhs_type) && types_equal(lhs_type, rhs_type))) {
                 throw CompileError("Fixed-point compound assignments currently require matching fixed-point operand types",
                                    expr->location);
             }
-            if (binary_op == "&" || binary_op == "|" || binary_op == "^" ||
-                binary_op == "<<" || binary_op == ">>") {
+            if (binary_code == BinaryOp::BitAnd || binary_code == BinaryOp::BitOr || binary_code == BinaryOp::BitXor ||
+                binary_code == BinaryOp::Shl || binary_code == BinaryOp::Shr) {
                 if (!fixed_bitwise_shift_supported(lhs_type)) {
                     throw CompileError(
                         "Fixed-point compound bitwise/shift assignments require fixed-point operands with positive storage width",
                         expr->location);
                 }
                 compound_value_type = lhs_type;
-            } else if (binary_op == "+" || binary_op == "-") {
+            } else if (binary_code == BinaryOp::Add || binary_code == BinaryOp::Sub) {
                 compound_value_type = lhs_type;
-            } else if (binary_op == "*" || binary_op == "/" || binary_op == "%") {
+            } else if (binary_code == BinaryOp::Mul || binary_code == BinaryOp::Div || binary_code == BinaryOp::Mod) {
                 compound_value_type = lhs_type;
             } else {
-                throw CompileError("Fixed-point compound assignment '" + assign_op + "' is not implemented yet",
+                throw CompileError("Fixed-point compound assignment '" + expr->op + "' is not implemented yet",
                                    expr->location);
             }
-        } else if (binary_op == "&&" || binary_op == "||") {
-            std::string context = (binary_op == "&&") ? "Logical operator &&" : "Logical operator ||";
+        } else if (binary_code == BinaryOp::LogicalAnd || binary_code == BinaryOp::LogicalOr) {
+            std::string context = (binary_code == BinaryOp::LogicalAnd) ? "Logical operator &&" : "Logical operator ||";
             require_boolean_expr(expr->left, lhs_type, expr->left ? expr->left->location : expr->location, context);
             require_boolean_expr(expr->right, rhs_type, expr->right ? expr->right->location : expr->location, context);
             compound_value_type = Type::make_primitive(PrimitiveType::Bool, expr->location);
-        } else if (binary_op == "+" || binary_op == "-" || binary_op == "*" || binary_op == "/") {
+        } else if (binary_code == BinaryOp::Add || binary_code == BinaryOp::Sub ||
+                   binary_code == BinaryOp::Mul || binary_code == BinaryOp::Div) {
             concretize_untyped_against(expr->left, lhs_type, rhs_type, binary_op);
             concretize_untyped_against(expr->right, rhs_type, lhs_type, binary_op);
             auto is_numeric_like = [&](TypePtr t) {
@@ -1125,8 +1126,8 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
             if (!compound_value_type) {
                 throw CompileError("Operator " + binary_op + " requires operands from the same numeric family", expr->location);
             }
-        } else if (binary_op == "%" || binary_op == "&" || binary_op == "|" ||
-                   binary_op == "^" || binary_op == "<<" || binary_op == ">>") {
+        } else if (binary_code == BinaryOp::Mod || binary_code == BinaryOp::BitAnd || binary_code == BinaryOp::BitOr ||
+                   binary_code == BinaryOp::BitXor || binary_code == BinaryOp::Shl || binary_code == BinaryOp::Shr) {
             concretize_untyped_against(expr->left, lhs_type, rhs_type, binary_op);
             concretize_untyped_against(expr->right, rhs_type, lhs_type, binary_op);
             materialize_unsigned_untyped(expr->left, lhs_type, binary_op);
@@ -1135,7 +1136,7 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
                                      "Operator " + binary_op);
             require_unsigned_integer(rhs_type, expr->right ? expr->right->location : expr->location,
                                      "Operator " + binary_op);
-            if (binary_op == "<<" || binary_op == ">>") {
+            if (binary_code == BinaryOp::Shl || binary_code == BinaryOp::Shr) {
                 compound_value_type = lhs_type;
             } else {
                 compound_value_type = unify_types(lhs_type, rhs_type);
@@ -1145,7 +1146,7 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
                 }
             }
         } else {
-            throw CompileError("Unsupported compound assignment operator: " + assign_op, expr->location);
+            throw CompileError("Unsupported compound assignment operator: " + expr->op, expr->location);
         }
 
         if (!types_compatible(compound_value_type, lhs_type)) {
@@ -1182,7 +1183,7 @@ TypePtr TypeChecker::check_assignment(ExprPtr expr) {
     if (assigned_sym) {
         if (expr->left->kind == Expr::Kind::Identifier) {
             CTValue value;
-            ExprPtr fact_expr = (assign_op == "=") ? expr->right : expr;
+            ExprPtr fact_expr = (assign_op == AssignOp::Assign) ? expr->right : expr;
             if (try_evaluate_constexpr(fact_expr, value)) {
                 remember_constexpr_value(assigned_sym, value);
             } else {
@@ -1211,10 +1212,10 @@ TypePtr TypeChecker::check_range(ExprPtr expr) {
     auto fold_const = [&](ExprPtr e, int64_t& out) -> bool {
         if (e->kind == Expr::Kind::IntLiteral) {
             if (e->has_exact_int_val) {
-                if (!e->exact_int_val.fits_i64()) {
+                if (!e->exact_int_val->fits_i64()) {
                     return false;
                 }
-                out = e->exact_int_val.to_i64();
+                out = e->exact_int_val->to_i64();
                 return true;
             }
             if (e->literal_is_unsigned &&
@@ -1401,7 +1402,8 @@ TypePtr TypeChecker::check_repeat(ExprPtr expr) {
 
 TypePtr TypeChecker::check_resource_expr(ExprPtr expr) {
     std::string resolved;
-    bool found = try_resolve_resource_path(expr->resource_path, expr->location.filename, project_root, resolved);
+    bool found = try_resolve_resource_path(expr->resource_path, expr->location.filename(), project_root, resolved,
+                                           directory_cache);
     const std::string tuple_name = std::string(TUPLE_TYPE_PREFIX) + "2_#s_#s";
     auto register_resource_tuple = [&](const SourceLocation& loc) {
         std::vector<TypePtr> elem_types = {
@@ -1433,31 +1435,21 @@ TypePtr TypeChecker::check_resource_expr(ExprPtr expr) {
 
     std::error_code ec;
     if (std::filesystem::is_directory(path, ec)) {
-        std::vector<std::filesystem::directory_entry> entries;
-        for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
-            if (entry.is_regular_file()) {
-                entries.push_back(entry);
-            }
-        }
+        std::vector<ResourceStore::Entry> entries = resources.read_directory(path);
         register_resource_tuple(expr->location);
         if (entries.empty()) {
             return make_empty_directory_result(expr->location);
         }
-        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
-            return a.path().filename().string() < b.path().filename().string();
-        });
 
         std::vector<ExprPtr> elements;
         elements.reserve(entries.size());
         for (const auto& entry : entries) {
-            std::ifstream file(entry.path(), std::ios::binary);
-            if (!file) {
-                throw CompileError("Cannot open resource file: " + entry.path().string(), expr->location);
+            if (!entry.data) {
+                throw CompileError("Cannot open resource file: " + (path / entry.name).string(), expr->location);
             }
-            std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-            ExprPtr literal = Expr::make_string(data, expr->location);
+            ExprPtr literal = Expr::make_string(*entry.data, expr->location);
             literal->type = Type::make_primitive(PrimitiveType::String, expr->location);
-            ExprPtr name_literal = Expr::make_string(entry.path().filename().string(), expr->location);
+            ExprPtr name_literal = Expr::make_string(entry.name, expr->location);
             name_literal->type = Type::make_primitive(PrimitiveType::String, expr->location);
             ExprPtr record = Expr::make_tuple({name_literal, literal}, expr->location);
             elements.push_back(record);
@@ -1469,16 +1461,16 @@ TypePtr TypeChecker::check_resource_expr(ExprPtr expr) {
     }
 
     if (std::filesystem::is_regular_file(path, ec)) {
-        std::ifstream file(path, std::ios::binary);
-        if (!file) {
+        std::shared_ptr<const std::string> data = resources.read_file(path);
+        if (!data) {
             throw CompileError("Cannot open resource: " + path.string(), expr->location);
         }
-        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        ExprPtr literal = Expr::make_string(data, expr->location);
+        ExprPtr literal = Expr::make_string(*data, expr->location);
         replace_expr_in_place(expr, literal);
         return check_expr(expr);
     }
 
+    resources.note_directory(path);
     return make_empty_directory_result(expr->location);
 }
 
@@ -1486,7 +1478,11 @@ TypePtr TypeChecker::check_process_expr(ExprPtr expr) {
     if (!allow_process) {
         throw CompileError("Process expressions are disabled (enable with --allow-process)", expr->location);
     }
-    std::string output = run_process_command(expr->process_command, expr->location);
+    const std::string& command = expr->process_command;
+    std::string output =
+        process_cache
+            ? process_cache->output_for(command, [&]() { return run_process_command(command, expr->location); })
+            : run_process_command(command, expr->location);
     ExprPtr literal = Expr::make_string(output, expr->location);
     literal->type = Type::make_primitive(PrimitiveType::String, expr->location);
     replace_expr_in_place(expr, literal);
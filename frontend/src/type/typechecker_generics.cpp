@@ -1,5 +1,6 @@
 #include "typechecker.h"
 #include "constants.h"
+#include "pipeline_trace.h"
 #include "resolver.h"
 #include <unordered_map>
 
@@ -7,34 +8,6 @@ namespace vexel {
 
 namespace {
 
-bool array_sizes_equal(ExprPtr a, ExprPtr b) {
-    if (!a && !b) return true;
-    if (!a || !b) return false;
-    if (a->kind == Expr::Kind::IntLiteral && b->kind == Expr::Kind::IntLiteral) {
-        if (a->has_exact_int_val && b->has_exact_int_val) {
-            return a->literal_is_unsigned == b->literal_is_unsigned &&
-                   a->exact_int_val == b->exact_int_val;
-        }
-        return a->uint_val == b->uint_val;
-    }
-    return a.get() == b.get();
-}
-
-size_t array_size_hash(ExprPtr size) {
-    if (!size) {
-        return 0x9e3779b9ULL;
-    }
-    if (size->kind == Expr::Kind::IntLiteral) {
-        if (size->has_exact_int_val) {
-            size_t h = std::hash<std::string>{}(size->exact_int_val.to_string());
-            h ^= std::hash<bool>{}(size->literal_is_unsigned) + 0x9e3779b9 + (h << 6) + (h >> 2);
-            return h;
-        }
-        return std::hash<uint64_t>{}(size->uint_val);
-    }
-    return std::hash<const Expr*>{}(size.get());
-}
-
 std::string mangle_type_component(TypePtr type) {
     if (!type) return "unknown";
 
@@ -47,7 +20,7 @@ std::string mangle_type_component(TypePtr type) {
             std::string component = "array_" + mangle_type_component(type->element_type);
             if (type->array_size && type->array_size->kind == Expr::Kind::IntLiteral) {
                 if (type->array_size->has_exact_int_val) {
-                    component += "_n" + type->array_size->exact_int_val.to_string();
+                    component += "_n" + type->array_size->exact_int_val->to_string();
                 } else {
                     component += "_n" + std::to_string(type->array_size->uint_val);
                 }
@@ -69,7 +42,7 @@ std::string mangle_type_component(TypePtr type) {
 TypePtr freeze_signature_type(TypePtr type) {
     if (!type) return nullptr;
 
-    TypePtr frozen = std::make_shared<Type>(*type);
+    TypePtr frozen = make_ast_node<Type>(*type);
     if (type->kind == Type::Kind::Array) {
         frozen->element_type = freeze_signature_type(type->element_type);
         if (type->array_size && type->array_size->kind == Expr::Kind::IntLiteral) {
@@ -78,8 +51,8 @@ TypePtr freeze_signature_type(TypePtr type) {
                                                           type->array_size->literal_is_unsigned,
                                                           type->array_size->location,
                                                           type->array_size->raw_literal.empty()
-                                                              ? type->array_size->exact_int_val.to_string()
-                                                              : type->array_size->raw_literal);
+                                                              ? type->array_size->exact_int_val->to_string()
+                                                              : type->array_size->raw_literal.str());
             } else {
                 frozen->array_size = Expr::make_uint(type->array_size->uint_val,
                                                      type->array_size->location,
@@ -92,76 +65,46 @@ TypePtr freeze_signature_type(TypePtr type) {
     return frozen;
 }
 
-} // namespace
-
-bool TypeSignature::types_equal_static(TypePtr a, TypePtr b) {
-    if (!a && !b) return true;
-    if (!a || !b) return false;
-
-    if (a->kind != b->kind) return false;
-
-    switch (a->kind) {
-        case Type::Kind::Primitive:
-            if (a->primitive != b->primitive) return false;
-            if (is_signed_int(a->primitive) || is_unsigned_int(a->primitive) ||
-                is_signed_fixed(a->primitive) || is_unsigned_fixed(a->primitive)) {
-                return a->integer_bits == b->integer_bits &&
-                       a->fractional_bits == b->fractional_bits;
-            }
-            return true;
-        case Type::Kind::Array:
-            return types_equal_static(a->element_type, b->element_type) &&
-                   array_sizes_equal(a->array_size, b->array_size);
-        case Type::Kind::Named:
-            return a->type_name == b->type_name;
+bool type_is_concrete(const TypePtr& type) {
+    if (!type) return false;
+    switch (type->kind) {
         case Type::Kind::TypeVar:
-            return a->var_name == b->var_name;
         case Type::Kind::TypeOf:
-            return a->typeof_expr.get() == b->typeof_expr.get();
+            return false;
+        case Type::Kind::Array:
+            return type_is_concrete(type->element_type);
+        default:
+            return true;
     }
-    return false;
 }
-size_t TypeSignatureHash::type_hash(TypePtr t) {
-    if (!t) return 0;
 
-    size_t hash = static_cast<size_t>(t->kind);
+} // namespace
 
-    switch (t->kind) {
-        case Type::Kind::Primitive:
-            hash ^= static_cast<size_t>(t->primitive) << 8;
-            if (is_signed_int(t->primitive) || is_unsigned_int(t->primitive) ||
-                is_signed_fixed(t->primitive) || is_unsigned_fixed(t->primitive)) {
-                hash ^= std::hash<uint64_t>{}(t->integer_bits) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-                hash ^= std::hash<int64_t>{}(t->fractional_bits) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-            }
-            break;
-        case Type::Kind::Array:
-            hash ^= type_hash(t->element_type) << 4;
-            hash ^= array_size_hash(t->array_size) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-            break;
-        case Type::Kind::Named:
-            hash ^= std::hash<std::string>{}(t->type_name);
-            break;
-        case Type::Kind::TypeVar:
-            hash ^= std::hash<std::string>{}(t->var_name);
-            break;
-        case Type::Kind::TypeOf:
-            hash ^= std::hash<const Expr*>{}(t->typeof_expr.get());
-            break;
+bool TypeChecker::signature_is_concrete(const Stmt& func) {
+    if (!type_is_concrete(func.return_type) || !func.return_types.empty()) return false;
+    for (const auto& param : func.params) {
+        if (param.is_expression_param || !type_is_concrete(param.type)) return false;
     }
+    if (func.ref_param_types.size() != func.ref_params.size()) return false;
+    for (const auto& ref_type : func.ref_param_types) {
+        if (!type_is_concrete(ref_type)) return false;
+    }
+    return true;
+}
 
-    return hash;
+TypeSignature TypeChecker::make_type_signature(const std::vector<TypePtr>& types) {
+    TypeSignature sig;
+    sig.param_types.reserve(types.size());
+    for (const auto& type : types) {
+        sig.param_types.push_back(type_interner->intern(resolve_type(type)));
+    }
+    return sig;
 }
 std::string TypeChecker::get_or_create_instantiation(const std::string& func_name,
                                                      const std::vector<TypePtr>& call_types,
                                                      StmtPtr generic_func,
                                                      int owner_instance_id) {
-    // Create type signature
-    TypeSignature sig;
-    sig.param_types.reserve(call_types.size());
-    for (const auto& call_type : call_types) {
-        sig.param_types.push_back(freeze_signature_type(resolve_type(call_type)));
-    }
+    TypeSignature sig = make_type_signature(call_types);
 
     // Keep instantiations per module instance.
     int instance_id = owner_instance_id;
@@ -189,9 +132,14 @@ std::string TypeChecker::get_or_create_instantiation(const std::string& func_nam
         }
     }
 
-    // Create new instantiation
-    StmtPtr cloned = clone_function(generic_func);
-    substitute_types(cloned, sig.param_types);
+    // Create new instantiation. Interned types are never spliced into the
+    // AST; the clone gets its own frozen copies.
+    std::vector<TypePtr> concrete_types;
+    concrete_types.reserve(sig.param_types.size());
+    for (const auto& type : sig.param_types) {
+        concrete_types.push_back(freeze_signature_type(type));
+    }
+    StmtPtr cloned = clone_function(generic_func, concrete_types, false);
 
     // Generate mangled name
     cloned->func_name = mangled;
@@ -200,18 +148,26 @@ std::string TypeChecker::get_or_create_instantiation(const std::string& func_nam
     cloned->is_generic = false;
     cloned->is_instantiation = true;
 
+    // A fully concrete signature gives the call site everything it needs, so
+    // the body is cloned and checked only once the function is found live.
+    // Otherwise check it now to infer the return type.
+    const bool defer_body = signature_is_concrete(*cloned);
+    if (!defer_body) {
+        cloned->body = clone_function(generic_func, concrete_types)->body;
+    }
+
     if (resolver) {
         resolver->resolve_generated_function(cloned, instance_id);
     }
 
-    // Type check the instantiation immediately to infer return type
-    int saved_instance = current_instance_id;
-    auto saved_constexpr_values = known_constexpr_values;
-    current_instance_id = instance_id;
-    forget_all_constexpr_values();
-    check_func_decl(cloned);
-    current_instance_id = saved_instance;
-    known_constexpr_values = std::move(saved_constexpr_values);
+    check_instantiation(cloned, instance_id);
+    if (defer_body) {
+        DeferredInstantiation deferred;
+        deferred.generic_func = generic_func;
+        deferred.concrete_types = std::move(concrete_types);
+        deferred.instance_id = instance_id;
+        deferred_instantiations.emplace(cloned.get(), std::move(deferred));
+    }
 
     // Store instantiation
     GenericInstantiation inst;
@@ -219,10 +175,115 @@ std::string TypeChecker::get_or_create_instantiation(const std::string& func_nam
     inst.declaration = cloned;
 
     instantiations[lookup_key][sig] = inst;
-    pending_instantiations.push_back(cloned);
+    PendingInstantiation pending;
+    pending.declaration = cloned;
+    pending.symbol = binding_for(instance_id, cloned.get());
+    pending.instance_id = pending.symbol ? pending.symbol->instance_id : instance_id;
+    pending_instantiations.push_back(std::move(pending));
 
     return mangled;
 }
+void TypeChecker::check_instantiation(StmtPtr func, int instance_id) {
+    int saved_instance = current_instance_id;
+    auto saved_constexpr_values = known_constexpr_values;
+    current_instance_id = instance_id;
+    forget_all_constexpr_values();
+    check_func_decl(func);
+    current_instance_id = saved_instance;
+    known_constexpr_values = std::move(saved_constexpr_values);
+}
+
+void TypeChecker::check_deferred_body(StmtPtr func, int instance_id) {
+    TraceSpan span("typecheck", "typecheck body", func->func_name);
+    int saved_instance = current_instance_id;
+    int saved_loop_depth = loop_depth;
+    auto saved_constexpr_values = known_constexpr_values;
+    current_instance_id = instance_id;
+    loop_depth = 0;
+    check_func_body(func);
+    current_instance_id = saved_instance;
+    loop_depth = saved_loop_depth;
+    known_constexpr_values = std::move(saved_constexpr_values);
+}
+
+void TypeChecker::materialize_function(const Symbol* func_sym) {
+    if (!func_sym || !func_sym->declaration) return;
+    auto body_it = deferred_function_bodies.find(func_sym);
+    if (body_it != deferred_function_bodies.end()) {
+        const int instance_id = body_it->second;
+        deferred_function_bodies.erase(body_it);
+        try {
+            check_deferred_body(func_sym->declaration, instance_id);
+        } catch (const CompileError&) {
+            if (!deferred_body_error) deferred_body_error = std::current_exception();
+            throw;
+        }
+        return;
+    }
+    auto it = deferred_instantiations.find(func_sym->declaration.get());
+    if (it == deferred_instantiations.end()) return;
+    DeferredInstantiation deferred = std::move(it->second);
+    deferred_instantiations.erase(it);
+
+    StmtPtr func = func_sym->declaration;
+    func->body = clone_function(deferred.generic_func, deferred.concrete_types)->body;
+    if (resolver) {
+        resolver->resolve_generated_body(func, deferred.instance_id);
+    }
+    check_instantiation(func, deferred.instance_id);
+}
+
+Symbol* TypeChecker::create_specialization(StmtPtr func,
+                                           const std::vector<std::pair<size_t, ExprPtr>>& bound,
+                                           int instance_id) {
+    if (!resolver || !func || !func->body) return nullptr;
+
+    std::string name;
+    for (size_t n = 0;; ++n) {
+        name = func->func_name + "_S" + std::to_string(n);
+        if (!resolver->lookup_internal_in_instance(instance_id, name)) break;
+    }
+
+    clone_declarations_of_instance = instance_id;
+    StmtPtr cloned = clone_function(func, {});
+    clone_declarations_of_instance = -1;
+    cloned->func_name = name;
+    cloned->is_exported = false;
+
+    // Bound parameters become the body's first statements, so every read of
+    // one sees the literal and the optimizer can fold through it.
+    std::vector<StmtPtr> prologue;
+    std::vector<bool> drop(cloned->params.size(), false);
+    for (const auto& entry : bound) {
+        const Parameter& param = cloned->params[entry.first];
+        prologue.push_back(Stmt::make_var(param.name, param.type, clone_expr(entry.second, nullptr), false, param.location));
+        drop[entry.first] = true;
+    }
+    std::vector<Parameter> kept;
+    for (size_t i = 0; i < cloned->params.size(); ++i) {
+        if (!drop[i]) kept.push_back(cloned->params[i]);
+    }
+    cloned->params = std::move(kept);
+    if (cloned->body->kind == Expr::Kind::Block) {
+        cloned->body->statements.insert(cloned->body->statements.begin(), prologue.begin(), prologue.end());
+    } else {
+        cloned->body = Expr::make_block(std::move(prologue), cloned->body, cloned->body->location);
+    }
+
+    resolver->resolve_generated_function(cloned, instance_id);
+    check_instantiation(cloned, instance_id);
+    return resolver->lookup_internal_in_instance(instance_id, name);
+}
+
+void TypeChecker::rebind_call_target(int instance_id, const ExprPtr& call, Symbol* target) {
+    if (!call || !call->operand || !target) return;
+    call->operand->name = target->name;
+    call->operand->resolved_symbol = target;
+    if (bindings) {
+        bindings->bind(instance_id, call->operand.get(), target);
+    }
+}
+
 std::string TypeChecker::mangle_generic_name(const std::string& base_name,
                                               const std::vector<TypePtr>& types) {
     std::string result = base_name + "_G";
@@ -233,8 +294,89 @@ std::string TypeChecker::mangle_generic_name(const std::string& base_name,
 
     return result;
 }
-StmtPtr TypeChecker::clone_function(StmtPtr func) {
-    auto cloned = std::make_shared<Stmt>();
+namespace {
+
+void collect_typevar_bindings(TypePtr pattern,
+                              TypePtr concrete,
+                              std::unordered_map<std::string, TypePtr>& type_map) {
+    if (!pattern || !concrete) return;
+    if (pattern->kind == Type::Kind::TypeVar) {
+        type_map[pattern->var_name] = concrete;
+        return;
+    }
+    if (pattern->kind == Type::Kind::Array && concrete->kind == Type::Kind::Array) {
+        collect_typevar_bindings(pattern->element_type, concrete->element_type, type_map);
+    }
+}
+
+// Mirrors the shapes substitute_type_with_map rewrites.
+bool type_mentions_type_var(const TypePtr& type) {
+    if (!type) return false;
+    if (type->kind == Type::Kind::TypeVar) return true;
+    if (type->kind == Type::Kind::Array) return type_mentions_type_var(type->element_type);
+    return false;
+}
+
+bool stmt_mentions_type_vars(const StmtPtr& stmt);
+
+bool expr_mentions_type_vars(const ExprPtr& expr) {
+    if (!expr) return false;
+    if (type_mentions_type_var(expr->type) ||
+        type_mentions_type_var(expr->declared_var_type) ||
+        type_mentions_type_var(expr->target_type)) {
+        return true;
+    }
+    const ExprPtr* children[] = {&expr->left, &expr->right, &expr->operand, &expr->condition.value(),
+                                 &expr->true_expr.value(), &expr->false_expr.value(), &expr->result_expr.value()};
+    for (const ExprPtr* child : children) {
+        if (expr_mentions_type_vars(*child)) return true;
+    }
+    for (const auto& arg : expr->args) {
+        if (expr_mentions_type_vars(arg)) return true;
+    }
+    for (const auto& elem : expr->elements) {
+        if (expr_mentions_type_vars(elem)) return true;
+    }
+    for (const auto& rec : expr->receivers) {
+        if (expr_mentions_type_vars(rec)) return true;
+    }
+    for (const auto& stmt : expr->statements) {
+        if (stmt_mentions_type_vars(stmt)) return true;
+    }
+    return false;
+}
+
+// Only the statement kinds clone_stmt copies matter here.
+bool stmt_mentions_type_vars(const StmtPtr& stmt) {
+    if (!stmt) return false;
+    switch (stmt->kind) {
+        case Stmt::Kind::Expr:
+        case Stmt::Kind::Return:
+            return expr_mentions_type_vars(stmt->expr) || expr_mentions_type_vars(stmt->return_expr);
+        case Stmt::Kind::VarDecl:
+            return type_mentions_type_var(stmt->var_type) || expr_mentions_type_vars(stmt->var_init);
+        case Stmt::Kind::ConditionalStmt:
+            return expr_mentions_type_vars(stmt->condition) || stmt_mentions_type_vars(stmt->true_stmt);
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+const GenericTemplate& TypeChecker::generic_template_for(StmtPtr generic_func) {
+    auto it = generic_templates.find(generic_func.get());
+    if (it != generic_templates.end()) {
+        return it->second;
+    }
+    GenericTemplate tmpl;
+    tmpl.body_mentions_type_vars = expr_mentions_type_vars(generic_func->body);
+    return generic_templates.emplace(generic_func.get(), tmpl).first->second;
+}
+
+StmtPtr TypeChecker::clone_function(StmtPtr func, const std::vector<TypePtr>& concrete_types, bool clone_body) {
+    TraceSpan span("typecheck", "instantiate", func->func_name);
+    auto cloned = make_ast_node<Stmt>();
     cloned->kind = func->kind;
     cloned->location = func->location;
     cloned->annotations = func->annotations;
@@ -246,24 +388,61 @@ StmtPtr TypeChecker::clone_function(StmtPtr func) {
     cloned->type_namespace = func->type_namespace;
 
     // Clone parameters
+    cloned->params.reserve(func->params.size());
     for (const auto& param : func->params) {
         cloned->params.push_back(Parameter(param.name, param.type, param.is_expression_param, param.location, param.annotations));
     }
     cloned->ref_params = func->ref_params;
     cloned->ref_param_types = func->ref_param_types;
+    cloned->return_type = func->return_type;
+    cloned->return_types = func->return_types;
 
-    // Clone return type
-    cloned->return_type = func->return_type; // Will be substituted later
+    // Bind type variables from the call site, then rewrite the signature.
+    TypeSubstitution substitutions;
+    size_t concrete_index = 0;
+    for (size_t i = 0; i < cloned->ref_param_types.size() && concrete_index < concrete_types.size(); ++i, ++concrete_index) {
+        TypePtr concrete = concrete_types[concrete_index];
+        if (!concrete) continue;
+        collect_typevar_bindings(cloned->ref_param_types[i], concrete, substitutions);
+        cloned->ref_param_types[i] = concrete;
+    }
+    for (size_t i = 0; i < cloned->params.size() && concrete_index < concrete_types.size(); i++, ++concrete_index) {
+        TypePtr concrete = concrete_types[concrete_index];
+        if (!concrete) continue;
+        collect_typevar_bindings(cloned->params[i].type, concrete, substitutions);
+        cloned->params[i].type = concrete;
+    }
 
-    // Clone body
-    cloned->body = func->body ? clone_expr(func->body) : nullptr;
+    for (auto& param : cloned->params) {
+        param.type = substitute_type_with_map(param.type, substitutions);
+    }
+    for (auto& ref_type : cloned->ref_param_types) {
+        ref_type = substitute_type_with_map(ref_type, substitutions);
+    }
+    cloned->return_type = substitute_type_with_map(cloned->return_type, substitutions);
+    for (auto& ret_type : cloned->return_types) {
+        ret_type = substitute_type_with_map(ret_type, substitutions);
+    }
+
+    if (!clone_body) {
+        return cloned;
+    }
+
+    // Clone the body, substituting type annotations on the way down so the
+    // copy is walked only once.
+    const bool body_needs_map = !substitutions.empty() && generic_template_for(func).body_mentions_type_vars;
+    cloned->body = clone_expr(func->body, body_needs_map ? &substitutions : nullptr);
 
     return cloned;
 }
-ExprPtr TypeChecker::clone_expr(ExprPtr expr) {
+ExprPtr TypeChecker::clone_expr(ExprPtr expr, const TypeSubstitution* type_map) {
     if (!expr) return nullptr;
 
-    auto cloned = std::make_shared<Expr>();
+    auto substitute = [&](const TypePtr& type) {
+        return type_map ? substitute_type_with_map(type, *type_map) : type;
+    };
+
+    auto cloned = make_ast_node<Expr>();
     cloned->kind = expr->kind;
     cloned->location = expr->location;
     cloned->annotations = expr->annotations;
@@ -275,83 +454,98 @@ ExprPtr TypeChecker::clone_expr(ExprPtr expr) {
     cloned->has_exact_int_val = expr->has_exact_int_val;
     cloned->float_val = expr->float_val;
     cloned->string_val = expr->string_val;
+    cloned->raw_literal = expr->raw_literal;
+    cloned->literal_is_unsigned = expr->literal_is_unsigned;
     cloned->resource_path = expr->resource_path;
+    cloned->process_command = expr->process_command;
 
     // Clone identifier info
     cloned->name = expr->name;
     cloned->is_expr_param_ref = expr->is_expr_param_ref;
     cloned->creates_new_variable = expr->creates_new_variable;
-    cloned->declared_var_type = expr->declared_var_type;
+    cloned->declared_var_type = substitute(expr->declared_var_type);
     cloned->is_mutable_binding = expr->is_mutable_binding;
 
     // Clone operator
     cloned->op = expr->op;
+    cloned->binary_op = expr->binary_op;
+    cloned->unary_op = expr->unary_op;
+    cloned->assign_op = expr->assign_op;
 
     // Clone sub-expressions
-    cloned->left = clone_expr(expr->left);
-    cloned->right = clone_expr(expr->right);
-    cloned->operand = clone_expr(expr->operand);
-    cloned->condition = clone_expr(expr->condition);
-    cloned->true_expr = clone_expr(expr->true_expr);
-    cloned->false_expr = clone_expr(expr->false_expr);
-    cloned->result_expr = clone_expr(expr->result_expr);
-    cloned->target_type = expr->target_type;
-
-    // Clone arguments
-    for (const auto& arg : expr->args) {
-        cloned->args.push_back(clone_expr(arg));
+    cloned->left = clone_expr(expr->left, type_map);
+    // A checked declaration no longer spells its type; specializations
+    // restate it from the declared symbol so the clone checks the same way.
+    if (clone_declarations_of_instance >= 0 && expr->kind == Expr::Kind::Assignment &&
+        expr->creates_new_variable && cloned->left && !cloned->left->type) {
+        if (Symbol* declared = binding_for(clone_declarations_of_instance, expr->left.get())) {
+            cloned->left->type = declared->type;
+        }
     }
+    cloned->right = clone_expr(expr->right, type_map);
+    cloned->operand = clone_expr(expr->operand, type_map);
+    cloned->condition = clone_expr(expr->condition, type_map);
+    cloned->true_expr = clone_expr(expr->true_expr, type_map);
+    cloned->false_expr = clone_expr(expr->false_expr, type_map);
+    cloned->result_expr = clone_expr(expr->result_expr, type_map);
+    cloned->target_type = substitute(expr->target_type);
 
-    // Clone elements
+    // Clone arguments, elements and receivers
+    cloned->args.reserve(expr->args.size());
+    for (const auto& arg : expr->args) {
+        cloned->args.push_back(clone_expr(arg, type_map));
+    }
+    cloned->elements.reserve(expr->elements.size());
     for (const auto& elem : expr->elements) {
-        cloned->elements.push_back(clone_expr(elem));
+        cloned->elements.push_back(clone_expr(elem, type_map));
     }
-
-    // Clone receivers
+    cloned->receivers.reserve(expr->receivers.size());
     for (const auto& rec : expr->receivers) {
-        cloned->receivers.push_back(clone_expr(rec));
+        cloned->receivers.push_back(clone_expr(rec, type_map));
     }
     cloned->is_constructor_call = expr->is_constructor_call;
     cloned->is_existence_probe = expr->is_existence_probe;
     cloned->is_optional_semantic_block = expr->is_optional_semantic_block;
+    cloned->is_sorted_iteration = expr->is_sorted_iteration;
+    cloned->was_parenthesized = expr->was_parenthesized;
 
     // Clone statements (for blocks) - deep cloning
+    cloned->statements.reserve(expr->statements.size());
     for (const auto& stmt : expr->statements) {
-        cloned->statements.push_back(clone_stmt(stmt));
+        cloned->statements.push_back(clone_stmt(stmt, type_map));
     }
 
     return cloned;
 }
-StmtPtr TypeChecker::clone_stmt(StmtPtr stmt) {
+StmtPtr TypeChecker::clone_stmt(StmtPtr stmt, const TypeSubstitution* type_map) {
     if (!stmt) return nullptr;
 
-    auto cloned = std::make_shared<Stmt>();
+    auto cloned = make_ast_node<Stmt>();
     cloned->kind = stmt->kind;
     cloned->location = stmt->location;
     cloned->annotations = stmt->annotations;
     cloned->is_instantiation = stmt->is_instantiation;
-    cloned->ref_param_symbols.clear();
 
     // Clone based on statement type
     switch (stmt->kind) {
         case Stmt::Kind::Expr:
         case Stmt::Kind::Return:
-            cloned->expr = clone_expr(stmt->expr);
-            cloned->return_expr = clone_expr(stmt->return_expr);
+            cloned->expr = clone_expr(stmt->expr, type_map);
+            cloned->return_expr = clone_expr(stmt->return_expr, type_map);
             break;
 
         case Stmt::Kind::VarDecl:
             cloned->var_name = stmt->var_name;
-            cloned->var_type = stmt->var_type;
-            cloned->var_init = clone_expr(stmt->var_init);
+            cloned->var_type = type_map ? substitute_type_with_map(stmt->var_type, *type_map) : stmt->var_type.value();
+            cloned->var_init = clone_expr(stmt->var_init, type_map);
             cloned->is_mutable = stmt->is_mutable;
             cloned->is_exported = stmt->is_exported;
             cloned->var_linkage = stmt->var_linkage;
             break;
 
         case Stmt::Kind::ConditionalStmt:
-            cloned->condition = clone_expr(stmt->condition);
-            cloned->true_stmt = clone_stmt(stmt->true_stmt);
+            cloned->condition = clone_expr(stmt->condition, type_map);
+            cloned->true_stmt = clone_stmt(stmt->true_stmt, type_map);
             break;
 
         case Stmt::Kind::Break:
@@ -367,23 +561,6 @@ StmtPtr TypeChecker::clone_stmt(StmtPtr stmt) {
     return cloned;
 }
 
-namespace {
-
-void collect_typevar_bindings(TypePtr pattern,
-                              TypePtr concrete,
-                              std::unordered_map<std::string, TypePtr>& type_map) {
-    if (!pattern || !concrete) return;
-    if (pattern->kind == Type::Kind::TypeVar) {
-        type_map[pattern->var_name] = concrete;
-        return;
-    }
-    if (pattern->kind == Type::Kind::Array && concrete->kind == Type::Kind::Array) {
-        collect_typevar_bindings(pattern->element_type, concrete->element_type, type_map);
-    }
-}
-
-} // namespace
-
 TypePtr TypeChecker::substitute_type_with_map(TypePtr type,
                                               const std::unordered_map<std::string, TypePtr>& type_map) {
     if (!type) return nullptr;
@@ -401,7 +578,7 @@ TypePtr TypeChecker::substitute_type_with_map(TypePtr type,
         if (elem == type->element_type) {
             return type;
         }
-        TypePtr cloned = std::make_shared<Type>(*type);
+        TypePtr cloned = make_ast_node<Type>(*type);
         cloned->element_type = elem;
         return cloned;
     }
@@ -409,109 +586,4 @@ TypePtr TypeChecker::substitute_type_with_map(TypePtr type,
     return type;
 }
 
-void TypeChecker::substitute_types(StmtPtr func, const std::vector<TypePtr>& concrete_types) {
-    if (!func) return;
-
-    std::unordered_map<std::string, TypePtr> substitutions;
-
-    size_t concrete_index = 0;
-    for (size_t i = 0; i < func->ref_param_types.size() && concrete_index < concrete_types.size(); ++i, ++concrete_index) {
-        TypePtr concrete = concrete_types[concrete_index];
-        if (!concrete) continue;
-        collect_typevar_bindings(func->ref_param_types[i], concrete, substitutions);
-        func->ref_param_types[i] = concrete;
-    }
-
-    for (size_t i = 0; i < func->params.size() && concrete_index < concrete_types.size(); i++, ++concrete_index) {
-        TypePtr concrete = concrete_types[concrete_index];
-        if (!concrete) continue;
-        collect_typevar_bindings(func->params[i].type, concrete, substitutions);
-        func->params[i].type = concrete;
-    }
-
-    for (auto& param : func->params) {
-        param.type = substitute_type_with_map(param.type, substitutions);
-    }
-    for (auto& ref_type : func->ref_param_types) {
-        ref_type = substitute_type_with_map(ref_type, substitutions);
-    }
-    func->return_type = substitute_type_with_map(func->return_type, substitutions);
-    for (auto& ret_type : func->return_types) {
-        ret_type = substitute_type_with_map(ret_type, substitutions);
-    }
-
-    if (func->body) {
-        substitute_types_in_expr(func->body, substitutions);
-    }
-}
-
-void TypeChecker::substitute_types_in_stmt(StmtPtr stmt,
-                                           const std::unordered_map<std::string, TypePtr>& type_map) {
-    if (!stmt) return;
-
-    switch (stmt->kind) {
-        case Stmt::Kind::Expr:
-            substitute_types_in_expr(stmt->expr, type_map);
-            break;
-        case Stmt::Kind::Return:
-            substitute_types_in_expr(stmt->return_expr, type_map);
-            break;
-        case Stmt::Kind::VarDecl:
-            stmt->var_type = substitute_type_with_map(stmt->var_type, type_map);
-            substitute_types_in_expr(stmt->var_init, type_map);
-            break;
-        case Stmt::Kind::ConditionalStmt:
-            substitute_types_in_expr(stmt->condition, type_map);
-            substitute_types_in_stmt(stmt->true_stmt, type_map);
-            break;
-        case Stmt::Kind::FuncDecl:
-            for (auto& param : stmt->params) {
-                param.type = substitute_type_with_map(param.type, type_map);
-            }
-            for (auto& ref_type : stmt->ref_param_types) {
-                ref_type = substitute_type_with_map(ref_type, type_map);
-            }
-            stmt->return_type = substitute_type_with_map(stmt->return_type, type_map);
-            for (auto& ret_type : stmt->return_types) {
-                ret_type = substitute_type_with_map(ret_type, type_map);
-            }
-            substitute_types_in_expr(stmt->body, type_map);
-            break;
-        default:
-            break;
-    }
-}
-
-void TypeChecker::substitute_types_in_expr(ExprPtr expr, const std::unordered_map<std::string, TypePtr>& type_map) {
-    if (!expr) return;
-
-    expr->type = substitute_type_with_map(expr->type, type_map);
-    expr->declared_var_type = substitute_type_with_map(expr->declared_var_type, type_map);
-    expr->target_type = substitute_type_with_map(expr->target_type, type_map);
-
-    substitute_types_in_expr(expr->left, type_map);
-    substitute_types_in_expr(expr->right, type_map);
-    substitute_types_in_expr(expr->operand, type_map);
-    substitute_types_in_expr(expr->condition, type_map);
-    substitute_types_in_expr(expr->true_expr, type_map);
-    substitute_types_in_expr(expr->false_expr, type_map);
-    substitute_types_in_expr(expr->result_expr, type_map);
-
-    for (auto& arg : expr->args) {
-        substitute_types_in_expr(arg, type_map);
-    }
-
-    for (auto& elem : expr->elements) {
-        substitute_types_in_expr(elem, type_map);
-    }
-
-    for (auto& receiver : expr->receivers) {
-        substitute_types_in_expr(receiver, type_map);
-    }
-
-    for (auto& stmt : expr->statements) {
-        substitute_types_in_stmt(stmt, type_map);
-    }
-}
-
 } // namespace vexel
@@ -0,0 +1,235 @@
+#include "typechecker.h"
+#include "ast_walk.h"
+#include <functional>
+#include <unordered_map>
+
+namespace vexel {
+
+namespace {
+
+// Typed deep copy of a checked body within one module instance. Bindings and
+// new-variable flags follow every copied node; symbols of locals declared in
+// the body are replaced by renamed copies so the result can sit inside any
+// caller without shadowing its names.
+class CheckedBodyCopier {
+public:
+    CheckedBodyCopier(Bindings& bindings, Program& program, int instance_id, std::string suffix)
+        : bindings_(bindings), program_(program), instance_id_(instance_id), suffix_(std::move(suffix)) {}
+
+    Symbol* local_copy(const Symbol* sym) {
+        auto it = locals_.find(sym);
+        if (it != locals_.end()) return it->second;
+        auto copy = std::make_unique<Symbol>(*sym);
+        if (copy->name != "_") {
+            copy->name = sym->name + suffix_;
+            copy->surface_name = copy->name;
+        }
+        copy->id = static_cast<int>(program_.symbols.size());
+        Symbol* out = copy.get();
+        program_.symbols.push_back(std::move(copy));
+        locals_[sym] = out;
+        return out;
+    }
+
+    ExprPtr copy(const ExprPtr& expr) {
+        if (!expr) return nullptr;
+        ExprPtr out = make_ast_node<Expr>(*expr);
+        Symbol* local = copy_binding(expr.get(), out.get());
+        if (local && out->kind == Expr::Kind::Identifier) {
+            out->name = local->name;
+            if (out->resolved_symbol) out->resolved_symbol = local;
+        }
+        out->left = copy(expr->left);
+        out->right = copy(expr->right);
+        out->operand = copy(expr->operand);
+        out->condition = copy(expr->condition);
+        out->true_expr = copy(expr->true_expr);
+        out->false_expr = copy(expr->false_expr);
+        out->result_expr = copy(expr->result_expr);
+        for (auto& arg : out->args) arg = copy(arg);
+        for (auto& rec : out->receivers) rec = copy(rec);
+        for (auto& elem : out->elements) elem = copy(elem);
+        for (auto& stmt : out->statements) stmt = copy(stmt);
+        return out;
+    }
+
+    StmtPtr copy(const StmtPtr& stmt) {
+        if (!stmt) return nullptr;
+        StmtPtr out = make_ast_node<Stmt>(*stmt);
+        Symbol* local = copy_binding(stmt.get(), out.get());
+        if (local && out->kind == Stmt::Kind::VarDecl) {
+            out->var_name = local->name;
+            local->declaration = out;
+        }
+        if (local && out->resolved_symbol) out->resolved_symbol = local;
+        out->expr = copy(stmt->expr);
+        out->return_expr = copy(stmt->return_expr);
+        out->var_init = copy(stmt->var_init);
+        out->condition = copy(stmt->condition);
+        out->true_stmt = copy(stmt->true_stmt);
+        return out;
+    }
+
+private:
+    // Returns the local copy `to` is bound to, or null when it is unbound or
+    // bound to a symbol declared outside the body.
+    Symbol* copy_binding(const void* from, const void* to) {
+        Symbol* sym = bindings_.lookup(instance_id_, from);
+        Symbol* local = sym && sym->is_local ? local_copy(sym) : nullptr;
+        if (sym) bindings_.bind(instance_id_, to, local ? local : sym);
+        if (bindings_.is_new_variable(instance_id_, from)) bindings_.set_new_variable(instance_id_, to, true);
+        return local;
+    }
+
+    Bindings& bindings_;
+    Program& program_;
+    int instance_id_;
+    std::string suffix_;
+    std::unordered_map<const Symbol*, Symbol*> locals_;
+};
+
+} // namespace
+
+bool TypeChecker::reads_only_constants(const ExprPtr& expr, int instance_id) const {
+    if (!expr) return true;
+    switch (expr->kind) {
+        case Expr::Kind::IntLiteral:
+        case Expr::Kind::FloatLiteral:
+        case Expr::Kind::CharLiteral:
+        case Expr::Kind::StringLiteral:
+            return true;
+        case Expr::Kind::Identifier: {
+            const Symbol* sym = bindings ? bindings->lookup(instance_id, expr.get()) : nullptr;
+            return sym && sym->kind == Symbol::Kind::Constant && !sym->is_external;
+        }
+        case Expr::Kind::Unary:
+        case Expr::Kind::Cast:
+            return reads_only_constants(expr->operand, instance_id);
+        case Expr::Kind::Binary:
+            return reads_only_constants(expr->left, instance_id) &&
+                   reads_only_constants(expr->right, instance_id);
+        default:
+            return false;
+    }
+}
+
+bool TypeChecker::writes_symbol(const ExprPtr& body, const Symbol* sym, int instance_id) const {
+    bool found = false;
+    auto written = [&](ExprPtr target) {
+        while (target && (target->kind == Expr::Kind::Index || target->kind == Expr::Kind::Member)) {
+            target = target->operand;
+        }
+        if (target && binding_for(instance_id, target.get()) == sym) found = true;
+    };
+    std::function<void(const StmtPtr&)> visit_stmt;
+    std::function<void(const ExprPtr&)> visit = [&](const ExprPtr& expr) {
+        if (!expr || found) return;
+        if (expr->kind == Expr::Kind::Assignment && !expr->creates_new_variable) written(expr->left);
+        if (expr->kind == Expr::Kind::Call) {
+            for (const auto& rec : expr->receivers) written(rec);
+        }
+        for_each_expr_child(expr, visit, visit_stmt);
+    };
+    visit_stmt = [&](const StmtPtr& stmt) {
+        if (!found) for_each_stmt_child(stmt, visit, visit_stmt);
+    };
+    visit(body);
+    return found;
+}
+
+StmtPtr TypeChecker::declare_synthesized_local(const std::string& name,
+                                               ExprPtr init,
+                                               bool is_mutable,
+                                               int instance_id) {
+    if (!program || !bindings || !init) return nullptr;
+    auto sym = std::make_unique<Symbol>();
+    sym->kind = Symbol::Kind::Variable;
+    sym->name = name;
+    sym->surface_name = name;
+    sym->type = init->type;
+    sym->is_mutable = is_mutable;
+    sym->is_local = true;
+    sym->instance_id = instance_id;
+    if (instance_id >= 0 && static_cast<size_t>(instance_id) < program->instances.size()) {
+        sym->module_id = program->instances[static_cast<size_t>(instance_id)].module_id;
+    }
+    sym->id = static_cast<int>(program->symbols.size());
+    const SourceLocation loc = init->location;
+    ExprPtr target = Expr::make_identifier(name, loc);
+    target->type = sym->type;
+    ExprPtr decl = Expr::make_assignment(target, init, loc);
+    decl->creates_new_variable = true;
+    decl->declared_var_type = sym->type;
+    decl->type = sym->type;
+    bindings->bind(instance_id, target.get(), sym.get());
+    bindings->set_new_variable(instance_id, decl.get(), true);
+    program->symbols.push_back(std::move(sym));
+    return Stmt::make_expr(decl, loc);
+}
+
+ExprPtr TypeChecker::make_symbol_reference(Symbol* sym, int instance_id, const SourceLocation& loc) {
+    ExprPtr ref = Expr::make_identifier(sym->name, loc);
+    ref->type = sym->type;
+    ref->resolved_symbol = sym;
+    ref->is_mutable_binding = sym->is_mutable;
+    if (bindings) bindings->bind(instance_id, ref.get(), sym);
+    return ref;
+}
+
+ExprPtr TypeChecker::inline_call_body(const ExprPtr& call,
+                                      const StmtPtr& callee,
+                                      int instance_id,
+                                      const std::string& suffix) {
+    if (!bindings || !program || !call || !callee || !callee->body ||
+        call->args.size() != callee->params.size()) {
+        return nullptr;
+    }
+    CheckedBodyCopier copier(*bindings, *program, instance_id, suffix);
+
+    // Each argument initializes a declaration of its parameter's copy, in
+    // argument order, ahead of the body. Arguments that only read constants
+    // become immutable locals, which compile-time evaluation folds through,
+    // unless the body writes the parameter.
+    std::vector<StmtPtr> statements;
+    for (size_t i = 0; i < callee->params.size(); ++i) {
+        const Parameter& param = callee->params[i];
+        Symbol* param_sym = bindings->lookup(instance_id, &param);
+        if (!param_sym) return nullptr;
+        Symbol* local = copier.local_copy(param_sym);
+        const ExprPtr& arg = call->args[i];
+
+        if (reads_only_constants(arg, instance_id) && !writes_symbol(callee->body, param_sym, instance_id)) {
+            StmtPtr decl = Stmt::make_var(local->name, param.type, arg, false, param.location);
+            local->kind = Symbol::Kind::Constant;
+            local->is_mutable = false;
+            local->declaration = decl;
+            bindings->bind(instance_id, decl.get(), local);
+            statements.push_back(decl);
+            continue;
+        }
+        local->kind = Symbol::Kind::Variable;
+        local->declaration = nullptr;
+        ExprPtr target = Expr::make_identifier(local->name, param.location);
+        ExprPtr decl = Expr::make_assignment(target, arg, param.location);
+        decl->creates_new_variable = true;
+        decl->declared_var_type = param.type;
+        decl->type = param.type;
+        bindings->bind(instance_id, target.get(), local);
+        bindings->set_new_variable(instance_id, decl.get(), true);
+        statements.push_back(Stmt::make_expr(decl, param.location));
+    }
+
+    ExprPtr body = copier.copy(callee->body);
+    ExprPtr result;
+    if (body->kind == Expr::Kind::Block && !body->is_optional_semantic_block) {
+        statements.insert(statements.end(), body->statements.begin(), body->statements.end());
+        result = body->result_expr;
+    } else {
+        result = body;
+    }
+    ExprPtr block = Expr::make_block(std::move(statements), result, call->location);
+    block->type = call->type;
+    return block;
+}
+
+} // namespace vexel
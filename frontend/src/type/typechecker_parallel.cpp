@@ -0,0 +1,239 @@
+#include "typechecker.h"
+#include "ast_arena.h"
+#include "ast_walk.h"
+#include "thread_pool.h"
+#include <exception>
+#include <functional>
+
+namespace vexel {
+
+// Parallel type checking schedules module instances over the import DAG in
+// waves: a wave holds every unchecked instance whose imports are all checked.
+// Within a wave, instances that cannot write outside their own module are
+// checked by worker TypeCheckers; the rest run serially on this checker.
+//
+// A worker sees the statements checked so far through a read-only pointer and
+// starts from copies of the inference tables, so earlier waves are immutable
+// while it runs. Workers draw fresh type variables from a per-instance prefix,
+// which lets their tables merge back (in instance order) without renaming.
+// Writes outside the instance's module come from generic instantiation (the
+// resolver defines the clone in the owner's scope) and from optional semantic
+// blocks (which snapshot and restore every module); instances whose module has
+// several instances share its AST. All three keep the instance serial.
+
+bool TypeChecker::module_blocks_parallel_check(const Module& mod) {
+    bool blocked = false;
+    std::function<void(const ExprPtr&)> visit_expr;
+    std::function<void(const StmtPtr&)> visit_stmt;
+    visit_expr = [&](const ExprPtr& expr) {
+        if (!expr || blocked) return;
+        if (expr->kind == Expr::Kind::Block && expr->is_optional_semantic_block) {
+            blocked = true;
+            return;
+        }
+        for_each_expr_child(expr, visit_expr, visit_stmt);
+    };
+    visit_stmt = [&](const StmtPtr& stmt) {
+        if (!stmt || blocked) return;
+        if (stmt->kind == Stmt::Kind::FuncDecl && is_generic_function(stmt)) {
+            blocked = true;
+            return;
+        }
+        if (stmt->kind == Stmt::Kind::TypeDecl) {
+            for (const auto& field : stmt->fields) {
+                if (!field.type || field.type->kind == Type::Kind::TypeVar) {
+                    blocked = true;
+                    return;
+                }
+            }
+        }
+        for_each_stmt_child(stmt, visit_expr, visit_stmt);
+    };
+    for (const auto& stmt : mod.top_level) {
+        visit_stmt(stmt);
+    }
+    return blocked;
+}
+
+std::vector<bool> TypeChecker::parallel_check_candidates(const Program& program_in) {
+    const size_t module_count = program_in.modules.size();
+    std::vector<int> instances_per_module(module_count, 0);
+    for (const auto& instance : program_in.instances) {
+        ++instances_per_module[static_cast<size_t>(instance.module_id)];
+    }
+
+    enum class State : uint8_t { Unknown, Blocked, Clear };
+    std::vector<State> module_state(module_count, State::Unknown);
+    auto module_blocked = [&](int module_id) {
+        State& state = module_state[static_cast<size_t>(module_id)];
+        if (state == State::Unknown) {
+            state = module_blocks_parallel_check(program_in.modules[static_cast<size_t>(module_id)].module)
+                        ? State::Blocked
+                        : State::Clear;
+        }
+        return state == State::Blocked;
+    };
+
+    // Closure state per instance; an import cycle counts as blocked.
+    std::vector<State> closure(program_in.instances.size(), State::Unknown);
+    std::vector<bool> visiting(program_in.instances.size(), false);
+    std::function<bool(int)> closure_blocked = [&](int id) {
+        const size_t index = static_cast<size_t>(id);
+        if (closure[index] != State::Unknown) return closure[index] == State::Blocked;
+        if (visiting[index]) return true;
+        visiting[index] = true;
+        const ModuleInstance& instance = program_in.instances[index];
+        bool blocked = module_blocked(instance.module_id);
+        for (size_t i = 0; !blocked && i < instance.imports.size(); ++i) {
+            blocked = closure_blocked(instance.imports[i]);
+        }
+        visiting[index] = false;
+        closure[index] = blocked ? State::Blocked : State::Clear;
+        return blocked;
+    };
+
+    std::vector<bool> candidates(program_in.instances.size(), false);
+    for (const auto& instance : program_in.instances) {
+        candidates[static_cast<size_t>(instance.id)] =
+            instances_per_module[static_cast<size_t>(instance.module_id)] == 1 && !closure_blocked(instance.id);
+    }
+    return candidates;
+}
+
+std::unique_ptr<TypeChecker> TypeChecker::make_instance_worker(int instance_id) {
+    auto worker = std::make_unique<TypeChecker>(project_root, allow_process, resolver, bindings, program,
+                                                type_strictness);
+    worker->shared_checked_statements = &checked_statements;
+    worker->type_var_prefix = "T" + std::to_string(instance_id) + "_";
+    worker->type_var_ids = type_var_ids;
+    worker->type_vars = type_vars;
+    worker->type_vars.start_tracking();
+    worker->forced_tuple_types = forced_tuple_types;
+    worker->constexpr_facts_ = constexpr_facts_;
+    worker->process_cache = process_cache;
+    worker->directory_cache = directory_cache;
+    worker->cte_step_budget = cte_step_budget;
+    worker->cte_memory_limit = cte_memory_limit;
+    worker->cte_peak_bytes = cte_peak_bytes;
+    worker->cte_profile = cte_profile;
+    worker->type_interner = type_interner;
+    worker->check_all = check_all;
+    worker->set_current_instance(instance_id);
+    return worker;
+}
+
+std::unique_ptr<TypeChecker> TypeChecker::make_query_worker() const {
+    auto worker = std::make_unique<TypeChecker>(project_root, allow_process, resolver, bindings, program,
+                                                type_strictness);
+    worker->persistent_cte_cache = persistent_cte_cache;
+    worker->type_var_ids = type_var_ids;
+    worker->process_cache = process_cache;
+    worker->directory_cache = directory_cache;
+    worker->cte_step_budget = cte_step_budget;
+    worker->cte_memory_limit = cte_memory_limit;
+    worker->cte_peak_bytes = cte_peak_bytes;
+    worker->cte_profile = cte_profile;
+    worker->type_interner = type_interner;
+    return worker;
+}
+
+void TypeChecker::merge_instance_worker(TypeChecker& worker) {
+    checked_statements.insert(worker.checked_statements.begin(), worker.checked_statements.end());
+    type_vars.merge(worker.type_vars);
+    for (const auto& entry : worker.forced_tuple_types) {
+        register_tuple_type(entry.first, entry.second);
+    }
+    constexpr_facts_.merge_checked_conditions(worker.constexpr_facts_);
+    for (auto& entry : worker.instantiations) {
+        instantiations[entry.first].insert(entry.second.begin(), entry.second.end());
+    }
+    pending_instantiations.insert(pending_instantiations.end(),
+                                  worker.pending_instantiations.begin(),
+                                  worker.pending_instantiations.end());
+    deferred_instantiations.insert(worker.deferred_instantiations.begin(),
+                                   worker.deferred_instantiations.end());
+    deferred_function_bodies.insert(worker.deferred_function_bodies.begin(),
+                                    worker.deferred_function_bodies.end());
+}
+
+void TypeChecker::check_program_parallel(Program& program_in) {
+    const std::vector<bool> candidates = parallel_check_candidates(program_in);
+    const size_t instance_count = program_in.instances.size();
+    std::vector<bool> done(instance_count, false);
+    size_t remaining = instance_count;
+    ThreadPool pool(parallel_workers);
+
+    auto check_serially = [&](int id) {
+        const ModuleInstance& instance = program_in.instances[static_cast<size_t>(id)];
+        set_current_instance(id);
+        check_module(program_in.modules[static_cast<size_t>(instance.module_id)].module);
+    };
+
+    while (remaining > 0) {
+        std::vector<int> wave;
+        for (const auto& instance : program_in.instances) {
+            if (done[static_cast<size_t>(instance.id)]) continue;
+            bool ready = true;
+            for (ModuleInstanceId import_id : instance.imports) {
+                ready = ready && done[static_cast<size_t>(import_id)];
+            }
+            if (ready) wave.push_back(instance.id);
+        }
+        if (wave.empty()) {
+            // Import cycle: fall back to the lowest unchecked instance.
+            for (size_t i = 0; i < instance_count && wave.empty(); ++i) {
+                if (!done[i]) wave.push_back(static_cast<int>(i));
+            }
+        }
+
+        std::vector<int> concurrent;
+        std::vector<int> serial;
+        for (int id : wave) {
+            (candidates[static_cast<size_t>(id)] ? concurrent : serial).push_back(id);
+        }
+        if (concurrent.size() < 2) {
+            serial = wave;
+            concurrent.clear();
+        }
+
+        if (!concurrent.empty()) {
+            std::vector<std::unique_ptr<TypeChecker>> workers;
+            workers.reserve(concurrent.size());
+            for (int id : concurrent) {
+                workers.push_back(make_instance_worker(id));
+            }
+            std::vector<std::exception_ptr> errors(concurrent.size());
+            if (bindings) bindings->set_concurrent_access(true);
+            for (size_t k = 0; k < concurrent.size(); ++k) {
+                pool.submit([&, k]() {
+                    try {
+                        AstArenaScope arena_scope(program_in.ast_arena);
+                        const ModuleInstance& instance = program_in.instances[static_cast<size_t>(concurrent[k])];
+                        workers[k]->check_module(program_in.modules[static_cast<size_t>(instance.module_id)].module);
+                    } catch (...) {
+                        errors[k] = std::current_exception();
+                    }
+                });
+            }
+            pool.wait();
+            if (bindings) bindings->set_concurrent_access(false);
+            for (const std::exception_ptr& error : errors) {
+                if (error) std::rethrow_exception(error);
+            }
+            for (size_t k = 0; k < concurrent.size(); ++k) {
+                merge_instance_worker(*workers[k]);
+                done[static_cast<size_t>(concurrent[k])] = true;
+            }
+            remaining -= concurrent.size();
+        }
+
+        for (int id : serial) {
+            check_serially(id);
+            done[static_cast<size_t>(id)] = true;
+            --remaining;
+        }
+    }
+    set_current_instance(program_in.instances.back().id);
+}
+
+} // namespace vexel
@@ -155,14 +155,29 @@ bool TypeChecker::is_generic_function(StmtPtr func) {
 
     return has_untyped_receiver || has_untyped_param || has_typevar_return;
 }
+namespace {
+
+// Form produced by validate_type's array-size canonicalization below.
+bool is_canonical_array_size(const ExprPtr& size) {
+    return size->kind == Expr::Kind::IntLiteral && size->has_exact_int_val && size->literal_is_unsigned &&
+           !size->exact_int_val->is_negative() && size->raw_literal == size->exact_int_val->to_string();
+}
+
+} // namespace
+
 TypePtr TypeChecker::validate_type(TypePtr type, const SourceLocation& loc) {
     if (!type) return nullptr;
 
     switch (type->kind) {
         case Type::Kind::Array: {
             // Recursively validate element type and materialize any type expression.
-            type->element_type = validate_type(type->element_type, loc);
-            if (type->array_size) {
+            // Already-validated types are left untouched, so re-validating a
+            // type shared with another module's declarations never writes to it.
+            TypePtr element_type = validate_type(type->element_type, loc);
+            if (element_type != type->element_type) {
+                type->element_type = element_type;
+            }
+            if (type->array_size && !is_canonical_array_size(type->array_size)) {
                 CTEQueryResult size_query = query_constexpr(type->array_size);
                 if (size_query.status == CTEQueryStatus::Error) {
                     throw CompileError(size_query.message.empty()
@@ -171,7 +186,10 @@ TypePtr TypeChecker::validate_type(TypePtr type, const SourceLocation& loc) {
                                        loc);
                 }
                 if (size_query.status != CTEQueryStatus::Known) {
-                    throw CompileError("Array size must be a compile-time constant", loc);
+                    throw CompileError(size_query.budget_exhausted || size_query.memory_exhausted
+                                           ? "Array size must be a compile-time constant: " + size_query.message
+                                           : "Array size must be a compile-time constant",
+                                       loc);
                 }
 
                 const CTValue& size_val = size_query.value;
@@ -11,7 +11,7 @@ if ! rg -q "kMaxCteFixpointIterations" "$OPT_CPP"; then
   exit 1
 fi
 
-if ! rg -q "cte_engine_\\.query\\(" "$OPT_CPP"; then
+if ! rg -q "(cte_engine_|engine)\\.query\\(" "$OPT_CPP"; then
   echo "optimizer must consume CTE through the canonical CTE engine service" >&2
   exit 1
 fi
@@ -5,7 +5,7 @@ SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
 OPT_CPP="$ROOT/frontend/src/transform/optimizer.cpp"
 
-if ! rg -q "cte_engine_\\.query\\(" "$OPT_CPP"; then
+if ! rg -q "(cte_engine_|engine)\\.query\\(" "$OPT_CPP"; then
   echo "optimizer must consume CTE through the canonical CTE engine query path" >&2
   exit 1
 fi
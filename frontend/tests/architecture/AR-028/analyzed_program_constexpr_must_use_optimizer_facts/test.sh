@@ -10,7 +10,7 @@ if rg -q 'checker\.constexpr_condition\(' "$TARGET"; then
   exit 1
 fi
 
-if ! rg -q 'optimization(->|\.)constexpr_conditions' "$TARGET"; then
+if ! rg -q 'optimization(->|\.)constexpr_condition\(' "$TARGET"; then
   echo "AnalyzedProgram constexpr callback must source decisions from optimizer constexpr facts" >&2
   exit 1
 fi
@@ -13,6 +13,7 @@ root = pathlib.Path(sys.argv[1])
 
 std_math = (root / "std" / "math.vx").read_text()
 evaluator = (root / "frontend" / "src" / "transform" / "evaluator_call.cpp").read_text()
+cte_math = (root / "frontend" / "src" / "transform" / "cte_math.cpp").read_text()
 typechecker = (root / "frontend" / "src" / "type" / "typechecker_expr.cpp").read_text()
 c_codegen = (root / "backends" / "c" / "src" / "codegen_support.cpp").read_text()
 ml_codegen_path = root / "backends" / "ext" / "megalinker" / "src" / "codegen_support.cpp"
@@ -22,7 +23,7 @@ std_funcs = set(re.findall(r"&!([A-Za-z_][A-Za-z0-9_]*)\s*\(", std_math))
 if not std_funcs:
     raise SystemExit("failed to parse bundled std/math.vx function surface")
 
-evaluator_funcs = set(re.findall(r'if \(name == "([A-Za-z0-9_]+)"\)', evaluator))
+evaluator_funcs = set(re.findall(r'\{"([A-Za-z0-9_]+)", (?:unary_f64|binary_f64|unary_f32|binary_f32|exact_f32|predicate)\(', cte_math))
 missing = sorted(std_funcs - evaluator_funcs)
 if missing:
     extra = sorted((evaluator_funcs - std_funcs) & std_funcs)
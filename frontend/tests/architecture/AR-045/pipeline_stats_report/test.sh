@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cat > "$TMPDIR/main.vx" <<'VX'
+&square(x:#i32) -> #i32 { x * x }
+&^main() -> #i32 { square(7) }
+VX
+
+"$VEXEL" -b vexel -o "$TMPDIR/out" --time-passes --stats-json="$TMPDIR/stats.json" "$TMPDIR/main.vx" \
+  >/dev/null 2>"$TMPDIR/stderr.txt"
+
+if ! grep -q "^=== Pipeline stats ===" "$TMPDIR/stderr.txt"; then
+  echo "--time-passes must print the stage table to stderr" >&2
+  exit 1
+fi
+
+expected_stages="load resolve typecheck merge monomorphize lower inline optimize analysis type-use dce-prune compact backend-emit"
+actual_stages="$(grep -o '"name": "[a-z-]*"' "$TMPDIR/stats.json" | sed 's/"name": "\(.*\)"/\1/' | tr '\n' ' ' | sed 's/ $//')"
+if [[ "$actual_stages" != "$expected_stages" ]]; then
+  echo "unexpected stage order: $actual_stages" >&2
+  exit 1
+fi
+
+for key in wall_ms peak_rss_delta_kb ast_nodes residual_iters total_wall_ms peak_rss_kb; do
+  if ! grep -q "\"$key\"" "$TMPDIR/stats.json"; then
+    echo "stats JSON missing key '$key'" >&2
+    exit 1
+  fi
+done
+
+if grep -q '"name": "load".*"ast_nodes": 0,' "$TMPDIR/stats.json"; then
+  echo "load stage must count parsed AST nodes" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+PIPELINE="$ROOT/frontend/src/pipeline/frontend_pipeline.cpp"
+
+LOOP="$(awk '
+  /int residual_iters = 0;/ { in_loop=1 }
+  in_loop { print }
+  in_loop && /^    }$/ { exit }
+' "$PIPELINE")"
+
+if [[ -z "$LOOP" ]]; then
+  echo "missing residual fixpoint loop in frontend_pipeline.cpp" >&2
+  exit 1
+fi
+
+if rg -q "optimizer\.run\(" <<<"$LOOP"; then
+  echo "residual fixpoint must not re-run the optimizer from scratch each round" >&2
+  exit 1
+fi
+
+if ! rg -q "optimizer\.rerun\(merged, residualizer\.rewritten_top_level\(\)\)" <<<"$LOOP"; then
+  echo "residual fixpoint must re-seed the optimizer with residualizer-rewritten roots" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+write_source() {
+  cat > "$TMPDIR/main.vx" <<VX
+&step(n:#i32) -> #i32 { n < 2 ? n : step(n - 1) + step(n - 2) $1 }
+&table() -> #i32[4] { [step(5), step(7), step(9), step(11)] }
+T = table();
+&^main() -> #i32 { T[3] }
+VX
+}
+
+write_source ""
+"$VEXEL" -b vexel -o "$TMPDIR/first" --cte-cache="$TMPDIR/cache" "$TMPDIR/main.vx" >/dev/null
+CACHE="$TMPDIR/cache/cte_calls.cache"
+if [[ ! -s "$CACHE" ]]; then
+  echo "--cte-cache must write the call cache file" >&2
+  exit 1
+fi
+
+"$VEXEL" -b vexel -o "$TMPDIR/second" --cte-cache="$TMPDIR/cache" "$TMPDIR/main.vx" >/dev/null
+"$VEXEL" -b vexel -o "$TMPDIR/plain" "$TMPDIR/main.vx" >/dev/null
+if ! cmp -s "$TMPDIR/second.vx" "$TMPDIR/plain.vx" || ! cmp -s "$TMPDIR/first.vx" "$TMPDIR/plain.vx"; then
+  echo "cached and uncached builds must emit identical output" >&2
+  exit 1
+fi
+
+# Editing the callee body must change the key; stale results would keep 89.
+write_source "+ 1"
+"$VEXEL" -b vexel -o "$TMPDIR/edited" --cte-cache="$TMPDIR/cache" "$TMPDIR/main.vx" >/dev/null
+"$VEXEL" -b vexel -o "$TMPDIR/edited_plain" "$TMPDIR/main.vx" >/dev/null
+if ! cmp -s "$TMPDIR/edited.vx" "$TMPDIR/edited_plain.vx"; then
+  echo "cache must not reuse results across callee edits" >&2
+  exit 1
+fi
+
+echo "ok"
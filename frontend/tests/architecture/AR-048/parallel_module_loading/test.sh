@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# A diamond plus a chain of imports, each module also using a tuple
+# multi-assignment so generated temporaries are part of the output.
+mkdir -p "$TMPDIR/lib"
+for i in 0 1 2 3 4 5 6 7; do
+  next=$((i + 1))
+  {
+    if [[ $i -lt 7 ]]; then
+      echo "::m$next;"
+    fi
+    echo "::shared;"
+    echo "&pair$i(x:#i32) -> (#i32, #i32) { (x + $i, x + $next) }"
+    echo "&^f$i(x:#i32) -> #i32 { a:#i32; b:#i32; a, b = pair$i(x); a + b + g() }"
+  } > "$TMPDIR/lib/m$i.vx"
+done
+echo "&g() -> #i32 { 1 }" > "$TMPDIR/lib/shared.vx"
+cat > "$TMPDIR/main.vx" <<VX
+::lib::m0;
+::lib::m4;
+&^main(x:#i32) -> #i32 { f0(x) + f4(x) }
+VX
+
+mkdir -p "$TMPDIR/serial"
+"$VEXEL" -b c -j 1 -o "$TMPDIR/serial/out" "$TMPDIR/main.vx" >/dev/null
+for run in 1 2 3; do
+  mkdir -p "$TMPDIR/parallel$run"
+  "$VEXEL" -b c -j 4 -o "$TMPDIR/parallel$run/out" "$TMPDIR/main.vx" >/dev/null
+  if ! diff -r "$TMPDIR/serial" "$TMPDIR/parallel$run" >/dev/null; then
+    echo "parallel module loading must emit output identical to -j 1" >&2
+    exit 1
+  fi
+done
+
+if "$VEXEL" -b c -j 0 -o "$TMPDIR/bad/out" "$TMPDIR/main.vx" >/dev/null 2>&1; then
+  echo "-j 0 must be rejected" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+write_lib() {
+  cat > "$TMPDIR/lib.vx" <<VX
+#Pair(a:#i32, b:#i32);
+[[inline]] &sum(p:#Pair) -> #i32 { p.a + p.b $1 }
+&scale(x:#i32) -> #i32 { r:#i32 = 0; i:#i32 = 0; (i < x)@{ r = r + 3; i = i + 1; }; r }
+VX
+}
+
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib;
+&^main() -> #i32 { sum(#Pair(2, 5)) + scale(4) + 0x10 }
+VX
+
+write_lib ""
+"$VEXEL" -b vexel -o "$TMPDIR/first" --parse-cache="$TMPDIR/cache" "$TMPDIR/main.vx" >/dev/null
+if [[ "$(find "$TMPDIR/cache/parsed" -name '*.ast' | wc -l)" -ne 2 ]]; then
+  echo "--parse-cache must store one entry per parsed module" >&2
+  exit 1
+fi
+
+"$VEXEL" -v -b vexel -o "$TMPDIR/second" --parse-cache="$TMPDIR/cache" "$TMPDIR/main.vx" >"$TMPDIR/second.log"
+if ! grep -q "Parse cache: 2 hit(s), 0 miss(es)" "$TMPDIR/second.log"; then
+  echo "warm build must load every module from the cache" >&2
+  exit 1
+fi
+
+"$VEXEL" -b vexel -o "$TMPDIR/plain" "$TMPDIR/main.vx" >/dev/null
+if ! cmp -s "$TMPDIR/second.vx" "$TMPDIR/plain.vx" || ! cmp -s "$TMPDIR/first.vx" "$TMPDIR/plain.vx"; then
+  echo "cached and uncached builds must emit identical output" >&2
+  exit 1
+fi
+
+# Editing a module must change its key; the untouched entry module still hits.
+write_lib "+ 1"
+"$VEXEL" -v -b vexel -o "$TMPDIR/edited" --parse-cache="$TMPDIR/cache" "$TMPDIR/main.vx" >"$TMPDIR/edited.log"
+"$VEXEL" -b vexel -o "$TMPDIR/edited_plain" "$TMPDIR/main.vx" >/dev/null
+if ! grep -q "Parse cache: 1 hit(s), 1 miss(es)" "$TMPDIR/edited.log" ||
+   ! cmp -s "$TMPDIR/edited.vx" "$TMPDIR/edited_plain.vx"; then
+  echo "cache must not reuse a module across source edits" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+cd "$TMPDIR"
+
+# Both modules run the same command; each run appends to runs.log.
+cat > lib.vx <<'VX'
+::"echo run >> runs.log; cat input.txt" -> greeting;
+&lib_len() -> #i32 { |greeting| }
+VX
+cat > main.vx <<'VX'
+::lib;
+::"echo run >> runs.log; cat input.txt" -> banner;
+&^main() -> #i32 { lib_len() + |banner| }
+VX
+
+runs() { [[ -f runs.log ]] && wc -l < runs.log || echo 0; }
+build() {
+  "$VEXEL" -v -b vexel -o "$1" --allow-process --process-cache=cache --process-input input.txt main.vx >"$1.log"
+}
+
+echo hello > input.txt
+"$VEXEL" -b vexel -o plain --allow-process main.vx >/dev/null
+if [[ "$(runs)" -ne 2 ]]; then
+  echo "without --process-cache every process expression must run" >&2
+  exit 1
+fi
+
+rm runs.log
+build first
+if [[ "$(runs)" -ne 1 ]] || ! grep -q "Process cache: 1 hit(s), 1 run(s)" first.log; then
+  echo "identical commands must run once per compilation" >&2
+  exit 1
+fi
+
+build second
+if [[ "$(runs)" -ne 1 ]] || ! grep -q "Process cache: 2 hit(s), 0 run(s)" second.log; then
+  echo "warm build must reuse the stored output" >&2
+  exit 1
+fi
+if ! cmp -s first.vx plain.vx || ! cmp -s second.vx plain.vx; then
+  echo "cached and uncached builds must emit identical output" >&2
+  exit 1
+fi
+
+# Changing a declared input must invalidate the entry.
+echo "hello, world" > input.txt
+build edited
+"$VEXEL" -b vexel -o edited_plain --allow-process main.vx >/dev/null
+if ! grep -q "Process cache: 1 hit(s), 1 run(s)" edited.log || ! cmp -s edited.vx edited_plain.vx; then
+  echo "cache must not reuse output across declared input edits" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# Six leaf modules with no generics can be checked in one concurrent wave.
+for m in a b c d e f; do
+  cat > "$TMPDIR/$m.vx" <<VX
+#Cell_$m(x:#i32, y:#i32);
+K_$m:#i32 = 7;
+&sq_$m(v:#i32) -> #i32 { v * v + K_$m }
+&sum_$m(n:#i32) -> #i32 { r:#i32 = 0; i:#i32 = 0; (i < n)@{ r = r + sq_$m(i); i = i + 1; }; r }
+&(self)#Cell_$m::bump() { self.x = self.x + 1; }
+&pair_$m(v:#i32) -> (#i32, #i32) { (v, v + K_$m) }
+&mix_$m(v:#i32) -> #i32 { c = #Cell_$m(v, 2); c.bump(); p:#i32; q:#i32; p, q = pair_$m(c.x); t = p * 3; t + q }
+F_$m:#i32 = sum_$m(10) + mix_$m(4);
+VX
+done
+cat > "$TMPDIR/main.vx" <<'VX'
+::a; ::b; ::c; ::d; ::e; ::f;
+&^main(argc:#i32) -> #i32 { sum_a(argc) + F_b + mix_c(argc) + F_d + sum_e(3) + mix_f(argc) }
+VX
+
+"$VEXEL" -b vexel -o "$TMPDIR/serial" "$TMPDIR/main.vx" >/dev/null
+for run in 1 2 3; do
+  "$VEXEL" -b vexel -j 4 --parallel-typecheck -o "$TMPDIR/parallel$run" "$TMPDIR/main.vx" >/dev/null
+  if ! cmp -s "$TMPDIR/serial.vx" "$TMPDIR/parallel$run.vx"; then
+    echo "--parallel-typecheck must emit the same program as the serial checker" >&2
+    exit 1
+  fi
+done
+
+# Errors in a concurrently checked module surface unchanged.
+echo '&bad_a() -> #i32 { undefined_name }' >> "$TMPDIR/a.vx"
+if "$VEXEL" -b vexel -j 4 --parallel-typecheck -o "$TMPDIR/err" "$TMPDIR/main.vx" >/dev/null 2>"$TMPDIR/err.log"; then
+  echo "type errors in a worker must fail the build" >&2
+  exit 1
+fi
+if ! grep -q "Undefined identifier: undefined_name" "$TMPDIR/err.log"; then
+  echo "worker error must be reported" >&2
+  cat "$TMPDIR/err.log" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# Many independent compile-time roots land in one drain, so workers evaluate
+# them concurrently; the later roots depend on earlier ones across drains.
+{
+  for i in $(seq 1 12); do
+    echo "&f$i(n:#i32) -> #i32 { r:#i32 = 0; i:#i32 = 0; (i < n)@{ r = r + i * $i; i = i + 1; }; r }"
+    echo "A$i:#i32 = f$i($((i + 20)));"
+    echo "B$i:#i32 = A$i + f$i(3);"
+  done
+  echo '&^main(argc:#i32) -> #i32 {'
+  echo '  s:#i32 = argc;'
+  for i in $(seq 1 12); do
+    echo "  (B$i > 0) ? { s = s + B$i; } : { s = s - f$i(argc); };"
+  done
+  echo '  s'
+  echo '}'
+} > "$TMPDIR/main.vx"
+
+# Outputs share one basename since the C backend names its header after it.
+for backend in vexel c; do
+  mkdir -p "$TMPDIR/serial_$backend"
+  "$VEXEL" -b "$backend" -o "$TMPDIR/serial_$backend/out" "$TMPDIR/main.vx" >/dev/null
+  for run in 1 2 3; do
+    mkdir -p "$TMPDIR/parallel_${backend}_$run"
+    "$VEXEL" -b "$backend" -j 4 --parallel-optimize -o "$TMPDIR/parallel_${backend}_$run/out" "$TMPDIR/main.vx" >/dev/null
+    for out in "$TMPDIR/serial_$backend"/*; do
+      if ! cmp -s "$out" "$TMPDIR/parallel_${backend}_$run/$(basename "$out")"; then
+        echo "--parallel-optimize must emit the same $backend output as the serial optimizer" >&2
+        exit 1
+      fi
+    done
+  done
+done
+
+# A root that fails to fold reports the same error as the serial run.
+cat >> "$TMPDIR/main.vx" <<'VX'
+seed:#i32;
+^BAD:#i32 = seed + B1;
+VX
+"$VEXEL" -b vexel -o "$TMPDIR/serr" "$TMPDIR/main.vx" >/dev/null 2>"$TMPDIR/serial_err.log" && serial_rc=0 || serial_rc=$?
+"$VEXEL" -b vexel -j 4 --parallel-optimize -o "$TMPDIR/perr" "$TMPDIR/main.vx" >/dev/null 2>"$TMPDIR/parallel_err.log" && parallel_rc=0 || parallel_rc=$?
+if [ "$serial_rc" = 0 ] || [ "$serial_rc" != "$parallel_rc" ] || ! cmp -s "$TMPDIR/serial_err.log" "$TMPDIR/parallel_err.log"; then
+  echo "--parallel-optimize must fail with the serial optimizer's error" >&2
+  cat "$TMPDIR/parallel_err.log" >&2
+  exit 1
+fi
+
+echo "ok"
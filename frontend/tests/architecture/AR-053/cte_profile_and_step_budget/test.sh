@@ -0,0 +1,65 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cat > "$TMPDIR/main.vx" <<'VX'
+&fib(n:#i32) -> #i32 { n < 2 ? n : fib(n - 1) + fib(n - 2) }
+&sum_to(n:#i32) -> #i32 {
+    s:#i32 = 0;
+    i:#i32 = 0;
+    (i < n)@{ s = s + i; i = i + 1; };
+    -> s;
+}
+TABLE:#i32 = sum_to(100);
+&^main() -> #i32 {
+    buf:#i32[sum_to(40) - 775] = 0;
+    -> fib(15) + TABLE + |buf|;
+}
+VX
+
+"$VEXEL" -b vexel -o "$TMPDIR/out" --cte-profile "$TMPDIR/main.vx" >/dev/null 2>"$TMPDIR/profile.txt"
+
+if ! grep -q "^=== Compile-time evaluation profile ===" "$TMPDIR/profile.txt"; then
+  echo "--cte-profile must print the profile table to stderr" >&2
+  exit 1
+fi
+if ! grep -Eq "^init +TABLE +main\.vx:8 " "$TMPDIR/profile.txt"; then
+  echo "profile must list the TABLE initializer" >&2
+  cat "$TMPDIR/profile.txt" >&2
+  exit 1
+fi
+# Memoized recursion: hits are reported and every body evaluation is a miss.
+fib_row="$(grep -E "^fn +fib " "$TMPDIR/profile.txt" || true)"
+read -r _ _ _ fib_evals fib_hits fib_misses _ <<<"$fib_row"
+if [[ -z "$fib_row" || "$fib_hits" -eq 0 || "$fib_evals" -ne "$fib_misses" ]]; then
+  echo "profile must report fib memo hits and misses: $fib_row" >&2
+  exit 1
+fi
+sum_row="$(grep -E "^fn +sum_to " "$TMPDIR/profile.txt" || true)"
+read -r _ _ _ _ _ _ sum_loops _ <<<"$sum_row"
+if [[ -z "$sum_row" || "$sum_loops" -lt 140 ]]; then
+  echo "profile must count sum_to loop iterations: $sum_row" >&2
+  exit 1
+fi
+
+if "$VEXEL" -b vexel -o "$TMPDIR/small" --cte-step-budget=200 "$TMPDIR/main.vx" >/dev/null 2>"$TMPDIR/budget.txt"; then
+  echo "an exhausted step budget on an array size must fail the build" >&2
+  exit 1
+fi
+if ! grep -q "Array size must be a compile-time constant: Compile-time evaluation exceeded the step budget of 200 steps (raise it with --cte-step-budget)" "$TMPDIR/budget.txt"; then
+  echo "exhausted step budget must name the budget and the flag" >&2
+  cat "$TMPDIR/budget.txt" >&2
+  exit 1
+fi
+
+if "$VEXEL" -b vexel -o "$TMPDIR/bad" --cte-step-budget=0 "$TMPDIR/main.vx" >/dev/null 2>&1; then
+  echo "--cte-step-budget must reject 0" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cat > "$TMPDIR/lib.vx" <<'VX'
+&used(x:#i32) -> #i32 { helper(x) + 1 }
+&helper(x:#i32) -> #i32 { x * 2 }
+&unused_a(x:#i32) -> #i32 { unused_b(x) * 3 + 1 }
+&unused_b(x:#i32) -> #i32 { a:#i32 = x; (a > 10) ? { a = a - 10; }; a }
+&unused_c(x:#i32) -> #i32 { unused_a(x) + unused_b(x) + 7 }
+VX
+
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib;
+&^main(n:#i32) -> #i32 { used(n) }
+VX
+
+"$VEXEL" -b vexel -o "$TMPDIR/out" --stats-json="$TMPDIR/stats.json" "$TMPDIR/main.vx" >/dev/null
+
+stage_nodes() {
+  python3 -c "import json, sys; d = json.load(open(sys.argv[1])); print([s['ast_nodes'] for s in d['stages'] if s['name'] == sys.argv[2]][0])" \
+    "$TMPDIR/stats.json" "$1"
+}
+
+typecheck_nodes="$(stage_nodes typecheck)"
+merge_nodes="$(stage_nodes merge)"
+if [[ "$merge_nodes" -ge "$typecheck_nodes" ]]; then
+  echo "unreachable functions must be dropped before merge ($merge_nodes >= $typecheck_nodes nodes)" >&2
+  exit 1
+fi
+
+if grep -q "unused_" "$TMPDIR/out.vx"; then
+  echo "unreachable functions leaked into lowered output" >&2
+  exit 1
+fi
+if ! grep -q "used" "$TMPDIR/out.vx"; then
+  echo "reachable library function missing from lowered output" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cat > "$TMPDIR/main.vx" <<'VX'
+&square(x:#i32) -> #i32 { x * x }
+&twice(x) { x + x }
+&helper(x:#i32) -> #i32 { twice(x) }
+&^main() -> #i32 { helper(square(3)) + twice(2) }
+VX
+
+"$VEXEL" -b vexel -o "$TMPDIR/ref" "$TMPDIR/main.vx" >/dev/null
+
+# Every level must validate cleanly and leave the output untouched.
+for level in off boundary sampled sampled:2 sampled:3:7 full; do
+  "$VEXEL" -b vexel -o "$TMPDIR/out" --pass-invariants="$level" "$TMPDIR/main.vx" >/dev/null
+  if ! cmp -s "$TMPDIR/ref.vx" "$TMPDIR/out.vx"; then
+    echo "--pass-invariants=$level changed the lowered output" >&2
+    exit 1
+  fi
+done
+
+for bad in bogus sampled:0 sampled:x full:2; do
+  if "$VEXEL" -b vexel -o "$TMPDIR/out" --pass-invariants="$bad" "$TMPDIR/main.vx" >/dev/null 2>"$TMPDIR/stderr.txt"; then
+    echo "--pass-invariants=$bad must be rejected" >&2
+    exit 1
+  fi
+  if ! grep -q "expects off, boundary, sampled" "$TMPDIR/stderr.txt"; then
+    echo "--pass-invariants=$bad must explain the accepted levels" >&2
+    exit 1
+  fi
+done
+
+echo "ok"
@@ -0,0 +1,71 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+SOCKET="$TMPDIR/vexel.sock"
+SERVER_PID=""
+cleanup() {
+  if [[ -n "$SERVER_PID" ]]; then kill "$SERVER_PID" 2>/dev/null || true; fi
+  rm -rf "$TMPDIR"
+}
+trap cleanup EXIT
+
+write_lib() {
+  cat > "$TMPDIR/lib.vx" <<VX
+#Pair(a:#i32, b:#i32);
+&sum(p:#Pair) -> #i32 { p.a + p.b $1 }
+VX
+}
+
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib;
+&^main() -> #i32 { sum(#Pair(2, 5)) }
+VX
+write_lib ""
+
+"$VEXEL" --serve "$SOCKET" &
+SERVER_PID=$!
+
+# Requests run in the client's working directory, so relative paths resolve there.
+cd "$TMPDIR"
+"$VEXEL" --connect "$SOCKET" -v -b vexel -o first main.vx >first.log
+"$VEXEL" --connect "$SOCKET" -v -b vexel -o second main.vx >second.log
+if ! grep -q "Resident modules: 0 hit(s), 2 miss(es)" first.log ||
+   ! grep -q "Resident modules: 2 hit(s), 0 miss(es)" second.log; then
+  echo "the server must keep parsed modules between requests" >&2
+  exit 1
+fi
+
+"$VEXEL" -b vexel -o plain main.vx >/dev/null
+if ! cmp -s first.vx plain.vx || ! cmp -s second.vx plain.vx; then
+  echo "server and direct builds must emit identical output" >&2
+  exit 1
+fi
+
+write_lib "+ 1"
+"$VEXEL" --connect "$SOCKET" -v -b vexel -o edited main.vx >edited.log
+"$VEXEL" -b vexel -o edited_plain main.vx >/dev/null
+if ! grep -q "Resident modules: 1 hit(s), 1 miss(es)" edited.log || ! cmp -s edited.vx edited_plain.vx; then
+  echo "the server must not reuse a module across source edits" >&2
+  exit 1
+fi
+
+status=0
+"$VEXEL" --connect "$SOCKET" -b vexel missing.vx 2>missing.err || status=$?
+if [[ "$status" -ne 1 ]] || ! grep -q "Cannot open file: missing.vx" missing.err; then
+  echo "the client must relay diagnostics and the exit code" >&2
+  exit 1
+fi
+
+"$VEXEL" --connect "$SOCKET" --shutdown
+wait "$SERVER_PID"
+SERVER_PID=""
+if [[ -e "$SOCKET" ]]; then
+  echo "shutdown must remove the socket" >&2
+  exit 1
+fi
+
+echo "ok"
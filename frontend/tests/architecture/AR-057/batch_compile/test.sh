@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cd "$TMPDIR"
+mkdir -p lib progs
+cat > lib/shapes.vx <<'VX'
+#Pair(a:#i32, b:#i32);
+&sum(p:#Pair) -> #i32 { p.a + p.b }
+VX
+cat > progs/one.vx <<'VX'
+::lib::shapes;
+&^main() -> #i32 { sum(#Pair(2, 5)) }
+VX
+cat > progs/two.vx <<'VX'
+::lib::shapes;
+&^main() -> #i32 { sum(#Pair(10, 20)) }
+VX
+cat > progs/bad.vx <<'VX'
+&^main() -> #i32 { missing() }
+VX
+
+# Entry paths are relative to the list; without an output base an entry
+# writes <-o directory>/<stem>.
+printf '# entries\nprogs/one.vx\n\nprogs/two.vx named/second\n' > list.txt
+"$VEXEL" -v -b vexel --batch list.txt >batch.log
+if ! grep -q "Resident modules: 0 hit(s), 2 miss(es)" batch.log ||
+   ! grep -q "Resident modules: 1 hit(s), 1 miss(es)" batch.log ||
+   ! grep -q "Batch: compiled 2 entries" batch.log; then
+  echo "entries must share parsed modules" >&2
+  exit 1
+fi
+"$VEXEL" -b vexel -o direct_one progs/one.vx
+"$VEXEL" -b vexel -o direct_two progs/two.vx
+if ! cmp -s out/one.vx direct_one.vx || ! cmp -s named/second.vx direct_two.vx; then
+  echo "batch and direct builds must emit identical output" >&2
+  exit 1
+fi
+
+printf 'progs/one.vx\nprogs/bad.vx\nprogs/two.vx\n' > mixed.txt
+status=0
+"$VEXEL" -b vexel -j 2 -o mixed --batch mixed.txt 2>mixed.err || status=$?
+if [[ "$status" -ne 1 ]] || ! grep -q "Batch: 1 of 3 entries failed" mixed.err ||
+   [[ ! -f mixed/one.vx || ! -f mixed/two.vx ]]; then
+  echo "a failing entry must not stop the others" >&2
+  exit 1
+fi
+
+printf 'progs/one.vx\nlib/../progs/one.vx\n' > clash.txt
+status=0
+"$VEXEL" -b vexel --batch clash.txt 2>clash.err || status=$?
+if [[ "$status" -ne 1 ]] || ! grep -q "both write one" clash.err; then
+  echo "entries writing the same output must be rejected" >&2
+  exit 1
+fi
+
+echo "ok"
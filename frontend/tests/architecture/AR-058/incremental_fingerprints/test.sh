@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cd "$TMPDIR"
+mkdir -p lib
+cat > lib/shapes.vx <<'VX'
+&^area(w:#i32, h:#i32) -> #i32 { w * h }
+VX
+cat > main.vx <<'VX'
+::lib::shapes;
+&^main() -> #i32 { area(2, 3) }
+VX
+
+build() {
+  "$VEXEL" -v -b c --incremental -o out/main main.vx >build.log
+}
+
+build
+if ! grep -q "Incremental: no previous build recorded" build.log; then
+  echo "first build must record fingerprints" >&2
+  exit 1
+fi
+build
+if ! grep -q "Up to date: main.vx" build.log || grep -q "Generating backend" build.log; then
+  echo "an unchanged build must be skipped" >&2
+  exit 1
+fi
+
+# A body edit leaves the module interface alone.
+sed -i 's/w \* h/h * w/' lib/shapes.vx
+build
+if ! grep -q "Incremental: 1 of 2 module(s) changed (0 interface), 0 dependent(s) affected" build.log ||
+   ! grep -q "Parse cache: 1 hit(s), 1 miss(es)" build.log; then
+  echo "a body edit must only re-parse its module" >&2
+  exit 1
+fi
+
+echo '&^perim(w:#i32, h:#i32) -> #i32 { w + w + h + h }' >> lib/shapes.vx
+build
+if ! grep -q "Incremental: 1 of 2 module(s) changed (1 interface), 1 dependent(s) affected" build.log; then
+  echo "an interface change must reach the importing module" >&2
+  exit 1
+fi
+
+# Touched outputs and different options are not up to date.
+echo '/* edited */' >> out/main.c
+build
+if grep -q "Up to date" build.log || grep -q "edited" out/main.c; then
+  echo "an edited output must be rebuilt" >&2
+  exit 1
+fi
+"$VEXEL" -v -b c --incremental --emit-analysis -o out/main main.vx >options.log
+if grep -q "Up to date" options.log; then
+  echo "builds with other options must not share a record" >&2
+  exit 1
+fi
+
+echo "ok"
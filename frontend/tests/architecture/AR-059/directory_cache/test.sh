@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+mkdir -p "$TMPDIR/util" "$TMPDIR/nested"
+cat > "$TMPDIR/util/base.vx" <<'VX'
+&base(x:#i32) -> #i32 { x + 1 }
+VX
+for name in a b c; do
+  cat > "$TMPDIR/util/$name.vx" <<VX
+::util::base;
+&$name(x:#i32) -> #i32 { base(x) * 2 }
+VX
+done
+# Not under the project root: found next to the importing file.
+cat > "$TMPDIR/nested/helper.vx" <<'VX'
+&helper() -> #i32 { 3 }
+VX
+cat > "$TMPDIR/nested/mid.vx" <<'VX'
+::helper;
+::util::c;
+&mid() -> #i32 { helper() + c(1) }
+VX
+cat > "$TMPDIR/main.vx" <<'VX'
+::util::a;
+::util::b;
+::nested::mid;
+&^main() -> #i32 { a(1) + b(2) + mid() }
+VX
+
+cd "$TMPDIR"
+"$VEXEL" -v -b vexel -o out main.vx >build.log
+line="$(grep '^Directory cache: ' build.log || true)"
+listings="$(sed -E 's/^Directory cache: ([0-9]+) listing.*/\1/' <<<"$line")"
+lookups="$(sed -E 's/.* for ([0-9]+) lookup.*/\1/' <<<"$line")"
+if [[ -z "$line" || "$listings" -gt 3 || "$lookups" -le "$listings" ]]; then
+  echo "imports must be resolved from one listing per searched directory: $line" >&2
+  exit 1
+fi
+if ! grep -q 'helper' out.vx; then
+  echo "file-relative import must still resolve" >&2
+  exit 1
+fi
+
+cat > "$TMPDIR/missing.vx" <<'VX'
+::util::absent;
+&^main() -> #i32 { 0 }
+VX
+if "$VEXEL" -b vexel -o missing missing.vx >missing.log 2>&1; then
+  echo "an import with no file must still fail" >&2
+  exit 1
+fi
+
+echo "ok"
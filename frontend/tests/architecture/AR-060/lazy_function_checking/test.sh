@@ -0,0 +1,110 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# `broken` has a declared signature and nothing reaches it; `table` is only
+# reached through a compile-time array size.
+cat > "$TMPDIR/lib.vx" <<'VX'
+&used(x:#i32) -> #i32 { x * 2 }
+&table(n:#i32) -> #i32 { n + 1 }
+&broken(x:#i32) -> #i32 { x + missing_flag }
+&loose(x:#i32) -> #i32 { y = x; y }
+VX
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib;
+&^main() -> #i32 {
+    buf:#i32[table(3)] = 0;
+    -> used(|buf|);
+}
+VX
+
+cd "$TMPDIR"
+if ! "$VEXEL" -b vexel -o out main.vx 2>build.err; then
+  echo "unreached function bodies must not be checked by default" >&2
+  cat build.err >&2
+  exit 1
+fi
+if grep -q "broken" out.vx; then
+  echo "unreached functions must not be emitted" >&2
+  exit 1
+fi
+
+if "$VEXEL" -b vexel --check-all -o all main.vx >/dev/null 2>all.err; then
+  echo "--check-all must report errors in unreached function bodies" >&2
+  exit 1
+fi
+if ! grep -q "missing_flag" all.err; then
+  echo "--check-all must name the error in the unreached body" >&2
+  cat all.err >&2
+  exit 1
+fi
+
+# A cached run without --check-all must not stand in for one with it.
+if "$VEXEL" --help 2>/dev/null | grep -q -- "--run"; then
+  set +e
+  "$VEXEL" -b c --run --run-cache=cache -o run main.vx >/dev/null 2>&1
+  status=$?
+  set -e
+  if [[ $status -ne 8 ]]; then
+    echo "the program must run without --check-all (exit $status)" >&2
+    exit 1
+  fi
+  if "$VEXEL" -b c --run --run-cache=cache --check-all -o run main.vx >/dev/null 2>&1; then
+    echo "--check-all must not reuse a cached run" >&2
+    exit 1
+  fi
+fi
+
+# Strictness diagnostics follow the same rule.
+sed -i 's/ + missing_flag//' lib.vx
+if ! "$VEXEL" -b vexel --type-strictness=1 -o strict main.vx >/dev/null 2>strict.err; then
+  echo "strictness must not check unreached bodies by default" >&2
+  cat strict.err >&2
+  exit 1
+fi
+if "$VEXEL" -b vexel --type-strictness=1 --check-all -o strict main.vx >/dev/null 2>&1; then
+  echo "--check-all must apply strictness to unreached bodies" >&2
+  exit 1
+fi
+
+# Once reached, a deferred body is checked and its errors are reported.
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib;
+&^main() -> #i32 { loose(1) + nope }
+VX
+if "$VEXEL" -b vexel -o reached main.vx >/dev/null 2>reached.err; then
+  echo "errors in reached code must still be reported" >&2
+  exit 1
+fi
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib;
+&^main() -> #i32 { loose(1) }
+VX
+if "$VEXEL" -b vexel --type-strictness=1 -o reached main.vx >/dev/null 2>&1; then
+  echo "a reached deferred body must be checked under the requested strictness" >&2
+  exit 1
+fi
+
+# A body first reached by a compile-time query reports its own error, not a
+# failed evaluation.
+cat > "$TMPDIR/main.vx" <<'VX'
+&folded(x:#i32) -> #i32 { x + missing_const }
+N = folded(2);
+&^main() -> #i32 { N }
+VX
+if "$VEXEL" -b vexel -o folded main.vx >/dev/null 2>folded.err; then
+  echo "errors in bodies reached at compile time must be reported" >&2
+  exit 1
+fi
+if ! grep -q "missing_const" folded.err; then
+  echo "a body reached at compile time must name its own error" >&2
+  cat folded.err >&2
+  exit 1
+fi
+
+echo ok
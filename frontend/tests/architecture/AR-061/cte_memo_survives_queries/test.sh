@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# Each global initializer is its own query. The second call of tri(100)
+# must reuse the first one's memo entry instead of running the loop again.
+cat > "$TMPDIR/main.vx" <<'VX'
+&tri(n:#i32) -> #i32 {
+    acc = 0;
+    i = 0;
+    (i < n)@{ acc = acc + i; i = i + 1; };
+    acc
+}
+A = tri(100);
+B = tri(100);
+&^main() -> #i32 { A + B }
+VX
+
+cd "$TMPDIR"
+"$VEXEL" --cte-profile -b c -o out main.vx 2>profile.txt
+row="$(awk '$1 == "fn" && $2 == "tri"' profile.txt)"
+if [[ -z "$row" ]]; then
+  echo "profile must list tri" >&2
+  cat profile.txt >&2
+  exit 1
+fi
+hits="$(awk '{print $5}' <<<"$row")"
+loops="$(awk '{print $7}' <<<"$row")"
+if (( hits == 0 )); then
+  echo "memoized calls must survive between queries" >&2
+  cat profile.txt >&2
+  exit 1
+fi
+# One run of the loop per engine (type checker and optimizer).
+if (( loops > 200 )); then
+  echo "tri(100) must run once per engine, ran $loops iterations" >&2
+  cat profile.txt >&2
+  exit 1
+fi
+
+echo ok
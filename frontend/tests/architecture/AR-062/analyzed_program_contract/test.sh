@@ -0,0 +1,83 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cd "$TMPDIR"
+mkdir -p lib
+cat > lib/shapes.vx <<'VX'
+#Box(w:#i32, h:#i32);
+&^area(b:#Box) -> #i32 { b.w * b.h }
+VX
+cat > main.vx <<'VX'
+::lib::shapes;
+&^main() -> #i32 {
+    boxes:#Box[2] = [#Box(2, 3), #Box(4, 5)];
+    total:#i32 = 0;
+    boxes@{ total = total + area(_); };
+    total
+}
+VX
+
+# One frontend run feeds both backends.
+"$VEXEL" -b c -o direct/main main.vx
+"$VEXEL" -b vexel -o direct/main main.vx
+"$VEXEL" -b c -o first/main --emit-analyzed=main.vxa main.vx
+"$VEXEL" -b c -o loaded/main --from-analyzed=main.vxa
+"$VEXEL" -b vexel -o loaded/main --from-analyzed=main.vxa
+for out in main.c main.h main.vx; do
+  if ! cmp -s "direct/$out" "loaded/$out"; then
+    echo "emitting from the analyzed program must match a full build ($out)" >&2
+    exit 1
+  fi
+done
+
+echo "damaged" > bad.vxa
+if "$VEXEL" -b c -o bad/main --from-analyzed=bad.vxa 2>bad.err ||
+   ! grep -q "not written by this compiler build, or damaged" bad.err; then
+  echo "a damaged analyzed program must be rejected" >&2
+  exit 1
+fi
+
+# A backend option change reuses the cached frontend result.
+build() {
+  "$VEXEL" -v -b c --analyzed-cache "$@" -o cached/main main.vx >build.log
+}
+build
+if ! grep -q "Analyzed cache: miss" build.log || ! grep -q "Type checking" build.log; then
+  echo "the first build must run the frontend" >&2
+  exit 1
+fi
+build --backend-opt field_order=align
+"$VEXEL" -b c --backend-opt field_order=align -o aligned/main main.vx
+if ! grep -q "Analyzed cache: hit" build.log || grep -q "Type checking" build.log ||
+   ! cmp -s cached/main.c aligned/main.c; then
+  echo "a backend option change must reuse the frontend result" >&2
+  exit 1
+fi
+sed -i 's/b.w \* b.h/b.h * b.w/' lib/shapes.vx
+build
+if ! grep -q "Analyzed cache: miss (inputs changed)" build.log; then
+  echo "a source edit must invalidate the cached frontend result" >&2
+  exit 1
+fi
+
+# Facts computed for one set of boundary reentrancy modes do not carry over.
+cat > reent.vx <<'VX'
+g:#i32 = 0;
+&helper(x:#i32) -> #i32 { g = g + x; g }
+&^entry_reent() -> #i32 { helper(1) }
+[[nonreentrant]] &^entry_nonreent() -> #i32 { helper(2) }
+VX
+"$VEXEL" -b c -o reent/out --emit-analyzed=reent.vxa reent.vx
+if "$VEXEL" -b vexel -o reent/out --from-analyzed=reent.vxa 2>reent.err ||
+   ! grep -q "other boundary reentrancy for backend 'vexel'" reent.err; then
+  echo "a backend with other boundary reentrancy must not reuse the facts" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,65 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# The table holds 64K packed words (512 KiB) while it is being built.
+cat > "$TMPDIR/main.vx" <<'VX'
+&build() -> #u32[65536] {
+    t:#u32[65536];
+    i:#i32 = 0;
+    (i < 65536)@{
+        t[i] = (#u32)i * (#u32)40503;
+        i = i + 1;
+    };
+    t
+}
+
+TABLE = build();
+
+&^main(k:#i32) -> #u32 {
+    TABLE[k] + TABLE[k + 1]
+}
+VX
+
+"$VEXEL" -b vexel -o "$TMPDIR/full" --emit-analysis --stats-json="$TMPDIR/full.json" "$TMPDIR/main.vx" >/dev/null
+if ! grep -q -- "- build@0: non-scalar-result" "$TMPDIR/full.analysis.txt"; then
+  echo "under the default limit build() must evaluate" >&2
+  exit 1
+fi
+peak="$(sed -n 's/.*"cte_peak_bytes": \([0-9]*\).*/\1/p' "$TMPDIR/full.json")"
+if [[ -z "$peak" || "$peak" -lt 524288 ]]; then
+  echo "stats must report the table's peak live bytes: '$peak'" >&2
+  exit 1
+fi
+
+# Over the limit the query gives up, the build still succeeds and the table
+# is left to the runtime.
+"$VEXEL" -b vexel -o "$TMPDIR/small" --emit-analysis --time-passes --cte-memory-limit=64K "$TMPDIR/main.vx" \
+  >/dev/null 2>"$TMPDIR/stderr.txt"
+if ! grep -q -- "- build@0: cte-memory-limit" "$TMPDIR/small.analysis.txt"; then
+  echo "a query over the memory limit must be recorded as a fold skip reason" >&2
+  cat "$TMPDIR/small.analysis.txt" >&2
+  exit 1
+fi
+if ! grep -q "TABLE: #u32\[65536\] = build();" "$TMPDIR/small.vx"; then
+  echo "TABLE must stay a runtime initializer" >&2
+  exit 1
+fi
+if ! grep -q "^cte peak live values: [1-9][0-9]* bytes$" "$TMPDIR/stderr.txt"; then
+  echo "--time-passes must print the peak live compile-time value bytes" >&2
+  exit 1
+fi
+
+for bad in 0 12Q 4KB; do
+  if "$VEXEL" -b vexel -o "$TMPDIR/bad" --cte-memory-limit="$bad" "$TMPDIR/main.vx" >/dev/null 2>&1; then
+    echo "--cte-memory-limit must reject '$bad'" >&2
+    exit 1
+  fi
+done
+
+echo "ok"
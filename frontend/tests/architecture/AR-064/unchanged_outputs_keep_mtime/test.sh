@@ -0,0 +1,67 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cat > "$TMPDIR/main.vx" <<'VX'
+&^main() -> #i32 { 7 }
+VX
+
+"$VEXEL" -b c -o "$TMPDIR/out" --emit-analysis "$TMPDIR/main.vx" >/dev/null
+outputs=("$TMPDIR/out.c" "$TMPDIR/out.h" "$TMPDIR/out.analysis.txt")
+touch -d '2000-01-01 00:00:00' "${outputs[@]}"
+
+# Identical output: the files, and so their timestamps, stay as they were.
+"$VEXEL" -b c -o "$TMPDIR/out" --emit-analysis "$TMPDIR/main.vx" >/dev/null
+for file in "${outputs[@]}"; do
+  if [[ "$(date -r "$file" +%Y)" != "2000" ]]; then
+    echo "unchanged output $(basename "$file") must not be rewritten" >&2
+    exit 1
+  fi
+done
+
+# Changed output replaces the file; no temporaries are left behind.
+sed -i 's/7/8/' "$TMPDIR/main.vx"
+"$VEXEL" -b c -o "$TMPDIR/out" --emit-analysis "$TMPDIR/main.vx" >/dev/null
+if [[ "$(date -r "$TMPDIR/out.c" +%Y)" == "2000" ]] || ! grep -q "8" "$TMPDIR/out.c"; then
+  echo "changed out.c must be replaced" >&2
+  exit 1
+fi
+if ls "$TMPDIR" | grep -q '\.tmp'; then
+  echo "writes must not leave temporaries behind" >&2
+  ls "$TMPDIR" >&2
+  exit 1
+fi
+
+# A symlinked output is written through, and the file keeps its mode.
+mv "$TMPDIR/out.c" "$TMPDIR/real.c"
+ln -s real.c "$TMPDIR/out.c"
+chmod 600 "$TMPDIR/real.c"
+sed -i 's/8/9/' "$TMPDIR/main.vx"
+"$VEXEL" -b c -o "$TMPDIR/out" "$TMPDIR/main.vx" >/dev/null
+if [[ ! -L "$TMPDIR/out.c" ]] || ! grep -q "9" "$TMPDIR/real.c"; then
+  echo "a symlinked output must be written through the link" >&2
+  exit 1
+fi
+if [[ "$(stat -c %a "$TMPDIR/real.c")" != "600" ]]; then
+  echo "a replaced output must keep its permissions" >&2
+  exit 1
+fi
+
+# Outputs that are not regular files are written in place.
+"$VEXEL" -b c -o "$TMPDIR/out" --stats-json /dev/stdout "$TMPDIR/main.vx" >"$TMPDIR/stats.json"
+"$VEXEL" -b c -o "$TMPDIR/out" --trace /dev/stderr "$TMPDIR/main.vx" 2>"$TMPDIR/trace.json" >/dev/null
+if ! grep -q '"stages"' "$TMPDIR/stats.json" || ! grep -q '"traceEvents"' "$TMPDIR/trace.json"; then
+  echo "--stats-json /dev/stdout and --trace /dev/stderr must reach the streams" >&2
+  exit 1
+fi
+if [[ ! -L /dev/stdout || ! -L /dev/stderr ]]; then
+  echo "/dev/stdout and /dev/stderr must not be replaced" >&2
+  exit 1
+fi
+
+echo "ok"
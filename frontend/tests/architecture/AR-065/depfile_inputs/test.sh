@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cd "$TMPDIR"
+mkdir -p lib data
+echo 'hi' > msg.txt
+echo 'a' > data/x.txt
+echo '&^unused() -> #i32 { 0 }' > lib/unused.vx
+cat > lib/shapes.vx <<'VX'
+&^area(w:#i32, h:#i32) -> #i32 { w * h }
+VX
+cat > main.vx <<'VX'
+::lib::shapes;
+&^main() -> #i32 {
+  m:#s = ::msg.txt;
+  d = ::data;
+  area(2, 3) + (#i32)|d| + (#i32)|m|
+}
+VX
+# The test runner is itself a make; its flags must not reach this one.
+unset MAKEFLAGS MFLAGS MAKELEVEL
+cat > Makefile <<MK
+out/main.c:
+	"$VEXEL" -b c -MD -o out/main main.vx
+-include out/main.d
+MK
+
+make -s
+for dep in "$TMPDIR/main.vx" "$TMPDIR/lib/shapes.vx" "$TMPDIR/msg.txt" "$TMPDIR/data/x.txt" "$TMPDIR/data"; do
+  if ! grep -Eq "^  $dep( \\\\)?$" out/main.d; then
+    echo "depfile must list $dep" >&2
+    cat out/main.d >&2
+    exit 1
+  fi
+done
+if ! grep -q "^out/main.c out/main.h:" out/main.d || grep -q "unused" out/main.d; then
+  echo "depfile must name the outputs as spelled by -o and only the inputs read" >&2
+  cat out/main.d >&2
+  exit 1
+fi
+
+# Inputs are older than the outputs, so only a listed input makes the rule
+# stale. make warns about the future timestamps; its -q answer is what counts.
+stale_after() {
+  touch -d '2000-01-01' main.vx lib/*.vx msg.txt data/x.txt data
+  touch -d '2030-01-01' out/main.c out/main.h
+  touch -d '2031-01-01' "$1"
+  ! make -q out/main.c 2>/dev/null
+}
+if stale_after lib/unused.vx; then
+  echo "a file the build did not read must not make it stale" >&2
+  exit 1
+fi
+for input in lib/shapes.vx msg.txt data/x.txt; do
+  if ! stale_after "$input"; then
+    echo "a change to $input must make the build stale" >&2
+    exit 1
+  fi
+done
+echo 'b' > data/y.txt
+touch -d '2000-01-01' data/y.txt
+if ! stale_after data; then
+  echo "a file added to a resource directory must make the build stale" >&2
+  exit 1
+fi
+
+# A removed input does not break make; --depfile picks the path.
+sed -i 's/::msg.txt/"hi"/' main.vx
+rm msg.txt
+touch -d '2000-01-01' data out/main.c out/main.h
+make -s -B
+"$VEXEL" -b vexel --depfile="dep file.d" -o vx/main main.vx
+if ! grep -q "^vx/main.vx:" "dep file.d" || grep -q "msg.txt" "dep file.d"; then
+  echo "--depfile must write the dependency file where asked" >&2
+  cat "dep file.d" >&2
+  exit 1
+fi
+if "$VEXEL" -b c --run -MD main.vx >/dev/null 2>&1; then
+  echo "-MD must be rejected with --run" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+mkdir -p "$TMPDIR/lib"
+cat > "$TMPDIR/lib/math.vx" <<'VX'
+&twice(x) { x * 2 }
+&^square(x:#i32) -> #i32 { x * x }
+VX
+cat > "$TMPDIR/main.vx" <<'VX'
+::lib::math;
+LIMIT = twice(21);
+&^main(k:#i32) -> #i32 { square(k) + twice(k) + LIMIT }
+VX
+
+cd "$TMPDIR"
+"$VEXEL" -b c --trace=trace.json --parallel-codegen -j 2 -o out/main main.vx >/dev/null
+python3 - trace.json <<'PY'
+import json, sys
+
+events = json.load(open(sys.argv[1]))["traceEvents"]
+spans = [e for e in events if e["ph"] == "X"]
+names = {e["name"] for e in spans}
+expected = [
+    "load", "typecheck", "optimize", "analysis", "backend-emit",
+    "parse main.vx", "parse lib/math.vx",
+    "typecheck main", "typecheck LIMIT", "instantiate twice",
+    "cte-fixpoint", "residualize", "reachability",
+    "emit main", "emit square",
+]
+missing = [name for name in expected if name not in names]
+if missing:
+    sys.exit("trace is missing spans: %s" % missing)
+
+# Spans of one thread nest: each one closes before the span enclosing it.
+by_thread = {}
+for e in spans:
+    if e["dur"] < 0:
+        sys.exit("negative duration: %s" % e)
+    by_thread.setdefault(e["tid"], []).append(e)
+for thread_spans in by_thread.values():
+    open_ends = []
+    for e in sorted(thread_spans, key=lambda e: (e["ts"], -e["dur"])):
+        while open_ends and open_ends[-1] <= e["ts"]:
+            open_ends.pop()
+        end = e["ts"] + e["dur"]
+        if open_ends and end > open_ends[-1] + 0.01:
+            sys.exit("span %r overlaps its parent" % e["name"])
+        open_ends.append(end)
+
+stage = {e["name"]: e for e in spans if e["cat"] == "stage"}
+typecheck = stage["typecheck"]
+for e in spans:
+    if e["name"] == "typecheck main" and not (
+            typecheck["ts"] <= e["ts"] and e["ts"] + e["dur"] <= typecheck["ts"] + typecheck["dur"] + 0.01):
+        sys.exit("declaration spans must nest inside the typecheck stage")
+threads = {e["args"]["name"] for e in events if e["ph"] == "M"}
+if "main" not in threads:
+    sys.exit("the compiling thread must be named")
+PY
+
+if "$VEXEL" -b c --trace= main.vx >/dev/null 2>&1; then
+  echo "--trace must reject an empty path" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cd "$TMPDIR"
+# Large enough to be split: every function names a multi-assignment
+# temporary, and string literals hold the bytes a chunk boundary is cut at.
+python3 - <<'PY'
+lines = ["&pair(x:#i32) -> (#i32, #i32) { (x, x + 1) }"]
+for i in range(6000):
+    lines.append('&f%d(x:#i32) -> #i32 { a:#i32; b:#i32; a, b = pair(x); s = "; } &g"; a + b + %d }' % (i, i))
+    lines.append("G%d = f%d(%d);" % (i, i, i % 7))
+lines.append("&^main(k:#i32) -> #i32 { f1(k) + f5999(k) + G17 }")
+source = "\n".join(lines) + "\n"
+open("big.vx", "w").write(source)
+# A syntax error in the first and in the last chunk.
+lines[1002] = lines[1002].replace(");", ") +;")
+lines[11992] = lines[11992].replace(");", ") *;")
+open("bad.vx", "w").write("\n".join(lines) + "\n")
+PY
+
+for backend in c vexel; do
+  "$VEXEL" -b "$backend" -j 1 -o "serial_$backend/main" big.vx >/dev/null
+  "$VEXEL" -b "$backend" -j 4 -o "chunked_$backend/main" big.vx >/dev/null
+  if ! diff -r "serial_$backend" "chunked_$backend" >/dev/null; then
+    echo "chunked parse changed the $backend output" >&2
+    exit 1
+  fi
+done
+
+"$VEXEL" -b c -j 4 --trace=trace.json -o traced/main big.vx >/dev/null
+chunks="$(grep -c '"parse chunk big.vx"' trace.json || true)"
+if [ "$chunks" -lt 2 ]; then
+  echo "expected big.vx to be parsed in chunks" >&2
+  exit 1
+fi
+
+if "$VEXEL" -b c -j 1 -o err1/main bad.vx >/dev/null 2>serial.err; then
+  echo "bad.vx must not compile" >&2
+  exit 1
+fi
+if "$VEXEL" -b c -j 4 -o err4/main bad.vx >/dev/null 2>chunked.err; then
+  echo "bad.vx must not compile" >&2
+  exit 1
+fi
+if ! cmp -s serial.err chunked.err || ! grep -q "Parse failed with 2 error(s)" chunked.err; then
+  echo "chunked parse changed the diagnostics" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cat > "$TMPDIR/main.vx" <<'VX'
+&^main() -> #i32 { 7 }
+VX
+
+cd "$TMPDIR"
+# Outputs naming a redirected stream go to the file behind it, after what it
+# already holds; the file itself is never replaced.
+echo "first line" > log.txt
+inode="$(stat -c %i log.txt)"
+{
+  "$VEXEL" -b c -o out --stats-json /dev/stdout main.vx
+  "$VEXEL" -b c -o out --trace /dev/fd/1 main.vx
+  echo "last line"
+} >> log.txt
+if [[ "$(stat -c %i log.txt)" != "$inode" ]]; then
+  echo "a redirected stdout file must not be replaced" >&2
+  exit 1
+fi
+if [[ "$(head -n 1 log.txt)" != "first line" || "$(tail -n 1 log.txt)" != "last line" ]]; then
+  echo "stream outputs must be appended to the redirected file" >&2
+  cat log.txt >&2
+  exit 1
+fi
+if ! grep -q '"stages"' log.txt || ! grep -q '"traceEvents"' log.txt; then
+  echo "stream outputs are missing from the redirected file" >&2
+  exit 1
+fi
+if ls | grep -q '\.tmp'; then
+  echo "stream outputs must not leave temporaries behind" >&2
+  exit 1
+fi
+
+echo "ok"
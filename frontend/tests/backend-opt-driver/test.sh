@@ -117,6 +117,19 @@ if ! rg -q -- "--run/--emit-exe require backend 'c'" wrong_backend_exe.err; then
   exit 1
 fi
 
+set +e
+"$ROOT/build/vexel" -b c --emit-exe --run-cache -o out input.vx >run_cache_exe.out 2>run_cache_exe.err
+status=$?
+set -e
+if [[ $status -eq 0 ]]; then
+  echo "expected --run-cache failure without --run"
+  exit 1
+fi
+if ! rg -q -- "--run-cache requires --run" run_cache_exe.err; then
+  echo "missing --run requirement error for --run-cache"
+  exit 1
+fi
+
 "$ROOT/build/vexel" --backend=c -o out input.vx >/dev/null 2>/dev/null
 if [[ ! -f out.c ]]; then
   echo "missing out.c when backend passed as --backend=c"
@@ -148,6 +161,7 @@ rm -f \
   bad_backend_value.out bad_backend_value.err \
   wrong_backend_run.out wrong_backend_run.err \
   wrong_backend_exe.out wrong_backend_exe.err \
+  run_cache_exe.out run_cache_exe.err \
   unknown.out unknown.err
 
 help_out=$("$ROOT/build/vexel" --help 2>/dev/null || true)
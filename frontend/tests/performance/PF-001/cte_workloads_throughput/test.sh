@@ -108,4 +108,25 @@ run_case "array_pipeline" 12000 "&^main() -> #i32 {
 }
 "
 
+run_case "loop_control" 300 "&pick(x:#u32) -> #u32 {
+  (x % 3 == 0) ? { -> x; };
+  -> 0;
+}
+&^main() -> #i32 {
+  acc:#u32 = 0;
+  i:#u32 = 0;
+  (i < 20000)@{
+    i = i + 1;
+    (i % 2 == 0) ? { ->>; };
+    acc = acc + pick(i);
+  };
+  j:#u32 = 0;
+  (1 == 1)@{
+    j = j + 1;
+    (j >= 5000) ? { ->|; };
+  };
+  (#i32)(acc + j)
+}
+"
+
 echo "ok"
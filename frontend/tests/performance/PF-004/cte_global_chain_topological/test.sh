@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# Ten chains of 300 global constants, each reading its predecessor and one
+# element further back. In topological order every initializer is evaluated
+# once with converged inputs; FIFO draining re-evaluated most of them.
+chains=10
+depth=300
+src_file="$TMPDIR/chains.vx"
+{
+  echo '&g(v:#i32) -> #i32 { v * 3 - v - v + 1 }'
+  for ((c=0; c<chains; ++c)); do
+    echo "C${c}_0:#i32 = $c;"
+    for ((i=1; i<depth; ++i)); do
+      echo "C${c}_$i:#i32 = g(C${c}_$((i - 1))) + (C${c}_$((i / 2)) > 100 ? 1 : 0);"
+    done
+  done
+  printf '&^main() -> #i32 { 0'
+  for ((c=0; c<chains; ++c)); do
+    printf ' + C%d_%d' "$c" "$((depth - 1))"
+  done
+  echo ' }'
+} > "$src_file"
+
+"$VEXEL" -b vexel --stats-json "$TMPDIR/stats.json" -o "$TMPDIR/out" "$src_file" >/dev/null
+
+if ! rg -q "^    4105$" "$TMPDIR/out.vx"; then
+  echo "global constant chains did not fold to their value" >&2
+  cat "$TMPDIR/out.vx" >&2
+  exit 1
+fi
+
+optimize_ms="$(sed -n 's/.*"name": "optimize", "wall_ms": \([0-9]*\)\..*/\1/p' "$TMPDIR/stats.json")"
+if [[ -z "$optimize_ms" ]]; then
+  echo "stats report has no optimize stage" >&2
+  exit 1
+fi
+if [[ "$optimize_ms" -gt 1200 ]]; then
+  echo "optimizing global constant chains exceeded budget: ${optimize_ms}ms > 1200ms" >&2
+  exit 1
+fi
+
+echo "ok"
@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+
+# Import chains of up to 512 modules, all imported by the entry module.
+# Import cycle checks used to walk the whole chain for every import.
+python3 "$ROOT/frontend/bench/scaling.py" --vexel "$VEXEL" --workload modules \
+  --sizes 64,128,256,512 \
+  --bound load=n --bound resolve=n --bound typecheck=n --bound analysis=nlogn --bound total=n
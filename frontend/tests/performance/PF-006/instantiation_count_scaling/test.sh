@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+
+# Two nested generic functions instantiated for up to 512 struct types.
+python3 "$ROOT/frontend/bench/scaling.py" --vexel "$VEXEL" --workload generics \
+  --sizes 64,128,256,512 \
+  --bound typecheck=n --bound monomorphize=n --bound optimize=nlogn --bound analysis=nlogn --bound total=n
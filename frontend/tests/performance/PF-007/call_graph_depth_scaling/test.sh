@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+
+# Call chains up to 1024 functions deep over a runtime argument.
+python3 "$ROOT/frontend/bench/scaling.py" --vexel "$VEXEL" --workload call-depth \
+  --sizes 128,256,512,1024 \
+  --bound resolve=n --bound typecheck=n --bound optimize=n --bound analysis=nlogn --bound total=n
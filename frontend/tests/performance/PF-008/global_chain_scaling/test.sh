@@ -0,0 +1,13 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+
+# Chains of up to 200 global constants, each reading its predecessor. The
+# residualizer fixpoint (optimize) must stay linear. Typecheck re-evaluates
+# the chain for every global it checks, so it is only held to O(n^2).
+python3 "$ROOT/frontend/bench/scaling.py" --vexel "$VEXEL" --workload global-chain \
+  --sizes 25,50,100,200 \
+  --bound load=n --bound optimize=n --bound typecheck=n2
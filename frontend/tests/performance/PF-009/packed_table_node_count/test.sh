@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+TMPDIR="$(mktemp -d)"
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# A 64K-entry folded table must not become one AST node per element, in the
+# optimizer or in the program handed to the backend.
+cat >"$TMPDIR/table.vx" <<'VX'
+&build() -> #u32[65536] {
+    t:#u32[65536];
+    i:#i32 = 0;
+    (i < 65536)@{
+        t[i] = (#u32)i * (#u32)40503;
+        i = i + 1;
+    };
+    t
+}
+
+TABLE = build();
+
+&^main(k:#i32) -> #u32 {
+    TABLE[k] + TABLE[k + 1]
+}
+VX
+
+"$VEXEL" -b c --stats-json="$TMPDIR/stats.json" -o "$TMPDIR/out" "$TMPDIR/table.vx" >/dev/null
+
+python3 - "$TMPDIR/stats.json" "$TMPDIR/out.c" <<'PY'
+import json
+import re
+import sys
+
+stats = json.load(open(sys.argv[1]))
+for stage in stats["stages"]:
+    if stage["name"] in ("optimize", "backend-emit") and stage["ast_nodes"] > 1000:
+        raise SystemExit(f"{stage['name']} holds {stage['ast_nodes']} AST nodes for a packed table")
+
+source = open(sys.argv[2]).read()
+if len(re.findall(r"vx_TABLE\[65536\] = \{0, 40503, ", source)) != 1:
+    raise SystemExit("table is not emitted once as an initialized global")
+if re.search(r"tmp[0-9]+\[65536\]", source):
+    raise SystemExit("table is copied into a temporary at its use sites")
+PY
+
+echo "ok"
@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+VEXEL="$ROOT/build/vexel"
+
+# A compile-time loop indexing an embedded resource reads the string once per
+# iteration. Copies share the buffer, so the scan stays linear in its length.
+python3 "$ROOT/frontend/bench/scaling.py" --vexel "$VEXEL" --workload cte-string-scan \
+  --sizes 5000,10000,20000,40000 \
+  --bound typecheck=n --bound optimize=n
@@ -5,15 +5,24 @@ import os
 from pathlib import Path
 import sys
 
-if len(sys.argv) != 5:
-    raise SystemExit("usage: embed.py <template> <js> <wasm> <out>")
+args = sys.argv[1:]
+# --external-wasm: the page loads vexel.wasm from beside itself instead of
+# carrying it as base64.
+external_wasm = "--external-wasm" in args
+args = [arg for arg in args if arg != "--external-wasm"]
+if len(args) != 4:
+    raise SystemExit("usage: embed.py [--external-wasm] <template> <js> <wasm> <out>")
 
-template_path, js_path, wasm_path, out_path = sys.argv[1:]
+template_path, js_path, wasm_path, out_path = args
 
 template = Path(template_path).read_text()
 js = Path(js_path).read_text()
-wasm = Path(wasm_path).read_bytes()
-wasm_b64 = base64.b64encode(wasm).decode("ascii")
+if external_wasm:
+    wasm_b64 = ""
+    wasm_url = Path(wasm_path).name
+else:
+    wasm_b64 = base64.b64encode(Path(wasm_path).read_bytes()).decode("ascii")
+    wasm_url = ""
 
 backends_env = os.environ.get("VEXEL_BACKENDS", "").strip()
 backends = backends_env.split() if backends_env else ["c"]
@@ -51,6 +60,15 @@ if example_root.exists():
         example_files.append(encode_example_file(path))
 example_files_json = json.dumps(example_files).replace("</", "<\\/")
 
+# The bundled std modules, which the worker installs as the compiler's builtin
+# std root so `::std::...` imports resolve as in a native build.
+std_files = []
+std_root = repo_root / "std"
+if std_root.exists():
+    for path in sorted(std_root.glob("*.vx")):
+        std_files.append({"path": path.relative_to(repo_root).as_posix(), "content": path.read_text()})
+std_files_json = json.dumps(std_files).replace("</", "<\\/")
+
 tutorial_manifest = []
 if tutorial_manifest_path.exists():
     tutorial_manifest = json.loads(tutorial_manifest_path.read_text())
@@ -59,6 +77,8 @@ tutorial_manifest_json = json.dumps(tutorial_manifest).replace("</", "<\\/")
 html = (
     template.replace("/*__VEXEL_JS__*/", js)
     .replace("__VEXEL_WASM_BASE64__", wasm_b64)
+    .replace("__VEXEL_WASM_URL__", wasm_url)
+    .replace("__VEXEL_STD_JSON__", std_files_json)
     .replace("__VEXEL_BACKENDS_JSON__", backends_json)
     .replace("__VEXEL_EXAMPLES_JSON__", example_files_json)
     .replace("__VEXEL_TUTORIAL_JSON__", tutorial_manifest_json)
@@ -1,9 +1,17 @@
 #include "backend_registry.h"
 #include "compiler.h"
+#include "module_cache.h"
 #include <iostream>
 #include <cstring>
 #include <vector>
 
+#if defined(__EMSCRIPTEN__)
+#include <emscripten/emscripten.h>
+#define VEXEL_WEB_EXPORT EMSCRIPTEN_KEEPALIVE
+#else
+#define VEXEL_WEB_EXPORT
+#endif
+
 // Web playground CLI: mirrors the unified driver but registers available backends.
 static void print_usage(const char* prog, const std::vector<vexel::BackendInfo>& backends) {
     std::cout << "Vexel Compiler (web)\n";
@@ -18,10 +26,66 @@ static void print_usage(const char* prog, const std::vector<vexel::BackendInfo>&
     std::cout << "\n";
     std::cout << "  --emit-analysis Emit analysis report alongside backend output\n";
     std::cout << "  --allow-process Enable process expressions (executes host commands; disabled by default)\n";
+    std::cout << "  --time-passes Print per-stage wall time, peak RSS growth and AST size to stderr\n";
+    std::cout << "  --stats-json <path> Write the same per-stage stats as JSON\n";
     std::cout << "  -v           Verbose output\n";
     std::cout << "  -h           Show this help\n";
 }
 
+static void print_compile_error(const vexel::CompileError& e) {
+    std::cerr << "Error";
+    if (!e.location.filename().empty()) {
+        std::cerr << " at " << e.location.filename()
+                  << ":" << e.location.line
+                  << ":" << e.location.column;
+    }
+    std::cerr << ": " << e.what() << "\n";
+}
+
+// Parsed modules kept for the life of the wasm instance. The playground
+// worker compiles every edit through vexel_web_compile in one instance, so
+// bundled std modules and unedited project files are decoded from here
+// instead of being parsed again; only edited buffers miss.
+static vexel::ResidentModuleCache& web_modules() {
+    static vexel::ResidentModuleCache modules;
+    return modules;
+}
+
+// One compile of `input` into `output` (base name) with `backend`, writing
+// `<output>.analysis.txt` as well when `emit_analysis` is non-zero. Outputs
+// go to the in-memory filesystem; diagnostics go to stderr. Returns the exit
+// code main() would return.
+extern "C" VEXEL_WEB_EXPORT int vexel_web_compile(const char* backend,
+                                                  const char* input,
+                                                  const char* output,
+                                                  int emit_analysis) {
+    vexel::Compiler::Options opts;
+    opts.backend = backend ? backend : "";
+    opts.input_file = input ? input : "";
+    opts.output_file = output && *output ? output : "out";
+    opts.emit_analysis = emit_analysis != 0;
+    opts.resident_modules = &web_modules();
+    if (opts.input_file.empty()) {
+        std::cerr << "Error: No input file specified\n";
+        return 1;
+    }
+    if (!vexel::find_backend(opts.backend)) {
+        std::cerr << "Error: Unknown backend '" << opts.backend << "'\n";
+        return 1;
+    }
+    try {
+        vexel::Compiler compiler(opts);
+        (void)compiler.compile();
+        return 0;
+    } catch (const vexel::CompileError& e) {
+        print_compile_error(e);
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
+
 int main(int argc, char** argv) {
     std::vector<vexel::BackendInfo> available_backends = vexel::list_backends();
     if (available_backends.empty()) {
@@ -43,6 +107,15 @@ int main(int argc, char** argv) {
             opts.emit_analysis = true;
         } else if (std::strcmp(argv[i], "--allow-process") == 0) {
             opts.allow_process = true;
+        } else if (std::strcmp(argv[i], "--time-passes") == 0) {
+            opts.time_passes = true;
+        } else if (std::strcmp(argv[i], "--stats-json") == 0) {
+            if (i + 1 < argc) {
+                opts.stats_json = argv[++i];
+            } else {
+                std::cerr << "Error: --stats-json requires an argument\n";
+                return 1;
+            }
         } else if (std::strcmp(argv[i], "-o") == 0) {
             if (i + 1 < argc) {
                 opts.output_file = argv[++i];
@@ -86,13 +159,7 @@ int main(int argc, char** argv) {
         (void)compiler.compile();
         return 0;
     } catch (const vexel::CompileError& e) {
-        std::cerr << "Error";
-        if (!e.location.filename.empty()) {
-            std::cerr << " at " << e.location.filename
-                      << ":" << e.location.line
-                      << ":" << e.location.column;
-        }
-        std::cerr << ": " << e.what() << "\n";
+        print_compile_error(e);
         return 1;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";